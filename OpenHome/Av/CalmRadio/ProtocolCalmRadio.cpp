@@ -148,6 +148,7 @@ void ProtocolCalmRadio::Interrupt(TBool aInterrupt)
         if (aInterrupt) {
             iStopped = true;
         }
+        iResolverClient.Interrupt(aInterrupt);
         iTcpClient.Interrupt(aInterrupt);
         iCalm->Interrupt(aInterrupt);
     }
@@ -161,6 +162,7 @@ ProtocolStreamResult ProtocolCalmRadio::Stream(const Brx& aUri)
     iContentProcessor = nullptr;
     iNextFlushId = MsgFlush::kIdInvalid;
     iCalm->Interrupt(false);
+    iResolverClient.Interrupt(false);
     iUri.Replace(aUri);
     iUriBase.Replace(Brx::Empty());
     iReaderIcy->Reset();
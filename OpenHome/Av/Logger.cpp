@@ -7,6 +7,7 @@
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Av/ProviderDebug.h>
 #include <OpenHome/Av/Product.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 
 #include <atomic>
 #include <vector>
@@ -81,14 +82,15 @@ void LoggerSerial::DisplayHelp(IWriter& aResponse)
 
 const TChar* LoggerBuffered::kShellCommandLog = "log";
 
-LoggerBuffered::LoggerBuffered(TUint aBytes, Net::DvDevice& aDevice, Product& aProduct,
+LoggerBuffered::LoggerBuffered(Environment& aEnv, TUint aBytes, Net::DvDevice& aDevice, Product& aProduct,
                                IShell& aShell, Optional<ILogPoster> aLogPoster)
     : iShell(aShell)
 {
     iShell.AddCommandHandler(kShellCommandLog, *this);
     iLoggerSerial = new Av::LoggerSerial(aShell);
     iLoggerRingBuffer = new RingBufferLogger(aBytes);
-    iProviderDebug = new ProviderDebug(aDevice, *iLoggerRingBuffer, aLogPoster);
+    iBinaryLogger = new Media::BinaryLogger(aEnv); // disabled until 'log binary on'
+    iProviderDebug = new ProviderDebug(aDevice, *iLoggerRingBuffer, *iBinaryLogger, aLogPoster);
     aProduct.AddAttribute("Debug");
 }
 
@@ -96,6 +98,7 @@ LoggerBuffered::~LoggerBuffered()
 {
     iShell.RemoveCommandHandler(kShellCommandLog);
     delete iProviderDebug;
+    delete iBinaryLogger;
     delete iLoggerRingBuffer;
     delete iLoggerSerial;
 }
@@ -110,23 +113,41 @@ RingBufferLogger& LoggerBuffered::LogBuffer()
     return *iLoggerRingBuffer;
 }
 
+Media::BinaryLogger& LoggerBuffered::BinaryLog()
+{
+    return *iBinaryLogger;
+}
+
 void LoggerBuffered::HandleShellCommand(Brn /*aCommand*/, const std::vector<Brn>& aArgs, IWriter& aResponse)
 {
-    if (aArgs.size() != 1) {
-        aResponse.Write(Brn("Unexpected number of arguments for command \'log\'\n"));
+    if (aArgs.size() == 1 && aArgs[0] == Brn("print")) {
+        iLoggerRingBuffer->Read(aResponse);
+        iBinaryLogger->Read(aResponse);
         return;
     }
-    if (aArgs[0] != Brn("print")) {
-        aResponse.Write(Brn("Unexpected command for \'log\': "));
-        aResponse.Write(aArgs[0]);
-        aResponse.Write(Brn("\n"));
+    if (aArgs.size() == 2 && aArgs[0] == Brn("binary")) {
+        if (aArgs[1] == Brn("on")) {
+            iBinaryLogger->SetEnabled(true);
+            return;
+        }
+        if (aArgs[1] == Brn("off")) {
+            iBinaryLogger->SetEnabled(false);
+            return;
+        }
+    }
+    if (aArgs.size() == 0 || aArgs.size() > 2) {
+        aResponse.Write(Brn("Unexpected number of arguments for command \'log\'\n"));
         return;
     }
-    iLoggerRingBuffer->Read(aResponse);
+    aResponse.Write(Brn("Unexpected command for \'log\': "));
+    aResponse.Write(aArgs[0]);
+    aResponse.Write(Brn("\n"));
 }
 
 void LoggerBuffered::DisplayHelp(IWriter& aResponse)
 {
     aResponse.Write(Brn("log print\n"));
     aResponse.Write(Brn("  display all recently logged content\n"));
+    aResponse.Write(Brn("log binary on|off\n"));
+    aResponse.Write(Brn("  enable/disable deferred formatting of logging from audio threads\n"));
 }
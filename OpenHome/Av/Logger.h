@@ -18,6 +18,9 @@ namespace OpenHome {
 namespace Net {
     class DvDevice;
 }
+namespace Media {
+    class BinaryLogger;
+}
 namespace Av {
 
 class ILoggerSerial
@@ -63,11 +66,12 @@ class LoggerBuffered : private IShellCommandHandler
 {
     static const TChar* kShellCommandLog;
 public:
-    LoggerBuffered(TUint aBytes, Net::DvDevice& aDevice, Product& aProduct,
+    LoggerBuffered(Environment& aEnv, TUint aBytes, Net::DvDevice& aDevice, Product& aProduct,
                    IShell& aShell, Optional<ILogPoster> aLogPoster);
     ~LoggerBuffered();
     ILoggerSerial& LoggerSerial();
     RingBufferLogger& LogBuffer();
+    Media::BinaryLogger& BinaryLog();
 private: // from IShellCommandHandler
     void HandleShellCommand(Brn aCommand, const std::vector<Brn>& aArgs, IWriter& aResponse) override;
     void DisplayHelp(IWriter& aResponse) override;
@@ -75,6 +79,7 @@ private:
     IShell& iShell;
     Av::LoggerSerial* iLoggerSerial;
     RingBufferLogger* iLoggerRingBuffer;
+    Media::BinaryLogger* iBinaryLogger;
     ProviderDebug* iProviderDebug;
 };
 
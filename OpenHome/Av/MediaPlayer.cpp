@@ -188,7 +188,7 @@ void MediaPlayer::AddAttribute(const TChar* aAttribute)
 
 ILoggerSerial& MediaPlayer::BufferLogOutput(TUint aBytes, IShell& aShell, Optional<ILogPoster> aLogPoster)
 {
-    iLoggerBuffered = new LoggerBuffered(aBytes, iDevice, *iProduct, aShell, aLogPoster);
+    iLoggerBuffered = new LoggerBuffered(iDvStack.Env(), aBytes, iDevice, *iProduct, aShell, aLogPoster);
     return iLoggerBuffered->LoggerSerial();
 }
 
@@ -311,3 +311,8 @@ ITransportRepeatRandom& MediaPlayer::TransportRepeatRandom()
 {
     return iTransportRepeatRandom;
 }
+
+Av::TrackLookahead& MediaPlayer::TrackLookahead()
+{
+    return iTrackLookahead;
+}
@@ -7,6 +7,7 @@
 #include <OpenHome/Av/Logger.h>
 #include <OpenHome/Av/Product.h>
 #include <OpenHome/Av/TransportControl.h>
+#include <OpenHome/Av/TrackLookahead.h>
 
 namespace OpenHome {
     class Environment;
@@ -88,6 +89,7 @@ public:
     virtual ILoggerSerial& BufferLogOutput(TUint aBytes, IShell& aShell, Optional<ILogPoster> aLogPoster) = 0; // must be called before Start()
     virtual IUnixTimestamp& UnixTimestamp() = 0;
     virtual ITransportRepeatRandom& TransportRepeatRandom() = 0;
+    virtual Av::TrackLookahead& TrackLookahead() = 0;
 };
 
 
@@ -150,6 +152,7 @@ public: // from IMediaPlayer
     ILoggerSerial& BufferLogOutput(TUint aBytes, IShell& aShell, Optional<ILogPoster> aLogPoster) override; // must be called before Start()
     IUnixTimestamp& UnixTimestamp() override;
     ITransportRepeatRandom& TransportRepeatRandom() override;
+    Av::TrackLookahead& TrackLookahead() override;
 private:
     Net::DvStack& iDvStack;
     Net::DvDeviceStandard& iDevice;
@@ -173,6 +176,7 @@ private:
     ProviderInfo* iProviderInfo;
     ProviderTransport* iProviderTransport;
     Av::TransportRepeatRandom iTransportRepeatRandom;
+    Av::TrackLookahead iTrackLookahead;
     Configuration::ProviderConfig* iProviderConfig;
     Configuration::ProviderConfigApp* iProviderConfigApp;
     LoggerBuffered* iLoggerBuffered;
@@ -116,7 +116,7 @@ SourcePlaylist::SourcePlaylist(IMediaPlayer& aMediaPlayer)
     iDatabase = new TrackDatabase(aMediaPlayer.TrackFactory());
     iShuffler = new Shuffler(env, *iDatabase);
     iRepeater = new Repeater(*iShuffler);
-    iUriProvider = new UriProviderPlaylist(*iRepeater, iPipeline, *this);
+    iUriProvider = new UriProviderPlaylist(*iRepeater, iPipeline, *this, aMediaPlayer.TrackLookahead());
     iUriProvider->SetTransportPlay(MakeFunctor(*this, &SourcePlaylist::Play));
     iUriProvider->SetTransportPause(MakeFunctor(*this, &SourcePlaylist::Pause));
     iUriProvider->SetTransportStop(MakeFunctor(*this, &SourcePlaylist::Stop));
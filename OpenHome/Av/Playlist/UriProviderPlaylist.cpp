@@ -19,7 +19,8 @@ using namespace OpenHome::Media;
 const Brn UriProviderPlaylist::kCommandId("id");
 const Brn UriProviderPlaylist::kCommandIndex("index");
 
-UriProviderPlaylist::UriProviderPlaylist(ITrackDatabaseReader& aDatabase, PipelineManager& aPipeline, ITrackDatabaseObserver& aObserver)
+UriProviderPlaylist::UriProviderPlaylist(ITrackDatabaseReader& aDatabase, PipelineManager& aPipeline,
+                                         ITrackDatabaseObserver& aObserver, ITrackLookaheadObserver& aLookahead)
     : UriProvider("Playlist",
                   Latency::NotSupported,
                   Next::Supported, Prev::Supported,
@@ -29,6 +30,7 @@ UriProviderPlaylist::UriProviderPlaylist(ITrackDatabaseReader& aDatabase, Pipeli
     , iDatabase(aDatabase)
     , iIdManager(aPipeline)
     , iObserver(aObserver)
+    , iLookahead(aLookahead)
     , iPending(nullptr)
     , iLastTrackId(ITrackDatabase::kTrackIdNone)
     , iPlayingTrackId(ITrackDatabase::kTrackIdNone)
@@ -99,6 +101,9 @@ EStreamPlay UriProviderPlaylist::GetNext(Media::Track*& aTrack)
         }
         canPlay = ePlayNo;
     }
+    if (aTrack != nullptr) {
+        NotifyUpcomingLocked(aTrack->Id());
+    }
     return canPlay;
 }
 
@@ -174,6 +179,23 @@ void UriProviderPlaylist::MoveTo(const Brx& aCommand)
     iPendingDirection = eJumpTo;
 }
 
+Track* UriProviderPlaylist::PeekNext()
+{
+    AutoMutex a(iLock);
+    if (iPending != nullptr) {
+        iPending->AddRef();
+        return iPending;
+    }
+    /* Don't wrap round to the start of the playlist; GetNext() would return that track
+       with ePlayLater so there's no benefit in fetching it early. */
+    Track* track = iDatabase.NextTrackRef(iLastTrackId);
+    if (track != nullptr && track->Id() == iFirstFailedTrackId) {
+        track->RemoveRef();
+        track = nullptr;
+    }
+    return track;
+}
+
 void UriProviderPlaylist::DoBegin(TUint aTrackId, EStreamPlay aPendingCanPlay)
 {
     AutoMutex a(iLock);
@@ -198,6 +220,25 @@ TUint UriProviderPlaylist::CurrentTrackIdLocked() const
     return id;
 }
 
+void UriProviderPlaylist::NotifyUpcomingLocked(TUint aTrackId)
+{
+    /* Give protocols a chance to do slow work (e.g. resolving streaming service urls) for the
+       tracks that will follow aTrackId before the Filler asks for them. */
+    TUint id = aTrackId;
+    for (TUint i=0; i<kLookaheadTracks; i++) {
+        Track* track = iDatabase.NextTrackRef(id);
+        if (track == nullptr || track->Id() == aTrackId) {
+            if (track != nullptr) {
+                track->RemoveRef();
+            }
+            break;
+        }
+        id = track->Id();
+        iLookahead.NotifyTrackUpcoming(track->Uri());
+        track->RemoveRef();
+    }
+}
+
 TUint UriProviderPlaylist::ParseCommand(const Brx& aCommand) const
 {
     Parser parser(aCommand);
@@ -317,9 +358,11 @@ void UriProviderPlaylist::NotifyMode(const Brx& /*aMode*/,
 void UriProviderPlaylist::NotifyTrack(Track& aTrack, const Brx& aMode, TBool /*aStartOfStream*/)
 {
     if (aMode == Mode()) {
-        iLock.Wait();
+        AutoMutex _(iLock);
         iPlayingTrackId = aTrack.Id();
-        iLock.Signal();
+        if (iActive) {
+            NotifyUpcomingLocked(iPlayingTrackId);
+        }
     }
 }
 
@@ -4,6 +4,7 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Media/Filler.h>
 #include <OpenHome/Av/Playlist/TrackDatabase.h>
+#include <OpenHome/Av/TrackLookahead.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/PipelineObserver.h>
@@ -23,8 +24,10 @@ class UriProviderPlaylist : public Media::UriProvider, private ITrackDatabaseObs
 {
     static const Brn kCommandId;
     static const Brn kCommandIndex;
+    static const TUint kLookaheadTracks = 2;
 public:
-    UriProviderPlaylist(ITrackDatabaseReader& aDatabase, Media::PipelineManager& aPipeline, ITrackDatabaseObserver& aObserver);
+    UriProviderPlaylist(ITrackDatabaseReader& aDatabase, Media::PipelineManager& aPipeline,
+                        ITrackDatabaseObserver& aObserver, ITrackLookaheadObserver& aLookahead);
     ~UriProviderPlaylist();
     void SetActive(TBool aActive);
 public: // from UriProvider
@@ -36,6 +39,7 @@ public: // from UriProvider
     void MoveNext() override;
     void MovePrevious() override;
     void MoveTo(const Brx& aCommand) override;
+    Media::Track* PeekNext() override;
 private: // from ITrackDatabaseObserver
     void NotifyTrackInserted(Media::Track& aTrack, TUint aIdBefore, TUint aIdAfter) override;
     void NotifyTrackDeleted(TUint aId, Media::Track* aBefore, Media::Track* aAfter) override;
@@ -54,6 +58,7 @@ private: // from Media::ITrackObserver
 private:
     void DoBegin(TUint aTrackId, Media::EStreamPlay aPendingCanPlay);
     TUint CurrentTrackIdLocked() const;
+    void NotifyUpcomingLocked(TUint aTrackId);
     TUint ParseCommand(const Brx& aCommand) const;
     Media::Track* ProcessCommandId(const Brx& aCommand);
     Media::Track* ProcessCommandIndex(const Brx& aCommand);
@@ -69,6 +74,7 @@ private:
     ITrackDatabaseReader& iDatabase;
     Media::IPipelineIdManager& iIdManager;
     ITrackDatabaseObserver& iObserver;
+    ITrackLookaheadObserver& iLookahead;
     Media::Track* iPending;
     Media::EStreamPlay iPendingCanPlay;
     EPendingDirection iPendingDirection;
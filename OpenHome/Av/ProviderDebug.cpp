@@ -3,14 +3,17 @@
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Optional.h>
 #include <OpenHome/Av/Logger.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
 using namespace OpenHome::Net;
 
-ProviderDebug::ProviderDebug(DvDevice& aDevice, RingBufferLogger& aLogger, Optional<ILogPoster> aLogPoster)
+ProviderDebug::ProviderDebug(DvDevice& aDevice, RingBufferLogger& aLogger, Media::BinaryLogger& aBinaryLogger,
+                             Optional<ILogPoster> aLogPoster)
     : DvProviderAvOpenhomeOrgDebug1(aDevice)
     , iLogger(aLogger)
+    , iBinaryLogger(aBinaryLogger)
     , iLogPoster(aLogPoster)
 {
     EnableActionGetLog();
@@ -21,6 +24,7 @@ void ProviderDebug::GetLog(IDvInvocation& aInvocation, IDvInvocationResponseStri
 {
     aInvocation.StartResponse();
     iLogger.Read(aLog);
+    iBinaryLogger.Read(aLog);
     aLog.WriteFlush();
     aInvocation.EndResponse();
 }
@@ -6,18 +6,23 @@
 
 namespace OpenHome {
     class RingBufferLogger;
+namespace Media {
+    class BinaryLogger;
+}
 namespace Av {
     class ILogPoster;
 
 class ProviderDebug : public Net::DvProviderAvOpenhomeOrgDebug1
 {
 public:
-    ProviderDebug(Net::DvDevice& aDevice, RingBufferLogger& aLogger, Optional<ILogPoster> aLogPoster);
+    ProviderDebug(Net::DvDevice& aDevice, RingBufferLogger& aLogger, Media::BinaryLogger& aBinaryLogger,
+                  Optional<ILogPoster> aLogPoster);
 private: // from DvProviderAvOpenhomeOrgDebug1
     void GetLog(Net::IDvInvocation& aInvocation, Net::IDvInvocationResponseString& aLog) override;
     void SendLog(Net::IDvInvocation& aInvocation, const Brx& aData) override;
 private:
     RingBufferLogger& iLogger;
+    Media::BinaryLogger& iBinaryLogger;
     Optional<ILogPoster> iLogPoster;
 };
 
@@ -12,19 +12,22 @@
 #include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Av/Qobuz/Qobuz.h>
+#include <OpenHome/Av/TrackLookahead.h>
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
 #include <OpenHome/Media/SupplyAggregator.h>
 
 namespace OpenHome {
     class IUnixTimestamp;
 namespace Av {
 
-class ProtocolQobuz : public Media::ProtocolNetwork, private IReader
+class ProtocolQobuz : public Media::ProtocolNetwork, private IReader, private ITrackLookaheadObserver
 {
     static const TUint kTcpConnectTimeoutMs = 10 * 1000;
+    static const TUint kStreamUrlLifetimeMs = 5 * 60 * 1000; // conservative; the service doesn't report url expiry
 public:
     ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
                   Credentials& aCredentialsManager, Configuration::IConfigInitialiser& aConfigInitialiser,
-                  IUnixTimestamp& aUnixTimestamp);
+                  IUnixTimestamp& aUnixTimestamp, ITrackLookahead& aTrackLookahead);
     ~ProtocolQobuz();
 private: // from Media::Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
@@ -40,6 +43,8 @@ private: // from IProtocolReader
     Brn Read(TUint aBytes) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+private: // from ITrackLookaheadObserver
+    void NotifyTrackUpcoming(const Brx& aUri) override;
 private:
     static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
     Media::ProtocolStreamResult DoStream();
@@ -50,6 +55,7 @@ private:
     TBool IsCurrentStream(TUint aStreamId) const;
 private:
     Qobuz* iQobuz;
+    StreamUrlResolver* iResolver;
     Media::SupplyAggregator* iSupply;
     Uri iUri;
     Bws<12> iTrackId;
@@ -87,7 +93,7 @@ Protocol* ProtocolFactory::NewQobuz(const Brx& aAppId, const Brx& aAppSecret, Av
 { // static
     return new ProtocolQobuz(aMediaPlayer.Env(), aAppId, aAppSecret,
                              aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser(),
-                             aMediaPlayer.UnixTimestamp());
+                             aMediaPlayer.UnixTimestamp(), aMediaPlayer.TrackLookahead());
 }
 
 
@@ -95,7 +101,7 @@ Protocol* ProtocolFactory::NewQobuz(const Brx& aAppId, const Brx& aAppSecret, Av
 
 ProtocolQobuz::ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
                              Credentials& aCredentialsManager, IConfigInitialiser& aConfigInitialiser,
-                             IUnixTimestamp& aUnixTimestamp)
+                             IUnixTimestamp& aUnixTimestamp, ITrackLookahead& aTrackLookahead)
     : ProtocolNetwork(aEnv)
     , iSupply(nullptr)
     , iWriterRequest(iWriterBuf)
@@ -111,10 +117,13 @@ ProtocolQobuz::ProtocolQobuz(Environment& aEnv, const Brx& aAppId, const Brx& aA
 
     iQobuz = new Qobuz(aEnv, aAppId, aAppSecret, aCredentialsManager, aConfigInitialiser, aUnixTimestamp);
     aCredentialsManager.Add(iQobuz);
+    iResolver = new StreamUrlResolver(aEnv, *iQobuz, kStreamUrlLifetimeMs);
+    aTrackLookahead.AddObserver(*this);
 }
 
 ProtocolQobuz::~ProtocolQobuz()
 {
+    delete iResolver;
     delete iSupply;
 }
 
@@ -131,8 +140,9 @@ void ProtocolQobuz::Interrupt(TBool aInterrupt)
         if (aInterrupt) {
             iStopped = true;
         }
+        iResolverClient.Interrupt(aInterrupt);
         iTcpClient.Interrupt(aInterrupt);
-        iQobuz->Interrupt(aInterrupt);
+        iResolver->Interrupt(aInterrupt); // also interrupts iQobuz
     }
     iLock.Signal();
 }
@@ -144,7 +154,8 @@ ProtocolStreamResult ProtocolQobuz::Stream(const Brx& aUri)
     iSeekable = iSeek = iStarted = iStopped = false;
     iContentProcessor = nullptr;
     iNextFlushId = MsgFlush::kIdInvalid;
-    iQobuz->Interrupt(false);
+    iResolver->Interrupt(false);
+    iResolverClient.Interrupt(false);
     iUri.Replace(aUri);
 
     if (iUri.Scheme() != Brn("qobuz")) {
@@ -156,10 +167,12 @@ ProtocolStreamResult ProtocolQobuz::Stream(const Brx& aUri)
     }
 
     ProtocolStreamResult res = EProtocolStreamErrorUnrecoverable;
-    if (!iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+    if (!iResolver->TryGetStreamUrl(iTrackId, iStreamUrl)) {
         // any error might be due to our session having expired
         // attempt login, getStreamUrl to see if that fixes things
-        if (!iQobuz->TryLogin() || !iQobuz->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+        // (urls cached against the old session are discarded)
+        iResolver->Clear();
+        if (!iQobuz->TryLogin() || !iResolver->TryGetStreamUrl(iTrackId, iStreamUrl)) {
             return EProtocolStreamErrorUnrecoverable;
         }
     }
@@ -289,6 +302,17 @@ void ProtocolQobuz::ReadInterrupt()
     iDechunker.ReadInterrupt();
 }
 
+void ProtocolQobuz::NotifyTrackUpcoming(const Brx& aUri)
+{
+    if (!aUri.BeginsWith(Brn("qobuz://"))) {
+        return;
+    }
+    Bws<12> trackId;
+    if (TryGetTrackId(aUri, trackId)) {
+        iResolver->Prefetch(trackId);
+    }
+}
+
 TBool ProtocolQobuz::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
 { // static
     Parser parser(aQuery);
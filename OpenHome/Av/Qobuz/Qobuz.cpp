@@ -49,6 +49,7 @@ Qobuz::Qobuz(Environment& aEnv, const Brx& aAppId, const Brx& aAppSecret,
     , iAppSecret(aAppSecret)
     , iUsername(kGranularityUsername)
     , iPassword(kGranularityPassword)
+    , iStreamUrlCache(nullptr)
 {
     iReaderResponse.AddHeader(iHeaderContentLength);
     iReaderResponse.AddHeader(iHeaderTransferEncoding);
@@ -79,12 +80,13 @@ TBool Qobuz::TryLogin()
 
 TBool Qobuz::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
 {
+    AutoMutex _(iLock); // also called from StreamUrlResolver's thread, concurrently with login
     TBool success = false;
     if (!TryConnect()) {
         LOG_ERROR(kPipeline, "Qobuz::TryGetStreamUrl - connection failure\n");
         return false;
     }
-    AutoSocketReader _(iSocket, iReaderUntil2);
+    AutoSocketReader __(iSocket, iReaderUntil2);
 
     // see https://github.com/Qobuz/api-documentation#request-signature for rules on creating request_sig value
     TUint timestamp;
@@ -158,6 +160,12 @@ void Qobuz::Interrupt(TBool aInterrupt)
     iSocket.Interrupt(aInterrupt);
 }
 
+void Qobuz::SetStreamUrlCache(IStreamUrlCache* aCache)
+{
+    AutoMutex _(iLockConfig);
+    iStreamUrlCache = aCache;
+}
+
 const Brx& Qobuz::Id() const
 {
     return kId;
@@ -320,6 +328,9 @@ void Qobuz::QualityChanged(Configuration::KeyValuePair<TUint>& aKvp)
 {
     iLockConfig.Wait();
     iSoundQuality = kQualityValues[aKvp.Value()];
+    if (iStreamUrlCache != nullptr) {
+        iStreamUrlCache->Clear(); // cached urls are for the previous quality
+    }
     iLockConfig.Signal();
 }
 
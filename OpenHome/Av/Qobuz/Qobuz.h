@@ -1,6 +1,7 @@
 #pragma once
 
 #include <OpenHome/Av/Credentials.h>
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Configuration/ConfigManager.h>
 #include <OpenHome/Private/Network.h>
@@ -18,7 +19,7 @@ namespace Configuration {
 }
 namespace Av {
 
-class Qobuz : public ICredentialConsumer
+class Qobuz : public ICredentialConsumer, public IStreamUrlSource
 {
     friend class TestQobuz;
     static const TUint kReadBufferBytes = 4 * 1024;
@@ -40,8 +41,10 @@ public:
           IUnixTimestamp& aUnixTimestamp);
     ~Qobuz();
     TBool TryLogin();
-    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl);
-    void Interrupt(TBool aInterrupt);
+public: // from IStreamUrlSource
+    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl) override;
+    void Interrupt(TBool aInterrupt) override;
+    void SetStreamUrlCache(IStreamUrlCache* aCache) override;
 private: // from ICredentialConsumer
     const Brx& Id() const override;
     void CredentialsChanged(const Brx& aUsername, const Brx& aPassword) override;
@@ -80,6 +83,7 @@ private:
     Bws<512> iPathAndQuery; // slightly too large for the stack; requires that all network operations are serialised
     Configuration::ConfigChoice* iConfigQuality;
     TUint iSubscriberIdQuality;
+    IStreamUrlCache* iStreamUrlCache;
 };
 
 };  // namespace Av
@@ -718,8 +718,17 @@ void ProtocolRaop::OutputAudio(const Brx& aAudio)
         iSupply->OutputDelay(Delay(latency));
     }
 
-    iAudioDecryptor.Decrypt(aAudio, iAudioDecrypted);
-    iSupply->OutputData(iAudioDecrypted);
+    const TUint decryptedBytes = RaopAudioDecryptor::kPacketSizeBytes + aAudio.Bytes();
+    if (decryptedBytes <= EncodedAudio::kMaxBytes) {
+        // decrypt directly into the pipeline's audio buffer
+        Bwn buf = iSupply->WritableData(decryptedBytes);
+        iAudioDecryptor.Decrypt(aAudio, buf);
+        iSupply->CommitData(buf.Bytes());
+    }
+    else {
+        iAudioDecryptor.Decrypt(aAudio, iAudioDecrypted);
+        iSupply->OutputData(iAudioDecrypted);
+    }
 }
 
 void ProtocolRaop::OutputDiscontinuity()
@@ -1425,17 +1434,34 @@ void RaopAudioServer::Run()
 
 // RaopAudioDecryptor
 
+RaopAudioDecryptor::RaopAudioDecryptor()
+    : iInitialised(false)
+{
+    iCtx = EVP_CIPHER_CTX_new();
+    ASSERT(iCtx != nullptr);
+}
+
+RaopAudioDecryptor::~RaopAudioDecryptor()
+{
+    EVP_CIPHER_CTX_free(iCtx);
+}
+
 void RaopAudioDecryptor::Init(const Brx& aAesKey, const Brx& aAesInitVector)
 {
-    iKey.Replace(aAesKey);
+    ASSERT(aAesKey.Bytes() == kAesKeyBytes);
     iInitVector.Replace(aAesInitVector);
+    ASSERT(iInitVector.Bytes() == kAesInitVectorBytes);
+    // EVP selects hardware AES (AES-NI, ARMv8 crypto extensions) where available
+    const TInt ret = EVP_DecryptInit_ex(iCtx, EVP_aes_128_cbc(), nullptr, aAesKey.Ptr(), iInitVector.Ptr());
+    ASSERT(ret == 1);
+    (void)EVP_CIPHER_CTX_set_padding(iCtx, 0);
+    iInitialised = true;
 }
 
 void RaopAudioDecryptor::Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const
 {
     //LOG(kMedia, ">RaopAudioDecryptor::Decrypt aEncryptedIn.Bytes(): %u\n", aEncryptedIn.Bytes());
-    ASSERT(iKey.Bytes() > 0);
-    ASSERT(iInitVector.Bytes() > 0);
+    ASSERT(iInitialised);
     ASSERT(aAudioOut.MaxBytes() >= kPacketSizeBytes+aEncryptedIn.Bytes());
 
     aAudioOut.SetBytes(0);
@@ -1443,14 +1469,20 @@ void RaopAudioDecryptor::Decrypt(const Brx& aEncryptedIn, Bwx& aAudioOut) const
     WriterBinary writerBinary(writerBuffer);
     writerBinary.WriteUint32Be(aEncryptedIn.Bytes());    // Write out payload size.
 
-    unsigned char* inBuf = const_cast<unsigned char*>(aEncryptedIn.Ptr());
+    const unsigned char* inBuf = aEncryptedIn.Ptr();
     unsigned char* outBuf = const_cast<unsigned char*>(aAudioOut.Ptr()+aAudioOut.Bytes());
-    unsigned char initVector[16];
-    memcpy(initVector, iInitVector.Ptr(), sizeof(initVector));  // Use same initVector at start of each decryption block.
-
-    AES_cbc_encrypt(inBuf, outBuf, aEncryptedIn.Bytes(), (AES_KEY*)iKey.Ptr(), initVector, AES_DECRYPT);
-    const TUint audioRemaining = aEncryptedIn.Bytes() % 16;
+    const TUint audioRemaining = aEncryptedIn.Bytes() % kAesBlockBytes;
     const TUint audioWritten = aEncryptedIn.Bytes()-audioRemaining;
+
+    if (audioWritten > 0) {
+        // Use same initVector at start of each packet; cipher and key schedule are unchanged
+        TInt ret = EVP_DecryptInit_ex(iCtx, nullptr, nullptr, nullptr, iInitVector.Ptr());
+        ASSERT(ret == 1);
+        int outBytes = 0;
+        ret = EVP_DecryptUpdate(iCtx, outBuf, &outBytes, inBuf, static_cast<int>(audioWritten));
+        ASSERT(ret == 1);
+        ASSERT(static_cast<TUint>(outBytes) == audioWritten);
+    }
     if (audioRemaining > 0) {
         // Copy remaining audio to outBuf if <16 bytes.
         memcpy(outBuf+audioWritten, inBuf+audioWritten, audioRemaining);
@@ -400,15 +400,27 @@ void RaopDiscoverySession::Run()
                         iActive = true;     // don't allow second stream to connect
                         LOG(kPipeline, "RaopDiscoverySession::Run %u kAnnounce\n", iInstance);
                         ReadSdp(iSdpInfo); //get encoded aes key
-                        DecryptAeskey();
-                        iWriterResponse->WriteStatus(HttpStatus::kOk, Http::eRtsp10);
-                        iWriterResponse->WriteHeader(Brn("Audio-Jack-Status"), Brn("connected; type=analog"));
-                        WriteSeq(iHeaderCSeq.CSeq());
-                        if(iHeaderAppleChallenge.Received()) {
-                            GenerateAppleResponse(iHeaderAppleChallenge.Challenge());   //encrypt challenge using rsa private key
-                            iWriterResponse->WriteHeaderBase64(Brn("Apple-Response"), iResponse);
-                            iHeaderAppleChallenge.Reset();
-                            LOG(kMedia, "RaopDiscoverySession::Run %u. Challenge response\n", iInstance);
+                        try {
+                            DecryptAeskey();
+                        }
+                        catch (RaopError&) {
+                            LOG_ERROR(kPipeline, "RaopDiscoverySession::Run %u. Reject ANNOUNCE with invalid aes key/iv\n", iInstance);
+                            iActive = false;
+                        }
+                        if (!iActive) {
+                            iWriterResponse->WriteStatus(RtspStatus::kBadRequest, Http::eRtsp10);
+                            WriteSeq(iHeaderCSeq.CSeq());
+                        }
+                        else {
+                            iWriterResponse->WriteStatus(HttpStatus::kOk, Http::eRtsp10);
+                            iWriterResponse->WriteHeader(Brn("Audio-Jack-Status"), Brn("connected; type=analog"));
+                            WriteSeq(iHeaderCSeq.CSeq());
+                            if(iHeaderAppleChallenge.Received()) {
+                                GenerateAppleResponse(iHeaderAppleChallenge.Challenge());   //encrypt challenge using rsa private key
+                                iWriterResponse->WriteHeaderBase64(Brn("Apple-Response"), iResponse);
+                                iHeaderAppleChallenge.Reset();
+                                LOG(kMedia, "RaopDiscoverySession::Run %u. Challenge response\n", iInstance);
+                            }
                         }
                     }
                     iWriterResponse->WriteFlush();
@@ -697,16 +709,24 @@ void RaopDiscoverySession::GenerateAppleResponse(const Brx& aChallenge)
 
 void RaopDiscoverySession::DecryptAeskey()
 {
+    // both come from the client's SDP so may be anything; RaopAudioDecryptor requires exact sizes
+    iAeskeyPresent = false;
+    if (iSdpInfo.Aesiv().Bytes() != kAesInitVectorBytes) {
+        LOG_ERROR(kPipeline, "RaopDiscoverySession::DecryptAeskey %u. aesiv is %u bytes\n", iInstance, iSdpInfo.Aesiv().Bytes());
+        THROW(RaopError);
+    }
     Brn rsaaeskey(iSdpInfo.Rsaaeskey());
-    unsigned char aeskey[128];
+    unsigned char aeskey[512];
+    ASSERT((TUint)RSA_size(iRsa) <= sizeof(aeskey)); // plaintext from a client can be up to the modulus size, not just kAesKeyBytes
     TInt res = RSA_private_decrypt(rsaaeskey.Bytes(), rsaaeskey.Ptr(), aeskey, iRsa, RSA_PKCS1_OAEP_PADDING);
-    if(res > 0) {
-        AES_KEY key;
-        AES_set_decrypt_key(aeskey, 128, &key);
-        iAeskey.Replace((const TByte* )&key, sizeof(AES_KEY));
-        iAeskeyPresent = true;
-        iAesSid++;
+    if (res != (TInt)kAesKeyBytes) {
+        LOG_ERROR(kPipeline, "RaopDiscoverySession::DecryptAeskey %u. rsaaeskey decrypt returned %d\n", iInstance, res);
+        THROW(RaopError);
     }
+    // store the raw key; RaopAudioDecryptor expands it once per session
+    iAeskey.Replace(aeskey, kAesKeyBytes);
+    iAeskeyPresent = true;
+    iAesSid++;
 }
 
 TUint RaopDiscoverySession::AesSid()
@@ -753,7 +773,12 @@ void RaopDiscoverySession::ReadSdp(ISdpHandler& aSdpHandler)
         Brn type = parser.Next('=');
         Brn value = Ascii::Trim(parser.Remaining());
         if (type.Bytes() == 1) {
-            aSdpHandler.Decode(type[0], value);
+            try {
+                aSdpHandler.Decode(type[0], value);
+            }
+            catch (BufferOverflow&) { // oversized value; leave it unset and keep reading the body
+                LOG_ERROR(kPipeline, "RaopDiscoverySession::ReadSdp %u. Oversized value for %c\n", iInstance, type[0]);
+            }
         }
     }
 }
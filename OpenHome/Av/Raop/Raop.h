@@ -11,7 +11,6 @@
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
 #include  <openssl/rsa.h>
-#include  <openssl/aes.h>
 
 EXCEPTION(RaopError);
 EXCEPTION(RaopVolumeInvalid);
@@ -159,6 +158,8 @@ class RaopDiscoverySession : public SocketTcpSession, public IRaopDiscovery
 private:
     static const TUint kMaxReadBufferBytes = 12000;
     static const TUint kMaxWriteBufferBytes = 4000;
+    static const TUint kAesKeyBytes = 16;
+    static const TUint kAesInitVectorBytes = 16;
     static const unsigned char kRsaKeyPrivate[];
 public:
     RaopDiscoverySession(Environment& aEnv, RaopDiscoveryServer& aDiscovery, RaopDevice& aRaopDevice, TUint aInstance, Media::IAttenuator& aAttenuator);
@@ -180,7 +181,7 @@ private:
     void WriteFply(Brn aData);
     void ReadSdp(Media::ISdpHandler& aSdpHandler);
     void GenerateAppleResponse(const Brx& aChallenge);
-    void DecryptAeskey();
+    void DecryptAeskey(); // throws RaopError if the client's key or iv are malformed
     void DeactivateCallback();
 private:
     static const TUint kMaxPortNumBytes = 5;
@@ -199,7 +200,7 @@ private:
     HeaderCSeq iHeaderCSeq;
     HeaderRtpInfo iHeaderRtpInfo;
     Media::SdpInfo iSdpInfo;
-    Bws<sizeof(AES_KEY)> iAeskey;
+    Bws<kAesKeyBytes> iAeskey; // AES-128 key
     TBool iAeskeyPresent;
     TUint iAesSid;
     RSA *iRsa;
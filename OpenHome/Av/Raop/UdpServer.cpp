@@ -41,19 +41,22 @@ SocketUdpServer::SocketUdpServer(Environment& aEnv, TUint aMaxSize, TUint aMaxPa
     , iSocket(aEnv, aPort, aInterface)
     , iMaxSize(aMaxSize)
     , iOpen(false)
-    , iFifoWaiting(aMaxPackets)
-    , iFifoReady(aMaxPackets)
+    , iEpoch(0)
+    , iRingWrite(0)
+    , iRingRead(0)
     , iLock("UDPL")
-    , iLockFifo("UDPF")
     , iSemRead("UDPR", 0)
     , iInterrupted(false)
     , iQuit(false)
+    , iDropped(0)
     , iAdapterListenerId(0)
     , iRebindPosted(false)
 {
-    // Populate iFifoWaiting with empty packets/bufs
-    while (iFifoWaiting.SlotsFree() > 0) {
-        iFifoWaiting.Write(new MsgUdp(iMaxSize));
+    ASSERT(aMaxPackets > 0);
+    // Populate ring with empty packets/bufs
+    for (TUint i=0; i<aMaxPackets; i++) {
+        iRing.push_back(new MsgUdp(iMaxSize));
+        iRingEpoch.push_back(0);
     }
 
     iDiscard = new MsgUdp(iMaxSize);
@@ -71,25 +74,15 @@ SocketUdpServer::~SocketUdpServer()
     NetworkAdapterList& nifList = iEnv.NetworkAdapterList();
     nifList.RemoveCurrentChangeListener(iAdapterListenerId);
 
-    {
-        AutoMutex _a(iLock);
-        iOpen = false; // Ensure that if server hasn't been Close()d, thread won't try to place message into queue after socket interrupt below.
-        iQuit = true;
-    }
+    iOpen = false; // Ensure that if server hasn't been Close()d, thread won't try to place message into queue after socket interrupt below.
+    iQuit = true;
 
     iSocket.Interrupt(true);
-    // Can't hold iLock here, as server thread needs to acquire iLock to check iQuit value following iSocket.Interrupt().
     iServerThread->Join();
     delete iServerThread;
     iSocket.Close();
 
-    AutoMutex _b(iLockFifo);
-    while (iFifoReady.SlotsUsed() > 0) {
-        MsgUdp* msg = iFifoReady.Read();
-        delete msg;
-    }
-    while (iFifoWaiting.SlotsUsed() > 0) {
-        MsgUdp* msg = iFifoWaiting.Read();
+    for (auto msg : iRing) {
         delete msg;
     }
     delete iDiscard;
@@ -111,21 +104,19 @@ void SocketUdpServer::Open()
 
 void SocketUdpServer::Close()
 {
-    LOG(kMedia, "SocketUdpServer::Close\n");
-    AutoMutex _a(iLock);
+    LOG(kMedia, "SocketUdpServer::Close (%u packets dropped)\n", iDropped.load());
+    AutoMutex _(iLock);
+    // Order matters - server thread reads iEpoch then iOpen, so will either see the server
+    // closed or publish its packet with an old epoch (which readers then discard)
     iOpen = false;
+    iEpoch++;
 
     // Terminate any current read on server thread.
     iSocket.Interrupt(true);
 
-    AutoMutex _b(iLockFifo);
-    // Move all messages from ready queue back to waiting queue.
-    // It's fine to clear iFifoReady.ReadInterrupt() state here, as any
-    // call to Read() will result in a UdpServerClosed due to iOpen == false.
-    while (iFifoReady.SlotsUsed() > 0) {
-        MsgUdp* msg = iFifoReady.Read();
-        iFifoWaiting.Write(msg);
-    }
+    // Discard all ready packets.
+    // Any call to Receive() will result in a UdpServerClosed due to iOpen == false.
+    iRingRead.store(iRingWrite.load());
 
     iSocket.Interrupt(false);
 }
@@ -142,7 +133,7 @@ TUint SocketUdpServer::Port() const
 
 void SocketUdpServer::Interrupt(TBool aInterrupt)
 {
-    // Clients only read from iFifoReady, so only need interrupt that.
+    // Clients only read from the ring, so only need interrupt that.
     // Want to continue reading from iSocket and buffering packets in background.
     AutoMutex _(iLock);
     iInterrupted = aInterrupt;
@@ -191,27 +182,44 @@ Endpoint SocketUdpServer::Receive(Bwx& aBuf)
     // Use for loop to consume extra iSemRead signals when message not available (e.g., Interrupt() was called many times).
     for (;;) {
         iSemRead.Wait();
-        {
-            AutoMutex _(iLock);
-            if (iInterrupted) {
-                THROW(NetworkError);
-            }
+        AutoMutex _(iLock);
+        if (iInterrupted) {
+            THROW(NetworkError);
         }
-
-        AutoMutex _(iLockFifo);
-        if (iFifoReady.SlotsUsed() > 0) {
-            // Get data from msg.
-            MsgUdp* msg = iFifoReady.Read();
+        MsgUdp* msg = NextReady();
+        if (msg != nullptr) {
             Endpoint ep;
             CopyMsgToBuf(*msg, aBuf, ep);
-            ASSERT(iFifoWaiting.SlotsUsed() < iFifoWaiting.Slots());
-            iFifoWaiting.Write(msg);
+            // slot can now be reused by server thread
+            iRingRead.store((iRingRead.load() + 1) % (2 * iRing.size()));
             return ep;
         }
-        else {
-            continue;
+    }
+}
+
+TUint SocketUdpServer::Dropped() const
+{
+    return iDropped.load();
+}
+
+MsgUdp* SocketUdpServer::NextReady()
+{
+    // called with iLock held
+    const TUint slots = iRing.size();
+    const TUint epoch = iEpoch.load();
+    TUint read = iRingRead.load();
+    const TUint write = iRingWrite.load();
+    while (read != write) {
+        const TUint slot = read % slots;
+        if (iRingEpoch[slot] == epoch) {
+            iRingRead.store(read);
+            return iRing[slot];
         }
+        // published after Close(); discard
+        read = (read + 1) % (2 * slots);
     }
+    iRingRead.store(read);
+    return nullptr;
 }
 
 void SocketUdpServer::CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint)
@@ -224,12 +232,10 @@ void SocketUdpServer::CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint)
 
 void SocketUdpServer::ServerThread()
 {
+    const TUint slots = iRing.size();
     for (;;) {
-        {
-            AutoMutex _(iLock);
-            if (iQuit) {
-                return;
-            }
+        if (iQuit) {
+            return;
         }
 
         try {
@@ -244,18 +250,24 @@ void SocketUdpServer::ServerThread()
             continue;
         }
 
-        AutoMutex _a(iLock);
+        const TUint epoch = iEpoch.load();
         if (iOpen) {
-            AutoMutex _b(iLockFifo);
-            if (iFifoWaiting.SlotsUsed() == 0) {
+            const TUint write = iRingWrite.load();
+            const TUint used = (write + 2 * slots - iRingRead.load()) % (2 * slots);
+            if (used == slots) {
                 // No more packets to read into.
                 // Drop this packet and reuse iDiscard to read next packet.
+                iDropped++;
                 continue;
             }
 
-            ASSERT(iFifoReady.SlotsUsed() < iFifoReady.Slots());
-            iFifoReady.Write(iDiscard);
-            iDiscard = iFifoWaiting.Read();
+            // Slot is unused by readers, so swap our packet into it then publish.
+            const TUint slot = write % slots;
+            MsgUdp* msg = iRing[slot];
+            iRing[slot] = iDiscard;
+            iRingEpoch[slot] = epoch;
+            iDiscard = msg;
+            iRingWrite.store((write + 1) % (2 * slots));
             iSemRead.Signal();
         }
     }
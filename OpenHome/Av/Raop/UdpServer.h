@@ -1,8 +1,10 @@
 #pragma once
 
-#include <OpenHome/Private/Fifo.h>
 #include <OpenHome/Private/Network.h>
 
+#include <atomic>
+#include <vector>
+
 EXCEPTION(UdpServerClosed);
 
 namespace OpenHome {
@@ -27,6 +29,9 @@ private:
 /**
  * Class for a continuously running server which buffers packets while active
  * and discards packets when deactivated
+ *
+ * Packets are passed from the server thread to readers via a single-producer ring.
+ * The server thread never blocks on a lock, so keeps up with bursts of packets.
  */
 class SocketUdpServer
 {
@@ -46,8 +51,10 @@ public:
     void SetTtl(TUint aTtl);
     
     Endpoint Receive(Bwx& aBuf);
+    TUint Dropped() const; // packets discarded while open as all slots were full
 private:
     static void CopyMsgToBuf(MsgUdp& aMsg, Bwx& aBuf, Endpoint& aEndpoint);
+    MsgUdp* NextReady();
     void ServerThread();
     void CurrentAdapterChanged();
     struct RebindJob {
@@ -61,16 +68,19 @@ private:
     Environment& iEnv;
     SocketUdp iSocket;
     TUint iMaxSize;
-    TBool iOpen;
-    FifoLiteDynamic<MsgUdp*> iFifoWaiting;
-    FifoLiteDynamic<MsgUdp*> iFifoReady;
+    std::atomic<TBool> iOpen;
+    std::atomic<TUint> iEpoch;          // incremented on Close(); packets from earlier epochs are discarded
+    std::vector<MsgUdp*> iRing;
+    std::vector<TUint> iRingEpoch;
+    std::atomic<TUint> iRingWrite;      // in [0, 2*slots); written by server thread only
+    std::atomic<TUint> iRingRead;       // in [0, 2*slots); written with iLock held
     MsgUdp* iDiscard;
     mutable Mutex iLock;
-    Mutex iLockFifo;
     Semaphore iSemRead;
     ThreadFunctor* iServerThread;
     TBool iInterrupted;
-    TBool iQuit;
+    std::atomic<TBool> iQuit;
+    std::atomic<TUint> iDropped;
     TUint iAdapterListenerId;
     TBool iRebindPosted;
     RebindJob iRebindJob;
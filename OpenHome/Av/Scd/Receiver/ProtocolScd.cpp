@@ -59,6 +59,7 @@ void ProtocolScd::Interrupt(TBool aInterrupt)
     if (aInterrupt) {
         iStopped = true;
     }
+    iResolverClient.Interrupt(aInterrupt);
     iTcpClient.Interrupt(aInterrupt);
 }
 
@@ -74,6 +75,7 @@ ProtocolStreamResult ProtocolScd::Stream(const Brx& aUri)
         iStreamId = IPipelineIdProvider::kStreamIdInvalid;
         iNextFlushId = MsgFlush::kIdInvalid;
         iStarted = iStopped = iUnrecoverableError = iExit = false;
+        iResolverClient.Interrupt(false);
         iFormatReqd = true;
     }
 
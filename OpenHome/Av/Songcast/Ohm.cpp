@@ -32,7 +32,7 @@ void OhmHeader::Internalise(IReader& aReader)
         THROW(OhmError);
     }
     iMsgType  = reader.ReadUintBe(1);
-    if(iMsgType > kMsgTypeResend && iMsgType != kMsgTypeAudioBlob) {
+    if(iMsgType > kMsgTypeLatency && iMsgType != kMsgTypeAudioBlob) {
         THROW(OhmError);
     }
     iBytes = reader.ReadUintBe(2);
@@ -326,6 +326,41 @@ void OhmHeaderResend::Externalise(IWriter& aWriter) const
 
     writer.WriteUint32Be(iFramesCount);
 }
+
+// OhmHeaderLatency
+
+OhmHeaderLatency::OhmHeaderLatency()
+    : iLatencyMs(0)
+    , iJitterUs(0)
+{
+}
+
+OhmHeaderLatency::OhmHeaderLatency(TUint aLatencyMs, TUint aJitterUs)
+    : iLatencyMs(aLatencyMs)
+    , iJitterUs(aJitterUs)
+{
+}
+
+void OhmHeaderLatency::Internalise(IReader& aReader, const OhmHeader& aHeader)
+{
+    ASSERT (aHeader.MsgType() == OhmHeader::kMsgTypeLatency);
+    if (aHeader.MsgBytes() < kHeaderBytes) {
+        THROW(OhmError);
+    }
+
+    ReaderBinary readerBinary(aReader);
+
+    iLatencyMs = readerBinary.ReadUintBe(4);
+    iJitterUs = readerBinary.ReadUintBe(4);
+}
+
+void OhmHeaderLatency::Externalise(IWriter& aWriter) const
+{
+    WriterBinary writer(aWriter);
+
+    writer.WriteUint32Be(iLatencyMs);
+    writer.WriteUint32Be(iJitterUs);
+}
     
     
 
@@ -38,6 +38,7 @@ public:
     static const TUint kMsgTypeMetatext = 5;
     static const TUint kMsgTypeSlave = 6;
     static const TUint kMsgTypeResend = 7;
+    static const TUint kMsgTypeLatency = 8;
     static const TUint kMsgTypeAudioBlob = 255; // locally generated, is never sent over the network
 
 public:
@@ -260,6 +261,31 @@ private:
     TUint iFramesCount;
 };
 
+class OhmHeaderLatency
+{
+public:
+    static const TUint kHeaderBytes = 8;
+
+public:
+    OhmHeaderLatency();
+    OhmHeaderLatency(TUint aLatencyMs, TUint aJitterUs);
+
+    void Internalise(IReader& aReader, const OhmHeader& aHeader);
+    void Externalise(IWriter& aWriter) const;
+
+    TUint LatencyMs() const {return iLatencyMs;}
+    TUint JitterUs() const {return iJitterUs;}
+    TUint MsgBytes() const {return kHeaderBytes;}
+
+private:
+    //Offset    Bytes                   Desc
+    //0         4                       Latency recommended by receiver (ms)
+    //4         4                       Inter-arrival jitter measured by receiver (us)
+
+    TUint iLatencyMs;
+    TUint iJitterUs;
+};
+
 class OhzHeader
 {
 public:
@@ -0,0 +1,199 @@
+#include <OpenHome/Av/Songcast/OhmJitter.h>
+#include <OpenHome/Types.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// OhmJitterEstimator
+
+OhmJitterEstimator::OhmJitterEstimator(TUint aMinLatencyMs, TUint aMaxLatencyMs)
+    : iMinLatencyMs(aMinLatencyMs)
+    , iMaxLatencyMs(aMaxLatencyMs)
+{
+    Reset();
+}
+
+void OhmJitterEstimator::Reset()
+{
+    iSampleRate = 0;
+    iLastSampleStart = 0;
+    iLastTransitUs = 0;
+    iJitterUs16 = 0;
+    iMinTransitUs = iMaxTransitUs = 0;
+    iPrevMinTransitUs = iPrevMaxTransitUs = 0;
+    iWindowFrames = 0;
+    iFrames = 0;
+}
+
+void OhmJitterEstimator::Add(TUint64 aRxTimeUs, TUint64 aSampleStart, TUint aSampleRate)
+{
+    if (aSampleRate == 0) {
+        return;
+    }
+    if (iFrames > 0) {
+        // a jump back of more than a second implies a new stream (rather than a frame
+        // arriving out of order); transit times aren't comparable with those seen previously
+        if (aSampleRate != iSampleRate || aSampleStart + aSampleRate < iLastSampleStart) {
+            Reset();
+        }
+    }
+    iSampleRate = aSampleRate;
+    if (aSampleStart > iLastSampleStart) {
+        iLastSampleStart = aSampleStart;
+    }
+    const TUint64 sentUs = (aSampleStart * 1000000) / aSampleRate;
+    const TInt64 transitUs = static_cast<TInt64>(aRxTimeUs - sentUs);
+    if (iFrames > 0) {
+        const TInt64 step = transitUs - iLastTransitUs;
+        if (step > kMaxTransitStepUs || step < -kMaxTransitStepUs) {
+            // sender paused or its clock jumped
+            Reset();
+            iSampleRate = aSampleRate;
+            iLastSampleStart = aSampleStart;
+        }
+    }
+
+    if (iFrames == 0) {
+        StartWindow(transitUs);
+        iPrevMinTransitUs = iPrevMaxTransitUs = transitUs;
+    }
+    else {
+        const TInt64 diff = transitUs - iLastTransitUs;
+        const TUint64 absDiff = static_cast<TUint64>(diff < 0? -diff : diff);
+        iJitterUs16 += absDiff - (iJitterUs16 >> 4);
+        if (iWindowFrames == kWindowFrames) {
+            iPrevMinTransitUs = iMinTransitUs;
+            iPrevMaxTransitUs = iMaxTransitUs;
+            StartWindow(transitUs);
+        }
+        if (transitUs < iMinTransitUs) {
+            iMinTransitUs = transitUs;
+        }
+        if (transitUs > iMaxTransitUs) {
+            iMaxTransitUs = transitUs;
+        }
+    }
+    iLastTransitUs = transitUs;
+    iWindowFrames++;
+    iFrames++;
+}
+
+TBool OhmJitterEstimator::HasEstimate() const
+{
+    return iFrames >= kMinFramesForEstimate;
+}
+
+TUint OhmJitterEstimator::JitterUs() const
+{
+    return static_cast<TUint>(iJitterUs16 >> 4);
+}
+
+TUint OhmJitterEstimator::MaxExcessUs() const
+{
+    if (iFrames == 0) {
+        return 0;
+    }
+    const TInt64 minTransit = (iMinTransitUs < iPrevMinTransitUs? iMinTransitUs : iPrevMinTransitUs);
+    const TInt64 maxTransit = (iMaxTransitUs > iPrevMaxTransitUs? iMaxTransitUs : iPrevMaxTransitUs);
+    return static_cast<TUint>(maxTransit - minTransit);
+}
+
+TUint OhmJitterEstimator::RecommendedLatencyMs() const
+{
+    TUint coverUs = MaxExcessUs();
+    const TUint jitterUs = JitterUs() * 4;
+    if (jitterUs > coverUs) {
+        coverUs = jitterUs;
+    }
+    TUint latencyMs = (coverUs + 999) / 1000 + kMarginMs;
+    latencyMs = ((latencyMs + kGranularityMs - 1) / kGranularityMs) * kGranularityMs;
+    if (latencyMs < iMinLatencyMs) {
+        return iMinLatencyMs;
+    }
+    if (latencyMs > iMaxLatencyMs) {
+        return iMaxLatencyMs;
+    }
+    return latencyMs;
+}
+
+void OhmJitterEstimator::StartWindow(TInt64 aTransitUs)
+{
+    iMinTransitUs = iMaxTransitUs = aTransitUs;
+    iWindowFrames = 0;
+}
+
+
+// OhmLatencySelector
+
+OhmLatencySelector::OhmLatencySelector(TUint aMaxLatencyMs)
+    : iMaxLatencyMs(aMaxLatencyMs)
+{
+    Reset();
+}
+
+void OhmLatencySelector::Reset()
+{
+    iLatencyMs = 0;
+    iLastChangeUs = 0;
+    iLastReportUs = 0;
+    iHoldStartUs = 0;
+    iHoldPeakMs = 0;
+}
+
+TBool OhmLatencySelector::Add(TUint64 aNowUs, TUint aRecommendedMs)
+{
+    iLastReportUs = aNowUs;
+    if (aRecommendedMs > iMaxLatencyMs) {
+        aRecommendedMs = iMaxLatencyMs;
+    }
+    if (aRecommendedMs > iHoldPeakMs) {
+        iHoldPeakMs = aRecommendedMs;
+    }
+    if (iLatencyMs == 0) {
+        Change(aNowUs, iHoldPeakMs);
+        return true;
+    }
+    if (aNowUs - iLastChangeUs < kMinChangeIntervalMs * 1000ULL) {
+        return false; // any higher report is applied once the interval has passed
+    }
+    if (iHoldPeakMs > iLatencyMs) {
+        Change(aNowUs, iHoldPeakMs);
+        return true;
+    }
+    if (aNowUs - iHoldStartUs < kDecreaseHoldMs * 1000ULL) {
+        return false;
+    }
+    if (iHoldPeakMs + kDecreaseMarginMs <= iLatencyMs) {
+        Change(aNowUs, iHoldPeakMs);
+        return true;
+    }
+    // no sustained fall; start a new hold period from this report
+    iHoldStartUs = aNowUs;
+    iHoldPeakMs = aRecommendedMs;
+    return false;
+}
+
+TBool OhmLatencySelector::Expire(TUint64 aNowUs)
+{
+    if (iLatencyMs == 0) {
+        return false;
+    }
+    if (aNowUs - iLastReportUs < kReportExpiryMs * 500ULL) {
+        return false; // a report raced with the caller's timer
+    }
+    Reset();
+    return true;
+}
+
+TUint OhmLatencySelector::LatencyMs() const
+{
+    return iLatencyMs;
+}
+
+void OhmLatencySelector::Change(TUint64 aNowUs, TUint aLatencyMs)
+{
+    iLatencyMs = aLatencyMs;
+    iLastChangeUs = aNowUs;
+    iHoldStartUs = aNowUs;
+    iHoldPeakMs = 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+
+namespace OpenHome {
+namespace Av {
+
+/*
+ * Estimates the latency a receiver needs to absorb network jitter on a Songcast stream.
+ *
+ * Each audio frame's arrival time is compared with its position in the stream (SampleStart),
+ * giving a relative transit time.  The smallest transit seen over the last two windows is
+ * taken as the baseline; a frame arriving later than this would have been played late (and
+ * so repaired or ramped) had latency been less than its excess transit.
+ * Smoothed inter-arrival jitter is also reported, calculated as per RFC 3550.
+ */
+class OhmJitterEstimator
+{
+public:
+    static const TUint kWindowFrames = 1000;
+    static const TUint kMinFramesForEstimate = 100;
+    static const TUint kMarginMs = 10;
+    static const TUint kGranularityMs = 10;
+private:
+    static const TInt64 kMaxTransitStepUs = 1000000;
+public:
+    OhmJitterEstimator(TUint aMinLatencyMs, TUint aMaxLatencyMs);
+    void Reset();
+    void Add(TUint64 aRxTimeUs, TUint64 aSampleStart, TUint aSampleRate);
+    TBool HasEstimate() const;
+    TUint JitterUs() const;
+    TUint MaxExcessUs() const;
+    TUint RecommendedLatencyMs() const;
+private:
+    void StartWindow(TInt64 aTransitUs);
+private:
+    const TUint iMinLatencyMs;
+    const TUint iMaxLatencyMs;
+    TUint iSampleRate;
+    TUint64 iLastSampleStart;
+    TInt64 iLastTransitUs;
+    TUint64 iJitterUs16; // RFC 3550 jitter, scaled by 16
+    TInt64 iMinTransitUs;
+    TInt64 iMaxTransitUs;
+    TInt64 iPrevMinTransitUs;
+    TInt64 iPrevMaxTransitUs;
+    TUint iWindowFrames;
+    TUint iFrames;
+};
+
+/*
+ * Chooses the latency a sender applies from its receivers' recommendations.
+ *
+ * Each change alters the latency of all audio sent, so every receiver re-ramps.  Changes
+ * are therefore damped.  Latency rises as soon as any receiver recommends more, but never
+ * within kMinChangeIntervalMs of the previous change.  It only falls once every report over
+ * kDecreaseHoldMs has been at least kDecreaseMarginMs lower, then drops to the highest of
+ * those reports.  If reports stop (e.g. the last adaptive receiver leaves), the owner should
+ * call Expire() kReportExpiryMs after the last one so the sender reverts to its own latency.
+ */
+class OhmLatencySelector
+{
+public:
+    static const TUint kMinChangeIntervalMs = 2000;
+    static const TUint kDecreaseHoldMs = 30000;
+    static const TUint kDecreaseMarginMs = 2 * OhmJitterEstimator::kGranularityMs;
+    static const TUint kReportExpiryMs = kDecreaseHoldMs;
+public:
+    OhmLatencySelector(TUint aMaxLatencyMs);
+    void Reset();
+    TBool Add(TUint64 aNowUs, TUint aRecommendedMs); // returns true if LatencyMs() changed
+    TBool Expire(TUint64 aNowUs); // returns true if LatencyMs() changed (to 0)
+    TUint LatencyMs() const; // 0 until a recommendation is received
+private:
+    void Change(TUint64 aNowUs, TUint aLatencyMs);
+private:
+    const TUint iMaxLatencyMs;
+    TUint iLatencyMs;
+    TUint64 iLastChangeUs;
+    TUint64 iLastReportUs;
+    TUint64 iHoldStartUs;
+    TUint iHoldPeakMs;
+};
+
+} // namespace Av
+} // namespace OpenHome
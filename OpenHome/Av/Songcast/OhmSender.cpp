@@ -4,6 +4,7 @@
 #include <OpenHome/Private/Converter.h>
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Private/Arch.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Av/Debug.h>
@@ -295,11 +296,13 @@ void ProviderSender::TimerAudioExpired()
 
 // OhmSenderDriver
 
-OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper)
+OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper,
+                                 Optional<Media::ISenderActivityObserver> aActivityObserver)
     : iMutex("OHMD")
     , iEnabled(false)
     , iActive(false)
     , iSend(false)
+    , iSendNotified(false)
     , iFrame(0)
     , iSampleRate(0)
     , iTimestampMultiplier(0)
@@ -312,6 +315,7 @@ OhmSenderDriver::OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aT
     , iSocket(aEnv)
     , iFactory(110, 10, 10) // FIXME - rationale for msg counts??
     , iTimestamper(aTimestamper.Ptr())
+    , iActivityObserver(aActivityObserver.Ptr())
     , iFirstFrame(true)
 {
 }
@@ -493,6 +497,7 @@ void OhmSenderDriver::SetEnabled(TBool aValue)
             iSend = true;
         }
     }
+    NotifySendLocked();
 }
 
 void OhmSenderDriver::SetActive(TBool aValue)
@@ -513,6 +518,7 @@ void OhmSenderDriver::SetActive(TBool aValue)
             }
         }
     }
+    NotifySendLocked();
 }
 
 void OhmSenderDriver::SetEndpoint(const Endpoint& aEndpoint, TIpAddress aAdapter)
@@ -625,6 +631,16 @@ void OhmSenderDriver::ResetLocked()
     }
 }
 
+void OhmSenderDriver::NotifySendLocked()
+{
+    if (iSend != iSendNotified) {
+        iSendNotified = iSend;
+        if (iActivityObserver != nullptr) {
+            iActivityObserver->NotifySenderActive(iSend);
+        }
+    }
+}
+
 
 // OhmSender
 
@@ -646,6 +662,10 @@ OhmSender::OhmSender(Environment& aEnv, Net::DvDeviceStandard& aDevice, IOhmSend
     , iRxBuffer(iSocketOhm)
     , iMutexStartStop("OHMS")
     , iMutexActive("OHMA")
+    , iMutexLatency("OHML")
+    , iLatencyConfigured(0)
+    , iLatencySelector(kMaxRecommendedLatencyMs)
+    , iLatencyDriver(0)
     , iNetworkDeactivated("OHDN", 0)
     , iZoneDeactivated("OHDZ", 0)
     , iStarted(false)
@@ -660,12 +680,12 @@ OhmSender::OhmSender(Environment& aEnv, Net::DvDeviceStandard& aDevice, IOhmSend
     CurrentSubnetChanged(); // roundabout way of initialising iInterface
  
     iDriver.SetTtl(kTtl);
-    iDriver.SetLatency(iLatency);
-    LOG(kSongcast, "OHM SENDER DRIVER LATENCY %d\n", iLatency);
+    UpdateDriverLatency(iLatency);
        
     iTimerAliveJoin = new Timer(aEnv, MakeFunctor(*this, &OhmSender::TimerAliveJoinExpired), "OhmSenderAliveJoin");
     iTimerAliveAudio = new Timer(aEnv, MakeFunctor(*this, &OhmSender::TimerAliveAudioExpired), "OhmSenderAliveAudio");
     iTimerExpiry = new Timer(aEnv, MakeFunctor(*this, &OhmSender::TimerExpiryExpired), "OhmSenderExpiry");
+    iTimerLatency = new Timer(aEnv, MakeFunctor(*this, &OhmSender::TimerLatencyExpired), "OhmSenderLatency");
 
     iThreadMulticast = new ThreadFunctor("OhmSenderM", MakeFunctor(*this, &OhmSender::RunMulticast), aThreadPriority, kThreadStackBytesNetwork);
     iThreadMulticast->Start();
@@ -699,6 +719,7 @@ OhmSender::~OhmSender()
     delete iTimerAliveJoin;
     delete iTimerAliveAudio;
     delete iTimerExpiry;
+    delete iTimerLatency;
     LOG(kSongcast, "OhmSender::~OhmSender deleted timers\n");
     delete iProvider;
     LOG(kSongcast, "OhmSender::~OhmSender deleted provider\n");
@@ -756,14 +777,12 @@ void OhmSender::SetLatency(TUint aValue)
         if (iStarted) {
             Stop();
             iLatency = aValue;
-            iDriver.SetLatency(iLatency);
-            LOG(kSongcast, "OHM SENDER DRIVER LATENCY %d\n", iLatency);
+            UpdateDriverLatency(iLatency);
             Start();
         }
         else {
             iLatency = aValue;
-            iDriver.SetLatency(iLatency);
-            LOG(kSongcast, "OHM SENDER DRIVER LATENCY %d\n", iLatency);
+            UpdateDriverLatency(iLatency);
         }
     }
 }
@@ -868,6 +887,12 @@ void OhmSender::Stop()
         LOG(kSongcast, "STOP CLOSE\n");
         iSocketOhm.Close();
         iStarted = false;
+        iTimerLatency->Cancel();
+        {
+            AutoMutex _(iMutexLatency);
+            iLatencySelector.Reset(); // receivers will report again once we restart
+            UpdateDriverLatencyLocked();
+        }
         LOG(kSongcast, "STOP UPDATE\n");
         UpdateUri();
         LOG(kSongcast, "STOP DONE\n");
@@ -975,6 +1000,9 @@ void OhmSender::RunMulticast()
                         iTimerAliveJoin->FireIn(kTimerAliveJoinTimeoutMs);
                         iProvider->NotifyListeners(true);
                     }
+                    else if (header.MsgType() == OhmHeader::kMsgTypeLatency) {
+                        LatencyRecommended(header);
+                    }
                     else if (header.MsgType() == OhmHeader::kMsgTypeResend) {
                         LOG(kSongcast, "OhmSender::RunMulticast resend received\n");
 
@@ -1193,6 +1221,9 @@ void OhmSender::RunUnicast()
                                 }
                             }
                         }
+                        else if (header.MsgType() == OhmHeader::kMsgTypeLatency) {
+                            LatencyRecommended(header);
+                        }
                         else if (header.MsgType() == OhmHeader::kMsgTypeResend) {
                             LOG(kSongcast, "OhmSender::RunUnicast resend received\n");
                             OhmHeaderResend headerResend;
@@ -1282,6 +1313,52 @@ void OhmSender::TimerExpiryExpired()
     }
 }
 
+void OhmSender::LatencyRecommended(const OhmHeader& aHeader)
+{
+    // Receivers with adaptive latency enabled report the latency their network jitter requires.
+    // iLatencySelector damps changes as each one makes every receiver re-ramp.
+    OhmHeaderLatency headerLatency;
+    headerLatency.Internalise(iRxBuffer, aHeader);
+    const TUint latencyMs = headerLatency.LatencyMs();
+    LOG(kSongcast, "OhmSender: receiver recommends latency of %ums (jitter %uus)\n", latencyMs, headerLatency.JitterUs());
+    const TUint64 nowUs = OsTimeInUs(iEnv.OsCtx());
+    AutoMutex _(iMutexLatency);
+    if (iLatencySelector.Add(nowUs, latencyMs)) {
+        UpdateDriverLatencyLocked();
+    }
+    iTimerLatency->FireIn(OhmLatencySelector::kReportExpiryMs);
+}
+
+void OhmSender::TimerLatencyExpired()
+{
+    // no receiver has recommended a latency for a while; revert to our configured latency
+    const TUint64 nowUs = OsTimeInUs(iEnv.OsCtx());
+    AutoMutex _(iMutexLatency);
+    if (iLatencySelector.Expire(nowUs)) {
+        LOG(kSongcast, "OhmSender: latency recommendations expired\n");
+        UpdateDriverLatencyLocked();
+    }
+}
+
+void OhmSender::UpdateDriverLatency(TUint aConfiguredMs)
+{
+    AutoMutex _(iMutexLatency);
+    iLatencyConfigured = aConfiguredMs;
+    UpdateDriverLatencyLocked();
+}
+
+void OhmSender::UpdateDriverLatencyLocked()
+{
+    // called with iMutexLatency locked
+    const TUint recommended = iLatencySelector.LatencyMs();
+    const TUint latency = (recommended > iLatencyConfigured? recommended : iLatencyConfigured);
+    if (latency != iLatencyDriver) {
+        iLatencyDriver = latency;
+        iDriver.SetLatency(iLatencyDriver);
+        LOG(kSongcast, "OHM SENDER DRIVER LATENCY %d\n", iLatencyDriver);
+    }
+}
+
 void OhmSender::UpdateChannel()
 {
     TUint address = (iChannel & 0xffff) | 0xeffd0000; // 239.253.x.x
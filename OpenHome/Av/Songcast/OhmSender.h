@@ -14,10 +14,14 @@
 #include "Ohm.h"
 #include "OhmMsg.h"
 #include "OhmSocket.h"
+#include "OhmJitter.h"
 #include "OhmSenderDriver.h"
 
 namespace OpenHome {
 class Environment;
+namespace Media {
+    class ISenderActivityObserver;
+}
 namespace Av {
 
 class ProviderSender;
@@ -28,7 +32,8 @@ class OhmSenderDriver : public IOhmSenderDriver
     static const TUint kMaxAudioFrameBytes = 6 * 1024;
     static const TUint kMaxHistoryFrames = 100;
 public:
-    OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper);
+    OhmSenderDriver(Environment& aEnv, Optional<IOhmTimestamper> aTimestamper,
+                    Optional<Media::ISenderActivityObserver> aActivityObserver); // aActivityObserver notified when sending to listeners starts/stops
     void SetAudioFormat(TUint aSampleRate, TUint aBitRate, TUint aChannels, TUint aBitDepth, TBool aLossless, const Brx& aCodecName, TUint64 aSampleStart);
     void SendAudio(const TByte* aData, TUint aBytes, TBool aHalt = false);
     OhmMsgAudio* CreateAudio();
@@ -44,12 +49,14 @@ private: // from IOhmSenderDriver
 private:
     inline void UpdateLatencyOhm();
     void ResetLocked();
+    void NotifySendLocked();
     void Resend(OhmMsgAudio& aMsg);
 private:
     Mutex iMutex;
     TBool iEnabled;
     TBool iActive;
     TBool iSend;
+    TBool iSendNotified;
     Endpoint iEndpoint;
     TIpAddress iAdapter;
     Bws<OhmMsgAudio::kStreamHeaderBytes> iStreamHeader;
@@ -66,6 +73,7 @@ private:
     OhmMsgFactory iFactory;
     FifoLite<OhmMsgAudio*, kMaxHistoryFrames> iFifoHistory;
     IOhmTimestamper* iTimestamper;
+    Media::ISenderActivityObserver* iActivityObserver;
     TBool iFirstFrame;
 };
 
@@ -79,6 +87,7 @@ class OhmSender
     static const TUint kTimerExpiryTimeoutMs = 10000;
     static const TUint kMaxSlaveCount = 4;
     static const TUint kTtl = 1;
+    static const TUint kMaxRecommendedLatencyMs = 1000;
 public:
     static const TUint kMaxNameBytes = 64;
     static const TUint kMaxTrackUriBytes = Ohm::kMaxTrackUriBytes;
@@ -117,6 +126,10 @@ private:
     void TimerAliveJoinExpired();
     void TimerAliveAudioExpired();
     void TimerExpiryExpired();
+    void TimerLatencyExpired();
+    void LatencyRecommended(const OhmHeader& aHeader);
+    void UpdateDriverLatency(TUint aConfiguredMs);
+    void UpdateDriverLatencyLocked();
     void Send();
     void SendTrackInfo();
     void SendTrack();
@@ -145,6 +158,10 @@ private:
     Bws<kMaxAudioFrameBytes> iTxBuffer;
     Mutex iMutexStartStop;
     Mutex iMutexActive;
+    Mutex iMutexLatency;
+    TUint iLatencyConfigured;
+    OhmLatencySelector iLatencySelector;
+    TUint iLatencyDriver;
     Semaphore iNetworkDeactivated;
     Semaphore iZoneDeactivated;
     ProviderSender* iProvider;
@@ -167,6 +184,7 @@ private:
     Timer* iTimerAliveJoin;
     Timer* iTimerAliveAudio;
     Timer* iTimerExpiry;
+    Timer* iTimerLatency;
     Bws<Ohm::kMaxTrackUriBytes> iTrackUri;
     Bws<Ohm::kMaxTrackMetadataBytes> iTrackMetadata;
     Bws<Ohm::kMaxTrackMetatextBytes> iTrackMetatext;
@@ -1,10 +1,137 @@
 #include "OhmSocket.h"
 #include <OpenHome/Private/Debug.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Av/Debug.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Av;
 
+// OhmReceiveQueue::Datagram
+
+OhmReceiveQueue::Datagram::Datagram(TUint aMaxBytes)
+    : iBuf(aMaxBytes)
+    , iRxTimeUs(0)
+{
+}
+
+
+// OhmReceiveQueue
+
+OhmReceiveQueue::OhmReceiveQueue(Environment& aEnv, SocketUdpBase& aSocket, TUint aThreadPriority,
+                                 TUint aMaxDatagrams, TUint aMaxDatagramBytes)
+    : iEnv(aEnv)
+    , iSocket(aSocket)
+    , iFifoFree(aMaxDatagrams)
+    , iFifoReady(aMaxDatagrams)
+    , iLock("OHRQ")
+    , iSemReady("OHRQ", 0)
+    , iInterrupted(false)
+    , iQuit(false)
+    , iDropped(0)
+{
+    while (iFifoFree.SlotsFree() > 0) {
+        iFifoFree.Write(new Datagram(aMaxDatagramBytes));
+    }
+    iPending = new Datagram(aMaxDatagramBytes);
+    iThread = new ThreadFunctor("OhmReceiveQueue", MakeFunctor(*this, &OhmReceiveQueue::Run), aThreadPriority);
+    iThread->Start();
+}
+
+OhmReceiveQueue::~OhmReceiveQueue()
+{
+    {
+        AutoMutex _(iLock);
+        iQuit = true;
+    }
+    iSocket.Interrupt(true);
+    delete iThread;
+    while (iFifoReady.SlotsUsed() > 0) {
+        delete iFifoReady.Read();
+    }
+    while (iFifoFree.SlotsUsed() > 0) {
+        delete iFifoFree.Read();
+    }
+    delete iPending;
+    if (iDropped > 0) {
+        LOG(kSongcast, "OhmReceiveQueue: dropped %u datagrams\n", iDropped);
+    }
+}
+
+Endpoint OhmReceiveQueue::Receive(Bwx& aBuffer, TUint64& aRxTimeUs)
+{
+    // loop consumes any iSemReady signals left over from datagrams read without waiting
+    for (;;) {
+        {
+            AutoMutex _(iLock);
+            if (iInterrupted) {
+                THROW(ReaderError);
+            }
+            if (iFifoReady.SlotsUsed() > 0) {
+                Datagram* datagram = iFifoReady.Read();
+                const TUint bytes = (datagram->iBuf.Bytes() < aBuffer.MaxBytes()? datagram->iBuf.Bytes() : aBuffer.MaxBytes());
+                aBuffer.Replace(datagram->iBuf.Ptr(), bytes);
+                aRxTimeUs = datagram->iRxTimeUs;
+                const Endpoint sender(datagram->iSender);
+                iFifoFree.Write(datagram);
+                return sender;
+            }
+        }
+        iSemReady.Wait();
+    }
+}
+
+void OhmReceiveQueue::Interrupt(TBool aInterrupt)
+{
+    // only the consumer is interrupted; datagrams continue to be read and queued
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (aInterrupt) {
+        iSemReady.Signal();
+    }
+}
+
+TUint OhmReceiveQueue::Dropped() const
+{
+    AutoMutex _(iLock);
+    return iDropped;
+}
+
+void OhmReceiveQueue::Run()
+{
+    for (;;) {
+        try {
+            iPending->iSender.Replace(iSocket.Receive(iPending->iBuf));
+            iPending->iRxTimeUs = OsTimeInUs(iEnv.OsCtx());
+        }
+        catch (NetworkError&) {
+            {
+                AutoMutex _(iLock);
+                if (iQuit) {
+                    return;
+                }
+            }
+            // avoid a busy loop if network operations repeatedly fail
+            Thread::Sleep(kRetryDelayMs);
+            continue;
+        }
+
+        AutoMutex _(iLock);
+        if (iQuit) {
+            return;
+        }
+        if (iFifoFree.SlotsUsed() == 0) {
+            // consumer has fallen too far behind.  Drop this datagram, reusing iPending for the next.
+            iDropped++;
+            continue;
+        }
+        iFifoReady.Write(iPending);
+        iPending = iFifoFree.Read();
+        iSemReady.Signal();
+    }
+}
+
+
 // OhmSocket
 
 // Sends on same socket in Unicast mode, but different socket in Multicast mode
@@ -14,6 +141,11 @@ OhmSocket::OhmSocket(Environment& aEnv)
     , iRxSocket(0)
     , iTxSocket(0)
     , iReader(0)
+    , iQueue(nullptr)
+    , iQueueThreadPriority(0)
+    , iQueueMaxDatagrams(0)
+    , iDatagramOffset(0)
+    , iRxTimeUs(0)
     , iLock("OHMS")
     , iInterrupt(false)
 {
@@ -26,6 +158,15 @@ OhmSocket::~OhmSocket()
     }
 }
 
+void OhmSocket::SetReceiveQueue(TUint aThreadPriority, TUint aMaxDatagrams, TUint aMaxDatagramBytes)
+{
+    AutoMutex _(iLock);
+    ASSERT(!iRxSocket);
+    iQueueThreadPriority = aThreadPriority;
+    iQueueMaxDatagrams = aMaxDatagrams;
+    iDatagram.Grow(aMaxDatagramBytes);
+}
+
 void OhmSocket::OpenUnicast(TIpAddress aInterface, TUint aTtl)
 {
     AutoMutex _(iLock);
@@ -35,11 +176,8 @@ void OhmSocket::OpenUnicast(TIpAddress aInterface, TUint aTtl)
     iRxSocket = new SocketUdp(iEnv, 0, aInterface);
     iRxSocket->SetTtl(aTtl);
     iRxSocket->SetRecvBufBytes(kReceiveBufBytes);
-    if (iInterrupt) {
-        iRxSocket->Interrupt(true);
-    }
 //    iRxSocket->SetSendBufBytes(kSendBufBytes);    // hangs in lwip, use default allocation for now - ToDo
-    iReader = new UdpReader(*iRxSocket);
+    CreateReader();
     iThis.Replace(Endpoint(iRxSocket->Port(), aInterface));
 }
 
@@ -54,11 +192,10 @@ void OhmSocket::OpenMulticast(TIpAddress aInterface, TUint aTtl, const Endpoint&
     iTxSocket = new SocketUdp(iEnv, 0, aInterface);
     iTxSocket->SetTtl(aTtl);
     if (iInterrupt) {
-        iRxSocket->Interrupt(true);
         iTxSocket->Interrupt(true);
     }
 //    iTxSocket->SetSendBufBytes(kSendBufBytes);    // hangs in lwip, use default allocation for now - ToDo
-    iReader = new UdpReader(*iRxSocket);
+    CreateReader();
     iThis.Replace(aEndpoint);
 }
 
@@ -79,6 +216,9 @@ Endpoint OhmSocket::This() const
 
 Endpoint OhmSocket::Sender() const
 {
+    if (iQueue != nullptr) {
+        return iSender;
+    }
     ASSERT(iReader);
     return iReader->Sender();
 }
@@ -87,6 +227,10 @@ void OhmSocket::Close()
 {
     AutoMutex _(iLock);
     iInterrupt = false;
+    delete iQueue;
+    iQueue = nullptr;
+    iDatagram.SetBytes(0);
+    iDatagramOffset = 0;
     delete iReader;
     iReader = nullptr;
     delete iRxSocket;
@@ -99,7 +243,10 @@ void OhmSocket::Interrupt(TBool aInterrupt)
 {
     AutoMutex _(iLock);
     iInterrupt = aInterrupt;
-    if (iRxSocket != nullptr) {
+    if (iQueue != nullptr) {
+        iQueue->Interrupt(aInterrupt);
+    }
+    else if (iRxSocket != nullptr) {
         iRxSocket->Interrupt(aInterrupt);
     }
     if (iTxSocket != nullptr) {
@@ -107,26 +254,69 @@ void OhmSocket::Interrupt(TBool aInterrupt)
     }
 }
 
+TUint64 OhmSocket::RxTimeUs() const
+{
+    return iRxTimeUs;
+}
+
 void OhmSocket::Read(Bwx& aBuffer)
 {
-    ASSERT(iReader);
-    iReader->Read(aBuffer);
+    if (iQueue == nullptr) {
+        ASSERT(iReader);
+        iReader->Read(aBuffer);
+        iRxTimeUs = OsTimeInUs(iEnv.OsCtx());
+        return;
+    }
+    if (iDatagramOffset == iDatagram.Bytes()) {
+        iSender.Replace(iQueue->Receive(iDatagram, iRxTimeUs));
+        iDatagramOffset = 0;
+    }
+    // as UdpReader, return as much of the current datagram as fits
+    TUint bytes = iDatagram.Bytes() - iDatagramOffset;
+    const TUint space = aBuffer.MaxBytes() - aBuffer.Bytes();
+    if (bytes > space) {
+        bytes = space;
+    }
+    aBuffer.Append(iDatagram.Ptr() + iDatagramOffset, bytes);
+    iDatagramOffset += bytes;
 }
 
 void OhmSocket::ReadFlush()
 {
-    if (iReader != nullptr) {
+    if (iQueue != nullptr) {
+        iDatagramOffset = iDatagram.Bytes();
+    }
+    else if (iReader != nullptr) {
         iReader->ReadFlush();
     }
 }
 
 void OhmSocket::ReadInterrupt()
 {
-    if (iReader != nullptr) {
+    if (iQueue != nullptr) {
+        iQueue->Interrupt(true);
+    }
+    else if (iReader != nullptr) {
         iReader->ReadInterrupt();
     }
 }
 
+void OhmSocket::CreateReader()
+{
+    if (iQueueMaxDatagrams > 0) {
+        iQueue = new OhmReceiveQueue(iEnv, *iRxSocket, iQueueThreadPriority, iQueueMaxDatagrams, iDatagram.MaxBytes());
+        if (iInterrupt) {
+            iQueue->Interrupt(true);
+        }
+    }
+    else {
+        if (iInterrupt) {
+            iRxSocket->Interrupt(true);
+        }
+        iReader = new UdpReader(*iRxSocket);
+    }
+}
+
 
 // OhzSocket
 
@@ -4,6 +4,8 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Fifo.h>
+#include <OpenHome/Private/Thread.h>
 
 #include "Ohm.h"
 
@@ -11,6 +13,46 @@ namespace OpenHome {
 class Environment;
 namespace Av {
 
+/*
+ * Drains a socket on a dedicated thread so that bursts of datagrams are queued here rather
+ * than overflowing the socket's receive buffer while the protocol thread is busy.
+ * Each datagram is stamped with its time of arrival.
+ */
+class OhmReceiveQueue : private INonCopyable
+{
+    static const TUint kRetryDelayMs = 50;
+    class Datagram
+    {
+    public:
+        Datagram(TUint aMaxBytes);
+    public:
+        Bwh iBuf;
+        Endpoint iSender;
+        TUint64 iRxTimeUs;
+    };
+public:
+    OhmReceiveQueue(Environment& aEnv, SocketUdpBase& aSocket, TUint aThreadPriority,
+                    TUint aMaxDatagrams, TUint aMaxDatagramBytes);
+    ~OhmReceiveQueue();
+    Endpoint Receive(Bwx& aBuffer, TUint64& aRxTimeUs); // throws ReaderError if interrupted
+    void Interrupt(TBool aInterrupt);
+    TUint Dropped() const;
+private:
+    void Run();
+private:
+    Environment& iEnv;
+    SocketUdpBase& iSocket;
+    FifoLiteDynamic<Datagram*> iFifoFree;
+    FifoLiteDynamic<Datagram*> iFifoReady;
+    Datagram* iPending;
+    mutable Mutex iLock;
+    Semaphore iSemReady;
+    ThreadFunctor* iThread;
+    TBool iInterrupted;
+    TBool iQuit;
+    TUint iDropped;
+};
+
 class OhmSocket : public IReaderSource, public INonCopyable
 {
     static const TUint kSendBufBytes = 16 * 1024;
@@ -18,6 +60,10 @@ class OhmSocket : public IReaderSource, public INonCopyable
 public:
     OhmSocket(Environment& aEnv);
     ~OhmSocket();
+    /*
+     * Receive via an OhmReceiveQueue for all subsequent Open...() calls.
+     */
+    void SetReceiveQueue(TUint aThreadPriority, TUint aMaxDatagrams, TUint aMaxDatagramBytes);
     void OpenUnicast(TIpAddress aInterface, TUint aTtl);
     void OpenMulticast(TIpAddress aInterface, TUint aTtl, const Endpoint& aEndpoint);
     Endpoint This() const;
@@ -25,15 +71,25 @@ public:
     void Send(const Brx& aBuffer, const Endpoint& aEndpoint);
     void Close();
     void Interrupt(TBool aInterrupt);
+    TUint64 RxTimeUs() const; // time the datagram currently being read arrived
 public: // from IReaderSource
     void Read(Bwx& aBuffer) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+private:
+    void CreateReader();
 private:
     Environment& iEnv;
     SocketUdpBase* iRxSocket;
     SocketUdpBase* iTxSocket;
     UdpReader* iReader;
+    OhmReceiveQueue* iQueue;
+    TUint iQueueThreadPriority;
+    TUint iQueueMaxDatagrams;
+    Bwh iDatagram;
+    TUint iDatagramOffset;
+    Endpoint iSender;
+    TUint64 iRxTimeUs;
     Endpoint iThis;
     Mutex iLock;
     TBool iInterrupt;
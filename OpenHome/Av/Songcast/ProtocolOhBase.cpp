@@ -21,7 +21,7 @@ using namespace OpenHome::Media;
 
 ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
                                Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                               Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+                               TUint aRxThreadPriority, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
     : Protocol(aEnv)
     , iEnv(aEnv)
     , iMsgFactory(aFactory)
@@ -50,7 +50,11 @@ ProtocolOhBase::ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Medi
     , iRepairFirst(nullptr)
     , iPipelineEmpty("OHBS", 0)
     , iOhmMsgProcessor(aOhmMsgProcessor)
+    , iAdaptiveLatency(false)
+    , iJitter(kAdaptiveLatencyMinMs, kAdaptiveLatencyMaxMs)
+    , iLastLatencyReportUs(0)
 {
+    iSocket.SetReceiveQueue(aRxThreadPriority, kRxQueueDatagrams, kMaxFrameBytes);
     iNacnId = iEnv.NetworkAdapterList().AddCurrentChangeListener(MakeFunctor(*this, &ProtocolOhBase::CurrentSubnetChanged), "ProtocolOhBase", false);
     iTimerRepair = new Timer(aEnv, MakeFunctor(*this, &ProtocolOhBase::TimerRepairExpired), "ProtocolOhBaseRepair");
     iRepairFrames.reserve(kMaxRepairBacklogFrames);
@@ -71,6 +75,11 @@ ProtocolOhBase::~ProtocolOhBase()
     delete iSupply;
 }
 
+void ProtocolOhBase::SetAdaptiveLatency(TBool aEnable)
+{
+    iAdaptiveLatency.store(aEnable);
+}
+
 void ProtocolOhBase::Add(OhmMsg* aMsg)
 {
     aMsg->Process(*this);
@@ -108,6 +117,22 @@ void ProtocolOhBase::RequestResend(const Brx& aFrames)
     }
 }
 
+void ProtocolOhBase::SendLatency(TUint aLatencyMs, TUint aJitterUs)
+{
+    Bws<OhmHeader::kHeaderBytes + OhmHeaderLatency::kHeaderBytes> buffer;
+    WriterBuffer writer(buffer);
+    OhmHeaderLatency headerLatency(aLatencyMs, aJitterUs);
+    OhmHeader header(OhmHeader::kMsgTypeLatency, headerLatency.MsgBytes());
+    header.Externalise(writer);
+    headerLatency.Externalise(writer);
+    try {
+        iSocket.Send(buffer, iEndpoint);
+    }
+    catch (NetworkError&) {
+        LOG_ERROR(kSongcast, "NetworkError in ProtocolOhBase::SendLatency()\n");
+    }
+}
+
 void ProtocolOhBase::SendJoin()
 {
     LOG(kSongcast, "SendJoin\n");
@@ -205,6 +230,8 @@ ProtocolStreamResult ProtocolOhBase::Stream(const Brx& aUri)
     iBitDepth = iSampleRate = iNumChannels = 0;
     iLatency = 0;
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
+    iJitter.Reset();
+    iLastLatencyReportUs = 0;
     iMutexTransport.Signal();
 
     return res;
@@ -502,9 +529,27 @@ void ProtocolOhBase::OutputAudio(OhmMsgAudio& aMsg)
     }
 }
 
+void ProtocolOhBase::UpdateJitter(const OhmMsgAudio& aMsg)
+{
+    const TUint64 rxTimeUs = iSocket.RxTimeUs();
+    iJitter.Add(rxTimeUs, aMsg.SampleStart(), aMsg.SampleRate());
+    if (!iJitter.HasEstimate() || rxTimeUs - iLastLatencyReportUs < kLatencyReportIntervalMs * 1000ULL) {
+        return;
+    }
+    iLastLatencyReportUs = rxTimeUs;
+    const TUint latencyMs = iJitter.RecommendedLatencyMs();
+    const TUint jitterUs = iJitter.JitterUs();
+    LOG(kSongcast, "ProtocolOhBase: jitter=%uus, maxExcess=%uus, recommending latency of %ums\n",
+                   jitterUs, iJitter.MaxExcessUs(), latencyMs);
+    SendLatency(latencyMs, jitterUs);
+}
+
 void ProtocolOhBase::Process(OhmMsgAudio& aMsg)
 {
     AddRxTimestamp(aMsg);
+    if (iAdaptiveLatency.load() && !aMsg.Resent()) {
+        UpdateJitter(aMsg);
+    }
 
     TBool outputAudio = false;
     {
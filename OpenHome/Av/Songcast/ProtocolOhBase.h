@@ -10,9 +10,11 @@
 #include <OpenHome/Av/Songcast/OhmMsg.h>
 #include <OpenHome/Av/Songcast/OhmSocket.h>
 #include <OpenHome/Av/Songcast/OhmTimestamp.h>
+#include <OpenHome/Av/Songcast/OhmJitter.h>
 #include <OpenHome/Private/Stream.h>
 #include <OpenHome/Media/Supply.h>
 
+#include <atomic>
 #include <vector>
 
 EXCEPTION(OhmDiscontinuity);
@@ -30,10 +32,19 @@ class ProtocolOhBase : public Media::Protocol, private IOhmMsgProcessor
     static const TUint kSubsequentRepairTimeoutMs = 30;
     static const TUint kTimerJoinTimeoutMs = 300;
     static const TUint kTtl = 2;
+    static const TUint kRxQueueDatagrams = 64;
+    static const TUint kAdaptiveLatencyMinMs = 20;
+    static const TUint kAdaptiveLatencyMaxMs = 1000;
+    static const TUint kLatencyReportIntervalMs = 1000;
+public:
+    /*
+     * Measure network jitter and periodically report a recommended latency to the sender.
+     */
+    void SetAdaptiveLatency(TBool aEnable);
 protected:
     ProtocolOhBase(Environment& aEnv, IOhmMsgFactory& aFactory, Media::TrackFactory& aTrackFactory,
                    Optional<IOhmTimestamper> aTimestamper, const TChar* aSupportedScheme, const Brx& aMode,
-                   Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                   TUint aRxThreadPriority, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
     ~ProtocolOhBase();
     void Add(OhmMsg* aMsg);
     void ResendSeen();
@@ -62,6 +73,8 @@ private:
     TBool RepairBegin(OhmMsgAudio& aMsg);
     TBool Repair(OhmMsgAudio& aMsg);
     void OutputAudio(OhmMsgAudio& aMsg);
+    void UpdateJitter(const OhmMsgAudio& aMsg);
+    void SendLatency(TUint aLatencyMs, TUint aJitterUs);
 private: // from IOhmMsgProcessor
     void Process(OhmMsgAudio& aMsg) override;
     void Process(OhmMsgTrack& aMsg) override;
@@ -111,6 +124,9 @@ private:
     Media::BwsTrackMetaData iTrackMetadata;
     Semaphore iPipelineEmpty;
     Optional<Av::IOhmMsgProcessor> iOhmMsgProcessor;
+    std::atomic<TBool> iAdaptiveLatency;
+    OhmJitterEstimator iJitter;
+    TUint64 iLastLatencyReportUs;
 };
 
 } // namespace Av
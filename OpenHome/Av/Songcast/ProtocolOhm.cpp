@@ -50,8 +50,8 @@ using namespace OpenHome::Media;
 
 ProtocolOhm::ProtocolOhm(Environment& aEnv, IOhmMsgFactory& aMsgFactory, TrackFactory& aTrackFactory,
                          Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                         Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
-    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohm", aMode, aOhmMsgProcessor)
+                         TUint aRxThreadPriority, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor)
+    : ProtocolOhBase(aEnv, aMsgFactory, aTrackFactory, aTimestamper, "ohm", aMode, aRxThreadPriority, aOhmMsgProcessor)
     , iStoppedLock("POHM")
     , iSemSenderUnicastOverride("POM2", 0)
     , iSenderUnicastOverrideEnabled(false)
@@ -131,6 +131,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                     case OhmHeader::kMsgTypeJoin:
                     case OhmHeader::kMsgTypeListen:
                     case OhmHeader::kMsgTypeLeave:
+                    case OhmHeader::kMsgTypeLatency:
                     case OhmHeader::kMsgTypeSlave:
                         break;
                     case OhmHeader::kMsgTypeAudio:
@@ -184,6 +185,7 @@ ProtocolStreamResult ProtocolOhm::Play(TIpAddress aInterface, TUint aTtl, const
                     {
                     case OhmHeader::kMsgTypeJoin:
                     case OhmHeader::kMsgTypeLeave:
+                    case OhmHeader::kMsgTypeLatency:
                     case OhmHeader::kMsgTypeSlave:
                         break;
                     case OhmHeader::kMsgTypeListen:
@@ -29,7 +29,7 @@ class ProtocolOhm : public ProtocolOhBase, public IUnicastOverrideObserver
 public:
     ProtocolOhm(Environment& aEnv, IOhmMsgFactory& aMsgFactory, Media::TrackFactory& aTrackFactory,
                 Optional<IOhmTimestamper> aTimestamper, const Brx& aMode,
-                Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
+                TUint aRxThreadPriority, Optional<Av::IOhmMsgProcessor> aOhmMsgProcessor);
 private: // from IUnicastOverrideObserver
     void UnicastOverrideEnabled() override;
     void UnicastOverrideDisabled() override;
@@ -42,7 +42,8 @@ Sender::Sender(Environment& aEnv,
                const Brx& aName,
                TUint aMinLatencyMs,
                const Brx& aSongcastMode,
-               IUnicastOverrideObserver& aUnicastOverrideObserver)
+               IUnicastOverrideObserver& aUnicastOverrideObserver,
+               Media::ISenderActivityObserver& aActivityObserver)
     : iAudioBuf(nullptr)
     , iSampleRate(0)
     , iMinLatencyMs(aMinLatencyMs)
@@ -54,7 +55,7 @@ Sender::Sender(Environment& aEnv,
     , iFirstChannelIndex(0)
 {
     const TInt defaultChannel = (TInt)aEnv.Random(kChannelMax, kChannelMin);
-    iOhmSenderDriver = new OhmSenderDriver(aEnv, aTimestamper);
+    iOhmSenderDriver = new OhmSenderDriver(aEnv, aTimestamper, aActivityObserver);
     // create sender with default configuration.  CongfigVals below will each call back on construction, allowing these to be updated
     iOhmSender = new OhmSender(aEnv, aDevice, *iOhmSenderDriver, aZoneHandler, aThreadPriority,
                                aName, defaultChannel, aMinLatencyMs, false/*unicast*/);
@@ -45,7 +45,8 @@ public:
            const Brx& aName,
            TUint aMinLatencyMs,
            const Brx& aSongcastMode,
-           IUnicastOverrideObserver& aUnicastOverrideObserver);
+           IUnicastOverrideObserver& aUnicastOverrideObserver,
+           Media::ISenderActivityObserver& aActivityObserver);
     ~Sender();
     void SetName(const Brx& aName);
     void SetImageUri(const Brx& aUri);
@@ -15,13 +15,10 @@ const TUint SenderThread::kMaxMsgBacklog = 100;
 SenderThread::SenderThread(IPipelineElementDownstream& aDownstream,
                            TUint aThreadPriority)
     : iDownstream(aDownstream)
-    , iLock("SCST")
-    , iFifo(kMaxMsgBacklog)
-    , iFifoSlotsUsed(0)
+    , iQueue(kMaxMsgBacklog, MsgQueueSpsc::EOverflow::Block)
     , iShutdownSem("SGSN", 0)
     , iQuit(false)
 {
-    ASSERT(iFifoSlotsUsed.is_lock_free());
     iThread = new ThreadFunctor("SongcastSender", MakeFunctor(*this, &SenderThread::Run), aThreadPriority);
     iThread->Start();
 }
@@ -34,23 +31,18 @@ SenderThread::~SenderThread()
 
 void SenderThread::Push(Msg* aMsg)
 {
-    AutoMutex _(iLock);
-    ASSERT(iFifoSlotsUsed < kMaxMsgBacklog);
-    iFifo.Write(aMsg);
-    iFifoSlotsUsed++;
-    iThread->Signal();
+    iQueue.Enqueue(aMsg);
 }
 
 void SenderThread::Run()
 {
+    Msg* msgs[kMaxMsgBatch];
     do {
-        iThread->Wait();
-        iLock.Wait();
-        auto msg = iFifo.Read();
-        iFifoSlotsUsed--;
-        iLock.Signal();
-        msg = msg->Process(*this);
-        iDownstream.Push(msg);
+        const TUint count = iQueue.DequeueBatch(msgs, kMaxMsgBatch);
+        for (TUint i=0; i<count; i++) {
+            auto msg = msgs[i]->Process(*this);
+            iDownstream.Push(msg);
+        }
     } while (!iQuit);
     iShutdownSem.Signal();
 }
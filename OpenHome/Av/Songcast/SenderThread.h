@@ -2,11 +2,8 @@
 
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Types.h>
-#include <OpenHome/Private/Fifo.h>
 #include <OpenHome/Private/Standard.h>
 
-#include <atomic>
-
 namespace OpenHome {
     class ThreadFunctor;
 namespace Av {
@@ -15,7 +12,8 @@ class SenderThread : public Media::IPipelineElementDownstream
                    , private Media::IMsgProcessor
                    , private INonCopyable
 {
-    static const TUint kMaxMsgBacklog; // asserts if ever exceeded
+    static const TUint kMaxMsgBacklog; // Push() blocks if this is ever exceeded
+    static const TUint kMaxMsgBatch = 16;
 public:
     SenderThread(Media::IPipelineElementDownstream& aDownstream,
                  TUint aThreadPriority);
@@ -45,9 +43,7 @@ private: // from Media::IMsgProcessor
 private:
     Media::IPipelineElementDownstream& iDownstream;
     ThreadFunctor* iThread;
-    Mutex iLock;
-    FifoLiteDynamic<Media::Msg*> iFifo;
-    std::atomic<TUint> iFifoSlotsUsed;
+    Media::MsgQueueSpsc iQueue;
     Semaphore iShutdownSem;
     TBool iQuit;
 };
@@ -21,12 +21,15 @@
 #include <OpenHome/Av/Songcast/Sender.h>
 #include <OpenHome/Av/Product.h>
 #include <OpenHome/Configuration/ConfigManager.h>
+#include <OpenHome/Av/StringIds.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Av/Debug.h>
 #include <OpenHome/PowerManager.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/NetworkAdapterList.h>
 
+#include <vector>
+
 namespace OpenHome {
 namespace Media {
     class PipelineManager;
@@ -49,6 +52,7 @@ class SongcastSender;
 class SourceReceiver : public Source, private ISourceReceiver, private IZoneListener, private Media::IPipelineObserver
 {
     static const TChar* kProtocolInfo;
+    static const Brn kConfigIdAdaptiveLatency;
 public:
     SourceReceiver(IMediaPlayer& aMediaPlayer,
                    Optional<Media::IClockPuller> aClockPuller,
@@ -81,6 +85,7 @@ private:
     void UriChanged();
     void ZoneChangeThread();
     void CurrentAdapterChanged();
+    void ConfigAdaptiveLatencyChanged(Configuration::KeyValuePair<TUint>& aStringId);
 private:
     Mutex iLock;
     Mutex iActivationLock;
@@ -91,6 +96,10 @@ private:
     ProviderReceiver* iProviderReceiver;
     UriProviderSongcast* iUriProvider;
     OhmMsgFactory* iOhmMsgFactory;
+    ProtocolOhm* iProtocolOhm;
+    ProtocolOhu* iProtocolOhu;
+    Configuration::ConfigChoice* iConfigAdaptiveLatency;
+    TUint iListenerIdAdaptiveLatency;
     Uri iUri; // allocated here as stack requirements are too high for an automatic variable
     Bws<ZoneHandler::kMaxZoneBytes> iZone;
     Media::BwsTrackUri iTrackUri;
@@ -185,6 +194,7 @@ ModeClockPullers UriProviderSongcast::ClockPullers()
 // SourceReceiver
 
 const TChar* SourceReceiver::kProtocolInfo = "ohz:*:*:*,ohm:*:*:*,ohu:*.*.*";
+const Brn SourceReceiver::kConfigIdAdaptiveLatency("Receiver.AdaptiveLatency");
 
 SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
                                Optional<Media::IClockPuller> aClockPuller,
@@ -214,9 +224,22 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
     iPipeline.Add(iUriProvider);
     iOhmMsgFactory = new OhmMsgFactory(210, 10, 10);
     TrackFactory& trackFactory = aMediaPlayer.TrackFactory();
-    auto protocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver);
-    iPipeline.Add(protocolOhm);
-    iPipeline.Add(new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), aOhmMsgObserver));
+    TUint priorityFiller = 0;
+    TUint priorityFlywheelRamper = 0;
+    TUint priorityStarvationRamper = 0;
+    TUint priorityCodec = 0;
+    TUint priorityEvent = 0;
+    iPipeline.GetThreadPriorities(priorityFiller, priorityFlywheelRamper, priorityStarvationRamper, priorityCodec, priorityEvent);
+    const TUint rxThreadPriority = priorityFiller + 1; // drain socket ahead of the protocol (which runs in Filler)
+    iProtocolOhm = new ProtocolOhm(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), rxThreadPriority, aOhmMsgObserver);
+    iPipeline.Add(iProtocolOhm);
+    iProtocolOhu = new ProtocolOhu(env, *iOhmMsgFactory, trackFactory, aRxTimestamper, iUriProvider->Mode(), rxThreadPriority, aOhmMsgObserver);
+    iPipeline.Add(iProtocolOhu);
+    std::vector<TUint> choices;
+    choices.push_back(eStringIdNo);
+    choices.push_back(eStringIdYes);
+    iConfigAdaptiveLatency = new ConfigChoice(aMediaPlayer.ConfigInitialiser(), kConfigIdAdaptiveLatency, choices, eStringIdNo);
+    iListenerIdAdaptiveLatency = iConfigAdaptiveLatency->Subscribe(MakeFunctorConfigChoice(*this, &SourceReceiver::ConfigAdaptiveLatencyChanged));
     iStoreZone = new StoreText(aMediaPlayer.ReadWriteStore(), aMediaPlayer.PowerManager(), kPowerPriorityNormal,
                                Brn("Receiver.Zone"), Brx::Empty(), iZone.MaxBytes());
     iStoreZone->Get(iZone);
@@ -225,12 +248,14 @@ SourceReceiver::SourceReceiver(IMediaPlayer& aMediaPlayer,
     iNacnId = iEnv.NetworkAdapterList().AddCurrentChangeListener(MakeFunctor(*this, &SourceReceiver::CurrentAdapterChanged), "SourceReceiver", false);
 
     // Sender
-    iSender = new SongcastSender(aMediaPlayer, *iZoneHandler, aTxTimestamper, iUriProvider->Mode(), *protocolOhm);
+    iSender = new SongcastSender(aMediaPlayer, *iZoneHandler, aTxTimestamper, iUriProvider->Mode(), *iProtocolOhm);
 }
 
 SourceReceiver::~SourceReceiver()
 {
     delete iSender;
+    iConfigAdaptiveLatency->Unsubscribe(iListenerIdAdaptiveLatency);
+    delete iConfigAdaptiveLatency;
     iEnv.NetworkAdapterList().RemoveCurrentChangeListener(iNacnId);
     delete iStoreZone;
     delete iOhmMsgFactory;
@@ -475,6 +500,13 @@ void SourceReceiver::CurrentAdapterChanged()
     }
 }
 
+void SourceReceiver::ConfigAdaptiveLatencyChanged(KeyValuePair<TUint>& aStringId)
+{
+    const TBool enabled = (aStringId.Value() == eStringIdYes);
+    iProtocolOhm->SetAdaptiveLatency(enabled);
+    iProtocolOhu->SetAdaptiveLatency(enabled);
+}
+
 
 // SongcastSender
 
@@ -495,7 +527,7 @@ SongcastSender::SongcastSender(IMediaPlayer& aMediaPlayer, ZoneHandler& aZoneHan
     iSender = new Sender(aMediaPlayer.Env(), aMediaPlayer.Device(), aZoneHandler,
                          aTxTimestamper, aMediaPlayer.ConfigInitialiser(), senderThreadPriority,
                          Brx::Empty(), pipeline.SenderMinLatencyMs(), aMode,
-                         aUnicastOverrideObserver);
+                         aUnicastOverrideObserver, pipeline.SenderActivityObserver());
     iLoggerSender = new Logger("Sender", *iSender);
     //iLoggerSender->SetEnabled(true);
     //iLoggerSender->SetFilter(Logger::EMsgAll);
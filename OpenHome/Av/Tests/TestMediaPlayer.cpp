@@ -6,6 +6,7 @@
 #include <OpenHome/Net/Core/DvDevice.h>
 #include <OpenHome/Media/PipelineManager.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Media/Utils/ClockPullerOccupancy.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/TestFramework.h>
 #include <OpenHome/Media/Codec/CodecFactory.h>
@@ -134,6 +135,7 @@ TestMediaPlayer::TestMediaPlayer(Net::DvStack& aDvStack, const Brx& aUdn, const
                                  const TChar* aStoreFile, TUint aOdpPort,
                                  TUint aMinWebUiResourceThreads, TUint aMaxWebUiTabs, TUint aUiSendQueueSize)
     : iPullableClock(nullptr)
+    , iClockPuller(nullptr)
     , iSemShutdown("TMPS", 0)
     , iDisabled("test", 0)
     , iTuneInPartnerId(aTuneInPartnerId)
@@ -144,6 +146,9 @@ TestMediaPlayer::TestMediaPlayer(Net::DvStack& aDvStack, const Brx& aUdn, const
     , iRxTimestamper(nullptr)
     , iStoreFileWriter(nullptr)
     , iOdpPort(aOdpPort)
+#ifdef __linux__
+    , iOdpEpoll(false)
+#endif
     , iMinWebUiResourceThreads(aMinWebUiResourceThreads)
     , iMaxWebUiTabs(aMaxWebUiTabs)
     , iUiSendQueueSize(aUiSendQueueSize)
@@ -249,6 +254,7 @@ TestMediaPlayer::~TestMediaPlayer()
     delete iFnManagerUpnpAv;
     ASSERT(!iDevice->Enabled());
     delete iMediaPlayer;
+    delete iClockPuller;
     delete iPipelineObserver;
     delete iInfoLogger;
     delete iDevice;
@@ -273,6 +279,13 @@ void TestMediaPlayer::SetSongcastTimestampers(IOhmTimestamper& aTxTimestamper, I
     iRxTimestamper = &aRxTimestamper;
 }
 
+#ifdef __linux__
+void TestMediaPlayer::SetOdpEpoll()
+{
+    iOdpEpoll = true;
+}
+#endif
+
 void TestMediaPlayer::StopPipeline()
 {
     TUint waitCount = 0;
@@ -300,8 +313,18 @@ void TestMediaPlayer::Run()
     RegisterPlugins(iMediaPlayer->Env());
     AddConfigApp();
 
-    iServerOdp.reset(new DviServerOdp(iMediaPlayer->DvStack(), kNumOdpSessions, iOdpPort));
-    Log::Print("ODP server running on port %u\n", iServerOdp->Port()); // don't use iOdpPort here - if it is 0, iServerOdp->Port() tells us the host assigned port
+    // don't use iOdpPort when reporting the port - if it is 0, Port() tells us the host assigned port
+#ifdef __linux__
+    if (iOdpEpoll) {
+        iServerOdpEpoll.reset(new DviServerOdpEpoll(iMediaPlayer->DvStack(), kNumOdpEpollWorkers, kMaxOdpEpollSessions, iOdpPort));
+        Log::Print("ODP (epoll) server running on port %u\n", iServerOdpEpoll->Port());
+    }
+    else
+#endif
+    {
+        iServerOdp.reset(new DviServerOdp(iMediaPlayer->DvStack(), kNumOdpSessions, iOdpPort));
+        Log::Print("ODP server running on port %u\n", iServerOdp->Port());
+    }
 
     InitialiseLogger();
     iMediaPlayer->Start(iRebootHandler);
@@ -441,10 +464,14 @@ void TestMediaPlayer::RegisterPlugins(Environment& aEnv)
     TUint priorityEvent = 0;
     iMediaPlayer->Pipeline().GetThreadPriorities(priorityFiller, priorityFlywheelRamper, priorityStarvationRamper, priorityCodec, priorityEvent);
     const TUint raopServerPriority = priorityFiller;
-    iMediaPlayer->Add(SourceFactory::NewRaop(*iMediaPlayer, Optional<IClockPuller>(nullptr), macAddr, raopServerPriority));
+    // RAOP and Songcast senders run on their own clocks; only one can be active at a time so they share a puller
+    if (iPullableClock != nullptr) {
+        iClockPuller = new ClockPullerOccupancy(*iPullableClock);
+    }
+    iMediaPlayer->Add(SourceFactory::NewRaop(*iMediaPlayer, Optional<IClockPuller>(iClockPuller), macAddr, raopServerPriority));
 
     iMediaPlayer->Add(SourceFactory::NewReceiver(*iMediaPlayer,
-                                                 Optional<IClockPuller>(nullptr),
+                                                 Optional<IClockPuller>(iClockPuller),
                                                  Optional<IOhmTimestamper>(iTxTimestamper),
                                                  Optional<IOhmTimestamper>(iRxTimestamper),
                                                  Optional<IOhmMsgProcessor>()));
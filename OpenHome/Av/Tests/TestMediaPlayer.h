@@ -27,6 +27,9 @@
 #include <OpenHome/Web/WebAppFramework.h>
 #include <OpenHome/Av/RebootHandler.h>
 #include <OpenHome/Net/Odp/DviServerOdp.h>
+#ifdef __linux__
+# include <OpenHome/Net/Odp/DviServerOdpEpoll.h>
+#endif
 
 #include <memory>
 
@@ -41,6 +44,7 @@ namespace Media {
     class PipelineManager;
     class DriverSongcastSender;
     class IPullableClock;
+    class ClockPullerOccupancy;
     class AllocatorInfoLogger;
 }
 namespace Configuration {
@@ -105,6 +109,8 @@ private:
     static const Brn kSongcastSenderIconFileName;
     static const TUint kTrackCount = 1200;
     static const TUint kNumOdpSessions = 4;
+    static const TUint kNumOdpEpollWorkers = 2;
+    static const TUint kMaxOdpEpollSessions = 64;
     static const TUint kMinWebUiResourceThreads = 4;
     static const TUint kMaxWebUiTabs = 4;
     static const TUint kUiSendQueueSize = 100;
@@ -116,6 +122,9 @@ public:
     virtual ~TestMediaPlayer();
     void SetPullableClock(Media::IPullableClock& aPullableClock);
     void SetSongcastTimestampers(IOhmTimestamper& aTxTimestamper, IOhmTimestamper& aRxTimestamper);
+#ifdef __linux__
+    void SetOdpEpoll(); // serve ODP from DviServerOdpEpoll rather than DviServerOdp.  Must be called before Run()
+#endif
     void StopPipeline();
     void AddAttribute(const TChar* aAttribute); // FIXME - only required by Songcasting driver
     virtual void Run();
@@ -151,6 +160,7 @@ protected:
     Web::WebAppFramework* iAppFramework;    // FIXME - add getter to IMediaPlayer and make private
     RebootLogger iRebootHandler;
     Media::IPullableClock* iPullableClock;
+    Media::ClockPullerOccupancy* iClockPuller;
     Media::AllocatorInfoLogger* iInfoLogger;
     Net::DvDeviceStandard* iDevice;
     Net::DvDevice* iDeviceUpnpAv;
@@ -175,6 +185,10 @@ private:
     Configuration::StoreFileWriterJson* iStoreFileWriter;
     TUint iOdpPort;
     std::unique_ptr<OpenHome::Net::DviServerOdp> iServerOdp;
+#ifdef __linux__
+    TBool iOdpEpoll;
+    std::unique_ptr<OpenHome::Net::DviServerOdpEpoll> iServerOdpEpoll;
+#endif
     TUint iMinWebUiResourceThreads;
     TUint iMaxWebUiTabs;
     TUint iUiSendQueueSize;
@@ -197,8 +211,11 @@ public:
     const TestFramework::OptionString& Qobuz() const;
     const TestFramework::OptionString& UserAgent() const;
     const TestFramework::OptionBool& ClockPull() const;
+    const TestFramework::OptionUint& AnimatorPeriod() const;
+    const TestFramework::OptionBool& PreciseTiming() const;
     const TestFramework::OptionString& StoreFile() const;
     const TestFramework::OptionUint& OptionOdp() const;
+    const TestFramework::OptionBool& OptionOdpEpoll() const;
 private:
     TestFramework::OptionParser iParser;
     TestFramework::OptionString iOptionRoom;
@@ -212,8 +229,11 @@ private:
     TestFramework::OptionString iOptionQobuz;
     TestFramework::OptionString iOptionUserAgent;
     TestFramework::OptionBool iOptionClockPull;
+    TestFramework::OptionUint iOptionAnimatorPeriod;
+    TestFramework::OptionBool iOptionPreciseTiming;
     TestFramework::OptionString iOptionStoreFile;
     TestFramework::OptionUint iOptionOdp;
+    TestFramework::OptionBool iOptionOdpEpoll;
 };
 
 // Not very nice, but only to allow reusable test functions.
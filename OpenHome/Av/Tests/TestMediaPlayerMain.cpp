@@ -73,10 +73,26 @@ void TestMediaPlayerThread::RunInThread()
     TestMediaPlayer* tmp = new TestMediaPlayer(*dvStack, udn, iOptions.Room().CString(), iOptions.Name().CString(),
         iOptions.TuneIn().Value(), iOptions.Tidal().Value(), iOptions.Qobuz().Value(),
         iOptions.UserAgent().Value(), iOptions.StoreFile().CString(), iOptions.OptionOdp().Value());
-    Media::AnimatorBasic* animator = new Media::AnimatorBasic(dvStack->Env(), tmp->Pipeline(), iOptions.ClockPull().Value());
+    const Media::AnimatorBasic::EPacing pacing = (iOptions.PreciseTiming().Value()? Media::AnimatorBasic::ePacingPrecise
+                                                                                  : Media::AnimatorBasic::ePacingCoarse);
+    Media::AnimatorBasic* animator = new Media::AnimatorBasic(dvStack->Env(), tmp->Pipeline(), iOptions.ClockPull().Value(),
+                                                              iOptions.AnimatorPeriod().Value(), pacing);
     tmp->SetPullableClock(*animator);
+    if (iOptions.OptionOdpEpoll().Value()) {
+#ifdef __linux__
+        tmp->SetOdpEpoll();
+#else
+        Log::Print("--odp-epoll is only supported on Linux; using default ODP server\n");
+#endif
+    }
     tmp->Run();
     tmp->StopPipeline();
+    if (iOptions.PreciseTiming().Value()) {
+        Media::AnimatorBasic::JitterStats stats;
+        animator->GetJitterStats(stats);
+        Log::Print("Animator jitter over %llu wakeups: min=%lluus, mean=%lluus, max=%lluus, stddev=%lluus, dropouts=%u\n",
+                   stats.iWakeups, stats.iLateMinUs, stats.iLateMeanUs, stats.iLateMaxUs, stats.iLateStdDevUs, stats.iDropouts);
+    }
     delete animator;
     delete tmp;
 }
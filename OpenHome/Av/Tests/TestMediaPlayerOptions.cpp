@@ -2,6 +2,8 @@
 #include <OpenHome/Private/OptionParser.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Media/Utils/AnimatorBasic.h>
 
 using namespace OpenHome;
 using namespace OpenHome::TestFramework;
@@ -19,8 +21,11 @@ TestMediaPlayerOptions::TestMediaPlayerOptions()
     , iOptionQobuz("", "--qobuz", Brn(""), "app_id:app_secret")
     , iOptionUserAgent("", "--useragent", Brn(""), "User Agent (for HTTP requests)")
     , iOptionClockPull("", "--clockpull", "Enable clock pulling")
+    , iOptionAnimatorPeriod("", "--animator-period", 5, "[1..20] ms between animator wakeups")
+    , iOptionPreciseTiming("", "--precise-timing", "Pace animator against absolute deadlines, reporting jitter on exit")
     , iOptionStoreFile("", "--storefile", Brn(""), "File for reading/writing persistent store")
     , iOptionOdp("", "--odp", 0, "Port for ODP server")
+    , iOptionOdpEpoll("", "--odp-epoll", "Serve ODP from a single epoll thread plus worker pool (Linux only)")
 {
     iParser.AddOption(&iOptionRoom);
     iParser.AddOption(&iOptionName);
@@ -33,8 +38,11 @@ TestMediaPlayerOptions::TestMediaPlayerOptions()
     iParser.AddOption(&iOptionQobuz);
     iParser.AddOption(&iOptionUserAgent);
     iParser.AddOption(&iOptionClockPull);
+    iParser.AddOption(&iOptionAnimatorPeriod);
+    iParser.AddOption(&iOptionPreciseTiming);
     iParser.AddOption(&iOptionStoreFile);
     iParser.AddOption(&iOptionOdp);
+    iParser.AddOption(&iOptionOdpEpoll);
 }
 
 void TestMediaPlayerOptions::AddOption(Option* aOption)
@@ -44,7 +52,16 @@ void TestMediaPlayerOptions::AddOption(Option* aOption)
 
 TBool TestMediaPlayerOptions::Parse(int aArgc, char* aArgv[])
 {
-    return iParser.Parse(aArgc, aArgv);
+    if (!iParser.Parse(aArgc, aArgv)) {
+        return false;
+    }
+    const TUint periodMs = iOptionAnimatorPeriod.Value();
+    if (periodMs < Media::AnimatorBasic::kPeriodMsMin || periodMs > Media::AnimatorBasic::kPeriodMsMax) {
+        Log::Print("--animator-period must be in the range [%u..%u]\n",
+                   Media::AnimatorBasic::kPeriodMsMin, Media::AnimatorBasic::kPeriodMsMax);
+        return false;
+    }
+    return true;
 }
 
 const OptionString& TestMediaPlayerOptions::Room() const
@@ -102,6 +119,16 @@ const OptionBool& TestMediaPlayerOptions::ClockPull() const
     return iOptionClockPull;
 }
 
+const OptionUint& TestMediaPlayerOptions::AnimatorPeriod() const
+{
+    return iOptionAnimatorPeriod;
+}
+
+const OptionBool& TestMediaPlayerOptions::PreciseTiming() const
+{
+    return iOptionPreciseTiming;
+}
+
 const OptionString& TestMediaPlayerOptions::StoreFile() const
 {
     return iOptionStoreFile;
@@ -111,3 +138,8 @@ const OptionUint& TestMediaPlayerOptions::OptionOdp() const
 {
     return iOptionOdp;
 }
+
+const OptionBool& TestMediaPlayerOptions::OptionOdpEpoll() const
+{
+    return iOptionOdpEpoll;
+}
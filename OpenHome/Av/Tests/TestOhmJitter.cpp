@@ -0,0 +1,562 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Songcast/OhmJitter.h>
+#include <OpenHome/Av/Songcast/OhmSocket.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/NetworkAdapterList.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Functor.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+using namespace OpenHome::TestFramework;
+
+namespace OpenHome {
+namespace Av {
+namespace TestOhmJitter {
+
+class SuiteOhmJitterEstimator : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kSampleRate = 48000;
+    static const TUint kSamplesPerFrame = 240; // 5ms
+    static const TUint kFrameUs = 5000;
+    static const TUint kMinLatencyMs = 20;
+    static const TUint kMaxLatencyMs = 1000;
+    static const TUint64 kBaseUs = 1000000000;
+public:
+    SuiteOhmJitterEstimator();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void AddFrame(TUint aFrame, TUint aDelayUs);
+    void AddFrames(TUint aFirst, TUint aCount, TUint aDelayUs);
+    TUint NextRandom();
+    TUint LinkDelayUs(TBool& aLost);
+    void TestNoJitterRecommendsMinimum();
+    void TestConstantDelayIgnored();
+    void TestLateFrameCovered();
+    void TestJitterMeasured();
+    void TestResetOnNewStream();
+    void TestResetOnPause();
+    void TestOldPeaksExpire();
+    void TestClampedToMax();
+    void TestLossyLinkFewerLateFrames();
+private:
+    OhmJitterEstimator* iEstimator;
+    TUint iRandom;
+};
+
+class SuiteOhmLatencySelector : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxLatencyMs = 1000;
+    static const TUint64 kBaseUs = 1000000000;
+    static const TUint kReportIntervalMs = 1000;
+public:
+    SuiteOhmLatencySelector();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TBool Report(TUint aMs, TUint aLatencyMs);
+    TUint ReportFor(TUint aStartMs, TUint aDurationMs, TUint aLatencyMs);
+    void TestFirstReportApplied();
+    void TestIncreaseApplied();
+    void TestIncreaseRateLimited();
+    void TestWobbleIgnored();
+    void TestSustainedDecreaseApplied();
+    void TestBriefDecreaseIgnored();
+    void TestHighestReceiverWins();
+    void TestClampedToMax();
+    void TestReportsExpire();
+private:
+    OhmLatencySelector* iSelector;
+};
+
+class SuiteOhmReceiveQueue : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxDatagrams = 4;
+    static const TUint kMaxDatagramBytes = 64;
+public:
+    SuiteOhmReceiveQueue(Environment& aEnv, TIpAddress aInterface);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Send(TUint aIndex);
+    void WaitForQueue();
+    void TestQueuedInOrder();
+    void TestOverflowDropped();
+    void TestInterrupt();
+private:
+    Environment& iEnv;
+    const TIpAddress iInterface;
+    SocketUdp* iSender;
+    SocketUdp* iReceiver;
+    OhmReceiveQueue* iQueue;
+    Bws<kMaxDatagramBytes> iBuf;
+};
+
+} // namespace TestOhmJitter
+} // namespace Av
+} // namespace OpenHome
+
+using namespace OpenHome::Av::TestOhmJitter;
+
+
+// SuiteOhmJitterEstimator
+
+SuiteOhmJitterEstimator::SuiteOhmJitterEstimator()
+    : SuiteUnitTest("OhmJitterEstimator")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestNoJitterRecommendsMinimum), "TestNoJitterRecommendsMinimum");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestConstantDelayIgnored), "TestConstantDelayIgnored");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestLateFrameCovered), "TestLateFrameCovered");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestJitterMeasured), "TestJitterMeasured");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestResetOnNewStream), "TestResetOnNewStream");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestResetOnPause), "TestResetOnPause");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestOldPeaksExpire), "TestOldPeaksExpire");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestClampedToMax), "TestClampedToMax");
+    AddTest(MakeFunctor(*this, &SuiteOhmJitterEstimator::TestLossyLinkFewerLateFrames), "TestLossyLinkFewerLateFrames");
+}
+
+void SuiteOhmJitterEstimator::Setup()
+{
+    iEstimator = new OhmJitterEstimator(kMinLatencyMs, kMaxLatencyMs);
+    iRandom = 12345;
+}
+
+void SuiteOhmJitterEstimator::TearDown()
+{
+    delete iEstimator;
+}
+
+void SuiteOhmJitterEstimator::AddFrame(TUint aFrame, TUint aDelayUs)
+{
+    const TUint64 rxTimeUs = kBaseUs + (TUint64)aFrame * kFrameUs + aDelayUs;
+    iEstimator->Add(rxTimeUs, (TUint64)aFrame * kSamplesPerFrame, kSampleRate);
+}
+
+void SuiteOhmJitterEstimator::AddFrames(TUint aFirst, TUint aCount, TUint aDelayUs)
+{
+    for (TUint i=aFirst; i<aFirst+aCount; i++) {
+        AddFrame(i, aDelayUs);
+    }
+}
+
+TUint SuiteOhmJitterEstimator::NextRandom()
+{
+    // deterministic LCG so that results are repeatable
+    iRandom = iRandom * 1103515245 + 12345;
+    return (iRandom >> 16) & 0x7fff;
+}
+
+TUint SuiteOhmJitterEstimator::LinkDelayUs(TBool& aLost)
+{
+    // ~1% loss; most frames delayed by 0-3ms with ~2% delayed by 30-60ms
+    aLost = (NextRandom() % 100 == 0);
+    if (NextRandom() % 50 == 0) {
+        return 30000 + (NextRandom() % 30001);
+    }
+    return NextRandom() % 3001;
+}
+
+void SuiteOhmJitterEstimator::TestNoJitterRecommendsMinimum()
+{
+    TEST(!iEstimator->HasEstimate());
+    AddFrames(0, OhmJitterEstimator::kMinFramesForEstimate - 1, 0);
+    TEST(!iEstimator->HasEstimate());
+    AddFrame(OhmJitterEstimator::kMinFramesForEstimate - 1, 0);
+    TEST(iEstimator->HasEstimate());
+    TEST(iEstimator->JitterUs() == 0);
+    TEST(iEstimator->MaxExcessUs() == 0);
+    TEST(iEstimator->RecommendedLatencyMs() == kMinLatencyMs);
+}
+
+void SuiteOhmJitterEstimator::TestConstantDelayIgnored()
+{
+    AddFrames(0, 200, 7000);
+    TEST(iEstimator->JitterUs() == 0);
+    TEST(iEstimator->MaxExcessUs() == 0);
+    TEST(iEstimator->RecommendedLatencyMs() == kMinLatencyMs);
+}
+
+void SuiteOhmJitterEstimator::TestLateFrameCovered()
+{
+    AddFrames(0, 150, 0);
+    AddFrame(150, 35000);
+    AddFrames(151, 49, 0);
+    TEST(iEstimator->MaxExcessUs() == 35000);
+    // 35ms + 10ms margin, rounded up to 10ms granularity
+    TEST(iEstimator->RecommendedLatencyMs() == 50);
+}
+
+void SuiteOhmJitterEstimator::TestJitterMeasured()
+{
+    for (TUint i=0; i<200; i++) {
+        AddFrame(i, (i % 2 == 0)? 0 : 2000);
+    }
+    TEST(iEstimator->JitterUs() >= 1900);
+    TEST(iEstimator->JitterUs() <= 2000);
+    TEST(iEstimator->MaxExcessUs() == 2000);
+    // 4 * jitter (8ms) + 10ms margin, rounded up
+    TEST(iEstimator->RecommendedLatencyMs() == kMinLatencyMs);
+}
+
+void SuiteOhmJitterEstimator::TestResetOnNewStream()
+{
+    AddFrames(0, 300, 0);
+    AddFrame(300, 40000);
+    AddFrames(301, 99, 0);
+    TEST(iEstimator->MaxExcessUs() == 40000);
+    // new stream starts from sample 0 again
+    iEstimator->Add(kBaseUs + 10000000, 0, kSampleRate);
+    TEST(!iEstimator->HasEstimate());
+    TEST(iEstimator->MaxExcessUs() == 0);
+    TEST(iEstimator->JitterUs() == 0);
+}
+
+void SuiteOhmJitterEstimator::TestResetOnPause()
+{
+    AddFrames(0, 200, 0);
+    AddFrame(200, 40000);
+    TEST(iEstimator->MaxExcessUs() == 40000);
+    // sender paused for 5s; stream position continues from where it left off
+    AddFrames(201, 10, 5000000);
+    TEST(!iEstimator->HasEstimate());
+    TEST(iEstimator->MaxExcessUs() == 0);
+}
+
+void SuiteOhmJitterEstimator::TestOldPeaksExpire()
+{
+    AddFrames(0, 50, 0);
+    AddFrame(50, 40000);
+    AddFrames(51, OhmJitterEstimator::kWindowFrames, 0);
+    TEST(iEstimator->MaxExcessUs() == 40000); // still within previous window
+    AddFrames(51 + OhmJitterEstimator::kWindowFrames, OhmJitterEstimator::kWindowFrames, 0);
+    TEST(iEstimator->MaxExcessUs() == 0);
+    TEST(iEstimator->RecommendedLatencyMs() == kMinLatencyMs);
+}
+
+void SuiteOhmJitterEstimator::TestClampedToMax()
+{
+    delete iEstimator;
+    iEstimator = new OhmJitterEstimator(kMinLatencyMs, 100);
+    AddFrames(0, 150, 0);
+    AddFrame(150, 500000);
+    AddFrames(151, 49, 0);
+    TEST(iEstimator->RecommendedLatencyMs() == 100);
+}
+
+void SuiteOhmJitterEstimator::TestLossyLinkFewerLateFrames()
+{
+    /* Frames arriving later than the receiver's latency have to be repaired (or are lost).
+       Train the estimator on a simulated jittery, lossy link then check that its
+       recommendation covers the next stretch of the same link where a fixed 20ms doesn't. */
+    static const TUint kFramesTrain = 2000;
+    static const TUint kFramesRun = 2000;
+    for (TUint i=0; i<kFramesTrain; i++) {
+        TBool lost;
+        const TUint delayUs = LinkDelayUs(lost);
+        if (!lost) {
+            AddFrame(i, delayUs);
+        }
+    }
+    const TUint recommendedMs = iEstimator->RecommendedLatencyMs();
+    TEST(recommendedMs > kMinLatencyMs);
+    TEST(recommendedMs <= 80);
+
+    TUint lateFixed = 0;
+    TUint lateAdaptive = 0;
+    for (TUint i=kFramesTrain; i<kFramesTrain+kFramesRun; i++) {
+        TBool lost;
+        const TUint delayUs = LinkDelayUs(lost);
+        if (lost) {
+            continue;
+        }
+        AddFrame(i, delayUs);
+        if (delayUs > kMinLatencyMs * 1000) {
+            lateFixed++;
+        }
+        if (delayUs > recommendedMs * 1000) {
+            lateAdaptive++;
+        }
+    }
+    Print("late frames: fixed %ums latency=%u, adaptive %ums latency=%u\n",
+          kMinLatencyMs, lateFixed, recommendedMs, lateAdaptive);
+    TEST(lateFixed > 0);
+    TEST(lateAdaptive < lateFixed);
+    TEST(lateAdaptive == 0);
+}
+
+
+// SuiteOhmLatencySelector
+
+SuiteOhmLatencySelector::SuiteOhmLatencySelector()
+    : SuiteUnitTest("OhmLatencySelector")
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestFirstReportApplied), "TestFirstReportApplied");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestIncreaseApplied), "TestIncreaseApplied");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestIncreaseRateLimited), "TestIncreaseRateLimited");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestWobbleIgnored), "TestWobbleIgnored");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestSustainedDecreaseApplied), "TestSustainedDecreaseApplied");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestBriefDecreaseIgnored), "TestBriefDecreaseIgnored");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestHighestReceiverWins), "TestHighestReceiverWins");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestClampedToMax), "TestClampedToMax");
+    AddTest(MakeFunctor(*this, &SuiteOhmLatencySelector::TestReportsExpire), "TestReportsExpire");
+}
+
+void SuiteOhmLatencySelector::Setup()
+{
+    iSelector = new OhmLatencySelector(kMaxLatencyMs);
+}
+
+void SuiteOhmLatencySelector::TearDown()
+{
+    delete iSelector;
+}
+
+TBool SuiteOhmLatencySelector::Report(TUint aMs, TUint aLatencyMs)
+{
+    return iSelector->Add(kBaseUs + (TUint64)aMs * 1000, aLatencyMs);
+}
+
+TUint SuiteOhmLatencySelector::ReportFor(TUint aStartMs, TUint aDurationMs, TUint aLatencyMs)
+{ // returns the number of changes
+    TUint changes = 0;
+    for (TUint ms=aStartMs; ms<aStartMs+aDurationMs; ms+=kReportIntervalMs) {
+        if (Report(ms, aLatencyMs)) {
+            changes++;
+        }
+    }
+    return changes;
+}
+
+void SuiteOhmLatencySelector::TestFirstReportApplied()
+{
+    TEST(iSelector->LatencyMs() == 0);
+    TEST(Report(0, 40));
+    TEST(iSelector->LatencyMs() == 40);
+    TEST(!Report(1000, 40));
+}
+
+void SuiteOhmLatencySelector::TestIncreaseApplied()
+{
+    TEST(Report(0, 40));
+    TEST(Report(OhmLatencySelector::kMinChangeIntervalMs, 60));
+    TEST(iSelector->LatencyMs() == 60);
+}
+
+void SuiteOhmLatencySelector::TestIncreaseRateLimited()
+{
+    TEST(Report(0, 40));
+    TEST(!Report(1000, 60));
+    TEST(iSelector->LatencyMs() == 40);
+    // higher report is remembered, even though the next is lower
+    TEST(Report(OhmLatencySelector::kMinChangeIntervalMs, 40));
+    TEST(iSelector->LatencyMs() == 60);
+}
+
+void SuiteOhmLatencySelector::TestWobbleIgnored()
+{
+    // estimate alternating across a granularity boundary changes latency at most once
+    TUint changes = 0;
+    for (TUint i=0; i<120; i++) {
+        if (Report(i * kReportIntervalMs, (i % 2 == 0)? 40 : 50)) {
+            changes++;
+        }
+    }
+    TEST(changes == 2); // initial 40 then 50
+    TEST(iSelector->LatencyMs() == 50);
+}
+
+void SuiteOhmLatencySelector::TestSustainedDecreaseApplied()
+{
+    TEST(Report(0, 80));
+    const TUint changes = ReportFor(1000, OhmLatencySelector::kDecreaseHoldMs, 40);
+    TEST(changes == 1);
+    TEST(iSelector->LatencyMs() == 40);
+}
+
+void SuiteOhmLatencySelector::TestBriefDecreaseIgnored()
+{
+    TEST(Report(0, 80));
+    TEST(ReportFor(1000, OhmLatencySelector::kDecreaseHoldMs - 5000, 40) == 0);
+    TEST(!Report(OhmLatencySelector::kDecreaseHoldMs - 4000, 80));
+    TEST(ReportFor(OhmLatencySelector::kDecreaseHoldMs - 3000, 5000, 40) == 0);
+    TEST(iSelector->LatencyMs() == 80);
+
+    // a fall smaller than the margin is never applied
+    delete iSelector;
+    iSelector = new OhmLatencySelector(kMaxLatencyMs);
+    TEST(Report(0, 80));
+    TEST(ReportFor(1000, 3 * OhmLatencySelector::kDecreaseHoldMs, 80 - OhmLatencySelector::kDecreaseMarginMs + 10) == 0);
+    TEST(iSelector->LatencyMs() == 80);
+}
+
+void SuiteOhmLatencySelector::TestHighestReceiverWins()
+{
+    // two receivers, each reporting once a second
+    TEST(Report(0, 30));
+    TEST(!Report(500, 90));
+    TUint changes = 0;
+    for (TUint ms=1000; ms<3*OhmLatencySelector::kDecreaseHoldMs; ms+=kReportIntervalMs) {
+        if (Report(ms, 30)) {
+            changes++;
+        }
+        if (Report(ms + 500, 90)) {
+            changes++;
+        }
+    }
+    TEST(changes == 1);
+    TEST(iSelector->LatencyMs() == 90);
+}
+
+void SuiteOhmLatencySelector::TestClampedToMax()
+{
+    TEST(Report(0, kMaxLatencyMs * 2));
+    TEST(iSelector->LatencyMs() == kMaxLatencyMs);
+}
+
+void SuiteOhmLatencySelector::TestReportsExpire()
+{
+    TEST(!iSelector->Expire(kBaseUs)); // nothing to expire
+    TEST(Report(0, 500));
+    TEST(ReportFor(1000, 5000, 500) == 0);
+    // expiry timer racing with a recent report is ignored
+    TEST(!iSelector->Expire(kBaseUs + 6000 * 1000ULL));
+    TEST(iSelector->LatencyMs() == 500);
+    // reports stop (e.g. last adaptive receiver left)
+    const TUint lastReportMs = 5000;
+    TEST(iSelector->Expire(kBaseUs + (lastReportMs + OhmLatencySelector::kReportExpiryMs) * 1000ULL));
+    TEST(iSelector->LatencyMs() == 0);
+    TEST(!iSelector->Expire(kBaseUs + (lastReportMs + 2 * OhmLatencySelector::kReportExpiryMs) * 1000ULL));
+    // a later report applies immediately
+    TEST(Report(lastReportMs + OhmLatencySelector::kReportExpiryMs + 1000, 40));
+    TEST(iSelector->LatencyMs() == 40);
+}
+
+
+// SuiteOhmReceiveQueue
+
+SuiteOhmReceiveQueue::SuiteOhmReceiveQueue(Environment& aEnv, TIpAddress aInterface)
+    : SuiteUnitTest("OhmReceiveQueue")
+    , iEnv(aEnv)
+    , iInterface(aInterface)
+{
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiveQueue::TestQueuedInOrder), "TestQueuedInOrder");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiveQueue::TestOverflowDropped), "TestOverflowDropped");
+    AddTest(MakeFunctor(*this, &SuiteOhmReceiveQueue::TestInterrupt), "TestInterrupt");
+}
+
+void SuiteOhmReceiveQueue::Setup()
+{
+    iSender = new SocketUdp(iEnv);
+    iReceiver = new SocketUdp(iEnv);
+    iQueue = new OhmReceiveQueue(iEnv, *iReceiver, kPriorityNormal, kMaxDatagrams, kMaxDatagramBytes);
+}
+
+void SuiteOhmReceiveQueue::TearDown()
+{
+    delete iQueue;
+    delete iReceiver;
+    delete iSender;
+}
+
+void SuiteOhmReceiveQueue::Send(TUint aIndex)
+{
+    Bws<kMaxDatagramBytes> buf("datagram ");
+    Ascii::AppendDec(buf, aIndex);
+    iSender->Send(buf, Endpoint(iReceiver->Port(), iInterface));
+}
+
+void SuiteOhmReceiveQueue::WaitForQueue()
+{
+    Thread::Sleep(100); // allow the queue's thread to read everything sent over loopback
+}
+
+void SuiteOhmReceiveQueue::TestQueuedInOrder()
+{
+    for (TUint i=0; i<3; i++) {
+        Send(i);
+    }
+    WaitForQueue();
+    TUint64 prevRxTimeUs = 0;
+    for (TUint i=0; i<3; i++) {
+        TUint64 rxTimeUs = 0;
+        const Endpoint sender = iQueue->Receive(iBuf, rxTimeUs);
+        Bws<kMaxDatagramBytes> expected("datagram ");
+        Ascii::AppendDec(expected, i);
+        TEST(iBuf == expected);
+        TEST(sender.Port() == iSender->Port());
+        TEST(rxTimeUs != 0);
+        TEST(rxTimeUs >= prevRxTimeUs);
+        prevRxTimeUs = rxTimeUs;
+    }
+    TEST(iQueue->Dropped() == 0);
+}
+
+void SuiteOhmReceiveQueue::TestOverflowDropped()
+{
+    // datagrams arriving while the queue is full are discarded; those already queued are kept
+    for (TUint i=0; i<kMaxDatagrams+2; i++) {
+        Send(i);
+    }
+    WaitForQueue();
+    TEST(iQueue->Dropped() == 2);
+    for (TUint i=0; i<kMaxDatagrams; i++) {
+        TUint64 rxTimeUs;
+        (void)iQueue->Receive(iBuf, rxTimeUs);
+        Bws<kMaxDatagramBytes> expected("datagram ");
+        Ascii::AppendDec(expected, i);
+        TEST(iBuf == expected);
+    }
+    Send(kMaxDatagrams+2);
+    TUint64 rxTimeUs;
+    (void)iQueue->Receive(iBuf, rxTimeUs);
+    TEST(iBuf == Brn("datagram 6"));
+}
+
+void SuiteOhmReceiveQueue::TestInterrupt()
+{
+    Send(0);
+    WaitForQueue();
+    TUint64 rxTimeUs;
+    iQueue->Interrupt(true);
+    TEST_THROWS(iQueue->Receive(iBuf, rxTimeUs), ReaderError);
+    // datagrams are still queued while the consumer is interrupted
+    Send(1);
+    WaitForQueue();
+    iQueue->Interrupt(false);
+    (void)iQueue->Receive(iBuf, rxTimeUs);
+    TEST(iBuf == Brn("datagram 0"));
+    (void)iQueue->Receive(iBuf, rxTimeUs);
+    TEST(iBuf == Brn("datagram 1"));
+}
+
+
+
+void TestOhmJitter(Environment& aEnv)
+{
+    NetworkAdapterList& nifList = aEnv.NetworkAdapterList();
+    AutoNetworkAdapterRef ref(aEnv, "TestOhmJitter");
+    NetworkAdapter* current = ref.Adapter();
+    TIpAddress addr = 0;
+    if (current != nullptr) {
+        addr = current->Address();
+    }
+    else {
+        std::vector<NetworkAdapter*>* subnetList = nifList.CreateSubnetList();
+        ASSERT(subnetList->size() > 0);
+        addr = (*subnetList)[0]->Address();
+        NetworkAdapterList::DestroySubnetList(subnetList);
+    }
+
+    Runner runner("Songcast adaptive latency tests\n");
+    runner.Add(new SuiteOhmJitterEstimator());
+    runner.Add(new SuiteOhmLatencySelector());
+    runner.Add(new SuiteOhmReceiveQueue(aEnv, addr));
+    runner.Run();
+}
@@ -0,0 +1,12 @@
+#include <OpenHome/Private/TestFramework.h>
+
+using namespace OpenHome;
+
+extern void TestOhmJitter(Environment& aEnv);
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::Library* lib = new Net::Library(aInitParams);
+    TestOhmJitter(lib->Env());
+    delete lib;
+}
@@ -5,6 +5,7 @@
 #include <OpenHome/Tests/TestPipe.h>
 #include <OpenHome/Private/Timer.h>
 #include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Converter.h>
 
 namespace OpenHome {
 namespace Av {
@@ -95,6 +96,23 @@ private:
     std::vector<std::reference_wrapper<MockTimerRepairer>> iTimers;
 };
 
+class SuiteRaopAudioDecryptor : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+public:
+    SuiteRaopAudioDecryptor();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestDecrypt();
+    void TestDecryptRepeated();
+    void TestTrailingBytesUnencrypted();
+    void TestShortPacket();
+private:
+    RaopAudioDecryptor* iDecryptor;
+    Bws<64> iOut;
+};
+
 class SuiteRaopResend : public TestFramework::SuiteUnitTest, private INonCopyable
 {
 private:
@@ -1109,9 +1127,81 @@ void SuiteRaopResend::TestSequenceNumberWrappingDuringRepair()
 
 
 
+// SuiteRaopAudioDecryptor
+
+// AES-128-CBC test vectors from NIST SP 800-38A, F.2.2
+static const TByte kAesKey[] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const TByte kAesIv[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f };
+static const TByte kAesCipherText[] = { 0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46, 0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+                                        0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee, 0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2 };
+static const TByte kAesPlainText[] = { 0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+                                       0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51 };
+
+SuiteRaopAudioDecryptor::SuiteRaopAudioDecryptor()
+    : SuiteUnitTest("SuiteRaopAudioDecryptor")
+{
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestDecrypt), "TestDecrypt");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestDecryptRepeated), "TestDecryptRepeated");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestTrailingBytesUnencrypted), "TestTrailingBytesUnencrypted");
+    AddTest(MakeFunctor(*this, &SuiteRaopAudioDecryptor::TestShortPacket), "TestShortPacket");
+}
+
+void SuiteRaopAudioDecryptor::Setup()
+{
+    iDecryptor = new RaopAudioDecryptor();
+    iDecryptor->Init(Brn(kAesKey, sizeof(kAesKey)), Brn(kAesIv, sizeof(kAesIv)));
+    iOut.SetBytes(0);
+}
+
+void SuiteRaopAudioDecryptor::TearDown()
+{
+    delete iDecryptor;
+}
+
+void SuiteRaopAudioDecryptor::TestDecrypt()
+{
+    const Brn cipherText(kAesCipherText, sizeof(kAesCipherText));
+    iDecryptor->Decrypt(cipherText, iOut);
+    TEST(iOut.Bytes() == RaopAudioDecryptor::kPacketSizeBytes + cipherText.Bytes());
+    TEST(Converter::BeUint32At(iOut, 0) == cipherText.Bytes());
+    TEST(iOut.Split(RaopAudioDecryptor::kPacketSizeBytes) == Brn(kAesPlainText, sizeof(kAesPlainText)));
+}
+
+void SuiteRaopAudioDecryptor::TestDecryptRepeated()
+{
+    // each packet is decrypted starting from the session's initialisation vector
+    const Brn cipherText(kAesCipherText, sizeof(kAesCipherText));
+    const Brn plainText(kAesPlainText, sizeof(kAesPlainText));
+    for (TUint i=0; i<3; i++) {
+        iDecryptor->Decrypt(cipherText, iOut);
+        TEST(iOut.Split(RaopAudioDecryptor::kPacketSizeBytes) == plainText);
+    }
+}
+
+void SuiteRaopAudioDecryptor::TestTrailingBytesUnencrypted()
+{
+    Bws<sizeof(kAesCipherText) + 3> packet(Brn(kAesCipherText, sizeof(kAesCipherText)));
+    packet.Append("xyz");
+    iDecryptor->Decrypt(packet, iOut);
+    TEST(iOut.Bytes() == RaopAudioDecryptor::kPacketSizeBytes + packet.Bytes());
+    TEST(Converter::BeUint32At(iOut, 0) == packet.Bytes());
+    TEST(iOut.Split(RaopAudioDecryptor::kPacketSizeBytes, sizeof(kAesPlainText)) == Brn(kAesPlainText, sizeof(kAesPlainText)));
+    TEST(iOut.Split(RaopAudioDecryptor::kPacketSizeBytes + sizeof(kAesPlainText)) == Brn("xyz"));
+}
+
+void SuiteRaopAudioDecryptor::TestShortPacket()
+{
+    // packets shorter than a cipher block are not encrypted
+    iDecryptor->Decrypt(Brn("short"), iOut);
+    TEST(Converter::BeUint32At(iOut, 0) == 5);
+    TEST(iOut.Split(RaopAudioDecryptor::kPacketSizeBytes) == Brn("short"));
+}
+
+
 void TestRaop(Environment& aEnv)
 {
     Runner runner("RAOP tests\n");
+    runner.Add(new SuiteRaopAudioDecryptor());
     runner.Add(new SuiteRaopResend(aEnv));
     runner.Run();
 }
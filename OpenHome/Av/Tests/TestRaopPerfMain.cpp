@@ -0,0 +1,201 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Av/Raop/UdpServer.h>
+#include <OpenHome/Av/Raop/ProtocolRaop.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/NetworkAdapterList.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Thread.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+
+/*
+    Measures the RAOP audio receive path:
+    - packets/sec a SocketUdpServer delivers to a reader when sent bursts of packets over
+      the local network adapter, along with the number it had to drop;
+    - time taken to decrypt a typical (352 frame, 16-bit stereo) audio packet.
+    Times are wall-clock, so per-packet figures are an upper bound on CPU cost.
+*/
+
+namespace OpenHome {
+namespace Av {
+namespace TestRaopPerf {
+
+class Bench : private INonCopyable
+{
+    static const TUint kMaxPacketBytes = 1472;
+    static const TUint kAudioPacketBytes = 352 * 4;
+    static const TUint kServerPackets = 25; // as SourceRaop
+    static const TUint kDrainMs = 200;
+public:
+    Bench(Environment& aEnv, TIpAddress aInterface, TUint aPackets, TUint aBurst);
+    void Run();
+private:
+    void RunReceive();
+    void RunDecrypt();
+    void Consume();
+private:
+    Environment& iEnv;
+    const TIpAddress iInterface;
+    const TUint iPackets;
+    const TUint iBurst;
+    SocketUdpServer* iServer;
+    Bws<kMaxPacketBytes> iRxBuf;
+    TUint iReceived;
+    TUint64 iLastRxUs;
+};
+
+} // namespace TestRaopPerf
+} // namespace Av
+} // namespace OpenHome
+
+using namespace OpenHome::Av::TestRaopPerf;
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, TIpAddress aInterface, TUint aPackets, TUint aBurst)
+    : iEnv(aEnv)
+    , iInterface(aInterface)
+    , iPackets(aPackets)
+    , iBurst(aBurst)
+    , iServer(nullptr)
+    , iReceived(0)
+    , iLastRxUs(0)
+{
+}
+
+void Bench::Run()
+{
+    RunReceive();
+    RunDecrypt();
+}
+
+void Bench::RunReceive()
+{
+    iServer = new SocketUdpServer(iEnv, kMaxPacketBytes, kServerPackets, ThreadPriority::kPriorityHigh, 0, iInterface);
+    iServer->Open();
+    iReceived = 0;
+    ThreadFunctor* consumer = new ThreadFunctor("RaopPerfConsumer", MakeFunctor(*this, &Bench::Consume), ThreadPriority::kPriorityNormal);
+    consumer->Start();
+
+    SocketUdp sender(iEnv);
+    const Endpoint ep(iServer->Port(), iInterface);
+    Bws<kAudioPacketBytes> packet;
+    packet.SetBytes(packet.MaxBytes());
+    const TUint64 startUs = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iPackets; i++) {
+        packet[0] = (TByte)i;
+        sender.Send(packet, ep);
+        if ((i + 1) % iBurst == 0) {
+            Thread::Sleep(1);
+        }
+    }
+    Thread::Sleep(kDrainMs);
+    iServer->Interrupt(true);
+    delete consumer;
+
+    const TUint dropped = iServer->Dropped();
+    delete iServer;
+    iServer = nullptr;
+
+    const TUint64 elapsedUs = (iLastRxUs > startUs? iLastRxUs - startUs : 1);
+    const TUint perSec = (TUint)(((TUint64)iReceived * 1000000) / elapsedUs);
+    const TUint usPerPacket = (iReceived > 0? (TUint)(elapsedUs / iReceived) : 0);
+    Log::Print("UDP receive: %u packets sent in bursts of %u\n", iPackets, iBurst);
+    Log::Print("%-24s %12u\n", "received", iReceived);
+    Log::Print("%-24s %12u\n", "dropped by server", dropped);
+    Log::Print("%-24s %12u\n", "lost elsewhere", iPackets - iReceived - dropped);
+    Log::Print("%-24s %12u\n", "packets/sec", perSec);
+    Log::Print("%-24s %12u\n", "us/packet", usPerPacket);
+}
+
+void Bench::Consume()
+{
+    for (;;) {
+        try {
+            iServer->Receive(iRxBuf);
+        }
+        catch (NetworkError&) {
+            break;
+        }
+        iReceived++;
+        iLastRxUs = OsTimeInUs(iEnv.OsCtx());
+    }
+}
+
+void Bench::RunDecrypt()
+{
+    Bws<16> key;
+    Bws<16> iv;
+    for (TUint i=0; i<16; i++) {
+        key.Append((TByte)i);
+        iv.Append((TByte)(0xff - i));
+    }
+    RaopAudioDecryptor decryptor;
+    decryptor.Init(key, iv);
+    Bws<kAudioPacketBytes> encrypted;
+    encrypted.SetBytes(encrypted.MaxBytes());
+    Bws<RaopAudioDecryptor::kPacketSizeBytes + kAudioPacketBytes> decrypted;
+
+    const TUint64 startUs = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iPackets; i++) {
+        decryptor.Decrypt(encrypted, decrypted);
+    }
+    const TUint64 elapsedUs = OsTimeInUs(iEnv.OsCtx()) - startUs;
+    const TUint nsPerPacket = (TUint)((elapsedUs * 1000) / iPackets);
+    const TUint mbPerSec = (elapsedUs > 0? (TUint)(((TUint64)iPackets * kAudioPacketBytes) / elapsedUs) : 0);
+    Log::Print("AES decrypt: %u packets of %u bytes\n", iPackets, kAudioPacketBytes);
+    Log::Print("%-24s %12u\n", "ns/packet", nsPerPacket);
+    Log::Print("%-24s %12u\n", "MB/s", mbPerSec);
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionPackets("-p", "--packets", 20000, "number of packets sent/decrypted");
+    parser.AddOption(&optionPackets);
+    OptionUint optionBurst("-b", "--burst", 16, "packets sent back-to-back before pausing for 1ms");
+    parser.AddOption(&optionBurst);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+    if (optionPackets.Value() == 0 || optionBurst.Value() == 0) {
+        Log::Print("--packets and --burst must be non-zero\n");
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Environment& env = lib->Env();
+    TIpAddress addr = 0;
+    {
+        NetworkAdapterList& nifList = env.NetworkAdapterList();
+        AutoNetworkAdapterRef ref(env, "TestRaopPerf");
+        const NetworkAdapter* current = ref.Adapter();
+        if (current != nullptr) {
+            addr = current->Address();
+        }
+        else {
+            std::vector<NetworkAdapter*>* subnetList = nifList.CreateSubnetList();
+            if (subnetList->size() > 0) {
+                addr = (*subnetList)[0]->Address();
+            }
+            NetworkAdapterList::DestroySubnetList(subnetList);
+        }
+    }
+    Bench* bench = new Bench(env, addr, optionPackets.Value(), optionBurst.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
@@ -0,0 +1,398 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+
+namespace OpenHome {
+namespace Av {
+namespace Test {
+
+// Stands in for a streaming service's api, taking a fixed time to answer each request
+class MockStreamUrlSource : public IStreamUrlSource
+{
+public:
+    MockStreamUrlSource(TUint aLatencyMs);
+    TUint Requests() const;
+    void SetFail(TBool aFail);
+    void SetInterruptible(TBool aInterruptible);
+    TBool Interrupted() const;
+    void WaitForRequest();
+    void ChangeQuality();
+public: // from IStreamUrlSource
+    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl) override;
+    void Interrupt(TBool aInterrupt) override;
+    void SetStreamUrlCache(IStreamUrlCache* aCache) override;
+private:
+    mutable Mutex iLock;
+    Semaphore iSemRequested;
+    Semaphore iSemInterrupt;
+    const TUint iLatencyMs;
+    TUint iRequests;
+    TBool iFail;
+    TBool iInterruptible;
+    TBool iInterrupted;
+    IStreamUrlCache* iCache;
+};
+
+} // namespace Test
+
+class SuiteStreamUrlResolver : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+    static const TUint kLatencyMs = 200;
+    static const TUint kLifetimeMs = 60 * 1000;
+public:
+    SuiteStreamUrlResolver(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    TUint TimedGet(const Brx& aTrackId, Bwx& aUrl);
+    void WaitForPrefetch();
+    void GetOnThread();
+private:
+    void TestMissResolvesSynchronously();
+    void TestSecondRequestIsCached();
+    void TestPrefetchAvoidsRoundTrip();
+    void TestPrefetchDuplicatesIgnored();
+    void TestRequestDuringPrefetchNotDuplicated();
+    void TestFailureNotCached();
+    void TestInvalidate();
+    void TestExpiry();
+    void TestMissInterruptsOtherPrefetch();
+    void TestSourceChangeClearsCache();
+    void TestInFlightResultDiscardedByClear();
+    void TestClientInterruptNotCleared();
+private:
+    Environment& iEnv;
+    Test::MockStreamUrlSource* iSource;
+    StreamUrlResolver* iResolver;
+    Semaphore iSemGot;
+    TBool iGotUrl;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Av::Test;
+
+
+// MockStreamUrlSource
+
+MockStreamUrlSource::MockStreamUrlSource(TUint aLatencyMs)
+    : iLock("MSUS")
+    , iSemRequested("MSUS", 0)
+    , iSemInterrupt("MSUI", 0)
+    , iLatencyMs(aLatencyMs)
+    , iRequests(0)
+    , iFail(false)
+    , iInterruptible(true)
+    , iInterrupted(false)
+    , iCache(nullptr)
+{
+}
+
+TUint MockStreamUrlSource::Requests() const
+{
+    AutoMutex _(iLock);
+    return iRequests;
+}
+
+void MockStreamUrlSource::SetFail(TBool aFail)
+{
+    AutoMutex _(iLock);
+    iFail = aFail;
+}
+
+void MockStreamUrlSource::SetInterruptible(TBool aInterruptible)
+{
+    AutoMutex _(iLock);
+    iInterruptible = aInterruptible;
+}
+
+TBool MockStreamUrlSource::Interrupted() const
+{
+    AutoMutex _(iLock);
+    return iInterrupted;
+}
+
+void MockStreamUrlSource::WaitForRequest()
+{
+    iSemRequested.Wait();
+}
+
+void MockStreamUrlSource::ChangeQuality()
+{
+    AutoMutex _(iLock);
+    if (iCache != nullptr) {
+        iCache->Clear();
+    }
+}
+
+TBool MockStreamUrlSource::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
+{
+    iLock.Wait();
+    TBool interrupted = iInterrupted;
+    const TBool interruptible = iInterruptible;
+    iLock.Signal();
+    if (!interruptible) {
+        Thread::Sleep(iLatencyMs);
+    }
+    else if (!interrupted) {
+        try {
+            iSemInterrupt.Wait(iLatencyMs);
+        }
+        catch (Timeout&) {
+        }
+    }
+    iLock.Wait();
+    iRequests++;
+    interrupted = iInterrupted;
+    const TBool fail = iFail || interrupted;
+    iLock.Signal();
+    if (!fail) {
+        aStreamUrl.Replace("https://cdn.example.com/");
+        aStreamUrl.Append(aTrackId);
+    }
+    iSemRequested.Signal();
+    return !fail;
+}
+
+void MockStreamUrlSource::Interrupt(TBool aInterrupt)
+{
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (aInterrupt) {
+        iSemInterrupt.Signal();
+    }
+    else {
+        iSemInterrupt.Clear();
+    }
+}
+
+void MockStreamUrlSource::SetStreamUrlCache(IStreamUrlCache* aCache)
+{
+    AutoMutex _(iLock);
+    iCache = aCache;
+}
+
+
+// SuiteStreamUrlResolver
+
+SuiteStreamUrlResolver::SuiteStreamUrlResolver(Environment& aEnv)
+    : SuiteUnitTest("StreamUrlResolver")
+    , iEnv(aEnv)
+    , iSemGot("SSUR", 0)
+    , iGotUrl(false)
+{
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestMissResolvesSynchronously), "TestMissResolvesSynchronously");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestSecondRequestIsCached), "TestSecondRequestIsCached");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestPrefetchAvoidsRoundTrip), "TestPrefetchAvoidsRoundTrip");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestPrefetchDuplicatesIgnored), "TestPrefetchDuplicatesIgnored");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestRequestDuringPrefetchNotDuplicated), "TestRequestDuringPrefetchNotDuplicated");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestFailureNotCached), "TestFailureNotCached");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestInvalidate), "TestInvalidate");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestExpiry), "TestExpiry");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestMissInterruptsOtherPrefetch), "TestMissInterruptsOtherPrefetch");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestSourceChangeClearsCache), "TestSourceChangeClearsCache");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestInFlightResultDiscardedByClear), "TestInFlightResultDiscardedByClear");
+    AddTest(MakeFunctor(*this, &SuiteStreamUrlResolver::TestClientInterruptNotCleared), "TestClientInterruptNotCleared");
+}
+
+void SuiteStreamUrlResolver::Setup()
+{
+    iSource = new MockStreamUrlSource(kLatencyMs);
+    iResolver = new StreamUrlResolver(iEnv, *iSource, kLifetimeMs);
+}
+
+void SuiteStreamUrlResolver::TearDown()
+{
+    delete iResolver;
+    delete iSource;
+}
+
+TUint SuiteStreamUrlResolver::TimedGet(const Brx& aTrackId, Bwx& aUrl)
+{
+    const TUint start = Os::TimeInMs(iEnv.OsCtx());
+    TEST(iResolver->TryGetStreamUrl(aTrackId, aUrl));
+    return Os::TimeInMs(iEnv.OsCtx()) - start;
+}
+
+void SuiteStreamUrlResolver::WaitForPrefetch()
+{
+    iSource->WaitForRequest();
+    Thread::Sleep(10); // give the prefetch thread time to store its result
+}
+
+void SuiteStreamUrlResolver::GetOnThread()
+{
+    Bws<64> url;
+    iGotUrl = iResolver->TryGetStreamUrl(Brn("1013"), url);
+    iSemGot.Signal();
+}
+
+void SuiteStreamUrlResolver::TestMissResolvesSynchronously()
+{
+    Bws<64> url;
+    const TUint ms = TimedGet(Brn("1001"), url);
+    TEST(url == Brn("https://cdn.example.com/1001"));
+    TEST(ms >= kLatencyMs);
+    TEST(iSource->Requests() == 1);
+    TEST(iResolver->CacheMisses() == 1);
+    Print("  track change (no prefetch) took %ums\n", ms);
+}
+
+void SuiteStreamUrlResolver::TestSecondRequestIsCached()
+{
+    Bws<64> url;
+    (void)TimedGet(Brn("1001"), url);
+    url.SetBytes(0);
+    (void)TimedGet(Brn("1001"), url);
+    TEST(url == Brn("https://cdn.example.com/1001"));
+    TEST(iSource->Requests() == 1);
+    TEST(iResolver->CacheHits() == 1);
+}
+
+void SuiteStreamUrlResolver::TestPrefetchAvoidsRoundTrip()
+{
+    iResolver->Prefetch(Brn("1002"));
+    WaitForPrefetch();
+    Bws<64> url;
+    const TUint ms = TimedGet(Brn("1002"), url);
+    TEST(url == Brn("https://cdn.example.com/1002"));
+    TEST(ms < kLatencyMs);
+    TEST(iSource->Requests() == 1);
+    TEST(iResolver->CacheHits() == 1);
+    TEST(iResolver->CacheMisses() == 0);
+    Print("  track change (prefetched) took %ums\n", ms);
+}
+
+void SuiteStreamUrlResolver::TestPrefetchDuplicatesIgnored()
+{
+    iResolver->Prefetch(Brn("1003"));
+    iResolver->Prefetch(Brn("1003"));
+    WaitForPrefetch();
+    iResolver->Prefetch(Brn("1003")); // already cached
+    Thread::Sleep(2 * kLatencyMs);
+    TEST(iSource->Requests() == 1);
+}
+
+void SuiteStreamUrlResolver::TestRequestDuringPrefetchNotDuplicated()
+{
+    iResolver->Prefetch(Brn("1004"));
+    Thread::Sleep(kLatencyMs / 4); // prefetch is now in flight
+    Bws<64> url;
+    const TUint ms = TimedGet(Brn("1004"), url);
+    TEST(url == Brn("https://cdn.example.com/1004"));
+    TEST(ms < kLatencyMs);
+    TEST(iSource->Requests() == 1);
+}
+
+void SuiteStreamUrlResolver::TestFailureNotCached()
+{
+    iSource->SetFail(true);
+    Bws<64> url;
+    TEST(!iResolver->TryGetStreamUrl(Brn("1005"), url));
+    iSource->SetFail(false);
+    (void)TimedGet(Brn("1005"), url);
+    TEST(url == Brn("https://cdn.example.com/1005"));
+    TEST(iSource->Requests() == 2);
+}
+
+void SuiteStreamUrlResolver::TestInvalidate()
+{
+    Bws<64> url;
+    (void)TimedGet(Brn("1006"), url);
+    iResolver->Invalidate(Brn("1006"));
+    (void)TimedGet(Brn("1006"), url);
+    TEST(iSource->Requests() == 2);
+    iResolver->Clear();
+    (void)TimedGet(Brn("1006"), url);
+    TEST(iSource->Requests() == 3);
+}
+
+void SuiteStreamUrlResolver::TestExpiry()
+{
+    static const TUint kShortLifetimeMs = 3 * kLatencyMs;
+    delete iResolver;
+    iResolver = new StreamUrlResolver(iEnv, *iSource, kShortLifetimeMs);
+    Bws<64> url;
+    (void)TimedGet(Brn("1007"), url);
+    (void)TimedGet(Brn("1007"), url);
+    TEST(iSource->Requests() == 1);
+    Thread::Sleep(kShortLifetimeMs);
+    (void)TimedGet(Brn("1007"), url);
+    TEST(iSource->Requests() == 2);
+}
+
+void SuiteStreamUrlResolver::TestMissInterruptsOtherPrefetch()
+{
+    iResolver->Prefetch(Brn("1008"));
+    Thread::Sleep(kLatencyMs / 4); // prefetch is now in flight
+    Bws<64> url;
+    const TUint ms = TimedGet(Brn("1009"), url);
+    TEST(url == Brn("https://cdn.example.com/1009"));
+    TEST(ms < 2 * kLatencyMs); // didn't wait for the prefetch to complete
+    TEST(iResolver->PrefetchesInterrupted() == 1);
+    TEST(iSource->Requests() == 2);
+    Print("  track change (other track prefetching) took %ums\n", ms);
+
+    // interrupted prefetch wasn't cached
+    (void)TimedGet(Brn("1008"), url);
+    TEST(iSource->Requests() == 3);
+    TEST(iResolver->CacheMisses() == 2);
+}
+
+void SuiteStreamUrlResolver::TestSourceChangeClearsCache()
+{
+    Bws<64> url;
+    (void)TimedGet(Brn("1010"), url);
+    (void)TimedGet(Brn("1010"), url);
+    TEST(iSource->Requests() == 1);
+    iSource->ChangeQuality();
+    (void)TimedGet(Brn("1010"), url);
+    TEST(iSource->Requests() == 2);
+}
+
+void SuiteStreamUrlResolver::TestInFlightResultDiscardedByClear()
+{
+    iResolver->Prefetch(Brn("1011"));
+    Thread::Sleep(kLatencyMs / 4); // prefetch is now in flight
+    iSource->ChangeQuality();
+    WaitForPrefetch();
+    Bws<64> url;
+    (void)TimedGet(Brn("1011"), url);
+    TEST(iSource->Requests() == 2);
+}
+
+void SuiteStreamUrlResolver::TestClientInterruptNotCleared()
+{
+    // source is slow to act on interrupts so the client interrupts while a prefetch is being abandoned
+    iSource->SetInterruptible(false);
+    iResolver->Prefetch(Brn("1012"));
+    Thread::Sleep(kLatencyMs / 4); // prefetch is now in flight
+    ThreadFunctor* thread = new ThreadFunctor("TrackChange", MakeFunctor(*this, &SuiteStreamUrlResolver::GetOnThread));
+    thread->Start();
+    Thread::Sleep(kLatencyMs / 4); // cache miss has interrupted the prefetch
+    TEST(iResolver->PrefetchesInterrupted() == 1);
+    iResolver->Interrupt(true);
+    iSemGot.Wait();
+    delete thread;
+    // end of the prefetch didn't clear the client's interrupt so the cache miss wasn't resolved
+    TEST(iSource->Interrupted());
+    TEST(!iGotUrl);
+    iResolver->Interrupt(false);
+    TEST(!iSource->Interrupted());
+}
+
+void TestStreamUrlResolver(Environment& aEnv)
+{
+    Runner runner("StreamUrlResolver tests\n");
+    runner.Add(new SuiteStreamUrlResolver(aEnv));
+    runner.Run();
+}
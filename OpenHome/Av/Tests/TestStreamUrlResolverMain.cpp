@@ -0,0 +1,12 @@
+#include <OpenHome/Private/TestFramework.h>
+
+using namespace OpenHome;
+
+extern void TestStreamUrlResolver(Environment& aEnv);
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::Library* lib = new Net::Library(aInitParams);
+    TestStreamUrlResolver(lib->Env());
+    delete lib;
+}
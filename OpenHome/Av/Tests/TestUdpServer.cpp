@@ -368,6 +368,7 @@ void SuiteSocketUdpServer::TestMsgsDisposedCapacityExceeded()
         iServer->Receive(iInBuf);
         CheckMsgValue(iInBuf, iMsgCount++);
     }
+    TEST(iServer->Dropped() == kDisposedCount);
 
     iMsgCount += kDisposedCount;
 
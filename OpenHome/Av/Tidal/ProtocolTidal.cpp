@@ -12,16 +12,20 @@
 #include <OpenHome/Private/Parser.h>
 #include <OpenHome/Private/Ascii.h>
 #include <OpenHome/Av/Tidal/Tidal.h>
+#include <OpenHome/Av/TrackLookahead.h>
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
 #include <OpenHome/Media/SupplyAggregator.h>
         
 namespace OpenHome {
 namespace Av {
 
-class ProtocolTidal : public Media::ProtocolNetwork, private IReader
+class ProtocolTidal : public Media::ProtocolNetwork, private IReader, private ITrackLookaheadObserver
 {
     static const TUint kTcpConnectTimeoutMs = 10 * 1000;
+    static const TUint kStreamUrlLifetimeMs = 5 * 60 * 1000; // conservative; the service doesn't report url expiry
 public:
-    ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager, Configuration::IConfigInitialiser& aConfigInitialiser);
+    ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager,
+                  Configuration::IConfigInitialiser& aConfigInitialiser, ITrackLookahead& aTrackLookahead);
     ~ProtocolTidal();
 private: // from Media::Protocol
     void Initialise(Media::MsgFactory& aMsgFactory, Media::IPipelineElementDownstream& aDownstream) override;
@@ -37,6 +41,8 @@ private: // from IReader
     Brn Read(TUint aBytes) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+private: // from ITrackLookaheadObserver
+    void NotifyTrackUpcoming(const Brx& aUri) override;
 private:
     static TBool TryGetTrackId(const Brx& aQuery, Bwx& aTrackId);
     Media::ProtocolStreamResult DoStream();
@@ -47,6 +53,7 @@ private:
     TBool IsCurrentStream(TUint aStreamId) const;
 private:
     Tidal* iTidal;
+    StreamUrlResolver* iResolver;
     Media::SupplyAggregator* iSupply;
     Uri iUri;
     Bws<12> iTrackId;
@@ -80,13 +87,14 @@ using namespace OpenHome::Configuration;
 
 Protocol* ProtocolFactory::NewTidal(Environment& aEnv, const Brx& aToken, Av::IMediaPlayer& aMediaPlayer)
 { // static
-    return new ProtocolTidal(aEnv, aToken, aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser());
+    return new ProtocolTidal(aEnv, aToken, aMediaPlayer.CredentialsManager(), aMediaPlayer.ConfigInitialiser(), aMediaPlayer.TrackLookahead());
 }
 
 
 // ProtocolTidal
 
-ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager, IConfigInitialiser& aConfigInitialiser)
+ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials& aCredentialsManager,
+                             IConfigInitialiser& aConfigInitialiser, ITrackLookahead& aTrackLookahead)
     : ProtocolNetwork(aEnv)
     , iSupply(nullptr)
     , iWriterRequest(iWriterBuf)
@@ -100,10 +108,13 @@ ProtocolTidal::ProtocolTidal(Environment& aEnv, const Brx& aToken, Credentials&
 
     iTidal = new Tidal(aEnv, aToken, aCredentialsManager, aConfigInitialiser);
     aCredentialsManager.Add(iTidal);
+    iResolver = new StreamUrlResolver(aEnv, *iTidal, kStreamUrlLifetimeMs);
+    aTrackLookahead.AddObserver(*this);
 }
 
 ProtocolTidal::~ProtocolTidal()
 {
+    delete iResolver;
     delete iSupply;
 }
 
@@ -120,8 +131,9 @@ void ProtocolTidal::Interrupt(TBool aInterrupt)
         if (aInterrupt) {
             iStopped = true;
         }
+        iResolverClient.Interrupt(aInterrupt);
         iTcpClient.Interrupt(aInterrupt);
-        iTidal->Interrupt(aInterrupt);
+        iResolver->Interrupt(aInterrupt); // also interrupts iTidal
     }
     iLock.Signal();
 }
@@ -133,7 +145,8 @@ ProtocolStreamResult ProtocolTidal::Stream(const Brx& aUri)
     iSeekable = iSeek = iStarted = iStopped = false;
     iContentProcessor = nullptr;
     iNextFlushId = MsgFlush::kIdInvalid;
-    iTidal->Interrupt(false);
+    iResolver->Interrupt(false);
+    iResolverClient.Interrupt(false);
     iUri.Replace(aUri);
 
     if (iUri.Scheme() != Brn("tidal")) {
@@ -148,11 +161,13 @@ ProtocolStreamResult ProtocolTidal::Stream(const Brx& aUri)
     if (iSessionId.Bytes() == 0 && !iTidal->TryLogin(iSessionId)) {
         return EProtocolStreamErrorUnrecoverable;
     }
-    if (!iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+    if (!iResolver->TryGetStreamUrl(iTrackId, iStreamUrl)) {
         // any error might be due to our session having expired
         // attempt logout, login, getStreamUrl to see if that fixes things
+        // (urls cached against the old session are discarded)
+        iResolver->Clear();
         (void)iTidal->TryLogout(iSessionId);
-        if (!iTidal->TryLogin(iSessionId) || !iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+        if (!iTidal->TryLogin(iSessionId) || !iResolver->TryGetStreamUrl(iTrackId, iStreamUrl)) {
             return EProtocolStreamErrorUnrecoverable;
         }
     }
@@ -282,6 +297,17 @@ void ProtocolTidal::ReadInterrupt()
     iReaderUntil.ReadInterrupt();
 }
 
+void ProtocolTidal::NotifyTrackUpcoming(const Brx& aUri)
+{
+    if (!aUri.BeginsWith(Brn("tidal://"))) {
+        return;
+    }
+    Bws<12> trackId;
+    if (TryGetTrackId(aUri, trackId)) {
+        iResolver->Prefetch(trackId);
+    }
+}
+
 TBool ProtocolTidal::TryGetTrackId(const Brx& aQuery, Bwx& aTrackId)
 { // static
     Parser parser(aQuery);
@@ -409,8 +435,9 @@ ProtocolStreamResult ProtocolTidal::ProcessContent()
     iContentProcessor = iProtocolManager->GetAudioProcessor();
     auto res = iContentProcessor->Stream(*this, iTotalBytes);
     if (res == EProtocolStreamErrorRecoverable && !(iSeek || iStopped)) {
+        iResolver->Clear();
         if (iTidal->TryReLogin(iSessionId, iSessionId) &&
-            iTidal->TryGetStreamUrl(iTrackId, iStreamUrl)) {
+            iResolver->TryGetStreamUrl(iTrackId, iStreamUrl)) {
             iUri.Replace(iStreamUrl);
         }
     }
@@ -0,0 +1,483 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Av/Tidal/Tidal.h>
+#include <OpenHome/Av/Credentials.h>
+#include <OpenHome/SocketSsl.h>
+#include <OpenHome/Configuration/ConfigManager.h>
+#include <OpenHome/Configuration/Tests/ConfigRamStore.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+
+#include "openssl/bio.h"
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/rsa.h"
+#include "openssl/x509.h"
+
+namespace OpenHome {
+namespace Av {
+namespace Test {
+
+/*
+ * Stands in for the Tidal api on the loopback adapter.  Answers streamurl requests over TLS
+ * (using a self-signed certificate - SocketSsl doesn't verify peers) so that the connection
+ * handling in Tidal::TryGetStreamUrl can be exercised and timed without the real service.
+ */
+class TidalStandIn : private INonCopyable
+{
+public:
+    enum EMode
+    {
+        eKeepAlive, // responses allow the connection to be re-used
+        eClose,     // responses carry 'Connection: close'
+        eDropIdle   // responses allow re-use but the server then drops the connection
+    };
+    static const TUint kMaxSessions = 2;
+public:
+    TidalStandIn(Environment& aEnv, TIpAddress aInterface);
+    ~TidalStandIn();
+    TUint Port() const;
+    void SetMode(EMode aMode);
+    EMode Mode() const;
+    TUint Connections() const;
+    TUint Requests() const;
+    SSL_CTX* Context();
+    void NotifyConnection();
+    void NotifyRequest();
+private:
+    static EVP_PKEY* CreateKey();
+    static X509* CreateCertificate(EVP_PKEY* aKey);
+private:
+    mutable Mutex iLock;
+    SSL_CTX* iCtx;
+    SocketTcpServer* iServer;
+    EMode iMode;
+    TUint iConnections;
+    TUint iRequests;
+};
+
+class TidalStandInSession : public SocketTcpSession
+{
+    static const TUint kMaxRequestBytes = 2 * 1024;
+public:
+    TidalStandInSession(TidalStandIn& aServer);
+private: // from SocketTcpSession
+    void Run() override;
+private:
+    void ReadRequest(SSL* aSsl);
+    void WriteResponse(SSL* aSsl, TBool aClose);
+    void FillReadBio(BIO* aBio);
+    void FlushWriteBio(BIO* aBio);
+private:
+    TidalStandIn& iServer;
+    Bws<kMaxRequestBytes> iRequest;
+    Bws<4 * 1024> iBuf;
+};
+
+} // namespace Test
+
+class SuiteTidalStreamUrl : public TestFramework::SuiteUnitTest, private ICredentialsState, private INonCopyable
+{
+    static const TUint kMeasureRequests = 10;
+public:
+    SuiteTidalStreamUrl(Environment& aEnv);
+    ~SuiteTidalStreamUrl();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from ICredentialsState
+    void SetState(const Brx& aId, const Brx& aStatus, const Brx& aData) override;
+private:
+    void GetUrl(TUint aTrackId);
+    TUint MeasureMs(Test::TidalStandIn::EMode aMode);
+private:
+    void TestKeepAliveReusesConnection();
+    void TestCloseNotReused();
+    void TestRetryAfterServerDropsConnection();
+    void TestMeasureTrackChange();
+private:
+    Environment& iEnv;
+    TIpAddress iInterface;
+    SocketSsl* iSslRef; // keeps openssl initialised for the lifetime of iServer's context
+    Configuration::ConfigRamStore* iStore;
+    Configuration::ConfigManager* iConfigManager;
+    Tidal* iTidal;
+    Test::TidalStandIn* iServer;
+};
+
+} // namespace Av
+} // namespace OpenHome
+
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Av;
+using namespace OpenHome::Av::Test;
+
+
+// TidalStandIn
+
+TidalStandIn::TidalStandIn(Environment& aEnv, TIpAddress aInterface)
+    : iLock("TSIN")
+    , iMode(eKeepAlive)
+    , iConnections(0)
+    , iRequests(0)
+{
+    iCtx = SSL_CTX_new(SSLv23_server_method());
+    ASSERT(iCtx != nullptr);
+    EVP_PKEY* key = CreateKey();
+    X509* cert = CreateCertificate(key);
+    ASSERT(1 == SSL_CTX_use_certificate(iCtx, cert));
+    ASSERT(1 == SSL_CTX_use_PrivateKey(iCtx, key));
+    X509_free(cert);  // iCtx holds its own references
+    EVP_PKEY_free(key);
+    static const unsigned char kSessionIdContext[] = "TidalStandIn";
+    (void)SSL_CTX_set_session_id_context(iCtx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+
+    iServer = new SocketTcpServer(aEnv, "TSIN", 0, aInterface);
+    for (TUint i=0; i<kMaxSessions; i++) {
+        iServer->Add("TSIS", new TidalStandInSession(*this));
+    }
+}
+
+TidalStandIn::~TidalStandIn()
+{
+    delete iServer;
+    SSL_CTX_free(iCtx);
+}
+
+TUint TidalStandIn::Port() const
+{
+    return iServer->Port();
+}
+
+void TidalStandIn::SetMode(EMode aMode)
+{
+    AutoMutex _(iLock);
+    iMode = aMode;
+}
+
+TidalStandIn::EMode TidalStandIn::Mode() const
+{
+    AutoMutex _(iLock);
+    return iMode;
+}
+
+TUint TidalStandIn::Connections() const
+{
+    AutoMutex _(iLock);
+    return iConnections;
+}
+
+TUint TidalStandIn::Requests() const
+{
+    AutoMutex _(iLock);
+    return iRequests;
+}
+
+SSL_CTX* TidalStandIn::Context()
+{
+    return iCtx;
+}
+
+void TidalStandIn::NotifyConnection()
+{
+    AutoMutex _(iLock);
+    iConnections++;
+}
+
+void TidalStandIn::NotifyRequest()
+{
+    AutoMutex _(iLock);
+    iRequests++;
+}
+
+EVP_PKEY* TidalStandIn::CreateKey()
+{ // static
+    BIGNUM* bn = BN_new();
+    ASSERT(BN_set_word(bn, RSA_F4));
+    RSA* rsa = RSA_new();
+    ASSERT(RSA_generate_key_ex(rsa, 2048, bn, nullptr) != 0);
+    BN_free(bn);
+    EVP_PKEY* key = EVP_PKEY_new();
+    ASSERT(1 == EVP_PKEY_assign_RSA(key, rsa)); // key now owns rsa
+    return key;
+}
+
+X509* TidalStandIn::CreateCertificate(EVP_PKEY* aKey)
+{ // static
+    X509* cert = X509_new();
+    (void)X509_set_version(cert, 2);
+    (void)ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    (void)X509_gmtime_adj(X509_get_notBefore(cert), 0);
+    (void)X509_gmtime_adj(X509_get_notAfter(cert), 60 * 60);
+    (void)X509_set_pubkey(cert, aKey);
+    X509_NAME* name = X509_get_subject_name(cert);
+    (void)X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+    (void)X509_set_issuer_name(cert, name);
+    ASSERT(X509_sign(cert, aKey, EVP_sha256()) != 0);
+    return cert;
+}
+
+
+// TidalStandInSession
+
+TidalStandInSession::TidalStandInSession(TidalStandIn& aServer)
+    : iServer(aServer)
+{
+}
+
+void TidalStandInSession::Run()
+{
+    iServer.NotifyConnection();
+    SSL* ssl = SSL_new(iServer.Context());
+    BIO* rbio = BIO_new(BIO_s_mem());
+    BIO* wbio = BIO_new(BIO_s_mem());
+    SSL_set_bio(ssl, rbio, wbio); // ownership of bios passes to ssl
+    SSL_set_accept_state(ssl);
+    try {
+        for (;;) {
+            const int ret = SSL_do_handshake(ssl);
+            FlushWriteBio(wbio);
+            if (ret == 1) {
+                break;
+            }
+            if (SSL_get_error(ssl, ret) != SSL_ERROR_WANT_READ) {
+                THROW(ReaderError);
+            }
+            FillReadBio(rbio);
+        }
+        for (;;) {
+            ReadRequest(ssl);
+            iServer.NotifyRequest();
+            const TidalStandIn::EMode mode = iServer.Mode();
+            WriteResponse(ssl, mode == TidalStandIn::eClose);
+            if (mode != TidalStandIn::eKeepAlive) {
+                (void)SSL_shutdown(ssl);
+                FlushWriteBio(wbio);
+                break;
+            }
+        }
+    }
+    catch (ReaderError&) {} // client closed its connection
+    catch (WriterError&) {}
+    catch (NetworkError&) {}
+    SSL_free(ssl);
+}
+
+void TidalStandInSession::ReadRequest(SSL* aSsl)
+{
+    iRequest.SetBytes(0);
+    // clients wait for a response so a request's headers always end at the end of our buffer
+    while (iRequest.Bytes() < 4 || iRequest.Split(iRequest.Bytes() - 4) != Brn("\r\n\r\n")) {
+        if (iRequest.Bytes() == iRequest.MaxBytes()) {
+            THROW(ReaderError);
+        }
+        TByte* ptr = const_cast<TByte*>(iRequest.Ptr()) + iRequest.Bytes();
+        const int bytes = SSL_read(aSsl, ptr, (int)(iRequest.MaxBytes() - iRequest.Bytes()));
+        if (bytes > 0) {
+            iRequest.SetBytes(iRequest.Bytes() + bytes);
+        }
+        else if (SSL_get_error(aSsl, bytes) == SSL_ERROR_WANT_READ) {
+            FillReadBio(SSL_get_rbio(aSsl));
+        }
+        else {
+            THROW(ReaderError);
+        }
+    }
+}
+
+void TidalStandInSession::WriteResponse(SSL* aSsl, TBool aClose)
+{
+    // request line is "GET /v1/tracks/<id>/streamurl?... HTTP/1.1"
+    Parser parser(iRequest);
+    (void)parser.Next(' ');
+    Parser path(parser.Next(' '));
+    (void)path.Next('/');
+    (void)path.Next('/');
+    (void)path.Next('/');
+    const Brn trackId = path.Next('/');
+
+    Bws<256> body("{\"url\":\"https://cdn.example.com/");
+    body.Append(trackId);
+    body.Append("\",\"trackId\":");
+    body.Append(trackId);
+    body.Append(",\"soundQuality\":\"LOSSLESS\"}");
+
+    Bws<512> response("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: ");
+    Ascii::AppendDec(response, body.Bytes());
+    response.Append("\r\n");
+    if (aClose) {
+        response.Append("Connection: close\r\n");
+    }
+    response.Append("\r\n");
+    response.Append(body);
+    if (SSL_write(aSsl, response.Ptr(), (int)response.Bytes()) != (int)response.Bytes()) {
+        THROW(WriterError);
+    }
+    FlushWriteBio(SSL_get_wbio(aSsl));
+}
+
+void TidalStandInSession::FillReadBio(BIO* aBio)
+{
+    iBuf.SetBytes(0);
+    Read(iBuf);
+    if (iBuf.Bytes() == 0) {
+        THROW(ReaderError);
+    }
+    (void)BIO_write(aBio, iBuf.Ptr(), (int)iBuf.Bytes());
+}
+
+void TidalStandInSession::FlushWriteBio(BIO* aBio)
+{
+    while (BIO_ctrl_pending(aBio) > 0) {
+        const int bytes = BIO_read(aBio, const_cast<TByte*>(iBuf.Ptr()), (int)iBuf.MaxBytes());
+        if (bytes <= 0) {
+            break;
+        }
+        iBuf.SetBytes(bytes);
+        Write(iBuf);
+    }
+}
+
+
+// SuiteTidalStreamUrl
+
+SuiteTidalStreamUrl::SuiteTidalStreamUrl(Environment& aEnv)
+    : SuiteUnitTest("Tidal stream urls (local https stand-in)")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteTidalStreamUrl::TestKeepAliveReusesConnection), "TestKeepAliveReusesConnection");
+    AddTest(MakeFunctor(*this, &SuiteTidalStreamUrl::TestCloseNotReused), "TestCloseNotReused");
+    AddTest(MakeFunctor(*this, &SuiteTidalStreamUrl::TestRetryAfterServerDropsConnection), "TestRetryAfterServerDropsConnection");
+    AddTest(MakeFunctor(*this, &SuiteTidalStreamUrl::TestMeasureTrackChange), "TestMeasureTrackChange");
+
+    std::vector<NetworkAdapter*>* ifs = Os::NetworkListAdapters(aEnv, Net::InitialisationParams::ELoopbackUse, "TestTidalStreamUrl");
+    iInterface = (*ifs)[0]->Address();
+    for (TUint i=0; i<ifs->size(); i++) {
+        (*ifs)[i]->RemoveRef("TestTidalStreamUrl");
+    }
+    delete ifs;
+    iSslRef = new SocketSsl(aEnv, 0);
+}
+
+SuiteTidalStreamUrl::~SuiteTidalStreamUrl()
+{
+    delete iSslRef;
+}
+
+void SuiteTidalStreamUrl::Setup()
+{
+    iStore = new Configuration::ConfigRamStore();
+    iConfigManager = new Configuration::ConfigManager(*iStore);
+    iTidal = new Tidal(iEnv, Brn("token"), *this, *iConfigManager);
+    iServer = new TidalStandIn(iEnv, iInterface);
+    Endpoint ep(iServer->Port(), iInterface);
+    Endpoint::AddressBuf host;
+    ep.AppendAddress(host);
+    iTidal->SetServer(host, iServer->Port());
+}
+
+void SuiteTidalStreamUrl::TearDown()
+{
+    delete iTidal; // closes any kept-alive connection, allowing iServer's sessions to exit
+    delete iServer;
+    delete iConfigManager;
+    delete iStore;
+}
+
+void SuiteTidalStreamUrl::SetState(const Brx& /*aId*/, const Brx& /*aStatus*/, const Brx& /*aData*/)
+{
+}
+
+void SuiteTidalStreamUrl::GetUrl(TUint aTrackId)
+{
+    Bws<16> trackId;
+    Ascii::AppendDec(trackId, aTrackId);
+    Bws<128> url;
+    TEST(iTidal->TryGetStreamUrl(trackId, url));
+    Bws<128> expected("https://cdn.example.com/");
+    expected.Append(trackId);
+    TEST(url == expected);
+}
+
+TUint SuiteTidalStreamUrl::MeasureMs(TidalStandIn::EMode aMode)
+{
+    iServer->SetMode(aMode);
+    GetUrl(1); // exclude the first (full) handshake from timings
+    const TUint start = Os::TimeInMs(iEnv.OsCtx());
+    for (TUint i=0; i<kMeasureRequests; i++) {
+        GetUrl(100 + i);
+    }
+    return Os::TimeInMs(iEnv.OsCtx()) - start;
+}
+
+void SuiteTidalStreamUrl::TestKeepAliveReusesConnection()
+{
+    iServer->SetMode(TidalStandIn::eKeepAlive);
+    for (TUint i=0; i<4; i++) {
+        GetUrl(1000 + i);
+    }
+    TEST(iServer->Requests() == 4);
+    TEST(iServer->Connections() == 1);
+}
+
+void SuiteTidalStreamUrl::TestCloseNotReused()
+{
+    iServer->SetMode(TidalStandIn::eClose);
+    for (TUint i=0; i<3; i++) {
+        GetUrl(2000 + i);
+    }
+    TEST(iServer->Requests() == 3);
+    TEST(iServer->Connections() == 3);
+}
+
+void SuiteTidalStreamUrl::TestRetryAfterServerDropsConnection()
+{
+    /* The server drops each connection after responding without saying it will.  Every
+       request after the first is written to a dead connection so must be retried on a
+       new one. */
+    iServer->SetMode(TidalStandIn::eDropIdle);
+    GetUrl(3000);
+    Thread::Sleep(50); // let the server's close reach us
+    GetUrl(3001);
+    GetUrl(3002);
+    TEST(iServer->Requests() == 3);
+    TEST(iServer->Connections() == 3);
+}
+
+void SuiteTidalStreamUrl::TestMeasureTrackChange()
+{
+    const SslHandshakeStats before = SocketSsl::HandshakeStats(iEnv);
+    const TUint closeMs = MeasureMs(TidalStandIn::eClose);
+    const SslHandshakeStats middle = SocketSsl::HandshakeStats(iEnv);
+    const TUint keepAliveMs = MeasureMs(TidalStandIn::eKeepAlive);
+    const SslHandshakeStats after = SocketSsl::HandshakeStats(iEnv);
+
+    Print("  %u streamurl requests, new connection each:  %ums (%u full, %u resumed handshakes)\n",
+          kMeasureRequests, closeMs,
+          middle.iFullCount - before.iFullCount, middle.iResumedCount - before.iResumedCount);
+    Print("  %u streamurl requests, kept-alive connection: %ums (%u full, %u resumed handshakes)\n",
+          kMeasureRequests, keepAliveMs,
+          after.iFullCount - middle.iFullCount, after.iResumedCount - middle.iResumedCount);
+    TEST(after.iFullCount + after.iResumedCount == middle.iFullCount + middle.iResumedCount + 1);
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    aInitParams->SetUseLoopbackNetworkAdapter();
+    Net::Library* lib = new Net::Library(aInitParams);
+    Runner runner("Tidal stream url tests\n");
+    runner.Add(new SuiteTidalStreamUrl(lib->Env()));
+    runner.Run();
+    delete lib;
+}
@@ -11,6 +11,7 @@
 #include <OpenHome/Private/Uri.h>
 #include <OpenHome/Media/Debug.h>
 #include <OpenHome/Av/Utils/FormUrl.h>
+#include <OpenHome/Json.h>
 
 #include <algorithm>
 
@@ -29,6 +30,7 @@ const Brn Tidal::kConfigKeySoundQuality("tidalhifi.com.SoundQuality");
 Tidal::Tidal(Environment& aEnv, const Brx& aToken, ICredentialsState& aCredentialsState, Configuration::IConfigInitialiser& aConfigInitialiser)
     : iLock("TDL1")
     , iLockConfig("TDL2")
+    , iLockInterrupt("TDL3")
     , iCredentialsState(aCredentialsState)
     , iSocket(aEnv, kReadBufferBytes)
     , iReaderBuf(iSocket)
@@ -36,11 +38,17 @@ Tidal::Tidal(Environment& aEnv, const Brx& aToken, ICredentialsState& aCredentia
     , iWriterBuf(iSocket)
     , iWriterRequest(iSocket)
     , iReaderResponse(aEnv, iReaderUntil)
+    , iKeepAlive(false)
+    , iInterrupted(false)
+    , iHost(kHost)
+    , iPort(kPort)
     , iToken(aToken)
     , iUsername(kGranularityUsername)
     , iPassword(kGranularityPassword)
+    , iStreamUrlCache(nullptr)
 {
     iReaderResponse.AddHeader(iHeaderContentLength);
+    iReaderResponse.AddHeader(iHeaderConnection);
     const int arr[] = {0, 1, 2};
     std::vector<TUint> qualities(arr, arr + sizeof(arr)/sizeof(arr[0]));
     iConfigQuality = new ConfigChoice(aConfigInitialiser, kConfigKeySoundQuality, qualities, 2);
@@ -78,12 +86,6 @@ TBool Tidal::TryReLogin(const Brx& aCurrentToken, Bwx& aNewToken)
 TBool Tidal::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
 {
     AutoMutex _(iLock);
-    TBool success = false;
-    if (!TryConnect(kPort)) {
-        LOG_ERROR(kMedia, "Tidal::TryGetStreamUrl - connection failure\n");
-        return false;
-    }
-    AutoSocketSsl __(iSocket);
     Bws<128> pathAndQuery("/v1/tracks/");
     pathAndQuery.Append(aTrackId);
     pathAndQuery.Append("/streamurl?sessionId=");
@@ -94,33 +96,81 @@ TBool Tidal::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
     iLockConfig.Wait();
     pathAndQuery.Append(Brn(kSoundQualities[iSoundQuality]));
     iLockConfig.Signal();
-    Brn url;
-    try {
-        WriteRequestHeaders(Http::kMethodGet, pathAndQuery, kPort);
 
-        iReaderResponse.Read();
-        const TUint code = iReaderResponse.Status().Code();
-        if (code != 200) {
-            LOG_ERROR(kPipeline, "Http error - %d - in response to Tidal GetStreamUrl.  Some/all of response is:\n", code);
-            Brn buf = iReaderUntil.Read(kReadBufferBytes);
-            LOG_ERROR(kPipeline, "%.*s\n", PBUF(buf));
-            THROW(ReaderError);
+    /* Stream urls are requested back to back as upcoming tracks are prefetched so we keep the
+       connection (and its TLS session) open between requests.  The server may have dropped an
+       idle connection so any network error on a reused connection is retried on a new one. */
+    for (TUint attempt=0; attempt<2; attempt++) {
+        TBool reused = iKeepAlive;
+        iKeepAlive = false;
+        // a socket interrupted while closed forgets this when it is re-opened
+        if (!reused && (Interrupted() || !TryConnect(iPort))) {
+            LOG_ERROR(kMedia, "Tidal::TryGetStreamUrl - connection failure\n");
+            return false;
         }
+        try {
+            WriteRequestHeaders(Http::kMethodGet, pathAndQuery, iPort, 0, true);
 
-        aStreamUrl.Replace(ReadString(iReaderUntil, Brn("url")));
-        LOG(kMedia, "Tidal::TryGetStreamUrl aStreamUrl: %.*s\n", PBUF(aStreamUrl));
-        success = true;
-    }
-    catch (HttpError&) {
-        LOG_ERROR(kPipeline, "HttpError in Tidal::TryGetStreamUrl\n");
-    }
-    catch (ReaderError&) {
-        LOG_ERROR(kPipeline, "ReaderError in Tidal::TryGetStreamUrl\n");
-    }
-    catch (WriterError&) {
-        LOG_ERROR(kPipeline, "WriterError in Tidal::TryGetStreamUrl\n");
+            iReaderResponse.Read();
+            const TUint code = iReaderResponse.Status().Code();
+            if (code != 200) {
+                LOG_ERROR(kPipeline, "Http error - %d - in response to Tidal GetStreamUrl.  Some/all of response is:\n", code);
+                Brn buf = iReaderUntil.Read(kReadBufferBytes);
+                LOG_ERROR(kPipeline, "%.*s\n", PBUF(buf));
+                iReaderUntil.ReadFlush();
+                iSocket.Close();
+                return false;
+            }
+
+            const TUint bodyBytes = iHeaderContentLength.ContentLength();
+            if (bodyBytes == 0 || bodyBytes > iResponseBody.MaxBytes()) {
+                // can't delimit the response so can't re-use this connection
+                aStreamUrl.Replace(ReadString(iReaderUntil, Brn("url")));
+                iReaderUntil.ReadFlush();
+                iSocket.Close();
+            }
+            else {
+                iResponseBody.SetBytes(0);
+                while (iResponseBody.Bytes() < bodyBytes) {
+                    iResponseBody.Append(iReaderUntil.Read(bodyBytes - iResponseBody.Bytes()));
+                }
+                JsonParser parser;
+                parser.ParseAndUnescape(iResponseBody);
+                aStreamUrl.Replace(parser.String("url"));
+                if (iHeaderConnection.Close()) {
+                    iReaderUntil.ReadFlush();
+                    iSocket.Close();
+                }
+                else {
+                    iKeepAlive = true;
+                }
+            }
+            LOG(kMedia, "Tidal::TryGetStreamUrl aStreamUrl: %.*s\n", PBUF(aStreamUrl));
+            return true;
+        }
+        catch (HttpError&) {
+            LOG_ERROR(kPipeline, "HttpError in Tidal::TryGetStreamUrl\n");
+        }
+        catch (ReaderError&) {
+            LOG_ERROR(kPipeline, "ReaderError in Tidal::TryGetStreamUrl\n");
+        }
+        catch (WriterError&) {
+            LOG_ERROR(kPipeline, "WriterError in Tidal::TryGetStreamUrl\n");
+        }
+        catch (JsonKeyNotFound&) {
+            LOG_ERROR(kPipeline, "JsonKeyNotFound in Tidal::TryGetStreamUrl\n");
+            reused = false; // a well-formed response we can't use; retrying won't help
+        }
+        catch (JsonCorrupt&) {
+            LOG_ERROR(kPipeline, "JsonCorrupt in Tidal::TryGetStreamUrl\n");
+        }
+        iReaderUntil.ReadFlush();
+        iSocket.Close();
+        if (!reused || Interrupted()) {
+            break;
+        }
     }
-    return success;
+    return false;
 }
 
 TBool Tidal::TryLogout(const Brx& aSessionId)
@@ -131,9 +181,18 @@ TBool Tidal::TryLogout(const Brx& aSessionId)
 
 void Tidal::Interrupt(TBool aInterrupt)
 {
+    iLockInterrupt.Wait();
+    iInterrupted = aInterrupt;
+    iLockInterrupt.Signal();
     iSocket.Interrupt(aInterrupt);
 }
 
+void Tidal::SetStreamUrlCache(IStreamUrlCache* aCache)
+{
+    AutoMutex _(iLockConfig);
+    iStreamUrlCache = aCache;
+}
+
 const Brx& Tidal::Id() const
 {
     return kId;
@@ -182,13 +241,22 @@ void Tidal::ReLogin(const Brx& aCurrentToken, Bwx& aNewToken)
     }
 }
 
+void Tidal::SetServer(const Brx& aHost, TUint aPort)
+{
+    AutoMutex _(iLock);
+    CloseKeepAlive();
+    iHost.Replace(aHost);
+    iPort = aPort;
+}
+
 TBool Tidal::TryConnect(TUint aPort)
 {
+    CloseKeepAlive();
     Endpoint ep;
     try {
-        ep.SetAddress(kHost);
+        ep.SetAddress(iHost);
         ep.SetPort(aPort);
-        iSocket.Connect(ep, kConnectTimeoutMs);
+        iSocket.Connect(ep, iHost, kConnectTimeoutMs);
     }
     catch (NetworkTimeout&) {
         return false;
@@ -199,6 +267,21 @@ TBool Tidal::TryConnect(TUint aPort)
     return true;
 }
 
+TBool Tidal::Interrupted() const
+{
+    AutoMutex _(iLockInterrupt);
+    return iInterrupted;
+}
+
+void Tidal::CloseKeepAlive()
+{
+    if (iKeepAlive) {
+        iKeepAlive = false;
+        iReaderUntil.ReadFlush();
+        iSocket.Close();
+    }
+}
+
 TBool Tidal::TryLoginLocked(Bwx& aSessionId)
 {
     if (!TryLoginLocked()) {
@@ -215,7 +298,7 @@ TBool Tidal::TryLoginLocked()
     Bws<80> error;
     iSessionId.SetBytes(0);
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iPort)) {
         LOG_ERROR(kPipeline, "Tidal::TryLogin - connection failure\n");
         iCredentialsState.SetState(kId, Brn("Login Error (Connection Failed): Please Try Again."), Brx::Empty());
         return false;
@@ -233,7 +316,7 @@ TBool Tidal::TryLoginLocked()
         Bws<128> pathAndQuery("/v1/login/username?token=");
         pathAndQuery.Append(iToken);
         try {
-            WriteRequestHeaders(Http::kMethodPost, pathAndQuery, kPort, reqBody.Bytes());
+            WriteRequestHeaders(Http::kMethodPost, pathAndQuery, iPort, reqBody.Bytes());
             iWriterBuf.Write(reqBody);
             iWriterBuf.WriteFlush();
 
@@ -294,7 +377,7 @@ TBool Tidal::TryLogoutLocked(const Brx& aSessionId)
         return true;
     }
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iPort)) {
         LOG_ERROR(kPipeline, "Tidal: connection failure\n");
         return false;
     }
@@ -302,7 +385,7 @@ TBool Tidal::TryLogoutLocked(const Brx& aSessionId)
     Bws<128> pathAndQuery("/v1/logout?sessionId=");
     pathAndQuery.Append(aSessionId);
     try {
-        WriteRequestHeaders(Http::kMethodPost, pathAndQuery, kPort);
+        WriteRequestHeaders(Http::kMethodPost, pathAndQuery, iPort);
 
         iReaderResponse.Read();
         const TUint code = iReaderResponse.Status().Code();
@@ -332,7 +415,7 @@ TBool Tidal::TryGetSubscriptionLocked()
     TBool updateStatus = false;
     Bws<kMaxStatusBytes> error;
     TBool success = false;
-    if (!TryConnect(kPort)) {
+    if (!TryConnect(iPort)) {
         LOG_ERROR(kMedia, "Tidal::TryGetSubscriptionLocked - connection failure\n");
         iCredentialsState.SetState(kId, Brn("Subscription Error (Connection Failed): Please Try Again."), Brx::Empty());
         return false;
@@ -345,7 +428,7 @@ TBool Tidal::TryGetSubscriptionLocked()
     pathAndQuery.Append(iSessionId);
 
     try {
-        WriteRequestHeaders(Http::kMethodGet, pathAndQuery, kPort, 0);
+        WriteRequestHeaders(Http::kMethodGet, pathAndQuery, iPort, 0);
 
         iReaderResponse.Read();
         const TUint code = iReaderResponse.Status().Code();
@@ -391,15 +474,17 @@ TBool Tidal::TryGetSubscriptionLocked()
     return success;
 }
 
-void Tidal::WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength)
+void Tidal::WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength, TBool aKeepAlive)
 {
     iWriterRequest.WriteMethod(aMethod, aPathAndQuery, Http::eHttp11);
-    Http::WriteHeaderHostAndPort(iWriterRequest, kHost, aPort);
+    Http::WriteHeaderHostAndPort(iWriterRequest, iHost, aPort);
     if (aContentLength > 0) {
         Http::WriteHeaderContentLength(iWriterRequest, aContentLength);
     }
     Http::WriteHeaderContentType(iWriterRequest, Brn("application/x-www-form-urlencoded"));
-    Http::WriteHeaderConnectionClose(iWriterRequest);
+    if (!aKeepAlive) {
+        Http::WriteHeaderConnectionClose(iWriterRequest);
+    }
     iWriterRequest.WriteFlush();
 }
 
@@ -437,5 +522,8 @@ void Tidal::QualityChanged(Configuration::KeyValuePair<TUint>& aKvp)
 {
     iLockConfig.Wait();
     iSoundQuality = std::min(aKvp.Value(), iMaxSoundQuality);
+    if (iStreamUrlCache != nullptr) {
+        iStreamUrlCache->Clear(); // cached urls are for the previous quality
+    }
     iLockConfig.Signal();
 }
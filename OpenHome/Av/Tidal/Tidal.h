@@ -1,6 +1,7 @@
 #pragma once
 
 #include <OpenHome/Av/Credentials.h>
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
 #include <OpenHome/Types.h>
 #include <OpenHome/SocketSsl.h>
 #include <OpenHome/Configuration/ConfigManager.h>
@@ -16,9 +17,10 @@ namespace Configuration {
 }
 namespace Av {
 
-class Tidal : public ICredentialConsumer
+class Tidal : public ICredentialConsumer, public IStreamUrlSource
 {
     friend class TestTidal;
+    friend class SuiteTidalStreamUrl;
     static const TUint kReadBufferBytes = 4 * 1024;
     static const TUint kWriteBufferBytes = 1024;
     static const TUint kConnectTimeoutMs = 10000; // FIXME - should read this + ProtocolNetwork's equivalent from a single client-changable location
@@ -35,9 +37,11 @@ public:
     ~Tidal();
     TBool TryLogin(Bwx& aSessionId);
     TBool TryReLogin(const Brx& aCurrentToken, Bwx& aNewToken);
-    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl);
     TBool TryLogout(const Brx& aSessionId);
-    void Interrupt(TBool aInterrupt);
+public: // from IStreamUrlSource
+    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl) override;
+    void Interrupt(TBool aInterrupt) override;
+    void SetStreamUrlCache(IStreamUrlCache* aCache) override;
 private: // from ICredentialConsumer
     const Brx& Id() const override;
     void CredentialsChanged(const Brx& aUsername, const Brx& aPassword) override;
@@ -45,18 +49,22 @@ private: // from ICredentialConsumer
     void Login(Bwx& aToken) override;
     void ReLogin(const Brx& aCurrentToken, Bwx& aNewToken) override;
 private:
+    void SetServer(const Brx& aHost, TUint aPort); // test use only
     TBool TryConnect(TUint aPort);
+    TBool Interrupted() const;
+    void CloseKeepAlive();
     TBool TryLoginLocked();
     TBool TryLoginLocked(Bwx& aSessionId);
     TBool TryLogoutLocked(const Brx& aSessionId);
     TBool TryGetSubscriptionLocked();
-    void WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength = 0);
+    void WriteRequestHeaders(const Brx& aMethod, const Brx& aPathAndQuery, TUint aPort, TUint aContentLength = 0, TBool aKeepAlive = false);
     static Brn ReadInt(ReaderUntil& aReader, const Brx& aTag);
     static Brn ReadString(ReaderUntil& aReader, const Brx& aTag);
     void QualityChanged(Configuration::KeyValuePair<TUint>& aKvp);
 private:
     Mutex iLock;
     Mutex iLockConfig;
+    mutable Mutex iLockInterrupt;
     ICredentialsState& iCredentialsState;
     SocketSsl iSocket;
     Srs<1024> iReaderBuf;
@@ -65,6 +73,12 @@ private:
     WriterHttpRequest iWriterRequest;
     ReaderHttpResponse iReaderResponse;
     HttpHeaderContentLength iHeaderContentLength;
+    HttpHeaderConnection iHeaderConnection;
+    Bws<kReadBufferBytes> iResponseBody; // requires that all network operations are serialised
+    TBool iKeepAlive;
+    TBool iInterrupted;
+    Bws<64> iHost;
+    TUint iPort;
     const Bws<32> iToken;
     WriterBwh iUsername;
     WriterBwh iPassword;
@@ -76,6 +90,7 @@ private:
     Bws<1024> iStreamUrl;
     Configuration::ConfigChoice* iConfigQuality;
     TUint iSubscriberIdQuality;
+    IStreamUrlCache* iStreamUrlCache;
 };
 
 };  // namespace Av
@@ -0,0 +1,28 @@
+#include <OpenHome/Av/TrackLookahead.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// TrackLookahead
+
+TrackLookahead::TrackLookahead()
+    : iLock("TLAH")
+{
+}
+
+void TrackLookahead::AddObserver(ITrackLookaheadObserver& aObserver)
+{
+    AutoMutex _(iLock);
+    iObservers.push_back(&aObserver);
+}
+
+void TrackLookahead::NotifyTrackUpcoming(const Brx& aUri)
+{
+    AutoMutex _(iLock);
+    for (auto it=iObservers.begin(); it!=iObservers.end(); ++it) {
+        (*it)->NotifyTrackUpcoming(aUri);
+    }
+}
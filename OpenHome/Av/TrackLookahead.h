@@ -0,0 +1,45 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Av {
+
+class ITrackLookaheadObserver
+{
+public:
+    virtual ~ITrackLookaheadObserver() {}
+    virtual void NotifyTrackUpcoming(const Brx& aUri) = 0; // aUri is only valid for the duration of this call
+};
+
+class ITrackLookahead
+{
+public:
+    virtual ~ITrackLookahead() {}
+    virtual void AddObserver(ITrackLookaheadObserver& aObserver) = 0;
+};
+
+/*
+ * Fans out hints from UriProviders about tracks that are likely to be played soon.
+ * Observers (typically protocols that have to resolve a uri before they can stream it)
+ * can use these to do slow work ahead of time.  Observers must not block.
+ */
+class TrackLookahead : public ITrackLookahead, public ITrackLookaheadObserver
+{
+public:
+    TrackLookahead();
+public: // from ITrackLookahead
+    void AddObserver(ITrackLookaheadObserver& aObserver) override;
+public: // from ITrackLookaheadObserver
+    void NotifyTrackUpcoming(const Brx& aUri) override;
+private:
+    Mutex iLock;
+    std::vector<ITrackLookaheadObserver*> iObservers;
+};
+
+} // namespace Av
+} // namespace OpenHome
@@ -46,7 +46,7 @@ DriverSongcastSender::DriverSongcastSender(IPipelineElementUpstream& aPipeline,
     , iQuit(false)
 {
     ASSERT(aMaxMsgSizeJiffies % Jiffies::kPerMs == 0);
-    iOhmSenderDriver = new OhmSenderDriver(iEnv, Optional<IOhmTimestamper>());
+    iOhmSenderDriver = new OhmSenderDriver(iEnv, Optional<IOhmTimestamper>(), Optional<ISenderActivityObserver>());
 
     Bws<64> udn("Driver-");
     udn.Append(aName);
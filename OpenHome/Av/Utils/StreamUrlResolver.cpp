@@ -0,0 +1,308 @@
+#include <OpenHome/Av/Utils/StreamUrlResolver.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Media/Debug.h>
+#include <OpenHome/OsWrapper.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Av;
+
+// StreamUrlResolver::Entry
+
+StreamUrlResolver::Entry::Entry()
+    : iTimeMs(0)
+    , iValid(false)
+{
+}
+
+void StreamUrlResolver::Entry::Set(const Brx& aTrackId, const Brx& aUrl, TUint aTimeMs)
+{
+    iTrackId.Replace(aTrackId);
+    iUrl.Replace(aUrl);
+    iTimeMs = aTimeMs;
+    iValid = true;
+}
+
+void StreamUrlResolver::Entry::Clear()
+{
+    iTrackId.SetBytes(0);
+    iUrl.SetBytes(0);
+    iValid = false;
+}
+
+TBool StreamUrlResolver::Entry::Matches(const Brx& aTrackId) const
+{
+    return iValid && iTrackId == aTrackId;
+}
+
+TBool StreamUrlResolver::Entry::IsFresh(TUint aNowMs, TUint aLifetimeMs) const
+{
+    // unsigned subtraction copes with the ms clock wrapping
+    return iValid && (aNowMs - iTimeMs) < aLifetimeMs;
+}
+
+const Brx& StreamUrlResolver::Entry::Url() const
+{
+    return iUrl;
+}
+
+TUint StreamUrlResolver::Entry::TimeMs() const
+{
+    return iTimeMs;
+}
+
+
+// StreamUrlResolver
+
+StreamUrlResolver::StreamUrlResolver(Environment& aEnv, IStreamUrlSource& aSource, TUint aUrlLifetimeMs)
+    : iEnv(aEnv)
+    , iSource(aSource)
+    , iUrlLifetimeMs(aUrlLifetimeMs)
+    , iLock("SUR1")
+    , iLockResolve("SUR2")
+    , iSem("SUR3", 0)
+    , iPendingIndex(0)
+    , iPendingCount(0)
+    , iPrefetching(false)
+    , iPrefetchInterrupted(false)
+    , iInterrupted(false)
+    , iGeneration(0)
+    , iHits(0)
+    , iMisses(0)
+    , iInterrupts(0)
+    , iQuit(false)
+{
+    iThread = new ThreadFunctor("StreamUrlResolver", MakeFunctor(*this, &StreamUrlResolver::Run), kPriorityLow);
+    iThread->Start();
+    iSource.SetStreamUrlCache(this);
+}
+
+StreamUrlResolver::~StreamUrlResolver()
+{
+    iSource.SetStreamUrlCache(nullptr);
+    iLock.Wait();
+    iQuit = true;
+    if (iPrefetching) {
+        iPrefetchInterrupted = true;
+        iSource.Interrupt(true);
+    }
+    iLock.Signal();
+    iSem.Signal();
+    delete iThread;
+}
+
+void StreamUrlResolver::Prefetch(const Brx& aTrackId)
+{
+    if (aTrackId.Bytes() == 0 || aTrackId.Bytes() > kMaxTrackIdBytes) {
+        return;
+    }
+    AutoMutex _(iLock);
+    /* Urls resolved less than half a lifetime ago will still be usable by the time the track is
+       streamed.  Older ones are refreshed so that we don't start a long track on a url that is
+       about to expire. */
+    if (FindLocked(aTrackId, iUrlLifetimeMs / 2) != nullptr) {
+        return;
+    }
+    for (TUint i=0; i<iPendingCount; i++) {
+        if (iPending[(iPendingIndex + i) % kMaxPending] == aTrackId) {
+            return;
+        }
+    }
+    if (iPendingCount == kMaxPending) {
+        // discard the oldest hint - it is least likely to still be relevant
+        iPendingIndex = (iPendingIndex + 1) % kMaxPending;
+        iPendingCount--;
+    }
+    iPending[(iPendingIndex + iPendingCount) % kMaxPending].Replace(aTrackId);
+    iPendingCount++;
+    iSem.Signal();
+}
+
+TBool StreamUrlResolver::TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl)
+{
+    {
+        AutoMutex _(iLock);
+        if (TryGetCachedLocked(aTrackId, aStreamUrl, iUrlLifetimeMs)) {
+            iHits++;
+            LOG(kMedia, "StreamUrlResolver: cache hit for %.*s\n", PBUF(aTrackId));
+            return true;
+        }
+    }
+
+    /* The prefetch thread may be part way through resolving this track.  Serialising
+       resolution means we wait for that to complete then find its result in the cache
+       rather than issuing a duplicate request.
+       A prefetch of any other track is of no use to the caller so is interrupted instead;
+       the source is un-interrupted by the prefetch thread before it releases iLockResolve
+       unless Interrupt(true) has been called in the meantime. */
+    iLock.Wait();
+    if (iPrefetching && iPrefetchTrackId != aTrackId && !iPrefetchInterrupted) {
+        LOG(kMedia, "StreamUrlResolver: interrupting prefetch of %.*s\n", PBUF(iPrefetchTrackId));
+        iPrefetchInterrupted = true;
+        iInterrupts++;
+        iSource.Interrupt(true);
+    }
+    iLock.Signal();
+
+    AutoMutex _(iLockResolve);
+    iLock.Wait();
+    const TBool cached = TryGetCachedLocked(aTrackId, aStreamUrl, iUrlLifetimeMs);
+    if (cached) {
+        iHits++;
+    }
+    else {
+        iMisses++;
+    }
+    const TUint generation = iGeneration;
+    iLock.Signal();
+    if (cached) {
+        return true;
+    }
+    LOG(kMedia, "StreamUrlResolver: cache miss for %.*s\n", PBUF(aTrackId));
+    return TryResolve(aTrackId, aStreamUrl, generation);
+}
+
+void StreamUrlResolver::Interrupt(TBool aInterrupt)
+{
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (!iPrefetchInterrupted) { // otherwise source stays interrupted until the prefetch completes
+        iSource.Interrupt(aInterrupt);
+    }
+}
+
+void StreamUrlResolver::Invalidate(const Brx& aTrackId)
+{
+    AutoMutex _(iLock);
+    for (TUint i=0; i<kMaxEntries; i++) {
+        if (iEntries[i].Matches(aTrackId)) {
+            iEntries[i].Clear();
+        }
+    }
+}
+
+void StreamUrlResolver::Clear()
+{
+    AutoMutex _(iLock);
+    for (TUint i=0; i<kMaxEntries; i++) {
+        iEntries[i].Clear();
+    }
+    iPendingCount = 0;
+    iGeneration++;
+}
+
+TUint StreamUrlResolver::CacheHits() const
+{
+    AutoMutex _(iLock);
+    return iHits;
+}
+
+TUint StreamUrlResolver::CacheMisses() const
+{
+    AutoMutex _(iLock);
+    return iMisses;
+}
+
+TUint StreamUrlResolver::PrefetchesInterrupted() const
+{
+    AutoMutex _(iLock);
+    return iInterrupts;
+}
+
+void StreamUrlResolver::Run()
+{
+    for (;;) {
+        iSem.Wait();
+        {
+            AutoMutex _(iLock);
+            if (iQuit) {
+                break;
+            }
+            if (iPendingCount == 0) {
+                continue; // pending list was cleared after we were signalled
+            }
+            iPrefetchTrackId.Replace(iPending[iPendingIndex]);
+            iPendingIndex = (iPendingIndex + 1) % kMaxPending;
+            iPendingCount--;
+        }
+
+        AutoMutex _(iLockResolve);
+        iLock.Wait();
+        const TBool fresh = (FindLocked(iPrefetchTrackId, iUrlLifetimeMs / 2) != nullptr);
+        iPrefetching = !fresh;
+        const TUint generation = iGeneration;
+        iLock.Signal();
+        if (!fresh) {
+            LOG(kMedia, "StreamUrlResolver: prefetching %.*s\n", PBUF(iPrefetchTrackId));
+            (void)TryResolve(iPrefetchTrackId, iPrefetchUrl, generation);
+            AutoMutex __(iLock);
+            iPrefetching = false;
+            if (iPrefetchInterrupted) {
+                iPrefetchInterrupted = false;
+                if (!iInterrupted) {
+                    iSource.Interrupt(false);
+                }
+            }
+        }
+    }
+}
+
+const StreamUrlResolver::Entry* StreamUrlResolver::FindLocked(const Brx& aTrackId, TUint aLifetimeMs) const
+{
+    const TUint now = NowMs();
+    for (TUint i=0; i<kMaxEntries; i++) {
+        if (iEntries[i].Matches(aTrackId) && iEntries[i].IsFresh(now, aLifetimeMs)) {
+            return &iEntries[i];
+        }
+    }
+    return nullptr;
+}
+
+TBool StreamUrlResolver::TryGetCachedLocked(const Brx& aTrackId, Bwx& aStreamUrl, TUint aLifetimeMs) const
+{
+    const Entry* entry = FindLocked(aTrackId, aLifetimeMs);
+    if (entry == nullptr) {
+        return false;
+    }
+    aStreamUrl.Replace(entry->Url());
+    return true;
+}
+
+void StreamUrlResolver::StoreLocked(const Brx& aTrackId, const Brx& aStreamUrl)
+{
+    const TUint now = NowMs();
+    TUint index = 0;
+    TUint oldestAge = 0;
+    for (TUint i=0; i<kMaxEntries; i++) {
+        if (iEntries[i].Matches(aTrackId) || !iEntries[i].IsFresh(now, iUrlLifetimeMs)) {
+            index = i;
+            break;
+        }
+        const TUint age = now - iEntries[i].TimeMs();
+        if (age > oldestAge) {
+            oldestAge = age;
+            index = i;
+        }
+    }
+    iEntries[index].Set(aTrackId, aStreamUrl, now);
+}
+
+TBool StreamUrlResolver::TryResolve(const Brx& aTrackId, Bwx& aStreamUrl, TUint aGeneration)
+{ // called with iLockResolve held
+    if (!iSource.TryGetStreamUrl(aTrackId, aStreamUrl)) {
+        return false;
+    }
+    AutoMutex _(iLock);
+    if (aStreamUrl.Bytes() <= kMaxUrlBytes && aGeneration == iGeneration) {
+        StoreLocked(aTrackId, aStreamUrl);
+    }
+    return true;
+}
+
+TUint StreamUrlResolver::NowMs() const
+{
+    return Os::TimeInMs(iEnv.OsCtx());
+}
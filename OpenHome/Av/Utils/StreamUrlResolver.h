@@ -0,0 +1,104 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+
+namespace OpenHome {
+    class Environment;
+namespace Av {
+
+class IStreamUrlCache
+{
+public:
+    virtual ~IStreamUrlCache() {}
+    virtual void Clear() = 0;
+};
+
+class IStreamUrlSource
+{
+public:
+    virtual ~IStreamUrlSource() {}
+    virtual TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl) = 0;
+    virtual void Interrupt(TBool aInterrupt) = 0;
+    virtual void SetStreamUrlCache(IStreamUrlCache* aCache) = 0; // aCache should be cleared if a setting that affects urls (e.g. sound quality) changes
+};
+
+/*
+ * Resolves streaming service track ids to (short-lived) stream urls.
+ * Prefetch() queues a track for resolution on a background thread; a later call to
+ * TryGetStreamUrl() for the same track is then satisfied from the cache rather than
+ * waiting on a service round trip.  Urls are discarded once aUrlLifetimeMs has passed.
+ * A cache miss interrupts any prefetch of a different track rather than queueing behind it.
+ * Clients must interrupt the source via Interrupt() rather than directly so that the end of
+ * an interrupted prefetch doesn't clear an interrupt the client set.
+ */
+class StreamUrlResolver : public IStreamUrlCache, private INonCopyable
+{
+    static const TUint kMaxTrackIdBytes = 32;
+    static const TUint kMaxUrlBytes = 1024;
+    static const TUint kMaxEntries = 4;
+    static const TUint kMaxPending = 4;
+public:
+    StreamUrlResolver(Environment& aEnv, IStreamUrlSource& aSource, TUint aUrlLifetimeMs);
+    ~StreamUrlResolver();
+    void Prefetch(const Brx& aTrackId); // non-blocking
+    TBool TryGetStreamUrl(const Brx& aTrackId, Bwx& aStreamUrl); // blocks for a service round trip on cache miss
+    void Interrupt(TBool aInterrupt); // forwarded to the source
+    void Invalidate(const Brx& aTrackId);
+    TUint CacheHits() const;
+    TUint CacheMisses() const;
+    TUint PrefetchesInterrupted() const;
+public: // from IStreamUrlCache
+    void Clear() override;
+private:
+    class Entry
+    {
+    public:
+        Entry();
+        void Set(const Brx& aTrackId, const Brx& aUrl, TUint aTimeMs);
+        void Clear();
+        TBool Matches(const Brx& aTrackId) const;
+        TBool IsFresh(TUint aNowMs, TUint aLifetimeMs) const;
+        const Brx& Url() const;
+        TUint TimeMs() const;
+    private:
+        Bws<kMaxTrackIdBytes> iTrackId;
+        Bws<kMaxUrlBytes> iUrl;
+        TUint iTimeMs;
+        TBool iValid;
+    };
+private:
+    void Run();
+    const Entry* FindLocked(const Brx& aTrackId, TUint aLifetimeMs) const;
+    TBool TryGetCachedLocked(const Brx& aTrackId, Bwx& aStreamUrl, TUint aLifetimeMs) const;
+    void StoreLocked(const Brx& aTrackId, const Brx& aStreamUrl);
+    TBool TryResolve(const Brx& aTrackId, Bwx& aStreamUrl, TUint aGeneration);
+    TUint NowMs() const;
+private:
+    Environment& iEnv;
+    IStreamUrlSource& iSource;
+    const TUint iUrlLifetimeMs;
+    mutable Mutex iLock;
+    Mutex iLockResolve;
+    Semaphore iSem;
+    ThreadFunctor* iThread;
+    Entry iEntries[kMaxEntries];
+    Bws<kMaxTrackIdBytes> iPending[kMaxPending];
+    TUint iPendingIndex;
+    TUint iPendingCount;
+    Bws<kMaxTrackIdBytes> iPrefetchTrackId;
+    Bws<kMaxUrlBytes> iPrefetchUrl;
+    TBool iPrefetching;
+    TBool iPrefetchInterrupted;
+    TBool iInterrupted; // as set by Interrupt()
+    TUint iGeneration; // incremented by Clear() so that in-flight lookups aren't cached
+    TUint iHits;
+    TUint iMisses;
+    TUint iInterrupts;
+    TBool iQuit;
+};
+
+} // namespace Av
+} // namespace OpenHome
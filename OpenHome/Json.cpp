@@ -7,8 +7,11 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/Stream.h>
 
-#include <map>
 #include <vector>
+#include <string.h>
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#endif
 
 using namespace OpenHome;
 
@@ -137,199 +140,360 @@ void Json::Unescape(Bwx& aValue)
 }
 
 
-// JsonParser
+// JsonTape
 
-const Brn JsonParser::kBoolValTrue("true");
-const Brn JsonParser::kBoolValFalse("false");
+static const Brn kLiteralTrue("true");
+static const Brn kLiteralFalse("false");
+static const Brn kLiteralNull("null");
 
-JsonParser::JsonParser()
+const TUint JsonTape::kEnd;
+const TUint JsonTape::kMaxDepth;
+
+JsonTape::JsonTape()
 {
 }
 
-void JsonParser::Reset()
+void JsonTape::Parse(const Brx& aJson)
 {
-    iPairs.clear();
+    Parse(aJson, false);
 }
 
-inline void JsonParser::Add(const Brn& aKey, const TByte* aValStart, TUint aValBytes)
+void JsonTape::ParseAndUnescape(Bwx& aJson)
 {
-    Brn val(aValStart, aValBytes);
-//    Log::Print("Add %.*s, %.*s\n", PBUF(aKey), PBUF(val));
-    iPairs.insert(std::pair<Brn, Brn>(aKey, val));
+    Parse(aJson, true);
 }
 
-void JsonParser::Parse(const Brx& aJson)
+void JsonTape::Reset()
 {
-    Parse(aJson, false);
+    iEntries.clear(); // retains capacity
 }
 
-void JsonParser::ParseAndUnescape(Bwx& aJson)
+TUint JsonTape::Count() const
 {
-    Parse(aJson, true);
+    return (TUint)iEntries.size();
 }
 
-void JsonParser::Parse(const Brx& aJson, TBool aUnescapeInPlace)
+JsonTape::ValType JsonTape::Type(TUint aIndex) const
 {
-    Reset();
+    ASSERT(aIndex < iEntries.size());
+    return iEntries[aIndex].iType;
+}
 
-    Brn json = Ascii::Trim(aJson);
-    if (json.Bytes() == 0 || json == WriterJson::kNull) {
-        return;
+Brn JsonTape::Key(TUint aIndex) const
+{
+    ASSERT(aIndex < iEntries.size());
+    const Entry& entry = iEntries[aIndex];
+    return Brn(entry.iKey, entry.iKeyBytes);
+}
+
+Brn JsonTape::Value(TUint aIndex) const
+{
+    ASSERT(aIndex < iEntries.size());
+    const Entry& entry = iEntries[aIndex];
+    return Brn(entry.iVal, entry.iValBytes);
+}
+
+TUint JsonTape::FirstChild(TUint aIndex) const
+{
+    ASSERT(aIndex < iEntries.size());
+    const Entry& entry = iEntries[aIndex];
+    if (entry.iType != ValType::Object && entry.iType != ValType::Array) {
+        return kEnd;
     }
-    const TByte* ptr = json.Ptr();
-    const TByte* end = ptr + json.Bytes();
-
-    enum ParseState {
-        DocStart,
-        KeyStart,
-        KeyEnd,
-        ValueStart,
-        NumEnd,
-        StringEnd,
-        ArrayEnd,
-        ObjectEnd,
-        MiscEnd,
-        Complete
-    } state;
-    state = DocStart;
-    const TByte* keyStart = nullptr;
-    const TByte* valStart = nullptr;
+    // children directly follow their parent; an empty container is followed by a value outside it
+    const TUint child = aIndex + 1;
+    if (child == iEntries.size() || iEntries[child].iVal >= entry.iVal + entry.iValBytes) {
+        return kEnd;
+    }
+    return child;
+}
+
+TUint JsonTape::NextSibling(TUint aIndex) const
+{
+    ASSERT(aIndex < iEntries.size());
+    return iEntries[aIndex].iNext;
+}
+
+TUint JsonTape::Find(TUint aObject, const Brx& aKey) const
+{
+    const TUint bytes = aKey.Bytes();
+    for (TUint i=FirstChild(aObject); i!=kEnd; i=iEntries[i].iNext) {
+        const Entry& entry = iEntries[i];
+        if (entry.iKeyBytes == bytes && memcmp(entry.iKey, aKey.Ptr(), bytes) == 0) {
+            return i;
+        }
+    }
+    return kEnd;
+}
+
+void JsonTape::Parse(const Brx& aJson, TBool aUnescapeInPlace)
+{
+    Reset();
+
+    class Level
+    {
+    public:
+        TUint iContainer;
+        TUint iLastChild;
+    };
+    Level levels[kMaxDepth];
+    TUint depth = 0;
+    const TByte* ptr = aJson.Ptr();
+    const TByte* end = ptr + aJson.Bytes();
     Brn key;
-    TUint nestCount = 0;
-    TBool escapeChar = false;
-    TUint skipCount = 0;
 
-    while (state != Complete && ptr < end) {
-        TChar ch = (TChar)*ptr++;
-        if (Ascii::IsWhitespace(ch)) {
-            ++skipCount;
-            continue;
+    for (;;) {
+        // read a value (whose key, if any, has already been read)
+        ptr = SkipWhitespace(ptr, end);
+        if (ptr == end) {
+            THROW(JsonCorrupt);
         }
-        switch (state)
+        const TByte* valStart = ptr;
+        TUint valBytes = 0;
+        ValType type;
+        switch (*ptr)
         {
-        case DocStart:
-            if (ch == '{') {
-                state = KeyStart;
-            }
+        case '{':
+            type = ValType::Object;
+            ptr++;
             break;
-        case KeyStart:
-            switch (ch)
-            {
-            case '\"':
-                keyStart = ptr;
-                state = KeyEnd;
-                break;
-            case '}':
-                state = Complete;
-                break;
-            default:
-                if (ch != ',') {
-                    THROW(JsonCorrupt);
-                }
-                break;
-            }
+        case '[':
+            type = ValType::Array;
+            ptr++;
             break;
-        case KeyEnd:
-            if (ch == '\"') {
-                key.Set(keyStart, ptr - keyStart - 1);
-                state = ValueStart;
+        case '\"':
+        {
+            type = ValType::String;
+            valStart = ptr + 1;
+            ptr = StringEnd(valStart, end);
+            valBytes = (TUint)(ptr - valStart);
+            ptr++;
+            /* Unescaping shortens a string without moving the bytes that follow it so would
+               corrupt the text of any container it was nested in. */
+            if (aUnescapeInPlace && depth <= 1) {
+                Bwn buf(valStart, valBytes, valBytes);
+                Json::Unescape(buf);
+                valBytes = buf.Bytes();
             }
+        }
             break;
-        case ValueStart:
-            skipCount = 0;
-            if (ch != ':') {
-                if (ch == '\"') {
-                    valStart = ptr;
-                    state = StringEnd;
-                }
-                else {
-                    valStart = ptr - 1;
-                    if (ch == '[') {
-                        state = ArrayEnd;
-                        nestCount = 1;
-                    }
-                    else if (ch == '{') {
-                        state = ObjectEnd;
-                        nestCount = 1;
-                    }
-                    else if (ch == '-' || Ascii::IsDigit(ch)) {
-                        // FIXME - no support for frac or exp
-                        state = NumEnd;
-                    }
-                    else {
-                        state = MiscEnd;
-                    }
-                }
-            }
+        case 't':
+            type = ValType::Bool;
+            ptr = LiteralEnd(ptr, end, kLiteralTrue);
+            valBytes = kLiteralTrue.Bytes();
             break;
-        case NumEnd:
-        case MiscEnd:
-            if (ch == ',') {
-                Add(key, valStart, ptr - valStart - 1 - skipCount);
-                state = KeyStart;
-            }
-            else if (ch == '}') {
-                if (nestCount != 0) {
-                    THROW(JsonUnsupported);
-                }
-                Add(key, valStart, ptr - valStart - 1 - skipCount);
-                state = Complete;
+        case 'f':
+            type = ValType::Bool;
+            ptr = LiteralEnd(ptr, end, kLiteralFalse);
+            valBytes = kLiteralFalse.Bytes();
+            break;
+        case 'n':
+            type = ValType::Null;
+            ptr = LiteralEnd(ptr, end, kLiteralNull);
+            valBytes = kLiteralNull.Bytes();
+            break;
+        default:
+            if (*ptr != '-' && !Ascii::IsDigit(*ptr)) {
+                THROW(JsonCorrupt);
             }
+            type = ValType::Number;
+            ptr = NumberEnd(ptr, end);
+            valBytes = (TUint)(ptr - valStart);
             break;
-        case StringEnd:
-            if (ch == '\\') {
-                escapeChar = !escapeChar;
+        }
+
+        const TUint index = Append(type, key, valStart, valBytes);
+        if (depth > 0) {
+            Level& parent = levels[depth-1];
+            if (parent.iLastChild != kEnd) {
+                iEntries[parent.iLastChild].iNext = index;
+            }
+            parent.iLastChild = index;
+        }
+        if (type == ValType::Object || type == ValType::Array) {
+            if (depth == kMaxDepth) {
+                THROW(JsonUnsupported);
             }
-            else if (ch == '\"') {
-                if (!escapeChar) {
-                    const TUint bytes = ptr - valStart - 1;
-                    if (!aUnescapeInPlace) {
-                        Add(key, valStart, bytes);
-                    }
-                    else {
-                        Bwn buf(valStart, bytes, bytes);
-                        Json::Unescape(buf);
-                        Add(key, buf.Ptr(), buf.Bytes());
-                    }
-                    state = KeyStart;
+            levels[depth].iContainer = index;
+            levels[depth].iLastChild = kEnd;
+            depth++;
+            ptr = SkipWhitespace(ptr, end);
+            const TByte close = (type == ValType::Object? '}' : ']');
+            if (ptr == end || *ptr != close) {
+                if (type == ValType::Object) {
+                    ptr = ReadKey(ptr, end, key);
                 }
-                escapeChar = false;
+                else {
+                    key.Set(Brx::Empty());
+                }
+                continue;
             }
-            else {
-                escapeChar = false;
+            // empty container - closed below
+        }
+
+        // close any containers that end after this value
+        for (;;) {
+            if (depth == 0) {
+                return; // anything following the root value is ignored
             }
-            break;
-        case ArrayEnd:
-            if (ch == '[') {
-                nestCount++;
+            ptr = SkipWhitespace(ptr, end);
+            if (ptr == end) {
+                THROW(JsonCorrupt);
             }
-            else if (ch == ']') {
-                nestCount--;
-                if (nestCount == 0) {
-                    Add(key, valStart, ptr - valStart);
-                    state = KeyStart;
-                }
+            Entry& container = iEntries[levels[depth-1].iContainer];
+            if (*ptr == ',') {
+                ptr++;
+                break;
             }
-            break;
-        case ObjectEnd:
-            if (ch == '{') {
-                nestCount++;
+            const TByte close = (container.iType == ValType::Object? '}' : ']');
+            if (*ptr != close) {
+                THROW(JsonCorrupt);
             }
-            else if (ch == '}') {
-                nestCount--;
-                if (nestCount == 0) {
-                    Add(key, valStart, ptr - valStart);
-                    state = KeyStart;
-                }
+            ptr++;
+            container.iValBytes = (TUint)(ptr - container.iVal);
+            depth--;
+        }
+        if (iEntries[levels[depth-1].iContainer].iType == ValType::Object) {
+            ptr = ReadKey(ptr, end, key);
+        }
+        else {
+            key.Set(Brx::Empty());
+        }
+    }
+}
+
+TUint JsonTape::Append(ValType aType, const Brx& aKey, const TByte* aVal, TUint aValBytes)
+{
+    Entry entry;
+    entry.iKey = aKey.Ptr();
+    entry.iVal = aVal;
+    entry.iKeyBytes = aKey.Bytes();
+    entry.iValBytes = aValBytes;
+    entry.iNext = kEnd;
+    entry.iType = aType;
+    iEntries.push_back(entry);
+    return (TUint)iEntries.size() - 1;
+}
+
+const TByte* JsonTape::SkipWhitespace(const TByte* aPtr, const TByte* aEnd)
+{
+    while (aPtr < aEnd && (*aPtr == ' ' || *aPtr == '\n' || *aPtr == '\r' || *aPtr == '\t')) {
+        aPtr++;
+    }
+    return aPtr;
+}
+
+const TByte* JsonTape::StringEnd(const TByte* aPtr, const TByte* aEnd)
+{ // aPtr is the first byte following an opening quote.  Returns the closing quote.
+#if defined(__SSE2__)
+    /* Strings (urls, titles, descriptions) make up most of a typical service response.
+       Check 16 bytes at a time for anything that might end one. */
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+#endif
+    while (aPtr < aEnd) {
+#if defined(__SSE2__)
+        if (aEnd - aPtr >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aPtr));
+            const TUint mask = (TUint)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote),
+                                                                     _mm_cmpeq_epi8(block, backslash)));
+            if (mask == 0) {
+                aPtr += 16;
+                continue;
             }
+            aPtr += __builtin_ctz(mask);
+        }
+#endif
+        if (*aPtr == '\"') {
+            return aPtr;
+        }
+        if (*aPtr == '\\' && ++aPtr == aEnd) {
             break;
-        default:
-            ASSERTS();
         }
+        aPtr++;
+    }
+    THROW(JsonCorrupt);
+}
 
+const TByte* JsonTape::NumberEnd(const TByte* aPtr, const TByte* aEnd)
+{
+    while (aPtr < aEnd) {
+        const TByte ch = *aPtr;
+        if (!Ascii::IsDigit(ch) && ch != '-' && ch != '+' && ch != '.' && ch != 'e' && ch != 'E') {
+            break;
+        }
+        aPtr++;
+    }
+    return aPtr;
+}
+
+const TByte* JsonTape::LiteralEnd(const TByte* aPtr, const TByte* aEnd, const Brx& aLiteral)
+{
+    const TUint bytes = aLiteral.Bytes();
+    if ((TUint)(aEnd - aPtr) < bytes || memcmp(aPtr, aLiteral.Ptr(), bytes) != 0) {
+        THROW(JsonCorrupt);
     }
+    return aPtr + bytes;
+}
+
+const TByte* JsonTape::ReadKey(const TByte* aPtr, const TByte* aEnd, Brn& aKey)
+{
+    aPtr = SkipWhitespace(aPtr, aEnd);
+    if (aPtr == aEnd || *aPtr != '\"') {
+        THROW(JsonCorrupt);
+    }
+    const TByte* keyStart = aPtr + 1;
+    aPtr = StringEnd(keyStart, aEnd);
+    aKey.Set(keyStart, (TUint)(aPtr - keyStart));
+    aPtr = SkipWhitespace(aPtr + 1, aEnd);
+    if (aPtr == aEnd || *aPtr != ':') {
+        THROW(JsonCorrupt);
+    }
+    return aPtr + 1;
+}
+
+
+// JsonParser
 
-    if (state != Complete) {
+const Brn JsonParser::kBoolValTrue("true");
+const Brn JsonParser::kBoolValFalse("false");
+
+JsonParser::JsonParser()
+{
+}
+
+void JsonParser::Reset()
+{
+    iTape.Reset();
+}
+
+void JsonParser::Parse(const Brx& aJson)
+{
+    Parse(aJson, false);
+}
+
+void JsonParser::ParseAndUnescape(Bwx& aJson)
+{
+    Parse(aJson, true);
+}
+
+void JsonParser::Parse(const Brx& aJson, TBool aUnescapeInPlace)
+{
+    Reset();
+
+    Brn json = Ascii::Trim(aJson);
+    if (json.Bytes() == 0 || json == WriterJson::kNull) {
+        return;
+    }
+    if (aUnescapeInPlace) {
+        Bwn buf(json.Ptr(), json.Bytes(), json.Bytes());
+        iTape.ParseAndUnescape(buf);
+    }
+    else {
+        iTape.Parse(json);
+    }
+    if (iTape.Type(0) != JsonTape::ValType::Object) {
+        iTape.Reset();
         THROW(JsonCorrupt);
     }
 }
@@ -342,9 +506,7 @@ TBool JsonParser::HasKey(const TChar* aKey) const
 
 TBool JsonParser::HasKey(const Brx& aKey) const
 {
-    Brn key(aKey);
-    const auto it = iPairs.find(key);
-    return it != iPairs.end();
+    return iTape.Count() > 0 && iTape.Find(0, aKey) != JsonTape::kEnd;
 }
 
 Brn JsonParser::String(const TChar* aKey) const
@@ -430,23 +592,29 @@ TBool JsonParser::IsNull(const Brx& aKey) const
 
 void JsonParser::GetKeys(std::vector<Brn>& aKeys) const
 {
-    aKeys.reserve(iPairs.size());
-    for (auto it=iPairs.begin(); it!=iPairs.end(); ++it) {
-        aKeys.push_back(it->first);
+    if (iTape.Count() == 0) {
+        return;
+    }
+    for (TUint i=iTape.FirstChild(0); i!=JsonTape::kEnd; i=iTape.NextSibling(i)) {
+        aKeys.push_back(iTape.Key(i));
     }
 }
 
+const JsonTape& JsonParser::Tape() const
+{
+    return iTape;
+}
+
 Brn JsonParser::Value(const Brx& aKey) const
 {
-    Brn key(aKey);
-    const auto it = iPairs.find(key);
-    if (it == iPairs.end()) {
+    const TUint index = (iTape.Count() == 0? JsonTape::kEnd : iTape.Find(0, aKey));
+    if (index == JsonTape::kEnd) {
         THROW(JsonKeyNotFound);
     }
-    if (it->second == WriterJson::kNull) {
+    if (iTape.Type(index) == JsonTape::ValType::Null) {
         THROW(JsonValueNull);
     }
-    return it->second;
+    return iTape.Value(index);
 }
 
 
@@ -5,7 +5,6 @@
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Stream.h>
 
-#include <map>
 #include <vector>
 
 EXCEPTION(JsonInvalid);
@@ -36,9 +35,60 @@ public:
 };
 
 /*
-    FIXME - limited support for objects
-            limited support for arrays
+    Single pass index ("tape") of a JSON document.
+    Each value is recorded once, in document order, as a reference to its bytes in the
+    source buffer; containers also record where their next sibling starts so nested
+    content can be stepped over without re-scanning it.  Values are only converted when
+    a caller asks for them.
+    Entries are kept between calls to Parse() so a tape that is reused stops allocating
+    once it has seen its largest document.
 */
+class JsonTape
+{
+public:
+    enum class ValType : TByte
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Object,
+        Array
+    };
+    static const TUint kEnd = 0xffffffff; // returned by FirstChild, NextSibling and Find when there is no such value
+    static const TUint kMaxDepth = 64;
+public:
+    JsonTape();
+    void Parse(const Brx& aJson); // throws JsonCorrupt
+    void ParseAndUnescape(Bwx& aJson); // as Parse, with the root's string members unescaped in place.  Nested containers are left escaped so their Value() can be parsed again
+    void Reset();
+    TUint Count() const; // 0 if no document has been parsed; otherwise the root is at index 0
+    ValType Type(TUint aIndex) const;
+    Brn Key(TUint aIndex) const; // empty for the root and for array members
+    Brn Value(TUint aIndex) const; // strings exclude their quotes, objects and arrays include their brackets
+    TUint FirstChild(TUint aIndex) const;
+    TUint NextSibling(TUint aIndex) const;
+    TUint Find(TUint aObject, const Brx& aKey) const;
+private:
+    void Parse(const Brx& aJson, TBool aUnescapeInPlace);
+    TUint Append(ValType aType, const Brx& aKey, const TByte* aVal, TUint aValBytes);
+    static const TByte* SkipWhitespace(const TByte* aPtr, const TByte* aEnd);
+    static const TByte* StringEnd(const TByte* aPtr, const TByte* aEnd);
+    static const TByte* NumberEnd(const TByte* aPtr, const TByte* aEnd);
+    static const TByte* LiteralEnd(const TByte* aPtr, const TByte* aEnd, const Brx& aLiteral);
+    static const TByte* ReadKey(const TByte* aPtr, const TByte* aEnd, Brn& aKey);
+private:
+    struct Entry
+    {
+        const TByte* iKey;
+        const TByte* iVal;
+        TUint iKeyBytes;
+        TUint iValBytes;
+        TUint iNext;
+        ValType iType;
+    };
+    std::vector<Entry> iEntries;
+};
 
 // FIXME - assumes all JSON must be contained within an object.
 class JsonParser
@@ -63,12 +113,12 @@ public:
     TBool IsNull(const TChar* aKey) const;
     TBool IsNull(const Brx& aKey) const;
     void GetKeys(std::vector<Brn>& aKeys) const;
+    const JsonTape& Tape() const; // allows nested values to be read without parsing them again
 private:
     void Parse(const Brx& aJson, TBool aUnescapeInPlace);
-    inline void Add(const Brn& aKey, const TByte* aValStart, TUint aValBytes);
     Brn Value(const Brx& aKey) const;
 private:
-    std::map<Brn, Brn, BufferCmp> iPairs;
+    JsonTape iTape;
 };
 
 class JsonParserArray
@@ -37,6 +37,14 @@ void ContainerBase::Construct(IMsgAudioEncodedCache& aCache, MsgFactory& aMsgFac
     iStopper = &aContainerStopper;
 }
 
+void ContainerBase::Skip(TUint aBytes, TUint64 aEndPos)
+{
+    if (aBytes >= kSkipSeekThresholdBytes && iSeekHandler->TrySkipTo(aEndPos)) {
+        return;
+    }
+    iCache->Discard(aBytes);
+}
+
 
 // MsgAudioEncodedCache
 
@@ -442,7 +450,11 @@ ContainerController::ContainerController(MsgFactory& aMsgFactory, IPipelineEleme
     , iRecogIdx(0)
     , iStreamEnded(false)
     , iStreamId(IPipelineIdProvider::kStreamIdInvalid)
+    , iStreamBytes(0)
+    , iStreamSeekable(false)
+    , iStreamLive(false)
     , iExpectedFlushId(MsgFlush::kIdInvalid)
+    , iSkipFlushId(MsgFlush::kIdInvalid)
     , iLock("COCO")
 {
     IPipelineElementUpstream* upstream = &iRewinder;
@@ -713,7 +725,10 @@ Msg* ContainerController::ProcessMsg(MsgEncodedStream* aMsg)
 
     AutoMutex a(iLock);
     iStreamId = aMsg->StreamId();
+    iStreamSeekable = aMsg->Seekable();
+    iStreamLive = aMsg->Live();
     iExpectedFlushId = MsgFlush::kIdInvalid;
+    iSkipFlushId = MsgFlush::kIdInvalid;
     iStreamHandler.store(aMsg->StreamHandler());
     aMsg->RemoveRef();
 
@@ -762,6 +777,12 @@ Msg* ContainerController::ProcessMsg(MsgFlush* aMsg)
     if (iExpectedFlushId == aMsg->Id()) {
         iExpectedFlushId = MsgFlush::kIdInvalid;
     }
+    if (iSkipFlushId == aMsg->Id()) {
+        // Result of a container skipping data; of no interest downstream.
+        iSkipFlushId = MsgFlush::kIdInvalid;
+        aMsg->RemoveRef();
+        return nullptr;
+    }
     return aMsg;
 }
 
@@ -866,6 +887,27 @@ TBool ContainerController::TrySeekTo(TUint aStreamId, TUint64 aBytePos)
     return true;
 }
 
+TBool ContainerController::TrySkipTo(TUint64 aBytePos)
+{
+    // Called from a ContainerBase during Pull(), so iLock is not already held.
+    AutoMutex a(iLock);
+    if (!iStreamSeekable || iStreamLive) {
+        // Caller falls back to discarding; a live or non-seekable stream can't jump forward.
+        return false;
+    }
+    auto streamHandler = iStreamHandler.load();
+    ASSERT(streamHandler != nullptr);
+    LOG(kMedia, "ContainerController::TrySkipTo iStreamId: %u, aBytePos: %llu\n", iStreamId, aBytePos);
+    const TUint flushId = streamHandler->TrySeek(iStreamId, aBytePos);
+    if (flushId == MsgFlush::kIdInvalid) {
+        return false;
+    }
+    iExpectedFlushId = flushId;
+    iSkipFlushId = flushId;
+    iCache->SetFlushing(iExpectedFlushId);
+    return true;
+}
+
 TBool ContainerController::TryGetUrl(IWriter& aWriter, TUint64 aOffset, TUint aBytes)
 {
     return iUrlBlockWriter.TryGet(aWriter, iUrl, aOffset, aBytes);
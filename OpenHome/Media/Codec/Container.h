@@ -51,6 +51,13 @@ class IContainerSeekHandler
 {
 public:
     virtual TBool TrySeekTo(TUint aStreamId, TUint64 aBytePos) = 0;
+    /**
+     * Seek forward within the current stream from a container's Pull(), in place of
+     * discarding data up to aBytePos.  The resulting flush is consumed by the container
+     * layer rather than being passed downstream.
+     * Returns false if the stream is not seekable.
+     */
+    virtual TBool TrySkipTo(TUint64 aBytePos) = 0;
     virtual ~IContainerSeekHandler() {}
 };
 
@@ -75,6 +82,7 @@ class ContainerBase : public IPipelineElementUpstream, private INonCopyable
     friend class ContainerController;
 private:
     static const TUint kMaxNameBytes = 4;
+    static const TUint kSkipSeekThresholdBytes = 128 * 1024;
 protected:
     ContainerBase(const Brx& aId);
 public:
@@ -86,6 +94,11 @@ public:
     const Brx& Id() const;
 protected:
     virtual void Construct(IMsgAudioEncodedCache& aCache, MsgFactory& aMsgFactory, IContainerSeekHandler& aSeekHandler, IContainerUrlBlockWriter& aUrlBlockWriter, IContainerStopper& aContainerStopper);
+    /**
+     * Skip the next aBytes of the stream, which end at stream offset aEndPos.
+     * Large skips seek upstream where the stream allows it; others are discarded by iCache.
+     */
+    void Skip(TUint aBytes, TUint64 aEndPos);
 public: // from IPipelineElementUpstream
     Msg* Pull() = 0;
 protected:
@@ -213,6 +226,7 @@ public: // from IStreamHandler
     void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
 private: // from IContainerSeekHandler
     TBool TrySeekTo(TUint aStreamId, TUint64 aBytePos) override;
+    TBool TrySkipTo(TUint64 aBytePos) override;
 private: // from IContainerUrlBlockWriter
     TBool TryGetUrl(IWriter& aWriter, TUint64 aOffset, TUint aBytes) override;
 private: // from IContainerStopper
@@ -244,7 +258,10 @@ private:
     TBool iStreamEnded;
     TUint iStreamId;
     TUint64 iStreamBytes;
+    TBool iStreamSeekable;
+    TBool iStreamLive;
     TUint iExpectedFlushId;
+    TUint iSkipFlushId;
     Mutex iLock;
 };
 
@@ -92,7 +92,8 @@ Msg* Id3v2::Pull()
         else if (iState == eRecognising) {
             if (RecogniseTag()) {
                 iTotalSize += iSize;
-                iCache->Discard(iSize-kRecogniseBytes);
+                // Tags may hold megabytes of artwork; seek past these where possible.
+                Skip(iSize-kRecogniseBytes, iTotalSize);
                 iSize = 0;
                 iState = eNone;
             }
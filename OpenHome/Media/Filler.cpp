@@ -77,6 +77,11 @@ void UriProvider::Interrupt(TBool /*aInterrupt*/)
 {
 }
 
+Track* UriProvider::PeekNext()
+{
+    return nullptr;
+}
+
 UriProvider::UriProvider(const TChar* aMode, Latency aLatency,
                          Next aNextSupported, Prev aPrevSupported,
                          Repeat aRepeatSupported, Random aRandomSupported,
@@ -113,6 +118,7 @@ Filler::Filler(IPipelineElementDownstream& aPipeline, IPipelineIdTracker& aIdTra
     , iLockUriProvider("FIL2")
     , iActiveUriProvider(nullptr)
     , iUriStreamer(nullptr)
+    , iPreroll(nullptr)
     , iTrack(nullptr)
     , iStopped(true)
     , iQuit(false)
@@ -144,6 +150,11 @@ void Filler::Add(UriProvider& aUriProvider)
     iUriProviders.push_back(&aUriProvider);
 }
 
+void Filler::SetPreroll(ITrackPreroll& aPreroll)
+{
+    iPreroll = &aPreroll;
+}
+
 void Filler::Start(IUriStreamer& aUriStreamer)
 {
     iUriStreamer = &aUriStreamer;
@@ -369,7 +380,12 @@ void Filler::Run()
                 iPipeline.Push(iMsgFactory.CreateMsgMetaText(Brx::Empty()));
             }
             else {
+                Track* next = (iPreroll == nullptr? nullptr : iActiveUriProvider->PeekNext());
                 iLock.Signal();
+                if (next != nullptr) {
+                    iPreroll->Preroll(*next);
+                    next->RemoveRef();
+                }
                 iUriStreamer->Interrupt(false);
                 iLock.Wait();
                 iWaitingForAudio = true;
@@ -20,6 +20,13 @@ namespace Media {
 
 class IClockPuller;
 
+class ITrackPreroll
+{
+public:
+    virtual ~ITrackPreroll() {}
+    virtual void Preroll(Track& aTrack) = 0; // fetch aTrack, in anticipation of it being streamed after the track passed to the next DoStream()
+};
+
 class UriProvider
 {
 public:
@@ -45,6 +52,7 @@ public:
     virtual void MovePrevious() = 0;
     virtual void MoveTo(const Brx& aCommand);
     virtual void Interrupt(TBool aInterrupt);
+    virtual Track* PeekNext(); // Track expected to follow the last one delivered by GetNext(), or nullptr if unknown.  Caller must RemoveRef().
 protected:
     enum class Latency          { Supported, NotSupported };
     enum class Next             { Supported, NotSupported };
@@ -74,6 +82,7 @@ public:
            IPipelineIdProvider& aIdProvider, TUint aThreadPriority, TUint aDefaultDelay);
     ~Filler();
     void Add(UriProvider& aUriProvider);
+    void SetPreroll(ITrackPreroll& aPreroll); // optional.  Must be called before Start()
     void Start(IUriStreamer& aUriStreamer);
     void Quit();
     void Play(const Brx& aMode, TUint aTrackId);
@@ -137,6 +146,7 @@ private:
     Mutex iLockUriProvider;
     UriProvider* iActiveUriProvider;
     IUriStreamer* iUriStreamer;
+    ITrackPreroll* iPreroll;
     Track* iTrack;
     TBool iStopped;
     TBool iQuit;
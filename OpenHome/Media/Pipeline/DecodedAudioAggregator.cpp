@@ -34,9 +34,34 @@ DecodedAudioAggregator::DecodedAudioAggregator(IPipelineElementDownstream& aDown
     , iBitDepth(0)
     , iSupportsLatency(false)
     , iAggregationDisabled(false)
+    , iDefaultMs(kMaxMs)
+    , iSenderMs(kMaxMs)
+    , iModeMs(0)
+    , iSenderActive(false)
+    , iSenderWindow(false)
+    , iMaxJiffies(kMaxJiffies)
 {
 }
 
+void DecodedAudioAggregator::SetWindows(TUint aDefaultMs, TUint aSenderMs)
+{
+    ASSERT(aDefaultMs > 0 && aSenderMs > 0);
+    iDefaultMs = aDefaultMs;
+    iSenderMs = aSenderMs;
+    iMaxJiffies = WindowJiffies(iDefaultMs);
+}
+
+void DecodedAudioAggregator::AddModeWindow(const Brx& aMode, TUint aMs)
+{
+    ASSERT(aMs > 0);
+    iModeWindows.push_back(std::pair<Brn, TUint>(Brn(aMode), aMs));
+}
+
+void DecodedAudioAggregator::NotifySenderActive(TBool aActive)
+{
+    iSenderActive.store(aActive);
+}
+
 void DecodedAudioAggregator::Push(Msg* aMsg)
 {
     ASSERT(aMsg != nullptr);
@@ -50,6 +75,8 @@ Msg* DecodedAudioAggregator::ProcessMsg(MsgMode* aMsg)
 {
     OutputAggregatedAudio();
     iSupportsLatency = aMsg->Info().SupportsLatency();
+    iModeMs = ModeWindowMs(aMsg->Mode());
+    UpdateWindow();
     return aMsg;
 }
 
@@ -123,9 +150,38 @@ Msg* DecodedAudioAggregator::ProcessMsg(MsgQuit* aMsg)
     return aMsg;
 }
 
-TBool DecodedAudioAggregator::AggregatorFull(TUint aBytes, TUint aJiffies)
+TUint DecodedAudioAggregator::WindowJiffies(TUint aMs)
+{ // static
+    return (Jiffies::kPerMs * aMs) - Jiffies::kMaxJiffiesPerSample;
+}
+
+TUint DecodedAudioAggregator::ModeWindowMs(const Brx& aMode) const
 {
-    return (aBytes == DecodedAudio::kMaxBytes || aJiffies >= kMaxJiffies);
+    for (const auto& window : iModeWindows) {
+        if (window.first == aMode) {
+            return window.second;
+        }
+    }
+    return 0;
+}
+
+void DecodedAudioAggregator::UpdateWindow()
+{
+    iSenderWindow = iSenderActive.load();
+    TUint windowMs = iModeMs;
+    if (windowMs == 0) {
+        windowMs = (iSenderWindow? iSenderMs : iDefaultMs);
+    }
+    const TUint maxJiffies = WindowJiffies(windowMs);
+    if (maxJiffies != iMaxJiffies) {
+        iMaxJiffies = maxJiffies;
+        LOG(kMedia, "DecodedAudioAggregator: window=%ums\n", windowMs);
+    }
+}
+
+TBool DecodedAudioAggregator::AggregatorFull(TUint aBytes, TUint aCapacityBytes, TUint aJiffies) const
+{
+    return (aBytes >= aCapacityBytes || aJiffies >= iMaxJiffies);
 }
 
 MsgAudioPcm* DecodedAudioAggregator::TryAggregate(MsgAudioPcm* aMsg)
@@ -140,7 +196,10 @@ MsgAudioPcm* DecodedAudioAggregator::TryAggregate(MsgAudioPcm* aMsg)
     ASSERT(jiffies == aMsg->Jiffies()); // refuse to handle msgs not terminating on sample boundaries
 
     if (iDecodedAudio == nullptr) {
-        if (AggregatorFull(msgBytes, aMsg->Jiffies())) {
+        if (iSenderActive.load() != iSenderWindow) {
+            UpdateWindow();
+        }
+        if (AggregatorFull(msgBytes, aMsg->CapacityBytes(), aMsg->Jiffies())) {
             return aMsg;
         }
         else {
@@ -151,13 +210,13 @@ MsgAudioPcm* DecodedAudioAggregator::TryAggregate(MsgAudioPcm* aMsg)
 
     TUint aggregatedJiffies = iDecodedAudio->Jiffies();
     TUint aggregatedBytes = Jiffies::ToBytes(aggregatedJiffies, jiffiesPerSample, iChannels, iBitDepth/8);
-    if (aggregatedBytes + msgBytes <= kMaxBytes) {
+    if (aggregatedBytes + msgBytes <= iDecodedAudio->CapacityBytes()) {
         // Have byte capacity to add new data.
         iDecodedAudio->Aggregate(aMsg);
 
         aggregatedJiffies = iDecodedAudio->Jiffies();
         aggregatedBytes = Jiffies::ToBytes(aggregatedJiffies, jiffiesPerSample, iChannels, iBitDepth/8);
-        if (AggregatorFull(aggregatedBytes, iDecodedAudio->Jiffies())) {
+        if (AggregatorFull(aggregatedBytes, iDecodedAudio->CapacityBytes(), iDecodedAudio->Jiffies())) {
             MsgAudioPcm* msg = iDecodedAudio;
             iDecodedAudio = nullptr;
             return msg;
@@ -4,24 +4,38 @@
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 namespace OpenHome {
 namespace Media {
 
-    class DecodedAudioAggregator : public PipelineElement, public IPipelineElementDownstream, private INonCopyable
+    class DecodedAudioAggregator : public PipelineElement, public IPipelineElementDownstream, public ISenderActivityObserver, private INonCopyable
 {
 public:
     static const TUint kMaxBytes = DecodedAudio::kMaxBytes;
-    static const TUint kMaxMs = 5;  // buffer MsgAudioPcm until we have this many ms
-                                    // (unless we hit DecodedAudio::kMaxBytes first).
-                                    // kMaxMs may be violated if it's possible to add
+    static const TUint kMaxMs = 5;  // default window; buffer MsgAudioPcm until we have this many ms
+                                    // (unless we fill the first msg's DecodedAudio first).
+                                    // The window may be violated if it's possible to add
                                     // a MsgAudioPcm without chopping it (and without
                                     // violating kMaxBytes).
     static const TUint kMaxJiffies = (Jiffies::kPerMs * kMaxMs) - Jiffies::kMaxJiffiesPerSample;
     static const TUint kSupportedMsgTypes;
 public:
     DecodedAudioAggregator(IPipelineElementDownstream& aDownstreamElement);
+    /*
+     * Windows (in ms) are selected on each MsgMode.  A window set for a specific mode takes
+     * precedence; otherwise aSenderMs is used while a Songcast sender is sending to listeners
+     * (see NotifySenderActive()) and aDefaultMs the rest of the time.  Changes in sender
+     * activity apply from the next msg output.  All must be set before the first msg is pushed.
+     */
+    void SetWindows(TUint aDefaultMs, TUint aSenderMs);
+    void AddModeWindow(const Brx& aMode, TUint aMs); // aMode must remain valid for the lifetime of this element
 public: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
+public: // from ISenderActivityObserver
+    void NotifySenderActive(TBool aActive) override;
 private: // IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgTrack* aMsg) override;
@@ -35,7 +49,10 @@ private: // IMsgProcessor
     Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
     Msg* ProcessMsg(MsgQuit* aMsg) override;
 private:
-    static TBool AggregatorFull(TUint aBytes, TUint aJiffies);
+    static TUint WindowJiffies(TUint aMs);
+    TUint ModeWindowMs(const Brx& aMode) const;
+    void UpdateWindow();
+    TBool AggregatorFull(TUint aBytes, TUint aCapacityBytes, TUint aJiffies) const;
     MsgAudioPcm* TryAggregate(MsgAudioPcm* aMsg);
     void OutputAggregatedAudio();
 private:
@@ -46,6 +63,13 @@ private:
     TUint iBitDepth;
     TBool iSupportsLatency;
     TBool iAggregationDisabled;
+    TUint iDefaultMs;
+    TUint iSenderMs;
+    TUint iModeMs; // 0 => current mode has no window of its own
+    std::atomic<TBool> iSenderActive;
+    TBool iSenderWindow; // iSenderActive, as last applied to iMaxJiffies
+    std::vector<std::pair<Brn, TUint>> iModeWindows;
+    TUint iMaxJiffies;
 };
 
 }
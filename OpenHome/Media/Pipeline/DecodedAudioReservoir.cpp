@@ -21,6 +21,7 @@ DecodedAudioReservoir::DecodedAudioReservoir(MsgFactory& aMsgFactory, IFlushIdPr
     , iClockPuller(nullptr)
     , iStreamHandler(nullptr)
     , iDecodedStream(nullptr)
+    , iStreamIdOut(IPipelineIdProvider::kStreamIdInvalid)
     , iDiscardJiffies(0)
     , iPostDiscardFlush(MsgFlush::kIdInvalid)
     , iGorgeLock("DCR2")
@@ -46,6 +47,17 @@ TUint DecodedAudioReservoir::SizeInJiffies() const
     return Jiffies();
 }
 
+TUint DecodedAudioReservoir::BufferedJiffies(TUint aStreamId) const
+{
+    if (aStreamId != iStreamIdOut.load()
+        || TrackCount() > 0
+        || EncodedStreamCount() > 0
+        || DecodedStreamCount() > 0) {
+        return 0;
+    }
+    return Jiffies();
+}
+
 Msg* DecodedAudioReservoir::Pull()
 {
     TBool wait = false;
@@ -242,6 +254,7 @@ Msg* DecodedAudioReservoir::ProcessMsgOut(MsgDecodedStream* aMsg)
         iDecodedStream->RemoveRef();
     }
     iDecodedStream = aMsg;
+    iStreamIdOut.store(aMsg->StreamInfo().StreamId());
 
     iGorgeLock.Wait();
     iPriorityMsgCount--;
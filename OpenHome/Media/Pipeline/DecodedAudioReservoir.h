@@ -11,7 +11,7 @@
 namespace OpenHome {
 namespace Media {
 
-class DecodedAudioReservoir : public AudioReservoir, private IStreamHandler
+class DecodedAudioReservoir : public AudioReservoir, public IDecodedAudioBuffer, private IStreamHandler
 {
     friend class SuiteGorger;
 public:
@@ -19,6 +19,8 @@ public:
                           TUint aMaxSize, TUint aMaxStreamCount, TUint aGorgeSize);
     ~DecodedAudioReservoir();
     TUint SizeInJiffies() const;
+public: // from IDecodedAudioBuffer
+    TUint BufferedJiffies(TUint aStreamId) const override;
 private: // from AudioReservoir
     TBool IsFull() const override;
     void HandleBlocked() override;
@@ -61,6 +63,7 @@ private:
     IClockPuller* iClockPuller;
     std::atomic<IStreamHandler*> iStreamHandler;
     MsgDecodedStream *iDecodedStream;
+    std::atomic<TUint> iStreamIdOut;
     TUint iDiscardJiffies;
     TUint iPostDiscardFlush;
     Mutex iGorgeLock;
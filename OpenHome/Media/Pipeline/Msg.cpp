@@ -25,15 +25,85 @@ using namespace OpenHome::Media;
 const TChar* OpenHome::Media::kStreamPlayNames[] = { "Yes", "No", "Later" };
 
 
+// AllocatorBudget
+
+AllocatorBudget::AllocatorBudget(TUint aBytes, IInfoAggregator& aInfoAggregator)
+    : iLock("PALB")
+    , iBytes(aBytes)
+    , iReserved(0)
+    , iReservedMax(0)
+{
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(AllocatorBase::kQueryMemory);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+void AllocatorBudget::Reserve(TUint aBytes)
+{
+    AutoMutex _(iLock);
+    iReserved += aBytes;
+    if (iReserved > iReservedMax) {
+        iReservedMax = iReserved;
+    }
+}
+
+TBool AllocatorBudget::TryReserve(TUint aBytes)
+{
+    AutoMutex _(iLock);
+    if (iBytes != 0 && iReserved + aBytes > iBytes) {
+        return false;
+    }
+    iReserved += aBytes;
+    if (iReserved > iReservedMax) {
+        iReservedMax = iReserved;
+    }
+    return true;
+}
+
+void AllocatorBudget::Release(TUint aBytes)
+{
+    AutoMutex _(iLock);
+    ASSERT(aBytes <= iReserved);
+    iReserved -= aBytes;
+}
+
+TUint AllocatorBudget::Reserved() const
+{
+    AutoMutex _(iLock);
+    return iReserved;
+}
+
+TUint AllocatorBudget::ReservedMax() const
+{
+    AutoMutex _(iLock);
+    return iReservedMax;
+}
+
+void AllocatorBudget::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    AutoMutex _(iLock);
+    if (aQuery == AllocatorBase::kQueryMemory) {
+        WriterAscii writer(aWriter);
+        writer.Write(Brn("AllocatorBudget: limit:"));
+        writer.WriteUint(iBytes);
+        writer.Write(Brn(" bytes, reserved:"));
+        writer.WriteUint(iReserved);
+        writer.Write(Brn(" bytes, peak:"));
+        writer.WriteUint(iReservedMax);
+        aWriter.Write(Brn(" bytes\n"));
+    }
+}
+
+
 // AllocatorBase
 
 const Brn AllocatorBase::kQueryMemory = Brn("memory");
 
 AllocatorBase::~AllocatorBase()
 {
-    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax, iFree.Slots());
-    const TUint slots = iFree.Slots();
-    for (TUint i=0; i<slots; i++) {
+    LOG(kPipeline, "> ~AllocatorBase for %s. (Peak %u/%u)\n", iName, iCellsUsedMax, iCellsTotal);
+    const TUint cells = iCellsTotal;
+    for (TUint i=0; i<cells; i++) {
         //Log::Print("  %u", i);
         try {
             Allocated* ptr = Read();
@@ -41,23 +111,34 @@ AllocatorBase::~AllocatorBase()
             delete ptr;
         }
         catch (AssertionFailed&) {
-            Log::Print("...leak at %u of %u\n", i+1, slots);
+            Log::Print("...leak at %u of %u\n", i+1, cells);
             ASSERTS();
         }
     }
+    if (iBudget != nullptr) {
+        iBudget->Release((iBudgetMode == eBudgetReserveMax? iCellsMax : cells) * iCellBytes);
+    }
     LOG(kPipeline, "< ~AllocatorBase for %s\n", iName);
 }
 
 void AllocatorBase::Free(Allocated* aPtr)
 {
+    std::vector<Allocated*> surplus;
     iLock.Wait();
     iCellsUsed--;
     iFree.Write(aPtr);
+    if (iCellsTotal > iCellsMin) {
+        TryShrinkLocked(surplus);
+    }
     iLock.Signal();
+    for (auto cell : surplus) {
+        delete cell;
+    }
 }
 
 TUint AllocatorBase::CellsTotal() const
 {
+    AutoMutex _(iLock);
     return iCellsTotal;
 }
 
@@ -84,23 +165,40 @@ TUint AllocatorBase::CellsUsedMax() const
 
 void AllocatorBase::GetStats(TUint& aCellsTotal, TUint& aCellBytes, TUint& aCellsUsed, TUint& aCellsUsedMax) const
 {
-    aCellsTotal = iCellsTotal;
     aCellBytes = iCellBytes;
     iLock.Wait();
+    aCellsTotal = iCellsTotal;
     aCellsUsed = iCellsUsed;
     aCellsUsedMax = iCellsUsedMax;
     iLock.Signal();
 }
 
 AllocatorBase::AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator)
-    : iFree(aNumCells)
+    : AllocatorBase(aName, aNumCells, aNumCells, aCellBytes, nullptr, eBudgetReserveMax, aInfoAggregator)
+{
+}
+
+AllocatorBase::AllocatorBase(const TChar* aName, TUint aMinCells, TUint aMaxCells, TUint aCellBytes,
+                             AllocatorBudget* aBudget, EBudget aBudgetMode, IInfoAggregator& aInfoAggregator)
+    : iFree(aMaxCells)
     , iLock("PAL1")
     , iName(aName)
-    , iCellsTotal(aNumCells)
+    , iCellsMin(aMinCells)
+    , iCellsMax(aMaxCells)
+    , iCellsPerGrow(aCellBytes >= kGrowBytes? 1 : kGrowBytes / aCellBytes)
     , iCellBytes(aCellBytes)
+    , iBudget(aBudget)
+    , iBudgetMode(aBudgetMode)
+    , iCellsTotal(aMinCells)
     , iCellsUsed(0)
     , iCellsUsedMax(0)
+    , iCellsTotalMax(aMinCells)
 {
+    ASSERT(aMinCells <= aMaxCells);
+    if (iBudget != nullptr) {
+        // Allocate() asserts if no cell is available so its worst case must always fit
+        iBudget->Reserve((iBudgetMode == eBudgetReserveMax? aMaxCells : aMinCells) * aCellBytes);
+    }
     std::vector<Brn> infoQueries;
     infoQueries.push_back(kQueryMemory);
     aInfoAggregator.Register(*this, infoQueries);
@@ -108,7 +206,26 @@ AllocatorBase::AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellByt
 
 Allocated* AllocatorBase::DoAllocate()
 {
-    iLock.Wait();
+    AutoMutex _(iLock);
+    ASSERT(iBudget == nullptr || iBudgetMode == eBudgetReserveMax);
+    if (iCellsUsed == iCellsTotal) {
+        // only fails once iCellsMax are in use; Read() below then asserts, as for a fixed size allocator
+        (void)TryGrowLocked();
+    }
+    return AllocateLocked();
+}
+
+Allocated* AllocatorBase::DoTryAllocate()
+{
+    AutoMutex _(iLock);
+    if (iCellsUsed == iCellsTotal && !TryGrowLocked()) {
+        return nullptr;
+    }
+    return AllocateLocked();
+}
+
+Allocated* AllocatorBase::AllocateLocked()
+{
     Allocated* cell = Read();
     ASSERT_VA(cell->iRefCount == 0, "%s has count %u\n", iName, cell->iRefCount.load());
     cell->iRefCount = 1;
@@ -116,10 +233,55 @@ Allocated* AllocatorBase::DoAllocate()
     if (iCellsUsed > iCellsUsedMax) {
         iCellsUsedMax = iCellsUsed;
     }
-    iLock.Signal();
     return cell;
 }
 
+TBool AllocatorBase::TryGrowLocked()
+{
+    if (iCellsTotal == iCellsMax) {
+        return false;
+    }
+    TUint cells = iCellsMax - iCellsTotal;
+    if (cells > iCellsPerGrow) {
+        cells = iCellsPerGrow;
+    }
+    if (iBudget != nullptr && iBudgetMode == eBudgetOnDemand && !iBudget->TryReserve(cells * iCellBytes)) {
+        LOG(kPipeline, "Allocator %s: budget exhausted, unable to grow beyond %u cells\n", iName, iCellsTotal);
+        return false;
+    }
+    for (TUint i=0; i<cells; i++) {
+        iFree.Write(CreateCell());
+    }
+    iCellsTotal += cells;
+    if (iCellsTotal > iCellsTotalMax) {
+        iCellsTotalMax = iCellsTotal;
+    }
+    return true;
+}
+
+void AllocatorBase::TryShrinkLocked(std::vector<Allocated*>& aCells)
+{
+    /* Shrink lazily - only once more than a quarter of cells (and at least two growth
+       steps' worth) are unused - so that an allocator whose usage fluctuates doesn't
+       repeatedly create and destroy cells.  Cells are deleted by the caller, outside iLock. */
+    const TUint free = iCellsTotal - iCellsUsed;
+    const TUint slack = (iCellsTotal / 4 > 2 * iCellsPerGrow? iCellsTotal / 4 : 2 * iCellsPerGrow);
+    if (free <= slack) {
+        return;
+    }
+    TUint cells = iCellsTotal - iCellsMin;
+    if (cells > iCellsPerGrow) {
+        cells = iCellsPerGrow;
+    }
+    for (TUint i=0; i<cells; i++) {
+        aCells.push_back(Read());
+    }
+    iCellsTotal -= cells;
+    if (iBudget != nullptr && iBudgetMode == eBudgetOnDemand) {
+        iBudget->Release(cells * iCellBytes);
+    }
+}
+
 Allocated* AllocatorBase::Read()
 {
     Allocated* p = nullptr;
@@ -149,6 +311,14 @@ void AllocatorBase::QueryInfo(const Brx& aQuery, IWriter& aWriter)
         writer.WriteUint(iCellsUsed);
         writer.Write(Brn(" cells, peak:"));
         writer.WriteUint(iCellsUsedMax);
+        if (iCellsMin != iCellsMax) {
+            writer.Write(Brn(" cells, range:"));
+            writer.WriteUint(iCellsMin);
+            writer.Write(Brn("-"));
+            writer.WriteUint(iCellsMax);
+            writer.Write(Brn(" cells, peak capacity:"));
+            writer.WriteUint(iCellsTotalMax);
+        }
         aWriter.Write(Brn(" cells\n"));
     }
 }
@@ -189,8 +359,10 @@ Allocated::~Allocated()
 
 // AudioData
 
-AudioData::AudioData(AllocatorBase& aAllocator)
+AudioData::AudioData(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes, TBool aOwnsStorage)
     : Allocated(aAllocator)
+    , iData(aStorage, 0, aMaxBytes)
+    , iOwnsStorage(aOwnsStorage)
 {
 #ifdef TIMESTAMP_LOGGING_ENABLE
     iOsCtx = gEnv->OsCtx();
@@ -199,6 +371,13 @@ AudioData::AudioData(AllocatorBase& aAllocator)
 #endif
 }
 
+AudioData::~AudioData()
+{
+    if (iOwnsStorage) {
+        delete[] iData.Ptr();
+    }
+}
+
 const TByte* AudioData::Ptr(TUint aBytes) const
 {
     ASSERT(aBytes < iData.Bytes());
@@ -210,6 +389,11 @@ TUint AudioData::Bytes() const
     return iData.Bytes();
 }
 
+TUint AudioData::MaxBytes() const
+{
+    return iData.MaxBytes();
+}
+
 #ifdef TIMESTAMP_LOGGING_ENABLE
 void AudioData::SetTimestamp(const TChar* aId)
 {
@@ -278,8 +462,8 @@ TBool AudioData::Timestamp::TryLog()
 
 // EncodedAudio
 
-EncodedAudio::EncodedAudio(AllocatorBase& aAllocator)
-    : AudioData(aAllocator)
+EncodedAudio::EncodedAudio(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes)
+    : AudioData(aAllocator, aStorage, aMaxBytes)
 {
 }
 
@@ -295,6 +479,18 @@ TUint EncodedAudio::Append(const Brx& aData)
     return aData.Bytes();
 }
 
+Bwn EncodedAudio::Unused()
+{
+    const TUint bytes = iData.Bytes();
+    return Bwn(iData.Ptr() + bytes, 0, iData.MaxBytes() - bytes);
+}
+
+void EncodedAudio::Commit(TUint aBytes)
+{
+    ASSERT(iData.Bytes() + aBytes <= iData.MaxBytes());
+    iData.SetBytes(iData.Bytes() + aBytes);
+}
+
 void EncodedAudio::Construct(const Brx& aData)
 {
     ASSERT(Append(aData) == aData.Bytes());
@@ -303,8 +499,8 @@ void EncodedAudio::Construct(const Brx& aData)
 
 // DecodedAudio
 
-DecodedAudio::DecodedAudio(AllocatorBase& aAllocator)
-    : AudioData(aAllocator)
+DecodedAudio::DecodedAudio(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes)
+    : AudioData(aAllocator, aStorage, aMaxBytes)
 {
 }
 
@@ -315,6 +511,7 @@ void DecodedAudio::Aggregate(DecodedAudio& aDecodedAudio)
 
 void DecodedAudio::Construct(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian)
 {
+    ASSERT(aData.Bytes() <= iData.MaxBytes());
     ASSERT((aBitDepth & 7) == 0);
     ASSERT(aData.Bytes() % (aBitDepth/8) == 0);
     TByte* ptr = const_cast<TByte*>(iData.Ptr());
@@ -367,6 +564,64 @@ void DecodedAudio::CopyToBigEndian32(const Brx& aData, TByte* aDest)
 }
 
 
+// AllocatorAudioData
+
+AllocatorAudioData::AllocatorAudioData(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator)
+    : AllocatorBase(aName, aNumCells, sizeof(AudioData) + aCellBytes, aInfoAggregator)
+    , iDataBytes(aCellBytes)
+{
+    CreateInitialCells(aNumCells);
+}
+
+AllocatorAudioData::AllocatorAudioData(const TChar* aName, TUint aMinCells, TUint aMaxCells, TUint aCellBytes,
+                                       AllocatorBudget* aBudget, EBudget aBudgetMode, IInfoAggregator& aInfoAggregator)
+    : AllocatorBase(aName, aMinCells, aMaxCells, sizeof(AudioData) + aCellBytes, aBudget, aBudgetMode, aInfoAggregator)
+    , iDataBytes(aCellBytes)
+    , iSlab(nullptr)
+{
+    if (aMinCells == aMaxCells) {
+        CreateInitialCells(aMinCells);
+    }
+    else {
+        // any cell may be freed on shrinking so none can share a slab
+        for (TUint i=0; i<aMinCells; i++) {
+            iFree.Write(CreateCell());
+        }
+    }
+}
+
+AllocatorAudioData::~AllocatorAudioData()
+{
+    // cells are deleted by ~AllocatorBase; they don't access slab buffers on destruction
+    delete[] iSlab;
+}
+
+void AllocatorAudioData::CreateInitialCells(TUint aNumCells)
+{
+    iSlab = new TByte[aNumCells * iDataBytes];
+    TByte* p = iSlab;
+    for (TUint i=0; i<aNumCells; i++) {
+        iFree.Write(new AudioData(*this, p, iDataBytes));
+        p += iDataBytes;
+    }
+}
+
+Allocated* AllocatorAudioData::CreateCell()
+{
+    return new AudioData(*this, new TByte[iDataBytes], iDataBytes, true);
+}
+
+AudioData* AllocatorAudioData::Allocate()
+{
+    return static_cast<AudioData*>(DoAllocate());
+}
+
+AudioData* AllocatorAudioData::TryAllocate()
+{
+    return static_cast<AudioData*>(DoTryAllocate());
+}
+
+
 // Jiffies
 
 TBool Jiffies::IsValidSampleRate(TUint aSampleRate)
@@ -1923,6 +2178,11 @@ void MsgAudioPcm::Aggregate(MsgAudioPcm* aMsg)
     aMsg->RemoveRef();
 }
 
+TUint MsgAudioPcm::CapacityBytes() const
+{
+    return iAudioData->MaxBytes();
+}
+
 MsgAudio* MsgAudioPcm::Clone()
 {
     MsgAudioPcm* clone = static_cast<MsgAudioPcm*>(MsgAudio::Clone());
@@ -2546,6 +2806,142 @@ TUint MsgQueue::NumMsgs() const
 }
 
 
+// MsgQueueSpsc
+
+MsgQueueSpsc::MsgQueueSpsc(TUint aMaxMsgs, EOverflow aOverflow)
+    : iMaxMsgs(aMaxMsgs)
+    , iMask(RoundUpPowerOfTwo(aMaxMsgs) - 1)
+    , iOverflow(aOverflow)
+    , iSemConsumer("MQSC", 0)
+    , iSemProducer("MQSP", 0)
+    , iHead(0)
+    , iConsumerWaiting(false)
+    , iTail(0)
+    , iProducerWaiting(false)
+{
+    ASSERT(aMaxMsgs > 0);
+    ASSERT(iHead.is_lock_free());
+    ASSERT(iConsumerWaiting.is_lock_free());
+    iRing = new Msg*[iMask + 1];
+}
+
+MsgQueueSpsc::~MsgQueueSpsc()
+{
+    Clear();
+    delete[] iRing;
+}
+
+void MsgQueueSpsc::Enqueue(Msg* aMsg)
+{
+    while (!TryEnqueue(aMsg)) {
+        ASSERT(iOverflow == EOverflow::Block);
+        iProducerWaiting.store(true);
+        if (NumMsgs() < iMaxMsgs) {
+            // consumer made space after our failed attempt; reclaim its signal if it spotted us waiting
+            if (!iProducerWaiting.exchange(false)) {
+                iSemProducer.Wait();
+            }
+            continue;
+        }
+        iSemProducer.Wait();
+    }
+}
+
+TBool MsgQueueSpsc::TryEnqueue(Msg* aMsg)
+{
+    ASSERT(aMsg != nullptr);
+    const TUint tail = iTail.load(std::memory_order_relaxed);
+    if (tail - iHead.load(std::memory_order_acquire) >= iMaxMsgs) {
+        return false;
+    }
+    iRing[tail & iMask] = aMsg;
+    iTail.store(tail + 1); // seq_cst - must be ordered before the load below
+    if (iConsumerWaiting.load() && iConsumerWaiting.exchange(false)) {
+        iSemConsumer.Signal();
+    }
+    return true;
+}
+
+Msg* MsgQueueSpsc::Dequeue()
+{
+    Msg* msg = nullptr;
+    (void)DequeueBatch(&msg, 1);
+    return msg;
+}
+
+TUint MsgQueueSpsc::DequeueBatch(Msg** aMsgs, TUint aMaxMsgs)
+{
+    ASSERT(aMaxMsgs > 0);
+    for (;;) {
+        TUint count = TryDequeue(aMsgs, aMaxMsgs);
+        if (count > 0) {
+            return count;
+        }
+        iConsumerWaiting.store(true);
+        count = TryDequeue(aMsgs, aMaxMsgs);
+        if (count > 0) {
+            // producer enqueued after our failed attempt; reclaim its signal if it spotted us waiting
+            if (!iConsumerWaiting.exchange(false)) {
+                iSemConsumer.Wait();
+            }
+            return count;
+        }
+        iSemConsumer.Wait();
+    }
+}
+
+void MsgQueueSpsc::Clear()
+{
+    Msg* msg;
+    while (TryDequeue(&msg, 1) > 0) {
+        msg->RemoveRef();
+    }
+}
+
+TBool MsgQueueSpsc::IsEmpty() const
+{
+    return NumMsgs() == 0;
+}
+
+TUint MsgQueueSpsc::NumMsgs() const
+{
+    const TUint head = iHead.load();
+    return iTail.load() - head;
+}
+
+TUint MsgQueueSpsc::MaxMsgs() const
+{
+    return iMaxMsgs;
+}
+
+TUint MsgQueueSpsc::TryDequeue(Msg** aMsgs, TUint aMaxMsgs)
+{
+    const TUint head = iHead.load(std::memory_order_relaxed);
+    const TUint available = iTail.load(std::memory_order_acquire) - head;
+    const TUint count = std::min(available, aMaxMsgs);
+    if (count == 0) {
+        return 0;
+    }
+    for (TUint i=0; i<count; i++) {
+        aMsgs[i] = iRing[(head + i) & iMask];
+    }
+    iHead.store(head + count); // seq_cst - must be ordered before the load below
+    if (iProducerWaiting.load() && iProducerWaiting.exchange(false)) {
+        iSemProducer.Signal();
+    }
+    return count;
+}
+
+TUint MsgQueueSpsc::RoundUpPowerOfTwo(TUint aValue)
+{
+    TUint pow2 = 1;
+    while (pow2 < aValue) {
+        pow2 <<= 1;
+    }
+    return pow2;
+}
+
+
 // MsgReservoir
 
 MsgReservoir::MsgReservoir()
@@ -3125,14 +3521,21 @@ Track* TrackFactory::CreateNullTrack()
 // MsgFactory
 
 MsgFactory::MsgFactory(IInfoAggregator& aInfoAggregator, const MsgFactoryInitParams& aInitParams)
-    : iAllocatorMsgMode("MsgMode", aInitParams.iMsgModeCount, aInfoAggregator)
+    : iBudget(aInitParams.iMemoryBudgetBytes, aInfoAggregator)
+    , iAllocatorMsgMode("MsgMode", aInitParams.iMsgModeCount, aInfoAggregator)
     , iAllocatorMsgTrack("MsgTrack", aInitParams.iMsgTrackCount, aInfoAggregator)
     , iAllocatorMsgDrain("MsgDrain", aInitParams.iMsgDrainCount, aInfoAggregator)
     , iDrainId(0)
     , iAllocatorMsgDelay("MsgDelay", aInitParams.iMsgDelayCount, aInfoAggregator)
     , iAllocatorMsgEncodedStream("MsgEncodedStream", aInitParams.iMsgEncodedStreamCount, aInfoAggregator)
-    , iAllocatorAudioData("AudioData", aInitParams.iEncodedAudioCount + aInitParams.iDecodedAudioCount, aInfoAggregator)
-    , iAllocatorMsgAudioEncoded("MsgAudioEncoded", aInitParams.iMsgAudioEncodedCount, aInfoAggregator)
+    , iAllocatorAudioData("AudioData", aInitParams.iEncodedAudioCount + aInitParams.iDecodedAudioCount,
+                          Max(aInitParams.iEncodedAudioCount, aInitParams.iEncodedAudioCountMax) + Max(aInitParams.iDecodedAudioCount, aInitParams.iDecodedAudioCountMax),
+                          AudioData::kMaxBytes, &iBudget, AllocatorBase::eBudgetReserveMax, aInfoAggregator)
+    , iAllocatorDecodedAudioMedium(nullptr)
+    , iAllocatorDecodedAudioLarge(nullptr)
+    , iDecodedAudioTargetMs(aInitParams.iDecodedAudioTargetMs)
+    , iAllocatorMsgAudioEncoded("MsgAudioEncoded", aInitParams.iMsgAudioEncodedCount,
+                                Max(aInitParams.iMsgAudioEncodedCount, aInitParams.iMsgAudioEncodedCountMax), &iBudget, aInfoAggregator)
     , iAllocatorMsgMetaText("MsgMetaText", aInitParams.iMsgMetaTextCount, aInfoAggregator)
     , iAllocatorMsgStreamInterrupted("MsgStreamInterrupted", aInitParams.iMsgStreamInterruptedCount, aInfoAggregator)
     , iAllocatorMsgHalt("MsgHalt", aInitParams.iMsgHaltCount, aInfoAggregator)
@@ -3140,12 +3543,29 @@ MsgFactory::MsgFactory(IInfoAggregator& aInfoAggregator, const MsgFactoryInitPar
     , iAllocatorMsgWait("MsgWait", aInitParams.iMsgWaitCount, aInfoAggregator)
     , iAllocatorMsgDecodedStream("MsgDecodedStream", aInitParams.iMsgDecodedStreamCount, aInfoAggregator)
     , iAllocatorMsgBitRate("MsgBitRate", aInitParams.iMsgBitRateCount, aInfoAggregator)
-    , iAllocatorMsgAudioPcm("MsgAudioPcm", aInitParams.iMsgAudioPcmCount, aInfoAggregator)
+    , iAllocatorMsgAudioPcm("MsgAudioPcm", aInitParams.iMsgAudioPcmCount,
+                            Max(aInitParams.iMsgAudioPcmCount, aInitParams.iMsgAudioPcmCountMax), &iBudget, aInfoAggregator)
     , iAllocatorMsgSilence("MsgSilence", aInitParams.iMsgSilenceCount, aInfoAggregator)
     , iAllocatorMsgPlayablePcm("MsgPlayablePcm", aInitParams.iMsgPlayablePcmCount, aInfoAggregator)
     , iAllocatorMsgPlayableSilence("MsgPlayableSilence", aInitParams.iMsgPlayableSilenceCount, aInfoAggregator)
     , iAllocatorMsgQuit("MsgQuit", aInitParams.iMsgQuitCount, aInfoAggregator)
 {
+    if (aInitParams.iDecodedAudioMediumCount > 0) {
+        iAllocatorDecodedAudioMedium = new AllocatorAudioData("DecodedAudioMedium", 0, aInitParams.iDecodedAudioMediumCount,
+                                                              DecodedAudio::kMaxBytesMedium, &iBudget,
+                                                              AllocatorBase::eBudgetOnDemand, aInfoAggregator);
+    }
+    if (aInitParams.iDecodedAudioLargeCount > 0) {
+        iAllocatorDecodedAudioLarge = new AllocatorAudioData("DecodedAudioLarge", 0, aInitParams.iDecodedAudioLargeCount,
+                                                             DecodedAudio::kMaxBytesLarge, &iBudget,
+                                                             AllocatorBase::eBudgetOnDemand, aInfoAggregator);
+    }
+}
+
+MsgFactory::~MsgFactory()
+{
+    delete iAllocatorDecodedAudioLarge;
+    delete iAllocatorDecodedAudioMedium;
 }
 
 MsgMode* MsgFactory::CreateMsgMode(const Brx& aMode, const ModeInfo& aInfo,
@@ -3220,6 +3640,18 @@ MsgAudioEncoded* MsgFactory::CreateMsgAudioEncoded(const Brx& aData)
     return msg;
 }
 
+MsgAudioEncoded* MsgFactory::CreateMsgAudioEncoded(EncodedAudio* aAudio)
+{
+    MsgAudioEncoded* msg = iAllocatorMsgAudioEncoded.Allocate();
+    msg->Initialise(aAudio);
+    return msg;
+}
+
+EncodedAudio* MsgFactory::CreateEncodedAudio()
+{
+    return static_cast<EncodedAudio*>(iAllocatorAudioData.Allocate());
+}
+
 MsgMetaText* MsgFactory::CreateMsgMetaText(const Brx& aMetaText)
 {
     MsgMetaText* msg = iAllocatorMsgMetaText.Allocate();
@@ -3285,7 +3717,7 @@ MsgBitRate* MsgFactory::CreateMsgBitRate(TUint aBitRate)
 
 MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, AudioDataEndian aEndian, TUint64 aTrackOffset)
 {
-    DecodedAudio* decodedAudio = CreateDecodedAudio(aData, aBitDepth, aEndian);
+    DecodedAudio* decodedAudio = CreateDecodedAudio(aData, aChannels, aSampleRate, aBitDepth, aEndian);
     return CreateMsgAudioPcm(decodedAudio, aChannels, aSampleRate, aBitDepth, aTrackOffset);
 }
 
@@ -3316,13 +3748,34 @@ EncodedAudio* MsgFactory::CreateEncodedAudio(const Brx& aData)
     return encodedAudio;
 }
 
-DecodedAudio* MsgFactory::CreateDecodedAudio(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian)
+DecodedAudio* MsgFactory::CreateDecodedAudio(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, AudioDataEndian aEndian)
 {
-    DecodedAudio* decodedAudio = static_cast<DecodedAudio*>(iAllocatorAudioData.Allocate());
+    DecodedAudio* decodedAudio = static_cast<DecodedAudio*>(AllocateDecodedAudio(aChannels, aSampleRate, aBitDepth));
     decodedAudio->Construct(aData, aBitDepth, aEndian);
     return decodedAudio;
 }
 
+AudioData* MsgFactory::AllocateDecodedAudio(TUint aChannels, TUint aSampleRate, TUint aBitDepth)
+{
+    /* Pick the smallest size class that holds iDecodedAudioTargetMs of this stream, allowing
+       DecodedAudioAggregator to build msgs of a similar duration whatever the format.
+       Larger classes are an optimisation only - fall back to a smaller one if all are in use. */
+    AudioData* audioData = nullptr;
+    if (iDecodedAudioTargetMs > 0) {
+        const TUint64 targetBytes = ((TUint64)aSampleRate * aChannels * (aBitDepth/8) * iDecodedAudioTargetMs) / 1000;
+        if (targetBytes > DecodedAudio::kMaxBytesMedium && iAllocatorDecodedAudioLarge != nullptr) {
+            audioData = iAllocatorDecodedAudioLarge->TryAllocate();
+        }
+        if (audioData == nullptr && targetBytes > DecodedAudio::kMaxBytes && iAllocatorDecodedAudioMedium != nullptr) {
+            audioData = iAllocatorDecodedAudioMedium->TryAllocate();
+        }
+    }
+    if (audioData == nullptr) {
+        audioData = iAllocatorAudioData.Allocate();
+    }
+    return audioData;
+}
+
 MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(DecodedAudio* aAudioData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, TUint64 aTrackOffset)
 {
     MsgAudioPcm* msg = iAllocatorMsgAudioPcm.Allocate();
@@ -3336,3 +3789,8 @@ MsgAudioPcm* MsgFactory::CreateMsgAudioPcm(DecodedAudio* aAudioData, TUint aChan
     }
     return msg;
 }
+
+TUint MsgFactory::Max(TUint aMin, TUint aMax)
+{ // static
+    return (aMax > aMin? aMax : aMin);
+}
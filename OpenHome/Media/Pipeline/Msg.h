@@ -13,6 +13,7 @@
 
 #include <limits.h>
 #include <atomic>
+#include <vector>
 
 EXCEPTION(SampleRateInvalid);
 EXCEPTION(SampleRateUnsupported);
@@ -24,8 +25,39 @@ namespace Media {
 
 class Allocated;
 
+/*
+ * Memory budget shared by elastic allocators.
+ * Memory an allocator must be able to provide is reserved unconditionally, even if this
+ * exceeds the budget.  Best effort cells beyond that are only created if they fit within
+ * what remains.
+ */
+class AllocatorBudget : private IInfoProvider, private INonCopyable
+{
+public:
+    AllocatorBudget(TUint aBytes, IInfoAggregator& aInfoAggregator); // aBytes==0 => unlimited
+    void Reserve(TUint aBytes);
+    TBool TryReserve(TUint aBytes);
+    void Release(TUint aBytes);
+    TUint Reserved() const;
+    TUint ReservedMax() const;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter);
+private:
+    mutable Mutex iLock;
+    const TUint iBytes;
+    TUint iReserved;
+    TUint iReservedMax;
+};
+
 class AllocatorBase : private IInfoProvider
 {
+public:
+    static const TUint kGrowBytes = 4096; // elastic allocators grow by (at least one) page of cells at a time
+    enum EBudget
+    {
+        eBudgetReserveMax, // aMaxCells reserved up front so growth never fails; required for Allocate()
+        eBudgetOnDemand    // cells beyond aMinCells only created while within budget; use TryAllocate()
+    };
 public:
     ~AllocatorBase();
     void Free(Allocated* aPtr);
@@ -38,9 +70,16 @@ public:
     static const Brn kQueryMemory;
 protected:
     AllocatorBase(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator);
+    AllocatorBase(const TChar* aName, TUint aMinCells, TUint aMaxCells, TUint aCellBytes,
+                  AllocatorBudget* aBudget, EBudget aBudgetMode, IInfoAggregator& aInfoAggregator);
     Allocated* DoAllocate();
+    Allocated* DoTryAllocate();
 private:
+    virtual Allocated* CreateCell() = 0; // only called for elastic allocators
     Allocated* Read();
+    Allocated* AllocateLocked();
+    TBool TryGrowLocked();
+    void TryShrinkLocked(std::vector<Allocated*>& aCells);
 private: // from IInfoProvider
     void QueryInfo(const Brx& aQuery, IWriter& aWriter);
 protected:
@@ -48,18 +87,27 @@ protected:
 private:
     mutable Mutex iLock;
     const TChar* iName;
-    const TUint iCellsTotal;
+    const TUint iCellsMin;
+    const TUint iCellsMax;
+    const TUint iCellsPerGrow;
     const TUint iCellBytes;
+    AllocatorBudget* iBudget;
+    const EBudget iBudgetMode;
+    TUint iCellsTotal;
     TUint iCellsUsed;
     TUint iCellsUsedMax;
+    TUint iCellsTotalMax;
 };
 
 template <class T> class Allocator : public AllocatorBase
 {
 public:
     Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator);
+    Allocator(const TChar* aName, TUint aMinCells, TUint aMaxCells, AllocatorBudget* aBudget, IInfoAggregator& aInfoAggregator);
     virtual ~Allocator();
     T* Allocate();
+private: // from AllocatorBase
+    Allocated* CreateCell() override;
 };
 
 template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aNumCells, IInfoAggregator& aInfoAggregator)
@@ -70,6 +118,14 @@ template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aNumCells,
     }
 }
 
+template <class T> Allocator<T>::Allocator(const TChar* aName, TUint aMinCells, TUint aMaxCells, AllocatorBudget* aBudget, IInfoAggregator& aInfoAggregator)
+    : AllocatorBase(aName, aMinCells, aMaxCells, sizeof(T), aBudget, eBudgetReserveMax, aInfoAggregator)
+{
+    for (TUint i=0; i<aMinCells; i++) {
+        iFree.Write(new T(*this));
+    }
+}
+
 template <class T> Allocator<T>::~Allocator()
 {
 }
@@ -79,6 +135,11 @@ template <class T> T* Allocator<T>::Allocate()
     return static_cast<T*>(DoAllocate());
 }
 
+template <class T> Allocated* Allocator<T>::CreateCell()
+{
+    return new T(*this);
+}
+
 class Logger;
 
 class Allocated
@@ -113,17 +174,22 @@ class AudioData : public Allocated
 public: 
     static const TUint kMaxBytes = 7680; // max of 2ms/10ch/96/32 and 5ms/2ch/192/24 (latter for Songcast, supporting earliest receiver)
 public:
-    AudioData(AllocatorBase& aAllocator);
+    AudioData(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes, TBool aOwnsStorage = false);
     const TByte* Ptr(TUint aOffsetBytes) const;
     TUint Bytes() const;
+    TUint MaxBytes() const;
 #ifdef TIMESTAMP_LOGGING_ENABLE
     void SetTimestamp(const TChar* aId);
     TBool TryLogTimestamps();
 #endif
+protected:
+    ~AudioData();
 private: // from Allocated
     void Clear() override;
 protected:
-    Bws<kMaxBytes> iData;
+    Bwn iData;
+private:
+    const TBool iOwnsStorage;
 #ifdef TIMESTAMP_LOGGING_ENABLE
 private:
     class Timestamp
@@ -149,8 +215,15 @@ class EncodedAudio : public AudioData
     friend class MsgFactory;
 public:
     TUint Append(const Brx& aData); // returns number of bytes appended
+    /*
+     * Allow data to be written directly into a cell (e.g. by reading a socket), avoiding
+     * copying it via Append().  Only valid for a cell from MsgFactory::CreateEncodedAudio()
+     * that hasn't yet been passed to CreateMsgAudioEncoded().
+     */
+    Bwn Unused();              // space following any data already held
+    void Commit(TUint aBytes); // record that aBytes have been written to the start of Unused()
 private:
-    EncodedAudio(AllocatorBase& aAllocator);
+    EncodedAudio(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes);
     void Construct(const Brx& aData);
 };
 
@@ -159,16 +232,42 @@ class DecodedAudio : public AudioData
     friend class MsgFactory;
 public:
     static const TUint kMaxNumChannels = 8;
+    // Larger size classes, allocated by MsgFactory for high rate and multichannel streams
+    // so that each msg can hold a similar duration of audio to a 44.1k stereo one.
+    static const TUint kMaxBytesMedium = kMaxBytes * 4;  // 5ms of 192k/8ch/32-bit
+    static const TUint kMaxBytesLarge  = kMaxBytes * 16; // 20ms of 192k/8ch/32-bit
 public:
     void Aggregate(DecodedAudio& aDecodedAudio);
 private:
-    DecodedAudio(AllocatorBase& aAllocator);
+    DecodedAudio(AllocatorBase& aAllocator, TByte* aStorage, TUint aMaxBytes);
     void Construct(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian);
     static void CopyToBigEndian16(const Brx& aData, TByte* aDest);
     static void CopyToBigEndian24(const Brx& aData, TByte* aDest);
     static void CopyToBigEndian32(const Brx& aData, TByte* aDest);
 };
 
+/*
+ * Allocates AudioData cells whose buffers are carved from a single slab of aCellBytes per cell.
+ * Cells are returned as AudioData; MsgFactory casts them to EncodedAudio or DecodedAudio.
+ */
+class AllocatorAudioData : public AllocatorBase
+{
+public:
+    AllocatorAudioData(const TChar* aName, TUint aNumCells, TUint aCellBytes, IInfoAggregator& aInfoAggregator);
+    AllocatorAudioData(const TChar* aName, TUint aMinCells, TUint aMaxCells, TUint aCellBytes,
+                       AllocatorBudget* aBudget, EBudget aBudgetMode, IInfoAggregator& aInfoAggregator);
+    ~AllocatorAudioData();
+    AudioData* Allocate();
+    AudioData* TryAllocate(); // returns nullptr rather than asserting if all cells are in use and no more can be created
+private: // from AllocatorBase
+    Allocated* CreateCell() override;
+private:
+    void CreateInitialCells(TUint aNumCells);
+private:
+    const TUint iDataBytes;
+    TByte* iSlab;
+};
+
 /**
  * Provides the pipeline's unit of timing.
  *
@@ -789,6 +888,7 @@ public:
     TUint64 TrackOffset() const; // offset of the start of this msg from the start of its track.  FIXME no tests for this yet
     MsgPlayable* CreatePlayable(); // removes ref, transfer ownership of DecodedAudio
     void Aggregate(MsgAudioPcm* aMsg); // append aMsg to the end of this msg, removes ref on aMsg
+    TUint CapacityBytes() const; // size of the DecodedAudio cell; Aggregate() can't grow a msg beyond this
     void SetAttenuation(TUint aAttenuation);
     inline void AddLogPoint(const TChar* aId);
 public: // from MsgAudio
@@ -1046,6 +1146,54 @@ private:
     Semaphore iSem;
 };
 
+/*
+ * Bounded queue for hand-offs where exactly one thread enqueues and exactly one
+ * (other) thread dequeues.
+ * Neither Enqueue() nor Dequeue() takes a lock.  A semaphore is only signalled
+ * when the consumer is blocked on an empty queue (or, with EOverflow::Block,
+ * when the producer is blocked on a full one).
+ * Holds at most aMaxMsgs msgs.  (The ring is rounded up to a power of two
+ * internally; the extra slots are never used.)
+ */
+class MsgQueueSpsc : private INonCopyable
+{
+    static const TUint kCacheLineBytes = 64;
+public:
+    enum class EOverflow
+    {
+        Assert, // enqueuing to a full queue is a programming error
+        Block   // Enqueue() waits for the consumer to make space
+    };
+public:
+    MsgQueueSpsc(TUint aMaxMsgs, EOverflow aOverflow = EOverflow::Assert);
+    ~MsgQueueSpsc();
+    void Enqueue(Msg* aMsg);                            // producer only
+    TBool TryEnqueue(Msg* aMsg);                        // producer only.  Returns false if queue full
+    Msg* Dequeue();                                     // consumer only.  Blocks until a msg is available
+    TUint DequeueBatch(Msg** aMsgs, TUint aMaxMsgs);    // consumer only.  Blocks until at least one msg is available
+    void Clear();                                       // consumer only
+    TBool IsEmpty() const;
+    TUint NumMsgs() const;                              // test/debug use only
+    TUint MaxMsgs() const;
+private:
+    TUint TryDequeue(Msg** aMsgs, TUint aMaxMsgs);
+    static TUint RoundUpPowerOfTwo(TUint aValue);
+private:
+    const TUint iMaxMsgs;
+    const TUint iMask;
+    const EOverflow iOverflow;
+    Msg** iRing;
+    Semaphore iSemConsumer;
+    Semaphore iSemProducer;
+    TByte iPad0[kCacheLineBytes];
+    std::atomic<TUint> iHead; // written by consumer only
+    std::atomic<TBool> iConsumerWaiting;
+    TByte iPad1[kCacheLineBytes];
+    std::atomic<TUint> iTail; // written by producer only
+    std::atomic<TBool> iProducerWaiting;
+    TByte iPad2[kCacheLineBytes];
+};
+
 class MsgReservoir
 {
 protected:
@@ -1509,6 +1657,13 @@ public:
     virtual TUint SeekRestream(const Brx& aMode, TUint aTrackId) = 0; // returns flush id that'll preceed restreamed track
 };
 
+class IDecodedAudioBuffer
+{
+public:
+    virtual ~IDecodedAudioBuffer() {}
+    virtual TUint BufferedJiffies(TUint aStreamId) const = 0; // audio from aStreamId available without further decoding.  0 if other streams are also buffered
+};
+
 class IStopper
 {
 public:
@@ -1574,6 +1729,13 @@ public:
     virtual ~IPostPipelineLatencyObserver() {}
 };
 
+class ISenderActivityObserver
+{
+public:
+    virtual void NotifySenderActive(TBool aActive) = 0; // may be called from any thread
+    virtual ~ISenderActivityObserver() {}
+};
+
 class TrackFactory
 {
 public:
@@ -1606,6 +1768,14 @@ public:
     inline void SetMsgDecodedStreamCount(TUint aCount);
     inline void SetMsgBitRateCount(TUint aCount);
     inline void SetMsgAudioPcmCount(TUint aCount, TUint aDecodedAudioCount);
+    inline void SetDecodedAudioSizeClasses(TUint aMediumCount, TUint aLargeCount, TUint aTargetMs); // aTargetMs==0 disables
+    // Allow audio pools to grow on demand beyond the counts above, up to these maximums.
+    // Maximums are always reserved from aBudgetBytes (0 => unlimited); size class pools
+    // (which always start empty) only grow into whatever remains.
+    // Counts below those set above are ignored.
+    inline void SetMsgAudioEncodedCountMax(TUint aCount, TUint aEncodedAudioCount);
+    inline void SetMsgAudioPcmCountMax(TUint aCount, TUint aDecodedAudioCount);
+    inline void SetMemoryBudget(TUint aBudgetBytes);
     inline void SetMsgSilenceCount(TUint aCount);
     inline void SetMsgPlayableCount(TUint aPcmCount, TUint aSilenceCount);
     inline void SetMsgQuitCount(TUint aCount);
@@ -1616,7 +1786,9 @@ private:
     TUint iMsgDelayCount;
     TUint iMsgEncodedStreamCount;
     TUint iEncodedAudioCount;
+    TUint iEncodedAudioCountMax;
     TUint iMsgAudioEncodedCount;
+    TUint iMsgAudioEncodedCountMax;
     TUint iMsgMetaTextCount;
     TUint iMsgStreamInterruptedCount;
     TUint iMsgHaltCount;
@@ -1625,7 +1797,13 @@ private:
     TUint iMsgDecodedStreamCount;
     TUint iMsgBitRateCount;
     TUint iDecodedAudioCount;
+    TUint iDecodedAudioMediumCount;
+    TUint iDecodedAudioLargeCount;
+    TUint iDecodedAudioTargetMs;
+    TUint iDecodedAudioCountMax;
     TUint iMsgAudioPcmCount;
+    TUint iMsgAudioPcmCountMax;
+    TUint iMemoryBudgetBytes;
     TUint iMsgSilenceCount;
     TUint iMsgPlayablePcmCount;
     TUint iMsgPlayableSilenceCount;
@@ -1636,6 +1814,7 @@ class MsgFactory
 {
 public:
     MsgFactory(IInfoAggregator& aInfoAggregator, const MsgFactoryInitParams& aInitParams);
+    ~MsgFactory();
 
     MsgMode* CreateMsgMode(const Brx& aMode, const ModeInfo& aInfo, ModeClockPullers aClockPullers, const ModeTransportControls& aTransportControls);
     MsgMode* CreateMsgMode(const Brx& aMode);
@@ -1646,6 +1825,8 @@ public:
     MsgEncodedStream* CreateMsgEncodedStream(const Brx& aUri, const Brx& aMetaText, TUint64 aTotalBytes, TUint64 aOffset, TUint aStreamId, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler* aStreamHandler, const PcmStreamInfo& aPcmStream);
     MsgEncodedStream* CreateMsgEncodedStream(MsgEncodedStream* aMsg, IStreamHandler* aStreamHandler);
     MsgAudioEncoded* CreateMsgAudioEncoded(const Brx& aData);
+    MsgAudioEncoded* CreateMsgAudioEncoded(EncodedAudio* aAudio); // takes ownership of aAudio
+    EncodedAudio* CreateEncodedAudio(); // empty cell, to be filled via EncodedAudio::Unused()/Commit()
     MsgMetaText* CreateMsgMetaText(const Brx& aMetaText);
     MsgStreamInterrupted* CreateMsgStreamInterrupted();
     MsgHalt* CreateMsgHalt(TUint aId = MsgHalt::kIdNone);
@@ -1661,16 +1842,22 @@ public:
     MsgQuit* CreateMsgQuit();
 private:
     EncodedAudio* CreateEncodedAudio(const Brx& aData);
-    DecodedAudio* CreateDecodedAudio(const Brx& aData, TUint aBitDepth, AudioDataEndian aEndian);
+    DecodedAudio* CreateDecodedAudio(const Brx& aData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, AudioDataEndian aEndian);
+    AudioData* AllocateDecodedAudio(TUint aChannels, TUint aSampleRate, TUint aBitDepth);
     MsgAudioPcm* CreateMsgAudioPcm(DecodedAudio* aAudioData, TUint aChannels, TUint aSampleRate, TUint aBitDepth, TUint64 aTrackOffset);
+    static TUint Max(TUint aMin, TUint aMax);
 private:
+    AllocatorBudget iBudget;
     Allocator<MsgMode> iAllocatorMsgMode;
     Allocator<MsgTrack> iAllocatorMsgTrack;
     Allocator<MsgDrain> iAllocatorMsgDrain;
     TUint iDrainId;
     Allocator<MsgDelay> iAllocatorMsgDelay;
     Allocator<MsgEncodedStream> iAllocatorMsgEncodedStream;
-    Allocator<AudioData> iAllocatorAudioData;
+    AllocatorAudioData iAllocatorAudioData;
+    AllocatorAudioData* iAllocatorDecodedAudioMedium;
+    AllocatorAudioData* iAllocatorDecodedAudioLarge;
+    const TUint iDecodedAudioTargetMs;
     Allocator<MsgAudioEncoded> iAllocatorMsgAudioEncoded;
     Allocator<MsgMetaText> iAllocatorMsgMetaText;
     Allocator<MsgStreamInterrupted> iAllocatorMsgStreamInterrupted;
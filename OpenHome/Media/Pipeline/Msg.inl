@@ -280,7 +280,9 @@ inline MsgFactoryInitParams::MsgFactoryInitParams()
     , iMsgDelayCount(1)
     , iMsgEncodedStreamCount(1)
     , iEncodedAudioCount(1)
+    , iEncodedAudioCountMax(0)
     , iMsgAudioEncodedCount(1)
+    , iMsgAudioEncodedCountMax(0)
     , iMsgMetaTextCount(1)
     , iMsgStreamInterruptedCount(1)
     , iMsgHaltCount(1)
@@ -289,7 +291,13 @@ inline MsgFactoryInitParams::MsgFactoryInitParams()
     , iMsgDecodedStreamCount(1)
     , iMsgBitRateCount(1)
     , iDecodedAudioCount(1)
+    , iDecodedAudioMediumCount(0)
+    , iDecodedAudioLargeCount(0)
+    , iDecodedAudioTargetMs(0)
+    , iDecodedAudioCountMax(0)
     , iMsgAudioPcmCount(1)
+    , iMsgAudioPcmCountMax(0)
+    , iMemoryBudgetBytes(0)
     , iMsgSilenceCount(1)
     , iMsgPlayablePcmCount(1)
     , iMsgPlayableSilenceCount(1)
@@ -354,6 +362,26 @@ inline void MsgFactoryInitParams::SetMsgAudioPcmCount(TUint aCount, TUint aDecod
     iMsgAudioPcmCount = aCount;
     iDecodedAudioCount = aDecodedAudioCount;
 }
+inline void MsgFactoryInitParams::SetDecodedAudioSizeClasses(TUint aMediumCount, TUint aLargeCount, TUint aTargetMs)
+{
+    iDecodedAudioMediumCount = aMediumCount;
+    iDecodedAudioLargeCount = aLargeCount;
+    iDecodedAudioTargetMs = aTargetMs;
+}
+inline void MsgFactoryInitParams::SetMsgAudioEncodedCountMax(TUint aCount, TUint aEncodedAudioCount)
+{
+    iMsgAudioEncodedCountMax = aCount;
+    iEncodedAudioCountMax = aEncodedAudioCount;
+}
+inline void MsgFactoryInitParams::SetMsgAudioPcmCountMax(TUint aCount, TUint aDecodedAudioCount)
+{
+    iMsgAudioPcmCountMax = aCount;
+    iDecodedAudioCountMax = aDecodedAudioCount;
+}
+inline void MsgFactoryInitParams::SetMemoryBudget(TUint aBudgetBytes)
+{
+    iMemoryBudgetBytes = aBudgetBytes;
+}
 inline void MsgFactoryInitParams::SetMsgSilenceCount(TUint aCount)
 {
     iMsgSilenceCount = aCount;
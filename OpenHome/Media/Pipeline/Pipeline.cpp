@@ -11,6 +11,7 @@
 #include <OpenHome/Media/Codec/MpegTs.h>
 #include <OpenHome/Media/Pipeline/DecodedAudioValidator.h>
 #include <OpenHome/Media/Pipeline/DecodedAudioAggregator.h>
+#include <OpenHome/Media/Pipeline/SampleRateConverter.h>
 #include <OpenHome/Media/Pipeline/SampleRateValidator.h>
 #include <OpenHome/Media/Pipeline/DecodedAudioReservoir.h>
 #include <OpenHome/Media/Pipeline/Ramper.h>
@@ -60,6 +61,14 @@ PipelineInitParams::PipelineInitParams()
     , iMaxLatencyJiffies(kMaxLatencyDefault)
     , iSupportElements(EPipelineSupportElementsAll)
     , iMuter(kMuterDefault)
+    , iSampleRateConversion(kSampleRateConversionDefault)
+    , iPrerollBytes(kPrerollBytesDefault)
+    , iSeekHistoryJiffies(kSeekHistoryDefault)
+    , iDecodedAudioMediumCount(kDecodedAudioMediumCountDefault)
+    , iDecodedAudioLargeCount(kDecodedAudioLargeCountDefault)
+    , iAudioMemoryBudgetBytes(kAudioMemoryBudgetDefault)
+    , iAggregationDefaultMs(kAggregationMsDefault)
+    , iAggregationSenderMs(kAggregationSenderMsDefault)
 {
     SetThreadPriorityMax(kThreadPriorityMax);
 }
@@ -142,6 +151,46 @@ void PipelineInitParams::SetMuter(MuterImpl aMuter)
     iMuter = aMuter;
 }
 
+void PipelineInitParams::SetSampleRateConversion(TBool aEnable)
+{
+    iSampleRateConversion = aEnable;
+}
+
+void PipelineInitParams::SetPrerollSize(TUint aBytes)
+{
+    iPrerollBytes = aBytes;
+}
+
+void PipelineInitParams::SetSeekHistory(TUint aJiffies)
+{
+    iSeekHistoryJiffies = aJiffies;
+}
+
+void PipelineInitParams::SetDecodedAudioSizeClasses(TUint aMediumCount, TUint aLargeCount)
+{
+    iDecodedAudioMediumCount = aMediumCount;
+    iDecodedAudioLargeCount = aLargeCount;
+}
+
+void PipelineInitParams::SetAudioMemoryBudget(TUint aBytes)
+{
+    iAudioMemoryBudgetBytes = aBytes;
+}
+
+void PipelineInitParams::SetAggregationWindows(TUint aDefaultMs, TUint aSenderMs)
+{
+    ASSERT(aDefaultMs >= kAggregationMsMin && aDefaultMs <= kAggregationMsMax);
+    ASSERT(aSenderMs >= kAggregationMsMin && aSenderMs <= kAggregationMsMax);
+    iAggregationDefaultMs = aDefaultMs;
+    iAggregationSenderMs = aSenderMs;
+}
+
+void PipelineInitParams::AddModeAggregationWindow(const TChar* aMode, TUint aMs)
+{
+    ASSERT(aMs >= kAggregationMsMin && aMs <= kAggregationMsMax);
+    iModeAggregationWindows.push_back(std::pair<Brn, TUint>(Brn(aMode), aMs));
+}
+
 TUint PipelineInitParams::EncodedReservoirBytes() const
 {
     return iEncodedReservoirBytes;
@@ -217,6 +266,60 @@ PipelineInitParams::MuterImpl PipelineInitParams::Muter() const
     return iMuter;
 }
 
+TBool PipelineInitParams::SampleRateConversion() const
+{
+    return iSampleRateConversion;
+}
+
+TUint PipelineInitParams::PrerollBytes() const
+{
+    return iPrerollBytes;
+}
+
+TUint PipelineInitParams::SeekHistoryJiffies() const
+{
+    return iSeekHistoryJiffies;
+}
+
+TUint PipelineInitParams::DecodedAudioMediumCount() const
+{
+    return iDecodedAudioMediumCount;
+}
+
+TUint PipelineInitParams::DecodedAudioLargeCount() const
+{
+    return iDecodedAudioLargeCount;
+}
+
+TUint PipelineInitParams::AudioMemoryBudgetBytes() const
+{
+    return iAudioMemoryBudgetBytes;
+}
+
+TUint PipelineInitParams::AggregationDefaultMs() const
+{
+    return iAggregationDefaultMs;
+}
+
+TUint PipelineInitParams::AggregationSenderMs() const
+{
+    return iAggregationSenderMs;
+}
+
+const std::vector<std::pair<Brn, TUint>>& PipelineInitParams::ModeAggregationWindows() const
+{
+    return iModeAggregationWindows;
+}
+
+TUint PipelineInitParams::AggregationMaxMs() const
+{
+    TUint maxMs = std::max(iAggregationDefaultMs, iAggregationSenderMs);
+    for (const auto& window : iModeAggregationWindows) {
+        maxMs = std::max(maxMs, window.second);
+    }
+    return maxMs;
+}
+
 
 // Pipeline
 
@@ -251,9 +354,11 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                                  (kReceiverMaxLatency + kSongcastFrameJiffies - 1) / kSongcastFrameJiffies);
     const TUint maxEncodedReservoirMsgs = encodedAudioCount;
     encodedAudioCount += kRewinderMaxMsgs; // this may only be required on platforms that don't guarantee priority based thread scheduling
+    encodedAudioCount += (aInitParams->PrerollBytes() + EncodedAudio::kMaxBytes - 1) / EncodedAudio::kMaxBytes;
     const TUint msgEncodedAudioCount = encodedAudioCount + 100; // +100 allows for Split()ing by Container and CodecController
     const TUint decodedReservoirSize = aInitParams->DecodedReservoirJiffies() + aInitParams->StarvationRamperMinJiffies();
-    const TUint decodedAudioCount = ((decodedReservoirSize + iInitParams->SenderMinLatency()) / DecodedAudioAggregator::kMaxJiffies) + 200; // +200 allows for songcast sender, some smaller msgs and some buffering in non-reservoir elements
+    TUint decodedAudioCount = ((decodedReservoirSize + iInitParams->SenderMinLatency()) / DecodedAudioAggregator::kMaxJiffies) + 200; // +200 allows for songcast sender, some smaller msgs and some buffering in non-reservoir elements
+    decodedAudioCount += (aInitParams->SeekHistoryJiffies() + DecodedAudioAggregator::kMaxJiffies - 1) / DecodedAudioAggregator::kMaxJiffies; // retained by Seeker
     const TUint msgAudioPcmCount = decodedAudioCount + 100; // +100 allows for Split()ing in various elements
     const TUint msgHaltCount = perStreamMsgCount * 2; // worst case is tiny Vorbis track with embedded metatext in a single-track playlist with repeat
     MsgFactoryInitParams msgInit;
@@ -262,14 +367,30 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     msgInit.SetMsgDrainCount(kMsgCountDrain);
     msgInit.SetMsgDelayCount(perStreamMsgCount);
     msgInit.SetMsgEncodedStreamCount(perStreamMsgCount);
-    msgInit.SetMsgAudioEncodedCount(msgEncodedAudioCount, encodedAudioCount);
+    if (aInitParams->AudioMemoryBudgetBytes() == 0) {
+        msgInit.SetMsgAudioEncodedCount(msgEncodedAudioCount, encodedAudioCount);
+    }
+    else {
+        // start with enough for typical use; grow towards the worst case sizes calculated above on demand
+        msgInit.SetMsgAudioEncodedCount(msgEncodedAudioCount / kElasticPoolInitialFraction, encodedAudioCount / kElasticPoolInitialFraction);
+        msgInit.SetMsgAudioEncodedCountMax(msgEncodedAudioCount, encodedAudioCount);
+        msgInit.SetMemoryBudget(aInitParams->AudioMemoryBudgetBytes());
+    }
     msgInit.SetMsgMetaTextCount(perStreamMsgCount);
     msgInit.SetMsgStreamInterruptedCount(perStreamMsgCount);
     msgInit.SetMsgHaltCount(msgHaltCount);
     msgInit.SetMsgFlushCount(kMsgCountFlush);
     msgInit.SetMsgWaitCount(perStreamMsgCount);
     msgInit.SetMsgDecodedStreamCount(perStreamMsgCount);
-    msgInit.SetMsgAudioPcmCount(msgAudioPcmCount, decodedAudioCount);
+    if (aInitParams->AudioMemoryBudgetBytes() == 0) {
+        msgInit.SetMsgAudioPcmCount(msgAudioPcmCount, decodedAudioCount);
+    }
+    else {
+        msgInit.SetMsgAudioPcmCount(msgAudioPcmCount / kElasticPoolInitialFraction, decodedAudioCount / kElasticPoolInitialFraction);
+        msgInit.SetMsgAudioPcmCountMax(msgAudioPcmCount, decodedAudioCount);
+    }
+    msgInit.SetDecodedAudioSizeClasses(aInitParams->DecodedAudioMediumCount(), aInitParams->DecodedAudioLargeCount(),
+                                       aInitParams->AggregationMaxMs());
     msgInit.SetMsgSilenceCount(kMsgCountSilence);
     msgInit.SetMsgPlayableCount(kMsgCountPlayablePcm, kMsgCountPlayableSilence);
     msgInit.SetMsgQuitCount(kMsgCountQuit);
@@ -319,14 +440,26 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                    downstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iDecodedAudioAggregator, new DecodedAudioAggregator(*downstream),
                    downstream, elementsSupported, EPipelineSupportElementsMandatory);
+    iDecodedAudioAggregator->SetWindows(aInitParams->AggregationDefaultMs(), aInitParams->AggregationSenderMs());
+    for (const auto& window : aInitParams->ModeAggregationWindows()) {
+        iDecodedAudioAggregator->AddModeWindow(window.first, window.second);
+    }
 
     ATTACH_ELEMENT(iLoggerSampleRateValidator, new Logger("Sample Rate Validator", *iDecodedAudioAggregator),
                    downstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iSampleRateValidator, new SampleRateValidator(*iMsgFactory, *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsMandatory);
+    iSampleRateConverter = nullptr;
+    iLoggerSampleRateConverter = nullptr;
+    if (aInitParams->SampleRateConversion()) {
+        ATTACH_ELEMENT(iLoggerSampleRateConverter, new Logger("Sample Rate Converter", *downstream),
+                       downstream, elementsSupported, EPipelineSupportElementsLogger);
+        ATTACH_ELEMENT(iSampleRateConverter, new SampleRateConverter(*iMsgFactory, *downstream),
+                       downstream, elementsSupported, EPipelineSupportElementsMandatory);
+    }
 
     // construct push logger slightly out of sequence
-    ATTACH_ELEMENT(iRampValidatorCodec, new RampValidator("Codec Controller", *iSampleRateValidator),
+    ATTACH_ELEMENT(iRampValidatorCodec, new RampValidator("Codec Controller", *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsRampValidator);
     ATTACH_ELEMENT(iLoggerCodecController, new Logger("Codec Controller", *downstream),
                    downstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -344,7 +477,9 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
     ATTACH_ELEMENT(iRampValidatorRamper, new RampValidator(*upstream, "Ramper"),
                    upstream, elementsSupported, EPipelineSupportElementsRampValidator);
-    ATTACH_ELEMENT(iSeeker, new Seeker(*iMsgFactory, *upstream, *iCodecController, aSeekRestreamer, aInitParams->RampShortJiffies()),
+    ATTACH_ELEMENT(iSeeker, new Seeker(*iMsgFactory, *upstream, *iCodecController, aSeekRestreamer,
+                                       *iDecodedAudioReservoir, aInitParams->RampShortJiffies(),
+                                       aInitParams->SeekHistoryJiffies()),
                    upstream, elementsSupported, EPipelineSupportElementsMandatory);
     ATTACH_ELEMENT(iLoggerSeeker, new Logger(*iSeeker, "Seeker"),
                    upstream, elementsSupported, EPipelineSupportElementsLogger);
@@ -491,6 +626,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     //iLoggerEncodedAudioReservoir->SetEnabled(true);
     //iLoggerContainer->SetEnabled(true);
     //iLoggerCodecController->SetEnabled(true);
+    //iLoggerSampleRateConverter->SetEnabled(true);
     //iLoggerSampleRateValidator->SetEnabled(true);
     //iLoggerDecodedAudioAggregator->SetEnabled(true);
     //iLoggerDecodedAudioReservoir->SetEnabled(true);
@@ -520,6 +656,7 @@ Pipeline::Pipeline(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggreg
     //iLoggerEncodedAudioReservoir->SetFilter(Logger::EMsgAll);
     //iLoggerContainer->SetFilter(Logger::EMsgAll);
     //iLoggerCodecController->SetFilter(Logger::EMsgAll);
+    //iLoggerSampleRateConverter->SetFilter(Logger::EMsgAll);
     //iLoggerSampleRateValidator->SetFilter(Logger::EMsgAll);
     //iLoggerDecodedAudioAggregator->SetFilter(Logger::EMsgAll);
     //iLoggerDecodedAudioReservoir->SetFilter(Logger::EMsgAll);
@@ -614,6 +751,8 @@ Pipeline::~Pipeline()
     delete iDecodedAudioAggregator;
     delete iLoggerSampleRateValidator;
     delete iSampleRateValidator;
+    delete iLoggerSampleRateConverter;
+    delete iSampleRateConverter;
     delete iRampValidatorCodec;
     delete iLoggerCodecController;
     delete iLoggerContainer;
@@ -794,11 +933,21 @@ ISpotifyTrackObserver& Pipeline::SpotifyTrackObserver() const
     return *iSpotifyReporter;
 }
 
+IPullableClock* Pipeline::SoftwareClock() const
+{
+    return iSampleRateConverter;
+}
+
 IPipelineElementUpstream& Pipeline::InsertElements(IPipelineElementUpstream& aTail)
 {
     return iRouter->InsertElements(aTail);
 }
 
+ISenderActivityObserver& Pipeline::SenderActivityObserver() const
+{
+    return *iDecodedAudioAggregator;
+}
+
 TUint Pipeline::SenderMinLatencyMs() const
 {
     return Jiffies::ToMs(iInitParams->SenderMinLatency());
@@ -844,6 +993,9 @@ Msg* Pipeline::Pull()
 
 void Pipeline::SetAnimator(IPipelineAnimator& aAnimator)
 {
+    if (iSampleRateConverter != nullptr) {
+        iSampleRateConverter->SetAnimator(aAnimator);
+    }
     iSampleRateValidator->SetAnimator(aAnimator);
     iVariableDelay2->SetAnimator(aAnimator);
     if (iMuterSamples != nullptr) {
@@ -12,6 +12,9 @@
 #include <OpenHome/Media/MuteManager.h>
 #include <OpenHome/Media/Pipeline/Attenuator.h>
 
+#include <utility>
+#include <vector>
+
 EXCEPTION(PipelineStreamNotPausable)
 
 namespace OpenHome {
@@ -53,6 +56,13 @@ public:
     void SetMaxLatency(TUint aJiffies);
     void SetSupportElements(TUint aElements); // EPipelineSupportElements members OR'd together
     void SetMuter(MuterImpl aMuter);
+    void SetSampleRateConversion(TBool aEnable); // convert streams the animator can't play; also allows the output clock to be pulled
+    void SetPrerollSize(TUint aBytes); // encoded audio fetched in advance for the next track; 0 disables
+    void SetSeekHistory(TUint aJiffies); // recently played audio retained for backward seeks; 0 disables
+    void SetDecodedAudioSizeClasses(TUint aMediumCount, TUint aLargeCount); // larger decoded audio cells for high rate/multichannel streams; 0 disables
+    void SetAudioMemoryBudget(TUint aBytes); // >0 => audio msg pools start small, growing on demand up to their usual size.  Decoded audio size classes are limited to what remains of aBytes
+    void SetAggregationWindows(TUint aDefaultMs, TUint aSenderMs); // duration of decoded audio msgs; aSenderMs applies while a Songcast sender has listeners.  [5..100]ms
+    void AddModeAggregationWindow(const TChar* aMode, TUint aMs); // overrides SetAggregationWindows() for aMode.  aMode must remain valid for the lifetime of the pipeline
     // getters
     TUint EncodedReservoirBytes() const;
     TUint DecodedReservoirJiffies() const;
@@ -69,6 +79,16 @@ public:
     TUint MaxLatencyJiffies() const;
     TUint SupportElements() const;
     MuterImpl Muter() const;
+    TBool SampleRateConversion() const;
+    TUint PrerollBytes() const;
+    TUint SeekHistoryJiffies() const;
+    TUint DecodedAudioMediumCount() const;
+    TUint DecodedAudioLargeCount() const;
+    TUint AudioMemoryBudgetBytes() const;
+    TUint AggregationDefaultMs() const;
+    TUint AggregationSenderMs() const;
+    const std::vector<std::pair<Brn, TUint>>& ModeAggregationWindows() const;
+    TUint AggregationMaxMs() const;
 private:
     PipelineInitParams();
 private:
@@ -87,6 +107,15 @@ private:
     TUint iMaxLatencyJiffies;
     TUint iSupportElements;
     MuterImpl iMuter;
+    TBool iSampleRateConversion;
+    TUint iPrerollBytes;
+    TUint iSeekHistoryJiffies;
+    TUint iDecodedAudioMediumCount;
+    TUint iDecodedAudioLargeCount;
+    TUint iAudioMemoryBudgetBytes;
+    TUint iAggregationDefaultMs;
+    TUint iAggregationSenderMs;
+    std::vector<std::pair<Brn, TUint>> iModeAggregationWindows;
 private:
     static const TUint kEncodedReservoirSizeBytes       = 1536 * 1024;
     static const TUint kDecodedReservoirSize            = Jiffies::kPerMs * 2000;
@@ -100,6 +129,16 @@ private:
     static const TUint kThreadPriorityMax               = kPriorityHighest - 1;
     static const TUint kMaxLatencyDefault               = Jiffies::kPerMs * 2000;
     static const MuterImpl kMuterDefault                = MuterImpl::eRampSamples;
+    static const TBool kSampleRateConversionDefault     = false;
+    static const TUint kPrerollBytesDefault             = 0;
+    static const TUint kSeekHistoryDefault              = 0;
+    static const TUint kDecodedAudioMediumCountDefault  = 0;
+    static const TUint kDecodedAudioLargeCountDefault   = 0;
+    static const TUint kAudioMemoryBudgetDefault        = 0;
+    static const TUint kAggregationMsDefault            = 5;
+    static const TUint kAggregationSenderMsDefault      = 5; // Songcast frame size
+    static const TUint kAggregationMsMin                = 5; // msg pools are sized assuming no smaller msgs
+    static const TUint kAggregationMsMax                = 100;
 };
 
 namespace Codec {
@@ -113,6 +152,7 @@ class AudioDumper;
 class EncodedAudioReservoir;
 class Logger;
 class DecodedAudioValidator;
+class SampleRateConverter;
 class SampleRateValidator;
 class DecodedAudioAggregator;
 class DecodedAudioReservoir;
@@ -139,6 +179,7 @@ class PreDriver;
 class ITrackObserver;
 class ISpotifyReporter;
 class ISpotifyTrackObserver;
+class IPullableClock;
 class IMimeTypeList;
 class AnalogBypassRamper;
 class IAnalogBypassVolumeRamper;
@@ -161,6 +202,7 @@ class Pipeline : public IPipelineElementDownstream
     static const TUint kReservoirCount          = 5; // Encoded + Decoded + (optional) Songcast sender + StarvationRamper + spare
     static const TUint kSongcastFrameJiffies    = Jiffies::kPerMs * 5; // effectively hard-coded by volkano1
     static const TUint kRewinderMaxMsgs         = 100;
+    static const TUint kElasticPoolInitialFraction = 4; // audio pools start at 1/4 of their max size if given a memory budget
 
     static const TUint kMsgCountSilence         = 410; // 2secs @ 5ms per msg + 10 spare
     static const TUint kMsgCountPlayablePcm     = 10;
@@ -191,7 +233,9 @@ public:
     void AddObserver(ITrackObserver& aObserver);
     ISpotifyReporter& SpotifyReporter() const;
     ISpotifyTrackObserver& SpotifyTrackObserver() const;
+    IPullableClock* SoftwareClock() const; // nullptr unless PipelineInitParams::SetSampleRateConversion(true)
     IPipelineElementUpstream& InsertElements(IPipelineElementUpstream& aTail);
+    ISenderActivityObserver& SenderActivityObserver() const;
     TUint SenderMinLatencyMs() const;
     void GetThreadPriorityRange(TUint& aMin, TUint& aMax) const;
     void GetThreadPriorities(TUint& aFlywheelRamper, TUint& aStarvationRamper, TUint& aCodec, TUint& aEvent);
@@ -252,6 +296,8 @@ private:
     Codec::CodecController* iCodecController;
     Logger* iLoggerCodecController;
     RampValidator* iRampValidatorCodec;
+    SampleRateConverter* iSampleRateConverter;
+    Logger* iLoggerSampleRateConverter;
     SampleRateValidator* iSampleRateValidator;
     Logger* iLoggerSampleRateValidator;
     DecodedAudioAggregator* iDecodedAudioAggregator;
@@ -0,0 +1,378 @@
+#include <OpenHome/Media/Pipeline/SampleRateConverter.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Resampler.h>
+#include <OpenHome/Media/Debug.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+const TUint SampleRateConverter::kSupportedMsgTypes =   eMode
+                                                      | eTrack
+                                                      | eDrain
+                                                      | eDelay
+                                                      | eEncodedStream
+                                                      | eMetatext
+                                                      | eStreamInterrupted
+                                                      | eHalt
+                                                      | eFlush
+                                                      | eWait
+                                                      | eDecodedStream
+                                                      | eBitRate
+                                                      | eAudioPcm
+                                                      | eSilence
+                                                      | eQuit;
+
+const TUint SampleRateConverter::kRates[] = { 8000, 11025, 12000, 16000, 22050, 24000, 32000,
+                                              44100, 48000, 88200, 96000, 176400, 192000 };
+
+SampleRateConverter::SampleRateConverter(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstreamElement)
+    : PipelineElement(kSupportedMsgTypes)
+    , iMsgFactory(aMsgFactory)
+    , iDownstream(aDownstreamElement)
+    , iAnimator(nullptr)
+    , iInputSamples(0)
+    , iMultiplier(kNominalFreq)
+    , iActive(false)
+    , iConverting(false)
+    , iRateOut(0)
+    , iBitDepthOut(0)
+    , iNumChannels(0)
+    , iTrackOffset(0)
+{
+    iResampler = new Resampler(kMaxInputSamples);
+    iInput = new TInt32[kMaxInputSamples];
+    iOutput = new TInt32[kMaxOutputSamples];
+}
+
+SampleRateConverter::~SampleRateConverter()
+{
+    delete[] iOutput;
+    delete[] iInput;
+    delete iResampler;
+}
+
+void SampleRateConverter::SetAnimator(IPipelineAnimator& aPipelineAnimator)
+{
+    iAnimator = &aPipelineAnimator;
+}
+
+void SampleRateConverter::PullClock(TUint aMultiplier)
+{
+    aMultiplier = std::max(kNominalFreq - kMaxPull, std::min(kNominalFreq + kMaxPull, aMultiplier));
+    iMultiplier.store(aMultiplier);
+}
+
+TUint SampleRateConverter::MaxPull() const
+{
+    return kMaxPull;
+}
+
+void SampleRateConverter::Push(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    if (msg != nullptr) {
+        iDownstream.Push(msg);
+    }
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgMode* aMsg)
+{
+    EndStream(true);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgTrack* aMsg)
+{
+    EndStream(true);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgDrain* aMsg)
+{
+    EndStream(false);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    EndStream(true);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgStreamInterrupted* aMsg)
+{
+    EndStream(false);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgHalt* aMsg)
+{
+    EndStream(false);
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgFlush* aMsg)
+{
+    // audio preceding a flush is being discarded; don't output its tail
+    if (iActive) {
+        iResampler->Reset();
+    }
+    return aMsg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    EndStream(true);
+    ASSERT(iAnimator != nullptr);
+    const DecodedStreamInfo& info = aMsg->StreamInfo();
+    const TUint sampleRate = info.SampleRate();
+    iNumChannels = info.NumChannels();
+    if (iNumChannels == 0 || iNumChannels > Resampler::kMaxChannels) {
+        return aMsg;
+    }
+    iTrackOffset = info.SampleStart() * Jiffies::PerSample(sampleRate);
+
+    if (IsSupported(sampleRate, info.BitDepth(), iNumChannels)) {
+        iResampler->Configure(sampleRate, sampleRate, iNumChannels);
+        iRateOut = sampleRate;
+        iBitDepthOut = info.BitDepth();
+        iActive = true;
+        ApplyPull();
+        return aMsg;
+    }
+
+    const TUint bitDepth = (info.BitDepth() > 24? 32 : 24);
+    const TUint rate = SelectRate(sampleRate, bitDepth, iNumChannels);
+    if (rate == 0) {
+        return aMsg; // SampleRateValidator will reject this stream
+    }
+    LOG(kPipeline, "SampleRateConverter: stream %u converted from %u/%u to %u/%u\n",
+                   info.StreamId(), sampleRate, info.BitDepth(), rate, bitDepth);
+    iResampler->Configure(sampleRate, rate, iNumChannels);
+    iRateOut = rate;
+    iBitDepthOut = bitDepth;
+    iActive = true;
+    iConverting = true;
+    ApplyPull();
+    const TUint64 sampleStart = (info.SampleStart() * rate) / sampleRate;
+    MsgDecodedStream* msg = iMsgFactory.CreateMsgDecodedStream(info.StreamId(), info.BitRate(), bitDepth, rate, iNumChannels,
+                                                               info.CodecName(), info.TrackLength(), sampleStart,
+                                                               info.Lossless(), info.Seekable(), info.Live(),
+                                                               info.AnalogBypass(), info.Multiroom(), info.Profile(),
+                                                               info.StreamHandler());
+    aMsg->RemoveRef();
+    return msg;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    if (!iActive) {
+        return aMsg;
+    }
+    ApplyPull();
+    if (!iConverting) {
+        /* Keep history of recent audio so that conversion can start seamlessly if the clock is pulled.
+           Only the last Resampler::kCentreTap frames are needed to resume, so skip reading the rest. */
+        iTrackOffset = aMsg->TrackOffset() + aMsg->Jiffies();
+        MsgAudioPcm* history = static_cast<MsgAudioPcm*>(aMsg->Clone());
+        const TUint jiffiesPerSample = Jiffies::PerSample(iResampler->RateIn());
+        const TUint frames = history->Jiffies() / jiffiesPerSample;
+        if (frames > Resampler::kCentreTap) {
+            MsgAudio* tail = history->Split((frames - Resampler::kCentreTap) * jiffiesPerSample);
+            history->RemoveRef();
+            history = static_cast<MsgAudioPcm*>(tail);
+        }
+        ReadInput(history);
+        return aMsg;
+    }
+    ReadInput(aMsg);
+    return nullptr;
+}
+
+Msg* SampleRateConverter::ProcessMsg(MsgSilence* aMsg)
+{
+    if (!iActive) {
+        return aMsg;
+    }
+    ApplyPull();
+    const TUint maxFrames = kMaxInputSamples / iNumChannels;
+    TUint frames = Jiffies::ToSamples(aMsg->Jiffies(), iResampler->RateIn());
+    if (!iConverting) {
+        frames = std::min(frames, Resampler::kCentreTap); // only recent history is needed (see ProcessMsg(MsgAudioPcm*))
+    }
+    while (frames > 0) {
+        const TUint count = std::min(frames, maxFrames);
+        iResampler->PushSilence(count);
+        if (iConverting) {
+            Output();
+        }
+        else {
+            iResampler->Bypass();
+        }
+        frames -= count;
+    }
+    if (!iConverting) {
+        return aMsg;
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+void SampleRateConverter::BeginBlock()
+{
+}
+
+void SampleRateConverter::ProcessFragment8(const Brx& aData, TUint /*aNumChannels*/)
+{
+    AppendSamples(aData, 1);
+}
+
+void SampleRateConverter::ProcessFragment16(const Brx& aData, TUint /*aNumChannels*/)
+{
+    AppendSamples(aData, 2);
+}
+
+void SampleRateConverter::ProcessFragment24(const Brx& aData, TUint /*aNumChannels*/)
+{
+    AppendSamples(aData, 3);
+}
+
+void SampleRateConverter::ProcessFragment32(const Brx& aData, TUint /*aNumChannels*/)
+{
+    AppendSamples(aData, 4);
+}
+
+void SampleRateConverter::EndBlock()
+{
+    Convert();
+}
+
+void SampleRateConverter::Flush()
+{
+}
+
+TBool SampleRateConverter::IsSupported(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels)
+{
+    try {
+        (void)iAnimator->PipelineAnimatorDelayJiffies(aSampleRate, aBitDepth, aNumChannels);
+        return true;
+    }
+    catch (SampleRateUnsupported&) {
+        return false;
+    }
+}
+
+TUint SampleRateConverter::SelectRate(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels)
+{
+    // lowest supported rate above aSampleRate; failing that, the highest supported rate
+    TUint highest = 0;
+    for (TUint rate : kRates) {
+        if (!IsSupported(rate, aBitDepth, aNumChannels)) {
+            continue;
+        }
+        if (rate > aSampleRate) {
+            return rate;
+        }
+        highest = rate;
+    }
+    return highest;
+}
+
+void SampleRateConverter::ReadInput(MsgAudioPcm* aMsg)
+{
+    MsgPlayable* playable = aMsg->CreatePlayable();
+    playable->Read(*this);
+    playable->RemoveRef();
+}
+
+void SampleRateConverter::ApplyPull()
+{
+    const TUint multiplier = iMultiplier.load();
+    if (multiplier != iResampler->Multiplier()) {
+        iResampler->SetPull(multiplier);
+    }
+    if (!iConverting && multiplier != kNominalFreq) {
+        LOG(kPipeline, "SampleRateConverter: clock pulled, converting %u/%u\n", iRateOut, iBitDepthOut);
+        iConverting = true;
+    }
+}
+
+void SampleRateConverter::Convert()
+{
+    const TUint frames = iInputSamples / iNumChannels;
+    iInputSamples = 0;
+    if (frames == 0) {
+        return;
+    }
+    iResampler->Push(iInput, frames);
+    if (iConverting) {
+        Output();
+    }
+    else {
+        iResampler->Bypass();
+    }
+}
+
+void SampleRateConverter::EndStream(TBool aOutputTail)
+{
+    if (!iActive) {
+        return;
+    }
+    if (iConverting) {
+        iResampler->Drain();
+        Output();
+    }
+    iResampler->Reset();
+    if (aOutputTail) { // start of a new stream or track
+        iActive = false;
+        iConverting = false;
+    }
+}
+
+void SampleRateConverter::Output()
+{
+    const TUint bytesPerSample = iBitDepthOut / 8;
+    const TUint maxFrames = AudioData::kMaxBytes / (iNumChannels * bytesPerSample);
+    ASSERT(maxFrames * iNumChannels <= kMaxOutputSamples);
+    for (;;) {
+        const TUint frames = iResampler->Pull(iOutput, maxFrames);
+        if (frames == 0) {
+            break;
+        }
+        const TUint samples = frames * iNumChannels;
+        TByte* dest = const_cast<TByte*>(iOutputBuf.Ptr());
+        for (TUint i=0; i<samples; i++) {
+            const TUint32 sample = (TUint32)iOutput[i];
+            for (TUint j=0; j<bytesPerSample; j++) {
+                *dest++ = (TByte)(sample >> (24 - 8*j));
+            }
+        }
+        iOutputBuf.SetBytes(samples * bytesPerSample);
+        MsgAudioPcm* msg = iMsgFactory.CreateMsgAudioPcm(iOutputBuf, iNumChannels, iRateOut, iBitDepthOut,
+                                                         AudioDataEndian::Big, iTrackOffset);
+        iTrackOffset += msg->Jiffies();
+        iDownstream.Push(msg);
+    }
+}
+
+void SampleRateConverter::AppendSamples(const Brx& aData, TUint aBytesPerSample)
+{
+    const TUint capacity = (kMaxInputSamples / iNumChannels) * iNumChannels;
+    const TByte* src = aData.Ptr();
+    const TUint samples = aData.Bytes() / aBytesPerSample;
+    for (TUint i=0; i<samples; i++) {
+        if (iInputSamples == capacity) {
+            Convert();
+        }
+        // left-justify so that all bit depths share a common scale
+        TUint32 sample = 0;
+        for (TUint j=0; j<aBytesPerSample; j++) {
+            sample |= (TUint32)*src++ << (24 - 8*j);
+        }
+        iInput[iInputSamples++] = (TInt32)sample;
+    }
+}
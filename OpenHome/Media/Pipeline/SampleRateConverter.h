@@ -0,0 +1,98 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+#include <atomic>
+
+namespace OpenHome {
+namespace Media {
+
+class Resampler;
+
+/*
+    Element which converts streams to a sample rate the animator supports.
+
+    Sits immediately upstream of SampleRateValidator.  A stream whose rate is supported is
+    passed through unmodified.  Otherwise the lowest supported rate above the stream's
+    (or the highest supported rate if there are none above it) is chosen and the stream is
+    converted to it (at 24-bit, or 32-bit for 32-bit sources).  Conversion is done in single
+    precision float so converted audio has ~24 bits of precision whatever its output depth.
+
+    Also implements IPullableClock so that fixed rate DACs can recover a sender's clock.
+    While the clock is pulled, audio is converted using a ratio adjusted by the pull
+    multiplier.  Streams are switched from pass through to conversion seamlessly; once
+    switched, they remain converted until the next MsgDecodedStream.
+*/
+
+class SampleRateConverter : public PipelineElement
+                          , public IPipelineElementDownstream
+                          , public IPullableClock
+                          , private IPcmProcessor
+                          , private INonCopyable
+{
+    friend class SuiteSampleRateConverter;
+
+    static const TUint kSupportedMsgTypes;
+    static const TUint kMaxPull = kNominalFreq / 100; // 1%
+    static const TUint kMaxInputSamples = AudioData::kMaxBytes; // one (8-bit) sample per byte in the worst case
+    static const TUint kMaxOutputSamples = AudioData::kMaxBytes; // as above; output bit depth matches input when the clock is pulled
+    static const TUint kRates[];
+public:
+    SampleRateConverter(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstreamElement);
+    ~SampleRateConverter();
+    void SetAnimator(IPipelineAnimator& aPipelineAnimator);
+public: // from IPullableClock
+    void PullClock(TUint aMultiplier) override;
+    TUint MaxPull() const override;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+private: // from IPcmProcessor
+    void BeginBlock() override;
+    void ProcessFragment8(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment16(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment24(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment32(const Brx& aData, TUint aNumChannels) override;
+    void EndBlock() override;
+    void Flush() override;
+private:
+    TBool IsSupported(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels);
+    TUint SelectRate(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels);
+    void ReadInput(MsgAudioPcm* aMsg);
+    void ApplyPull();
+    void Convert();
+    void EndStream(TBool aOutputTail);
+    void Output();
+    void AppendSamples(const Brx& aData, TUint aBytesPerSample);
+private:
+    MsgFactory& iMsgFactory;
+    IPipelineElementDownstream& iDownstream;
+    IPipelineAnimator* iAnimator;
+    Resampler* iResampler;
+    TInt32* iInput;
+    TUint iInputSamples;
+    TInt32* iOutput;
+    Bws<AudioData::kMaxBytes> iOutputBuf;
+    std::atomic<TUint> iMultiplier;
+    TBool iActive;      // stream can be converted (iResampler is configured for it)
+    TBool iConverting;  // audio is being converted rather than passed through
+    TUint iRateOut;
+    TUint iBitDepthOut;
+    TUint iNumChannels;
+    TUint64 iTrackOffset;
+};
+
+} // namespace Media
+} // namespace OpenHome
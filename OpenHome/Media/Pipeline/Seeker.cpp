@@ -9,12 +9,14 @@
 using namespace OpenHome;
 using namespace OpenHome::Media;
 
-Seeker::Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, ISeeker& aSeeker, ISeekRestreamer& aRestreamer, TUint aRampDuration)
+Seeker::Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, ISeeker& aSeeker, ISeekRestreamer& aRestreamer,
+               IDecodedAudioBuffer& aDecodedAudioBuffer, TUint aRampDuration, TUint aHistoryJiffies)
     : iFlusher(aUpstreamElement, "Seeker")
     , iMsgFactory(aMsgFactory)
     , iUpstreamElement(aUpstreamElement)
     , iSeeker(aSeeker)
     , iRestreamer(aRestreamer)
+    , iDecodedAudioBuffer(aDecodedAudioBuffer)
     , iLock("SEEK")
     , iState(ERunning)
     , iRampDuration(aRampDuration)
@@ -29,11 +31,17 @@ Seeker::Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamEleme
     , iMsgStream(nullptr)
     , iSeekInNextStream(false)
     , iDecodeDiscardUntilSeekPoint(false)
+    , iHistoryMaxJiffies(aHistoryJiffies)
+    , iHistoryJiffies(0)
+    , iUpstreamPosJiffies(0)
+    , iPulledUpstream(false)
+    , iSeekPending(false)
 {
 }
 
 Seeker::~Seeker()
 {
+    ClearHistory();
     if (iMsgStream != nullptr) {
         iMsgStream->RemoveRef();
     }
@@ -43,8 +51,8 @@ void Seeker::Seek(TUint aStreamId, TUint aSecondsAbsolute, TBool aRampDown)
 {
     LOG(kPipeline, "> Seeker::Seek(%u, %u, %u)\n", aStreamId, aSecondsAbsolute, aRampDown);
     AutoMutex a(iLock);
-    if (iState != ERunning) {
-        LOG(kPipeline, "Seek request rejected - iState = %u\n", iState);
+    if (iState != ERunning || iSeekPending) {
+        LOG(kPipeline, "Seek request rejected - iState = %u, iSeekPending = %u\n", iState, iSeekPending);
         THROW(SeekAlreadyInProgress);
     }
     if (iStreamId != aStreamId) {
@@ -69,7 +77,15 @@ void Seeker::Seek(TUint aStreamId, TUint aSecondsAbsolute, TBool aRampDown)
         // leave iCurrentRampValue unchanged
     }
     else if (!aRampDown || iState == EFlushing) {
-        DoSeek();
+        if (BufferedSeekPossible()) {
+            /* Seeking within buffered audio rebuilds iQueue, so must be done from Pull().
+               Doing it here could let a msg Pull() has already taken from upstream
+               overtake the replayed audio. */
+            iSeekPending = true;
+        }
+        else {
+            DoSeek();
+        }
     }
     else {
         LOG(kPipeline, "Seeker state -> RampingDown\n");
@@ -83,8 +99,16 @@ Msg* Seeker::Pull()
 {
     Msg* msg;
     do {
-        msg = ((iStreamIsSeekable && !iQueue.IsEmpty())? iQueue.Dequeue() : iFlusher.Pull());
         iLock.Wait();
+        if (iSeekPending) {
+            iSeekPending = false;
+            DoSeek();
+        }
+        iLock.Signal();
+        const TBool fromQueue = (iStreamIsSeekable && !iQueue.IsEmpty());
+        msg = (fromQueue? iQueue.Dequeue() : iFlusher.Pull());
+        iLock.Wait();
+        iPulledUpstream = !fromQueue;
         msg = msg->Process(*this);
         iLock.Signal();
     } while (msg == nullptr);
@@ -93,12 +117,14 @@ Msg* Seeker::Pull()
 
 Msg* Seeker::ProcessMsg(MsgMode* aMsg)
 {
+    ClearHistory();
     iMode.Replace(aMsg->Mode());
     return aMsg;
 }
 
 Msg* Seeker::ProcessMsg(MsgTrack* aMsg)
 {
+    ClearHistory();
     iTrackId = aMsg->Track().Id();
     return aMsg;
 }
@@ -128,6 +154,8 @@ Msg* Seeker::ProcessMsg(MsgEncodedStream* aMsg)
     iFlushEndJiffies = 0;
     iStreamId = aMsg->StreamId();
     iStreamIsSeekable = aMsg->Seekable();
+    iSeekPending = false;
+    ClearHistory();
     return aMsg;
 }
 
@@ -154,6 +182,7 @@ Msg* Seeker::ProcessMsg(MsgHalt* aMsg)
 
 Msg* Seeker::ProcessMsg(MsgFlush* aMsg)
 {
+    ClearHistory();
     if (iTargetFlushId != MsgFlush::kIdInvalid && iTargetFlushId == aMsg->Id()) {
         ASSERT(iState == EFlushing);
         aMsg->RemoveRef();
@@ -183,6 +212,10 @@ Msg* Seeker::ProcessMsg(MsgDecodedStream* aMsg)
     iStreamPosJiffies = Jiffies::PerSample(streamInfo.SampleRate()) * streamInfo.SampleStart();
     iDecodeDiscardUntilSeekPoint = false;
     iFlushEndJiffies = 0;
+    if (iPulledUpstream) { // rather than generated by TrySeekHistory()
+        ClearHistory();
+        iUpstreamPosJiffies = iStreamPosJiffies;
+    }
     if (iSeekInNextStream) {
         iSeekInNextStream = false;
         DoSeek();
@@ -207,6 +240,9 @@ Msg* Seeker::ProcessMsg(MsgBitRate* aMsg)
 
 Msg* Seeker::ProcessMsg(MsgAudioPcm* aMsg)
 {
+    if (iPulledUpstream) {
+        RecordHistory(aMsg);
+    }
     if (iDecodeDiscardUntilSeekPoint && iFlushEndJiffies == iStreamPosJiffies) {
         ASSERT(iState == EFlushing);
         iState = ERampingUp;
@@ -310,6 +346,9 @@ void Seeker::NotifySeekComplete(TUint aHandle, TUint aFlushId)
 void Seeker::DoSeek()
 {
     LOG(kPipeline, "> Seeker::DoSeek()\n");
+    if (TrySeekBuffered()) {
+        return;
+    }
     iState = EFlushing; /* set this before calling StartSeek as its possible NotifySeekComplete
                            could be called from another thread before StartSeek returns. */
     iSeeker.StartSeek(iStreamId, iSeekSeconds, *this, iSeekHandle);
@@ -323,6 +362,72 @@ void Seeker::DoSeek()
     }
 }
 
+TBool Seeker::BufferedSeekPossible() const
+{
+    if (iMsgStream == nullptr || iMsgStream->StreamInfo().StreamId() != iStreamId) {
+        return false;
+    }
+    const TUint64 seekJiffies = ((TUint64)iSeekSeconds) * Jiffies::kPerSecond;
+    if (seekJiffies < iStreamPosJiffies) {
+        return (!iHistory.empty() && iHistory.front()->TrackOffset() <= seekJiffies);
+    }
+    const TUint64 bufferedEndJiffies = iUpstreamPosJiffies + iDecodedAudioBuffer.BufferedJiffies(iStreamId);
+    return (seekJiffies <= bufferedEndJiffies);
+}
+
+TBool Seeker::TrySeekBuffered()
+{
+    if (!BufferedSeekPossible()) {
+        return false;
+    }
+    const TUint64 seekJiffies = ((TUint64)iSeekSeconds) * Jiffies::kPerSecond;
+    if (seekJiffies < iStreamPosJiffies) {
+        return TrySeekHistory(seekJiffies);
+    }
+    LOG(kPipeline, "Seeker::TrySeekBuffered() discard until %llu\n", seekJiffies);
+    iFlushEndJiffies = seekJiffies;
+    iState = EFlushing;
+    iDecodeDiscardUntilSeekPoint = true;
+    iSeekConsecutiveFailureCount = 0;
+    iQueue.EnqueueAtHead(iMsgFactory.CreateMsgHalt());
+    return true;
+}
+
+TBool Seeker::TrySeekHistory(TUint64 aSeekJiffies)
+{
+    LOG(kPipeline, "Seeker::TrySeekHistory() replay from %llu (history runs %llu ... %llu)\n",
+                   aSeekJiffies, iHistory.front()->TrackOffset(), iUpstreamPosJiffies);
+    iQueue.Clear(); // anything queued was also recorded in iHistory
+    for (auto it = iHistory.rbegin(); it != iHistory.rend(); ++it) {
+        MsgAudioPcm* msg = *it;
+        if (msg->TrackOffset() + msg->Jiffies() <= aSeekJiffies) {
+            break;
+        }
+        MsgAudio* clone = msg->Clone();
+        if (msg->TrackOffset() < aSeekJiffies) {
+            MsgAudio* remaining = clone->Split(static_cast<TUint>(aSeekJiffies - msg->TrackOffset()));
+            clone->RemoveRef();
+            clone = remaining;
+        }
+        iQueue.EnqueueAtHead(clone);
+    }
+    const DecodedStreamInfo& info = iMsgStream->StreamInfo();
+    const TUint64 sampleStart = aSeekJiffies / Jiffies::PerSample(info.SampleRate());
+    iQueue.EnqueueAtHead(iMsgFactory.CreateMsgDecodedStream(info.StreamId(), info.BitRate(), info.BitDepth(),
+                                                            info.SampleRate(), info.NumChannels(), info.CodecName(),
+                                                            info.TrackLength(), sampleStart, info.Lossless(),
+                                                            info.Seekable(), info.Live(), info.AnalogBypass(),
+                                                            info.Multiroom(), info.Profile(), info.StreamHandler()));
+    iQueue.EnqueueAtHead(iMsgFactory.CreateMsgHalt());
+    iState = ERampingUp;
+    iRemainingRampSize = iRampDuration;
+    iCurrentRampValue = Ramp::kMin;
+    iFlushEndJiffies = 0;
+    iDecodeDiscardUntilSeekPoint = false;
+    iSeekConsecutiveFailureCount = 0;
+    return true;
+}
+
 Msg* Seeker::ProcessFlushable(Msg* aMsg)
 {
     if (iState == EFlushing || iTargetFlushId != MsgFlush::kIdInvalid) {
@@ -367,3 +472,32 @@ void Seeker::HandleSeekFail()
         }
     }
 }
+
+void Seeker::RecordHistory(MsgAudioPcm* aMsg)
+{
+    if (aMsg->TrackOffset() != iUpstreamPosJiffies) {
+        ClearHistory(); // discontinuity - earlier audio can no longer be replayed ahead of what follows
+    }
+    iUpstreamPosJiffies = aMsg->TrackOffset() + aMsg->Jiffies();
+    if (iHistoryMaxJiffies == 0) {
+        return;
+    }
+    auto clone = static_cast<MsgAudioPcm*>(aMsg->Clone());
+    clone->ClearRamp();
+    iHistory.push_back(clone);
+    iHistoryJiffies += clone->Jiffies();
+    while (iHistoryJiffies - iHistory.front()->Jiffies() >= iHistoryMaxJiffies) {
+        iHistoryJiffies -= iHistory.front()->Jiffies();
+        iHistory.front()->RemoveRef();
+        iHistory.pop_front();
+    }
+}
+
+void Seeker::ClearHistory()
+{
+    for (auto msg : iHistory) {
+        msg->RemoveRef();
+    }
+    iHistory.clear();
+    iHistoryJiffies = 0;
+}
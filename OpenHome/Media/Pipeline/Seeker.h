@@ -6,6 +6,8 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Flusher.h>
 
+#include <deque>
+
 EXCEPTION(SeekAlreadyInProgress)
 EXCEPTION(SeekStreamInvalid)
 EXCEPTION(SeekStreamNotSeekable)
@@ -23,13 +25,18 @@ If the track is playing when Seek() is called, it is first ramped down
 ...the track is ramped up when we restart playing
 Calls to Seek() are ignored if a previous seek is in progress
 If TrySeek returned a valid flush id, the MsgFlush with this id is consumed
+Seeks which can be satisfied from audio that is already decoded don't call TrySeek
+...targets inside the decoded reservoir are reached by discarding audio up to the seek point
+...targets up to aHistoryJiffies behind the current position are replayed from a copy of recently pulled audio
+...these seeks are always performed from Pull(), even if Seek() is called without a ramp down
 */
 
 class Seeker : public IPipelineElementUpstream, private IMsgProcessor, private ISeekObserver
 {
     friend class SuiteSeeker;
 public:
-    Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, ISeeker& aSeeker, ISeekRestreamer& aRestreamer, TUint aRampDuration);
+    Seeker(MsgFactory& aMsgFactory, IPipelineElementUpstream& aUpstreamElement, ISeeker& aSeeker, ISeekRestreamer& aRestreamer,
+           IDecodedAudioBuffer& aDecodedAudioBuffer, TUint aRampDuration, TUint aHistoryJiffies);
     virtual ~Seeker();
     void Seek(TUint aStreamId, TUint aSecondsAbsolute, TBool aRampDown);
 public: // from IPipelineElementUpstream
@@ -56,8 +63,13 @@ private: // from ISeekObserver
     void NotifySeekComplete(TUint aHandle, TUint aFlushId) override;
 private:
     void DoSeek();
+    TBool BufferedSeekPossible() const;
+    TBool TrySeekBuffered();
+    TBool TrySeekHistory(TUint64 aSeekJiffies);
     Msg* ProcessFlushable(Msg* aMsg);
     void HandleSeekFail();
+    void RecordHistory(MsgAudioPcm* aMsg);
+    void ClearHistory();
 private:
     enum EState
     {
@@ -72,6 +84,7 @@ private:
     IPipelineElementUpstream& iUpstreamElement;
     ISeeker& iSeeker;
     ISeekRestreamer& iRestreamer;
+    IDecodedAudioBuffer& iDecodedAudioBuffer;
     Mutex iLock;
     EState iState;
     const TUint iRampDuration;
@@ -93,6 +106,12 @@ private:
     MsgDecodedStream* iMsgStream;
     TBool iSeekInNextStream;
     TBool iDecodeDiscardUntilSeekPoint;
+    const TUint iHistoryMaxJiffies;
+    std::deque<MsgAudioPcm*> iHistory; // unramped clones of audio pulled from upstream, oldest first
+    TUint iHistoryJiffies;
+    TUint64 iUpstreamPosJiffies;
+    TBool iPulledUpstream;
+    TBool iSeekPending; // Seek() found the target is buffered; DoSeek() on the next Pull()
 };
 
 } // namespace Media
@@ -5,6 +5,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Pipeline/Flusher.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Media;
@@ -206,7 +207,7 @@ Msg* Skipper::ProcessMsg(MsgBitRate* aMsg)
 Msg* Skipper::ProcessMsg(MsgAudioPcm* aMsg)
 {
     if (!iRunning) {
-        LOG(kMedia, "Skipper::ProcessMsg(MsgAudioPcm* ), setting iRunning=true\n");
+        LOG_BINARY(kMedia, "Skipper::ProcessMsg(MsgAudioPcm* ), setting iRunning=true\n");
         iRunning = true;
     }
     if (iState == eStarting) {
@@ -303,7 +304,7 @@ TBool Skipper::TryRemoveCurrentStream(TBool aRampDown)
     if (!iRunning) {
         aRampDown = false;
     }
-    LOG(kMedia, "Skipper::TryRemoveCurrentStream(%u), iState=%u, iRunning=%u\n", aRampDown, iState, iRunning);
+    LOG_BINARY(kMedia, "Skipper::TryRemoveCurrentStream(%u), iState=%u, iRunning=%u\n", aRampDown, iState, iRunning);
     EState state = iState;
     if (!aRampDown || iState == eStarting) {
         StartFlushing();
@@ -6,6 +6,7 @@
 #include <OpenHome/Media/FlywheelRamper.h>
 #include <OpenHome/Media/Pipeline/ElementObserver.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 //#include <OpenHome/Private/Timer.h>
 //#include <OpenHome/Net/Private/Globals.h>
 
@@ -456,7 +457,7 @@ void StarvationRamper::PullerThread()
 
 void StarvationRamper::StartFlywheelRamp()
 {
-    LOG(kPipeline, "StarvationRamper::StartFlywheelRamp()\n");
+    LOG_BINARY(kPipeline, "StarvationRamper::StartFlywheelRamp()\n");
 //    const TUint startTime = Time::Now(*gEnv);
     if (iRecentAudioJiffies > kTrainingJiffies) {
         TInt excess = iRecentAudioJiffies - kTrainingJiffies;
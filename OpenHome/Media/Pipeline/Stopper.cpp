@@ -4,6 +4,7 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 #include <OpenHome/Media/Pipeline/ElementObserver.h>
 
 #include <atomic>
@@ -193,7 +194,7 @@ Msg* Stopper::Pull()
         }
         else {
             if (iState == EPaused || iState == EStopped) {
-                LOG(kPipeline, "Stopper::Pull(), waiting, iState=%s\n", State());
+                LOG_BINARY(kPipeline, "Stopper::Pull(), waiting, iState=%s\n", State());
                 iSem.Wait();
             }
             msg = (iQueue.IsEmpty()? iUpstreamElement.Pull() : iQueue.Dequeue());
@@ -510,8 +511,8 @@ void Stopper::HandleStopped()
 void Stopper::SetState(EState aState)
 {
     if (iState != aState) {
-        LOG(kPipeline, "Stopper changing state from %s to %s\n", State(), State(aState));
-        LOG(kPipeline, "  iRemainingRampSize=%u, iCurrentRampValue=%08x\n", iRemainingRampSize, iCurrentRampValue);
+        LOG_BINARY(kPipeline, "Stopper changing state from %s to %s\n", State(), State(aState));
+        LOG_BINARY(kPipeline, "  iRemainingRampSize=%u, iCurrentRampValue=%08x\n", iRemainingRampSize, iCurrentRampValue);
         iState = aState;
     }
 }
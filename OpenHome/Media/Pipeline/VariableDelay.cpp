@@ -5,6 +5,7 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Media/Debug.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
 #include <OpenHome/Private/Standard.h>
 
 #include <algorithm>
@@ -268,7 +269,7 @@ void VariableDelayBase::ResetStatusAndRamp()
 void VariableDelayBase::SetupRamp()
 {
     iWaitForAudioBeforeGeneratingSilence = (iDelayAdjustment > 0);
-    LOG(kMedia, "VariableDelay(%s), delay=%u, adjustment=%d\n",
+    LOG_BINARY(kMedia, "VariableDelay(%s), delay=%u, adjustment=%d\n",
                 iId, iDelayJiffies/Jiffies::kPerMs, iDelayAdjustment/(TInt)Jiffies::kPerMs);
     switch (iStatus)
     {
@@ -559,7 +560,7 @@ Msg* VariableDelayLeft::ProcessMsg(MsgDelay* aMsg)
     aMsg->RemoveRef();
     auto msg = iMsgFactory.CreateMsgDelay(std::min(iDownstreamDelay, msgDelayJiffies));
     TUint delayJiffies = (iDownstreamDelay >= msgDelayJiffies? 0 : msgDelayJiffies - iDownstreamDelay);
-    LOG(kMedia, "VariableDelayLeft::ProcessMsg(MsgDelay(%u): delay=%u(%u), prev=%u(%u), iStatus=%s\n",
+    LOG_BINARY(kMedia, "VariableDelayLeft::ProcessMsg(MsgDelay(%u): delay=%u(%u), prev=%u(%u), iStatus=%s\n",
                 msgDelayJiffies,
                 delayJiffies, Jiffies::ToMs(delayJiffies),
                 iDelayJiffies, Jiffies::ToMs(iDelayJiffies),
@@ -624,7 +625,7 @@ Msg* VariableDelayRight::ProcessMsg(MsgDelay* aMsg)
     aMsg->RemoveRef();
     delayJiffies = (iAnimatorLatency >= delayJiffies? 0 : delayJiffies - iAnimatorLatency);
     delayJiffies = std::max(delayJiffies, iMinDelay);
-    LOG(kMedia, "VariableDelayRight::ProcessMsg(MsgDelay(%u): delay=%u(%u), downstream=%u(%u), prev=%u(%u), iStatus=%s\n",
+    LOG_BINARY(kMedia, "VariableDelayRight::ProcessMsg(MsgDelay(%u): delay=%u(%u), downstream=%u(%u), prev=%u(%u), iStatus=%s\n",
                 msgDelayJiffies,
                 delayJiffies, Jiffies::ToMs(delayJiffies),
                 iAnimatorLatency, Jiffies::ToMs(iAnimatorLatency),
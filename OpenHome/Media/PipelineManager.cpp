@@ -2,6 +2,7 @@
 #include <OpenHome/Media/Pipeline/Pipeline.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
 #include <OpenHome/Media/Filler.h>
+#include <OpenHome/Media/PrerollCache.h>
 #include <OpenHome/Media/IdManager.h>
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Media/Debug.h>
@@ -45,10 +46,13 @@ TUint PriorityArbitratorPipeline::HostRange() const
 PipelineManager::PipelineManager(PipelineInitParams* aInitParams, IInfoAggregator& aInfoAggregator, TrackFactory& aTrackFactory)
     : iLock("PLM1")
     , iPublicLock("PLM2")
+    , iPrerollProtocolManager(nullptr)
+    , iPrerollCache(nullptr)
     , iModeObserver(nullptr)
     , iPipelineState(EPipelineStopped)
     , iPipelineStoppedSem("PLM3", 1)
 {
+    const TUint prerollBytes = aInitParams->PrerollBytes();
     iPrefetchObserver = new PrefetchObserver();
     iPipeline = new Pipeline(aInitParams, aInfoAggregator, aTrackFactory,
                              *this, *iPrefetchObserver, *this, *this);
@@ -60,7 +64,16 @@ PipelineManager::PipelineManager(PipelineInitParams* aInitParams, IInfoAggregato
                          iPipeline->Factory(), aTrackFactory, *iPrefetchObserver,
                          *iIdManager, iFillerPriority, iPipeline->SenderMinLatencyMs() * Jiffies::kPerMs);
     iProtocolManager = new ProtocolManager(*iFiller, iPipeline->Factory(), *iIdManager, *iPipeline);
-    iFiller->Start(*iProtocolManager);
+    if (prerollBytes == 0) {
+        iFiller->Start(*iProtocolManager);
+    }
+    else {
+        iPrerollCache = new PrerollCache(*iFiller, *iProtocolManager, iFillerPriority, prerollBytes);
+        iPrerollProtocolManager = new ProtocolManager(*iPrerollCache, iPipeline->Factory(), *iIdManager, *iPipeline);
+        iPrerollCache->Start(*iPrerollProtocolManager);
+        iFiller->SetPreroll(*iPrerollCache);
+        iFiller->Start(*iPrerollCache);
+    }
 }
 
 PipelineManager::~PipelineManager()
@@ -68,6 +81,8 @@ PipelineManager::~PipelineManager()
     delete iPipeline;
     delete iPrefetchObserver;
     delete iProtocolManager;
+    delete iPrerollProtocolManager;
+    delete iPrerollCache;
     delete iFiller;
     delete iIdManager;
     for (TUint i=0; i<iUriProviders.size(); i++) {
@@ -88,6 +103,9 @@ void PipelineManager::Quit()
     iLock.Signal();
     iPipeline->Quit();
     iFiller->Quit();
+    if (iPrerollCache != nullptr) {
+        iPrerollCache->Quit();
+    }
 }
 
 void PipelineManager::Add(Codec::ContainerBase* aContainer)
@@ -105,6 +123,16 @@ void PipelineManager::Add(Protocol* aProtocol)
     iProtocolManager->Add(aProtocol);
 }
 
+void PipelineManager::AddPreroll(Protocol* aProtocol)
+{
+    if (iPrerollProtocolManager == nullptr) {
+        delete aProtocol;
+    }
+    else {
+        iPrerollProtocolManager->Add(aProtocol);
+    }
+}
+
 void PipelineManager::Add(ContentProcessor* aContentProcessor)
 {
     iProtocolManager->Add(aContentProcessor);
@@ -164,6 +192,11 @@ ISpotifyTrackObserver& PipelineManager::SpotifyTrackObserver() const
     return iPipeline->SpotifyTrackObserver();
 }
 
+IPullableClock* PipelineManager::SoftwareClock() const
+{
+    return iPipeline->SoftwareClock();
+}
+
 void PipelineManager::Begin(const Brx& aMode, TUint aTrackId)
 {
     AutoMutex _(iPublicLock);
@@ -312,6 +345,11 @@ IPipelineElementUpstream& PipelineManager::InsertElements(IPipelineElementUpstre
     return iPipeline->InsertElements(aTail);
 }
 
+ISenderActivityObserver& PipelineManager::SenderActivityObserver() const
+{
+    return iPipeline->SenderActivityObserver();
+}
+
 TUint PipelineManager::SenderMinLatencyMs() const
 {
     return iPipeline->SenderMinLatencyMs();
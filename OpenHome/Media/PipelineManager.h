@@ -22,6 +22,7 @@ class IPipelineAnimator;
 class ProtocolManager;
 class ITrackObserver;
 class Filler;
+class PrerollCache;
 class IdManager;
 class IMimeTypeList;
 class Protocol;
@@ -29,6 +30,7 @@ class ContentProcessor;
 class UriProvider;
 class IAnalogBypassVolumeRamper;
 class IVolumeRamper;
+class IPullableClock;
 
 class PriorityArbitratorPipeline : public IPriorityArbitrator, private INonCopyable
 {
@@ -102,6 +104,16 @@ public:
      * @param[in] aProtocol        Ownership transfers to PipelineManager.
      */
     void Add(Protocol* aProtocol);
+    /**
+     * Add a protocol used only to fetch the start of the track expected to play next.
+     *
+     * Must be a different instance from any passed to Add(Protocol*).
+     * Ignored unless PipelineInitParams::SetPrerollSize() was passed a non-zero size.
+     * Must be called before Start().
+     *
+     * @param[in] aProtocol        Ownership transfers to PipelineManager.
+     */
+    void AddPreroll(Protocol* aProtocol);
     /**
      * Add a content processor to the pipeline.
      *
@@ -163,6 +175,14 @@ public:
      *          the pipeline.
      */
     ISpotifyTrackObserver& SpotifyTrackObserver() const;
+    /**
+     * Retrieve the pipeline's software clock.
+     *
+     * @return  IPullableClock that varies the rate of the pipeline's output by
+     *          resampling.  nullptr unless sample rate conversion was enabled
+     *          via PipelineInitParams.
+     */
+    IPullableClock* SoftwareClock() const;
     /**
      * Instruct the pipeline what should be streamed next.
      *
@@ -263,6 +283,7 @@ public:
      */
     void Prev();
     IPipelineElementUpstream& InsertElements(IPipelineElementUpstream& aTail);
+    ISenderActivityObserver& SenderActivityObserver() const; // notify while elements from InsertElements() are sending to listeners
     TUint SenderMinLatencyMs() const;
     void GetThreadPriorityRange(TUint& aMin, TUint& aMax) const;
     void GetThreadPriorities(TUint& aFiller, TUint& aFlywheelRamper, TUint& aStarvationRamper, TUint& aCodec, TUint& aEvent);
@@ -320,6 +341,8 @@ private:
     ProtocolManager* iProtocolManager;
     TUint iFillerPriority;
     Filler* iFiller;
+    ProtocolManager* iPrerollProtocolManager;
+    PrerollCache* iPrerollCache;
     IdManager* iIdManager;
     std::vector<UriProvider*> iUriProviders;
     std::vector<IPipelineObserver*> iObservers;
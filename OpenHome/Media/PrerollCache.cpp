@@ -0,0 +1,252 @@
+#include <OpenHome/Media/PrerollCache.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Debug.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// PrerollCache
+
+const TUint PrerollCache::kSupportedMsgTypes =   eTrack
+                                               | eDrain
+                                               | eDelay
+                                               | eEncodedStream
+                                               | eAudioEncoded
+                                               | eMetatext
+                                               | eStreamInterrupted
+                                               | eHalt
+                                               | eFlush
+                                               | eWait;
+
+PrerollCache::PrerollCache(IPipelineElementDownstream& aDownstream, IUriStreamer& aUriStreamer, TUint aThreadPriority, TUint aMaxBytes)
+    : PipelineElement(kSupportedMsgTypes)
+    , Thread("Preroll", aThreadPriority)
+    , iLock("PREC")
+    , iDownstream(aDownstream)
+    , iUriStreamer(aUriStreamer)
+    , iPrerollStreamer(nullptr)
+    , iMaxBytes(aMaxBytes)
+    , iSemResume("PRE1", 0)
+    , iSemFetched("PRE2", 0)
+    , iState(EState::eIdle)
+    , iTrack(nullptr)
+    , iPendingTrack(nullptr)
+    , iBytes(0)
+    , iResult(EProtocolStreamSuccess)
+    , iInterrupted(false)
+{
+}
+
+PrerollCache::~PrerollCache()
+{
+    ClearLocked();
+    if (iPendingTrack != nullptr) {
+        iPendingTrack->RemoveRef();
+    }
+}
+
+void PrerollCache::Start(IUriStreamer& aPrerollStreamer)
+{
+    iPrerollStreamer = &aPrerollStreamer;
+    Thread::Start();
+}
+
+void PrerollCache::Quit()
+{
+    iLock.Wait();
+    CancelLocked();
+    iLock.Signal();
+    Kill();
+    iPrerollStreamer->Interrupt(true);
+    Join();
+}
+
+ProtocolStreamResult PrerollCache::DoStream(Track& aTrack)
+{
+    iLock.Wait();
+    const TBool prerolled = (iTrack != nullptr && iTrack->Id() == aTrack.Id() && iTrack->Uri() == aTrack.Uri()
+                             && (iState == EState::ePrerolling || iState == EState::eFetched));
+    if (!prerolled) {
+        if (iPendingTrack != nullptr) {
+            if (iPendingTrack->Id() == aTrack.Id()) {
+                iPendingTrack->RemoveRef();
+                iPendingTrack = nullptr;
+            }
+            else {
+                // whatever we hold was expected to follow a track that is no longer playing
+                CancelLocked();
+                StartPendingLocked();
+            }
+        }
+        iLock.Signal();
+        return iUriStreamer.DoStream(aTrack);
+    }
+    LOG(kMedia, "PrerollCache: splicing %u bytes of track %u\n", iBytes, aTrack.Id());
+    iState = EState::eDraining;
+    iLock.Signal();
+    iSemResume.Signal();
+
+    for (;;) {
+        iLock.Wait();
+        if (iQueue.IsEmpty()) {
+            iState = EState::eSpliced;
+            iLock.Signal();
+            break;
+        }
+        Msg* msg = iQueue.Dequeue();
+        const TBool interrupted = iInterrupted;
+        iLock.Signal();
+        if (interrupted) {
+            msg->RemoveRef();
+        }
+        else {
+            iDownstream.Push(msg);
+        }
+    }
+
+    iSemFetched.Wait();
+    AutoMutex _(iLock);
+    const ProtocolStreamResult res = iResult;
+    ClearLocked();
+    StartPendingLocked();
+    return res;
+}
+
+void PrerollCache::Interrupt(TBool aInterrupt)
+{
+    iUriStreamer.Interrupt(aInterrupt);
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (iState == EState::eDraining || iState == EState::eSpliced) {
+        iPrerollStreamer->Interrupt(aInterrupt);
+    }
+}
+
+void PrerollCache::Preroll(Track& aTrack)
+{
+    AutoMutex _(iLock);
+    if (iTrack != nullptr && iTrack->Id() == aTrack.Id() && iState != EState::eCancelled) {
+        return; // already fetching or fetched
+    }
+    if (iPendingTrack != nullptr) {
+        if (iPendingTrack->Id() == aTrack.Id()) {
+            return;
+        }
+        iPendingTrack->RemoveRef();
+    }
+    iPendingTrack = &aTrack;
+    iPendingTrack->AddRef();
+    StartPendingLocked();
+}
+
+void PrerollCache::Push(Msg* aMsg)
+{
+    iLock.Wait();
+    if (iState == EState::eSpliced) {
+        iLock.Signal();
+        iDownstream.Push(aMsg);
+        return;
+    }
+    if (iState == EState::eCancelled || iState == EState::eIdle) {
+        iLock.Signal();
+        aMsg->RemoveRef();
+        iPrerollStreamer->Interrupt(true); // in case a cancellation raced with the start of the fetch
+        return;
+    }
+    aMsg = aMsg->Process(*this);
+    iQueue.Enqueue(aMsg);
+    const TBool full = (iState == EState::ePrerolling && iBytes >= iMaxBytes);
+    if (full) {
+        iSemResume.Clear();
+    }
+    iLock.Signal();
+    if (full) {
+        LOG(kMedia, "PrerollCache: holding %u bytes of track %u\n", iBytes, iTrack->Id());
+        iSemResume.Wait();
+    }
+}
+
+Msg* PrerollCache::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    iBytes += aMsg->Bytes();
+    return aMsg;
+}
+
+void PrerollCache::Run()
+{
+    try {
+        for (;;) {
+            Wait();
+            iLock.Wait();
+            if (iState == EState::eCancelled) {
+                // cancelled before we started fetching it
+                ClearLocked();
+                StartPendingLocked();
+                iLock.Signal();
+                continue;
+            }
+            // DoStream() may already be splicing a track we haven't started fetching
+            ASSERT(iState == EState::ePrerolling || iState == EState::eDraining || iState == EState::eSpliced);
+            Track* track = iTrack;
+            iLock.Signal();
+
+            LOG(kMedia, "PrerollCache: fetching track %u\n", track->Id());
+            iPrerollStreamer->Interrupt(false);
+            const ProtocolStreamResult res = iPrerollStreamer->DoStream(*track);
+
+            AutoMutex _(iLock);
+            iResult = res;
+            if (iState == EState::eCancelled) {
+                ClearLocked();
+                StartPendingLocked();
+            }
+            else {
+                if (iState == EState::ePrerolling) {
+                    iState = EState::eFetched;
+                }
+                iSemFetched.Signal();
+            }
+        }
+    }
+    catch (ThreadKill&) {
+    }
+}
+
+void PrerollCache::StartPendingLocked()
+{
+    if (iPendingTrack == nullptr || iState != EState::eIdle) {
+        return; // anything pending is started once the current track is streamed or cancelled
+    }
+    iTrack = iPendingTrack;
+    iPendingTrack = nullptr;
+    iState = EState::ePrerolling;
+    iSemFetched.Clear();
+    Signal();
+}
+
+void PrerollCache::CancelLocked()
+{
+    if (iState == EState::ePrerolling) {
+        iState = EState::eCancelled;
+        iPrerollStreamer->Interrupt(true);
+        iSemResume.Signal();
+    }
+    else if (iState == EState::eFetched) {
+        ClearLocked();
+    }
+}
+
+void PrerollCache::ClearLocked()
+{
+    iQueue.Clear();
+    if (iTrack != nullptr) {
+        iTrack->RemoveRef();
+        iTrack = nullptr;
+    }
+    iState = EState::eIdle;
+    iBytes = 0;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Filler.h>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Fetches the start of the track expected to play next, so that skipping to it doesn't
+ * wait for a protocol to connect and the first data to arrive.
+ *
+ * Sits between Filler and the pipeline's ProtocolManager.  Preroll() starts streaming
+ * a track on a dedicated thread via a second IUriStreamer whose protocols push into this
+ * class.  Up to aMaxBytes of encoded audio is held, after which the fetch is blocked
+ * (leaving its connection open).  If Filler then asks to DoStream() the same track, the
+ * held msgs are passed downstream immediately and the fetch resumes from where it
+ * stopped, pushing directly downstream.  Any other track is streamed as normal.
+ *
+ * Only one track is fetched at a time.  Preroll() for a different track while one is
+ * held doesn't discard it (Filler calls Preroll(N+1) just before DoStream(N)); the new
+ * track is fetched once the held one has been streamed, or once DoStream() is called
+ * for some other track, showing that the held one is no longer expected next.
+ */
+class PrerollCache : public IUriStreamer
+                   , public ITrackPreroll
+                   , public IPipelineElementDownstream
+                   , private PipelineElement
+                   , private Thread
+                   , private INonCopyable
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    PrerollCache(IPipelineElementDownstream& aDownstream, IUriStreamer& aUriStreamer, TUint aThreadPriority, TUint aMaxBytes);
+    ~PrerollCache();
+    void Start(IUriStreamer& aPrerollStreamer);
+    void Quit();
+public: // from IUriStreamer
+    ProtocolStreamResult DoStream(Track& aTrack) override;
+    void Interrupt(TBool aInterrupt) override;
+public: // from ITrackPreroll
+    void Preroll(Track& aTrack) override;
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from PipelineElement (IMsgProcessor)
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+private: // from Thread
+    void Run() override;
+private:
+    void StartPendingLocked();
+    void CancelLocked();
+    void ClearLocked();
+private:
+    enum class EState
+    {
+        eIdle,
+        ePrerolling,  // fetch in progress, msgs held
+        eFetched,     // fetch complete, msgs held
+        eDraining,    // DoStream() passing held msgs downstream
+        eSpliced,     // fetch pushing directly downstream
+        eCancelled
+    };
+private:
+    Mutex iLock;
+    IPipelineElementDownstream& iDownstream;
+    IUriStreamer& iUriStreamer;
+    IUriStreamer* iPrerollStreamer;
+    const TUint iMaxBytes;
+    MsgQueue iQueue;
+    Semaphore iSemResume;
+    Semaphore iSemFetched;
+    EState iState;
+    Track* iTrack;
+    Track* iPendingTrack;
+    TUint iBytes;
+    ProtocolStreamResult iResult;
+    TBool iInterrupted;
+};
+
+} // namespace Media
+} // namespace OpenHome
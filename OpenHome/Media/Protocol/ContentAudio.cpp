@@ -33,17 +33,8 @@ ProtocolStreamResult ContentAudio::Stream(IReader& aReader, TUint64 aTotalBytes)
         for (;;) {
             Brn buf = aReader.Read(kMaxReadBytes);
             iSupply->OutputData(buf);
-            if (aTotalBytes > 0) {
-                if (buf.Bytes() > aTotalBytes) { // aTotalBytes is inaccurate - ignore it
-                    aTotalBytes = 0;
-                }
-                else {
-                    aTotalBytes -= buf.Bytes();
-                    if (aTotalBytes == 0) {
-                        iSupply->Flush();
-                        break;
-                    }
-                }
+            if (UpdateTotalBytes(buf.Bytes(), aTotalBytes)) {
+                break;
             }
         }
     }
@@ -53,3 +44,46 @@ ProtocolStreamResult ContentAudio::Stream(IReader& aReader, TUint64 aTotalBytes)
     }
     return res;
 }
+
+ProtocolStreamResult ContentAudio::StreamDirect(IReader& /*aReader*/, IReaderDirect& aReaderDirect, TUint64 aTotalBytes)
+{
+    ProtocolStreamResult res = EProtocolStreamSuccess;
+    try {
+        for (;;) {
+            Bwn buf = iSupply->WritableData();
+            try {
+                aReaderDirect.ReadDirect(buf);
+            }
+            catch (ReaderError&) {
+                iSupply->CommitData(buf.Bytes());
+                throw;
+            }
+            iSupply->CommitData(buf.Bytes());
+            if (UpdateTotalBytes(buf.Bytes(), aTotalBytes)) {
+                break;
+            }
+        }
+    }
+    catch (ReaderError&) {
+        res = EProtocolStreamErrorRecoverable;
+        iSupply->Flush();
+    }
+    return res;
+}
+
+TBool ContentAudio::UpdateTotalBytes(TUint aBytes, TUint64& aTotalBytes)
+{
+    if (aTotalBytes > 0) {
+        if (aBytes > aTotalBytes) { // aTotalBytes is inaccurate - ignore it
+            aTotalBytes = 0;
+        }
+        else {
+            aTotalBytes -= aBytes;
+            if (aTotalBytes == 0) {
+                iSupply->Flush();
+                return true;
+            }
+        }
+    }
+    return false;
+}
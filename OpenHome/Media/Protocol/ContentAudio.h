@@ -22,8 +22,11 @@ public:
 private: // from ContentProcessor
     TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData);
     ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes);
+    ProtocolStreamResult StreamDirect(IReader& aReader, IReaderDirect& aReaderDirect, TUint64 aTotalBytes) override;
 private:
-    SupplyAggregator* iSupply;
+    TBool UpdateTotalBytes(TUint aBytes, TUint64& aTotalBytes); // returns true if all bytes have been read
+private:
+    SupplyAggregatorBytes* iSupply;
 };
 
 } // namespace Media
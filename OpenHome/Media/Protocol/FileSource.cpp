@@ -0,0 +1,333 @@
+#include <OpenHome/Media/Protocol/FileSource.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Exception.h>
+#include <OpenHome/Private/File.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <algorithm>
+#include <limits>
+
+#ifdef FILE_SOURCE_MAPPED_SUPPORTED
+# include <errno.h>
+# include <fcntl.h>
+# include <setjmp.h>
+# include <signal.h>
+# include <string.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <atomic>
+# include <mutex>
+
+static_assert(sizeof(off_t) >= 8, "FileSourceMapped requires a 64-bit off_t (build with _FILE_OFFSET_BITS=64)");
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+#ifdef FILE_SOURCE_MAPPED_SUPPORTED
+
+/*
+ * A fault on a mapping (file truncated by another process, USB/NAS volume gone) raises
+ * SIGBUS.  While a thread is copying from a FileSourceMapped window, a fault within that
+ * copy's source range jumps back to the copy, which reports failure.  Any other SIGBUS is
+ * passed to whichever handler was installed before ours.
+ */
+namespace {
+
+struct MappedCopy
+{
+    sigjmp_buf iJmp;
+    const TByte* iStart;
+    const TByte* iEnd;
+};
+
+thread_local MappedCopy* tMappedCopy = nullptr;
+struct sigaction gSigBusPrev;
+std::once_flag gSigBusInstalled;
+
+void SigBusHandler(int aSignal, siginfo_t* aInfo, void* aContext)
+{
+    MappedCopy* copy = tMappedCopy;
+    if (copy != nullptr) {
+        const TByte* addr = static_cast<const TByte*>(aInfo->si_addr);
+        if (addr >= copy->iStart && addr < copy->iEnd) {
+            siglongjmp(copy->iJmp, 1);
+        }
+    }
+    if ((gSigBusPrev.sa_flags & SA_SIGINFO) != 0) {
+        gSigBusPrev.sa_sigaction(aSignal, aInfo, aContext);
+    }
+    else if (gSigBusPrev.sa_handler != SIG_DFL && gSigBusPrev.sa_handler != SIG_IGN) {
+        gSigBusPrev.sa_handler(aSignal);
+    }
+    else {
+        // not ours; restore default handling so the faulting access terminates the process as before
+        (void)signal(SIGBUS, SIG_DFL);
+    }
+}
+
+void InstallSigBusHandler()
+{
+    struct sigaction sa;
+    (void)memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = SigBusHandler;
+    sa.sa_flags = SA_SIGINFO;
+    (void)sigemptyset(&sa.sa_mask);
+    (void)sigaction(SIGBUS, &sa, &gSigBusPrev);
+}
+
+TBool CopyFromMapping(TByte* aDest, const TByte* aSrc, TUint aBytes)
+{
+    MappedCopy copy;
+    copy.iStart = aSrc;
+    copy.iEnd = aSrc + aBytes;
+    if (sigsetjmp(copy.iJmp, 1) != 0) {
+        tMappedCopy = nullptr;
+        return false;
+    }
+    tMappedCopy = &copy;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    (void)memcpy(aDest, aSrc, aBytes);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    tMappedCopy = nullptr;
+    return true;
+}
+
+} // namespace
+
+#endif // FILE_SOURCE_MAPPED_SUPPORTED
+
+// FileSourceFactory
+
+IFileSource* FileSourceFactory::New()
+{ // static
+    IFileSource* source = NewMapped();
+    if (source == nullptr) {
+        source = NewStream();
+    }
+    return source;
+}
+
+IFileSource* FileSourceFactory::NewMapped()
+{ // static
+#ifdef FILE_SOURCE_MAPPED_SUPPORTED
+    return new FileSourceMapped();
+#else
+    return nullptr;
+#endif
+}
+
+IFileSource* FileSourceFactory::NewStream()
+{ // static
+    return new FileSourceStream();
+}
+
+
+// FileSourceStream
+
+FileSourceStream::FileSourceStream()
+{
+}
+
+FileSourceStream::~FileSourceStream()
+{
+    iFileStream.CloseFile();
+}
+
+void FileSourceStream::Open(const TChar* aPath)
+{
+    IFile* file = IFile::Open(aPath, eFileReadOnly);
+    iFileStream.SetFile(file);
+}
+
+void FileSourceStream::Close()
+{
+    iFileStream.CloseFile();
+}
+
+TUint64 FileSourceStream::Bytes() const
+{
+    return iFileStream.Bytes();
+}
+
+void FileSourceStream::Seek(TUint64 aOffset)
+{
+    if (aOffset > std::numeric_limits<TUint32>::max()) {
+        THROW(FileSeekError);
+    }
+    iFileStream.Seek((TUint32)aOffset);
+}
+
+void FileSourceStream::Interrupt(TBool aInterrupt)
+{
+    iFileStream.Interrupt(aInterrupt);
+}
+
+void FileSourceStream::Read(Bwx& aBuffer)
+{
+    const TUint prevBytes = aBuffer.Bytes();
+    iFileStream.Read(aBuffer);
+    if (aBuffer.Bytes() == prevBytes) {
+        THROW(ReaderError); // end of file
+    }
+}
+
+void FileSourceStream::ReadFlush()
+{
+    iFileStream.ReadFlush();
+}
+
+void FileSourceStream::ReadInterrupt()
+{
+    iFileStream.ReadInterrupt();
+}
+
+
+#ifdef FILE_SOURCE_MAPPED_SUPPORTED
+
+// FileSourceMapped
+
+FileSourceMapped::FileSourceMapped()
+    : iPageBytes((TUint64)sysconf(_SC_PAGESIZE))
+    , iFd(-1)
+    , iBytes(0)
+    , iPos(0)
+    , iWindow(nullptr)
+    , iWindowOffset(0)
+    , iWindowBytes(0)
+    , iAdvisedEnd(0)
+    , iInterrupted(false)
+{
+    std::call_once(gSigBusInstalled, InstallSigBusHandler);
+}
+
+FileSourceMapped::~FileSourceMapped()
+{
+    Close();
+}
+
+void FileSourceMapped::Open(const TChar* aPath)
+{
+    ASSERT(iFd == -1);
+    const int fd = open(aPath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        THROW(FileOpenError);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        (void)close(fd);
+        THROW(FileOpenError);
+    }
+    iFd = fd;
+    iBytes = (TUint64)st.st_size;
+    iPos = 0;
+    iAdvisedEnd = 0;
+}
+
+void FileSourceMapped::Close()
+{
+    Unmap();
+    if (iFd != -1) {
+        (void)close(iFd);
+        iFd = -1;
+    }
+    iBytes = iPos = 0;
+}
+
+TUint64 FileSourceMapped::Bytes() const
+{
+    return iBytes;
+}
+
+void FileSourceMapped::Seek(TUint64 aOffset)
+{
+    if (aOffset > iBytes) {
+        THROW(FileSeekError);
+    }
+    iPos = aOffset;
+    iAdvisedEnd = aOffset;
+}
+
+void FileSourceMapped::Interrupt(TBool aInterrupt)
+{
+    iInterrupted.store(aInterrupt);
+}
+
+void FileSourceMapped::Read(Bwx& aBuffer)
+{
+    if (iInterrupted.load() || iPos >= iBytes) {
+        THROW(ReaderError);
+    }
+    if (iWindow == nullptr || iPos < iWindowOffset || iPos >= iWindowOffset + iWindowBytes) {
+        MapWindow(iPos);
+    }
+    ReadAhead();
+    const TUint64 windowRemaining = iWindowOffset + iWindowBytes - iPos;
+    const TUint bytes = (TUint)std::min<TUint64>(aBuffer.MaxBytes() - aBuffer.Bytes(), windowRemaining);
+    TByte* dest = const_cast<TByte*>(aBuffer.Ptr()) + aBuffer.Bytes();
+    if (!CopyFromMapping(dest, iWindow + (iPos - iWindowOffset), bytes)) {
+        LOG_ERROR(kMedia, "FileSourceMapped: SIGBUS reading %u bytes at %llu (file truncated or volume removed?)\n", bytes, iPos);
+        Unmap();
+        THROW(ReaderError);
+    }
+    aBuffer.SetBytes(aBuffer.Bytes() + bytes);
+    iPos += bytes;
+}
+
+void FileSourceMapped::ReadFlush()
+{
+}
+
+void FileSourceMapped::ReadInterrupt()
+{
+    iInterrupted.store(true);
+}
+
+void FileSourceMapped::MapWindow(TUint64 aOffset)
+{
+    Unmap();
+    const TUint64 offset = aOffset - (aOffset % iPageBytes);
+    const TUint64 bytes = (iBytes - offset < kWindowBytes? iBytes - offset : kWindowBytes);
+    void* p = mmap(nullptr, (size_t)bytes, PROT_READ, MAP_PRIVATE, iFd, (off_t)offset);
+    if (p == MAP_FAILED) {
+        LOG_ERROR(kMedia, "FileSourceMapped: mmap(%llu bytes at %llu) failed (%d)\n", bytes, offset, errno);
+        THROW(ReaderError);
+    }
+    (void)madvise(p, (size_t)bytes, MADV_SEQUENTIAL);
+    iWindow = static_cast<TByte*>(p);
+    iWindowOffset = offset;
+    iWindowBytes = bytes;
+    iAdvisedEnd = std::max(iAdvisedEnd, offset);
+}
+
+void FileSourceMapped::Unmap()
+{
+    if (iWindow != nullptr) {
+        (void)munmap(iWindow, (size_t)iWindowBytes);
+        iWindow = nullptr;
+        iWindowOffset = iWindowBytes = 0;
+    }
+}
+
+void FileSourceMapped::ReadAhead()
+{
+    // keep between kReadAheadBytes/2 and kReadAheadBytes requested ahead of the read position
+    const TUint64 windowEnd = iWindowOffset + iWindowBytes;
+    if (iAdvisedEnd >= windowEnd) {
+        return;
+    }
+    if (iAdvisedEnd > iPos && iAdvisedEnd - iPos >= kReadAheadBytes / 2) {
+        return;
+    }
+    TUint64 start = std::max(iAdvisedEnd, iPos);
+    start -= start % iPageBytes;
+    const TUint64 end = std::min(start + kReadAheadBytes, windowEnd);
+    (void)madvise(iWindow + (start - iWindowOffset), (size_t)(end - start), MADV_WILLNEED);
+    iAdvisedEnd = end;
+}
+
+#endif // FILE_SOURCE_MAPPED_SUPPORTED
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/File.h>
+
+#include <atomic>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Read-only local file, addressed with 64-bit offsets.
+ * Read() throws ReaderError at end of file or after ReadInterrupt().
+ */
+class IFileSource : public IReaderSource
+{
+public:
+    virtual ~IFileSource() {}
+    virtual void Open(const TChar* aPath) = 0; // throws FileOpenError
+    virtual void Close() = 0;
+    virtual TUint64 Bytes() const = 0;
+    virtual void Seek(TUint64 aOffset) = 0;    // throws FileSeekError
+    virtual void Interrupt(TBool aInterrupt) = 0;
+};
+
+class FileSourceFactory
+{
+public:
+    static IFileSource* New();       // memory mapped where supported, otherwise as NewStream()
+    static IFileSource* NewMapped(); // returns nullptr if not supported on this platform
+    static IFileSource* NewStream();
+};
+
+/*
+ * Reads via IFile/FileStream.  Files larger than 4GB can't be seeked beyond 4GB.
+ */
+class FileSourceStream : public IFileSource, private INonCopyable
+{
+public:
+    FileSourceStream();
+    ~FileSourceStream();
+public: // from IFileSource
+    void Open(const TChar* aPath) override;
+    void Close() override;
+    TUint64 Bytes() const override;
+    void Seek(TUint64 aOffset) override;
+    void Interrupt(TBool aInterrupt) override;
+public: // from IReaderSource
+    void Read(Bwx& aBuffer) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    FileStream iFileStream;
+};
+
+#if defined(__linux__) || (defined(__APPLE__) && defined(__MACH__))
+# define FILE_SOURCE_MAPPED_SUPPORTED
+
+/*
+ * Reads by memcpy from a read-only mapping of the file, avoiding a syscall per read.
+ * Maps a window of up to kWindowBytes at a time (so is usable for very large files on
+ * 32-bit systems) and advises the kernel of sequential access, requesting readahead of
+ * kReadAheadBytes ahead of the current position.
+ * Faults reading the mapping (file truncated by another process, removable or network
+ * volume gone) are caught by a process-wide SIGBUS handler and reported as ReaderError.
+ * The handler is installed by the first FileSourceMapped and chains to any earlier one.
+ */
+class FileSourceMapped : public IFileSource, private INonCopyable
+{
+    static const TUint64 kWindowBytes = 64 * 1024 * 1024;
+    static const TUint kReadAheadBytes = 2 * 1024 * 1024;
+public:
+    FileSourceMapped();
+    ~FileSourceMapped();
+public: // from IFileSource
+    void Open(const TChar* aPath) override;
+    void Close() override;
+    TUint64 Bytes() const override;
+    void Seek(TUint64 aOffset) override;
+    void Interrupt(TBool aInterrupt) override;
+public: // from IReaderSource
+    void Read(Bwx& aBuffer) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    void MapWindow(TUint64 aOffset);
+    void Unmap();
+    void ReadAhead();
+private:
+    const TUint64 iPageBytes;
+    TInt iFd;
+    TUint64 iBytes;
+    TUint64 iPos;
+    TByte* iWindow;
+    TUint64 iWindowOffset;
+    TUint64 iWindowBytes;
+    TUint64 iAdvisedEnd; // file offset up to which WILLNEED has been requested
+    std::atomic<TBool> iInterrupted;
+};
+
+#endif // FILE_SOURCE_MAPPED_SUPPORTED
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,370 @@
+#include <OpenHome/Media/Protocol/HostResolver.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Arch.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Timer.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// HostLookupOs
+
+void HostLookupOs::Lookup(const Brx& aHost, std::vector<TIpAddress>& aAddresses)
+{
+    Endpoint ep;
+    ep.SetAddress(aHost); // platform resolver only reports the first address
+    aAddresses.push_back(ep.Address());
+}
+
+
+// HostResolverStats
+
+HostResolverStats::HostResolverStats()
+    : iHits(0)
+    , iNegativeHits(0)
+    , iMisses(0)
+    , iLookups(0)
+    , iLookupFailures(0)
+    , iInterrupts(0)
+    , iLookupMs(0)
+{
+}
+
+
+// HostResolverClient
+
+HostResolverClient::HostResolverClient()
+    : iSem("HRCL", 0)
+    , iInterrupted(false)
+    , iHost(nullptr)
+    , iComplete(false)
+    , iFailed(false)
+{
+}
+
+void HostResolverClient::Interrupt(TBool aInterrupt)
+{
+    iInterrupted = aInterrupt;
+    if (aInterrupt) {
+        iSem.Signal();
+    }
+}
+
+TBool HostResolverClient::IsInterrupted() const
+{
+    return iInterrupted;
+}
+
+
+// HostResolver::Entry
+
+HostResolver::Entry::Entry(const Brx& aHost)
+    : iHost(aHost)
+    , iState(EState::ePending)
+    , iResolvedMs(0)
+    , iLastUsed(0)
+{
+}
+
+
+// HostResolver
+
+TUint HostResolver::iRefCount = 0;
+HostLookupOs* HostResolver::iSharedLookup = nullptr;
+HostResolver* HostResolver::iShared = nullptr;
+
+HostResolver& HostResolver::Get(Environment& aEnv)
+{ // static
+    AutoMutex a(aEnv.Mutex());
+    if (iRefCount++ == 0) {
+        iSharedLookup = new HostLookupOs();
+        iShared = new HostResolver(aEnv, *iSharedLookup, kPositiveTtlMs, kNegativeTtlMs);
+    }
+    return *iShared;
+}
+
+void HostResolver::RemoveRef(Environment& aEnv)
+{ // static
+    AutoMutex a(aEnv.Mutex());
+    if (--iRefCount == 0) {
+        delete iShared;
+        iShared = nullptr;
+        delete iSharedLookup;
+        iSharedLookup = nullptr;
+    }
+}
+
+HostResolver::HostResolver(Environment& aEnv, IHostLookup& aLookup, TUint aPositiveTtlMs, TUint aNegativeTtlMs)
+    : iEnv(aEnv)
+    , iLookup(aLookup)
+    , iPositiveTtlMs(aPositiveTtlMs)
+    , iNegativeTtlMs(aNegativeTtlMs)
+    , iLock("HRES")
+    , iUseCount(0)
+    , iQuit(false)
+    , iSemLookups("HRSL", 0)
+{
+    iEntries.reserve(kMaxEntries);
+    for (TUint i=0; i<kNumWorkers; i++) {
+        Bws<Thread::kMaxNameBytes+1> thName;
+        thName.AppendPrintf("HostResolver%u", i);
+        thName.PtrZ();
+        auto worker = new ThreadFunctor(reinterpret_cast<const TChar*>(thName.Ptr()),
+                                        MakeFunctor(*this, &HostResolver::WorkerRun));
+        iWorkers.push_back(worker);
+        worker->Start();
+    }
+}
+
+HostResolver::~HostResolver()
+{
+    iLock.Wait();
+    iQuit = true;
+    iLock.Signal();
+    for (TUint i=0; i<iWorkers.size(); i++) {
+        iSemLookups.Signal();
+    }
+    for (auto worker : iWorkers) {
+        delete worker; // waits for any in-progress lookup to complete
+    }
+    ASSERT(iClients.size() == 0);
+    for (auto entry : iEntries) {
+        delete entry;
+    }
+}
+
+void HostResolver::Resolve(HostResolverClient& aClient, const Brx& aHost, std::vector<TIpAddress>& aAddresses)
+{
+    if (aHost.Bytes() == 0 || aHost.Bytes() > kMaxHostBytes) {
+        THROW(NetworkError);
+    }
+    TIpAddress address;
+    if (TryParseNumeric(aHost, address)) {
+        aAddresses.clear();
+        aAddresses.push_back(address);
+        return;
+    }
+    aClient.iSem.Clear();
+    iLock.Wait();
+    if (aClient.IsInterrupted()) {
+        iStats.iInterrupts++;
+        iLock.Signal();
+        THROW(NetworkError);
+    }
+    Entry* entry = FindLocked(aHost);
+    if (entry != nullptr && (entry->iState == EState::eResolved || entry->iState == EState::eFailed)) {
+        if (!ExpiredLocked(*entry, Time::Now(iEnv))) {
+            entry->iLastUsed = ++iUseCount;
+            if (entry->iState == EState::eFailed) {
+                iStats.iNegativeHits++;
+                iLock.Signal();
+                THROW(NetworkError);
+            }
+            iStats.iHits++;
+            aAddresses = entry->iAddresses;
+            iLock.Signal();
+            return;
+        }
+        entry->iState = EState::ePending;
+        iSemLookups.Signal();
+    }
+    iStats.iMisses++;
+    if (entry == nullptr) {
+        entry = AddLocked(aHost);
+        iSemLookups.Signal();
+    }
+    entry->iLastUsed = ++iUseCount;
+    aClient.iHost = &aHost;
+    aClient.iComplete = false;
+    aClient.iFailed = false;
+    aClient.iAddresses.clear();
+    iClients.push_back(&aClient);
+    iLock.Signal();
+
+    aClient.iSem.Wait();
+
+    iLock.Wait();
+    auto it = std::find(iClients.begin(), iClients.end(), &aClient);
+    if (it != iClients.end()) {
+        iClients.erase(it);
+    }
+    aClient.iHost = nullptr;
+    const TBool complete = aClient.iComplete;
+    const TBool failed = aClient.iFailed;
+    if (!complete) {
+        iStats.iInterrupts++;
+    }
+    else if (!failed) {
+        aAddresses.swap(aClient.iAddresses);
+    }
+    iLock.Signal();
+    if (!complete || failed) {
+        THROW(NetworkError);
+    }
+}
+
+void HostResolver::Clear()
+{
+    AutoMutex _(iLock);
+    for (auto it=iEntries.begin(); it!=iEntries.end();) {
+        if ((*it)->iState == EState::eResolved || (*it)->iState == EState::eFailed) {
+            delete *it;
+            it = iEntries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+HostResolverStats HostResolver::Stats() const
+{
+    AutoMutex _(iLock);
+    return iStats;
+}
+
+TBool HostResolver::TryParseNumeric(const Brx& aHost, TIpAddress& aAddress)
+{ // static
+    TUint address = 0;
+    TUint octet = 0;
+    TUint digits = 0;
+    TUint dots = 0;
+    for (TUint i=0; i<aHost.Bytes(); i++) {
+        const TChar ch = aHost[i];
+        if (ch == '.') {
+            if (digits == 0 || ++dots > 3) {
+                return false;
+            }
+            address = (address << 8) | octet;
+            octet = digits = 0;
+        }
+        else if (Ascii::IsDigit(ch) && digits < 3) {
+            octet = (octet * 10) + (ch - '0');
+            if (octet > 255) {
+                return false;
+            }
+            digits++;
+        }
+        else {
+            return false;
+        }
+    }
+    if (dots != 3 || digits == 0) {
+        return false;
+    }
+    aAddress = Arch::BigEndian4((address << 8) | octet);
+    return true;
+}
+
+void HostResolver::WorkerRun()
+{
+    for (;;) {
+        iSemLookups.Wait();
+        iLock.Wait();
+        if (iQuit) {
+            iLock.Signal();
+            break;
+        }
+        Entry* entry = nullptr;
+        for (auto e : iEntries) {
+            if (e->iState == EState::ePending) {
+                entry = e;
+                break;
+            }
+        }
+        if (entry == nullptr) {
+            iLock.Signal();
+            continue;
+        }
+        entry->iState = EState::eLookingUp;
+        const Bws<kMaxHostBytes> host(entry->iHost);
+        iLock.Signal();
+
+        std::vector<TIpAddress> addresses;
+        const TUint startMs = Time::Now(iEnv);
+        try {
+            iLookup.Lookup(host, addresses);
+        }
+        catch (NetworkError&) {
+            addresses.clear();
+        }
+        const TUint nowMs = Time::Now(iEnv);
+        const TBool failed = (addresses.size() == 0);
+        LOG(kMedia, "HostResolver: %.*s %s after %ums\n", PBUF(host), (failed? "failed" : "resolved"), nowMs - startMs);
+
+        iLock.Wait();
+        iStats.iLookups++;
+        iStats.iLookupMs += nowMs - startMs;
+        if (failed) {
+            iStats.iLookupFailures++;
+        }
+        entry->iState = (failed? EState::eFailed : EState::eResolved);
+        entry->iAddresses.swap(addresses);
+        entry->iResolvedMs = nowMs;
+        CompleteLocked(*entry);
+        iLock.Signal();
+    }
+}
+
+HostResolver::Entry* HostResolver::FindLocked(const Brx& aHost)
+{
+    for (auto entry : iEntries) {
+        if (entry->iHost == aHost) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+HostResolver::Entry* HostResolver::AddLocked(const Brx& aHost)
+{
+    if (iEntries.size() >= kMaxEntries) {
+        // evict the least recently used entry that isn't being resolved
+        auto lru = iEntries.end();
+        for (auto it=iEntries.begin(); it!=iEntries.end(); ++it) {
+            if ((*it)->iState != EState::eResolved && (*it)->iState != EState::eFailed) {
+                continue;
+            }
+            if (lru == iEntries.end() || (*it)->iLastUsed < (*lru)->iLastUsed) {
+                lru = it;
+            }
+        }
+        if (lru != iEntries.end()) {
+            delete *lru;
+            iEntries.erase(lru);
+        }
+    }
+    auto entry = new Entry(aHost);
+    iEntries.push_back(entry);
+    return entry;
+}
+
+TBool HostResolver::ExpiredLocked(const Entry& aEntry, TUint aNowMs) const
+{
+    const TUint ttlMs = (aEntry.iState == EState::eFailed? iNegativeTtlMs : iPositiveTtlMs);
+    return (aNowMs - aEntry.iResolvedMs >= ttlMs);
+}
+
+void HostResolver::CompleteLocked(Entry& aEntry)
+{
+    const TBool failed = (aEntry.iState == EState::eFailed);
+    for (auto client : iClients) {
+        if (client->iComplete || *client->iHost != aEntry.iHost) {
+            continue;
+        }
+        client->iComplete = true;
+        client->iFailed = failed;
+        client->iAddresses = aEntry.iAddresses;
+        client->iSem.Signal();
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Thread.h>
+
+#include <atomic>
+#include <vector>
+
+namespace OpenHome {
+class Environment;
+namespace Media {
+
+class IHostLookup
+{
+public:
+    virtual ~IHostLookup() {}
+    // blocking.  Appends one or more addresses for aHost to aAddresses or throws NetworkError
+    virtual void Lookup(const Brx& aHost, std::vector<TIpAddress>& aAddresses) = 0;
+};
+
+class HostLookupOs : public IHostLookup
+{
+public: // from IHostLookup
+    void Lookup(const Brx& aHost, std::vector<TIpAddress>& aAddresses) override;
+};
+
+class HostResolverStats
+{
+public:
+    HostResolverStats();
+public:
+    TUint iHits;
+    TUint iNegativeHits;
+    TUint iMisses;
+    TUint iLookups;
+    TUint iLookupFailures;
+    TUint iInterrupts;
+    TUint64 iLookupMs; // total time spent in IHostLookup::Lookup()
+};
+
+class HostResolver;
+
+/*
+ * Per-caller state for HostResolver::Resolve(), allowing a blocked Resolve() to be
+ * interrupted from another thread.
+ */
+class HostResolverClient : private INonCopyable
+{
+    friend class HostResolver;
+public:
+    HostResolverClient();
+    void Interrupt(TBool aInterrupt);
+    TBool IsInterrupted() const;
+private:
+    Semaphore iSem;
+    std::atomic<TBool> iInterrupted;
+    const Brx* iHost;
+    TBool iComplete;
+    TBool iFailed;
+    std::vector<TIpAddress> iAddresses;
+};
+
+/*
+ * Resolves host names on a small pool of worker threads, caching results.
+ *
+ * Numeric (dotted IPv4) hosts are converted directly, without a lookup.  Other hosts are
+ * looked up on whichever worker is free so one slow lookup only delays requests for the
+ * same host.  Successful lookups are cached for aPositiveTtlMs, failed ones for
+ * aNegativeTtlMs (the platform resolver doesn't report record TTLs).  Concurrent requests
+ * for the same host share a single lookup.  The cache is bounded, discarding the least
+ * recently used host.
+ *
+ * Protocols share a single instance per process, accessed via Get() / RemoveRef().
+ */
+class HostResolver : private INonCopyable
+{
+public:
+    static const TUint kMaxHostBytes = 256;
+    static const TUint kMaxEntries = 32;
+    static const TUint kNumWorkers = 4;
+    static const TUint kPositiveTtlMs = 60 * 1000;
+    static const TUint kNegativeTtlMs = 5 * 1000;
+public:
+    static HostResolver& Get(Environment& aEnv);
+    static void RemoveRef(Environment& aEnv);
+public:
+    HostResolver(Environment& aEnv, IHostLookup& aLookup, TUint aPositiveTtlMs, TUint aNegativeTtlMs);
+    ~HostResolver();
+    /*
+     * Blocks until aHost is resolved or aClient is interrupted.
+     * Replaces aAddresses with all addresses for aHost.  Throws NetworkError on failure.
+     */
+    void Resolve(HostResolverClient& aClient, const Brx& aHost, std::vector<TIpAddress>& aAddresses);
+    void Clear();
+    HostResolverStats Stats() const;
+    static TBool TryParseNumeric(const Brx& aHost, TIpAddress& aAddress);
+private:
+    enum class EState
+    {
+        ePending,
+        eLookingUp,
+        eResolved,
+        eFailed
+    };
+    class Entry
+    {
+    public:
+        Entry(const Brx& aHost);
+    public:
+        Bws<kMaxHostBytes> iHost;
+        EState iState;
+        std::vector<TIpAddress> iAddresses;
+        TUint iResolvedMs;
+        TUint64 iLastUsed;
+    };
+private:
+    Entry* FindLocked(const Brx& aHost);
+    Entry* AddLocked(const Brx& aHost);
+    TBool ExpiredLocked(const Entry& aEntry, TUint aNowMs) const;
+    void CompleteLocked(Entry& aEntry);
+    void WorkerRun();
+private:
+    Environment& iEnv;
+    IHostLookup& iLookup;
+    const TUint iPositiveTtlMs;
+    const TUint iNegativeTtlMs;
+    mutable Mutex iLock;
+    std::vector<Entry*> iEntries;
+    std::vector<HostResolverClient*> iClients;
+    TUint64 iUseCount;
+    HostResolverStats iStats;
+    TBool iQuit;
+    Semaphore iSemLookups;
+    std::vector<ThreadFunctor*> iWorkers;
+private:
+    static TUint iRefCount;
+    static HostLookupOs* iSharedLookup;
+    static HostResolver* iShared;
+};
+
+} // namespace Media
+} // namespace OpenHome
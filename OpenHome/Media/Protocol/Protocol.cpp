@@ -102,60 +102,66 @@ Protocol::AutoStream::~AutoStream()
 
 ProtocolNetwork::ProtocolNetwork(Environment& aEnv)
     : Protocol(aEnv)
-    , iReaderBuf(iTcpClient)
+    , iReaderBuf(kReadBufferBytes, iTcpClient)
     , iWriterBuf(iTcpClient)
     , iLock("PRNW")
     , iSocketIsOpen(false)
+    , iHostResolver(HostResolver::Get(aEnv))
 {
 }
 
+ProtocolNetwork::~ProtocolNetwork()
+{
+    HostResolver::RemoveRef(iEnv);
+}
+
 TBool ProtocolNetwork::Connect(const Uri& aUri, TUint aDefaultPort, TUint aTimeoutMs)
 {
     LOG(kMedia, ">ProtocolNetwork::Connect\n");
 
-    Endpoint endpoint;
-    try {
-        endpoint.SetAddress(aUri.Host());
-        TInt port = aUri.Port();
-        if (port == -1) {
-            port = (TInt)aDefaultPort;
-        }
-        endpoint.SetPort(port);
+    TInt port = aUri.Port();
+    if (port == -1) {
+        port = (TInt)aDefaultPort;
     }
-    catch (NetworkError&) {
-        LOG(kMedia, "<Protocol::Connect error setting address and port\n");
-        return false;
-    }
-
     try {
-        Open();
+        iHostResolver.Resolve(iResolverClient, aUri.Host(), iAddresses);
     }
     catch (NetworkError&) {
-        LOG(kMedia, "<ProtocolNetwork::Connect error opening\n");
-        return false;
-    }
-    try {
-        iTcpClient.Connect(endpoint, aTimeoutMs);
-    }
-    catch (NetworkTimeout&) {
-        Close();
-        LOG(kMedia, "<ProtocolNetwork::Connect error connecting\n");
+        LOG(kMedia, "<Protocol::Connect error resolving %.*s\n", PBUF(aUri.Host()));
         return false;
     }
-    catch (NetworkError&) {
-        Close();
-        LOG(kMedia, "<ProtocolNetwork::Connect error connecting\n");
-        return false;
+
+    for (TUint i=0; i<iAddresses.size() && !iResolverClient.IsInterrupted(); i++) {
+        const Endpoint endpoint((TUint)port, iAddresses[i]);
+        try {
+            Open();
+        }
+        catch (NetworkError&) {
+            LOG(kMedia, "<ProtocolNetwork::Connect error opening\n");
+            return false;
+        }
+        try {
+            iTcpClient.Connect(endpoint, aTimeoutMs);
+            LOG(kMedia, "<Protocol::Connect\n");
+            return true;
+        }
+        catch (NetworkTimeout&) {
+            Close();
+        }
+        catch (NetworkError&) {
+            Close();
+        }
     }
 
-    LOG(kMedia, "<Protocol::Connect\n");
-    return true;
+    LOG(kMedia, "<ProtocolNetwork::Connect error connecting\n");
+    return false;
 }
 
 void ProtocolNetwork::Interrupt(TBool aInterrupt)
 {
     iLock.Wait();
     if (iActive) {
+        iResolverClient.Interrupt(aInterrupt);
         iTcpClient.Interrupt(aInterrupt);
     }
     iLock.Signal();
@@ -180,6 +186,66 @@ void ProtocolNetwork::Close()
 }
 
 
+// ReaderBufferDirect
+
+ReaderBufferDirect::ReaderBufferDirect(TUint aMaxBytes, IReaderSource& aSource)
+    : iSource(aSource)
+    , iBuf(aMaxBytes)
+    , iOffset(0)
+{
+}
+
+TBool ReaderBufferDirect::IsLastRead(const Brx& aBuf) const
+{
+    return iOffset == iBuf.Bytes() && aBuf.Ptr() + aBuf.Bytes() == iBuf.Ptr() + iBuf.Bytes();
+}
+
+Brn ReaderBufferDirect::Read(TUint aBytes)
+{
+    if (iOffset == iBuf.Bytes()) {
+        iBuf.SetBytes(0);
+        iOffset = 0;
+        iSource.Read(iBuf);
+        if (iBuf.Bytes() == 0) {
+            THROW(ReaderError);
+        }
+    }
+    const TUint bytes = std::min(aBytes, iBuf.Bytes() - iOffset);
+    Brn buf(iBuf.Ptr() + iOffset, bytes);
+    iOffset += bytes;
+    return buf;
+}
+
+void ReaderBufferDirect::ReadFlush()
+{
+    iBuf.SetBytes(0);
+    iOffset = 0;
+}
+
+void ReaderBufferDirect::ReadInterrupt()
+{
+    iSource.ReadInterrupt();
+}
+
+void ReaderBufferDirect::ReadDirect(Bwx& aBuffer)
+{
+    const TUint space = aBuffer.MaxBytes() - aBuffer.Bytes();
+    ASSERT(space > 0);
+    if (iOffset < iBuf.Bytes()) {
+        aBuffer.Append(Read(space));
+        return;
+    }
+    // IReaderSource::Read() replaces a buffer's contents so read into the unused tail of aBuffer
+    const TUint prevBytes = aBuffer.Bytes();
+    Bwn tail(aBuffer.Ptr() + prevBytes, 0, space);
+    iSource.Read(tail);
+    if (tail.Bytes() == 0) {
+        THROW(ReaderError);
+    }
+    aBuffer.SetBytes(prevBytes + tail.Bytes());
+}
+
+
 // ContentProcessor
 
 ContentProcessor::ContentProcessor()
@@ -290,6 +356,11 @@ Brn ContentProcessor::ReadTag(ReaderUntil& aReader, TUint64& aBytesRemaining)
     }
 }
 
+ProtocolStreamResult ContentProcessor::StreamDirect(IReader& aReader, IReaderDirect& /*aReaderDirect*/, TUint64 aTotalBytes)
+{
+    return Stream(aReader, aTotalBytes);
+}
+
 Brn ContentProcessor::Read(TUint aBytes)
 {
     ASSERT(iReader != nullptr);
@@ -7,6 +7,9 @@
 #include <OpenHome/Private/Network.h>
 #include <OpenHome/Private/Thread.h>
 #include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Protocol/HostResolver.h>
+
+#include <vector>
 
 namespace OpenHome {
 class Environment;
@@ -149,6 +152,47 @@ private:
     };
 };
 
+/*
+ * Allows a reader to append data directly to a caller-supplied buffer, avoiding the
+ * copy from an intermediate buffer that IReader::Read() implies.
+ */
+class IReaderDirect
+{
+public:
+    virtual ~IReaderDirect() {}
+    /*
+     * Appends between 1 and (aBuffer.MaxBytes() - aBuffer.Bytes()) bytes to aBuffer.
+     * Throws ReaderError on end of stream.
+     */
+    virtual void ReadDirect(Bwx& aBuffer) = 0;
+};
+
+/*
+ * Equivalent to Srs, but also allows data to be read directly from the source into a
+ * caller's buffer once any buffered data has been consumed.
+ */
+class ReaderBufferDirect : public IReader, public IReaderDirect, private INonCopyable
+{
+public:
+    ReaderBufferDirect(TUint aMaxBytes, IReaderSource& aSource);
+    /*
+     * Returns true if aBuf, returned by the last call to Read(), consumed all buffered data.
+     * Readers which pass through our data can use this to determine that they are no
+     * longer buffering any data either so can forward to ReadDirect().
+     */
+    TBool IsLastRead(const Brx& aBuf) const;
+public: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+public: // from IReaderDirect
+    void ReadDirect(Bwx& aBuffer) override;
+private:
+    IReaderSource& iSource;
+    Bwh iBuf;
+    TUint iOffset;
+};
+
 class ProtocolNetwork : public Protocol
 {
 protected:
@@ -157,6 +201,11 @@ protected:
     static const TUint kConnectTimeoutMs = 3000;
 protected:
     ProtocolNetwork(Environment& aEnv);
+    ~ProtocolNetwork();
+    /*
+     * Resolves aUri's host via the shared HostResolver then tries each of its addresses
+     * in turn until one accepts a connection.
+     */
     TBool Connect(const Uri& aUri, TUint aDefaultPort, TUint aTimeoutMs = kConnectTimeoutMs);
 protected: // from Protocol
     void Interrupt(TBool aInterrupt) override;
@@ -164,11 +213,15 @@ protected:
     void Open();
     void Close();
 protected:
-    Srs<kReadBufferBytes> iReaderBuf;
+    ReaderBufferDirect iReaderBuf;
     Sws<kWriteBufferBytes> iWriterBuf;
     Mutex iLock;
     SocketTcpClient iTcpClient;
     TBool iSocketIsOpen;
+    HostResolverClient iResolverClient; // Interrupt() alongside iTcpClient to cancel a host lookup; cleared at the start of each stream
+private:
+    HostResolver& iHostResolver;
+    std::vector<TIpAddress> iAddresses;
 };
 
 class ContentProcessor : protected IReader
@@ -186,6 +239,11 @@ public:
     virtual TBool Recognise(const Brx& aUri, const Brx& aMimeType, const Brx& aData) = 0;
     virtual void Reset();
     virtual ProtocolStreamResult Stream(IReader& aReader, TUint64 aTotalBytes) = 0;
+    /*
+     * As Stream() but allows processors which pass data through unmodified to read
+     * directly into their output buffers.  Default implementation calls Stream().
+     */
+    virtual ProtocolStreamResult StreamDirect(IReader& aReader, IReaderDirect& aReaderDirect, TUint64 aTotalBytes);
 protected:
     void SetStream(IReader& aStream);
     Brn ReadLine(ReaderUntil& aReader, TUint64& aBytesRemaining);
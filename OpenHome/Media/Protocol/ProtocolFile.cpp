@@ -1,5 +1,6 @@
 #include <OpenHome/Media/Protocol/ProtocolFactory.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Protocol/FileSource.h>
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Private/File.h>
@@ -16,7 +17,7 @@
 namespace OpenHome {
 namespace Media {
 
-class ProtocolFile : public Protocol, private IReader
+class ProtocolFile : public Protocol, private IReader, private IReaderDirect
 {
 public:
     ProtocolFile(Environment& aEnv);
@@ -33,6 +34,8 @@ private: // from IReader
     Brn Read(TUint aBytes) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+private: // from IReaderDirect
+    void ReadDirect(Bwx& aBuffer) override;
 private:
     TBool IsCurrentStream(TUint aStreamId) const;
 private:
@@ -40,14 +43,15 @@ private:
     Mutex iLock;
     Supply* iSupply;
     Uri iUri;
-    FileStream iFileStream;
-    Srs<kReadBufBytes> iReaderBuf;
+    IFileSource* iFileSource;
+    ReaderBufferDirect iReaderBuf;
     ContentRecogBuf iContentRecogBuf;
     TUint iStreamId;
     TBool iStop;
     TBool iSeek;
+    TBool iReadDirect; // iContentRecogBuf and iReaderBuf are both empty
     TBool iFileOpen;
-    TUint32 iSeekPos;
+    TUint64 iSeekPos;
     TUint iNextFlushId;
 };
 
@@ -70,7 +74,8 @@ ProtocolFile::ProtocolFile(Environment& aEnv)
     : Protocol(aEnv)
     , iLock("PRTF")
     , iSupply(nullptr)
-    , iReaderBuf(iFileStream)
+    , iFileSource(FileSourceFactory::New())
+    , iReaderBuf(kReadBufBytes, *iFileSource)
     , iContentRecogBuf(iReaderBuf)
 {
 }
@@ -78,6 +83,7 @@ ProtocolFile::ProtocolFile(Environment& aEnv)
 ProtocolFile::~ProtocolFile()
 {
     delete iSupply;
+    delete iFileSource;
 }
 
 void ProtocolFile::Initialise(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream)
@@ -89,7 +95,7 @@ void ProtocolFile::Interrupt(TBool aInterrupt)
 {
     iLock.Wait();
     if (aInterrupt) {
-        iFileStream.ReadInterrupt();
+        iFileSource->ReadInterrupt();
     }
     iLock.Signal();
 }
@@ -112,17 +118,17 @@ ProtocolStreamResult ProtocolFile::Stream(const Brx& aUri)
     Brhz pathBuf(iUri.Path());
     TChar* path = pathBuf.Transfer();
     try {
-        IFile* file = IFile::Open(path, eFileReadOnly);
-        iFileStream.SetFile(file);
+        iFileSource->Open(path);
     }
     catch (FileOpenError&) {
         free(path);
         return EProtocolStreamErrorUnrecoverable;
     }
+    iReadDirect = false;
     iFileOpen = true;
     free(path);
-    iFileStream.Interrupt(false);
-    const TUint fileSize = iFileStream.Bytes();
+    iFileSource->Interrupt(false);
+    const TUint64 fileSize = iFileSource->Bytes();
 
     ContentProcessor* contentProcessor = nullptr;
     try {
@@ -140,13 +146,20 @@ ProtocolStreamResult ProtocolFile::Stream(const Brx& aUri)
     iStreamId = iIdProvider->NextStreamId();
     iSupply->OutputStream(iUri.AbsoluteUri(), fileSize, iSeekPos, true, false, Multiroom::Allowed, *this, iStreamId);
     contentProcessor = iProtocolManager->GetAudioProcessor();
-    TUint remaining = fileSize;
+    TUint64 remaining = fileSize;
     while (res == EProtocolStreamErrorRecoverable) {
-        res = contentProcessor->Stream(*this, remaining);
+        res = contentProcessor->StreamDirect(*this, *this, remaining);
         iLock.Wait();
         if (iSeek) {
-            iFileStream.Interrupt(false);
-            iFileStream.Seek(iSeekPos);
+            iFileSource->Interrupt(false);
+            try {
+                iFileSource->Seek(iSeekPos);
+            }
+            catch (FileSeekError&) {
+                LOG(kMedia, "ProtocolFile::Stream failed to seek to %llu\n", iSeekPos);
+                res = EProtocolStreamErrorUnrecoverable;
+            }
+            ReadFlush(); // discard any data buffered from before the seek
             remaining = fileSize - iSeekPos;
             iSeek = false;
             iSeekPos = 0;
@@ -164,7 +177,7 @@ ProtocolStreamResult ProtocolFile::Stream(const Brx& aUri)
     }
 
     iLock.Wait();
-    iFileStream.CloseFile();
+    iFileSource->Close();
     iFileOpen = false;
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iLock.Signal();
@@ -182,17 +195,17 @@ ProtocolGetResult ProtocolFile::Get(IWriter& /*aWriter*/, const Brx& /*aUri*/, T
 TUint ProtocolFile::TrySeek(TUint aStreamId, TUint64 aOffset)
 {
     iLock.Wait();
-    const TBool streamIsValid = IsCurrentStream(aStreamId);
+    const TBool streamIsValid = IsCurrentStream(aStreamId) && aOffset <= iFileSource->Bytes();
     if (streamIsValid) {
         iSeek = true;
-        iSeekPos = (TUint32)aOffset;
+        iSeekPos = aOffset;
         iNextFlushId = iFlushIdProvider->NextFlushId();
     }
     iLock.Signal();
     if (!streamIsValid) {
         return MsgFlush::kIdInvalid;
     }
-    iFileStream.ReadInterrupt();
+    iFileSource->ReadInterrupt();
     return iNextFlushId;
 }
 
@@ -203,7 +216,7 @@ TUint ProtocolFile::TryStop(TUint aStreamId)
     if (stop) {
         iNextFlushId = iFlushIdProvider->NextFlushId();
         iStop = true;
-        iFileStream.ReadInterrupt();
+        iFileSource->ReadInterrupt();
     }
     iLock.Signal();
     if (!stop) {
@@ -219,6 +232,7 @@ Brn ProtocolFile::Read(TUint aBytes)
 
 void ProtocolFile::ReadFlush()
 {
+    iReadDirect = false;
     iContentRecogBuf.ReadFlush();
 }
 
@@ -227,6 +241,18 @@ void ProtocolFile::ReadInterrupt()
     iContentRecogBuf.ReadInterrupt();
 }
 
+void ProtocolFile::ReadDirect(Bwx& aBuffer)
+{
+    if (iReadDirect) {
+        iReaderBuf.ReadDirect(aBuffer);
+    }
+    else {
+        Brn buf = iContentRecogBuf.Read(aBuffer.MaxBytes() - aBuffer.Bytes());
+        aBuffer.Append(buf);
+        iReadDirect = iReaderBuf.IsLastRead(buf);
+    }
+}
+
 TBool ProtocolFile::IsCurrentStream(TUint aStreamId) const
 {
     if (!iFileOpen || iStreamId != aStreamId || aStreamId == IPipelineIdProvider::kStreamIdInvalid) {
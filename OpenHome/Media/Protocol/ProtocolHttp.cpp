@@ -36,6 +36,7 @@ private:
 
 class ProtocolHttp : public ProtocolNetwork
                    , private IReader
+                   , private IReaderDirect
                    , private IIcyObserver
 {
     static const TUint kMaxUserAgentBytes = 64;
@@ -58,6 +59,8 @@ private: // from IReader
     Brn Read(TUint aBytes) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+private: // from IReaderDirect
+    void ReadDirect(Bwx& aBuffer) override;
 private: // from IIcyObserver
     void NotifyIcyData(const Brx& aIcyData) override;
 private:
@@ -97,6 +100,7 @@ private:
     TBool iStarted;
     TBool iStopped;
     TBool iReadSuccess;
+    TBool iReadDirect; // all readers above iReaderBuf are empty and passing data through unmodified
     TUint64 iSeekPos;
     TUint64 iOffset;
     ContentProcessor* iContentProcessor;
@@ -244,6 +248,7 @@ void ProtocolHttp::Interrupt(TBool aInterrupt)
             iStopped = true;
             iSem.Signal(); // no need to check iLive - iSem will be cleared when this protocol is next reused anyway
         }
+        iResolverClient.Interrupt(aInterrupt);
         iTcpClient.Interrupt(aInterrupt);
     }
     iLock.Signal();
@@ -423,6 +428,7 @@ Brn ProtocolHttp::Read(TUint aBytes)
 
 void ProtocolHttp::ReadFlush()
 {
+    iReadDirect = false;
     iReaderIcy->ReadFlush();
 }
 
@@ -431,6 +437,22 @@ void ProtocolHttp::ReadInterrupt()
     iReaderIcy->ReadInterrupt();
 }
 
+void ProtocolHttp::ReadDirect(Bwx& aBuffer)
+{
+    if (!iReadDirect) {
+        Brn buf = Read(aBuffer.MaxBytes() - aBuffer.Bytes());
+        aBuffer.Append(buf);
+        if (!iHeaderTransferEncoding.IsChunked() && !iHeaderIcyMetadata.Received()) {
+            iReadDirect = iReaderBuf.IsLastRead(buf);
+        }
+        return;
+    }
+    const TUint prevBytes = aBuffer.Bytes();
+    iReaderBuf.ReadDirect(aBuffer);
+    iOffset += aBuffer.Bytes() - prevBytes; // normally updated by iReaderIcy
+    iReadSuccess = true;
+}
+
 void ProtocolHttp::NotifyIcyData(const Brx& aIcyData)
 {
     iSupply->OutputMetadata(aIcyData);
@@ -440,10 +462,11 @@ void ProtocolHttp::Reinitialise(const Brx& aUri)
 {
     iTotalStreamBytes = iTotalBytes = iSeekPos = iOffset = 0;
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
-    iSeekable = iSeek = iLive = iStarted = iStopped = iReadSuccess = false;
+    iSeekable = iSeek = iLive = iStarted = iStopped = iReadSuccess = iReadDirect = false;
     iContentProcessor = nullptr;
     iNextFlushId = MsgFlush::kIdInvalid;
     (void)iSem.Clear();
+    iResolverClient.Interrupt(false);
     iUri.Replace(aUri);
     iReaderIcy->Reset();
     iIcyObserverDidlLite->Reset();
@@ -608,6 +631,7 @@ void ProtocolHttp::StartStream()
 
 TUint ProtocolHttp::WriteRequest(TUint64 aOffset)
 {
+    iReadDirect = false;
     iContentRecogBuf.ReadFlush();
     //iTcpClient.LogVerbose(true);
     Close();
@@ -705,7 +729,7 @@ ProtocolStreamResult ProtocolHttp::ProcessContent()
         }
     }
     iContentProcessor = iProtocolManager->GetAudioProcessor();
-    ProtocolStreamResult res = iContentProcessor->Stream(*this, iTotalBytes);
+    ProtocolStreamResult res = iContentProcessor->StreamDirect(*this, *this, iTotalBytes);
     if (!iReadSuccess) {
         return EProtocolStreamErrorUnrecoverable;
     }
@@ -1,5 +1,6 @@
 #include <OpenHome/Media/Protocol/ProtocolFactory.h>
 #include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Protocol/HostResolver.h>
 #include <OpenHome/Exception.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Types.h>
@@ -11,6 +12,7 @@
 #include <OpenHome/Media/Supply.h>
 
 #include <algorithm>
+#include <vector>
 
 namespace OpenHome {
 namespace Media {
@@ -46,6 +48,9 @@ private:
 private:
     Mutex iLock;
     Supply* iSupply;
+    HostResolver& iHostResolver;
+    HostResolverClient iResolverClient;
+    std::vector<TIpAddress> iAddresses;
     SocketSsl iSocket;
     Srs<1024> iReaderBuf;
     ReaderUntilS<kReadBufferBytes> iReaderUntil;
@@ -80,6 +85,7 @@ ProtocolHttps::ProtocolHttps(Environment& aEnv)
     : Protocol(aEnv)
     , iLock("PHTS")
     , iSupply(nullptr)
+    , iHostResolver(HostResolver::Get(aEnv))
     , iSocket(aEnv, kReadBufferBytes)
     , iReaderBuf(iSocket)
     , iReaderUntil(iReaderBuf)
@@ -95,6 +101,7 @@ ProtocolHttps::ProtocolHttps(Environment& aEnv)
 ProtocolHttps::~ProtocolHttps()
 {
     delete iSupply;
+    HostResolver::RemoveRef(iEnv);
 }
 
 void ProtocolHttps::Initialise(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream)
@@ -110,6 +117,7 @@ void ProtocolHttps::Interrupt(TBool aInterrupt)
         if (aInterrupt) {
             iStopped = true;
         }
+        iResolverClient.Interrupt(aInterrupt);
         iSocket.Interrupt(aInterrupt);
     }
     iLock.Signal();
@@ -204,6 +212,7 @@ void ProtocolHttps::ReadInterrupt()
 void ProtocolHttps::Reinitialise(const Brx& aUri)
 {
     iSocket.Interrupt(false);
+    iResolverClient.Interrupt(false);
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iStopped = false;
     iNextFlushId = MsgFlush::kIdInvalid;
@@ -212,20 +221,26 @@ void ProtocolHttps::Reinitialise(const Brx& aUri)
 
 TBool ProtocolHttps::Connect()
 {
-    Endpoint ep;
+    TInt port = iUri.Port();
+    if (port == -1) {
+        port = (TInt)kDefaultPort;
+    }
     try {
-        ep.SetAddress(iUri.Host());
-        TInt port = iUri.Port();
-        if (port == -1) {
-            port = (TInt)kDefaultPort;
-        }
-        ep.SetPort(port);
-        iSocket.Connect(ep, kConnectTimeoutMs);
+        iHostResolver.Resolve(iResolverClient, iUri.Host(), iAddresses);
     }
     catch (NetworkError&) {
         return false;
     }
-    return true;
+    for (TUint i=0; i<iAddresses.size() && !iResolverClient.IsInterrupted(); i++) {
+        const Endpoint ep((TUint)port, iAddresses[i]);
+        try {
+            iSocket.Connect(ep, iUri.Host(), kConnectTimeoutMs);
+            return true;
+        }
+        catch (NetworkError&) {
+        }
+    }
+    return false;
 }
 
 ProtocolStreamResult ProtocolHttps::DoStream()
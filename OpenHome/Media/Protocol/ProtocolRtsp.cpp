@@ -46,6 +46,7 @@ ProtocolStreamResult ProtocolRtsp::Stream(const Brx& aUri)
     iStreamId = IPipelineIdProvider::kStreamIdInvalid;
     iStopped = false;
     iNextFlushId = MsgFlush::kIdInvalid;
+    iResolverClient.Interrupt(false);
     iUri.Replace(aUri);
     iLock.Signal();
     LOG(kMedia, "ProtocolRtsp::Stream(%.*s)\n", PBUF(aUri));
@@ -0,0 +1,333 @@
+#include <OpenHome/Media/Resampler.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+#if defined(__AVX2__) && defined(__FMA__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+static const double kPi = 3.14159265358979323846;
+static const double kKaiserBeta = 9.0;  // ~90dB stopband attenuation
+static const double kRolloff = 0.91;    // cutoff as a fraction of the lower Nyquist frequency
+static const float kScaleIn = 1.0f / 2147483648.0f;
+static const float kScaleOut = 2147483648.0f;
+
+// Resampler
+
+Resampler::Resampler(TUint aMaxInputFrames)
+    : iCapacity(aMaxInputFrames + 3*kTaps) // unconsumed history + a full input block + padding added by Drain()
+    , iRateIn(0)
+    , iRateOut(0)
+    , iNumChannels(0)
+    , iMultiplier(IPullableClock::kNominalFreq)
+    , iStepBase(0)
+    , iStep(0)
+    , iPos(0)
+    , iEnd(0)
+    , iDraining(false)
+    , iDrainEnd(0)
+{
+    iCoeffs = new float[(kPhases + 1) * kTaps];
+    iHistory = new float[kMaxChannels * iCapacity];
+    iInterpolated = new float[kTaps];
+}
+
+Resampler::~Resampler()
+{
+    delete[] iInterpolated;
+    delete[] iHistory;
+    delete[] iCoeffs;
+}
+
+void Resampler::Configure(TUint aRateIn, TUint aRateOut, TUint aNumChannels)
+{
+    ASSERT(aRateIn != 0 && aRateOut != 0);
+    ASSERT(aNumChannels > 0 && aNumChannels <= kMaxChannels);
+    const TBool redesign = (iRateIn == 0 || std::min(aRateIn, aRateOut) * (TUint64)iRateIn != std::min(iRateIn, iRateOut) * (TUint64)aRateIn);
+    iRateIn = aRateIn;
+    iRateOut = aRateOut;
+    iNumChannels = aNumChannels;
+    iStepBase = ((TUint64)aRateIn << 32) / aRateOut;
+    if (redesign) {
+        DesignFilter();
+    }
+    SetPull(iMultiplier);
+    Reset();
+}
+
+void Resampler::SetPull(TUint aMultiplier)
+{
+    iMultiplier = aMultiplier;
+    iStep = (TUint64)(((double)iStepBase * aMultiplier) / IPullableClock::kNominalFreq);
+}
+
+void Resampler::Reset()
+{
+    // history starts with silence so that the first output sample is aligned with the first input sample
+    for (TUint i=0; i<iNumChannels; i++) {
+        (void)memset(iHistory + i*iCapacity, 0, kCentreTap * sizeof(float));
+    }
+    iEnd = kCentreTap;
+    iPos = 0;
+    iDraining = false;
+    iDrainEnd = 0;
+}
+
+void Resampler::Bypass()
+{
+    ASSERT(iEnd >= kCentreTap);
+    iPos = (TUint64)(iEnd - kCentreTap) << 32;
+    iDraining = false;
+}
+
+void Resampler::Push(const TInt32* aInput, TUint aFrames)
+{
+    Compact();
+    ASSERT(iEnd + aFrames <= iCapacity);
+    for (TUint i=0; i<iNumChannels; i++) {
+        float* dest = iHistory + i*iCapacity + iEnd;
+        const TInt32* src = aInput + i;
+        for (TUint j=0; j<aFrames; j++) {
+            *dest++ = (float)*src * kScaleIn;
+            src += iNumChannels;
+        }
+    }
+    iEnd += aFrames;
+}
+
+void Resampler::PushSilence(TUint aFrames)
+{
+    Compact();
+    ASSERT(iEnd + aFrames <= iCapacity);
+    for (TUint i=0; i<iNumChannels; i++) {
+        (void)memset(iHistory + i*iCapacity + iEnd, 0, aFrames * sizeof(float));
+    }
+    iEnd += aFrames;
+}
+
+void Resampler::Drain()
+{
+    PushSilence(kTaps - kCentreTap); // may compact history so calculate end of stream afterwards
+    iDraining = true;
+    iDrainEnd = iEnd - (kTaps - kCentreTap);
+}
+
+TUint Resampler::Pull(TInt32* aOutput, TUint aMaxFrames)
+{
+    TUint frames = 0;
+    while (frames < aMaxFrames && CanOutput()) {
+        const TUint start = (TUint)(iPos >> 32);
+        const TUint frac = (TUint)iPos;
+        const TUint phase = frac >> 24; // top 8 bits => kPhases (256) phases
+        const float* coeffs = iCoeffs + phase*kTaps;
+        const TUint remainder = frac & 0xffffff;
+        if (remainder != 0) {
+            InterpolateCoeffs(coeffs, coeffs + kTaps, remainder * (1.0f / 16777216.0f), iInterpolated);
+            coeffs = iInterpolated;
+        }
+        for (TUint i=0; i<iNumChannels; i++) {
+            const float sample = DotProduct(coeffs, iHistory + i*iCapacity + start) * kScaleOut;
+            if (sample >= 2147483647.0f) {
+                *aOutput++ = 0x7fffffff;
+            }
+            else if (sample <= -2147483648.0f) {
+                *aOutput++ = (TInt32)0x80000000;
+            }
+            else {
+                *aOutput++ = (TInt32)std::lrint(sample);
+            }
+        }
+        iPos += iStep;
+        frames++;
+    }
+    return frames;
+}
+
+TUint Resampler::RateIn() const
+{
+    return iRateIn;
+}
+
+TUint Resampler::RateOut() const
+{
+    return iRateOut;
+}
+
+TUint Resampler::NumChannels() const
+{
+    return iNumChannels;
+}
+
+TUint Resampler::Multiplier() const
+{
+    return iMultiplier;
+}
+
+void Resampler::DesignFilter()
+{
+    /* When only pulling (rates equal) use the full bandwidth so that phase 0 is a unit impulse.
+       Unpulled audio is then passed through unmodified and the alias band is negligible for
+       the fraction of a percent the clock is pulled by. */
+    const double ratio = std::min(1.0, (double)iRateOut / iRateIn);
+    const double cutoff = (iRateIn == iRateOut? 0.5 : 0.5 * ratio * kRolloff); // cycles per input sample
+    const double halfLength = kTaps / 2;
+    const double i0Beta = BesselI0(kKaiserBeta);
+    for (TUint p=0; p<=kPhases; p++) {
+        float* coeffs = iCoeffs + p*kTaps;
+        double sum = 0;
+        for (TUint k=0; k<kTaps; k++) {
+            const double x = (double)k - kCentreTap - ((double)p / kPhases);
+            const double r = x / halfLength;
+            const double window = (r >= 1.0 || r <= -1.0)? 0 : BesselI0(kKaiserBeta * std::sqrt(1.0 - r*r)) / i0Beta;
+            const double h = 2 * cutoff * Sinc(2 * cutoff * x) * window;
+            coeffs[k] = (float)h;
+            sum += h;
+        }
+        // normalise each phase for unity gain at DC
+        for (TUint k=0; k<kTaps; k++) {
+            coeffs[k] = (float)(coeffs[k] / sum);
+        }
+    }
+}
+
+void Resampler::Compact()
+{
+    const TUint start = std::min((TUint)(iPos >> 32), iEnd);
+    if (start == 0) {
+        return;
+    }
+    const TUint remaining = iEnd - start;
+    for (TUint i=0; i<iNumChannels; i++) {
+        float* history = iHistory + i*iCapacity;
+        (void)memmove(history, history + start, remaining * sizeof(float));
+    }
+    iEnd = remaining;
+    iPos -= (TUint64)start << 32;
+    iDrainEnd = (iDrainEnd > start? iDrainEnd - start : 0);
+}
+
+TBool Resampler::CanOutput() const
+{
+    const TUint start = (TUint)(iPos >> 32);
+    if (start + kTaps > iEnd) {
+        return false;
+    }
+    if (iDraining && start + kCentreTap >= iDrainEnd) {
+        return false;
+    }
+    return true;
+}
+
+double Resampler::Sinc(double aX)
+{ // static
+    if (aX == 0) {
+        return 1.0;
+    }
+    const double x = kPi * aX;
+    return std::sin(x) / x;
+}
+
+double Resampler::BesselI0(double aX)
+{ // static
+    // power series; converges quickly for the range of values used by the Kaiser window
+    double sum = 1.0;
+    double term = 1.0;
+    const double halfX = aX / 2;
+    for (TUint k=1; k<50; k++) {
+        term *= halfX / k;
+        const double t2 = term * term;
+        sum += t2;
+        if (t2 < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+void Resampler::InterpolateCoeffs(const float* aPhase, const float* aNextPhase, float aFraction, float* aOut)
+{ // static
+#if defined(__AVX2__) && defined(__FMA__)
+    const __m256 fraction = _mm256_set1_ps(aFraction);
+    for (TUint i=0; i<kTaps; i+=8) {
+        const __m256 a = _mm256_loadu_ps(aPhase + i);
+        const __m256 b = _mm256_loadu_ps(aNextPhase + i);
+        _mm256_storeu_ps(aOut + i, _mm256_fmadd_ps(_mm256_sub_ps(b, a), fraction, a));
+    }
+#elif defined(__SSE2__)
+    const __m128 fraction = _mm_set1_ps(aFraction);
+    for (TUint i=0; i<kTaps; i+=4) {
+        const __m128 a = _mm_loadu_ps(aPhase + i);
+        const __m128 b = _mm_loadu_ps(aNextPhase + i);
+        _mm_storeu_ps(aOut + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), fraction)));
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const float32x4_t fraction = vdupq_n_f32(aFraction);
+    for (TUint i=0; i<kTaps; i+=4) {
+        const float32x4_t a = vld1q_f32(aPhase + i);
+        const float32x4_t b = vld1q_f32(aNextPhase + i);
+        vst1q_f32(aOut + i, vmlaq_f32(a, vsubq_f32(b, a), fraction));
+    }
+#else
+    for (TUint i=0; i<kTaps; i++) {
+        aOut[i] = aPhase[i] + (aNextPhase[i] - aPhase[i]) * aFraction;
+    }
+#endif
+}
+
+float Resampler::DotProduct(const float* aCoeffs, const float* aSamples)
+{ // static
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (TUint i=0; i<kTaps; i+=16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(aCoeffs + i), _mm256_loadu_ps(aSamples + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(aCoeffs + i + 8), _mm256_loadu_ps(aSamples + i + 8), acc1);
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (TUint i=0; i<kTaps; i+=8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(aCoeffs + i), _mm_loadu_ps(aSamples + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(aCoeffs + i + 4), _mm_loadu_ps(aSamples + i + 4)));
+    }
+    __m128 sum = _mm_add_ps(acc0, acc1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    for (TUint i=0; i<kTaps; i+=8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(aCoeffs + i), vld1q_f32(aSamples + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(aCoeffs + i + 4), vld1q_f32(aSamples + i + 4));
+    }
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+    const float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+    float sum[4] = { 0, 0, 0, 0 };
+    for (TUint i=0; i<kTaps; i+=4) {
+        sum[0] += aCoeffs[i]   * aSamples[i];
+        sum[1] += aCoeffs[i+1] * aSamples[i+1];
+        sum[2] += aCoeffs[i+2] * aSamples[i+2];
+        sum[3] += aCoeffs[i+3] * aSamples[i+3];
+    }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+#endif
+}
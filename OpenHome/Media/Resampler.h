@@ -0,0 +1,87 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Standard.h>
+
+namespace OpenHome {
+namespace Media {
+
+///////////////////////////////////////////////////////////////////////////////////////////
+//
+// Resampler: windowed-sinc polyphase sample rate converter.
+//
+// Audio is passed in and out as interleaved, left-justified 32-bit samples (so a 16-bit
+// sample occupies the top 16 bits of each TInt32).  Filtering is done in single precision
+// float; the inner loops use AVX2/FMA, SSE2 or NEON when the compiler targets them.
+// Samples and accumulators have a 24-bit mantissa so output is accurate to ~24 bits; the
+// low byte of 32-bit input is not preserved, even when the ratio is exactly 1.
+//
+// The nominal ratio is set by Configure().  It can then be varied continuously by
+// SetPull() (a fix 1.31 multiplier, as used by IPullableClock), allowing the resampler
+// to act as a software clock.  The filter's cutoff is set by the lower of the two rates
+// so only has to be designed when Configure() is called.
+//
+// Each output sample is calculated from kTaps input samples.  Coefficients for kPhases
+// fractional positions are precalculated; positions in between are linearly interpolated.
+///////////////////////////////////////////////////////////////////////////////////////////
+
+class Resampler : private INonCopyable
+{
+public:
+    static const TUint kTaps = 64;
+    static const TUint kPhases = 256;
+    static const TUint kMaxChannels = 8;
+    static const TUint kCentreTap = kTaps/2 - 1; // coefficient for an input sample that coincides with the output
+public:
+    Resampler(TUint aMaxInputFrames); // max frames passed to a single call to Push()
+    ~Resampler();
+    void Configure(TUint aRateIn, TUint aRateOut, TUint aNumChannels); // also calls Reset()
+    void SetPull(TUint aMultiplier); // >kNominalFreq consumes input faster => produces fewer output samples
+    /*
+     * Discard all history; the next input is the start of a new stream.
+     */
+    void Reset();
+    /*
+     * Treat all buffered input as though it had been output unconverted.
+     * Allows a stream to be passed through until pulling is required then switch to
+     * conversion seamlessly.
+     */
+    void Bypass();
+    void Push(const TInt32* aInput, TUint aFrames); // all available output must have been Pull()ed first
+    void PushSilence(TUint aFrames);
+    /*
+     * Pad the input so that Pull() returns all output up to the end of the stream.
+     */
+    void Drain();
+    TUint Pull(TInt32* aOutput, TUint aMaxFrames); // returns number of frames written
+    TUint RateIn() const;
+    TUint RateOut() const;
+    TUint NumChannels() const;
+    TUint Multiplier() const;
+private:
+    void DesignFilter();
+    void Compact();
+    TBool CanOutput() const;
+    static double Sinc(double aX);
+    static double BesselI0(double aX);
+    static void InterpolateCoeffs(const float* aPhase, const float* aNextPhase, float aFraction, float* aOut);
+    static float DotProduct(const float* aCoeffs, const float* aSamples);
+private:
+    const TUint iCapacity; // frames per channel in iHistory
+    float* iCoeffs;        // (kPhases + 1) * kTaps
+    float* iHistory;       // kMaxChannels * iCapacity, planar
+    float* iInterpolated;  // kTaps
+    TUint iRateIn;
+    TUint iRateOut;
+    TUint iNumChannels;
+    TUint iMultiplier;
+    TUint64 iStepBase;     // input frames per output frame at nominal rate, 32.32 fixed point
+    TUint64 iStep;         // as iStepBase, adjusted by iMultiplier
+    TUint64 iPos;          // position of first tap for next output, 32.32 fixed point, relative to iHistory
+    TUint iEnd;            // number of frames in iHistory
+    TBool iDraining;
+    TUint iDrainEnd;       // if iDraining, no output is generated for positions at or beyond this frame
+};
+
+} // namespace Media
+} // namespace OpenHome
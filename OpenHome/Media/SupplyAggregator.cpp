@@ -13,6 +13,7 @@ using namespace OpenHome::Media;
 SupplyAggregator::SupplyAggregator(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownStreamElement)
     : iMsgFactory(aMsgFactory)
     , iAudioEncoded(nullptr)
+    , iWritable(nullptr)
     , iDownStreamElement(aDownStreamElement)
 {
 }
@@ -22,10 +23,14 @@ SupplyAggregator::~SupplyAggregator()
     if (iAudioEncoded != nullptr) {
         iAudioEncoded->RemoveRef();
     }
+    if (iWritable != nullptr) {
+        iWritable->RemoveRef();
+    }
 }
 
 void SupplyAggregator::Flush()
 {
+    CommitWritable();
     if (iAudioEncoded != nullptr) {
         OutputEncodedAudio();
     }
@@ -37,6 +42,10 @@ void SupplyAggregator::Discard()
         iAudioEncoded->RemoveRef();
         iAudioEncoded = nullptr;
     }
+    if (iWritable != nullptr) {
+        iWritable->RemoveRef();
+        iWritable = nullptr;
+    }
 }
 
 void SupplyAggregator::OutputTrack(Track& aTrack, TBool aStartOfStream)
@@ -83,6 +92,7 @@ void SupplyAggregator::OutputWait()
 
 void SupplyAggregator::Output(Msg* aMsg)
 {
+    CommitWritable();
     if (iAudioEncoded != nullptr) {
         OutputEncodedAudio();
     }
@@ -95,6 +105,21 @@ void SupplyAggregator::OutputEncodedAudio()
     iAudioEncoded = nullptr;
 }
 
+void SupplyAggregator::CommitWritable()
+{
+    if (iWritable == nullptr) {
+        return;
+    }
+    if (iWritable->Bytes() == 0) {
+        iWritable->RemoveRef();
+    }
+    else {
+        ASSERT(iAudioEncoded == nullptr);
+        iAudioEncoded = iMsgFactory.CreateMsgAudioEncoded(iWritable);
+    }
+    iWritable = nullptr;
+}
+
 
 // SupplyAggregatorBytes
 
@@ -121,6 +146,7 @@ void SupplyAggregatorBytes::OutputData(const Brx& aData)
     if (aData.Bytes() == 0) {
         return;
     }
+    CommitWritable();
     if (iAudioEncoded == nullptr) {
         iAudioEncoded = iMsgFactory.CreateMsgAudioEncoded(aData);
     }
@@ -134,6 +160,31 @@ void SupplyAggregatorBytes::OutputData(const Brx& aData)
     }
 }
 
+Bwn SupplyAggregatorBytes::WritableData(TUint aMinBytes)
+{
+    ASSERT(aMinBytes > 0 && aMinBytes <= EncodedAudio::kMaxBytes);
+    if (iWritable != nullptr && iWritable->Unused().MaxBytes() < aMinBytes) {
+        CommitWritable();
+    }
+    if (iWritable == nullptr) {
+        if (iAudioEncoded != nullptr) {
+            OutputEncodedAudio();
+        }
+        iWritable = iMsgFactory.CreateEncodedAudio();
+    }
+    return iWritable->Unused();
+}
+
+void SupplyAggregatorBytes::CommitData(TUint aBytes)
+{
+    ASSERT(iWritable != nullptr);
+    iWritable->Commit(aBytes);
+    if (iWritable->Unused().MaxBytes() == 0) {
+        CommitWritable();
+        OutputEncodedAudio();
+    }
+}
+
 
 // SupplyAggregatorJiffies
 
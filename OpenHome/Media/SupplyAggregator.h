@@ -26,9 +26,11 @@ public: // from ISupply
 protected:
     void Output(Msg* aMsg);
     void OutputEncodedAudio();
+    void CommitWritable();
 protected:
     MsgFactory& iMsgFactory;
     MsgAudioEncoded* iAudioEncoded;
+    EncodedAudio* iWritable; // cell being filled directly.  Only one of this and iAudioEncoded is non-null
 private:
     IPipelineElementDownstream& iDownStreamElement;
 };
@@ -41,6 +43,15 @@ public: // from ISupply
     void OutputStream(const Brx& aUri, TUint64 aTotalBytes, TUint64 aStartPos, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler& aStreamHandler, TUint aStreamId) override;
     void OutputPcmStream(const Brx& aUri, TUint64 aTotalBytes, TBool aSeekable, TBool aLive, Media::Multiroom aMultiroom, IStreamHandler& aStreamHandler, TUint aStreamId, const PcmStreamInfo& aPcmStream) override;
     void OutputData(const Brx& aData) override;
+public:
+    /*
+     * Zero-copy alternative to OutputData().  Returns at least aMinBytes of unused space at
+     * the end of an EncodedAudio cell (aMinBytes must not exceed EncodedAudio::kMaxBytes).
+     * Write data to the start of it then call CommitData() with the number of bytes written.
+     * No other calls may be made on this object between the two.
+     */
+    Bwn WritableData(TUint aMinBytes = 1);
+    void CommitData(TUint aBytes);
 };
 
 class SupplyAggregatorJiffies : public SupplyAggregator
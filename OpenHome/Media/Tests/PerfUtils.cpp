@@ -0,0 +1,118 @@
+#include <OpenHome/Media/Tests/PerfUtils.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <string.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// AllocatorStats
+
+AllocatorStats::AllocatorStats()
+    : iBudgetPeak(0)
+{
+}
+
+void AllocatorStats::Capture()
+{
+    /* AllocatorBase only exposes its stats via IInfoProvider so parse the kQueryMemory
+       report of each allocator, e.g.
+       "Allocator: MsgAudioPcm, capacity:200 cells x 104 bytes, in use:0 cells, peak:42 cells\n" */
+    static const Brn kAllocator("Allocator");
+    static const Brn kBudget("AllocatorBudget");
+    iEntries.clear();
+    iBudgetPeak = 0;
+    for (TUint i=0; i<iInfoProviders.size(); i++) {
+        iLine.SetBytes(0);
+        iInfoProviders[i]->QueryInfo(AllocatorBase::kQueryMemory, *this);
+        Parser parser(iLine);
+        const Brn type = parser.Next(':');
+        if (type == kBudget) {
+            iBudgetPeak = ValueAfter(iLine, "peak:");
+            continue;
+        }
+        if (type != kAllocator) {
+            continue;
+        }
+        Brn name = Ascii::Trim(parser.Next(','));
+        if (name.Bytes() > kMaxNameBytes) {
+            name.Set(name.Ptr(), kMaxNameBytes);
+        }
+        Entry entry;
+        (void)memcpy(entry.iName, name.Ptr(), name.Bytes());
+        entry.iName[name.Bytes()] = '\0';
+        entry.iCellBytes = ValueAfter(iLine, " x ");
+        entry.iCells = ValueAfter(iLine, "capacity:");
+        entry.iPeakCells = ValueAfter(iLine, "peak:");
+        iEntries.push_back(entry);
+    }
+}
+
+void AllocatorStats::PrintJson(const TChar* aIndent) const
+{
+    TUint64 peakBytes = 0;
+    Log::Print("%s\"allocators\": [", aIndent);
+    for (TUint i=0; i<iEntries.size(); i++) {
+        const Entry& entry = iEntries[i];
+        const TUint64 bytes = entry.iPeakCells * entry.iCellBytes;
+        Log::Print("%s\n%s  {\"name\": \"%s\", \"cell_bytes\": %llu, \"cells\": %llu, \"peak_cells\": %llu, \"peak_bytes\": %llu}",
+                   (i == 0? "" : ","), aIndent, entry.iName, entry.iCellBytes, entry.iCells, entry.iPeakCells, bytes);
+        peakBytes += bytes;
+    }
+    if (iEntries.size() == 0) {
+        Log::Print("],\n");
+    }
+    else {
+        Log::Print("\n%s],\n", aIndent);
+    }
+    Log::Print("%s\"allocator_peak_bytes\": %llu,\n", aIndent, peakBytes);
+    Log::Print("%s\"budget_peak_bytes\": %llu,\n", aIndent, iBudgetPeak);
+}
+
+TUint64 AllocatorStats::ValueAfter(const Brx& aLine, const TChar* aKey)
+{ // static
+    const Brn key(aKey);
+    for (TUint i=0; i+key.Bytes()<=aLine.Bytes(); i++) {
+        if (aLine.Split(i, key.Bytes()) == key) {
+            TUint64 val = 0;
+            for (TUint j=i+key.Bytes(); j<aLine.Bytes() && aLine[j] >= '0' && aLine[j] <= '9'; j++) {
+                val = (val * 10) + (aLine[j] - '0');
+            }
+            return val;
+        }
+    }
+    return 0;
+}
+
+void AllocatorStats::Register(IInfoProvider& aProvider, std::vector<Brn>& /*aSupportedQueries*/)
+{
+    iInfoProviders.push_back(&aProvider);
+}
+
+void AllocatorStats::Write(TByte aValue)
+{
+    if (iLine.Bytes() < iLine.MaxBytes()) {
+        iLine.Append(aValue);
+    }
+}
+
+void AllocatorStats::Write(const Brx& aBuffer)
+{
+    const TUint bytes = iLine.MaxBytes() - iLine.Bytes();
+    iLine.Append(aBuffer.Split(0, aBuffer.Bytes() < bytes? aBuffer.Bytes() : bytes));
+}
+
+void AllocatorStats::WriteFlush()
+{
+}
+
+
+// PerfJson
+
+void PerfJson::PrintMilli(const TChar* aIndent, const TChar* aKey, TUint64 aMilli)
+{ // static
+    Log::Print("%s\"%s\": %llu.%03llu,\n", aIndent, aKey, aMilli / 1000, aMilli % 1000);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/InfoProvider.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <vector>
+
+namespace OpenHome {
+namespace Media {
+
+/*
+Collects the allocators registered by a MsgFactory/TrackFactory and prints their
+peak usage as the body of a JSON object, for use by the perf benchmarks.
+Capture() must be called while the allocators are still alive; PrintJson() reports
+the values from the most recent Capture().
+*/
+
+class AllocatorStats : public IInfoAggregator, private IWriter
+{
+    static const TUint kMaxLineBytes = 256;
+    static const TUint kMaxNameBytes = 64;
+public:
+    AllocatorStats();
+    void Capture();
+    void PrintJson(const TChar* aIndent) const;
+private:
+    static TUint64 ValueAfter(const Brx& aLine, const TChar* aKey);
+private: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    class Entry
+    {
+    public:
+        TChar iName[kMaxNameBytes+1];
+        TUint64 iCellBytes;
+        TUint64 iCells;
+        TUint64 iPeakCells;
+    };
+private:
+    std::vector<IInfoProvider*> iInfoProviders;
+    std::vector<Entry> iEntries;
+    TUint64 iBudgetPeak;
+    Bws<kMaxLineBytes> iLine;
+};
+
+class PerfJson
+{
+public:
+    static void PrintMilli(const TChar* aIndent, const TChar* aKey, TUint64 aMilli); // prints "aKey": aMilli/1000 to 3dp, followed by a comma
+};
+
+} // namespace Media
+} // namespace OpenHome
+
@@ -0,0 +1,123 @@
+#include <OpenHome/Media/Utils/ShmPcmRing.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/*
+    Sample consumer for AnimatorShm.  Deliberately uses nothing from this tree other than
+    ShmPcmRing.h, as an out of process DSP would.
+
+    Reads from the ring in realtime (every kPeriodMs, paced against CLOCK_MONOTONIC),
+    optionally appending raw audio to a file, and prints ring occupancy, the producer's
+    requested pull and the current format once per second.
+
+    Usage: ShmPcmConsumer <shm name> [--latency-us <us>] [--output <file>]
+*/
+
+using namespace OpenHome::Media;
+
+static const uint32_t kPeriodMs = 5;
+
+static void Usage(const char* aProgram)
+{
+    fprintf(stderr, "Usage: %s <shm name> [--latency-us <us>] [--output <file>]\n", aProgram);
+}
+
+int main(int aArgc, char* aArgv[])
+{
+    if (aArgc < 2) {
+        Usage(aArgv[0]);
+        return 1;
+    }
+    const char* name = aArgv[1];
+    uint32_t latencyUs = 0;
+    const char* outputPath = nullptr;
+    for (int i=2; i<aArgc; i++) {
+        if (strcmp(aArgv[i], "--latency-us") == 0 && i+1 < aArgc) {
+            latencyUs = (uint32_t)strtoul(aArgv[++i], nullptr, 10);
+        }
+        else if (strcmp(aArgv[i], "--output") == 0 && i+1 < aArgc) {
+            outputPath = aArgv[++i];
+        }
+        else {
+            Usage(aArgv[0]);
+            return 1;
+        }
+    }
+
+    ShmPcmRingReader reader;
+    while (!reader.Open(name)) {
+        fprintf(stderr, "Waiting for %s...\n", name);
+        (void)sleep(1);
+    }
+    FILE* output = nullptr;
+    if (outputPath != nullptr) {
+        output = fopen(outputPath, "wb");
+        if (output == nullptr) {
+            fprintf(stderr, "Failed to open %s (%d)\n", outputPath, errno);
+            return 1;
+        }
+    }
+    ShmPcmRingHeader& header = reader.Header();
+    header.iConsumerLatencyUs.store(latencyUs, std::memory_order_relaxed);
+
+    static uint8_t buf[192000 / 1000 * kPeriodMs * 8 * 4];
+    uint64_t framesDue = 0;  // fractional frames are carried in framesDueRem
+    uint64_t framesDueRem = 0;
+    uint64_t underruns = 0;
+    uint64_t bytesThisSecond = 0;
+    uint32_t periods = 0;
+    struct timespec deadline;
+    (void)clock_gettime(CLOCK_MONOTONIC, &deadline);
+    for (;;) {
+        deadline.tv_nsec += kPeriodMs * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_nsec -= 1000000000;
+            deadline.tv_sec++;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+        }
+        if (header.iState.load(std::memory_order_acquire) == eShmPcmRingClosed) {
+            break;
+        }
+        if (reader.FormatChanged()) {
+            fprintf(stderr, "Format: %uHz, %u channels, %u bit (%u bytes per sample)\n",
+                    header.iSampleRate, header.iNumChannels, header.iBitDepth, header.iBytesPerSample);
+            framesDueRem = 0;
+        }
+        const uint32_t frameBytes = reader.FrameBytes();
+        if (frameBytes != 0) {
+            // consume one period at the stream's nominal rate, carrying any fractional frame
+            framesDueRem += (uint64_t)header.iSampleRate * kPeriodMs;
+            framesDue = framesDueRem / 1000;
+            framesDueRem %= 1000;
+            const uint32_t wanted = (uint32_t)framesDue * frameBytes;
+            const uint32_t bytes = reader.Read(buf, wanted < sizeof(buf)? wanted : sizeof(buf));
+            if (bytes < wanted && header.iState.load(std::memory_order_relaxed) == eShmPcmRingPlaying) {
+                underruns++;
+            }
+            if (output != nullptr && bytes > 0) {
+                (void)fwrite(buf, 1, bytes, output);
+            }
+            bytesThisSecond += bytes;
+        }
+        if (++periods == 1000 / kPeriodMs) {
+            const uint64_t occupancy = reader.AvailableBytes();
+            const double pull = header.iPullMultiplier.load(std::memory_order_relaxed) / (double)(1u << 31);
+            const uint32_t rate = header.iSampleRate;
+            const double occupancyMs = (frameBytes == 0 || rate == 0)? 0 : (occupancy * 1000.0) / ((double)frameBytes * rate);
+            printf("read %8llu bytes, occupancy %6.2fms, pull %.6f, underruns %llu, format %uHz/%uch/%ubit\n",
+                   (unsigned long long)bytesThisSecond, occupancyMs, pull, (unsigned long long)underruns,
+                   rate, header.iNumChannels, header.iBitDepth);
+            (void)fflush(stdout);
+            bytesThisSecond = 0;
+            periods = 0;
+        }
+    }
+
+    if (output != nullptr) {
+        (void)fclose(output);
+    }
+    return 0;
+}
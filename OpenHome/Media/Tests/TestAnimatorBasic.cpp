@@ -0,0 +1,235 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Utils/AnimatorBasic.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Private/Printer.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteAnimatorBasic : public SuiteUnitTest, private IPipeline
+{
+    static const TUint kMsgFrames = 64;
+    static const TUint kChannels = 2;
+    static const TUint kBitDepth = 16;
+    static const TUint kToleranceMs = 20;
+    static const SpeakerProfile kProfile;
+public:
+    SuiteAnimatorBasic(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Start(TUint aSampleRate, TUint aPeriodMs, AnimatorBasic::EPacing aPacing);
+    void CheckPlayed(const AnimatorBasic::JitterStats& aStats, TUint64 aMultiplier);
+private:
+    void PeriodJiffiesExact();
+    void PeriodJiffiesPulled();
+    void PeriodOutOfRangeRejected();
+    void PreciseSampleAccurate();
+    void PrecisePulled();
+    void JitterStatsReported();
+private: // from IPipeline
+    Msg* Pull() override;
+    void SetAnimator(IPipelineAnimator& aAnimator) override;
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    AnimatorBasic* iAnimator;
+    Mutex iLock;
+    TUint iSampleRate;
+    TBool iStreamSent;
+    TBool iQuit;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteAnimatorBasic
+
+const SpeakerProfile SuiteAnimatorBasic::kProfile(2);
+
+SuiteAnimatorBasic::SuiteAnimatorBasic(Environment& aEnv)
+    : SuiteUnitTest("AnimatorBasic")
+    , iEnv(aEnv)
+    , iLock("TANB")
+{
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::PeriodJiffiesExact), "PeriodJiffiesExact");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::PeriodJiffiesPulled), "PeriodJiffiesPulled");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::PeriodOutOfRangeRejected), "PeriodOutOfRangeRejected");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::PreciseSampleAccurate), "PreciseSampleAccurate");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::PrecisePulled), "PrecisePulled");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorBasic::JitterStatsReported), "JitterStatsReported");
+}
+
+void SuiteAnimatorBasic::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(50, 50);
+    init.SetMsgPlayableCount(50, 1);
+    init.SetMsgDecodedStreamCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iAnimator = nullptr;
+    iSampleRate = 0;
+    iStreamSent = false;
+    iQuit = false;
+}
+
+void SuiteAnimatorBasic::TearDown()
+{
+    if (iAnimator != nullptr) {
+        iLock.Wait();
+        iQuit = true;
+        iLock.Signal();
+        delete iAnimator;
+    }
+    delete iMsgFactory;
+}
+
+void SuiteAnimatorBasic::Start(TUint aSampleRate, TUint aPeriodMs, AnimatorBasic::EPacing aPacing)
+{
+    iSampleRate = aSampleRate;
+    iAnimator = new AnimatorBasic(iEnv, *this, true, aPeriodMs, aPacing);
+    Thread::Sleep(50); // let the animator settle before measuring
+    iAnimator->ResetJitterStats();
+}
+
+void SuiteAnimatorBasic::CheckPlayed(const AnimatorBasic::JitterStats& aStats, TUint64 aMultiplier)
+{
+    const TUint64 expected = (aStats.iElapsedUs * Jiffies::kPerMs * aMultiplier) / (1000 * IPullableClock::kNominalFreq);
+    const TUint64 diff = (aStats.iJiffiesPlayed > expected? aStats.iJiffiesPlayed - expected : expected - aStats.iJiffiesPlayed);
+    if (diff > kToleranceMs * Jiffies::kPerMs) {
+        Print("played %llums, expected %llums\n", aStats.iJiffiesPlayed / Jiffies::kPerMs, expected / Jiffies::kPerMs);
+    }
+    TEST(diff <= kToleranceMs * Jiffies::kPerMs);
+    TEST(aStats.iDropouts == 0);
+}
+
+Msg* SuiteAnimatorBasic::Pull()
+{
+    iLock.Wait();
+    const TBool quit = iQuit;
+    iLock.Signal();
+    if (quit) {
+        return iMsgFactory->CreateMsgQuit();
+    }
+    if (!iStreamSent) {
+        iStreamSent = true;
+        return iMsgFactory->CreateMsgDecodedStream(1, 100, kBitDepth, iSampleRate, kChannels, Brn("Dummy"), 0, 0, true, true, false, false, Multiroom::Allowed, kProfile, nullptr);
+    }
+    Bws<kMsgFrames * kChannels * (kBitDepth/8)> buf;
+    buf.SetBytes(buf.MaxBytes());
+    buf.Fill(0);
+    MsgAudioPcm* audio = iMsgFactory->CreateMsgAudioPcm(buf, kChannels, iSampleRate, kBitDepth, AudioDataEndian::Big, 0);
+    return audio->CreatePlayable();
+}
+
+void SuiteAnimatorBasic::SetAnimator(IPipelineAnimator& /*aAnimator*/)
+{
+}
+
+void SuiteAnimatorBasic::PeriodJiffiesExact()
+{
+    static const TUint kPeriods[] = { 1, 3, 5, 7, 20 };
+    static const TUint kHourMs = 60 * 60 * 1000;
+    for (auto periodMs : kPeriods) {
+        TUint64 remainder = 0;
+        TUint64 total = 0;
+        for (TUint i=0; i<kHourMs/periodMs; i++) {
+            total += AnimatorBasic::PeriodJiffies(periodMs, IPullableClock::kNominalFreq, remainder);
+        }
+        const TUint64 expected = (TUint64)(kHourMs - (kHourMs % periodMs)) * Jiffies::kPerMs;
+        TEST(total == expected);
+        TEST(remainder == 0);
+    }
+    // an hour at 44.1kHz is a whole number of samples, all of which are accounted for
+    TUint64 remainder = 0;
+    TUint64 total = 0;
+    for (TUint i=0; i<kHourMs/5; i++) {
+        total += AnimatorBasic::PeriodJiffies(5, IPullableClock::kNominalFreq, remainder);
+    }
+    TEST(total % Jiffies::PerSample(44100) == 0);
+    TEST(total / Jiffies::PerSample(44100) == 60 * 60 * 44100);
+}
+
+void SuiteAnimatorBasic::PeriodJiffiesPulled()
+{
+    static const TUint kHourMs = 60 * 60 * 1000;
+    const TUint64 multiplier = IPullableClock::kNominalFreq + (IPullableClock::kNominalFreq / 100);
+    TUint64 remainder = 0;
+    TUint64 total = 0;
+    for (TUint i=0; i<kHourMs/5; i++) {
+        total += AnimatorBasic::PeriodJiffies(5, multiplier, remainder);
+    }
+    const TUint64 expected = ((TUint64)kHourMs * Jiffies::kPerMs * multiplier) / IPullableClock::kNominalFreq;
+    TEST(total == expected);
+}
+
+void SuiteAnimatorBasic::PeriodOutOfRangeRejected()
+{
+    TEST_THROWS(new AnimatorBasic(iEnv, *this, false, AnimatorBasic::kPeriodMsMin - 1), AssertionFailed);
+    TEST_THROWS(new AnimatorBasic(iEnv, *this, false, AnimatorBasic::kPeriodMsMax + 1), AssertionFailed);
+}
+
+void SuiteAnimatorBasic::PreciseSampleAccurate()
+{
+    // 1ms at 7350Hz is 7.35 samples, so any part-sample dropped each period would lose ~5% of audio
+    Start(7350, 1, AnimatorBasic::ePacingPrecise);
+    Thread::Sleep(1000);
+    AnimatorBasic::JitterStats stats;
+    iAnimator->GetJitterStats(stats);
+    CheckPlayed(stats, IPullableClock::kNominalFreq);
+}
+
+void SuiteAnimatorBasic::PrecisePulled()
+{
+    Start(44100, 5, AnimatorBasic::ePacingPrecise);
+    const TUint64 multiplier = IPullableClock::kNominalFreq + iAnimator->MaxPull();
+    iAnimator->PullClock((TUint)multiplier);
+    iAnimator->ResetJitterStats();
+    Thread::Sleep(1000);
+    AnimatorBasic::JitterStats stats;
+    iAnimator->GetJitterStats(stats);
+    CheckPlayed(stats, multiplier);
+}
+
+void SuiteAnimatorBasic::JitterStatsReported()
+{
+    static const TUint kPeriodMs = 5;
+    Start(48000, kPeriodMs, AnimatorBasic::ePacingPrecise);
+    Thread::Sleep(500);
+    AnimatorBasic::JitterStats stats;
+    iAnimator->GetJitterStats(stats);
+    const TUint64 expectedWakeups = stats.iElapsedUs / (kPeriodMs * 1000);
+    TEST(stats.iWakeups + 2 >= expectedWakeups);
+    TEST(stats.iWakeups <= expectedWakeups + 1);
+    TEST(stats.iLateMinUs <= stats.iLateMeanUs);
+    TEST(stats.iLateMeanUs <= stats.iLateMaxUs);
+    Print("Jitter over %u wakeups: min=%uus, mean=%uus, max=%uus, stddev=%uus\n", (TUint)stats.iWakeups,
+          (TUint)stats.iLateMinUs, (TUint)stats.iLateMeanUs, (TUint)stats.iLateMaxUs, (TUint)stats.iLateStdDevUs);
+
+    iAnimator->ResetJitterStats();
+    iAnimator->GetJitterStats(stats);
+    TEST(stats.iWakeups <= 1);
+    TEST(stats.iDropouts == 0);
+    TEST(stats.iElapsedUs < kPeriodMs * 1000 * 2);
+}
+
+
+
+void TestAnimatorBasic(Environment& aEnv)
+{
+    Runner runner("AnimatorBasic tests\n");
+    runner.Add(new SuiteAnimatorBasic(aEnv));
+    runner.Run();
+}
@@ -0,0 +1,475 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Utils/AnimatorShm.h>
+#include <OpenHome/Media/Utils/ShmPcmRing.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteAnimatorShm : public SuiteUnitTest, private IPipeline
+{
+    static const TUint kSampleRate = 48000;
+    static const TUint kChannels = 2;
+    static const TUint kBufferMs = 20;
+    static const TUint kMsgFrames = 240; // 5ms @ 48k
+    static const SpeakerProfile kProfile;
+    static const Brn kShmName;
+    enum EContent
+    {
+        eRamp
+       ,eSilence
+       ,eImpulse
+    };
+public:
+    SuiteAnimatorShm(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void PushStream(TUint aBitDepth, TUint aChannels = kChannels);
+    void PushAudio(TUint aBitDepth, TUint aNumMsgs, EContent aContent = eRamp,
+                   TUint aChannels = kChannels, TUint aFrames = kMsgFrames);
+    void PushDrain();
+    void StartConsumer(TBool aRealTime);
+    void StopConsumer();
+    void ConsumerThread();
+    void WaitForBytes(TUint aBytes);
+    void Drained();
+private:
+    void HeaderInitialised();
+    void Audio16DeliveredNativeEndian();
+    void Audio24DeliveredLeftJustified();
+    void FormatChangeSignalled();
+    void FormatChangeRealignsFrames();
+    void RingLimitedToBufferDuration();
+    void DelayIncludesConsumerLatency();
+    void UnsupportedFormatsRejected();
+    void PullPublished();
+    void DrainWaitsForConsumer();
+    void Latency();
+    void StalledConsumerDiscards();
+private: // from IPipeline
+    Msg* Pull() override;
+    void SetAnimator(IPipelineAnimator& aAnimator) override;
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    MsgQueue iQueue;
+    AnimatorShm* iAnimator;
+    IPipelineAnimator* iPipelineAnimator;
+    ShmPcmRingReader iReader;
+    ThreadFunctor* iConsumer;
+    Mutex iLock;
+    Semaphore iSemDrained;
+    std::vector<TByte> iReceived;
+    TBool iConsumerRealTime;
+    TBool iConsumerQuit;
+    TUint64 iImpulseReadUs;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteAnimatorShm
+
+const SpeakerProfile SuiteAnimatorShm::kProfile(2);
+const Brn SuiteAnimatorShm::kShmName("/ohPipelineTestShm");
+
+SuiteAnimatorShm::SuiteAnimatorShm(Environment& aEnv)
+    : SuiteUnitTest("AnimatorShm")
+    , iEnv(aEnv)
+    , iLock("TASM")
+    , iSemDrained("TASM", 0)
+{
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::HeaderInitialised), "HeaderInitialised");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::Audio16DeliveredNativeEndian), "Audio16DeliveredNativeEndian");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::Audio24DeliveredLeftJustified), "Audio24DeliveredLeftJustified");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::FormatChangeSignalled), "FormatChangeSignalled");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::FormatChangeRealignsFrames), "FormatChangeRealignsFrames");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::RingLimitedToBufferDuration), "RingLimitedToBufferDuration");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::DelayIncludesConsumerLatency), "DelayIncludesConsumerLatency");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::UnsupportedFormatsRejected), "UnsupportedFormatsRejected");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::PullPublished), "PullPublished");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::DrainWaitsForConsumer), "DrainWaitsForConsumer");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::Latency), "Latency");
+    AddTest(MakeFunctor(*this, &SuiteAnimatorShm::StalledConsumerDiscards), "StalledConsumerDiscards");
+}
+
+void SuiteAnimatorShm::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(100, 100);
+    init.SetMsgPlayableCount(100, 10);
+    init.SetMsgDecodedStreamCount(4);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iPipelineAnimator = nullptr;
+    iAnimator = new AnimatorShm(iEnv, *this, kShmName, kBufferMs);
+    TEST(iPipelineAnimator == iAnimator);
+    TEST(iReader.Open(reinterpret_cast<const TChar*>(Bws<64>(kShmName).PtrZ())));
+    iConsumer = nullptr;
+    iReceived.clear();
+    iConsumerRealTime = false;
+    iConsumerQuit = false;
+    iImpulseReadUs = 0;
+    iSemDrained.Clear();
+}
+
+void SuiteAnimatorShm::TearDown()
+{
+    StopConsumer();
+    iQueue.Enqueue(iMsgFactory->CreateMsgQuit());
+    // MsgQuit may be behind audio; allow the animator to discard that before it exits
+    delete iAnimator;
+    iReader.Close();
+    delete iMsgFactory;
+}
+
+void SuiteAnimatorShm::PushStream(TUint aBitDepth, TUint aChannels)
+{
+    const SpeakerProfile profile(aChannels);
+    iQueue.Enqueue(iMsgFactory->CreateMsgDecodedStream(1, 100, aBitDepth, kSampleRate, aChannels, Brn("Dummy"), 0, 0, true, true, false, false, Multiroom::Allowed, profile, nullptr));
+}
+
+void SuiteAnimatorShm::PushAudio(TUint aBitDepth, TUint aNumMsgs, EContent aContent, TUint aChannels, TUint aFrames)
+{
+    // eRamp => each sample is distinct; eImpulse => a single non-zero sample at the start of the first msg
+    const TUint bytesPerSample = aBitDepth / 8;
+    const TUint samplesPerMsg = aFrames * aChannels;
+    Bws<kMsgFrames * kChannels * 4> buf;
+    ASSERT(samplesPerMsg * bytesPerSample <= buf.MaxBytes());
+    for (TUint i=0; i<aNumMsgs; i++) {
+        buf.SetBytes(0);
+        for (TUint j=0; j<samplesPerMsg; j++) {
+            TUint32 val = 0;
+            if (aContent == eRamp) {
+                val = (i * samplesPerMsg + j) * 0x10101 + 0x10;
+            }
+            else if (aContent == eImpulse && i == 0 && j == 0) {
+                val = 0x7fffff;
+            }
+            for (TUint k=0; k<bytesPerSample; k++) {
+                buf.Append((TByte)(val >> (8 * (bytesPerSample - 1 - k))));
+            }
+        }
+        MsgAudioPcm* audio = iMsgFactory->CreateMsgAudioPcm(buf, aChannels, kSampleRate, aBitDepth, AudioDataEndian::Big, 0);
+        iQueue.Enqueue(audio->CreatePlayable());
+    }
+}
+
+void SuiteAnimatorShm::PushDrain()
+{
+    iQueue.Enqueue(iMsgFactory->CreateMsgDrain(MakeFunctor(*this, &SuiteAnimatorShm::Drained)));
+}
+
+void SuiteAnimatorShm::Drained()
+{
+    iSemDrained.Signal();
+}
+
+void SuiteAnimatorShm::StartConsumer(TBool aRealTime)
+{
+    iConsumerRealTime = aRealTime;
+    iConsumerQuit = false;
+    iConsumer = new ThreadFunctor("ShmConsumer", MakeFunctor(*this, &SuiteAnimatorShm::ConsumerThread), kPrioritySystemHighest - 1);
+    iConsumer->Start();
+}
+
+void SuiteAnimatorShm::StopConsumer()
+{
+    if (iConsumer != nullptr) {
+        iLock.Wait();
+        iConsumerQuit = true;
+        iLock.Signal();
+        delete iConsumer;
+        iConsumer = nullptr;
+    }
+}
+
+void SuiteAnimatorShm::ConsumerThread()
+{
+    // either reads everything available or, like a DAC, reads at the stream's sample rate
+    TByte buf[4096];
+    const TUint64 startUs = ShmPcmRingNowUs();
+    TUint64 framesRead = 0;
+    for (;;) {
+        iLock.Wait();
+        const TBool quit = iConsumerQuit;
+        iLock.Signal();
+        if (quit) {
+            break;
+        }
+        (void)iReader.FormatChanged();
+        TUint maxBytes = sizeof(buf);
+        const TUint frameBytes = iReader.FrameBytes();
+        TUint64 due = 0;
+        if (iConsumerRealTime && frameBytes > 0) {
+            due = ((ShmPcmRingNowUs() - startUs) * kSampleRate) / 1000000;
+            maxBytes = (TUint)std::min((TUint64)sizeof(buf) / frameBytes, due - std::min(due, framesRead)) * frameBytes;
+        }
+        const TUint bytes = (maxBytes == 0? 0 : iReader.Read(buf, maxBytes));
+        if (frameBytes > 0) {
+            framesRead += bytes / frameBytes;
+            if (iConsumerRealTime && bytes < maxBytes) {
+                framesRead = due; // underrun; like a DAC, don't catch up on audio that was missed
+            }
+        }
+        iLock.Wait();
+        for (TUint i=0; i<bytes; i++) {
+            if (iImpulseReadUs == 0 && buf[i] != 0 && iConsumerRealTime) {
+                iImpulseReadUs = ShmPcmRingNowUs();
+            }
+            iReceived.push_back(buf[i]);
+        }
+        iLock.Signal();
+        Thread::Sleep(1);
+    }
+}
+
+void SuiteAnimatorShm::WaitForBytes(TUint aBytes)
+{
+    for (TUint i=0; i<2000; i++) {
+        iLock.Wait();
+        const TUint received = (TUint)iReceived.size();
+        iLock.Signal();
+        if (received >= aBytes) {
+            return;
+        }
+        Thread::Sleep(1);
+    }
+}
+
+void SuiteAnimatorShm::HeaderInitialised()
+{
+    ShmPcmRingHeader& header = iReader.Header();
+    TEST(header.iMagic == kShmPcmRingMagic);
+    TEST(header.iVersion == kShmPcmRingVersion);
+    TEST(header.iDataOffset == kShmPcmRingDataOffset);
+    TEST(header.iDataBytes % kShmPcmRingFrameAlign == 0);
+    TEST(header.iDataBytes >= (AnimatorShm::kMaxSampleRate / 1000) * kBufferMs * AnimatorShm::kMaxChannels * 4);
+    TEST(header.iState.load() == eShmPcmRingStarting);
+    TEST(header.iPullMultiplier.load() == IPullableClock::kNominalFreq);
+    TEST(header.iWriteBytes.load() == 0);
+}
+
+void SuiteAnimatorShm::Audio16DeliveredNativeEndian()
+{
+    StartConsumer(false);
+    PushStream(16);
+    PushAudio(16, 20);
+    const TUint expectedBytes = 20 * kMsgFrames * kChannels * 2;
+    WaitForBytes(expectedBytes);
+    AutoMutex _(iLock);
+    TEST(iReceived.size() == expectedBytes);
+    TUint mismatches = 0;
+    const TInt16* samples = reinterpret_cast<const TInt16*>(&iReceived[0]);
+    for (TUint i=0; i<iReceived.size()/2; i++) {
+        const TInt16 expected = (TInt16)(TUint16)((i * 0x10101 + 0x10) & 0xffff);
+        if (samples[i] != expected) {
+            mismatches++;
+        }
+    }
+    TEST(mismatches == 0);
+    TEST(iReader.Header().iState.load() == eShmPcmRingPlaying);
+}
+
+void SuiteAnimatorShm::Audio24DeliveredLeftJustified()
+{
+    StartConsumer(false);
+    PushStream(24);
+    PushAudio(24, 20);
+    const TUint expectedBytes = 20 * kMsgFrames * kChannels * 4;
+    WaitForBytes(expectedBytes);
+    AutoMutex _(iLock);
+    TEST(iReceived.size() == expectedBytes);
+    TUint mismatches = 0;
+    const TInt32* samples = reinterpret_cast<const TInt32*>(&iReceived[0]);
+    for (TUint i=0; i<iReceived.size()/4; i++) {
+        const TInt32 expected = (TInt32)(((i * 0x10101 + 0x10) & 0xffffff) << 8);
+        if (samples[i] != expected) {
+            mismatches++;
+        }
+    }
+    TEST(mismatches == 0);
+}
+
+void SuiteAnimatorShm::FormatChangeSignalled()
+{
+    ShmPcmRingHeader& header = iReader.Header();
+    TEST(!iReader.FormatChanged());
+    PushStream(24);
+    PushAudio(24, 1);
+    for (TUint i=0; i<1000 && header.iWriteBytes.load() == 0; i++) {
+        Thread::Sleep(1);
+    }
+    TEST(iReader.FormatChanged());
+    TEST(header.iSampleRate == kSampleRate);
+    TEST(header.iNumChannels == kChannels);
+    TEST(header.iBitDepth == 24);
+    TEST(header.iBytesPerSample == 4);
+    TEST(!iReader.FormatChanged());
+
+    // format can't change until the consumer has emptied the ring
+    PushStream(16);
+    PushAudio(16, 1);
+    Thread::Sleep(20);
+    TEST(!iReader.FormatChanged());
+    StartConsumer(false);
+    WaitForBytes(kMsgFrames * kChannels * (4 + 2));
+    TEST(header.iBitDepth == 16);
+    TEST(header.iBytesPerSample == 2);
+}
+
+void SuiteAnimatorShm::FormatChangeRealignsFrames()
+{
+    // 16-bit mono with an odd number of frames leaves the write cursor part way through a
+    // 24-bit stereo frame.  Enough 24-bit audio follows to wrap the ring.
+    static const TUint kMonoFrames = kMsgFrames + 1;
+    static const TUint kMonoBytes = kMonoFrames * 2;
+    const TUint stereoMsgs = (iReader.Header().iDataBytes / (kMsgFrames * kChannels * 4)) + 10;
+    StartConsumer(false);
+    PushStream(16, 1);
+    PushAudio(16, 1, eRamp, 1, kMonoFrames);
+    WaitForBytes(kMonoBytes);
+    PushStream(24);
+    PushAudio(24, stereoMsgs);
+    const TUint expectedBytes = kMonoBytes + (stereoMsgs * kMsgFrames * kChannels * 4);
+    WaitForBytes(expectedBytes);
+    TEST(iReader.Header().iWriteBytes.load() % (kChannels * 4) == 0);
+    AutoMutex _(iLock);
+    TEST(iReceived.size() == expectedBytes);
+    TUint mismatches = 0;
+    for (TUint i=0; i<(iReceived.size() - kMonoBytes)/4; i++) {
+        TInt32 sample;
+        (void)memcpy(&sample, &iReceived[kMonoBytes + 4*i], sizeof(sample)); // mono audio leaves this unaligned
+        const TInt32 expected = (TInt32)(((i * 0x10101 + 0x10) & 0xffffff) << 8);
+        if (sample != expected) {
+            mismatches++;
+        }
+    }
+    TEST(mismatches == 0);
+}
+
+void SuiteAnimatorShm::RingLimitedToBufferDuration()
+{
+    PushStream(16);
+    PushAudio(16, 20); // 100ms
+    Thread::Sleep(50);
+    const TUint limitBytes = ((kSampleRate * kBufferMs) / 1000) * kChannels * 2;
+    TEST(iReader.AvailableBytes() == limitBytes);
+    TEST(iPipelineAnimator->PipelineAnimatorBufferJiffies() == kBufferMs * Jiffies::kPerMs);
+
+    // consumer reading allows more to be written; occupancy is restored
+    TByte buf[960];
+    TEST(iReader.Read(buf, sizeof(buf)) == sizeof(buf)); // 5ms
+    Thread::Sleep(20);
+    TEST(iReader.AvailableBytes() == limitBytes);
+}
+
+void SuiteAnimatorShm::DelayIncludesConsumerLatency()
+{
+    TEST(iPipelineAnimator->PipelineAnimatorDelayJiffies(kSampleRate, 16, kChannels) == kBufferMs * Jiffies::kPerMs);
+    iReader.Header().iConsumerLatencyUs.store(5000);
+    TEST(iPipelineAnimator->PipelineAnimatorDelayJiffies(kSampleRate, 16, kChannels) == (kBufferMs + 5) * Jiffies::kPerMs);
+    TEST(iPipelineAnimator->PipelineAnimatorDelayJiffies(192000, 32, 8) == (kBufferMs + 5) * Jiffies::kPerMs);
+}
+
+void SuiteAnimatorShm::UnsupportedFormatsRejected()
+{
+    TEST_THROWS(iPipelineAnimator->PipelineAnimatorDelayJiffies(384000, 16, 2), SampleRateUnsupported);
+    TEST_THROWS(iPipelineAnimator->PipelineAnimatorDelayJiffies(kSampleRate, 16, 9), SampleRateUnsupported);
+    TEST_THROWS(iPipelineAnimator->PipelineAnimatorDelayJiffies(kSampleRate, 20, 2), SampleRateUnsupported);
+}
+
+void SuiteAnimatorShm::PullPublished()
+{
+    IPullableClock& clock = *iAnimator;
+    ShmPcmRingHeader& header = iReader.Header();
+    const TUint pull = IPullableClock::kNominalFreq + (IPullableClock::kNominalFreq / 10000);
+    clock.PullClock(pull);
+    TEST(header.iPullMultiplier.load() == pull);
+    clock.PullClock(IPullableClock::kNominalFreq * 2);
+    TEST(header.iPullMultiplier.load() == IPullableClock::kNominalFreq + clock.MaxPull());
+    clock.PullClock(0);
+    TEST(header.iPullMultiplier.load() == IPullableClock::kNominalFreq - clock.MaxPull());
+}
+
+void SuiteAnimatorShm::DrainWaitsForConsumer()
+{
+    PushStream(16);
+    PushAudio(16, 2);
+    PushDrain();
+    TEST_THROWS(iSemDrained.Wait(50), Timeout);
+    StartConsumer(false);
+    iSemDrained.Wait(1000);
+    TEST(iReader.AvailableBytes() == 0);
+}
+
+void SuiteAnimatorShm::Latency()
+{
+    // consumer reads at the sample rate; time from an impulse being pulled from the pipeline
+    // to it being read should match the delay the animator reports
+    StartConsumer(true);
+    PushStream(16);
+    PushAudio(16, 20, eSilence); // 100ms
+    Thread::Sleep(100);
+    const TUint64 sentUs = ShmPcmRingNowUs();
+    PushAudio(16, 1, eImpulse);
+    TUint64 readUs = 0;
+    for (TUint i=0; i<1000 && readUs == 0; i++) {
+        Thread::Sleep(1);
+        iLock.Wait();
+        readUs = iImpulseReadUs;
+        iLock.Signal();
+    }
+    const TUint64 latencyUs = readUs - sentUs;
+    const TUint delayUs = Jiffies::ToMs(iPipelineAnimator->PipelineAnimatorDelayJiffies(kSampleRate, 16, kChannels)) * 1000;
+    Print("AnimatorShm latency: %uus (reported %uus)\n", (TUint)latencyUs, delayUs);
+    TEST(readUs != 0);
+    TEST(latencyUs + 10000 >= delayUs);
+    TEST(latencyUs <= delayUs + 10000);
+}
+
+void SuiteAnimatorShm::StalledConsumerDiscards()
+{
+    iReader.Close(); // no consumer
+    PushStream(16);
+    PushAudio(16, 40); // 200ms
+    PushDrain();
+    // ring fills, consumer times out, rest of the audio is discarded in (roughly) real time
+    iSemDrained.Wait(2000);
+    TEST(iQueue.IsEmpty());
+}
+
+Msg* SuiteAnimatorShm::Pull()
+{
+    return iQueue.Dequeue();
+}
+
+void SuiteAnimatorShm::SetAnimator(IPipelineAnimator& aAnimator)
+{
+    iPipelineAnimator = &aAnimator;
+}
+
+
+
+void TestAnimatorShm(Environment& aEnv)
+{
+    Runner runner("AnimatorShm tests\n");
+    runner.Add(new SuiteAnimatorShm(aEnv));
+    runner.Run();
+}
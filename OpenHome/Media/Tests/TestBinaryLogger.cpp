@@ -0,0 +1,206 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Functor.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+namespace TestBinaryLogger {
+
+class SuiteBinaryLogger : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kEntriesPerThread = 8;
+public:
+    SuiteBinaryLogger(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    const Brx& Read();
+    TBool Contains(const TChar* aText);
+    TUint Count(const TChar* aText);
+    void LogFromThread();
+    void TestDisabledRecordsNothing();
+    void TestIntegers();
+    void TestStrings();
+    void TestStringsTruncated();
+    void TestDouble();
+    void TestPercent();
+    void TestOldestDiscarded();
+    void TestThreadsMerged();
+private:
+    Environment& iEnv;
+    BinaryLogger* iLogger;
+    Bwh iBuf;
+};
+
+} // namespace TestBinaryLogger
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestBinaryLogger;
+
+
+// SuiteBinaryLogger
+
+SuiteBinaryLogger::SuiteBinaryLogger(Environment& aEnv)
+    : SuiteUnitTest("BinaryLogger")
+    , iEnv(aEnv)
+    , iBuf(16 * 1024)
+{
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestDisabledRecordsNothing), "TestDisabledRecordsNothing");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestIntegers), "TestIntegers");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestStrings), "TestStrings");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestStringsTruncated), "TestStringsTruncated");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestDouble), "TestDouble");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestPercent), "TestPercent");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestOldestDiscarded), "TestOldestDiscarded");
+    AddTest(MakeFunctor(*this, &SuiteBinaryLogger::TestThreadsMerged), "TestThreadsMerged");
+}
+
+void SuiteBinaryLogger::Setup()
+{
+    iLogger = new BinaryLogger(iEnv, kEntriesPerThread);
+    iLogger->SetEnabled(true);
+}
+
+void SuiteBinaryLogger::TearDown()
+{
+    delete iLogger;
+}
+
+const Brx& SuiteBinaryLogger::Read()
+{
+    iBuf.SetBytes(0);
+    WriterBuffer writer(iBuf);
+    iLogger->Read(writer);
+    return iBuf;
+}
+
+TBool SuiteBinaryLogger::Contains(const TChar* aText)
+{
+    return Count(aText) > 0;
+}
+
+TUint SuiteBinaryLogger::Count(const TChar* aText)
+{
+    const Brn text(aText);
+    TUint count = 0;
+    for (TUint i=0; i+text.Bytes()<=iBuf.Bytes(); i++) {
+        if (iBuf.Split(i, text.Bytes()) == text) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void SuiteBinaryLogger::LogFromThread()
+{
+    TEST(BinaryLogger::TryRecord("from thread %u\n", 2u));
+}
+
+void SuiteBinaryLogger::TestDisabledRecordsNothing()
+{
+    iLogger->SetEnabled(false);
+    TEST(!BinaryLogger::TryRecord("disabled %u\n", 1u));
+    (void)Read();
+    TEST(iBuf.Bytes() == 0);
+}
+
+void SuiteBinaryLogger::TestIntegers()
+{
+    const TUint64 big = 0x123456789ULL;
+    TEST(BinaryLogger::TryRecord("u=%u d=%d x=%08x big=%llu w=%4u|\n", 42u, -7, 0xabcu, big, 3u));
+    (void)Read();
+    TEST(Contains("u=42 d=-7 x=00000abc big=4886718345 w=   3|\n"));
+}
+
+void SuiteBinaryLogger::TestStrings()
+{
+    const Brn buf("buffer");
+    TEST(BinaryLogger::TryRecord("literal=%s buf=%.*s after=%u\n", "text", PBUF(buf), 1u));
+    (void)Read();
+    TEST(Contains("literal=text buf=buffer after=1\n"));
+}
+
+void SuiteBinaryLogger::TestStringsTruncated()
+{
+    Bws<BinaryLogger::kMaxStringBytes * 2> buf;
+    while (buf.Bytes() < buf.MaxBytes()) {
+        buf.Append('a');
+    }
+    TEST(BinaryLogger::TryRecord("[%.*s]\n", PBUF(buf)));
+    (void)Read();
+    Bws<BinaryLogger::kMaxStringBytes + 4> expected("[");
+    for (TUint i=0; i<BinaryLogger::kMaxStringBytes; i++) {
+        expected.Append('a');
+    }
+    expected.Append("]\n");
+    TEST(Contains((const TChar*)expected.PtrZ()));
+}
+
+void SuiteBinaryLogger::TestDouble()
+{
+    TEST(BinaryLogger::TryRecord("ratio=%.3f\n", 0.125));
+    (void)Read();
+    TEST(Contains("ratio=0.125\n"));
+}
+
+void SuiteBinaryLogger::TestPercent()
+{
+    TEST(BinaryLogger::TryRecord("100%% of %u\n", 5u));
+    (void)Read();
+    TEST(Contains("100% of 5\n"));
+}
+
+void SuiteBinaryLogger::TestOldestDiscarded()
+{
+    for (TUint i=0; i<kEntriesPerThread * 2; i++) {
+        TEST(BinaryLogger::TryRecord("entry %u\n", i));
+    }
+    (void)Read();
+    TEST(Count("entry ") == kEntriesPerThread);
+    TEST(!Contains("entry 0\n"));
+    TEST(Contains("entry 8\n"));
+    TEST(Contains("entry 15\n"));
+}
+
+void SuiteBinaryLogger::TestThreadsMerged()
+{
+    TEST(BinaryLogger::TryRecord("from main %u\n", 1u));
+    Thread::Sleep(2); // ensure distinct timestamps
+    ThreadFunctor* th = new ThreadFunctor("BLOG", MakeFunctor(*this, &SuiteBinaryLogger::LogFromThread));
+    th->Start();
+    delete th;
+    (void)Read();
+    TEST(Contains("from main 1\n"));
+    TEST(Contains("from thread 2\n"));
+    const Brn text("from main");
+    TUint mainPos = 0;
+    TUint threadPos = 0;
+    for (TUint i=0; i+text.Bytes()<=iBuf.Bytes(); i++) {
+        if (iBuf.Split(i, text.Bytes()) == text) {
+            mainPos = i;
+        }
+        else if (iBuf.Split(i, 11) == Brn("from thread")) {
+            threadPos = i;
+        }
+    }
+    TEST(mainPos < threadPos); // oldest first
+}
+
+
+
+void TestBinaryLogger(Environment& aEnv)
+{
+    Runner runner("BinaryLogger tests\n");
+    runner.Add(new SuiteBinaryLogger(aEnv));
+    runner.Run();
+}
@@ -0,0 +1,11 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Net/Private/Globals.h>
+
+extern void TestBinaryLogger(OpenHome::Environment& aEnv);
+
+void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], Net::InitialisationParams* aInitParams)
+{
+    Net::Library* lib = new Net::Library(aInitParams);
+    TestBinaryLogger(lib->Env());
+    delete lib;
+}
@@ -0,0 +1,136 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Utils/BinaryLogger.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/FunctorMsg.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Times a representative pipeline log message sent via Log::Print (into a RingBufferLogger,
+    as used by the Debug service) and via BinaryLogger::TryRecord.  The cost of formatting
+    the binary log afterwards is reported separately.
+*/
+
+namespace OpenHome {
+namespace TestBinaryLoggerPerf {
+
+class Bench : private INonCopyable
+{
+public:
+    Bench(Environment& aEnv, TUint aIterations);
+    void Run();
+private:
+    void LogDiscard(const TChar* aMsg);
+    TUint TimePrint();
+    TUint TimeBinary();
+    TUint TimeRead();
+private:
+    Environment& iEnv;
+    const TUint iIterations;
+    BinaryLogger iBinaryLogger;
+    Bwh iReadBuf;
+};
+
+} // namespace TestBinaryLoggerPerf
+} // namespace OpenHome
+
+using namespace OpenHome::TestBinaryLoggerPerf;
+
+static const TChar* kStatus = "RAMPING_DOWN";
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, TUint aIterations)
+    : iEnv(aEnv)
+    , iIterations(aIterations)
+    , iBinaryLogger(aEnv)
+    , iReadBuf(BinaryLogger::kDefaultEntriesPerThread * 256)
+{
+}
+
+void Bench::Run()
+{
+    Log::Print("Log benchmark (%u iterations)\n", iIterations);
+    FunctorMsg discard = MakeFunctorMsg(*this, &Bench::LogDiscard);
+    FunctorMsg downstream = Log::SwapOutput(discard);
+    TUint printNs;
+    {
+        RingBufferLogger ringBuffer(64 * 1024);
+        printNs = TimePrint();
+    }
+    iBinaryLogger.SetEnabled(true);
+    const TUint binaryNs = TimeBinary();
+    iBinaryLogger.SetEnabled(false);
+    const TUint readUs = TimeRead();
+    (void)Log::SwapOutput(downstream);
+
+    Log::Print("%-24s %12s\n", "method", "ns/call");
+    Log::Print("%-24s %12u\n", "Log::Print", printNs);
+    Log::Print("%-24s %12u\n", "BinaryLogger", binaryNs);
+    Log::Print("formatting %u binary entries took %uus\n", BinaryLogger::kDefaultEntriesPerThread, readUs);
+}
+
+void Bench::LogDiscard(const TChar* /*aMsg*/)
+{
+}
+
+TUint Bench::TimePrint()
+{
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iIterations; i++) {
+        Log::Print("VariableDelayLeft::ProcessMsg(MsgDelay(%u): delay=%u(%u), prev=%u(%u), iStatus=%s\n",
+                   i, i, i/56448, i, i/56448, kStatus);
+    }
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+    return (TUint)((us * 1000) / iIterations);
+}
+
+TUint Bench::TimeBinary()
+{
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iIterations; i++) {
+        (void)BinaryLogger::TryRecord("VariableDelayLeft::ProcessMsg(MsgDelay(%u): delay=%u(%u), prev=%u(%u), iStatus=%s\n",
+                                      i, i, i/56448, i, i/56448, kStatus);
+    }
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+    return (TUint)((us * 1000) / iIterations);
+}
+
+TUint Bench::TimeRead()
+{
+    iReadBuf.SetBytes(0);
+    WriterBuffer writer(iReadBuf);
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    iBinaryLogger.Read(writer);
+    return (TUint)(OsTimeInUs(iEnv.OsCtx()) - start);
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionIterations("-i", "--iterations", 100000, "number of messages logged by each method");
+    parser.AddOption(&optionIterations);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionIterations.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
@@ -0,0 +1,390 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Utils/ClockPullerOccupancy.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+
+#include <algorithm>
+#include <climits>
+#include <deque>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SimPullableClock : public IPullableClock
+{
+public:
+    SimPullableClock(TUint aMaxPullPpm);
+    TUint Multiplier() const;
+    TUint PullCount() const;
+    TInt MaxStepPpb() const;
+public: // from IPullableClock
+    void PullClock(TUint aMultiplier) override;
+    TUint MaxPull() const override;
+private:
+    const TUint iMaxPull;
+    TUint iMultiplier;
+    TUint iPullCount;
+    TInt iMaxStepPpb;
+};
+
+/*
+    Simulates a remote sender feeding a local pipeline buffer that ClockPullerOccupancy observes.
+
+    The sender's clock runs at (1 + aDriftPpm) of nominal.  It sends 5ms packets which arrive after
+    a random delay in [0..aJitterMs); every aOutlierEveryMs a packet is delayed by an additional
+    aOutlierMs.  The local animator plays audio every 5ms at the rate set via SimPullableClock.
+*/
+class ClockSimulator : private INonCopyable
+{
+    static const TUint kPacketMs = 5;
+    static const TUint kAnimatorMs = 5;
+    static const TUint kStartLatencyMs = 100;
+public:
+    ClockSimulator(TInt aDriftPpm, TUint aJitterMs, TUint aOutlierEveryMs, TUint aOutlierMs, TUint aMaxPullPpm);
+    ~ClockSimulator();
+    void Run(TUint aDurationMs);
+    TInt PullPpb() const;
+    TInt64 TargetJiffies() const;
+    TInt64 MinJiffies() const;
+    TInt64 MaxJiffies() const;
+    TInt MinPullPpb() const;
+    TInt MaxPullPpb() const;
+    TUint PullCount() const;
+    TInt MaxStepPpb() const;
+    void ResetStats();
+    void Stop();
+    TUint Multiplier() const;
+private:
+    TUint NextRandom(TUint aMax);
+private:
+    const TInt iDriftPpm;
+    const TUint iJitterMs;
+    const TUint iOutlierEveryMs;
+    const TUint iOutlierMs;
+    SimPullableClock iClock;
+    ClockPullerOccupancy* iPuller;
+    std::deque<std::pair<TUint64, TUint>> iInFlight; // (arrival time, jiffies)
+    TUint64 iNowMs;
+    TInt64 iSentMicroJiffies;   // produced by sender, not yet packetised
+    TInt64 iPlayedPartsJiffies; // fractional jiffies owed to player, scaled by kNominalFreq
+    TBool iStarted;
+    TInt64 iTarget;
+    TInt64 iMin;
+    TInt64 iMax;
+    TInt iMinPull;
+    TInt iMaxPull;
+    TUint iRandom;
+};
+
+class SuiteClockPullerOccupancy : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kSettleMs = 200 * 1000;
+    static const TUint kMeasureMs = 300 * 1000;
+    static const TInt kPpbPerPpm = 1000;
+    static const TInt kMaxWanderPpb = 35 * kPpbPerPpm; // 20ms of network jitter moves the measured occupancy by a few hundred us
+public:
+    SuiteClockPullerOccupancy();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestNoDriftNoPull();
+    void TestPositiveDrift();
+    void TestNegativeDrift();
+    void TestOutliersRejected();
+    void TestPullLimitedByClock();
+    void TestStopRestoresNominal();
+    void CheckTracksDrift(TInt aDriftPpm);
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SimPullableClock
+
+SimPullableClock::SimPullableClock(TUint aMaxPullPpm)
+    : iMaxPull((TUint)(((TUint64)kNominalFreq * aMaxPullPpm) / 1000000))
+    , iMultiplier(kNominalFreq)
+    , iPullCount(0)
+    , iMaxStepPpb(0)
+{
+}
+
+TUint SimPullableClock::Multiplier() const
+{
+    return iMultiplier;
+}
+
+TUint SimPullableClock::PullCount() const
+{
+    return iPullCount;
+}
+
+TInt SimPullableClock::MaxStepPpb() const
+{
+    return iMaxStepPpb;
+}
+
+void SimPullableClock::PullClock(TUint aMultiplier)
+{
+    const TInt64 step = (((TInt64)aMultiplier - (TInt64)iMultiplier) * 1000000000LL) / kNominalFreq;
+    const TInt stepAbs = (TInt)(step < 0? -step : step);
+    iMaxStepPpb = std::max(iMaxStepPpb, stepAbs);
+    iMultiplier = aMultiplier;
+    iPullCount++;
+}
+
+TUint SimPullableClock::MaxPull() const
+{
+    return iMaxPull;
+}
+
+
+// ClockSimulator
+
+ClockSimulator::ClockSimulator(TInt aDriftPpm, TUint aJitterMs, TUint aOutlierEveryMs, TUint aOutlierMs, TUint aMaxPullPpm)
+    : iDriftPpm(aDriftPpm)
+    , iJitterMs(aJitterMs)
+    , iOutlierEveryMs(aOutlierEveryMs)
+    , iOutlierMs(aOutlierMs)
+    , iClock(aMaxPullPpm)
+    , iNowMs(0)
+    , iSentMicroJiffies(0)
+    , iPlayedPartsJiffies(0)
+    , iStarted(false)
+    , iTarget(0)
+    , iRandom(0x12345678)
+{
+    iPuller = new ClockPullerOccupancy(iClock);
+    ResetStats();
+}
+
+ClockSimulator::~ClockSimulator()
+{
+    delete iPuller;
+}
+
+void ClockSimulator::Run(TUint aDurationMs)
+{
+    static const TInt64 kNominal = IPullableClock::kNominalFreq;
+    const TUint64 end = iNowMs + aDurationMs;
+    for (; iNowMs < end; iNowMs++) {
+        // sender
+        iSentMicroJiffies += (TInt64)Jiffies::kPerMs * (1000000 + iDriftPpm);
+        const TInt64 packetMicroJiffies = (TInt64)kPacketMs * Jiffies::kPerMs * 1000000;
+        while (iSentMicroJiffies >= packetMicroJiffies) {
+            iSentMicroJiffies -= packetMicroJiffies;
+            TUint64 arrival = iNowMs + (iJitterMs == 0? 0 : NextRandom(iJitterMs));
+            if (iOutlierEveryMs != 0 && (iNowMs % iOutlierEveryMs) < kPacketMs) {
+                arrival += iOutlierMs;
+            }
+            iInFlight.push_back(std::pair<TUint64, TUint>(arrival, kPacketMs * Jiffies::kPerMs));
+        }
+
+        // network
+        for (auto it = iInFlight.begin(); it != iInFlight.end(); ) {
+            if (it->first <= iNowMs) {
+                iPuller->Update((TInt)it->second);
+                it = iInFlight.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        // local animator
+        if (!iStarted) {
+            if (iNowMs >= kStartLatencyMs) {
+                iStarted = true;
+                iTarget = iPuller->OccupancyJiffies();
+                iPuller->Start();
+            }
+            continue;
+        }
+        if (iNowMs % kAnimatorMs == 0) {
+            iPlayedPartsJiffies += (TInt64)kAnimatorMs * Jiffies::kPerMs * iClock.Multiplier();
+            const TInt jiffies = (TInt)(iPlayedPartsJiffies / kNominal);
+            iPlayedPartsJiffies -= jiffies * kNominal;
+            iPuller->Update(-jiffies);
+        }
+        const TInt64 occupancy = iPuller->OccupancyJiffies();
+        iMin = std::min(iMin, occupancy);
+        iMax = std::max(iMax, occupancy);
+        const TInt pull = iPuller->PullPpb();
+        iMinPull = std::min(iMinPull, pull);
+        iMaxPull = std::max(iMaxPull, pull);
+    }
+}
+
+TInt ClockSimulator::PullPpb() const
+{
+    return iPuller->PullPpb();
+}
+
+TInt64 ClockSimulator::TargetJiffies() const
+{
+    return iTarget;
+}
+
+TInt64 ClockSimulator::MinJiffies() const
+{
+    return iMin;
+}
+
+TInt64 ClockSimulator::MaxJiffies() const
+{
+    return iMax;
+}
+
+TInt ClockSimulator::MinPullPpb() const
+{
+    return iMinPull;
+}
+
+TInt ClockSimulator::MaxPullPpb() const
+{
+    return iMaxPull;
+}
+
+TUint ClockSimulator::PullCount() const
+{
+    return iClock.PullCount();
+}
+
+TInt ClockSimulator::MaxStepPpb() const
+{
+    return iClock.MaxStepPpb();
+}
+
+void ClockSimulator::ResetStats()
+{
+    iMin = LLONG_MAX;
+    iMax = LLONG_MIN;
+    iMinPull = INT_MAX;
+    iMaxPull = INT_MIN;
+}
+
+void ClockSimulator::Stop()
+{
+    iPuller->Stop();
+}
+
+TUint ClockSimulator::Multiplier() const
+{
+    return iClock.Multiplier();
+}
+
+TUint ClockSimulator::NextRandom(TUint aMax)
+{ // deterministic LCG so that failures are reproducible
+    iRandom = iRandom * 1103515245 + 12345;
+    return (iRandom >> 8) % aMax;
+}
+
+
+// SuiteClockPullerOccupancy
+
+SuiteClockPullerOccupancy::SuiteClockPullerOccupancy()
+    : SuiteUnitTest("ClockPullerOccupancy")
+{
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestNoDriftNoPull), "TestNoDriftNoPull");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestPositiveDrift), "TestPositiveDrift");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestNegativeDrift), "TestNegativeDrift");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestOutliersRejected), "TestOutliersRejected");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestPullLimitedByClock), "TestPullLimitedByClock");
+    AddTest(MakeFunctor(*this, &SuiteClockPullerOccupancy::TestStopRestoresNominal), "TestStopRestoresNominal");
+}
+
+void SuiteClockPullerOccupancy::Setup()
+{
+}
+
+void SuiteClockPullerOccupancy::TearDown()
+{
+}
+
+void SuiteClockPullerOccupancy::TestNoDriftNoPull()
+{
+    ClockSimulator sim(0, 0, 0, 0, 1000);
+    sim.Run(kSettleMs);
+    TEST(sim.PullCount() == 0);
+    TEST(sim.PullPpb() == 0);
+}
+
+void SuiteClockPullerOccupancy::CheckTracksDrift(TInt aDriftPpm)
+{
+    ClockSimulator sim(aDriftPpm, 20, 0, 0, 1000);
+    sim.Run(kSettleMs);
+    sim.ResetStats();
+    sim.Run(kMeasureMs);
+
+    // buffer is held close to its starting level
+    const TInt64 kMaxErrorJiffies = 20 * Jiffies::kPerMs; // includes up to 20ms of network jitter
+    TEST(sim.MinJiffies() > sim.TargetJiffies() - kMaxErrorJiffies);
+    TEST(sim.MaxJiffies() < sim.TargetJiffies() + kMaxErrorJiffies);
+
+    // local clock tracks the sender without wandering
+    const TInt drift = aDriftPpm * kPpbPerPpm;
+    TEST(sim.MinPullPpb() > drift - kMaxWanderPpb);
+    TEST(sim.MaxPullPpb() < drift + kMaxWanderPpb);
+    TEST(sim.MaxStepPpb() <= ClockPullerOccupancy::kMaxSlewPpb);
+
+    Print("drift %dppm: occupancy [%d..%d]us, pull [%d..%d]ppb\n", aDriftPpm,
+          (TInt)(((sim.MinJiffies() - sim.TargetJiffies()) * 1000) / Jiffies::kPerMs),
+          (TInt)(((sim.MaxJiffies() - sim.TargetJiffies()) * 1000) / Jiffies::kPerMs),
+          sim.MinPullPpb(), sim.MaxPullPpb());
+}
+
+void SuiteClockPullerOccupancy::TestPositiveDrift()
+{
+    CheckTracksDrift(200);
+}
+
+void SuiteClockPullerOccupancy::TestNegativeDrift()
+{
+    CheckTracksDrift(-200);
+}
+
+void SuiteClockPullerOccupancy::TestOutliersRejected()
+{
+    // a burst of packets delayed by 100ms every 10s shouldn't disturb the pull any more than normal jitter
+    ClockSimulator sim(0, 20, 10 * 1000, 100, 1000);
+    sim.Run(kSettleMs);
+    sim.ResetStats();
+    sim.Run(kMeasureMs);
+    TEST(sim.MinPullPpb() > -kMaxWanderPpb);
+    TEST(sim.MaxPullPpb() < kMaxWanderPpb);
+    Print("outliers: pull [%d..%d]ppb\n", sim.MinPullPpb(), sim.MaxPullPpb());
+}
+
+void SuiteClockPullerOccupancy::TestPullLimitedByClock()
+{
+    ClockSimulator sim(200, 0, 0, 0, 100);
+    sim.Run(kSettleMs);
+    TEST(sim.MaxPullPpb() <= 100 * kPpbPerPpm);
+    TEST(sim.PullPpb() >= 99 * kPpbPerPpm);
+}
+
+void SuiteClockPullerOccupancy::TestStopRestoresNominal()
+{
+    ClockSimulator sim(200, 0, 0, 0, 1000);
+    sim.Run(kSettleMs);
+    TEST(sim.Multiplier() > IPullableClock::kNominalFreq);
+    sim.Stop();
+    TEST(sim.Multiplier() == IPullableClock::kNominalFreq);
+    TEST(sim.PullPpb() == 0);
+}
+
+
+
+void TestClockPuller()
+{
+    Runner runner("Clock puller tests\n");
+    runner.Add(new SuiteClockPullerOccupancy());
+    runner.Run();
+}
@@ -0,0 +1,747 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Codec/CodecController.h>
+#include <OpenHome/Media/Codec/CodecFactory.h>
+#include <OpenHome/Media/Codec/Container.h>
+#include <OpenHome/Media/Codec/ContainerFactory.h>
+#include <OpenHome/Media/Protocol/FileSource.h>
+#include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Tests/TestCodec.h>
+#include <OpenHome/Media/Tests/PerfUtils.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <ctime>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+using namespace OpenHome::Media::Codec;
+
+extern AudioFileCollection* TestCodecFiles();
+
+/*
+    Measures the cost of each codec, independent of protocols and the rest of the pipeline.
+    Each file is read into memory then fed (in EncodedAudio sized msgs) through a
+    ContainerController and CodecController with all containers/codecs registered, the
+    decoded output being discarded as soon as it leaves CodecController.
+    Files are those used by TestCodec (plus any --extra files, e.g. mp3 which TestCodec
+    doesn't include by default) and raw pcm streams synthesised by the benchmark.
+    For each stream, reports as JSON:
+    - time taken to recognise the stream (from MsgEncodedStream to MsgDecodedStream)
+    - decode throughput (encoded MB per second) and realtime factor (audio seconds per
+      second), from the fastest of --passes decodes
+    - CPU time for the fastest decode (CPU for the whole process)
+    - peak usage of each allocator
+    - for seekable streams, the latency of seeks to 10%, 50% and 90% of the stream.  Each
+      seek is requested (via ISeeker, so exercises the codec's TrySeek) once a quarter of
+      the stream has been delivered; latency is measured to the first audio output after
+      the seek completes.
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestCodecPerf {
+
+class MemorySource : public IPipelineElementUpstream, public IStreamHandler, public IUrlBlockWriter, private INonCopyable
+{
+public:
+    static const TUint kStreamId = 1;
+public:
+    MemorySource(Environment& aEnv, MsgFactory& aMsgFactory, TrackFactory& aTrackFactory,
+                 const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable, TBool aGate);
+    TUint64 StreamStartTime() const;
+    void WaitForGate();
+    void ReleaseGate();
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+public: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+public: // from IUrlBlockWriter
+    TBool TryGet(IWriter& aWriter, const Brx& aUrl, TUint64 aOffset, TUint aBytes) override;
+private:
+    enum EState
+    {
+        eTrack
+       ,eStream
+       ,eAudio
+       ,eQuit
+    };
+private:
+    Environment& iEnv;
+    MsgFactory& iMsgFactory;
+    TrackFactory& iTrackFactory;
+    const Brx& iName;
+    const Brx& iData;
+    const PcmStreamInfo* iPcmStream;
+    const TBool iSeekable;
+    EState iState;
+    TUint64 iPos;
+    TUint64 iGateOffset;
+    TUint iPendingFlushId;
+    TUint iNextFlushId;
+    TUint64 iStreamStartTime;
+    Semaphore iSemGateReached;
+    Semaphore iSemGateRelease;
+};
+
+class Sink : public PipelineElement, public IPipelineElementDownstream, public ISeekObserver, private INonCopyable
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    Sink(Environment& aEnv);
+    void WaitForQuit();
+    void NotifySeekFailed();
+    TBool Recognised() const;
+    TUint64 DecodedStreamTime() const;
+    TUint64 QuitTime() const;
+    TUint64 Jiffies() const;
+    TBool SeekCompleted() const;
+    TUint64 SeekAudioTime() const;
+    void GetStreamInfo(Bwx& aCodec, TUint& aSampleRate, TUint& aBitDepth, TUint& aChannels, TBool& aSeekable) const;
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+public: // from ISeekObserver
+    void NotifySeekComplete(TUint aHandle, TUint aFlushId) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    Environment& iEnv;
+    Semaphore iSemQuit;
+    TBool iRecognised;
+    TUint64 iDecodedStreamTime;
+    TUint64 iQuitTime;
+    TUint64 iJiffies;
+    Bws<32> iCodec;
+    TUint iSampleRate;
+    TUint iBitDepth;
+    TUint iChannels;
+    TBool iSeekable;
+    TBool iSeekPending;
+    TBool iSeekSucceeded;
+    TUint64 iSeekAudioTime;
+};
+
+class Bench : private IMimeTypeList, private INonCopyable
+{
+    static const TChar* kIndent;
+    static const TUint kPcmSeconds = 10;
+    static const TUint kMsgAudioEncodedCount = 100;
+    static const TUint kMsgAudioPcmCount = 100;
+    static const TUint kMaxOutputJiffies = Jiffies::kPerMs * 5;
+    static const TUint kNoSeek = UINT_MAX;
+    static const TUint kSeekPercents[];
+    static const TUint kNumSeekPercents = 3;
+public:
+    Bench(Environment& aEnv, const Brx& aDir, TUint aPasses);
+    void Run(TBool aExtraFiles, const Brx& aExtra);
+private:
+    class Result
+    {
+    public:
+        Result();
+    public:
+        TBool iRecognised;
+        TUint64 iDecodeUs;
+        TUint64 iCpuUs;
+        TUint64 iRecognitionUs;
+        TUint64 iJiffies;
+        Bws<32> iCodec;
+        TUint iSampleRate;
+        TUint iBitDepth;
+        TUint iChannels;
+        TBool iSeekable;
+        TBool iSeekCompleted;
+        TUint64 iSeekLatencyUs;
+    };
+private:
+    void RunFile(const Brx& aFilename, TBool aSeekable);
+    void RunPcm(TUint aSampleRate, TUint aBitDepth, TUint aChannels);
+    void RunStream(const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable);
+    void DecodeOnce(const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable,
+                    TUint aSeekSeconds, AllocatorStats& aAllocatorStats, Result& aResult);
+    TBool LoadFile(const Brx& aFilename, Bwh& aData);
+    void BeginRun(const Brx& aName);
+private: // from IMimeTypeList
+    void Add(const TChar* aMimeType) override;
+private:
+    Environment& iEnv;
+    const Brx& iDir;
+    const TUint iPasses;
+    TBool iFirstRun;
+};
+
+} // namespace TestCodecPerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestCodecPerf;
+
+
+// MemorySource
+
+MemorySource::MemorySource(Environment& aEnv, MsgFactory& aMsgFactory, TrackFactory& aTrackFactory,
+                           const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable, TBool aGate)
+    : iEnv(aEnv)
+    , iMsgFactory(aMsgFactory)
+    , iTrackFactory(aTrackFactory)
+    , iName(aName)
+    , iData(aData)
+    , iPcmStream(aPcmStream)
+    , iSeekable(aSeekable)
+    , iState(eTrack)
+    , iPos(0)
+    , iGateOffset(aGate? aData.Bytes() / 4 : UINT64_MAX)
+    , iPendingFlushId(MsgFlush::kIdInvalid)
+    , iNextFlushId(MsgFlush::kIdInvalid + 1)
+    , iStreamStartTime(0)
+    , iSemGateReached("MSG1", 0)
+    , iSemGateRelease("MSG2", 0)
+{
+}
+
+TUint64 MemorySource::StreamStartTime() const
+{
+    return iStreamStartTime;
+}
+
+void MemorySource::WaitForGate()
+{
+    iSemGateReached.Wait();
+}
+
+void MemorySource::ReleaseGate()
+{
+    iSemGateRelease.Signal();
+}
+
+Msg* MemorySource::Pull()
+{
+    switch (iState)
+    {
+    case eTrack:
+    {
+        iState = eStream;
+        Track* track = iTrackFactory.CreateTrack(iName, Brx::Empty());
+        Msg* msg = iMsgFactory.CreateMsgTrack(*track);
+        track->RemoveRef();
+        return msg;
+    }
+    case eStream:
+        iState = eAudio;
+        iStreamStartTime = OsTimeInUs(iEnv.OsCtx());
+        if (iPcmStream != nullptr) {
+            return iMsgFactory.CreateMsgEncodedStream(iName, Brx::Empty(), iData.Bytes(), 0, kStreamId, iSeekable,
+                                                      false, Multiroom::Allowed, this, *iPcmStream);
+        }
+        return iMsgFactory.CreateMsgEncodedStream(iName, Brx::Empty(), iData.Bytes(), 0, kStreamId, iSeekable,
+                                                  false, Multiroom::Allowed, this);
+    case eAudio:
+        break;
+    case eQuit:
+        return iMsgFactory.CreateMsgQuit();
+    }
+
+    if (iPendingFlushId != MsgFlush::kIdInvalid) {
+        const TUint flushId = iPendingFlushId;
+        iPendingFlushId = MsgFlush::kIdInvalid;
+        return iMsgFactory.CreateMsgFlush(flushId);
+    }
+    if (iPos >= iGateOffset) {
+        iGateOffset = UINT64_MAX;
+        iSemGateReached.Signal();
+        iSemGateRelease.Wait();
+    }
+    if (iPos >= iData.Bytes()) {
+        iState = eQuit;
+        return iMsgFactory.CreateMsgQuit();
+    }
+    TUint bytes = EncodedAudio::kMaxBytes;
+    if (iPos + bytes > iData.Bytes()) {
+        bytes = (TUint)(iData.Bytes() - iPos);
+    }
+    Brn slice(iData.Ptr() + iPos, bytes);
+    iPos += bytes;
+    return iMsgFactory.CreateMsgAudioEncoded(slice);
+}
+
+EStreamPlay MemorySource::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint MemorySource::TrySeek(TUint aStreamId, TUint64 aOffset)
+{
+    // called from CodecController's thread, which is also the only caller of Pull()
+    if (aStreamId != kStreamId || !iSeekable || aOffset >= iData.Bytes()) {
+        return MsgFlush::kIdInvalid;
+    }
+    iPos = aOffset;
+    iPendingFlushId = iNextFlushId++;
+    return iPendingFlushId;
+}
+
+TUint MemorySource::TryDiscard(TUint /*aJiffies*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+TUint MemorySource::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void MemorySource::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+TBool MemorySource::TryGet(IWriter& aWriter, const Brx& /*aUrl*/, TUint64 aOffset, TUint aBytes)
+{
+    if (aOffset >= iData.Bytes()) {
+        return false;
+    }
+    TUint bytes = aBytes;
+    if (aOffset + bytes > iData.Bytes()) {
+        bytes = (TUint)(iData.Bytes() - aOffset);
+    }
+    try {
+        aWriter.Write(Brn(iData.Ptr() + aOffset, bytes));
+        aWriter.WriteFlush();
+    }
+    catch (WriterError&) {
+        return false;
+    }
+    return true;
+}
+
+
+// Sink
+
+const TUint Sink::kSupportedMsgTypes =   eMode
+                                       | eTrack
+                                       | eDrain
+                                       | eDelay
+                                       | eEncodedStream
+                                       | eMetatext
+                                       | eStreamInterrupted
+                                       | eHalt
+                                       | eFlush
+                                       | eWait
+                                       | eDecodedStream
+                                       | eBitRate
+                                       | eAudioPcm
+                                       | eSilence
+                                       | eQuit;
+
+Sink::Sink(Environment& aEnv)
+    : PipelineElement(kSupportedMsgTypes)
+    , iEnv(aEnv)
+    , iSemQuit("SNKQ", 0)
+    , iRecognised(false)
+    , iDecodedStreamTime(0)
+    , iQuitTime(0)
+    , iJiffies(0)
+    , iSampleRate(0)
+    , iBitDepth(0)
+    , iChannels(0)
+    , iSeekable(false)
+    , iSeekPending(false)
+    , iSeekSucceeded(false)
+    , iSeekAudioTime(0)
+{
+}
+
+void Sink::WaitForQuit()
+{
+    iSemQuit.Wait();
+}
+
+void Sink::NotifySeekFailed()
+{
+    iSeekPending = false;
+    iSeekSucceeded = false;
+}
+
+/* The following accessors are only valid after WaitForQuit() returns.  All other
+   members are only written from CodecController's thread before MsgQuit is pushed. */
+
+TBool Sink::Recognised() const
+{
+    return iRecognised;
+}
+
+TUint64 Sink::DecodedStreamTime() const
+{
+    return iDecodedStreamTime;
+}
+
+TUint64 Sink::QuitTime() const
+{
+    return iQuitTime;
+}
+
+TUint64 Sink::Jiffies() const
+{
+    return iJiffies;
+}
+
+TBool Sink::SeekCompleted() const
+{
+    return iSeekSucceeded && iSeekAudioTime != 0;
+}
+
+TUint64 Sink::SeekAudioTime() const
+{
+    return iSeekAudioTime;
+}
+
+void Sink::GetStreamInfo(Bwx& aCodec, TUint& aSampleRate, TUint& aBitDepth, TUint& aChannels, TBool& aSeekable) const
+{
+    aCodec.Replace(iCodec);
+    aSampleRate = iSampleRate;
+    aBitDepth = iBitDepth;
+    aChannels = iChannels;
+    aSeekable = iSeekable;
+}
+
+void Sink::Push(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    msg->RemoveRef();
+}
+
+void Sink::NotifySeekComplete(TUint /*aHandle*/, TUint aFlushId)
+{
+    // called from CodecController's thread, immediately before the first audio from the new position is pushed
+    iSeekPending = (aFlushId != MsgFlush::kIdInvalid);
+    iSeekSucceeded = iSeekPending;
+}
+
+Msg* Sink::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    if (!iRecognised) {
+        iDecodedStreamTime = OsTimeInUs(iEnv.OsCtx());
+        iRecognised = true;
+        const DecodedStreamInfo& info = aMsg->StreamInfo();
+        iCodec.Replace(info.CodecName());
+        iSampleRate = info.SampleRate();
+        iBitDepth = info.BitDepth();
+        iChannels = info.NumChannels();
+        iSeekable = info.Seekable();
+    }
+    return aMsg;
+}
+
+Msg* Sink::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    if (iSeekPending) {
+        iSeekAudioTime = OsTimeInUs(iEnv.OsCtx());
+        iSeekPending = false;
+    }
+    iJiffies += aMsg->Jiffies();
+    return aMsg;
+}
+
+Msg* Sink::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuitTime = OsTimeInUs(iEnv.OsCtx());
+    iSemQuit.Signal();
+    return aMsg;
+}
+
+
+// Bench::Result
+
+Bench::Result::Result()
+    : iRecognised(false)
+    , iDecodeUs(0)
+    , iCpuUs(0)
+    , iRecognitionUs(0)
+    , iJiffies(0)
+    , iSampleRate(0)
+    , iBitDepth(0)
+    , iChannels(0)
+    , iSeekable(false)
+    , iSeekCompleted(false)
+    , iSeekLatencyUs(0)
+{
+}
+
+
+// Bench
+
+const TChar* Bench::kIndent = "      ";
+const TUint Bench::kSeekPercents[] = { 10, 50, 90 };
+
+Bench::Bench(Environment& aEnv, const Brx& aDir, TUint aPasses)
+    : iEnv(aEnv)
+    , iDir(aDir)
+    , iPasses(aPasses)
+    , iFirstRun(true)
+{
+}
+
+void Bench::Run(TBool aExtraFiles, const Brx& aExtra)
+{
+    Log::Print("{\n  \"benchmark\": \"codec\",\n  \"passes\": %u,\n  \"runs\": [", iPasses);
+    AudioFileCollection* files = TestCodecFiles();
+    for (const auto& file : files->RequiredFiles()) {
+        RunFile(file.Filename(), file.Seekable());
+    }
+    if (aExtraFiles) {
+        for (const auto& file : files->ExtraFiles()) {
+            RunFile(file.Filename(), file.Seekable());
+        }
+    }
+    delete files;
+    Parser extra(aExtra);
+    while (!extra.Finished()) {
+        const Brn filename = Ascii::Trim(extra.Next(','));
+        if (filename.Bytes() > 0) {
+            RunFile(filename, true);
+        }
+    }
+    RunPcm(44100, 16, 2);
+    RunPcm(96000, 24, 2);
+    RunPcm(192000, 24, 2);
+    RunPcm(192000, 24, 8);
+    Log::Print("\n  ]\n}\n");
+}
+
+void Bench::RunFile(const Brx& aFilename, TBool aSeekable)
+{
+    Bwh data;
+    if (!LoadFile(aFilename, data)) {
+        BeginRun(aFilename);
+        Log::Print("%s\"available\": false\n    }", kIndent);
+        return;
+    }
+    RunStream(aFilename, data, nullptr, aSeekable);
+}
+
+void Bench::RunPcm(TUint aSampleRate, TUint aBitDepth, TUint aChannels)
+{
+    const TUint bytesPerSample = aBitDepth / 8;
+    const TUint frameBytes = bytesPerSample * aChannels;
+    Bwh data(aSampleRate * kPcmSeconds * frameBytes);
+    // big endian sawtooth, with successive channels offset
+    TByte* p = const_cast<TByte*>(data.Ptr());
+    for (TUint i=0; i<aSampleRate * kPcmSeconds; i++) {
+        for (TUint ch=0; ch<aChannels; ch++) {
+            const TUint sample = (i + (ch * 64)) << (32 - 10);
+            for (TUint b=0; b<bytesPerSample; b++) {
+                *p++ = (TByte)(sample >> (24 - (b * 8)));
+            }
+        }
+    }
+    data.SetBytes(data.MaxBytes());
+    PcmStreamInfo pcmStream;
+    pcmStream.Set(aBitDepth, aSampleRate, aChannels, AudioDataEndian::Big, SpeakerProfile(aChannels));
+    Bws<32> name;
+    name.AppendPrintf("pcm-%u-%u-%uch", aSampleRate, aBitDepth, aChannels);
+    RunStream(name, data, &pcmStream, true);
+}
+
+void Bench::RunStream(const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable)
+{
+    AllocatorStats allocatorStats;
+    Result best;
+    DecodeOnce(aName, aData, aPcmStream, aSeekable, kNoSeek, allocatorStats, best);
+    for (TUint i=1; i<iPasses && best.iRecognised; i++) {
+        AllocatorStats passStats;
+        Result result;
+        DecodeOnce(aName, aData, aPcmStream, aSeekable, kNoSeek, passStats, result);
+        if (result.iDecodeUs < best.iDecodeUs) {
+            best.iDecodeUs = result.iDecodeUs;
+            best.iCpuUs = result.iCpuUs;
+        }
+        if (result.iRecognitionUs < best.iRecognitionUs) {
+            best.iRecognitionUs = result.iRecognitionUs;
+        }
+    }
+
+    BeginRun(aName);
+    Log::Print("%s\"available\": true,\n", kIndent);
+    Log::Print("%s\"recognised\": %s,\n", kIndent, (best.iRecognised? "true" : "false"));
+    Log::Print("%s\"codec\": \"%.*s\",\n", kIndent, PBUF(best.iCodec));
+    Log::Print("%s\"sample_rate\": %u,\n%s\"bit_depth\": %u,\n%s\"channels\": %u,\n",
+               kIndent, best.iSampleRate, kIndent, best.iBitDepth, kIndent, best.iChannels);
+    Log::Print("%s\"encoded_bytes\": %u,\n", kIndent, aData.Bytes());
+    const TUint64 audioMs = best.iJiffies / Jiffies::kPerMs;
+    const TUint64 us = best.iDecodeUs;
+    PerfJson::PrintMilli(kIndent, "audio_seconds", audioMs);
+    PerfJson::PrintMilli(kIndent, "decode_seconds", us / 1000);
+    PerfJson::PrintMilli(kIndent, "cpu_seconds", best.iCpuUs / 1000);
+    PerfJson::PrintMilli(kIndent, "decode_mb_per_second", (us == 0? 0 : ((TUint64)aData.Bytes() * 1000) / us));
+    PerfJson::PrintMilli(kIndent, "realtime_factor", (us == 0? 0 : (audioMs * 1000000) / us));
+    Log::Print("%s\"recognition_us\": %llu,\n", kIndent, best.iRecognitionUs);
+    allocatorStats.PrintJson(kIndent);
+
+    Log::Print("%s\"seeks\": [", kIndent);
+    const TUint seconds = (TUint)(best.iJiffies / Jiffies::kPerSecond);
+    TBool first = true;
+    if (best.iRecognised && aSeekable && best.iSeekable && seconds > 0) {
+        for (TUint i=0; i<kNumSeekPercents; i++) {
+            const TUint seekSeconds = (seconds * kSeekPercents[i]) / 100;
+            AllocatorStats seekStats;
+            Result result;
+            DecodeOnce(aName, aData, aPcmStream, aSeekable, seekSeconds, seekStats, result);
+            Log::Print("%s\n%s  {\"percent\": %u, \"seconds\": %u, \"completed\": %s, \"latency_us\": %llu}",
+                       (first? "" : ","), kIndent, kSeekPercents[i], seekSeconds,
+                       (result.iSeekCompleted? "true" : "false"), result.iSeekLatencyUs);
+            first = false;
+        }
+    }
+    if (first) {
+        Log::Print("]\n    }");
+    }
+    else {
+        Log::Print("\n%s]\n    }", kIndent);
+    }
+}
+
+void Bench::DecodeOnce(const Brx& aName, const Brx& aData, const PcmStreamInfo* aPcmStream, TBool aSeekable,
+                       TUint aSeekSeconds, AllocatorStats& aAllocatorStats, Result& aResult)
+{
+    const TBool seek = (aSeekSeconds != kNoSeek);
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(kMsgAudioEncodedCount, kMsgAudioEncodedCount);
+    init.SetMsgAudioPcmCount(kMsgAudioPcmCount, kMsgAudioPcmCount);
+    init.SetMsgEncodedStreamCount(2);
+    init.SetMsgFlushCount(4);
+    MsgFactory* msgFactory = new MsgFactory(aAllocatorStats, init);
+    TrackFactory* trackFactory = new TrackFactory(aAllocatorStats, 1);
+    MemorySource* source = new MemorySource(iEnv, *msgFactory, *trackFactory, aName, aData, aPcmStream, aSeekable, seek);
+    ContainerController* container = new ContainerController(*msgFactory, *source, *source, false);
+    container->AddContainer(ContainerFactory::NewId3v2());
+    container->AddContainer(ContainerFactory::NewMpeg4(*this));
+    container->AddContainer(ContainerFactory::NewMpegTs(*this));
+    Sink* sink = new Sink(iEnv);
+    CodecController* controller = new CodecController(*msgFactory, *container, *sink, *source,
+                                                      kMaxOutputJiffies, kPriorityNormal, false);
+    controller->AddCodec(CodecFactory::NewAac(*this));
+    controller->AddCodec(CodecFactory::NewAdts(*this));
+    controller->AddCodec(CodecFactory::NewAifc(*this));
+    controller->AddCodec(CodecFactory::NewAiff(*this));
+    controller->AddCodec(CodecFactory::NewAlacApple(*this));
+    controller->AddCodec(CodecFactory::NewFlac(*this));
+    controller->AddCodec(CodecFactory::NewMp3(*this));
+    controller->AddCodec(CodecFactory::NewPcm());
+    controller->AddCodec(CodecFactory::NewVorbis(*this));
+    controller->AddCodec(CodecFactory::NewWav(*this));
+
+    const std::clock_t cpuStart = std::clock();
+    controller->Start();
+    TUint64 seekStart = 0;
+    if (seek) {
+        source->WaitForGate();
+        TUint handle = ISeeker::kHandleError;
+        seekStart = OsTimeInUs(iEnv.OsCtx());
+        static_cast<ISeeker*>(controller)->StartSeek(MemorySource::kStreamId, aSeekSeconds, *sink, handle);
+        if (handle == ISeeker::kHandleError) {
+            sink->NotifySeekFailed();
+        }
+        source->ReleaseGate();
+    }
+    sink->WaitForQuit();
+    const std::clock_t cpuTicks = std::clock() - cpuStart;
+
+    aResult.iRecognised = sink->Recognised();
+    aResult.iDecodeUs = sink->QuitTime() - source->StreamStartTime();
+    aResult.iCpuUs = ((TUint64)cpuTicks * 1000000) / CLOCKS_PER_SEC;
+    aResult.iRecognitionUs = (aResult.iRecognised? sink->DecodedStreamTime() - source->StreamStartTime() : 0);
+    aResult.iJiffies = sink->Jiffies();
+    sink->GetStreamInfo(aResult.iCodec, aResult.iSampleRate, aResult.iBitDepth, aResult.iChannels, aResult.iSeekable);
+    aResult.iSeekCompleted = (seek && sink->SeekCompleted());
+    aResult.iSeekLatencyUs = (aResult.iSeekCompleted? sink->SeekAudioTime() - seekStart : 0);
+    aAllocatorStats.Capture();
+
+    delete controller;
+    delete sink;
+    delete container;
+    delete source;
+    delete trackFactory;
+    delete msgFactory;
+}
+
+TBool Bench::LoadFile(const Brx& aFilename, Bwh& aData)
+{
+    Bws<512> path(iDir);
+    if (path.Bytes() > 0 && path[path.Bytes()-1] != '/') {
+        path.Append('/');
+    }
+    path.Append(aFilename);
+    FileSourceStream file;
+    try {
+        file.Open(path.PtrZ());
+    }
+    catch (FileOpenError&) {
+        return false;
+    }
+    aData.Grow((TUint)file.Bytes());
+    try {
+        while (aData.Bytes() < aData.MaxBytes()) {
+            file.Read(aData);
+        }
+    }
+    catch (ReaderError&) {
+    }
+    file.Close();
+    return (aData.Bytes() > 0);
+}
+
+void Bench::BeginRun(const Brx& aName)
+{
+    Log::Print("%s\n    {\n", (iFirstRun? "" : ","));
+    iFirstRun = false;
+    Log::Print("%s\"name\": \"%.*s\",\n", kIndent, PBUF(aName));
+}
+
+void Bench::Add(const TChar* /*aMimeType*/)
+{
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionString optionDir("-d", "--dir", Brn("."), "directory containing TestCodec's audio files");
+    parser.AddOption(&optionDir);
+    OptionUint optionPasses("-n", "--passes", 3, "decodes of each stream (fastest is reported)");
+    parser.AddOption(&optionPasses);
+    OptionBool optionAll("-a", "--all", "also decode TestCodec's extra files");
+    parser.AddOption(&optionAll);
+    OptionString optionExtra("-x", "--extra", Brn("10s-stereo-44k-128k.mp3"), "comma separated additional files (in --dir)");
+    parser.AddOption(&optionExtra);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+    if (optionPasses.Value() == 0) {
+        Log::Print("--passes must be non-zero\n");
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionDir.Value(), optionPasses.Value());
+    bench->Run(optionAll.Value(), optionExtra.Value());
+    delete bench;
+    delete lib;
+}
@@ -1,5 +1,6 @@
 #include <OpenHome/Media/Pipeline/Msg.h>
 #include <OpenHome/Media/Codec/Container.h>
+#include <OpenHome/Media/Codec/ContainerFactory.h>
 #include <OpenHome/Private/SuiteUnitTest.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
 #include <OpenHome/Media/Debug.h>
@@ -255,6 +256,80 @@ private:
     TestDummyContainer* iDummyContainer;
 };
 
+/**
+ * Stream of encoded data held in memory.  Counts the bytes it outputs.
+ * Accepts any in-range seek regardless of what its MsgEncodedStream reports, so
+ * tests can check that callers respect the stream's Seekable()/Live() flags.
+ */
+class TestSeekableStream : public IPipelineElementUpstream, public IStreamHandler, private INonCopyable
+{
+    static const TUint kStreamId = 1;
+public:
+    TestSeekableStream(MsgFactory& aMsgFactory, const Brx& aData);
+    void Start(TBool aSeekable, TBool aLive);
+    TUint64 BytesTransferred() const;
+    TUint SeekCount() const;
+public: // from IPipelineElementUpstream
+    Msg* Pull() override;
+public: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    MsgFactory& iMsgFactory;
+    const Brx& iData;
+    TBool iSeekable;
+    TBool iLive;
+    TBool iStreamStarted;
+    TUint64 iPos;
+    TUint64 iBytesTransferred;
+    TUint iSeekCount;
+    TUint iNextFlushId;
+    TUint iPendingFlushId;
+};
+
+/**
+ * Checks that large ID3v2 tags are skipped by seeking upstream rather than by
+ * pulling the whole tag through the container.
+ */
+class SuiteId3v2Skip : public SuiteUnitTest, public TestContainerMsgProcessor
+{
+    static const TUint kArtworkBytes = 5 * 1024 * 1024;
+    static const TUint kAudioBytes = 100 * 1000;
+public:
+    SuiteId3v2Skip();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private:
+    void AppendTag(TUint aTagBytes);
+    void AppendAudio();
+    void PullStream(TBool aSeekable, TBool aLive);
+    TBool AudioMatches() const;
+private:
+    void TestLargeTagSeeks();
+    void TestChainedLargeTagsSeek();
+    void TestSmallTagDiscarded();
+    void TestNotSeekableDiscards();
+    void TestLiveDiscards();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    TestUrlBlockWriter iUrlBlockWriter;
+    Bwh iData;
+    TUint iAudioStart;
+    Bwh iAudio;
+    TUint iFlushCount;
+    TBool iQuit;
+    TestSeekableStream* iStream;
+};
+
 } // Codec
 } // Media
 } // OpenHome
@@ -1133,10 +1208,253 @@ void SuiteContainerNull::TestNullContainer()
 }
 
 
+// TestSeekableStream
+
+TestSeekableStream::TestSeekableStream(MsgFactory& aMsgFactory, const Brx& aData)
+    : iMsgFactory(aMsgFactory)
+    , iData(aData)
+    , iSeekable(false)
+    , iLive(false)
+    , iStreamStarted(false)
+    , iPos(0)
+    , iBytesTransferred(0)
+    , iSeekCount(0)
+    , iNextFlushId(MsgFlush::kIdInvalid+1)
+    , iPendingFlushId(MsgFlush::kIdInvalid)
+{
+}
+
+void TestSeekableStream::Start(TBool aSeekable, TBool aLive)
+{
+    iSeekable = aSeekable;
+    iLive = aLive;
+    iStreamStarted = false;
+    iPos = 0;
+    iBytesTransferred = 0;
+    iSeekCount = 0;
+    iPendingFlushId = MsgFlush::kIdInvalid;
+}
+
+TUint64 TestSeekableStream::BytesTransferred() const
+{
+    return iBytesTransferred;
+}
+
+TUint TestSeekableStream::SeekCount() const
+{
+    return iSeekCount;
+}
+
+Msg* TestSeekableStream::Pull()
+{
+    if (!iStreamStarted) {
+        iStreamStarted = true;
+        return iMsgFactory.CreateMsgEncodedStream(Brn("http://127.0.0.1:65535"), Brn("metatext"), iData.Bytes(), 0, kStreamId, iSeekable, iLive, Multiroom::Allowed, this);
+    }
+    if (iPendingFlushId != MsgFlush::kIdInvalid) {
+        Msg* msg = iMsgFactory.CreateMsgFlush(iPendingFlushId);
+        iPendingFlushId = MsgFlush::kIdInvalid;
+        return msg;
+    }
+    if (iPos == iData.Bytes()) {
+        return iMsgFactory.CreateMsgQuit();
+    }
+    const TUint remaining = (TUint)(iData.Bytes() - iPos);
+    const TUint bytes = (remaining < EncodedAudio::kMaxBytes? remaining : EncodedAudio::kMaxBytes);
+    Msg* msg = iMsgFactory.CreateMsgAudioEncoded(Brn(iData.Ptr() + iPos, bytes));
+    iPos += bytes;
+    iBytesTransferred += bytes;
+    return msg;
+}
+
+EStreamPlay TestSeekableStream::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+TUint TestSeekableStream::TrySeek(TUint aStreamId, TUint64 aOffset)
+{
+    if (aStreamId != kStreamId || aOffset > iData.Bytes()) {
+        return MsgFlush::kIdInvalid;
+    }
+    iSeekCount++;
+    iPos = aOffset;
+    iPendingFlushId = iNextFlushId++;
+    return iPendingFlushId;
+}
+
+TUint TestSeekableStream::TryDiscard(TUint /*aJiffies*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint TestSeekableStream::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void TestSeekableStream::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+}
+
+
+// SuiteId3v2Skip
+
+SuiteId3v2Skip::SuiteId3v2Skip()
+    : SuiteUnitTest("SuiteId3v2Skip")
+    , iData(2 * kArtworkBytes + kAudioBytes + 100)
+    , iAudio(kAudioBytes)
+{
+    AddTest(MakeFunctor(*this, &SuiteId3v2Skip::TestLargeTagSeeks), "TestLargeTagSeeks");
+    AddTest(MakeFunctor(*this, &SuiteId3v2Skip::TestChainedLargeTagsSeek), "TestChainedLargeTagsSeek");
+    AddTest(MakeFunctor(*this, &SuiteId3v2Skip::TestSmallTagDiscarded), "TestSmallTagDiscarded");
+    AddTest(MakeFunctor(*this, &SuiteId3v2Skip::TestNotSeekableDiscards), "TestNotSeekableDiscards");
+    AddTest(MakeFunctor(*this, &SuiteId3v2Skip::TestLiveDiscards), "TestLiveDiscards");
+}
+
+void SuiteId3v2Skip::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(20, 20);
+    init.SetMsgEncodedStreamCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iStream = new TestSeekableStream(*iMsgFactory, iData);
+    iData.SetBytes(0);
+    iAudio.SetBytes(0);
+    iAudioStart = 0;
+    iFlushCount = 0;
+    iQuit = false;
+}
+
+void SuiteId3v2Skip::TearDown()
+{
+    delete iStream;
+    delete iMsgFactory;
+}
+
+Msg* SuiteId3v2Skip::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    ASSERT(iAudio.Bytes() + aMsg->Bytes() <= iAudio.MaxBytes());
+    aMsg->CopyTo(const_cast<TByte*>(iAudio.Ptr()) + iAudio.Bytes());
+    iAudio.SetBytes(iAudio.Bytes() + aMsg->Bytes());
+    return aMsg;
+}
+
+Msg* SuiteId3v2Skip::ProcessMsg(MsgFlush* aMsg)
+{
+    iFlushCount++;
+    return aMsg;
+}
+
+Msg* SuiteId3v2Skip::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuit = true;
+    return aMsg;
+}
+
+void SuiteId3v2Skip::AppendTag(TUint aTagBytes)
+{
+    iData.Append(Brn("ID3"));
+    iData.Append((TByte)3);    // v2.3
+    iData.Append((TByte)0);
+    iData.Append((TByte)0);    // flags
+    iData.Append((TByte)((aTagBytes >> 21) & 0x7f));
+    iData.Append((TByte)((aTagBytes >> 14) & 0x7f));
+    iData.Append((TByte)((aTagBytes >> 7) & 0x7f));
+    iData.Append((TByte)(aTagBytes & 0x7f));
+    for (TUint i=0; i<aTagBytes; i++) {
+        iData.Append((TByte)0xff); // stand-in for artwork; must never reach the codec
+    }
+}
+
+void SuiteId3v2Skip::AppendAudio()
+{
+    iAudioStart = iData.Bytes();
+    for (TUint i=0; i<kAudioBytes; i++) {
+        iData.Append((TByte)(i % 251));
+    }
+}
+
+void SuiteId3v2Skip::PullStream(TBool aSeekable, TBool aLive)
+{
+    iStream->Start(aSeekable, aLive);
+    ContainerController* container = new ContainerController(*iMsgFactory, *iStream, iUrlBlockWriter, false);
+    container->AddContainer(ContainerFactory::NewId3v2());
+    while (!iQuit) {
+        Msg* msg = container->Pull();
+        msg = msg->Process(*this);
+        msg->RemoveRef();
+    }
+    delete container;
+}
+
+TBool SuiteId3v2Skip::AudioMatches() const
+{
+    return iAudio == Brn(iData.Ptr() + iAudioStart, kAudioBytes);
+}
+
+void SuiteId3v2Skip::TestLargeTagSeeks()
+{
+    AppendTag(kArtworkBytes);
+    AppendAudio();
+    PullStream(true, false);
+    TEST(AudioMatches());
+    TEST(iStream->SeekCount() == 1);
+    TEST(iStream->BytesTransferred() < kArtworkBytes / 10);
+    TEST(iFlushCount == 0);
+}
+
+void SuiteId3v2Skip::TestChainedLargeTagsSeek()
+{
+    AppendTag(kArtworkBytes);
+    AppendTag(kArtworkBytes / 4);
+    AppendAudio();
+    PullStream(true, false);
+    TEST(AudioMatches());
+    TEST(iStream->SeekCount() == 2);
+    TEST(iStream->BytesTransferred() < kArtworkBytes / 10);
+    TEST(iFlushCount == 0);
+}
+
+void SuiteId3v2Skip::TestSmallTagDiscarded()
+{
+    AppendTag(1024);
+    AppendAudio();
+    PullStream(true, false);
+    TEST(AudioMatches());
+    TEST(iStream->SeekCount() == 0);
+    TEST(iStream->BytesTransferred() == iData.Bytes());
+}
+
+void SuiteId3v2Skip::TestNotSeekableDiscards()
+{
+    AppendTag(kArtworkBytes);
+    AppendAudio();
+    PullStream(false, false);
+    TEST(AudioMatches());
+    TEST(iStream->SeekCount() == 0);
+    TEST(iStream->BytesTransferred() == iData.Bytes());
+    TEST(iFlushCount == 0);
+}
+
+void SuiteId3v2Skip::TestLiveDiscards()
+{
+    AppendTag(kArtworkBytes);
+    AppendAudio();
+    PullStream(true, true);
+    TEST(AudioMatches());
+    TEST(iStream->SeekCount() == 0);
+    TEST(iStream->BytesTransferred() == iData.Bytes());
+    TEST(iFlushCount == 0);
+}
+
+
 void TestContainer()
 {
     Runner runner("Container tests\n");
     runner.Add(new SuiteContainerUnbuffered());
     runner.Add(new SuiteContainerNull());
+    runner.Add(new SuiteId3v2Skip());
     runner.Run();
 }
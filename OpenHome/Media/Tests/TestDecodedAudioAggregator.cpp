@@ -80,6 +80,9 @@ private:
     MsgDecodedStream* CreateDecodedStream();
     MsgFlush* CreateFlush();
     MsgAudioPcm* CreateAudio(TUint aBytes, TUint aSampleRate=kSampleRate, TUint aBitDepth=kBitDepth, TUint aNumChannels=kChannels);
+    void CreateMsgFactory(TUint aDecodedAudioMediumCount);
+    void StartHighRateStream();
+    void StartMode(const Brx& aMode);
 private:
     void TestStreamSuccessful();
     void TestNoDataAfterDecodedStream();
@@ -88,6 +91,10 @@ private:
     void TestTrackEncodedStreamTrack();
     void TestPcmIsExpectedSize();
     void TestRawPcmNotAggregated();
+    void TestHighRateUsesLargerCells();
+    void TestLargerCellsExhausted();
+    void TestWindowPerMode();
+    void TestSenderWindow();
 private:
     static const TUint kWavHeaderBytes = 44;
     static const TUint kSampleRate = 44100;
@@ -135,24 +142,17 @@ SuiteDecodedAudioAggregator::SuiteDecodedAudioAggregator()
     AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestTrackEncodedStreamTrack), "TestTrackEncodedStreamTrack");
     AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestPcmIsExpectedSize), "TestPcmIsExpectedSize");
     AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestRawPcmNotAggregated), "TestRawPcmNotAggregated");
+    AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestHighRateUsesLargerCells), "TestHighRateUsesLargerCells");
+    AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestLargerCellsExhausted), "TestLargerCellsExhausted");
+    AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestWindowPerMode), "TestWindowPerMode");
+    AddTest(MakeFunctor(*this, &SuiteDecodedAudioAggregator::TestSenderWindow), "TestSenderWindow");
 }
 
 void SuiteDecodedAudioAggregator::Setup()
 {
     iTrackFactory = new TrackFactory(iInfoAggregator, 5);
-    // Need so many (Msg)AudioEncoded because kMaxMsgBytes is currently 960, and msgs are queued in advance of being pulled for these tests.
-    MsgFactoryInitParams init;
-    init.SetMsgAudioEncodedCount(400, 400);
-    init.SetMsgAudioPcmCount(100, 100);
-    init.SetMsgSilenceCount(10);
-    init.SetMsgPlayableCount(50, 0);
-    init.SetMsgDecodedStreamCount(2);
-    init.SetMsgTrackCount(2);
-    init.SetMsgEncodedStreamCount(2);
-    init.SetMsgMetaTextCount(2);
-    init.SetMsgHaltCount(2);
-    init.SetMsgFlushCount(2);
-    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iMsgFactory = nullptr;
+    CreateMsgFactory(0);
     iDecodedAudioAggregator = new DecodedAudioAggregator(*this);
     iSemReceived = new Semaphore("TCSR", 0);
     iSemStop = new Semaphore("TCSS", 0);
@@ -410,6 +410,48 @@ MsgAudioPcm* SuiteDecodedAudioAggregator::CreateAudio(TUint aBytes, TUint aSampl
     return audio;
 }
 
+void SuiteDecodedAudioAggregator::CreateMsgFactory(TUint aDecodedAudioMediumCount)
+{
+    delete iMsgFactory;
+    // Need so many (Msg)AudioEncoded because kMaxMsgBytes is currently 960, and msgs are queued in advance of being pulled for these tests.
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(400, 400);
+    init.SetMsgAudioPcmCount(100, 100);
+    init.SetDecodedAudioSizeClasses(aDecodedAudioMediumCount, 0, DecodedAudioAggregator::kMaxMs);
+    init.SetMsgSilenceCount(10);
+    init.SetMsgPlayableCount(50, 0);
+    init.SetMsgDecodedStreamCount(2);
+    init.SetMsgTrackCount(2);
+    init.SetMsgEncodedStreamCount(2);
+    init.SetMsgMetaTextCount(2);
+    init.SetMsgHaltCount(2);
+    init.SetMsgFlushCount(2);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+}
+
+void SuiteDecodedAudioAggregator::StartHighRateStream()
+{
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+    Queue(iMsgFactory->CreateMsgDecodedStream(++iNextStreamId, 0, 32, 192000, 8, Brn("Dummy"), 0, 0, true, true, false, false, Multiroom::Allowed, SpeakerProfile(8), this));
+    PullNext(EMsgDecodedStream);
+}
+
+void SuiteDecodedAudioAggregator::StartMode(const Brx& aMode)
+{
+    // 48k/16-bit/stereo so that 1ms of audio is a whole number of samples
+    Queue(iMsgFactory->CreateMsgMode(aMode));
+    PullNext(EMsgMode);
+    Queue(CreateTrack());
+    PullNext(EMsgTrack);
+    Queue(CreateEncodedStream());
+    PullNext(EMsgEncodedStream);
+    Queue(iMsgFactory->CreateMsgDecodedStream(++iNextStreamId, 0, 16, 48000, 2, Brn("Dummy"), 0, 0, true, true, false, false, Multiroom::Allowed, kProfile, this));
+    PullNext(EMsgDecodedStream);
+}
+
 void SuiteDecodedAudioAggregator::TestStreamSuccessful()
 {
     static const TUint kMaxMsgBytes = DecodedAudio::kMaxBytes;
@@ -553,6 +595,116 @@ void SuiteDecodedAudioAggregator::TestRawPcmNotAggregated()
     TEST(iJiffies == iTrackOffset);
 }
 
+void SuiteDecodedAudioAggregator::TestHighRateUsesLargerCells()
+{
+    // 1ms of 192k/8ch/32-bit is 6144 bytes so only one codec output fits in a default cell
+    static const TUint kBytesPerMs = 192 * 8 * 4;
+    static const TUint64 kJiffies1Ms = Jiffies::kPerMs;
+    CreateMsgFactory(10);
+    StartHighRateStream();
+
+    for (TUint i=0; i<10; i++) {
+        Queue(CreateAudio(kBytesPerMs, 192000, 32, 8));
+    }
+    Queue(CreateEncodedStream());
+    PullNext(EMsgAudioPcm, kJiffies1Ms * DecodedAudioAggregator::kMaxMs);
+    PullNext(EMsgAudioPcm, kJiffies1Ms * DecodedAudioAggregator::kMaxMs);
+    PullNext(EMsgEncodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
+void SuiteDecodedAudioAggregator::TestLargerCellsExhausted()
+{
+    static const TUint kBytesPerMs = 192 * 8 * 4;
+    static const TUint64 kJiffies1Ms = Jiffies::kPerMs;
+    CreateMsgFactory(1);
+    StartHighRateStream();
+
+    // first msg takes the only larger cell; later ones fall back to default sized cells
+    for (TUint i=0; i<7; i++) {
+        Queue(CreateAudio(kBytesPerMs, 192000, 32, 8));
+    }
+    Queue(CreateEncodedStream());
+    PullNext(EMsgAudioPcm, kJiffies1Ms * DecodedAudioAggregator::kMaxMs);
+    PullNext(EMsgAudioPcm, kJiffies1Ms);
+    PullNext(EMsgAudioPcm, kJiffies1Ms);
+    PullNext(EMsgEncodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
+void SuiteDecodedAudioAggregator::TestWindowPerMode()
+{
+    static const TUint kBytesPerMs = 48 * 2 * 2;
+    static const TUint64 kJiffies1Ms = Jiffies::kPerMs;
+    static const Brn kModeLocal("Local");
+    static const Brn kModeOther("Other");
+    iDecodedAudioAggregator->AddModeWindow(kModeLocal, 20);
+
+    StartMode(kModeLocal);
+    for (TUint i=0; i<25; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    Queue(CreateEncodedStream());
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 20);
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 5);
+    PullNext(EMsgEncodedStream);
+
+    // modes without their own window revert to the default
+    StartMode(kModeOther);
+    for (TUint i=0; i<10; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    Queue(CreateEncodedStream());
+    PullNext(EMsgAudioPcm, kJiffies1Ms * DecodedAudioAggregator::kMaxMs);
+    PullNext(EMsgAudioPcm, kJiffies1Ms * DecodedAudioAggregator::kMaxMs);
+    PullNext(EMsgEncodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
+void SuiteDecodedAudioAggregator::TestSenderWindow()
+{
+    static const TUint kBytesPerMs = 48 * 2 * 2;
+    static const TUint64 kJiffies1Ms = Jiffies::kPerMs;
+    static const Brn kModeLocal("Local");
+    static const Brn kModeReceiver("Receiver");
+    iDecodedAudioAggregator->SetWindows(20, 5);
+    iDecodedAudioAggregator->AddModeWindow(kModeReceiver, 40);
+
+    // sender without listeners => default window
+    StartMode(kModeLocal);
+    for (TUint i=0; i<20; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 20);
+
+    // listener joins mid-stream => sender window applies from the next msg
+    iDecodedAudioAggregator->NotifySenderActive(true);
+    for (TUint i=0; i<10; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 5);
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 5);
+
+    // a mode's own window takes precedence over the sender's
+    StartMode(kModeReceiver);
+    for (TUint i=0; i<40; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 40);
+
+    // last listener leaves => default window again
+    StartMode(kModeLocal);
+    iDecodedAudioAggregator->NotifySenderActive(false);
+    for (TUint i=0; i<25; i++) {
+        Queue(CreateAudio(kBytesPerMs, 48000, 16, 2));
+    }
+    Queue(CreateEncodedStream());
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 20);
+    PullNext(EMsgAudioPcm, kJiffies1Ms * 5);
+    PullNext(EMsgEncodedStream);
+    TEST(iJiffies == iTrackOffset);
+}
+
 
 void TestDecodedAudioAggregator()
 {
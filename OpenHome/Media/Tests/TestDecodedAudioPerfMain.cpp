@@ -0,0 +1,299 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Pipeline/DecodedAudioAggregator.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Measures the cost of moving decoded audio through the pipeline for a range of formats,
+    with and without MsgFactory's larger DecodedAudio size classes, then (with size
+    classes) for a range of DecodedAudioAggregator windows, as selected per mode by
+    PipelineInitParams::SetAggregationWindows()/AddModeAggregationWindow().
+    Codec-sized chunks of audio are passed through DecodedAudioAggregator then a chain
+    of pass-through elements (standing in for the pipeline's other elements) before
+    being freed.  Reports the number of MsgAudioPcm output per second of audio and the
+    time (on a single thread, so effectively CPU time) taken to process each second of audio.
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestDecodedAudioPerf {
+
+class Hop : public PipelineElement, public IPipelineElementDownstream, private INonCopyable
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    Hop(IPipelineElementDownstream& aDownstream);
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private:
+    IPipelineElementDownstream& iDownstream;
+};
+
+class Sink : public PipelineElement, public IPipelineElementDownstream
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    Sink();
+    TUint AudioMsgs() const;
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+private:
+    TUint iAudioMsgs;
+};
+
+class Bench : private INonCopyable
+{
+    static const TUint kDecodedAudioCount = 16;
+    static const TUint kMaxFramesPerChunk = 1152; // typical of mp3/flac output
+    static const TUint kMaxHops = 64;
+    static const TUint kWindowsMs[];
+    static const TUint kNumWindows = 3;
+    static const TChar* kMode;
+public:
+    Bench(Environment& aEnv, TUint aSeconds, TUint aHops);
+    void Run();
+private:
+    void RunFormat(TUint aSampleRate, TUint aBitDepth, TUint aChannels);
+    void RunWindows(TUint aSampleRate, TUint aBitDepth, TUint aChannels);
+    void Measure(TUint aSampleRate, TUint aBitDepth, TUint aChannels, TBool aSizeClasses, TUint aWindowMs,
+                 TUint& aMsgsPerSec, TUint& aUsPerSec);
+private:
+    Environment& iEnv;
+    const TUint iSeconds;
+    const TUint iHops;
+    AllocatorInfoLogger iInfoAggregator;
+};
+
+} // namespace TestDecodedAudioPerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestDecodedAudioPerf;
+
+
+// Hop
+
+const TUint Hop::kSupportedMsgTypes =   eMode
+                                      | eDecodedStream
+                                      | eAudioPcm
+                                      | eQuit;
+
+Hop::Hop(IPipelineElementDownstream& aDownstream)
+    : PipelineElement(kSupportedMsgTypes)
+    , iDownstream(aDownstream)
+{
+}
+
+void Hop::Push(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    iDownstream.Push(msg);
+}
+
+
+// Sink
+
+const TUint Sink::kSupportedMsgTypes =   eMode
+                                       | eDecodedStream
+                                       | eAudioPcm
+                                       | eQuit;
+
+Sink::Sink()
+    : PipelineElement(kSupportedMsgTypes)
+    , iAudioMsgs(0)
+{
+}
+
+TUint Sink::AudioMsgs() const
+{
+    return iAudioMsgs;
+}
+
+void Sink::Push(Msg* aMsg)
+{
+    Msg* msg = aMsg->Process(*this);
+    msg->RemoveRef();
+}
+
+Msg* Sink::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    iAudioMsgs++;
+    return aMsg;
+}
+
+
+// Bench
+
+const TUint Bench::kWindowsMs[] = { DecodedAudioAggregator::kMaxMs, 20, 40 };
+const TChar* Bench::kMode = "Perf";
+
+Bench::Bench(Environment& aEnv, TUint aSeconds, TUint aHops)
+    : iEnv(aEnv)
+    , iSeconds(aSeconds)
+    , iHops(aHops > kMaxHops? kMaxHops : aHops)
+{
+}
+
+void Bench::Run()
+{
+    Log::Print("DecodedAudio benchmark (%us of audio per format, %u elements after DecodedAudioAggregator)\n", iSeconds, iHops);
+    Log::Print("%-18s %14s %14s %14s %14s\n", "format", "msgs/s", "msgs/s", "us/s", "us/s");
+    Log::Print("%-18s %14s %14s %14s %14s\n", "", "(default)", "(classes)", "(default)", "(classes)");
+    RunFormat(44100, 16, 2);
+    RunFormat(48000, 24, 2);
+    RunFormat(96000, 24, 2);
+    RunFormat(192000, 24, 2);
+    RunFormat(96000, 24, 6);
+    RunFormat(192000, 24, 8);
+    RunFormat(192000, 32, 8);
+
+    Log::Print("\nBy aggregation window (with size classes)\n");
+    Log::Print("%-18s", "format");
+    for (TUint i=0; i<kNumWindows; i++) {
+        Log::Print(" %14s", "msgs/s");
+    }
+    for (TUint i=0; i<kNumWindows; i++) {
+        Log::Print(" %14s", "us/s");
+    }
+    Log::Print("\n%-18s", "");
+    for (TUint j=0; j<2; j++) {
+        for (TUint i=0; i<kNumWindows; i++) {
+            Bws<16> window;
+            window.AppendPrintf("(%ums)", kWindowsMs[i]);
+            Log::Print(" %14.*s", PBUF(window));
+        }
+    }
+    Log::Print("\n");
+    RunWindows(44100, 16, 2);
+    RunWindows(48000, 24, 2);
+    RunWindows(96000, 24, 2);
+    RunWindows(192000, 24, 2);
+    RunWindows(192000, 24, 8);
+}
+
+void Bench::RunFormat(TUint aSampleRate, TUint aBitDepth, TUint aChannels)
+{
+    TUint msgsDefault, usDefault, msgsClasses, usClasses;
+    Measure(aSampleRate, aBitDepth, aChannels, false, DecodedAudioAggregator::kMaxMs, msgsDefault, usDefault);
+    Measure(aSampleRate, aBitDepth, aChannels, true, DecodedAudioAggregator::kMaxMs, msgsClasses, usClasses);
+    Bws<32> format;
+    format.AppendPrintf("%u/%u/%uch", aSampleRate, aBitDepth, aChannels);
+    format.PtrZ();
+    Log::Print("%-18s %14u %14u %14u %14u\n", reinterpret_cast<const TChar*>(format.Ptr()),
+               msgsDefault, msgsClasses, usDefault, usClasses);
+}
+
+void Bench::RunWindows(TUint aSampleRate, TUint aBitDepth, TUint aChannels)
+{
+    TUint msgs[kNumWindows];
+    TUint us[kNumWindows];
+    for (TUint i=0; i<kNumWindows; i++) {
+        Measure(aSampleRate, aBitDepth, aChannels, true, kWindowsMs[i], msgs[i], us[i]);
+    }
+    Bws<32> format;
+    format.AppendPrintf("%u/%u/%uch", aSampleRate, aBitDepth, aChannels);
+    Log::Print("%-18.*s", PBUF(format));
+    for (TUint i=0; i<kNumWindows; i++) {
+        Log::Print(" %14u", msgs[i]);
+    }
+    for (TUint i=0; i<kNumWindows; i++) {
+        Log::Print(" %14u", us[i]);
+    }
+    Log::Print("\n");
+}
+
+void Bench::Measure(TUint aSampleRate, TUint aBitDepth, TUint aChannels, TBool aSizeClasses, TUint aWindowMs,
+                    TUint& aMsgsPerSec, TUint& aUsPerSec)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioPcmCount(kDecodedAudioCount, kDecodedAudioCount);
+    if (aSizeClasses) {
+        init.SetDecodedAudioSizeClasses(kDecodedAudioCount, kDecodedAudioCount, aWindowMs);
+    }
+    init.SetMsgDecodedStreamCount(2);
+    MsgFactory* factory = new MsgFactory(iInfoAggregator, init);
+
+    Sink sink;
+    std::vector<Hop*> hops;
+    IPipelineElementDownstream* downstream = &sink;
+    for (TUint i=0; i<iHops; i++) {
+        Hop* hop = new Hop(*downstream);
+        hops.push_back(hop);
+        downstream = hop;
+    }
+    DecodedAudioAggregator* aggregator = new DecodedAudioAggregator(*downstream);
+    aggregator->AddModeWindow(Brn(kMode), aWindowMs);
+
+    const TUint frameBytes = aChannels * (aBitDepth / 8);
+    TUint framesPerChunk = DecodedAudio::kMaxBytes / frameBytes;
+    if (framesPerChunk > kMaxFramesPerChunk) {
+        framesPerChunk = kMaxFramesPerChunk;
+    }
+    Bwh chunk(framesPerChunk * frameBytes);
+    (void)memset(const_cast<TByte*>(chunk.Ptr()), 0x7f, chunk.MaxBytes());
+    chunk.SetBytes(chunk.MaxBytes());
+    const TUint64 totalFrames = (TUint64)aSampleRate * iSeconds;
+    const TUint jiffiesPerChunk = framesPerChunk * Jiffies::PerSample(aSampleRate);
+
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    aggregator->Push(factory->CreateMsgMode(Brn(kMode)));
+    aggregator->Push(factory->CreateMsgDecodedStream(1, 0, aBitDepth, aSampleRate, aChannels, Brn("Perf"), 0, 0, true, false, false, false,
+                                                     Multiroom::Allowed, SpeakerProfile(aChannels), nullptr));
+    TUint64 trackOffset = 0;
+    for (TUint64 frames=0; frames<totalFrames; frames+=framesPerChunk) {
+        aggregator->Push(factory->CreateMsgAudioPcm(chunk, aChannels, aSampleRate, aBitDepth, AudioDataEndian::Big, trackOffset));
+        trackOffset += jiffiesPerChunk;
+    }
+    aggregator->Push(factory->CreateMsgQuit());
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+
+    aMsgsPerSec = sink.AudioMsgs() / iSeconds;
+    aUsPerSec = (TUint)(us / iSeconds);
+
+    delete aggregator;
+    for (auto hop : hops) {
+        delete hop;
+    }
+    delete factory;
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionSeconds("-s", "--seconds", 60, "seconds of audio generated for each format");
+    parser.AddOption(&optionSeconds);
+    OptionUint optionHops("-e", "--elements", 30, "pass-through elements following DecodedAudioAggregator (max 64)");
+    parser.AddOption(&optionHops);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+    if (optionSeconds.Value() == 0) {
+        Log::Print("--seconds must be non-zero\n");
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionSeconds.Value(), optionHops.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
@@ -0,0 +1,316 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Protocol/ContentAudio.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Compares the two ways ContentAudio can ingest a protocol's data:
+    - Stream(): data is received into a read buffer (Srs) then copied into EncodedAudio
+    - StreamDirect(): data is received directly into EncodedAudio, via ReaderBufferDirect
+    A memory-backed IReaderSource stands in for a socket, returning at most --chunk bytes
+    per read.  Reports throughput and the number of bytes copied in user space per byte
+    delivered to the pipeline (excluding the 'recv' from the source).
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestEncodedIngestPerf {
+
+class SourceMemory : public IReaderSource, private INonCopyable
+{
+public:
+    SourceMemory(TUint aChunkBytes);
+    void Reset(TUint64 aTotalBytes);
+    TBool LastReadWasTo(const TByte* aPtr, TUint aBytes) const;
+public: // from IReaderSource
+    void Read(Bwx& aBuffer) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+private:
+    Bwh iData;
+    TUint64 iRemaining;
+    TUint iOffset;
+    const TByte* iLastReadPtr;
+    TUint iLastReadBytes;
+};
+
+class ReaderCounting : public IReader, public IReaderDirect, private INonCopyable
+{
+public:
+    ReaderCounting(IReader& aReader, IReaderDirect& aReaderDirect, const SourceMemory& aSource);
+    TUint64 BytesCopied() const;
+public: // from IReader
+    Brn Read(TUint aBytes) override;
+    void ReadFlush() override;
+    void ReadInterrupt() override;
+public: // from IReaderDirect
+    void ReadDirect(Bwx& aBuffer) override;
+private:
+    IReader& iReader;
+    IReaderDirect& iReaderDirect;
+    const SourceMemory& iSource;
+    TUint64 iBytesCopied;
+};
+
+class DownstreamCounting : public IPipelineElementDownstream
+{
+public:
+    DownstreamCounting();
+    void Reset();
+    TUint64 Bytes() const;
+    TUint Msgs() const;
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private:
+    TUint64 iBytes;
+    TUint iMsgs;
+};
+
+class Bench : private INonCopyable
+{
+    static const TUint kReadBufferBytes = 6 * 1024; // as ProtocolNetwork
+public:
+    Bench(Environment& aEnv, TUint64 aBytes, TUint aChunkBytes);
+    ~Bench();
+    void Run();
+private:
+    void Report(const TChar* aName, TUint64 aUs, TUint64 aBytesCopied);
+private:
+    Environment& iEnv;
+    const TUint64 iBytes;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    SourceMemory iSource;
+    DownstreamCounting iDownstream;
+};
+
+} // namespace TestEncodedIngestPerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestEncodedIngestPerf;
+
+
+// SourceMemory
+
+SourceMemory::SourceMemory(TUint aChunkBytes)
+    : iData(aChunkBytes)
+    , iRemaining(0)
+    , iOffset(0)
+    , iLastReadPtr(nullptr)
+    , iLastReadBytes(0)
+{
+    for (TUint i=0; i<aChunkBytes; i++) {
+        iData.Append((TByte)i);
+    }
+}
+
+void SourceMemory::Reset(TUint64 aTotalBytes)
+{
+    iRemaining = aTotalBytes;
+    iOffset = 0;
+    iLastReadPtr = nullptr;
+    iLastReadBytes = 0;
+}
+
+TBool SourceMemory::LastReadWasTo(const TByte* aPtr, TUint aBytes) const
+{
+    return iLastReadPtr == aPtr && iLastReadBytes == aBytes;
+}
+
+void SourceMemory::Read(Bwx& aBuffer)
+{
+    if (iRemaining == 0) {
+        THROW(ReaderError);
+    }
+    TUint bytes = std::min(aBuffer.MaxBytes() - aBuffer.Bytes(), iData.Bytes() - iOffset);
+    if (bytes > iRemaining) {
+        bytes = (TUint)iRemaining;
+    }
+    iLastReadPtr = aBuffer.Ptr() + aBuffer.Bytes();
+    iLastReadBytes = bytes;
+    aBuffer.Append(iData.Ptr() + iOffset, bytes); // models the kernel's copy during recv()
+    iOffset += bytes;
+    if (iOffset == iData.Bytes()) {
+        iOffset = 0;
+    }
+    iRemaining -= bytes;
+}
+
+void SourceMemory::ReadFlush()
+{
+}
+
+void SourceMemory::ReadInterrupt()
+{
+}
+
+
+// ReaderCounting
+
+ReaderCounting::ReaderCounting(IReader& aReader, IReaderDirect& aReaderDirect, const SourceMemory& aSource)
+    : iReader(aReader)
+    , iReaderDirect(aReaderDirect)
+    , iSource(aSource)
+    , iBytesCopied(0)
+{
+}
+
+TUint64 ReaderCounting::BytesCopied() const
+{
+    return iBytesCopied;
+}
+
+Brn ReaderCounting::Read(TUint aBytes)
+{
+    Brn buf = iReader.Read(aBytes);
+    iBytesCopied += buf.Bytes(); // ContentAudio copies everything returned by Read()
+    return buf;
+}
+
+void ReaderCounting::ReadFlush()
+{
+    iReader.ReadFlush();
+}
+
+void ReaderCounting::ReadInterrupt()
+{
+    iReader.ReadInterrupt();
+}
+
+void ReaderCounting::ReadDirect(Bwx& aBuffer)
+{
+    const TByte* dest = aBuffer.Ptr() + aBuffer.Bytes();
+    const TUint prevBytes = aBuffer.Bytes();
+    iReaderDirect.ReadDirect(aBuffer);
+    const TUint bytes = aBuffer.Bytes() - prevBytes;
+    if (!iSource.LastReadWasTo(dest, bytes)) {
+        iBytesCopied += bytes; // data was copied from an intermediate buffer
+    }
+}
+
+
+// DownstreamCounting
+
+DownstreamCounting::DownstreamCounting()
+    : iBytes(0)
+    , iMsgs(0)
+{
+}
+
+void DownstreamCounting::Reset()
+{
+    iBytes = 0;
+    iMsgs = 0;
+}
+
+TUint64 DownstreamCounting::Bytes() const
+{
+    return iBytes;
+}
+
+TUint DownstreamCounting::Msgs() const
+{
+    return iMsgs;
+}
+
+void DownstreamCounting::Push(Msg* aMsg)
+{
+    auto audio = dynamic_cast<MsgAudioEncoded*>(aMsg);
+    if (audio != nullptr) {
+        iBytes += audio->Bytes();
+        iMsgs++;
+    }
+    aMsg->RemoveRef();
+}
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, TUint64 aBytes, TUint aChunkBytes)
+    : iEnv(aEnv)
+    , iBytes(aBytes)
+    , iSource(aChunkBytes)
+{
+    MsgFactoryInitParams init;
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+}
+
+Bench::~Bench()
+{
+    delete iMsgFactory;
+}
+
+void Bench::Run()
+{
+    Log::Print("Encoded audio ingest benchmark (%llu bytes)\n", iBytes);
+    Log::Print("%-28s %10s %14s %10s\n", "path", "MB/s", "copies/byte", "msgs");
+    {
+        ContentAudio content(*iMsgFactory, iDownstream);
+        ContentProcessor& processor = content;
+        Srs<kReadBufferBytes> readerBuf(iSource);
+        ReaderBufferDirect unused(1, iSource);
+        ReaderCounting reader(readerBuf, unused, iSource);
+        iSource.Reset(iBytes);
+        const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+        (void)processor.Stream(reader, iBytes);
+        Report("Stream (Srs)", OsTimeInUs(iEnv.OsCtx()) - start, reader.BytesCopied());
+    }
+    {
+        ContentAudio content(*iMsgFactory, iDownstream);
+        ContentProcessor& processor = content;
+        ReaderBufferDirect readerBuf(kReadBufferBytes, iSource);
+        ReaderCounting reader(readerBuf, readerBuf, iSource);
+        iSource.Reset(iBytes);
+        const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+        (void)processor.StreamDirect(reader, reader, iBytes);
+        Report("StreamDirect", OsTimeInUs(iEnv.OsCtx()) - start, reader.BytesCopied());
+    }
+}
+
+void Bench::Report(const TChar* aName, TUint64 aUs, TUint64 aBytesCopied)
+{
+    const TUint64 bytes = iDownstream.Bytes();
+    ASSERT(bytes == iBytes);
+    const TUint64 mbPerSec = (aUs == 0? 0 : bytes / aUs); // bytes/us == MB/s
+    const TUint copiesPerByteX1000 = (TUint)((aBytesCopied * 1000) / bytes);
+    Log::Print("%-28s %10llu %10u.%03u %10u\n", aName, mbPerSec,
+               copiesPerByteX1000 / 1000, copiesPerByteX1000 % 1000, iDownstream.Msgs());
+    iDownstream.Reset();
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionMb("-m", "--mb", 512, "MB of data streamed through each path");
+    parser.AddOption(&optionMb);
+    OptionUint optionChunk("-c", "--chunk", 16 * 1024, "max bytes returned by each read from the (simulated) socket");
+    parser.AddOption(&optionChunk);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), (TUint64)optionMb.Value() * 1024 * 1024, optionChunk.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
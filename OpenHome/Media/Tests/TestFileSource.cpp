@@ -0,0 +1,276 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Protocol/FileSource.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Private/File.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Buffer.h>
+
+#include <stdio.h>
+
+#ifdef __linux__
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteFileSource : public SuiteUnitTest
+{
+    static const TChar* kFileName;
+    static const TUint kFileBytes = 300007; // not a multiple of any page or read size
+public:
+    SuiteFileSource(const TChar* aName, IFileSource* aSource);
+    ~SuiteFileSource();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    static TByte ExpectedByte(TUint64 aOffset);
+    TBool CheckRead(TUint64 aOffset, TUint aBytes);
+private:
+    void TestBytes();
+    void TestReadAll();
+    void TestSeek();
+    void TestEndOfFileThrows();
+    void TestInterrupt();
+    void TestOpenMissingFileThrows();
+private:
+    IFileSource* iSource;
+};
+
+#ifdef __linux__
+class SuiteFileSourceLarge : public SuiteUnitTest
+{
+    static const TChar* kFileName;
+    static const TUint64 kFileBytes = 5ULL * 1024 * 1024 * 1024;
+    static const TUint64 kMarkerOffset = (9ULL * 1024 * 1024 * 1024) / 2;
+public:
+    SuiteFileSourceLarge();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestSeekBeyond4GB();
+    void TestTruncatedWhileMappedThrows();
+private:
+    IFileSource* iSource;
+    TBool iFileCreated;
+};
+#endif // __linux__
+
+} // namespace Media
+} // namespace OpenHome
+
+
+// SuiteFileSource
+
+const TChar* SuiteFileSource::kFileName = "TestFileSource.tmp";
+
+SuiteFileSource::SuiteFileSource(const TChar* aName, IFileSource* aSource)
+    : SuiteUnitTest(aName)
+    , iSource(aSource)
+{
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestBytes), "TestBytes");
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestReadAll), "TestReadAll");
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestSeek), "TestSeek");
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestEndOfFileThrows), "TestEndOfFileThrows");
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestInterrupt), "TestInterrupt");
+    AddTest(MakeFunctor(*this, &SuiteFileSource::TestOpenMissingFileThrows), "TestOpenMissingFileThrows");
+}
+
+SuiteFileSource::~SuiteFileSource()
+{
+    delete iSource;
+}
+
+void SuiteFileSource::Setup()
+{
+    FILE* f = fopen(kFileName, "wb");
+    ASSERT(f != nullptr);
+    for (TUint i=0; i<kFileBytes; i++) {
+        (void)fputc(ExpectedByte(i), f);
+    }
+    (void)fclose(f);
+    iSource->Open(kFileName);
+    iSource->Interrupt(false);
+}
+
+void SuiteFileSource::TearDown()
+{
+    iSource->Close();
+    (void)remove(kFileName);
+}
+
+TByte SuiteFileSource::ExpectedByte(TUint64 aOffset)
+{ // static
+    return (TByte)((aOffset * 7) % 251);
+}
+
+TBool SuiteFileSource::CheckRead(TUint64 aOffset, TUint aBytes)
+{
+    Bwh buf(aBytes);
+    while (buf.Bytes() < aBytes) {
+        iSource->Read(buf);
+    }
+    for (TUint i=0; i<buf.Bytes(); i++) {
+        if (buf[i] != ExpectedByte(aOffset + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SuiteFileSource::TestBytes()
+{
+    TEST(iSource->Bytes() == kFileBytes);
+}
+
+void SuiteFileSource::TestReadAll()
+{
+    Bwh buf(kFileBytes + 100);
+    try {
+        for (;;) {
+            iSource->Read(buf);
+        }
+    }
+    catch (ReaderError&) {
+    }
+    TEST(buf.Bytes() == kFileBytes);
+    TBool match = true;
+    for (TUint i=0; i<buf.Bytes() && match; i++) {
+        match = (buf[i] == ExpectedByte(i));
+    }
+    TEST(match);
+}
+
+void SuiteFileSource::TestSeek()
+{
+    static const TUint kOffsets[] = { 100000, 4096, 0, 299000, 12345 };
+    for (auto offset : kOffsets) {
+        iSource->Seek(offset);
+        TEST(CheckRead(offset, 1000));
+    }
+}
+
+void SuiteFileSource::TestEndOfFileThrows()
+{
+    iSource->Seek(kFileBytes - 10);
+    TEST(CheckRead(kFileBytes - 10, 10));
+    Bws<10> buf;
+    TEST_THROWS(iSource->Read(buf), ReaderError);
+}
+
+void SuiteFileSource::TestInterrupt()
+{
+    Bws<100> buf;
+    iSource->ReadInterrupt();
+    TEST_THROWS(iSource->Read(buf), ReaderError);
+    iSource->Interrupt(false);
+    TEST(CheckRead(0, 100));
+}
+
+void SuiteFileSource::TestOpenMissingFileThrows()
+{
+    iSource->Close();
+    TEST_THROWS(iSource->Open("TestFileSourceMissing.tmp"), FileOpenError);
+    iSource->Open(kFileName);
+}
+
+
+#ifdef __linux__
+
+// SuiteFileSourceLarge
+
+const TChar* SuiteFileSourceLarge::kFileName = "TestFileSourceLarge.tmp";
+
+SuiteFileSourceLarge::SuiteFileSourceLarge()
+    : SuiteUnitTest("FileSourceMapped (>4GB)")
+    , iSource(nullptr)
+    , iFileCreated(false)
+{
+    AddTest(MakeFunctor(*this, &SuiteFileSourceLarge::TestSeekBeyond4GB), "TestSeekBeyond4GB");
+    AddTest(MakeFunctor(*this, &SuiteFileSourceLarge::TestTruncatedWhileMappedThrows), "TestTruncatedWhileMappedThrows");
+}
+
+void SuiteFileSourceLarge::Setup()
+{
+    // sparse file, so uses little disk space
+    const int fd = open(kFileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT(fd != -1);
+    iFileCreated = (ftruncate(fd, (off_t)kFileBytes) == 0);
+    if (iFileCreated) {
+        const TChar marker[] = "marker";
+        iFileCreated = (pwrite(fd, marker, sizeof(marker), (off_t)kMarkerOffset) == (ssize_t)sizeof(marker));
+    }
+    (void)close(fd);
+    iSource = FileSourceFactory::NewMapped();
+    iSource->Open(kFileName);
+}
+
+void SuiteFileSourceLarge::TearDown()
+{
+    delete iSource;
+    (void)remove(kFileName);
+}
+
+void SuiteFileSourceLarge::TestSeekBeyond4GB()
+{
+    if (!iFileCreated) {
+        Print("Unable to create sparse file - skipping\n");
+        return;
+    }
+    TEST(iSource->Bytes() == kFileBytes);
+    iSource->Seek(kMarkerOffset);
+    Bws<6> buf;
+    while (buf.Bytes() < buf.MaxBytes()) {
+        iSource->Read(buf);
+    }
+    TEST(buf == Brn("marker"));
+    iSource->Seek(kFileBytes - 1);
+    buf.SetBytes(0);
+    iSource->Read(buf);
+    TEST(buf.Bytes() == 1);
+    TEST_THROWS(iSource->Read(buf), ReaderError);
+}
+
+void SuiteFileSourceLarge::TestTruncatedWhileMappedThrows()
+{
+    if (!iFileCreated) {
+        Print("Unable to create sparse file - skipping\n");
+        return;
+    }
+    iSource->Seek(kMarkerOffset);
+    Bws<6> buf;
+    while (buf.Bytes() < buf.MaxBytes()) {
+        iSource->Read(buf); // maps the window containing the marker
+    }
+    TEST(truncate(kFileName, 0) == 0);
+    // later reads from the same window now fault
+    iSource->Seek(kMarkerOffset + 64 * 1024);
+    buf.SetBytes(0);
+    TEST_THROWS(iSource->Read(buf), ReaderError);
+}
+
+#endif // __linux__
+
+
+
+void TestFileSource()
+{
+    Runner runner("FileSource tests\n");
+    runner.Add(new SuiteFileSource("FileSourceStream", FileSourceFactory::NewStream()));
+    IFileSource* mapped = FileSourceFactory::NewMapped();
+    if (mapped != nullptr) {
+        runner.Add(new SuiteFileSource("FileSourceMapped", mapped));
+    }
+#ifdef __linux__
+    runner.Add(new SuiteFileSourceLarge());
+#endif
+    runner.Run();
+}
@@ -0,0 +1,179 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Protocol/FileSource.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/File.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <ctime>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Measures local file read throughput and CPU use, reading into EncodedAudio sized
+    buffers as ContentAudio does:
+    - stream/Srs: FileStream read via a 6KB Srs, data then copied (as ProtocolFile used to)
+    - stream/direct: FileStream read directly into each buffer
+    - mapped/direct: FileSourceMapped copying directly from the mapping into each buffer
+    The file is read once before timing so that all runs are served from the page cache.
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestFileSourcePerf {
+
+class Bench : private INonCopyable
+{
+    static const TUint kReadBufferBytes = 6 * 1024; // as ProtocolFile
+public:
+    Bench(Environment& aEnv, const Brx& aPath, TUint aPasses);
+    void Run();
+private:
+    void RunSrs(const TChar* aName, IFileSource& aSource);
+    void RunDirect(const TChar* aName, IFileSource& aSource);
+    void Report(const TChar* aName, TUint64 aBytes, TUint64 aUs, std::clock_t aCpuTicks);
+private:
+    Environment& iEnv;
+    Bwh iPath;
+    const TUint iPasses;
+    Bws<EncodedAudio::kMaxBytes> iAudio;
+};
+
+} // namespace TestFileSourcePerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestFileSourcePerf;
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, const Brx& aPath, TUint aPasses)
+    : iEnv(aEnv)
+    , iPath(aPath.Bytes() + 1)
+    , iPasses(aPasses)
+{
+    iPath.Replace(aPath);
+    iPath.PtrZ();
+}
+
+void Bench::Run()
+{
+    IFileSource* stream = FileSourceFactory::NewStream();
+    IFileSource* mapped = FileSourceFactory::NewMapped();
+    RunDirect(nullptr, *stream); // warm page cache
+    Log::Print("Local file read benchmark (%u passes of %.*s)\n", iPasses, PBUF(iPath));
+    Log::Print("%-20s %10s %12s\n", "reader", "MB/s", "cpu us/MB");
+    RunSrs("stream/Srs", *stream);
+    RunDirect("stream/direct", *stream);
+    if (mapped != nullptr) {
+        RunDirect("mapped/direct", *mapped);
+    }
+    delete mapped;
+    delete stream;
+}
+
+void Bench::RunSrs(const TChar* aName, IFileSource& aSource)
+{
+    TUint64 bytes = 0;
+    const std::clock_t cpuStart = std::clock();
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iPasses; i++) {
+        aSource.Open((const TChar*)iPath.Ptr());
+        aSource.Interrupt(false);
+        Srs<kReadBufferBytes> reader(aSource);
+        try {
+            for (;;) {
+                Brn buf = reader.Read(iAudio.MaxBytes() - iAudio.Bytes());
+                iAudio.Append(buf);
+                bytes += buf.Bytes();
+                if (iAudio.Bytes() == iAudio.MaxBytes()) {
+                    iAudio.SetBytes(0);
+                }
+            }
+        }
+        catch (ReaderError&) {
+        }
+        aSource.Close();
+    }
+    Report(aName, bytes, OsTimeInUs(iEnv.OsCtx()) - start, std::clock() - cpuStart);
+}
+
+void Bench::RunDirect(const TChar* aName, IFileSource& aSource)
+{
+    TUint64 bytes = 0;
+    const std::clock_t cpuStart = std::clock();
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iPasses; i++) {
+        aSource.Open((const TChar*)iPath.Ptr());
+        aSource.Interrupt(false);
+        ReaderBufferDirect reader(kReadBufferBytes, aSource);
+        try {
+            for (;;) {
+                const TUint prevBytes = iAudio.Bytes();
+                reader.ReadDirect(iAudio);
+                bytes += iAudio.Bytes() - prevBytes;
+                if (iAudio.Bytes() == iAudio.MaxBytes()) {
+                    iAudio.SetBytes(0);
+                }
+            }
+        }
+        catch (ReaderError&) {
+        }
+        aSource.Close();
+        if (aName == nullptr) {
+            break;
+        }
+    }
+    if (aName != nullptr) {
+        Report(aName, bytes, OsTimeInUs(iEnv.OsCtx()) - start, std::clock() - cpuStart);
+    }
+}
+
+void Bench::Report(const TChar* aName, TUint64 aBytes, TUint64 aUs, std::clock_t aCpuTicks)
+{
+    const TUint64 mb = aBytes / (1024 * 1024);
+    const TUint64 mbPerSec = (aUs == 0? 0 : (aBytes * 1000000) / (aUs * 1024 * 1024));
+    const TUint64 cpuUs = ((TUint64)aCpuTicks * 1000000) / CLOCKS_PER_SEC;
+    Log::Print("%-20s %10llu %12llu\n", aName, mbPerSec, (mb == 0? 0 : cpuUs / mb));
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionString optionFile("-f", "--file", Brn(""), "file to read");
+    parser.AddOption(&optionFile);
+    OptionUint optionPasses("-p", "--passes", 5, "number of times the file is read by each reader");
+    parser.AddOption(&optionPasses);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+    if (optionFile.Value().Bytes() == 0) {
+        Log::Print("--file must be specified\n");
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionFile.Value(), optionPasses.Value());
+    try {
+        bench->Run();
+    }
+    catch (FileOpenError&) {
+        Log::Print("Unable to open %.*s\n", PBUF(optionFile.Value()));
+    }
+    delete bench;
+    delete lib;
+}
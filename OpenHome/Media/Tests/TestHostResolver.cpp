@@ -0,0 +1,359 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/Protocol/HostResolver.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Arch.h>
+#include <OpenHome/Functor.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+namespace TestHostResolver {
+
+/*
+ * Stands in for a DNS server.  Hosts starting "unknown" fail to resolve; all others
+ * resolve to kAddress1 and kAddress2.  Lookups can optionally be held until Release().
+ */
+class StubHostLookup : public IHostLookup, private INonCopyable
+{
+public:
+    static const TIpAddress kAddress1 = 0x0100007f;
+    static const TIpAddress kAddress2 = 0x0200007f;
+public:
+    StubHostLookup();
+    void SetBlocking(TBool aBlock);
+    void WaitForLookup();
+    void Release();
+    TUint Lookups() const;
+public: // from IHostLookup
+    void Lookup(const Brx& aHost, std::vector<TIpAddress>& aAddresses) override;
+private:
+    mutable Mutex iLock;
+    Semaphore iSemEntered;
+    Semaphore iSemRelease;
+    TBool iBlock;
+    TUint iLookups;
+};
+
+class SuiteHostResolver : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kPositiveTtlMs = 200;
+    static const TUint kNegativeTtlMs = 100;
+public:
+    SuiteHostResolver(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void ResolveOnThread();
+    void ResolveSlowOnThread();
+    void InterruptClient();
+    TBool TryResolve(const Brx& aHost);
+    void TestResolveReturnsAllAddresses();
+    void TestCachedWithinTtl();
+    void TestExpiresAfterTtl();
+    void TestFailureCachedWithinNegativeTtl();
+    void TestConcurrentRequestsShareLookup();
+    void TestInterruptCancelsWait();
+    void TestInterruptedClientFailsImmediately();
+    void TestLeastRecentlyUsedEvicted();
+    void TestNumericHostNotLookedUp();
+    void TestSlowLookupDoesntBlockOtherHosts();
+private:
+    Environment& iEnv;
+    StubHostLookup* iLookup;
+    HostResolver* iResolver;
+    HostResolverClient* iClient;
+    std::vector<TIpAddress> iAddresses;
+    TBool iThreadResolved;
+};
+
+} // namespace TestHostResolver
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestHostResolver;
+
+
+// StubHostLookup
+
+StubHostLookup::StubHostLookup()
+    : iLock("SHLK")
+    , iSemEntered("SHL1", 0)
+    , iSemRelease("SHL2", 0)
+    , iBlock(false)
+    , iLookups(0)
+{
+}
+
+void StubHostLookup::SetBlocking(TBool aBlock)
+{
+    AutoMutex _(iLock);
+    iBlock = aBlock;
+}
+
+void StubHostLookup::WaitForLookup()
+{
+    iSemEntered.Wait();
+}
+
+void StubHostLookup::Release()
+{
+    iSemRelease.Signal();
+}
+
+TUint StubHostLookup::Lookups() const
+{
+    AutoMutex _(iLock);
+    return iLookups;
+}
+
+void StubHostLookup::Lookup(const Brx& aHost, std::vector<TIpAddress>& aAddresses)
+{
+    iLock.Wait();
+    iLookups++;
+    const TBool block = iBlock;
+    iLock.Signal();
+    if (block) {
+        iSemEntered.Signal();
+        iSemRelease.Wait();
+    }
+    if (aHost.BeginsWith(Brn("unknown"))) {
+        THROW(NetworkError);
+    }
+    aAddresses.push_back(kAddress1);
+    aAddresses.push_back(kAddress2);
+}
+
+
+// SuiteHostResolver
+
+SuiteHostResolver::SuiteHostResolver(Environment& aEnv)
+    : SuiteUnitTest("HostResolver")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestResolveReturnsAllAddresses), "TestResolveReturnsAllAddresses");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestCachedWithinTtl), "TestCachedWithinTtl");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestExpiresAfterTtl), "TestExpiresAfterTtl");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestFailureCachedWithinNegativeTtl), "TestFailureCachedWithinNegativeTtl");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestConcurrentRequestsShareLookup), "TestConcurrentRequestsShareLookup");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestInterruptCancelsWait), "TestInterruptCancelsWait");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestInterruptedClientFailsImmediately), "TestInterruptedClientFailsImmediately");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestLeastRecentlyUsedEvicted), "TestLeastRecentlyUsedEvicted");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestNumericHostNotLookedUp), "TestNumericHostNotLookedUp");
+    AddTest(MakeFunctor(*this, &SuiteHostResolver::TestSlowLookupDoesntBlockOtherHosts), "TestSlowLookupDoesntBlockOtherHosts");
+}
+
+void SuiteHostResolver::Setup()
+{
+    iLookup = new StubHostLookup();
+    iResolver = new HostResolver(iEnv, *iLookup, kPositiveTtlMs, kNegativeTtlMs);
+    iClient = new HostResolverClient();
+    iAddresses.clear();
+    iThreadResolved = false;
+}
+
+void SuiteHostResolver::TearDown()
+{
+    delete iClient;
+    delete iResolver;
+    delete iLookup;
+}
+
+void SuiteHostResolver::InterruptClient()
+{
+    Thread::Sleep(50); // allow main thread to block in Resolve()
+    iClient->Interrupt(true);
+}
+
+void SuiteHostResolver::ResolveOnThread()
+{
+    HostResolverClient client;
+    std::vector<TIpAddress> addresses;
+    try {
+        iResolver->Resolve(client, Brn("www.example.com"), addresses);
+        iThreadResolved = (addresses.size() == 2);
+    }
+    catch (NetworkError&) {
+    }
+}
+
+void SuiteHostResolver::ResolveSlowOnThread()
+{
+    HostResolverClient client;
+    std::vector<TIpAddress> addresses;
+    try {
+        iResolver->Resolve(client, Brn("slow.example.com"), addresses);
+        iThreadResolved = (addresses.size() == 2);
+    }
+    catch (NetworkError&) {
+    }
+}
+
+TBool SuiteHostResolver::TryResolve(const Brx& aHost)
+{
+    try {
+        iResolver->Resolve(*iClient, aHost, iAddresses);
+        return true;
+    }
+    catch (NetworkError&) {
+        return false;
+    }
+}
+
+void SuiteHostResolver::TestResolveReturnsAllAddresses()
+{
+    TEST(TryResolve(Brn("www.example.com")));
+    TEST(iAddresses.size() == 2);
+    TEST(iAddresses[0] == StubHostLookup::kAddress1);
+    TEST(iAddresses[1] == StubHostLookup::kAddress2);
+    TEST(iLookup->Lookups() == 1);
+    const HostResolverStats stats = iResolver->Stats();
+    TEST(stats.iMisses == 1);
+    TEST(stats.iLookups == 1);
+    TEST(stats.iLookupFailures == 0);
+}
+
+void SuiteHostResolver::TestCachedWithinTtl()
+{
+    TEST(TryResolve(Brn("www.example.com")));
+    iAddresses.clear();
+    TEST(TryResolve(Brn("www.example.com")));
+    TEST(iAddresses.size() == 2);
+    TEST(iLookup->Lookups() == 1);
+    TEST(iResolver->Stats().iHits == 1);
+}
+
+void SuiteHostResolver::TestExpiresAfterTtl()
+{
+    TEST(TryResolve(Brn("www.example.com")));
+    Thread::Sleep(kPositiveTtlMs + 50);
+    TEST(TryResolve(Brn("www.example.com")));
+    TEST(iLookup->Lookups() == 2);
+    TEST(iResolver->Stats().iHits == 0);
+}
+
+void SuiteHostResolver::TestFailureCachedWithinNegativeTtl()
+{
+    TEST(!TryResolve(Brn("unknown.example.com")));
+    TEST(!TryResolve(Brn("unknown.example.com")));
+    TEST(iLookup->Lookups() == 1);
+    HostResolverStats stats = iResolver->Stats();
+    TEST(stats.iNegativeHits == 1);
+    TEST(stats.iLookupFailures == 1);
+    Thread::Sleep(kNegativeTtlMs + 50);
+    TEST(!TryResolve(Brn("unknown.example.com")));
+    TEST(iLookup->Lookups() == 2);
+}
+
+void SuiteHostResolver::TestConcurrentRequestsShareLookup()
+{
+    iLookup->SetBlocking(true);
+    ThreadFunctor* th = new ThreadFunctor("HRT1", MakeFunctor(*this, &SuiteHostResolver::ResolveOnThread));
+    th->Start();
+    iLookup->WaitForLookup();
+    iLookup->SetBlocking(false);
+    ThreadFunctor* th2 = new ThreadFunctor("HRT2", MakeFunctor(*this, &SuiteHostResolver::ResolveOnThread));
+    th2->Start();
+    Thread::Sleep(50); // allow th2 to start waiting on the in-progress lookup
+    iLookup->Release();
+    TEST(TryResolve(Brn("www.example.com")));
+    delete th2;
+    delete th;
+    TEST(iThreadResolved);
+    TEST(iLookup->Lookups() == 1);
+}
+
+void SuiteHostResolver::TestInterruptCancelsWait()
+{
+    iLookup->SetBlocking(true);
+    ThreadFunctor* th = new ThreadFunctor("HRT1", MakeFunctor(*this, &SuiteHostResolver::ResolveOnThread));
+    th->Start();
+    iLookup->WaitForLookup();
+    ThreadFunctor* interrupter = new ThreadFunctor("HRT2", MakeFunctor(*this, &SuiteHostResolver::InterruptClient));
+    interrupter->Start();
+    TEST(!TryResolve(Brn("www.example.com")));
+    TEST(iResolver->Stats().iInterrupts == 1);
+    delete interrupter;
+
+    // lookup completes for the uninterrupted caller and is cached for the next
+    iLookup->Release();
+    delete th;
+    TEST(iThreadResolved);
+    iClient->Interrupt(false);
+    TEST(TryResolve(Brn("www.example.com")));
+    TEST(iLookup->Lookups() == 1);
+}
+
+void SuiteHostResolver::TestInterruptedClientFailsImmediately()
+{
+    iClient->Interrupt(true);
+    TEST(!TryResolve(Brn("www.example.com")));
+    TEST(iLookup->Lookups() == 0);
+    iClient->Interrupt(false);
+    TEST(TryResolve(Brn("www.example.com")));
+}
+
+void SuiteHostResolver::TestLeastRecentlyUsedEvicted()
+{
+    Bws<32> host;
+    for (TUint i=0; i<HostResolver::kMaxEntries; i++) {
+        host.Replace("host");
+        Ascii::AppendDec(host, i);
+        TEST(TryResolve(host));
+    }
+    TEST(TryResolve(Brn("host0"))); // host1 is now least recently used
+    TEST(TryResolve(Brn("extra")));
+    const TUint lookups = iLookup->Lookups();
+    TEST(TryResolve(Brn("host0")));
+    TEST(iLookup->Lookups() == lookups);
+    TEST(TryResolve(Brn("host1")));
+    TEST(iLookup->Lookups() == lookups + 1);
+}
+
+void SuiteHostResolver::TestNumericHostNotLookedUp()
+{
+    TEST(TryResolve(Brn("192.168.1.10")));
+    TEST(iAddresses.size() == 1);
+    TEST(iAddresses[0] == Arch::BigEndian4(0xc0a8010a));
+    TEST(iLookup->Lookups() == 0);
+    TEST(iResolver->Stats().iMisses == 0);
+
+    // not a dotted quad so looked up as a name
+    TEST(TryResolve(Brn("192.168.1")));
+    TEST(TryResolve(Brn("192.168.1.256")));
+    TEST(TryResolve(Brn("1.2.3.4.example.com")));
+    TEST(iLookup->Lookups() == 3);
+}
+
+void SuiteHostResolver::TestSlowLookupDoesntBlockOtherHosts()
+{
+    iLookup->SetBlocking(true);
+    ThreadFunctor* th = new ThreadFunctor("HRT1", MakeFunctor(*this, &SuiteHostResolver::ResolveSlowOnThread));
+    th->Start();
+    iLookup->WaitForLookup();
+    iLookup->SetBlocking(false);
+    TEST(TryResolve(Brn("www.example.com")));
+    TEST(!iThreadResolved);
+    iLookup->Release();
+    delete th;
+    TEST(iThreadResolved);
+    TEST(iLookup->Lookups() == 2);
+}
+
+
+
+void TestHostResolver(Environment& aEnv)
+{
+    Runner runner("HostResolver tests\n");
+    runner.Add(new SuiteHostResolver(aEnv));
+    runner.Run();
+}
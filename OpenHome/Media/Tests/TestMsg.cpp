@@ -3,6 +3,7 @@
 #include <OpenHome/Media/Pipeline/RampArray.h>
 #include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
 #include <OpenHome/Media/Utils/ProcessorPcmUtils.h>
+#include <OpenHome/Private/Thread.h>
 
 #include <string.h>
 #include <vector>
@@ -24,6 +25,19 @@ private:
     AllocatorInfoLogger iInfoAggregator;
 };
 
+class SuiteAllocatorElastic : public Suite
+{
+public:
+    SuiteAllocatorElastic();
+    void Test() override;
+private:
+    void TestGrowAndShrink();
+    void TestBudget();
+    void TestBudgetBelowWorstCase();
+private:
+    AllocatorInfoLogger iInfoAggregator;
+};
+
 class TestCell : public Allocated
 {
 public:
@@ -287,6 +301,22 @@ private:
     AllocatorInfoLogger iInfoAggregator;
 };
 
+class SuiteMsgQueueSpsc : public Suite
+{
+    static const TUint kMsgCount = 64;
+    static const TUint kQueueMsgs = 3; // deliberately not a power of two
+public:
+    SuiteMsgQueueSpsc();
+    ~SuiteMsgQueueSpsc();
+    void Test() override;
+private:
+    void ProducerThread();
+private:
+    MsgFactory* iMsgFactory;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgQueueSpsc* iQueue;
+};
+
 class SuiteMsgReservoir : public Suite
 {
     static const TUint kMsgCount = 8;
@@ -484,6 +514,137 @@ void SuiteAllocator::Test()
 }
 
 
+// SuiteAllocatorElastic
+
+SuiteAllocatorElastic::SuiteAllocatorElastic()
+    : Suite("Elastic allocator tests")
+{
+}
+
+void SuiteAllocatorElastic::Test()
+{
+    TestGrowAndShrink();
+    TestBudget();
+    TestBudgetBelowWorstCase();
+}
+
+void SuiteAllocatorElastic::TestGrowAndShrink()
+{
+    static const TUint kMinCells = 2;
+    const TUint maxCells = (AllocatorBase::kGrowBytes / sizeof(TestCell)) * 3;
+    Allocator<TestCell>* allocator = new Allocator<TestCell>("TestCellElastic", kMinCells, maxCells, nullptr, iInfoAggregator);
+    const TUint cellsPerGrow = AllocatorBase::kGrowBytes / allocator->CellBytes();
+    TEST(allocator->CellsTotal() == kMinCells);
+
+    std::vector<TestCell*> cells;
+    for (TUint i=0; i<kMinCells; i++) {
+        cells.push_back(allocator->Allocate());
+    }
+    TEST(allocator->CellsTotal() == kMinCells);
+    // allocating beyond the initial cells grows by a page of cells at a time
+    cells.push_back(allocator->Allocate());
+    TEST(allocator->CellsTotal() == kMinCells + cellsPerGrow);
+    while (cells.size() < maxCells) {
+        cells.push_back(allocator->Allocate());
+    }
+    TEST(allocator->CellsTotal() == maxCells);
+    TEST(allocator->CellsUsed() == maxCells);
+    TEST_THROWS(allocator->Allocate(), AssertionFailed);
+    iInfoAggregator.PrintStats();
+
+    // cells aren't released until a good proportion are unused...
+    cells.back()->RemoveRef();
+    cells.pop_back();
+    TEST(allocator->CellsTotal() == maxCells);
+    // ...but are once they all are, never dropping below the minimum
+    for (auto cell : cells) {
+        cell->RemoveRef();
+    }
+    cells.clear();
+    TEST(allocator->CellsTotal() < maxCells);
+    TEST(allocator->CellsTotal() >= kMinCells);
+    TEST(allocator->CellsUsedMax() == maxCells);
+
+    // cells freed on shrinking can be recreated
+    while (cells.size() < maxCells) {
+        cells.push_back(allocator->Allocate());
+    }
+    TEST(allocator->CellsTotal() == maxCells);
+    for (auto cell : cells) {
+        cell->RemoveRef();
+    }
+    delete allocator;
+}
+
+void SuiteAllocatorElastic::TestBudget()
+{
+    static const TUint kDataBytes = AllocatorBase::kGrowBytes; // so cells are added one at a time
+    static const TUint kBudgetCells = 3;
+    static const TUint kMaxCells = 10;
+    static const TUint kCellBytes = sizeof(AudioData) + kDataBytes;
+    AllocatorBudget budget(kBudgetCells * kCellBytes, iInfoAggregator);
+    AllocatorAudioData* allocator = new AllocatorAudioData("AudioDataElastic", 1, kMaxCells, kDataBytes, &budget,
+                                                         AllocatorBase::eBudgetOnDemand, iInfoAggregator);
+    TEST(budget.Reserved() == kCellBytes);
+
+    std::vector<AudioData*> cells;
+    for (TUint i=0; i<kBudgetCells; i++) {
+        AudioData* cell = allocator->TryAllocate();
+        TEST(cell != nullptr);
+        TEST(cell->MaxBytes() == kDataBytes);
+        cells.push_back(cell);
+    }
+    TEST(budget.Reserved() == kBudgetCells * kCellBytes);
+    // budget exhausted before kMaxCells reached
+    TEST(allocator->TryAllocate() == nullptr);
+    TEST(allocator->CellsTotal() == kBudgetCells);
+
+    for (auto cell : cells) {
+        cell->RemoveRef();
+    }
+    TEST(allocator->CellsTotal() < kBudgetCells);
+    TEST(budget.Reserved() == allocator->CellsTotal() * kCellBytes);
+    TEST(budget.ReservedMax() == kBudgetCells * kCellBytes);
+    delete allocator;
+    TEST(budget.Reserved() == 0);
+}
+
+void SuiteAllocatorElastic::TestBudgetBelowWorstCase()
+{
+    // a pool using Allocate() can always grow to its maximum, even if this exceeds the budget
+    static const TUint kDataBytes = AllocatorBase::kGrowBytes;
+    static const TUint kBudgetCells = 3;
+    static const TUint kMaxCells = 10;
+    static const TUint kCellBytes = sizeof(AudioData) + kDataBytes;
+    AllocatorBudget budget(kBudgetCells * kCellBytes, iInfoAggregator);
+    AllocatorAudioData* mandatory = new AllocatorAudioData("AudioDataMandatory", 1, kMaxCells, kDataBytes, &budget,
+                                                           AllocatorBase::eBudgetReserveMax, iInfoAggregator);
+    TEST(budget.Reserved() == kMaxCells * kCellBytes);
+    TEST(mandatory->CellsTotal() == 1);
+    AllocatorAudioData* optional = new AllocatorAudioData("AudioDataOptional", 0, kMaxCells, kDataBytes, &budget,
+                                                          AllocatorBase::eBudgetOnDemand, iInfoAggregator);
+
+    std::vector<AudioData*> cells;
+    for (TUint i=0; i<kMaxCells; i++) {
+        cells.push_back(mandatory->Allocate());
+    }
+    TEST(mandatory->CellsTotal() == kMaxCells);
+    TEST(budget.Reserved() == kMaxCells * kCellBytes);
+    TEST_THROWS(mandatory->Allocate(), AssertionFailed);
+    // ...leaving nothing for best effort pools
+    TEST(optional->TryAllocate() == nullptr);
+
+    for (auto cell : cells) {
+        cell->RemoveRef();
+    }
+    TEST(mandatory->CellsTotal() < kMaxCells);
+    TEST(budget.Reserved() == kMaxCells * kCellBytes);
+    delete optional;
+    delete mandatory;
+    TEST(budget.Reserved() == 0);
+}
+
+
 // SuiteMsgAudioEncoded
 
 SuiteMsgAudioEncoded::SuiteMsgAudioEncoded()
@@ -2747,6 +2908,110 @@ void SuiteMsgQueueLite::Test()
 }
 
 
+// SuiteMsgQueueSpsc
+
+SuiteMsgQueueSpsc::SuiteMsgQueueSpsc()
+    : Suite("MsgQueueSpsc tests")
+    , iQueue(nullptr)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgFlushCount(kMsgCount);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+}
+
+SuiteMsgQueueSpsc::~SuiteMsgQueueSpsc()
+{
+    delete iMsgFactory;
+}
+
+void SuiteMsgQueueSpsc::Test()
+{
+    // capacity is exactly as requested, not rounded up to the ring's power of two size
+    iQueue = new MsgQueueSpsc(kQueueMsgs);
+    TEST(iQueue->MaxMsgs() == kQueueMsgs);
+
+    // queue is fifo
+    TEST(iQueue->IsEmpty());
+    for (TUint i=0; i<kQueueMsgs; i++) {
+        TEST(iQueue->TryEnqueue(iMsgFactory->CreateMsgFlush(i+1)));
+    }
+    TEST(iQueue->NumMsgs() == kQueueMsgs);
+    TEST(!iQueue->IsEmpty());
+
+    // full queue rejects TryEnqueue without taking ownership of msg
+    Msg* msg = iMsgFactory->CreateMsgFlush(kQueueMsgs+1);
+    TEST(!iQueue->TryEnqueue(msg));
+    msg->RemoveRef();
+    for (TUint i=0; i<kQueueMsgs; i++) {
+        auto flush = static_cast<MsgFlush*>(iQueue->Dequeue());
+        TEST(flush->Id() == i+1);
+        flush->RemoveRef();
+    }
+    TEST(iQueue->IsEmpty());
+
+    // batch dequeue returns all available msgs, up to the limit requested, in order
+    for (TUint i=0; i<3; i++) {
+        iQueue->Enqueue(iMsgFactory->CreateMsgFlush(i+1));
+    }
+    Msg* msgs[kQueueMsgs];
+    TUint count = iQueue->DequeueBatch(msgs, 2);
+    TEST(count == 2);
+    TEST(static_cast<MsgFlush*>(msgs[0])->Id() == 1);
+    TEST(static_cast<MsgFlush*>(msgs[1])->Id() == 2);
+    msgs[0]->RemoveRef();
+    msgs[1]->RemoveRef();
+    count = iQueue->DequeueBatch(msgs, kQueueMsgs);
+    TEST(count == 1);
+    TEST(static_cast<MsgFlush*>(msgs[0])->Id() == 3);
+    msgs[0]->RemoveRef();
+    TEST(iQueue->IsEmpty());
+
+    // indexes wrap correctly
+    for (TUint i=0; i<kMsgCount; i++) {
+        iQueue->Enqueue(iMsgFactory->CreateMsgFlush(i+1));
+        auto flush = static_cast<MsgFlush*>(iQueue->Dequeue());
+        TEST(flush->Id() == i+1);
+        flush->RemoveRef();
+    }
+
+    // Clear() releases any queued msgs
+    iQueue->Enqueue(iMsgFactory->CreateMsgFlush(1));
+    iQueue->Enqueue(iMsgFactory->CreateMsgFlush(2));
+    iQueue->Clear();
+    TEST(iQueue->IsEmpty());
+    delete iQueue;
+
+    // producer blocks rather than asserting when consumer falls behind; all msgs delivered in order
+    iQueue = new MsgQueueSpsc(kQueueMsgs, MsgQueueSpsc::EOverflow::Block);
+    ThreadFunctor* producer = new ThreadFunctor("MQSP", MakeFunctor(*this, &SuiteMsgQueueSpsc::ProducerThread));
+    producer->Start();
+    TUint expected = 1;
+    while (expected <= kMsgCount) {
+        if (expected % 8 == 0) {
+            Thread::Sleep(1); // let the producer fill the queue
+        }
+        count = iQueue->DequeueBatch(msgs, kQueueMsgs);
+        TEST(count > 0 && count <= kQueueMsgs);
+        for (TUint i=0; i<count; i++) {
+            TEST(static_cast<MsgFlush*>(msgs[i])->Id() == expected);
+            expected++;
+            msgs[i]->RemoveRef();
+        }
+    }
+    delete producer;
+    TEST(iQueue->IsEmpty());
+    delete iQueue;
+    iQueue = nullptr;
+}
+
+void SuiteMsgQueueSpsc::ProducerThread()
+{
+    for (TUint i=0; i<kMsgCount; i++) {
+        iQueue->Enqueue(iMsgFactory->CreateMsgFlush(i+1));
+    }
+}
+
+
 // SuiteMsgReservoir
 
 SuiteMsgReservoir::SuiteMsgReservoir()
@@ -3286,6 +3551,7 @@ void TestMsg()
 {
     Runner runner("Basic Msg tests\n");
     runner.Add(new SuiteAllocator());
+    runner.Add(new SuiteAllocatorElastic());
     runner.Add(new SuiteMsgAudioEncoded());
     runner.Add(new SuiteRamp());
     runner.Add(new SuiteMsgAudio());
@@ -3301,6 +3567,7 @@ void TestMsg()
     runner.Add(new SuiteMsgProcessor());
     runner.Add(new SuiteMsgQueue());
     runner.Add(new SuiteMsgQueueLite());
+    runner.Add(new SuiteMsgQueueSpsc());
     runner.Add(new SuiteMsgReservoir());
     runner.Add(new SuitePipelineElement());
     runner.Run();
@@ -0,0 +1,254 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Compares MsgQueue (mutex + semaphore per msg) with MsgQueueSpsc for a
+    single producer/single consumer hand-off.
+    - throughput: one thread allocates and enqueues msgs as fast as it can, another
+      dequeues (singly or in batches) and frees them
+    - latency: a msg is bounced between two threads via a pair of queues; half the
+      round trip time is reported
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestMsgQueuePerf {
+
+class IQueue
+{
+public:
+    virtual void Enqueue(Msg* aMsg) = 0;
+    virtual TUint DequeueBatch(Msg** aMsgs, TUint aMaxMsgs) = 0;
+    virtual ~IQueue() {}
+};
+
+class QueueLocked : public IQueue
+{
+public: // from IQueue
+    void Enqueue(Msg* aMsg) override;
+    TUint DequeueBatch(Msg** aMsgs, TUint aMaxMsgs) override;
+private:
+    MsgQueue iQueue;
+};
+
+class QueueSpsc : public IQueue
+{
+public:
+    QueueSpsc(TUint aMaxMsgs);
+public: // from IQueue
+    void Enqueue(Msg* aMsg) override;
+    TUint DequeueBatch(Msg** aMsgs, TUint aMaxMsgs) override;
+private:
+    MsgQueueSpsc iQueue;
+};
+
+class Bench : private INonCopyable
+{
+    static const TUint kMaxQueueMsgs = 256;
+    static const TUint kMaxBatch = 16;
+public:
+    Bench(Environment& aEnv, TUint aMsgs, TUint aRoundTrips);
+    ~Bench();
+    void Run();
+private:
+    void Throughput(const TChar* aName, IQueue& aQueue, TUint aBatch);
+    void Latency(const TChar* aName, IQueue& aForward, IQueue& aBack);
+    void Producer();
+    void Echo();
+private:
+    Environment& iEnv;
+    const TUint iMsgs;
+    const TUint iRoundTrips;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    IQueue* iQueue;
+    IQueue* iQueueBack;
+};
+
+} // namespace TestMsgQueuePerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestMsgQueuePerf;
+
+
+// QueueLocked
+
+void QueueLocked::Enqueue(Msg* aMsg)
+{
+    iQueue.Enqueue(aMsg);
+}
+
+TUint QueueLocked::DequeueBatch(Msg** aMsgs, TUint /*aMaxMsgs*/)
+{
+    aMsgs[0] = iQueue.Dequeue();
+    return 1;
+}
+
+
+// QueueSpsc
+
+QueueSpsc::QueueSpsc(TUint aMaxMsgs)
+    : iQueue(aMaxMsgs, MsgQueueSpsc::EOverflow::Block)
+{
+}
+
+void QueueSpsc::Enqueue(Msg* aMsg)
+{
+    iQueue.Enqueue(aMsg);
+}
+
+TUint QueueSpsc::DequeueBatch(Msg** aMsgs, TUint aMaxMsgs)
+{
+    return iQueue.DequeueBatch(aMsgs, aMaxMsgs);
+}
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, TUint aMsgs, TUint aRoundTrips)
+    : iEnv(aEnv)
+    , iMsgs(aMsgs)
+    , iRoundTrips(aRoundTrips)
+    , iQueue(nullptr)
+    , iQueueBack(nullptr)
+{
+    MsgFactoryInitParams init;
+    init.SetMsgFlushCount(kMaxQueueMsgs + kMaxBatch + 1);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+}
+
+Bench::~Bench()
+{
+    delete iMsgFactory;
+}
+
+void Bench::Run()
+{
+    Log::Print("MsgQueue benchmark (%u msgs, %u round trips)\n", iMsgs, iRoundTrips);
+    Log::Print("%-28s %14s\n", "throughput", "msgs/s");
+    {
+        QueueLocked queue;
+        Throughput("MsgQueue", queue, 1);
+    }
+    {
+        QueueSpsc queue(kMaxQueueMsgs);
+        Throughput("MsgQueueSpsc", queue, 1);
+    }
+    {
+        QueueSpsc queue(kMaxQueueMsgs);
+        Throughput("MsgQueueSpsc (batch 16)", queue, kMaxBatch);
+    }
+    Log::Print("%-28s %14s %14s\n", "latency", "mean(ns)", "max(ns)");
+    {
+        QueueLocked forward;
+        QueueLocked back;
+        Latency("MsgQueue", forward, back);
+    }
+    {
+        QueueSpsc forward(kMaxQueueMsgs);
+        QueueSpsc back(kMaxQueueMsgs);
+        Latency("MsgQueueSpsc", forward, back);
+    }
+}
+
+void Bench::Throughput(const TChar* aName, IQueue& aQueue, TUint aBatch)
+{
+    iQueue = &aQueue;
+    Msg* msgs[kMaxBatch];
+    ThreadFunctor* producer = new ThreadFunctor("MQPP", MakeFunctor(*this, &Bench::Producer));
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    producer->Start();
+    TUint remaining = iMsgs;
+    while (remaining > 0) {
+        const TUint count = aQueue.DequeueBatch(msgs, aBatch);
+        for (TUint i=0; i<count; i++) {
+            msgs[i]->RemoveRef();
+        }
+        remaining -= count;
+    }
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+    delete producer;
+    Log::Print("%-28s %14llu\n", aName, (us == 0? 0 : ((TUint64)iMsgs * 1000000) / us));
+    iQueue = nullptr;
+}
+
+void Bench::Latency(const TChar* aName, IQueue& aForward, IQueue& aBack)
+{
+    iQueue = &aForward;
+    iQueueBack = &aBack;
+    ThreadFunctor* echo = new ThreadFunctor("MQPE", MakeFunctor(*this, &Bench::Echo));
+    echo->Start();
+    Msg* msg = iMsgFactory->CreateMsgFlush(1);
+    TUint64 totalUs = 0;
+    TUint64 maxUs = 0;
+    for (TUint i=0; i<iRoundTrips; i++) {
+        const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+        aForward.Enqueue(msg);
+        (void)aBack.DequeueBatch(&msg, 1);
+        const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+        totalUs += us;
+        if (us > maxUs) {
+            maxUs = us;
+        }
+    }
+    aForward.Enqueue(iMsgFactory->CreateMsgQuit());
+    delete echo;
+    msg->RemoveRef();
+    Log::Print("%-28s %14llu %14llu\n", aName, (totalUs * 1000) / (2 * iRoundTrips), (maxUs * 1000) / 2);
+    iQueue = nullptr;
+    iQueueBack = nullptr;
+}
+
+void Bench::Producer()
+{
+    for (TUint i=0; i<iMsgs; i++) {
+        iQueue->Enqueue(iMsgFactory->CreateMsgFlush(i+1));
+    }
+}
+
+void Bench::Echo()
+{
+    Msg* msg;
+    for (TUint i=0; i<iRoundTrips; i++) {
+        (void)iQueue->DequeueBatch(&msg, 1);
+        iQueueBack->Enqueue(msg);
+    }
+    (void)iQueue->DequeueBatch(&msg, 1); // MsgQuit
+    msg->RemoveRef();
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionMsgs("-m", "--msgs", 1000000, "number of msgs passed in each throughput test");
+    parser.AddOption(&optionMsgs);
+    OptionUint optionRoundTrips("-r", "--roundtrips", 100000, "number of round trips in each latency test");
+    parser.AddOption(&optionRoundTrips);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionMsgs.Value(), optionRoundTrips.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
@@ -0,0 +1,614 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/PipelineManager.h>
+#include <OpenHome/Media/Pipeline/Pipeline.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Pipeline/AnalogBypassRamper.h>
+#include <OpenHome/Media/Pipeline/MuterVolume.h>
+#include <OpenHome/Media/Protocol/ProtocolFactory.h>
+#include <OpenHome/Media/Codec/CodecFactory.h>
+#include <OpenHome/Media/Codec/ContainerFactory.h>
+#include <OpenHome/Media/UriProviderSingleTrack.h>
+#include <OpenHome/Media/MimeTypeList.h>
+#include <OpenHome/Media/Tests/PerfUtils.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Parser.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <ctime>
+#include <vector>
+#ifdef __linux__
+# include <dirent.h>
+# include <stdio.h>
+# include <stdlib.h>
+# include <string.h>
+# include <unistd.h>
+# include <sys/resource.h>
+#endif
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Measures the throughput of a complete PipelineManager, fed by ProtocolTone (or
+    ProtocolFile for any additional uris) and drained by an animator that pulls as fast
+    as possible rather than pacing in real time.  Each format/uri is played once, using
+    a newly constructed pipeline.  For each run, reports as JSON:
+    - audio seconds output per wall clock and per CPU second (CPU for the whole process)
+    - CPU time and running samples for each thread.  The pipeline's elements are split
+      between a small number of threads (Filler: protocols; CodecController: containers,
+      codecs and the elements up to DecodedAudioReservoir; StarvationRamper: elements up
+      to StarvationRamper; PipelineAnimator: the remainder) so the per-thread figures
+      attribute cost to groups of elements.  Per thread stats are only available on Linux.
+    - peak usage of each allocator
+    - voluntary/involuntary context switches (Linux only)
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestPipelinePerf {
+
+class SinkAnimator : public PipelineElement, public IPipelineAnimator, private INonCopyable
+{
+    static const TUint kSupportedMsgTypes;
+public:
+    SinkAnimator(IPipeline& aPipeline);
+    ~SinkAnimator();
+    TBool WaitForEndOfTrack(TUint aTimeoutMs);
+    TUint64 Jiffies() const;
+    void GetStreamInfo(Bwx& aCodec, TUint& aSampleRate, TUint& aBitDepth, TUint& aChannels) const;
+private:
+    void Run();
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() override;
+    TUint PipelineAnimatorDelayJiffies(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) override;
+private:
+    IPipeline& iPipeline;
+    ThreadFunctor* iThread;
+    mutable Mutex iLock;
+    Semaphore iSemEndOfTrack;
+    TUint64 iJiffies;
+    Bws<32> iCodec;
+    TUint iSampleRate;
+    TUint iBitDepth;
+    TUint iChannels;
+    TBool iQuit;
+};
+
+class ThreadSampler : private INonCopyable
+{
+    static const TUint kMaxNameBytes = 16;
+public:
+    ThreadSampler(TUint aPeriodMs);
+    ~ThreadSampler();
+    void Start();
+    void Stop();
+    void Print() const;
+private:
+    void Run();
+    void Sample(TBool aAccumulate);
+private:
+    class Stats
+    {
+    public:
+        TUint iTid;
+        TChar iName[kMaxNameBytes + 1];
+        TUint64 iTicksLast;
+        TUint64 iTicks;
+        TUint iSamples;
+        TUint iSamplesRunning;
+    };
+private:
+    const TUint iPeriodMs;
+    ThreadFunctor* iThread;
+    Semaphore iSem;
+    TBool iStop;
+    std::vector<Stats> iStats;
+};
+
+class Bench : private IAnalogBypassVolumeRamper, private INonCopyable
+{
+    static const TChar* kMode;
+    static const TChar* kIndent;
+    static const TUint kTrackCount = 4;
+public:
+    Bench(Environment& aEnv, TUint aSeconds, TUint aPeriodMs, TUint aTimeoutSecs, TUint aWindowMs);
+    void Run(const Brx& aFormats, const Brx& aUris);
+private:
+    void RunTone(const Brx& aFormat);
+    void RunUri(const Brx& aUri);
+    static TBool GetContextSwitches(TUint64& aVoluntary, TUint64& aInvoluntary);
+private: // from IAnalogBypassVolumeRamper
+    void ApplyVolumeMultiplier(TUint aValue) override;
+private:
+    Environment& iEnv;
+    const TUint iSeconds;
+    const TUint iPeriodMs;
+    const TUint iTimeoutMs;
+    const TUint iWindowMs;
+    TBool iFirstRun;
+    VolumeRamperStub iVolumeRamper;
+};
+
+} // namespace TestPipelinePerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestPipelinePerf;
+
+
+// SinkAnimator
+
+const TUint SinkAnimator::kSupportedMsgTypes =   eMode
+                                               | eDrain
+                                               | eHalt
+                                               | eDecodedStream
+                                               | ePlayable
+                                               | eQuit;
+
+SinkAnimator::SinkAnimator(IPipeline& aPipeline)
+    : PipelineElement(kSupportedMsgTypes)
+    , iPipeline(aPipeline)
+    , iLock("SNKA")
+    , iSemEndOfTrack("SNKE", 0)
+    , iJiffies(0)
+    , iSampleRate(0)
+    , iBitDepth(0)
+    , iChannels(0)
+    , iQuit(false)
+{
+    iPipeline.SetAnimator(*this);
+    iThread = new ThreadFunctor("PipelineAnimator", MakeFunctor(*this, &SinkAnimator::Run), kPrioritySystemHighest);
+    iThread->Start();
+}
+
+SinkAnimator::~SinkAnimator()
+{
+    delete iThread;
+}
+
+TBool SinkAnimator::WaitForEndOfTrack(TUint aTimeoutMs)
+{
+    try {
+        iSemEndOfTrack.Wait(aTimeoutMs);
+    }
+    catch (Timeout&) {
+        return false;
+    }
+    return true;
+}
+
+TUint64 SinkAnimator::Jiffies() const
+{
+    AutoMutex _(iLock);
+    return iJiffies;
+}
+
+void SinkAnimator::GetStreamInfo(Bwx& aCodec, TUint& aSampleRate, TUint& aBitDepth, TUint& aChannels) const
+{
+    AutoMutex _(iLock);
+    aCodec.Replace(iCodec);
+    aSampleRate = iSampleRate;
+    aBitDepth = iBitDepth;
+    aChannels = iChannels;
+}
+
+void SinkAnimator::Run()
+{
+    while (!iQuit) {
+        Msg* msg = iPipeline.Pull();
+        msg = msg->Process(*this);
+        ASSERT(msg == nullptr);
+    }
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgMode* aMsg)
+{
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgDrain* aMsg)
+{
+    aMsg->ReportDrained();
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgHalt* aMsg)
+{
+    aMsg->ReportHalted();
+    aMsg->RemoveRef();
+    // the pipeline halts before the first track as well as at the end of each
+    if (Jiffies() > 0) {
+        iSemEndOfTrack.Signal();
+    }
+    return nullptr;
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    const DecodedStreamInfo& info = aMsg->StreamInfo();
+    {
+        AutoMutex _(iLock);
+        iCodec.Replace(info.CodecName());
+        iSampleRate = info.SampleRate();
+        iBitDepth = info.BitDepth();
+        iChannels = info.NumChannels();
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgPlayable* aMsg)
+{
+    {
+        AutoMutex _(iLock);
+        iJiffies += aMsg->Jiffies();
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* SinkAnimator::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuit = true;
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+TUint SinkAnimator::PipelineAnimatorBufferJiffies()
+{
+    return 0;
+}
+
+TUint SinkAnimator::PipelineAnimatorDelayJiffies(TUint /*aSampleRate*/, TUint /*aBitDepth*/, TUint /*aNumChannels*/)
+{
+    return 0;
+}
+
+
+// ThreadSampler
+
+ThreadSampler::ThreadSampler(TUint aPeriodMs)
+    : iPeriodMs(aPeriodMs)
+    , iThread(nullptr)
+    , iSem("TSMP", 0)
+    , iStop(false)
+{
+}
+
+ThreadSampler::~ThreadSampler()
+{
+    Stop();
+}
+
+void ThreadSampler::Start()
+{
+    ASSERT(iThread == nullptr);
+    iStats.clear();
+    iStop = false;
+    Sample(false);
+    iThread = new ThreadFunctor("PerfSampler", MakeFunctor(*this, &ThreadSampler::Run), kPriorityHigh);
+    iThread->Start();
+}
+
+void ThreadSampler::Stop()
+{
+    if (iThread == nullptr) {
+        return;
+    }
+    iStop = true;
+    iSem.Signal();
+    delete iThread;
+    iThread = nullptr;
+    Sample(true);
+}
+
+void ThreadSampler::Print() const
+{
+#ifdef __linux__
+    const TUint64 ticksPerSec = (TUint64)sysconf(_SC_CLK_TCK);
+#else
+    const TUint64 ticksPerSec = 1;
+#endif
+    Log::Print("      \"threads\": [");
+    for (TUint i=0; i<iStats.size(); i++) {
+        const Stats& stats = iStats[i];
+        Log::Print("%s\n        {\"tid\": %u, \"name\": \"%s\", \"cpu_ms\": %llu, \"samples\": %u, \"running_samples\": %u}",
+                   (i == 0? "" : ","), stats.iTid, stats.iName,
+                   (stats.iTicks * 1000) / ticksPerSec, stats.iSamples, stats.iSamplesRunning);
+    }
+    Log::Print("%s],\n", (iStats.size() == 0? "" : "\n      "));
+}
+
+void ThreadSampler::Run()
+{
+    while (!iStop) {
+        try {
+            iSem.Wait(iPeriodMs);
+        }
+        catch (Timeout&) {}
+        if (!iStop) {
+            Sample(true);
+        }
+    }
+}
+
+void ThreadSampler::Sample(TBool aAccumulate)
+{
+#ifdef __linux__
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        TChar path[64];
+        (void)snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) {
+            continue; // thread exited since readdir
+        }
+        TChar line[512];
+        const TBool read = (fgets(line, sizeof(line), file) != nullptr);
+        (void)fclose(file);
+        if (!read) {
+            continue;
+        }
+        // "tid (name) state ..." - name may contain spaces or brackets so search back for its end
+        TChar* nameStart = strchr(line, '(');
+        TChar* nameEnd = strrchr(line, ')');
+        if (nameStart == nullptr || nameEnd == nullptr || nameEnd < nameStart) {
+            continue;
+        }
+        TChar state;
+        unsigned long long utime, stime;
+        if (sscanf(nameEnd + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &state, &utime, &stime) != 3) {
+            continue;
+        }
+        const TUint tid = (TUint)strtoul(line, nullptr, 10);
+        const TUint64 ticks = utime + stime;
+        Stats* stats = nullptr;
+        for (TUint i=0; i<iStats.size(); i++) {
+            if (iStats[i].iTid == tid) {
+                stats = &iStats[i];
+                break;
+            }
+        }
+        if (stats == nullptr) {
+            Stats s;
+            s.iTid = tid;
+            TUint nameBytes = (TUint)(nameEnd - nameStart - 1);
+            if (nameBytes > kMaxNameBytes) {
+                nameBytes = kMaxNameBytes;
+            }
+            (void)memcpy(s.iName, nameStart + 1, nameBytes);
+            s.iName[nameBytes] = '\0';
+            // a thread which starts during the run has all of its CPU time attributed to the run
+            s.iTicksLast = (aAccumulate? 0 : ticks);
+            s.iTicks = 0;
+            s.iSamples = 0;
+            s.iSamplesRunning = 0;
+            iStats.push_back(s);
+            stats = &iStats[iStats.size() - 1];
+        }
+        if (aAccumulate) {
+            stats->iTicks += ticks - stats->iTicksLast;
+            stats->iTicksLast = ticks;
+            stats->iSamples++;
+            if (state == 'R') {
+                stats->iSamplesRunning++;
+            }
+        }
+    }
+    (void)closedir(dir);
+#else
+    (void)aAccumulate;
+#endif
+}
+
+
+// Bench
+
+const TChar* Bench::kMode = "PipelinePerf";
+const TChar* Bench::kIndent = "      ";
+
+Bench::Bench(Environment& aEnv, TUint aSeconds, TUint aPeriodMs, TUint aTimeoutSecs, TUint aWindowMs)
+    : iEnv(aEnv)
+    , iSeconds(aSeconds)
+    , iPeriodMs(aPeriodMs)
+    , iTimeoutMs(aTimeoutSecs * 1000)
+    , iWindowMs(aWindowMs)
+    , iFirstRun(true)
+{
+}
+
+void Bench::Run(const Brx& aFormats, const Brx& aUris)
+{
+    Log::Print("{\n  \"benchmark\": \"pipeline\",\n  \"tone_seconds\": %u,\n  \"aggregation_ms\": %u,\n  \"runs\": [", iSeconds, iWindowMs);
+    Parser formats(aFormats);
+    while (!formats.Finished()) {
+        const Brn format = Ascii::Trim(formats.Next(','));
+        if (format.Bytes() > 0) {
+            RunTone(format);
+        }
+    }
+    Parser uris(aUris);
+    while (!uris.Finished()) {
+        const Brn uri = Ascii::Trim(uris.Next(','));
+        if (uri.Bytes() > 0) {
+            RunUri(uri);
+        }
+    }
+    Log::Print("\n  ]\n}\n");
+}
+
+void Bench::RunTone(const Brx& aFormat)
+{
+    // aFormat is samplerate/bitdepth/channels
+    Parser parser(aFormat);
+    const Brn sampleRate = parser.Next('/');
+    const Brn bitDepth = parser.Next('/');
+    const Brn channels = parser.Remaining();
+    Bws<256> uri("tone://square.wav?bitdepth=");
+    uri.Append(bitDepth);
+    uri.Append("&samplerate=");
+    uri.Append(sampleRate);
+    uri.Append("&pitch=440&channels=");
+    uri.Append(channels);
+    uri.AppendPrintf("&duration=%u", iSeconds);
+    RunUri(uri);
+}
+
+void Bench::RunUri(const Brx& aUri)
+{
+    AllocatorStats allocatorStats;
+    MimeTypeList mimeTypes;
+    TrackFactory* trackFactory = new TrackFactory(allocatorStats, kTrackCount);
+    PipelineInitParams* initParams = PipelineInitParams::New();
+    initParams->SetAggregationWindows(iWindowMs, iWindowMs);
+    PipelineManager* pipeline = new PipelineManager(initParams, allocatorStats, *trackFactory);
+    pipeline->Add(Codec::ContainerFactory::NewId3v2());
+    pipeline->Add(Codec::ContainerFactory::NewMpeg4(mimeTypes));
+    pipeline->Add(Codec::ContainerFactory::NewMpegTs(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewAac(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewAdts(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewAifc(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewAiff(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewAlacApple(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewFlac(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewMp3(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewVorbis(mimeTypes));
+    pipeline->Add(Codec::CodecFactory::NewWav(mimeTypes));
+    pipeline->Add(ProtocolFactory::NewTone(iEnv));
+    pipeline->Add(ProtocolFactory::NewFile(iEnv));
+    UriProviderSingleTrack* uriProvider = new UriProviderSingleTrack(kMode, false, *trackFactory);
+    pipeline->Add(uriProvider); // transfers ownership
+    SinkAnimator* sink = new SinkAnimator(*pipeline);
+    pipeline->Start(*this, iVolumeRamper);
+    ThreadSampler sampler(iPeriodMs);
+
+    Track* track = uriProvider->SetTrack(aUri, Brx::Empty());
+    TUint64 csVoluntaryStart = 0, csInvoluntaryStart = 0;
+    (void)GetContextSwitches(csVoluntaryStart, csInvoluntaryStart);
+    sampler.Start();
+    const std::clock_t cpuStart = std::clock();
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    pipeline->Begin(Brn(kMode), track->Id());
+    track->RemoveRef();
+    pipeline->Play();
+    const TBool completed = sink->WaitForEndOfTrack(iTimeoutMs);
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+    const std::clock_t cpuTicks = std::clock() - cpuStart;
+    sampler.Stop();
+    TUint64 csVoluntary = 0, csInvoluntary = 0;
+    const TBool haveCs = GetContextSwitches(csVoluntary, csInvoluntary);
+
+    const TUint64 jiffies = sink->Jiffies();
+    const TUint64 audioMs = jiffies / Jiffies::kPerMs;
+    const TUint64 cpuUs = ((TUint64)cpuTicks * 1000000) / CLOCKS_PER_SEC;
+    Bws<32> codec;
+    TUint sampleRate, bitDepth, channels;
+    sink->GetStreamInfo(codec, sampleRate, bitDepth, channels);
+
+    Log::Print("%s\n    {\n", (iFirstRun? "" : ","));
+    iFirstRun = false;
+    Log::Print("      \"uri\": \"%.*s\",\n", PBUF(aUri));
+    Log::Print("      \"completed\": %s,\n", (completed? "true" : "false"));
+    Log::Print("      \"codec\": \"%.*s\",\n", PBUF(codec));
+    Log::Print("      \"sample_rate\": %u,\n      \"bit_depth\": %u,\n      \"channels\": %u,\n", sampleRate, bitDepth, channels);
+    PerfJson::PrintMilli(kIndent, "audio_seconds", audioMs);
+    PerfJson::PrintMilli(kIndent, "wall_seconds", us / 1000);
+    PerfJson::PrintMilli(kIndent, "cpu_seconds", cpuUs / 1000);
+    PerfJson::PrintMilli(kIndent, "audio_seconds_per_cpu_second", (cpuUs == 0? 0 : (audioMs * 1000000) / cpuUs));
+    PerfJson::PrintMilli(kIndent, "realtime_factor", (us == 0? 0 : (audioMs * 1000000) / us));
+    if (haveCs) {
+        Log::Print("      \"context_switches\": {\"voluntary\": %llu, \"involuntary\": %llu},\n",
+                   csVoluntary - csVoluntaryStart, csInvoluntary - csInvoluntaryStart);
+    }
+    else {
+        Log::Print("      \"context_switches\": null,\n");
+    }
+    sampler.Print();
+    allocatorStats.Capture();
+    allocatorStats.PrintJson(kIndent);
+    Log::Print("      \"sample_period_ms\": %u\n    }", iPeriodMs);
+
+    pipeline->Quit();
+    delete sink;
+    delete pipeline;
+    delete trackFactory;
+}
+
+TBool Bench::GetContextSwitches(TUint64& aVoluntary, TUint64& aInvoluntary)
+{ // static
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return false;
+    }
+    aVoluntary = (TUint64)usage.ru_nvcsw;
+    aInvoluntary = (TUint64)usage.ru_nivcsw;
+    return true;
+#else
+    aVoluntary = aInvoluntary = 0;
+    return false;
+#endif
+}
+
+void Bench::ApplyVolumeMultiplier(TUint /*aValue*/)
+{
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionSeconds("-s", "--seconds", 120, "seconds of audio generated for each tone format [1..900]");
+    parser.AddOption(&optionSeconds);
+    OptionString optionFormats("-f", "--formats", Brn("44100/16/2,48000/24/2,96000/24/2,192000/24/2,192000/24/8"),
+                               "comma separated tone formats (samplerate/bitdepth/channels)");
+    parser.AddOption(&optionFormats);
+    OptionString optionUris("-u", "--uris", Brn(""), "comma separated uris (e.g. file:///music/track.flac) played after the tones");
+    parser.AddOption(&optionUris);
+    OptionUint optionPeriod("-p", "--period", 10, "thread sampling period (ms)");
+    parser.AddOption(&optionPeriod);
+    OptionUint optionTimeout("-t", "--timeout", 600, "maximum duration (s) of each run");
+    parser.AddOption(&optionTimeout);
+    OptionUint optionWindow("-w", "--window", 5, "DecodedAudioAggregator window (ms) for all modes [5..100]");
+    parser.AddOption(&optionWindow);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+    if (optionSeconds.Value() == 0 || optionSeconds.Value() > 900 || optionPeriod.Value() == 0 ||
+        optionWindow.Value() < 5 || optionWindow.Value() > 100) {
+        Log::Print("--seconds must be in the range [1..900], --window in the range [5..100] and --period must be non-zero\n");
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionSeconds.Value(), optionPeriod.Value(), optionTimeout.Value(), optionWindow.Value());
+    bench->Run(optionFormats.Value(), optionUris.Value());
+    delete bench;
+    delete lib;
+}
@@ -0,0 +1,738 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Media/PrerollCache.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Protocol/Protocol.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Functor.h>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+namespace TestPrerollCache {
+
+/*
+ * Stands in for a ProtocolManager streaming a track over http.  DoStream() waits for
+ * kConnectMs (connection plus server response time) before outputting a stream of
+ * aTrackBytes of audio.
+ */
+class StandInUriStreamer : public IUriStreamer, private INonCopyable
+{
+public:
+    static const TUint kConnectMs = 300;
+    static const TUint kChunkBytes = 4096;
+public:
+    StandInUriStreamer(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TUint aTrackBytes);
+    TUint StreamCount() const;
+    TUint InterruptCount() const;
+    TUint64 BytesOutput() const;
+public: // from IUriStreamer
+    ProtocolStreamResult DoStream(Track& aTrack) override;
+    void Interrupt(TBool aInterrupt) override;
+private:
+    TBool Interrupted() const;
+private:
+    mutable Mutex iLock;
+    MsgFactory& iMsgFactory;
+    IPipelineElementDownstream& iDownstream;
+    const TUint iTrackBytes;
+    TUint iStreamCount;
+    TUint iInterruptCount;
+    TUint64 iBytesOutput;
+    TBool iInterrupted;
+    TUint iNextStreamId;
+};
+
+class RecordingDownstream : public IPipelineElementDownstream, private INonCopyable
+{
+public:
+    RecordingDownstream(Environment& aEnv);
+    void Reset();
+    TUint64 AudioBytes() const;
+    TUint Tracks() const;
+    TUint64 FirstAudioUs() const;
+    TBool AudioInOrder() const;
+public: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private:
+    class AudioRecorder : public IMsgProcessor
+    {
+    public:
+        AudioRecorder(RecordingDownstream& aOwner);
+    private: // from IMsgProcessor
+        Msg* ProcessMsg(MsgMode* aMsg) override               { return aMsg; }
+        Msg* ProcessMsg(MsgTrack* aMsg) override;
+        Msg* ProcessMsg(MsgDrain* aMsg) override              { return aMsg; }
+        Msg* ProcessMsg(MsgDelay* aMsg) override              { return aMsg; }
+        Msg* ProcessMsg(MsgEncodedStream* aMsg) override      { return aMsg; }
+        Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+        Msg* ProcessMsg(MsgMetaText* aMsg) override           { return aMsg; }
+        Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override  { return aMsg; }
+        Msg* ProcessMsg(MsgHalt* aMsg) override               { return aMsg; }
+        Msg* ProcessMsg(MsgFlush* aMsg) override              { return aMsg; }
+        Msg* ProcessMsg(MsgWait* aMsg) override               { return aMsg; }
+        Msg* ProcessMsg(MsgDecodedStream* aMsg) override      { return aMsg; }
+        Msg* ProcessMsg(MsgBitRate* aMsg) override            { return aMsg; }
+        Msg* ProcessMsg(MsgAudioPcm* aMsg) override           { return aMsg; }
+        Msg* ProcessMsg(MsgSilence* aMsg) override            { return aMsg; }
+        Msg* ProcessMsg(MsgPlayable* aMsg) override           { return aMsg; }
+        Msg* ProcessMsg(MsgQuit* aMsg) override               { return aMsg; }
+    private:
+        RecordingDownstream& iOwner;
+    };
+private:
+    Environment& iEnv;
+    AudioRecorder iRecorder;
+    TUint64 iAudioBytes;
+    TUint iTracks;
+    TUint64 iFirstAudioUs;
+    TBool iAudioInOrder;
+};
+
+class SuitePrerollCache : public SuiteUnitTest, private INonCopyable
+{
+    static const TUint kPrerollBytes = 64 * 1024;
+    static const TUint kTrackBytes = 256 * 1024;
+public:
+    SuitePrerollCache(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void WaitForPrerolled();
+    ProtocolStreamResult TimedStream(Track& aTrack, TUint64& aLatencyUs);
+private:
+    void TestStreamWithoutPrerollWaitsForConnect();
+    void TestStreamPrerolledTrackIsImmediate();
+    void TestPrerollHoldsLimitedBytes();
+    void TestOtherTrackStreamsNormally();
+    void TestPrerollBeforeStreamOfHeldTrack();
+    void TestStreamOfOtherTrackReplacesHeld();
+    void TestShortTrackFullyPrerolled();
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    TrackFactory* iTrackFactory;
+    RecordingDownstream* iDownstream;
+    StandInUriStreamer* iPrimary;
+    PrerollCache* iCache;
+    StandInUriStreamer* iPrerollStreamer;
+    Track* iTrack1;
+    Track* iTrack2;
+    Track* iTrack3;
+};
+
+/*
+ * Plays a short list of tracks through Filler, with the UriProvider able to say which
+ * track comes next.
+ */
+class StandInUriProvider : public UriProvider
+{
+public:
+    static const TUint kNumTracks = 3;
+public:
+    StandInUriProvider(TrackFactory& aTrackFactory);
+    ~StandInUriProvider();
+    TUint IdByIndex(TUint aIndex) const;
+private: // from UriProvider
+    void Begin(TUint aTrackId) override;
+    void BeginLater(TUint aTrackId) override;
+    EStreamPlay GetNext(Track*& aTrack) override;
+    TUint CurrentTrackId() const override;
+    void MoveNext() override;
+    void MovePrevious() override;
+    Track* PeekNext() override;
+private:
+    Track* iTracks[kNumTracks];
+    TUint iNextIndex;
+};
+
+class SuiteFillerPreroll : public SuiteUnitTest
+                         , private IPipelineIdTracker
+                         , private IPipelineIdManager
+                         , private IFlushIdProvider
+                         , private IStreamPlayObserver
+                         , private IPipelineIdProvider
+                         , private INonCopyable
+{
+    static const TUint kPrerollBytes = 64 * 1024;
+    static const TUint kTrackBytes = 256 * 1024;
+public:
+    SuiteFillerPreroll(Environment& aEnv);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private: // from IPipelineIdTracker
+    void AddStream(TUint aId, TUint aStreamId, TBool aPlayNow) override;
+private: // from IPipelineIdManager
+    void InvalidateAt(TUint aId) override;
+    void InvalidateAfter(TUint aId) override;
+    void InvalidatePending() override;
+    void InvalidateAll() override;
+private: // from IFlushIdProvider
+    TUint NextFlushId() override;
+private: // from IStreamPlayObserver
+    void NotifyTrackFailed(TUint aTrackId) override;
+    void NotifyStreamPlayStatus(TUint aTrackId, TUint aStreamId, EStreamPlay aStatus) override;
+private: // from IPipelineIdProvider
+    TUint NextStreamId() override;
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+private:
+    void TestFollowingTracksPrerolled();
+private:
+    Environment& iEnv;
+    AllocatorInfoLogger iInfoAggregator;
+    MsgFactory* iMsgFactory;
+    TrackFactory* iTrackFactory;
+    RecordingDownstream* iDownstream;
+    Filler* iFiller;
+    StandInUriProvider* iUriProvider;
+    StandInUriStreamer* iPrimary;
+    PrerollCache* iCache;
+    StandInUriStreamer* iPrerollStreamer;
+    TUint iNextFlushId;
+};
+
+} // namespace TestPrerollCache
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestPrerollCache;
+
+
+// StandInUriStreamer
+
+StandInUriStreamer::StandInUriStreamer(MsgFactory& aMsgFactory, IPipelineElementDownstream& aDownstream, TUint aTrackBytes)
+    : iLock("TSIU")
+    , iMsgFactory(aMsgFactory)
+    , iDownstream(aDownstream)
+    , iTrackBytes(aTrackBytes)
+    , iStreamCount(0)
+    , iInterruptCount(0)
+    , iBytesOutput(0)
+    , iInterrupted(false)
+    , iNextStreamId(1)
+{
+}
+
+TUint StandInUriStreamer::StreamCount() const
+{
+    AutoMutex _(iLock);
+    return iStreamCount;
+}
+
+TUint StandInUriStreamer::InterruptCount() const
+{
+    AutoMutex _(iLock);
+    return iInterruptCount;
+}
+
+TUint64 StandInUriStreamer::BytesOutput() const
+{
+    AutoMutex _(iLock);
+    return iBytesOutput;
+}
+
+ProtocolStreamResult StandInUriStreamer::DoStream(Track& aTrack)
+{
+    iLock.Wait();
+    iStreamCount++;
+    const TUint streamId = iNextStreamId++;
+    iLock.Signal();
+    iDownstream.Push(iMsgFactory.CreateMsgTrack(aTrack));
+    for (TUint i=0; i<kConnectMs; i+=5) {
+        if (Interrupted()) {
+            return EProtocolStreamStopped;
+        }
+        Thread::Sleep(5);
+    }
+    iDownstream.Push(iMsgFactory.CreateMsgEncodedStream(aTrack.Uri(), Brx::Empty(), iTrackBytes, 0, streamId, false, false, Multiroom::Allowed, nullptr));
+    TByte data[kChunkBytes];
+    for (TUint offset=0; offset<iTrackBytes; offset+=kChunkBytes) {
+        if (Interrupted()) {
+            return EProtocolStreamStopped;
+        }
+        const TUint bytes = (iTrackBytes - offset < kChunkBytes? iTrackBytes - offset : kChunkBytes);
+        for (TUint i=0; i<bytes; i++) {
+            data[i] = (TByte)((offset + i) % 251);
+        }
+        iDownstream.Push(iMsgFactory.CreateMsgAudioEncoded(Brn(data, bytes)));
+        AutoMutex _(iLock);
+        iBytesOutput += bytes;
+    }
+    return EProtocolStreamSuccess;
+}
+
+void StandInUriStreamer::Interrupt(TBool aInterrupt)
+{
+    AutoMutex _(iLock);
+    iInterrupted = aInterrupt;
+    if (aInterrupt) {
+        iInterruptCount++;
+    }
+}
+
+TBool StandInUriStreamer::Interrupted() const
+{
+    AutoMutex _(iLock);
+    return iInterrupted;
+}
+
+
+// RecordingDownstream
+
+RecordingDownstream::RecordingDownstream(Environment& aEnv)
+    : iEnv(aEnv)
+    , iRecorder(*this)
+{
+    Reset();
+}
+
+void RecordingDownstream::Reset()
+{
+    iAudioBytes = 0;
+    iTracks = 0;
+    iFirstAudioUs = 0;
+    iAudioInOrder = true;
+}
+
+TUint64 RecordingDownstream::AudioBytes() const
+{
+    return iAudioBytes;
+}
+
+TUint RecordingDownstream::Tracks() const
+{
+    return iTracks;
+}
+
+TUint64 RecordingDownstream::FirstAudioUs() const
+{
+    return iFirstAudioUs;
+}
+
+TBool RecordingDownstream::AudioInOrder() const
+{
+    return iAudioInOrder;
+}
+
+void RecordingDownstream::Push(Msg* aMsg)
+{
+    aMsg = aMsg->Process(iRecorder);
+    aMsg->RemoveRef();
+}
+
+RecordingDownstream::AudioRecorder::AudioRecorder(RecordingDownstream& aOwner)
+    : iOwner(aOwner)
+{
+}
+
+Msg* RecordingDownstream::AudioRecorder::ProcessMsg(MsgTrack* aMsg)
+{
+    iOwner.iTracks++;
+    return aMsg;
+}
+
+Msg* RecordingDownstream::AudioRecorder::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    if (iOwner.iFirstAudioUs == 0) {
+        iOwner.iFirstAudioUs = OsTimeInUs(iOwner.iEnv.OsCtx());
+    }
+    TByte buf[StandInUriStreamer::kChunkBytes];
+    ASSERT(aMsg->Bytes() <= sizeof(buf));
+    aMsg->CopyTo(buf);
+    for (TUint i=0; i<aMsg->Bytes(); i++) {
+        if (buf[i] != (TByte)((iOwner.iAudioBytes + i) % 251)) {
+            iOwner.iAudioInOrder = false;
+        }
+    }
+    iOwner.iAudioBytes += aMsg->Bytes();
+    return aMsg;
+}
+
+
+// SuitePrerollCache
+
+SuitePrerollCache::SuitePrerollCache(Environment& aEnv)
+    : SuiteUnitTest("PrerollCache")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestStreamWithoutPrerollWaitsForConnect), "TestStreamWithoutPrerollWaitsForConnect");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestStreamPrerolledTrackIsImmediate), "TestStreamPrerolledTrackIsImmediate");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestPrerollHoldsLimitedBytes), "TestPrerollHoldsLimitedBytes");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestOtherTrackStreamsNormally), "TestOtherTrackStreamsNormally");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestPrerollBeforeStreamOfHeldTrack), "TestPrerollBeforeStreamOfHeldTrack");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestStreamOfOtherTrackReplacesHeld), "TestStreamOfOtherTrackReplacesHeld");
+    AddTest(MakeFunctor(*this, &SuitePrerollCache::TestShortTrackFullyPrerolled), "TestShortTrackFullyPrerolled");
+}
+
+void SuitePrerollCache::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(200, 200);
+    init.SetMsgTrackCount(6);
+    init.SetMsgEncodedStreamCount(4);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iTrackFactory = new TrackFactory(iInfoAggregator, 4);
+    iDownstream = new RecordingDownstream(iEnv);
+    iPrimary = new StandInUriStreamer(*iMsgFactory, *iDownstream, kTrackBytes);
+    iCache = new PrerollCache(*iDownstream, *iPrimary, kPriorityNormal, kPrerollBytes);
+    iPrerollStreamer = new StandInUriStreamer(*iMsgFactory, *iCache, kTrackBytes);
+    iCache->Start(*iPrerollStreamer);
+    iTrack1 = iTrackFactory->CreateTrack(Brn("http://127.0.0.1/1.flac"), Brx::Empty());
+    iTrack2 = iTrackFactory->CreateTrack(Brn("http://127.0.0.1/2.flac"), Brx::Empty());
+    iTrack3 = iTrackFactory->CreateTrack(Brn("http://127.0.0.1/3.flac"), Brx::Empty());
+}
+
+void SuitePrerollCache::TearDown()
+{
+    iCache->Quit();
+    delete iCache;
+    delete iPrerollStreamer;
+    delete iPrimary;
+    delete iDownstream;
+    iTrack1->RemoveRef();
+    iTrack2->RemoveRef();
+    iTrack3->RemoveRef();
+    delete iTrackFactory;
+    delete iMsgFactory;
+}
+
+void SuitePrerollCache::WaitForPrerolled()
+{
+    for (TUint i=0; i<200 && iPrerollStreamer->BytesOutput() < kPrerollBytes; i++) {
+        Thread::Sleep(10);
+    }
+    Thread::Sleep(10); // allow the preroll thread to block
+}
+
+ProtocolStreamResult SuitePrerollCache::TimedStream(Track& aTrack, TUint64& aLatencyUs)
+{
+    iDownstream->Reset();
+    iCache->Interrupt(false);
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    const ProtocolStreamResult res = iCache->DoStream(aTrack);
+    aLatencyUs = (iDownstream->FirstAudioUs() == 0? 0 : iDownstream->FirstAudioUs() - start);
+    return res;
+}
+
+void SuitePrerollCache::TestStreamWithoutPrerollWaitsForConnect()
+{
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    Print("latency without preroll: %llums\n", latencyUs / 1000);
+    TEST(latencyUs >= StandInUriStreamer::kConnectMs * 1000);
+    TEST(iPrimary->StreamCount() == 1);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+}
+
+void SuitePrerollCache::TestStreamPrerolledTrackIsImmediate()
+{
+    iCache->Preroll(*iTrack1);
+    WaitForPrerolled();
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    Print("latency with preroll: %llums\n", latencyUs / 1000);
+    TEST(latencyUs < (StandInUriStreamer::kConnectMs * 1000) / 4);
+    TEST(iPrimary->StreamCount() == 0);
+    TEST(iPrerollStreamer->StreamCount() == 1);
+    TEST(iDownstream->Tracks() == 1);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+    TEST(iDownstream->AudioInOrder());
+}
+
+void SuitePrerollCache::TestPrerollHoldsLimitedBytes()
+{
+    iCache->Preroll(*iTrack1);
+    WaitForPrerolled();
+    Thread::Sleep(50);
+    const TUint64 bytes = iPrerollStreamer->BytesOutput();
+    TEST(bytes >= kPrerollBytes);
+    TEST(bytes < kPrerollBytes + 2 * StandInUriStreamer::kChunkBytes);
+    TEST(iDownstream->AudioBytes() == 0);
+}
+
+void SuitePrerollCache::TestOtherTrackStreamsNormally()
+{
+    iCache->Preroll(*iTrack2);
+    WaitForPrerolled();
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    TEST(iPrimary->StreamCount() == 1);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+
+    // preroll of the other track is unaffected
+    TEST(TimedStream(*iTrack2, latencyUs) == EProtocolStreamSuccess);
+    TEST(latencyUs < (StandInUriStreamer::kConnectMs * 1000) / 4);
+    TEST(iPrimary->StreamCount() == 1);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+    TEST(iDownstream->AudioInOrder());
+}
+
+void SuitePrerollCache::TestPrerollBeforeStreamOfHeldTrack()
+{
+    // Filler asks for the following track to be prerolled just before streaming the current one
+    iCache->Preroll(*iTrack1);
+    WaitForPrerolled();
+    iCache->Preroll(*iTrack2);
+    TEST(iPrerollStreamer->InterruptCount() == 0);
+    TEST(iPrerollStreamer->StreamCount() == 1);
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    TEST(latencyUs < (StandInUriStreamer::kConnectMs * 1000) / 4);
+    TEST(iPrimary->StreamCount() == 0);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+
+    // the following track is fetched once the held one has been streamed
+    for (TUint i=0; i<200 && iPrerollStreamer->BytesOutput() < kTrackBytes + kPrerollBytes; i++) {
+        Thread::Sleep(10);
+    }
+    TEST(iPrerollStreamer->StreamCount() == 2);
+    TEST(TimedStream(*iTrack2, latencyUs) == EProtocolStreamSuccess);
+    TEST(latencyUs < (StandInUriStreamer::kConnectMs * 1000) / 4);
+    TEST(iPrimary->StreamCount() == 0);
+    TEST(iDownstream->AudioInOrder());
+}
+
+void SuitePrerollCache::TestStreamOfOtherTrackReplacesHeld()
+{
+    iCache->Preroll(*iTrack1);
+    WaitForPrerolled();
+    iCache->Preroll(*iTrack2);
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack3, latencyUs) == EProtocolStreamSuccess);
+    TEST(iPrimary->StreamCount() == 1);
+    TEST(iPrerollStreamer->InterruptCount() > 0);
+    for (TUint i=0; i<200 && iPrerollStreamer->StreamCount() < 2; i++) {
+        Thread::Sleep(10);
+    }
+    TEST(iPrerollStreamer->StreamCount() == 2);
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    TEST(iPrimary->StreamCount() == 2); // no longer prerolled
+    TEST(TimedStream(*iTrack2, latencyUs) == EProtocolStreamSuccess);
+    TEST(iPrimary->StreamCount() == 2);
+    TEST(iDownstream->AudioBytes() == kTrackBytes);
+}
+
+void SuitePrerollCache::TestShortTrackFullyPrerolled()
+{
+    // replace the preroll streamer with one whose tracks fit within the preroll limit
+    iCache->Quit();
+    delete iCache;
+    delete iPrerollStreamer;
+    iCache = new PrerollCache(*iDownstream, *iPrimary, kPriorityNormal, kPrerollBytes);
+    iPrerollStreamer = new StandInUriStreamer(*iMsgFactory, *iCache, kPrerollBytes / 2);
+    iCache->Start(*iPrerollStreamer);
+
+    iCache->Preroll(*iTrack1);
+    for (TUint i=0; i<200 && iPrerollStreamer->BytesOutput() < kPrerollBytes / 2; i++) {
+        Thread::Sleep(10);
+    }
+    TUint64 latencyUs = 0;
+    TEST(TimedStream(*iTrack1, latencyUs) == EProtocolStreamSuccess);
+    TEST(latencyUs < (StandInUriStreamer::kConnectMs * 1000) / 4);
+    TEST(iPrimary->StreamCount() == 0);
+    TEST(iDownstream->AudioBytes() == kPrerollBytes / 2);
+}
+
+
+// StandInUriProvider
+
+StandInUriProvider::StandInUriProvider(TrackFactory& aTrackFactory)
+    : UriProvider("StandIn",
+                  Latency::NotSupported,
+                  Next::Supported, Prev::Supported,
+                  Repeat::NotSupported, Random::NotSupported,
+                  RampPauseResume::Long, RampSkip::Short)
+    , iNextIndex(0)
+{
+    iTracks[0] = aTrackFactory.CreateTrack(Brn("http://127.0.0.1/1.flac"), Brx::Empty());
+    iTracks[1] = aTrackFactory.CreateTrack(Brn("http://127.0.0.1/2.flac"), Brx::Empty());
+    iTracks[2] = aTrackFactory.CreateTrack(Brn("http://127.0.0.1/3.flac"), Brx::Empty());
+}
+
+StandInUriProvider::~StandInUriProvider()
+{
+    for (TUint i=0; i<kNumTracks; i++) {
+        iTracks[i]->RemoveRef();
+    }
+}
+
+TUint StandInUriProvider::IdByIndex(TUint aIndex) const
+{
+    return iTracks[aIndex]->Id();
+}
+
+void StandInUriProvider::Begin(TUint aTrackId)
+{
+    for (TUint i=0; i<kNumTracks; i++) {
+        if (iTracks[i]->Id() == aTrackId) {
+            iNextIndex = i;
+            return;
+        }
+    }
+    THROW(UriProviderInvalidId);
+}
+
+void StandInUriProvider::BeginLater(TUint /*aTrackId*/)
+{
+    ASSERTS();
+}
+
+EStreamPlay StandInUriProvider::GetNext(Track*& aTrack)
+{
+    if (iNextIndex == kNumTracks) {
+        aTrack = nullptr;
+        return ePlayNo;
+    }
+    aTrack = iTracks[iNextIndex++];
+    aTrack->AddRef();
+    return ePlayYes;
+}
+
+TUint StandInUriProvider::CurrentTrackId() const
+{
+    return (iNextIndex == 0? Track::kIdNone : iTracks[iNextIndex-1]->Id());
+}
+
+void StandInUriProvider::MoveNext()
+{
+    ASSERTS();
+}
+
+void StandInUriProvider::MovePrevious()
+{
+    ASSERTS();
+}
+
+Track* StandInUriProvider::PeekNext()
+{
+    if (iNextIndex == kNumTracks) {
+        return nullptr;
+    }
+    Track* track = iTracks[iNextIndex];
+    track->AddRef();
+    return track;
+}
+
+
+// SuiteFillerPreroll
+
+SuiteFillerPreroll::SuiteFillerPreroll(Environment& aEnv)
+    : SuiteUnitTest("Filler with PrerollCache")
+    , iEnv(aEnv)
+{
+    AddTest(MakeFunctor(*this, &SuiteFillerPreroll::TestFollowingTracksPrerolled), "TestFollowingTracksPrerolled");
+}
+
+void SuiteFillerPreroll::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(200, 200);
+    init.SetMsgTrackCount(6);
+    init.SetMsgEncodedStreamCount(4);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iTrackFactory = new TrackFactory(iInfoAggregator, StandInUriProvider::kNumTracks + 1);
+    iDownstream = new RecordingDownstream(iEnv);
+    iFiller = new Filler(*iDownstream, *this, *this, *this, *iMsgFactory, *iTrackFactory, *this, *this, kPriorityNormal, Jiffies::kPerMs * 150);
+    iUriProvider = new StandInUriProvider(*iTrackFactory);
+    iPrimary = new StandInUriStreamer(*iMsgFactory, *iFiller, kTrackBytes);
+    iCache = new PrerollCache(*iFiller, *iPrimary, kPriorityNormal, kPrerollBytes);
+    iPrerollStreamer = new StandInUriStreamer(*iMsgFactory, *iCache, kTrackBytes);
+    iCache->Start(*iPrerollStreamer);
+    iFiller->Add(*iUriProvider);
+    iFiller->SetPreroll(*iCache);
+    iFiller->Start(*iCache);
+    iNextFlushId = MsgFlush::kIdInvalid + 1;
+}
+
+void SuiteFillerPreroll::TearDown()
+{
+    iFiller->Quit();
+    iCache->Quit();
+    delete iFiller;
+    delete iCache;
+    delete iPrerollStreamer;
+    delete iPrimary;
+    delete iUriProvider;
+    delete iDownstream;
+    delete iTrackFactory;
+    delete iMsgFactory;
+}
+
+void SuiteFillerPreroll::AddStream(TUint /*aId*/, TUint /*aStreamId*/, TBool /*aPlayNow*/)
+{
+}
+
+void SuiteFillerPreroll::InvalidateAt(TUint /*aId*/)
+{
+}
+
+void SuiteFillerPreroll::InvalidateAfter(TUint /*aId*/)
+{
+}
+
+void SuiteFillerPreroll::InvalidatePending()
+{
+}
+
+void SuiteFillerPreroll::InvalidateAll()
+{
+}
+
+TUint SuiteFillerPreroll::NextFlushId()
+{
+    return iNextFlushId++;
+}
+
+void SuiteFillerPreroll::NotifyTrackFailed(TUint /*aTrackId*/)
+{
+}
+
+void SuiteFillerPreroll::NotifyStreamPlayStatus(TUint /*aTrackId*/, TUint /*aStreamId*/, EStreamPlay /*aStatus*/)
+{
+}
+
+TUint SuiteFillerPreroll::NextStreamId()
+{
+    ASSERTS();
+    return kStreamIdInvalid;
+}
+
+EStreamPlay SuiteFillerPreroll::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayYes;
+}
+
+void SuiteFillerPreroll::TestFollowingTracksPrerolled()
+{
+    iFiller->Play(iUriProvider->Mode(), iUriProvider->IdByIndex(0));
+    // all tracks, followed by Filler's null track once the UriProvider runs out
+    for (TUint i=0; i<500 && iDownstream->Tracks() < StandInUriProvider::kNumTracks + 1; i++) {
+        Thread::Sleep(10);
+    }
+    TEST(iDownstream->Tracks() == StandInUriProvider::kNumTracks + 1);
+    TEST(iFiller->IsStopped());
+    TEST(iDownstream->AudioBytes() == StandInUriProvider::kNumTracks * kTrackBytes);
+    // only the first track had to wait for a connection; the others were prerolled while their predecessor streamed
+    TEST(iPrimary->StreamCount() == 1);
+    TEST(iPrerollStreamer->StreamCount() == StandInUriProvider::kNumTracks - 1);
+    TEST(iPrerollStreamer->InterruptCount() == 0);
+}
+
+
+
+void TestPrerollCache(Environment& aEnv)
+{
+    Runner runner("PrerollCache tests\n");
+    runner.Add(new SuitePrerollCache(aEnv));
+    runner.Add(new SuiteFillerPreroll(aEnv));
+    runner.Run();
+}
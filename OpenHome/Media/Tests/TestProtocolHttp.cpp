@@ -179,6 +179,16 @@ private:
     EMode iMode;
 };
 
+class TestHttpSessionInterrupt : public TestHttpSessionStreamFull
+{
+public:
+    TestHttpSessionInterrupt();
+private: // from TestHttpSession
+    void Respond();
+private:
+    TBool iFirstRequest;
+};
+
 class TestHttpSessionSeek : public SocketTcpSession
 {
 public:
@@ -237,7 +247,8 @@ public:
         eReconnect        = 2,
         eStreamLive       = 3,
         eLiveReconnect    = 4,
-        eChunked          = 5
+        eChunked          = 5,
+        eInterrupt        = 6
     };
 public:
     static TestHttpSession* Create(ESession aSession);
@@ -313,6 +324,17 @@ private:
     TByte iOutput[EncodedAudio::kMaxBytes];
 };
 
+class TestHttpSupplyInterrupt : public TestHttpSupplier
+{
+public:
+    TestHttpSupplyInterrupt(TUint aDataSize);
+    void SetProtocolManager(ProtocolManager& aProtocolManager);
+protected: // from IMsgProcessor
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+private:
+    ProtocolManager* iProtocolManager;
+};
+
 class TestHttpPipelineProvider : public IPipelineIdProvider
 {
 public:
@@ -428,6 +450,24 @@ private:
 };
 
 
+class SuiteHttpInterrupt : public Suite
+{
+public:
+    SuiteHttpInterrupt();
+    ~SuiteHttpInterrupt();
+private: // from Suite
+    void Test();
+private:
+    TestHttpServer* iServer;
+    TestHttpSupplyInterrupt* iSupply;
+    TestHttpPipelineProvider* iProvider;
+    TestHttpFlushIdProvider* iFlushId;
+    MsgFactory* iMsgFactory;
+    ProtocolManager* iProtocolManager;
+    AllocatorInfoLogger iInfoAggregator;
+    TrackFactory* iTrackFactory;
+};
+
 class SuiteHttpSeekBase : public SuiteHttpBase
 {
 public:
@@ -821,6 +861,29 @@ void TestHttpSessionChunked::Respond()
 }
 
 
+// TestHttpSessionInterrupt
+
+TestHttpSessionInterrupt::TestHttpSessionInterrupt()
+    : TestHttpSessionStreamFull()
+    , iFirstRequest(true)
+{
+}
+
+void TestHttpSessionInterrupt::Respond()
+{
+    WriteResponseContentLength(kStreamLen);
+    if (iFirstRequest) {
+        // Client is interrupted once it sees the stream.  Only write as much as will fit
+        // in socket buffers so closing the connection can't fail a write here.
+        iFirstRequest = false;
+        Stream(0, kStreamLen/16);
+    }
+    else {
+        Stream(0, kStreamLen);
+    }
+}
+
+
 // TestHttpSessionSeek
 
 TestHttpSessionSeek::TestHttpSessionSeek(Semaphore& aSemServerWait, Semaphore& aSemExternalOp)
@@ -956,6 +1019,8 @@ TestHttpSession* SessionFactory::Create(ESession aSession)
         return new TestHttpSessionLiveReconnect();
     case eChunked:
         return new TestHttpSessionChunked();
+    case eInterrupt:
+        return new TestHttpSessionInterrupt();
     default:
         ASSERTS();
         return nullptr;    // Will never reach here.
@@ -1166,6 +1231,30 @@ Msg* TestHttpSupplyChunked::ProcessMsg(MsgAudioEncoded* aMsg)
 }
 
 
+// TestHttpSupplyInterrupt
+
+TestHttpSupplyInterrupt::TestHttpSupplyInterrupt(TUint aDataSize)
+    : TestHttpSupplier(aDataSize)
+    , iProtocolManager(nullptr)
+{
+}
+
+void TestHttpSupplyInterrupt::SetProtocolManager(ProtocolManager& aProtocolManager)
+{
+    iProtocolManager = &aProtocolManager;
+}
+
+Msg* TestHttpSupplyInterrupt::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    (void)TestHttpSupplier::ProcessMsg(aMsg);
+    if (StreamCount() == 1) {
+        // simulate the user stopping the first stream
+        iProtocolManager->Interrupt(true);
+    }
+    return aMsg;
+}
+
+
 // TestHttpPipelineProvider
 
 TestHttpPipelineProvider::TestHttpPipelineProvider()
@@ -1479,6 +1568,79 @@ void SuiteHttpChunked::Test()
 }
 
 
+// SuiteHttpInterrupt
+
+SuiteHttpInterrupt::SuiteHttpInterrupt()
+    : Suite("HTTP stream after interrupt")
+{
+    std::vector<NetworkAdapter*>* ifs = Os::NetworkListAdapters(*gEnv, Net::InitialisationParams::ELoopbackUse, "SuiteHttpInterrupt");
+    TIpAddress addr = (*ifs)[0]->Address();
+    for (TUint i=0; i<ifs->size(); i++) {
+        (*ifs)[i]->RemoveRef("SuiteHttpInterrupt");
+    }
+    delete ifs;
+
+    iServer = new TestHttpServer(*gEnv, "HSV1", 0, addr);
+    TestHttpSession* session = SessionFactory::Create(SessionFactory::eInterrupt);
+    iServer->Add("HTP1", session);
+
+    iSupply = new TestHttpSupplyInterrupt(TestHttpSession::kStreamLen);
+    iProvider = new TestHttpPipelineProvider();
+    iFlushId = new TestHttpFlushIdProvider();
+
+    MsgFactoryInitParams init;
+    init.SetMsgAudioEncodedCount(100, 100);
+    init.SetMsgTrackCount(10);
+    init.SetMsgEncodedStreamCount(10);
+    init.SetMsgMetaTextCount(10);
+    init.SetMsgFlushCount(10);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+
+    iProtocolManager = new ProtocolManager(*iSupply, *iMsgFactory, *iProvider, *iFlushId);
+    iProtocolManager->Add(ProtocolFactory::NewHttp(*gEnv, Brx::Empty()));
+    iSupply->SetProtocolManager(*iProtocolManager);
+
+    iTrackFactory= new TrackFactory(iInfoAggregator, 2);
+}
+
+SuiteHttpInterrupt::~SuiteHttpInterrupt()
+{
+    delete iTrackFactory;
+    delete iProtocolManager;
+    delete iProvider;
+    delete iSupply;
+    delete iMsgFactory;
+    delete iServer;
+    delete iFlushId;
+}
+
+void SuiteHttpInterrupt::Test()
+{
+    // Address the server by name so that streams go via the host resolver.
+    Bws<TestHttpServer::kMaxUriBytes> uri(TestHttpServer::kPrefixHttp);
+    uri.Append("localhost:");
+    Ascii::AppendDec(uri, iServer->Port());
+
+    Track* track = iTrackFactory->CreateTrack(uri, Brx::Empty());
+    ProtocolStreamResult res = iProtocolManager->DoStream(*track);
+    track->RemoveRef();
+    TEST(res == EProtocolStreamStopped);
+    TEST(iSupply->StreamCount() == 1);
+    const TUint firstStreamBytes = iSupply->DataTotal();
+
+    // Filler cancels the interruption before the protocol is next active
+    iProtocolManager->Interrupt(false);
+
+    track = iTrackFactory->CreateTrack(uri, Brx::Empty());
+    res = iProtocolManager->DoStream(*track);
+    track->RemoveRef();
+    TEST(res == EProtocolStreamSuccess);
+    TEST(iSupply->TrackCount() == 2);
+    TEST(iSupply->StreamCount() == 2);
+    TEST(iSupply->DataTotal() - firstStreamBytes == TestHttpSession::kStreamLen);
+}
+
+
 // SuiteHttpSeekBase
 
 SuiteHttpSeekBase::SuiteHttpSeekBase(const TChar* aSuiteName, SessionSeekFactory::ESessionSeek aSession)
@@ -1557,6 +1719,7 @@ void TestProtocolHttp()
     runner.Add(new SuiteHttpStreamLive());
     runner.Add(new SuiteHttpLiveReconnect());
     runner.Add(new SuiteHttpChunked());
+    runner.Add(new SuiteHttpInterrupt());
     runner.Add(new SuiteHttpSeekInvalid());
     runner.Run();
 }
@@ -0,0 +1,153 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Media/Resampler.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+/*
+    Reports the cost and quality of Resampler for common conversions.
+    - throughput: seconds of audio converted per second of cpu (i.e. multiple of realtime)
+    - THD+N: residual after removing a best fit sine, for a 1kHz tone at -6dBFS
+*/
+
+namespace OpenHome {
+namespace Media {
+namespace TestResamplerPerf {
+
+class Bench : private INonCopyable
+{
+    static const TUint kFramesPerPush = 1024;
+public:
+    Bench(Environment& aEnv, TUint aSeconds);
+    void Run();
+private:
+    void Measure(TUint aRateIn, TUint aRateOut, TUint aNumChannels, TUint aMultiplier);
+    static double ThdN(const std::vector<TInt32>& aOutput, TUint aFrames, TUint aNumChannels, TUint aRateOut, double aFreq);
+private:
+    Environment& iEnv;
+    const TUint iSeconds;
+};
+
+} // namespace TestResamplerPerf
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome::Media::TestResamplerPerf;
+
+static const double kPi = 3.14159265358979;
+
+Bench::Bench(Environment& aEnv, TUint aSeconds)
+    : iEnv(aEnv)
+    , iSeconds(aSeconds)
+{
+}
+
+void Bench::Run()
+{
+    Log::Print("Resampler benchmark (%us of audio per conversion)\n", iSeconds);
+    Log::Print("%-28s %4s %12s %12s\n", "conversion", "ch", "x realtime", "THD+N(dB)");
+    static const TUint kConversions[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 44100, 96000 },
+                                             { 96000, 48000 }, { 192000, 48000 }, { 48000, 48000 } };
+    static const TUint kChannels[] = { 2, 8 };
+    for (auto& conversion : kConversions) {
+        for (auto channels : kChannels) {
+            Measure(conversion[0], conversion[1], channels, IPullableClock::kNominalFreq);
+        }
+    }
+    // software clock: unity ratio pulled by 100ppm
+    Measure(44100, 44100, 2, IPullableClock::kNominalFreq + (IPullableClock::kNominalFreq / 10000));
+}
+
+void Bench::Measure(TUint aRateIn, TUint aRateOut, TUint aNumChannels, TUint aMultiplier)
+{
+    const TUint inputFrames = aRateIn * iSeconds;
+    std::vector<TInt32> input(inputFrames * aNumChannels);
+    for (TUint i=0; i<inputFrames; i++) {
+        const TInt32 sample = (TInt32)lrint(sin(2 * kPi * 1000 * i / aRateIn) * 0.5 * 8388607) * 256;
+        for (TUint j=0; j<aNumChannels; j++) {
+            input[i*aNumChannels + j] = sample;
+        }
+    }
+    const TUint maxOutputFrames = (TUint)(((TUint64)inputFrames * aRateOut) / aRateIn) * 2 + 1024;
+    std::vector<TInt32> output((size_t)maxOutputFrames * aNumChannels);
+
+    Resampler resampler(kFramesPerPush);
+    resampler.Configure(aRateIn, aRateOut, aNumChannels);
+    resampler.SetPull(aMultiplier);
+    TUint outputFrames = 0;
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<inputFrames; i+=kFramesPerPush) {
+        const TUint frames = std::min(kFramesPerPush, inputFrames - i);
+        resampler.Push(&input[i*aNumChannels], frames);
+        outputFrames += resampler.Pull(&output[outputFrames*aNumChannels], maxOutputFrames - outputFrames);
+    }
+    resampler.Drain();
+    outputFrames += resampler.Pull(&output[outputFrames*aNumChannels], maxOutputFrames - outputFrames);
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+
+    const double freq = 1000.0 * aMultiplier / IPullableClock::kNominalFreq;
+    const double thdn = ThdN(output, outputFrames, aNumChannels, aRateOut, freq);
+    const TUint realtime = (us == 0? 0 : (TUint)(((TUint64)iSeconds * 1000000) / us));
+    Bws<32> name;
+    name.AppendPrintf("%u -> %u%s", aRateIn, aRateOut, (aMultiplier == IPullableClock::kNominalFreq? "" : " (pulled)"));
+    Log::Print("%-28.*s %4u %12u %12d\n", PBUF(name), aNumChannels, realtime, (TInt)thdn);
+}
+
+double Bench::ThdN(const std::vector<TInt32>& aOutput, TUint aFrames, TUint aNumChannels, TUint aRateOut, double aFreq)
+{ // static
+    // least squares fit of a sine to the first channel over the middle of the output
+    const TUint start = aFrames / 4;
+    const TUint end = (aFrames * 3) / 4;
+    double ss = 0, cc = 0, sc = 0, sy = 0, cy = 0;
+    for (TUint i=start; i<end; i++) {
+        const double s = sin(2 * kPi * aFreq * i / aRateOut);
+        const double c = cos(2 * kPi * aFreq * i / aRateOut);
+        const double y = aOutput[i*aNumChannels] / 2147483648.0;
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        sy += s * y;
+        cy += c * y;
+    }
+    const double det = ss * cc - sc * sc;
+    const double a = (sy * cc - cy * sc) / det;
+    const double b = (cy * ss - sy * sc) / det;
+    double signal = 0, noise = 0;
+    for (TUint i=start; i<end; i++) {
+        const double fit = a * sin(2 * kPi * aFreq * i / aRateOut) + b * cos(2 * kPi * aFreq * i / aRateOut);
+        const double err = aOutput[i*aNumChannels] / 2147483648.0 - fit;
+        signal += fit * fit;
+        noise += err * err;
+    }
+    return 10 * log10(noise / signal);
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionSeconds("-s", "--seconds", 10, "seconds of audio converted in each test");
+    parser.AddOption(&optionSeconds);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench bench(lib->Env(), optionSeconds.Value());
+    bench.Run();
+    delete lib;
+}
@@ -0,0 +1,744 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Media/Pipeline/SampleRateConverter.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Resampler.h>
+#include <OpenHome/Media/Utils/AllocatorInfoLogger.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Functor.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+class SuiteSampleRateConverter : public SuiteUnitTest
+                               , private IPipelineElementDownstream
+                               , private IMsgProcessor
+                               , private IPipelineAnimator
+                               , private IStreamHandler
+{
+    static const TUint kBitrate = 256;
+    static const TUint kSampleRate = 44100;
+    static const TUint kChannels = 2;
+    static const SpeakerProfile kProfile;
+    static const TUint kBitDepth = 16;
+public:
+    SuiteSampleRateConverter();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    enum EMsgType
+    {
+        EMsgNone
+       ,EMsgMode
+       ,EMsgTrack
+       ,EMsgDrain
+       ,EMsgEncodedStream
+       ,EMsgDelay
+       ,EMsgMetaText
+       ,EMsgStreamInterrupted
+       ,EMsgHalt
+       ,EMsgFlush
+       ,EMsgWait
+       ,EMsgDecodedStream
+       ,EMsgBitRate
+       ,EMsgAudioPcm
+       ,EMsgSilence
+       ,EMsgQuit
+    };
+private:
+    void PushMsg(EMsgType aType);
+    void StartStream();
+private:
+    void MsgsPassThrough();
+    void SupportedRatePassesThrough();
+    void UnsupportedRateConverted();
+    void ConvertedDurationMatchesInput();
+    void ConvertedSilenceOutputAsAudio();
+    void NoSupportedRatePassesThrough();
+    void PullStartsConversion();
+    void PullConvertsFullSizeMsgs();
+    void PullClamped();
+private: // from IPipelineElementDownstream
+    void Push(Msg* aMsg) override;
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgTrack* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgDelay* aMsg) override;
+    Msg* ProcessMsg(MsgEncodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgAudioEncoded* aMsg) override;
+    Msg* ProcessMsg(MsgMetaText* aMsg) override;
+    Msg* ProcessMsg(MsgStreamInterrupted* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgFlush* aMsg) override;
+    Msg* ProcessMsg(MsgWait* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgBitRate* aMsg) override;
+    Msg* ProcessMsg(MsgAudioPcm* aMsg) override;
+    Msg* ProcessMsg(MsgSilence* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() override;
+    TUint PipelineAnimatorDelayJiffies(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) override;
+private: // from IStreamHandler
+    EStreamPlay OkToPlay(TUint aStreamId) override;
+    TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
+    TUint TryDiscard(TUint aJiffies) override;
+    TUint TryStop(TUint aStreamId) override;
+    void NotifyStarving(const Brx& aMode, TUint aStreamId, TBool aStarving) override;
+private:
+    MsgFactory* iMsgFactory;
+    TrackFactory* iTrackFactory;
+    AllocatorInfoLogger iInfoAggregator;
+    SampleRateConverter* iSampleRateConverter;
+    EMsgType iLastMsg;
+    TUint iNextStreamId;
+    TByte iAudioData[AudioData::kMaxBytes];
+    TUint iAudioBytes; // default of 884 => 5ms @ 44.1, 16-bit, stereo
+    TUint64 iTrackOffsetTx;
+    std::vector<TUint> iSupportedRates; // empty => all rates supported
+    TUint iStreamSampleRate;
+    TUint iStreamBitDepth;
+    TBool iAudioMatchesStream; // all audio is in the format reported by the last MsgDecodedStream
+    TUint64 iJiffiesRx;
+    TUint64 iTrackOffsetRx;
+    TBool iTrackOffsetsContiguous;
+};
+
+class SuiteResampler : public Suite
+{
+    static const TUint kMaxInputFrames = 1024;
+public:
+    SuiteResampler();
+    void Test() override;
+private:
+    void TestUnityBitExact();
+    void TestThdN(TUint aRateIn, TUint aRateOut, TUint aFreq, TUint aMultiplier);
+    void TestOutputCount(TUint aRateIn, TUint aRateOut);
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+
+// SuiteSampleRateConverter
+
+const SpeakerProfile SuiteSampleRateConverter::kProfile(2);
+
+SuiteSampleRateConverter::SuiteSampleRateConverter()
+    : SuiteUnitTest("SampleRateConverter tests")
+{
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::MsgsPassThrough), "MsgsPassThrough");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::SupportedRatePassesThrough), "SupportedRatePassesThrough");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::UnsupportedRateConverted), "UnsupportedRateConverted");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::ConvertedDurationMatchesInput), "ConvertedDurationMatchesInput");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::ConvertedSilenceOutputAsAudio), "ConvertedSilenceOutputAsAudio");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::NoSupportedRatePassesThrough), "NoSupportedRatePassesThrough");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::PullStartsConversion), "PullStartsConversion");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::PullConvertsFullSizeMsgs), "PullConvertsFullSizeMsgs");
+    AddTest(MakeFunctor(*this, &SuiteSampleRateConverter::PullClamped), "PullClamped");
+}
+
+void SuiteSampleRateConverter::Setup()
+{
+    MsgFactoryInitParams init;
+    init.SetMsgDelayCount(2);
+    init.SetMsgAudioPcmCount(50, 50);
+    init.SetMsgSilenceCount(10);
+    init.SetMsgDecodedStreamCount(3);
+    iMsgFactory = new MsgFactory(iInfoAggregator, init);
+    iTrackFactory = new TrackFactory(iInfoAggregator, 3);
+    iSampleRateConverter = new SampleRateConverter(*iMsgFactory, *this);
+    iSampleRateConverter->SetAnimator(*this);
+    iLastMsg = EMsgNone;
+    iNextStreamId = 1;
+    for (TUint i=0; i<sizeof(iAudioData); i+=2) {
+        // 1kHz sine at -6dB, little endian
+        const TUint frame = i / (2 * kChannels);
+        const TInt16 sample = (TInt16)(16383 * sin(2 * 3.14159265358979 * 1000 * frame / kSampleRate));
+        iAudioData[i] = (TByte)sample;
+        iAudioData[i+1] = (TByte)(sample >> 8);
+    }
+    iAudioBytes = 884;
+    iTrackOffsetTx = 0;
+    iSupportedRates.clear();
+    iStreamSampleRate = iStreamBitDepth = 0;
+    iAudioMatchesStream = true;
+    iJiffiesRx = 0;
+    iTrackOffsetRx = 0;
+    iTrackOffsetsContiguous = true;
+}
+
+void SuiteSampleRateConverter::TearDown()
+{
+    delete iSampleRateConverter;
+    delete iTrackFactory;
+    delete iMsgFactory;
+}
+
+void SuiteSampleRateConverter::PushMsg(EMsgType aType)
+{
+    Msg* msg = nullptr;
+    switch (aType)
+    {
+    case EMsgMode:
+        msg = iMsgFactory->CreateMsgMode(Brn("dummyMode"));
+        break;
+    case EMsgTrack:
+    {
+        Track* track = iTrackFactory->CreateTrack(Brx::Empty(), Brx::Empty());
+        msg = iMsgFactory->CreateMsgTrack(*track);
+        track->RemoveRef();
+    }
+        break;
+    case EMsgDrain:
+        msg = iMsgFactory->CreateMsgDrain(Functor());
+        break;
+    case EMsgEncodedStream:
+        msg = iMsgFactory->CreateMsgEncodedStream(Brx::Empty(), Brx::Empty(), 0, 0, iNextStreamId, false, true, Multiroom::Allowed, nullptr);
+        break;
+    case EMsgDelay:
+        msg = iMsgFactory->CreateMsgDelay(Jiffies::kPerMs * 20);
+        break;
+    case EMsgMetaText:
+        msg = iMsgFactory->CreateMsgMetaText(Brn("dummy metatext"));
+        break;
+    case EMsgStreamInterrupted:
+        msg = iMsgFactory->CreateMsgStreamInterrupted();
+        break;
+    case EMsgHalt:
+        msg = iMsgFactory->CreateMsgHalt();
+        break;
+    case EMsgFlush:
+        msg = iMsgFactory->CreateMsgFlush(1);
+        break;
+    case EMsgWait:
+        msg = iMsgFactory->CreateMsgWait();
+        break;
+    case EMsgDecodedStream:
+        iTrackOffsetTx = 0;
+        msg = iMsgFactory->CreateMsgDecodedStream(iNextStreamId++, kBitrate, kBitDepth, kSampleRate, kChannels, Brn("Dummy"), 0, 0, true, true, false, false, Multiroom::Allowed, kProfile, this);
+        break;
+    case EMsgBitRate:
+        msg = iMsgFactory->CreateMsgBitRate(123);
+        break;
+    case EMsgAudioPcm:
+    {
+        Brn audioBuf(iAudioData, iAudioBytes);
+        MsgAudioPcm* msgPcm = iMsgFactory->CreateMsgAudioPcm(audioBuf, kChannels, kSampleRate, kBitDepth, AudioDataEndian::Little, iTrackOffsetTx);
+        iTrackOffsetTx += msgPcm->Jiffies();
+        msg = msgPcm;
+    }
+        break;
+    case EMsgSilence:
+    {
+        TUint size = Jiffies::kPerMs * 4;
+        msg = iMsgFactory->CreateMsgSilence(size, kSampleRate, kBitDepth, kChannels);
+    }
+        break;
+    case EMsgQuit:
+        msg = iMsgFactory->CreateMsgQuit();
+        break;
+    case EMsgNone:
+    default:
+        ASSERTS();
+        break;
+    }
+    static_cast<IPipelineElementDownstream*>(iSampleRateConverter)->Push(msg);
+}
+
+void SuiteSampleRateConverter::StartStream()
+{
+    EMsgType types[] = { EMsgMode, EMsgTrack, EMsgEncodedStream, EMsgDecodedStream };
+    const size_t numElems = sizeof(types) / sizeof(types[0]);
+    for (size_t i=0; i<numElems; i++) {
+        PushMsg(types[i]);
+    }
+}
+
+void SuiteSampleRateConverter::MsgsPassThrough()
+{
+    EMsgType types[] = { EMsgMode, EMsgTrack, EMsgDrain, EMsgEncodedStream, EMsgDelay,
+                         EMsgMetaText, EMsgStreamInterrupted, EMsgHalt, EMsgFlush, EMsgWait, EMsgDecodedStream,
+                         EMsgBitRate, EMsgAudioPcm, EMsgSilence, EMsgQuit };
+    const size_t numElems = sizeof(types) / sizeof(types[0]);
+    for (size_t i=0; i<numElems; i++) {
+        PushMsg(types[i]);
+        TEST(iLastMsg == types[i]);
+    }
+}
+
+void SuiteSampleRateConverter::SupportedRatePassesThrough()
+{
+    iSupportedRates.push_back(kSampleRate);
+    StartStream();
+    TEST(iLastMsg == EMsgDecodedStream);
+    TEST(iStreamSampleRate == kSampleRate);
+    TEST(iStreamBitDepth == kBitDepth);
+    for (TUint i=0; i<10; i++) {
+        iLastMsg = EMsgNone;
+        PushMsg(EMsgAudioPcm);
+        TEST(iLastMsg == EMsgAudioPcm);
+    }
+    TEST(iAudioMatchesStream);
+    TEST(iJiffiesRx == iTrackOffsetTx);
+    TEST(!iSampleRateConverter->iConverting);
+}
+
+void SuiteSampleRateConverter::UnsupportedRateConverted()
+{
+    iSupportedRates.push_back(48000);
+    iSupportedRates.push_back(96000);
+    StartStream();
+    TEST(iLastMsg == EMsgDecodedStream);
+    TEST(iStreamSampleRate == 48000);
+    TEST(iStreamBitDepth == 24);
+    TEST(iSampleRateConverter->iConverting);
+    PushMsg(EMsgAudioPcm);
+    PushMsg(EMsgAudioPcm);
+    TEST(iLastMsg == EMsgAudioPcm);
+    TEST(iAudioMatchesStream);
+}
+
+void SuiteSampleRateConverter::ConvertedDurationMatchesInput()
+{
+    iSupportedRates.push_back(48000);
+    StartStream();
+    for (TUint i=0; i<100; i++) {
+        PushMsg(EMsgAudioPcm);
+    }
+    TEST(iJiffiesRx < iTrackOffsetTx); // filter delay means some audio is still buffered
+    PushMsg(EMsgHalt);
+    TEST(iLastMsg == EMsgHalt);
+    const TUint64 tolerance = Jiffies::PerSample(48000) * 2;
+    TEST(iJiffiesRx + tolerance >= iTrackOffsetTx);
+    TEST(iJiffiesRx <= iTrackOffsetTx + tolerance);
+    TEST(iTrackOffsetsContiguous);
+}
+
+void SuiteSampleRateConverter::ConvertedSilenceOutputAsAudio()
+{
+    iSupportedRates.push_back(48000);
+    StartStream();
+    iLastMsg = EMsgNone;
+    for (TUint i=0; i<5; i++) {
+        PushMsg(EMsgSilence);
+    }
+    TEST(iLastMsg == EMsgAudioPcm);
+    PushMsg(EMsgDrain);
+    TEST(iLastMsg == EMsgDrain);
+    const TUint64 expected = 5 * Jiffies::kPerMs * 4;
+    const TUint64 tolerance = Jiffies::PerSample(kSampleRate) * 5; // each MsgSilence is rounded to a whole number of samples
+    TEST(iJiffiesRx + tolerance >= expected);
+    TEST(iJiffiesRx <= expected + tolerance);
+}
+
+void SuiteSampleRateConverter::NoSupportedRatePassesThrough()
+{
+    iSupportedRates.push_back(1); // no usable rates
+    StartStream();
+    TEST(iLastMsg == EMsgDecodedStream);
+    TEST(iStreamSampleRate == kSampleRate);
+    TEST(iStreamBitDepth == kBitDepth);
+    PushMsg(EMsgAudioPcm);
+    TEST(iLastMsg == EMsgAudioPcm);
+    TEST(iAudioMatchesStream);
+}
+
+void SuiteSampleRateConverter::PullStartsConversion()
+{
+    iSupportedRates.push_back(kSampleRate);
+    StartStream();
+    for (TUint i=0; i<20; i++) {
+        PushMsg(EMsgAudioPcm);
+    }
+    TEST(!iSampleRateConverter->iConverting);
+    TEST(iJiffiesRx == iTrackOffsetTx);
+    const TUint64 jiffiesBeforePull = iJiffiesRx;
+
+    static_cast<IPullableClock*>(iSampleRateConverter)->PullClock(IPullableClock::kNominalFreq + IPullableClock::kNominalFreq / 200);
+    for (TUint i=0; i<200; i++) {
+        PushMsg(EMsgAudioPcm);
+    }
+    TEST(iSampleRateConverter->iConverting);
+    TEST(iAudioMatchesStream);
+    TEST(iTrackOffsetsContiguous);
+    PushMsg(EMsgDrain);
+    // clock pulled 0.5% fast => 0.5% less output
+    const TUint64 jiffiesIn = iTrackOffsetTx - jiffiesBeforePull;
+    const TUint64 jiffiesOut = iJiffiesRx - jiffiesBeforePull;
+    const TUint64 expected = jiffiesIn - (jiffiesIn / 200);
+    const TUint64 tolerance = Jiffies::PerSample(kSampleRate) * 4;
+    TEST(jiffiesOut + tolerance >= expected);
+    TEST(jiffiesOut <= expected + tolerance);
+
+    // conversion continues for the remainder of the stream
+    static_cast<IPullableClock*>(iSampleRateConverter)->PullClock(IPullableClock::kNominalFreq);
+    PushMsg(EMsgAudioPcm);
+    TEST(iSampleRateConverter->iConverting);
+    PushMsg(EMsgDecodedStream);
+    TEST(!iSampleRateConverter->iConverting);
+}
+
+void SuiteSampleRateConverter::PullConvertsFullSizeMsgs()
+{
+    // pass-through stream so output is 16-bit, filling a full AudioData per msg
+    iAudioBytes = sizeof(iAudioData);
+    iSupportedRates.push_back(kSampleRate);
+    StartStream();
+    PushMsg(EMsgAudioPcm);
+    TEST(!iSampleRateConverter->iConverting);
+    const TUint64 jiffiesBeforePull = iJiffiesRx;
+
+    static_cast<IPullableClock*>(iSampleRateConverter)->PullClock(IPullableClock::kNominalFreq - IPullableClock::kNominalFreq / 200);
+    for (TUint i=0; i<20; i++) {
+        PushMsg(EMsgAudioPcm);
+    }
+    TEST(iSampleRateConverter->iConverting);
+    TEST(iStreamBitDepth == kBitDepth);
+    TEST(iAudioMatchesStream);
+    TEST(iTrackOffsetsContiguous);
+    PushMsg(EMsgDrain);
+    // clock pulled 0.5% slow => 0.5% more output
+    const TUint64 jiffiesIn = iTrackOffsetTx - jiffiesBeforePull;
+    const TUint64 jiffiesOut = iJiffiesRx - jiffiesBeforePull;
+    const TUint64 expected = jiffiesIn + (jiffiesIn / 200);
+    const TUint64 tolerance = Jiffies::PerSample(kSampleRate) * 4;
+    TEST(jiffiesOut + tolerance >= expected);
+    TEST(jiffiesOut <= expected + tolerance);
+}
+
+void SuiteSampleRateConverter::PullClamped()
+{
+    IPullableClock* clock = static_cast<IPullableClock*>(iSampleRateConverter);
+    const TUint maxPull = clock->MaxPull();
+    TEST(maxPull > 0);
+    clock->PullClock(IPullableClock::kNominalFreq * 2);
+    TEST(iSampleRateConverter->iMultiplier.load() == IPullableClock::kNominalFreq + maxPull);
+    clock->PullClock(0);
+    TEST(iSampleRateConverter->iMultiplier.load() == IPullableClock::kNominalFreq - maxPull);
+    clock->PullClock(IPullableClock::kNominalFreq - 1);
+    TEST(iSampleRateConverter->iMultiplier.load() == IPullableClock::kNominalFreq - 1);
+}
+
+void SuiteSampleRateConverter::Push(Msg* aMsg)
+{
+    aMsg = aMsg->Process(*this);
+    if (aMsg != nullptr) {
+        aMsg->RemoveRef();
+    }
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgMode* aMsg)
+{
+    iLastMsg = EMsgMode;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgTrack* aMsg)
+{
+    iLastMsg = EMsgTrack;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgDrain* aMsg)
+{
+    iLastMsg = EMsgDrain;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgDelay* aMsg)
+{
+    iLastMsg = EMsgDelay;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgEncodedStream* aMsg)
+{
+    iLastMsg = EMsgEncodedStream;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgAudioEncoded* aMsg)
+{
+    ASSERTS();
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgMetaText* aMsg)
+{
+    iLastMsg = EMsgMetaText;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgStreamInterrupted* aMsg)
+{
+    iLastMsg = EMsgStreamInterrupted;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgHalt* aMsg)
+{
+    iLastMsg = EMsgHalt;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgFlush* aMsg)
+{
+    iLastMsg = EMsgFlush;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgWait* aMsg)
+{
+    iLastMsg = EMsgWait;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    iLastMsg = EMsgDecodedStream;
+    const DecodedStreamInfo& info = aMsg->StreamInfo();
+    iStreamSampleRate = info.SampleRate();
+    iStreamBitDepth = info.BitDepth();
+    iJiffiesRx = 0;
+    iTrackOffsetRx = info.SampleStart() * Jiffies::PerSample(info.SampleRate());
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgBitRate* aMsg)
+{
+    iLastMsg = EMsgBitRate;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgAudioPcm* aMsg)
+{
+    iLastMsg = EMsgAudioPcm;
+    if (aMsg->TrackOffset() != iTrackOffsetRx) {
+        iTrackOffsetsContiguous = false;
+    }
+    const TUint jiffies = aMsg->Jiffies();
+    iTrackOffsetRx = aMsg->TrackOffset() + jiffies;
+    iJiffiesRx += jiffies;
+    MsgPlayable* playable = aMsg->CreatePlayable();
+    const TUint samples = playable->Bytes() / (kChannels * (iStreamBitDepth / 8));
+    if (jiffies != samples * Jiffies::PerSample(iStreamSampleRate)) {
+        iAudioMatchesStream = false;
+    }
+    playable->RemoveRef();
+    return nullptr;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgSilence* aMsg)
+{
+    iLastMsg = EMsgSilence;
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgPlayable* aMsg)
+{
+    ASSERTS();
+    return aMsg;
+}
+
+Msg* SuiteSampleRateConverter::ProcessMsg(MsgQuit* aMsg)
+{
+    iLastMsg = EMsgQuit;
+    return aMsg;
+}
+
+TUint SuiteSampleRateConverter::PipelineAnimatorBufferJiffies()
+{
+    return 0;
+}
+
+TUint SuiteSampleRateConverter::PipelineAnimatorDelayJiffies(TUint aSampleRate, TUint /*aBitDepth*/, TUint /*aNumChannels*/)
+{
+    if (iSupportedRates.size() > 0) {
+        TBool found = false;
+        for (auto rate : iSupportedRates) {
+            if (rate == aSampleRate) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            THROW(SampleRateUnsupported);
+        }
+    }
+    return Jiffies::kPerMs * 5;
+}
+
+EStreamPlay SuiteSampleRateConverter::OkToPlay(TUint /*aStreamId*/)
+{
+    return ePlayNo;
+}
+
+TUint SuiteSampleRateConverter::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint SuiteSampleRateConverter::TryDiscard(TUint /*aJiffies*/)
+{
+    ASSERTS();
+    return MsgFlush::kIdInvalid;
+}
+
+TUint SuiteSampleRateConverter::TryStop(TUint /*aStreamId*/)
+{
+    return MsgFlush::kIdInvalid;
+}
+
+void SuiteSampleRateConverter::NotifyStarving(const Brx& /*aMode*/, TUint /*aStreamId*/, TBool /*aStarving*/)
+{
+    ASSERTS();
+}
+
+
+// SuiteResampler
+
+SuiteResampler::SuiteResampler()
+    : Suite("Resampler tests")
+{
+}
+
+void SuiteResampler::Test()
+{
+    TestUnityBitExact();
+    TestThdN(44100, 48000, 1000, IPullableClock::kNominalFreq);
+    TestThdN(48000, 44100, 1000, IPullableClock::kNominalFreq);
+    TestThdN(44100, 96000, 10000, IPullableClock::kNominalFreq);
+    TestThdN(96000, 44100, 15000, IPullableClock::kNominalFreq);
+    TestThdN(44100, 44100, 1000, IPullableClock::kNominalFreq + IPullableClock::kNominalFreq / 1000);
+    TestThdN(48000, 48000, 1000, IPullableClock::kNominalFreq - IPullableClock::kNominalFreq / 1000);
+    TestOutputCount(44100, 48000);
+    TestOutputCount(96000, 44100);
+    TestOutputCount(8000, 192000);
+}
+
+void SuiteResampler::TestUnityBitExact()
+{
+    Resampler resampler(kMaxInputFrames);
+    resampler.Configure(48000, 48000, 2);
+    std::vector<TInt32> input(kMaxInputFrames * 2);
+    std::vector<TInt32> output(kMaxInputFrames * 4);
+    TInt32 val = 0x7f000000;
+    for (auto& sample : input) {
+        sample = val;
+        val = (TInt32)((TUint32)val * 1103515245u + 12345u) & ~0xff; // arbitrary 24-bit audio
+    }
+    resampler.Push(&input[0], kMaxInputFrames);
+    TUint frames = resampler.Pull(&output[0], kMaxInputFrames * 2);
+    resampler.Drain();
+    frames += resampler.Pull(&output[frames * 2], kMaxInputFrames * 2 - frames);
+    TEST(frames == kMaxInputFrames);
+    TUint mismatches = 0;
+    for (TUint i=0; i<frames*2; i++) {
+        if (output[i] != input[i]) {
+            mismatches++;
+        }
+    }
+    TEST(mismatches == 0);
+}
+
+void SuiteResampler::TestThdN(TUint aRateIn, TUint aRateOut, TUint aFreq, TUint aMultiplier)
+{
+    static const double kPi = 3.14159265358979;
+    Resampler resampler(kMaxInputFrames);
+    resampler.Configure(aRateIn, aRateOut, 1);
+    resampler.SetPull(aMultiplier);
+    const TUint inputFrames = aRateIn; // 1s
+    std::vector<TInt32> input(inputFrames);
+    for (TUint i=0; i<inputFrames; i++) {
+        input[i] = (TInt32)lrint(sin(2 * kPi * aFreq * i / aRateIn) * 0.5 * 8388607) * 256;
+    }
+    std::vector<TInt32> output((size_t)(((TUint64)inputFrames * aRateOut) / aRateIn) * 2 + 1024);
+    TUint outputFrames = 0;
+    for (TUint i=0; i<inputFrames; i+=kMaxInputFrames) {
+        resampler.Push(&input[i], std::min(kMaxInputFrames, inputFrames - i));
+        outputFrames += resampler.Pull(&output[outputFrames], (TUint)output.size() - outputFrames);
+    }
+    resampler.Drain();
+    outputFrames += resampler.Pull(&output[outputFrames], (TUint)output.size() - outputFrames);
+
+    // least squares fit of a sine at the (pulled) output frequency over the middle of the output
+    const double freq = (double)aFreq * aMultiplier / IPullableClock::kNominalFreq;
+    const TUint start = outputFrames / 4;
+    const TUint end = (outputFrames * 3) / 4;
+    double ss = 0, cc = 0, sc = 0, sy = 0, cy = 0;
+    for (TUint i=start; i<end; i++) {
+        const double s = sin(2 * kPi * freq * i / aRateOut);
+        const double c = cos(2 * kPi * freq * i / aRateOut);
+        const double y = output[i] / 2147483648.0;
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        sy += s * y;
+        cy += c * y;
+    }
+    const double det = ss * cc - sc * sc;
+    const double a = (sy * cc - cy * sc) / det;
+    const double b = (cy * ss - sy * sc) / det;
+    double signal = 0, noise = 0;
+    for (TUint i=start; i<end; i++) {
+        const double fit = a * sin(2 * kPi * freq * i / aRateOut) + b * cos(2 * kPi * freq * i / aRateOut);
+        const double err = output[i] / 2147483648.0 - fit;
+        signal += fit * fit;
+        noise += err * err;
+    }
+    const double thdn = 10 * log10(noise / signal);
+    Print("%u -> %u, %uHz, multiplier %u: THD+N %ddB\n", aRateIn, aRateOut, aFreq, aMultiplier, (TInt)thdn);
+    TEST(thdn < -90);
+}
+
+void SuiteResampler::TestOutputCount(TUint aRateIn, TUint aRateOut)
+{
+    Resampler resampler(kMaxInputFrames);
+    resampler.Configure(aRateIn, aRateOut, 2);
+    std::vector<TInt32> input(kMaxInputFrames * 2, 0x10000000);
+    const TUint maxOutput = (TUint)(((TUint64)kMaxInputFrames * aRateOut) / aRateIn) + 2;
+    std::vector<TInt32> output(maxOutput * 2);
+    TUint64 inputFrames = 0;
+    TUint64 outputFrames = 0;
+    for (TUint i=0; i<100; i++) {
+        resampler.Push(&input[0], kMaxInputFrames);
+        inputFrames += kMaxInputFrames;
+        outputFrames += resampler.Pull(&output[0], maxOutput);
+    }
+    resampler.Drain();
+    for (;;) {
+        const TUint frames = resampler.Pull(&output[0], maxOutput);
+        if (frames == 0) {
+            break;
+        }
+        outputFrames += frames;
+    }
+    const TUint64 expected = (inputFrames * aRateOut) / aRateIn;
+    TEST(outputFrames + 1 >= expected);
+    TEST(outputFrames <= expected + 1);
+}
+
+
+
+void TestSampleRateConverter()
+{
+    Runner runner("SampleRateConverter tests\n");
+    runner.Add(new SuiteSampleRateConverter());
+    runner.Add(new SuiteResampler());
+    runner.Run();
+}
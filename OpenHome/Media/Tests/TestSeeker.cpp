@@ -15,9 +15,10 @@ using namespace OpenHome::Media;
 namespace OpenHome {
 namespace Media {
 
-class SuiteSeeker : public SuiteUnitTest, private IPipelineElementUpstream, private ISeeker, private ISeekRestreamer, private IStreamHandler, private IMsgProcessor
+class SuiteSeeker : public SuiteUnitTest, private IPipelineElementUpstream, private ISeeker, private ISeekRestreamer, private IDecodedAudioBuffer, private IStreamHandler, private IMsgProcessor
 {
     static const TUint kRampDuration = Jiffies::kPerMs * 20;
+    static const TUint kHistoryJiffies = Jiffies::kPerMs * 50;
     static const TUint kExpectedFlushId = 5;
     static const TUint kExpectedSeekSeconds = 51;
     static const TUint kSampleRate = 44100;
@@ -36,6 +37,8 @@ private: // from ISeeker
     void StartSeek(TUint aStreamId, TUint aSecondsAbsolute, ISeekObserver& aObserver, TUint& aHandle) override;
 private: // from ISeekRestreamer
     TUint SeekRestream(const Brx& aMode, TUint aTrackId) override;
+private: // from IDecodedAudioBuffer
+    TUint BufferedJiffies(TUint aStreamId) const override;
 private: // from IStreamHandler
     EStreamPlay OkToPlay(TUint aStreamId) override;
     TUint TrySeek(TUint aStreamId, TUint64 aOffset) override;
@@ -98,7 +101,12 @@ private:
     void TestNewStreamCancelsRampDownAndSeek();
     void TestOverlappingSeekIgnored();
     void TestSeekForwardFailStillSeeks();
+    void TestSeekForwardWithinBufferedAudio();
+    void TestSeekForwardBeyondBufferedAudio();
+    void TestSeekBackwardWithinHistory();
+    void TestSeekBackwardBeyondHistory();
 private:
+    void StartStreamAt(TUint64 aTrackOffset);
     AllocatorInfoLogger iInfoAggregator;
     TrackFactory* iTrackFactory;
     MsgFactory* iMsgFactory;
@@ -124,6 +132,7 @@ private:
     TUint iNextSeekResponse;
     TUint iSeekSeconds;
     ThreadFunctor* iSeekResponseThread;
+    TUint iBufferedJiffies;
 };
 
 } // namespace Media
@@ -150,6 +159,10 @@ SuiteSeeker::SuiteSeeker()
     AddTest(MakeFunctor(*this, &SuiteSeeker::TestNewStreamCancelsRampDownAndSeek), "TestNewStreamCancelsRampDownAndSeek");
     AddTest(MakeFunctor(*this, &SuiteSeeker::TestOverlappingSeekIgnored), "TestOverlappingSeekIgnored");
     AddTest(MakeFunctor(*this, &SuiteSeeker::TestSeekForwardFailStillSeeks), "TestSeekForwardFailStillSeeks");
+    AddTest(MakeFunctor(*this, &SuiteSeeker::TestSeekForwardWithinBufferedAudio), "TestSeekForwardWithinBufferedAudio");
+    AddTest(MakeFunctor(*this, &SuiteSeeker::TestSeekForwardBeyondBufferedAudio), "TestSeekForwardBeyondBufferedAudio");
+    AddTest(MakeFunctor(*this, &SuiteSeeker::TestSeekBackwardWithinHistory), "TestSeekBackwardWithinHistory");
+    AddTest(MakeFunctor(*this, &SuiteSeeker::TestSeekBackwardBeyondHistory), "TestSeekBackwardBeyondHistory");
 }
 
 SuiteSeeker::~SuiteSeeker()
@@ -160,16 +173,16 @@ void SuiteSeeker::Setup()
 {
     iTrackFactory = new TrackFactory(iInfoAggregator, 5);
     MsgFactoryInitParams init;
-    init.SetMsgAudioPcmCount(5, 5);
+    init.SetMsgAudioPcmCount(30, 30); // allows for kHistoryJiffies of audio retained by Seeker
     init.SetMsgSilenceCount(10);
-    init.SetMsgDecodedStreamCount(2);
+    init.SetMsgDecodedStreamCount(3);
     init.SetMsgTrackCount(2);
     init.SetMsgEncodedStreamCount(2);
     init.SetMsgMetaTextCount(2);
     init.SetMsgHaltCount(2);
     init.SetMsgFlushCount(2);
     iMsgFactory = new MsgFactory(iInfoAggregator, init);
-    iSeeker = new Seeker(*iMsgFactory, *this, *this, *this, kRampDuration);
+    iSeeker = new Seeker(*iMsgFactory, *this, *this, *this, *this, kRampDuration, kHistoryJiffies);
     iSeekResponseThread = new ThreadFunctor("SeekResponse", MakeFunctor(*this, &SuiteSeeker::SeekResponseThread));
     iSeekResponseThread->Start();
     iStreamId = UINT_MAX;
@@ -190,6 +203,7 @@ void SuiteSeeker::Setup()
     iSeekerResponse.Clear();
     iNextSeekResponse = MsgFlush::kIdInvalid;
     iSeekSeconds = UINT_MAX;
+    iBufferedJiffies = 0;
 }
 
 void SuiteSeeker::TearDown()
@@ -234,6 +248,11 @@ TUint SuiteSeeker::SeekRestream(const Brx& /*aMode*/, TUint /*aTrackId*/)
     return MsgFlush::kIdInvalid;
 }
 
+TUint SuiteSeeker::BufferedJiffies(TUint aStreamId) const
+{
+    return (aStreamId == iStreamId? iBufferedJiffies : 0);
+}
+
 TUint SuiteSeeker::TrySeek(TUint /*aStreamId*/, TUint64 /*aOffset*/)
 {
     ASSERTS();
@@ -448,6 +467,19 @@ Msg* SuiteSeeker::CreateAudio()
     return audio;
 }
 
+void SuiteSeeker::StartStreamAt(TUint64 aTrackOffset)
+{
+    iTrackOffset = aTrackOffset;
+    iPendingMsgs.push_back(CreateTrack());
+    iPendingMsgs.push_back(CreateEncodedStream());
+    iPendingMsgs.push_back(CreateDecodedStream());
+    iPendingMsgs.push_back(CreateAudio());
+    for (TUint i=0; i<4; i++) {
+        PullNext();
+    }
+    TEST(iLastPulledMsg == EMsgAudioPcm);
+}
+
 void SuiteSeeker::SeekResponseThread()
 {
     iSeekResponseThread->Wait();
@@ -771,6 +803,97 @@ void SuiteSeeker::TestSeekForwardFailStillSeeks()
     }
 }
 
+void SuiteSeeker::TestSeekForwardWithinBufferedAudio()
+{
+    StartStreamAt(0);
+    iBufferedJiffies = Jiffies::kPerSecond * 2;
+    static const TUint kSeekSecs = 1;
+    iSeeker->Seek(iStreamId, kSeekSecs, false);
+    TEST(iSeekSeconds == UINT_MAX); // i.e. StartSeek has not been called
+    TEST(iSeeker->iSeekPending);
+    PullNext(EMsgHalt);
+    TEST(iSeeker->iState == Seeker::EFlushing);
+    iGenerateAudio = true;
+    PullNext(EMsgDecodedStream);
+    TEST(iStreamSampleStart == kSeekSecs * kSampleRate);
+    iGenerateAudio = false;
+    iRampingUp = true;
+    iLastSubsample = 0;
+    PullNext(EMsgAudioPcm);
+    TEST(iTrackOffsetPulled == (kSeekSecs * Jiffies::kPerSecond) + iLastMsgAudioSize);
+    while (iRampingUp) {
+        iPendingMsgs.push_back(CreateAudio());
+        PullNext(EMsgAudioPcm);
+    }
+}
+
+void SuiteSeeker::TestSeekForwardBeyondBufferedAudio()
+{
+    StartStreamAt(0);
+    iBufferedJiffies = Jiffies::kPerMs * 500;
+    static const TUint kSeekSecs = 1;
+    iNextSeekResponse = kExpectedFlushId;
+    iSeeker->Seek(iStreamId, kSeekSecs, false);
+    iSeekerResponse.Wait();
+    TEST(iSeekSeconds == kSeekSecs);
+    PullNext(EMsgHalt);
+    TEST(iSeeker->iQueue.IsEmpty());
+}
+
+void SuiteSeeker::TestSeekBackwardWithinHistory()
+{
+    static const TUint kSeekSecs = 10;
+    StartStreamAt((kSeekSecs * Jiffies::kPerSecond) - (Jiffies::kPerMs * 20));
+    while (iTrackOffset < (kSeekSecs * Jiffies::kPerSecond) + (Jiffies::kPerMs * 20)) {
+        iPendingMsgs.push_back(CreateAudio());
+        PullNext(EMsgAudioPcm);
+    }
+    const TUint64 upstreamJiffies = iTrackOffset;
+
+    iSeeker->Seek(iStreamId, kSeekSecs, false);
+    TEST(iSeekSeconds == UINT_MAX); // i.e. StartSeek has not been called
+    // replay is only queued from the pull thread; a msg it is processing can't overtake the replay
+    TEST(iSeeker->iSeekPending);
+    TEST(iSeeker->iQueue.IsEmpty());
+    TEST_THROWS(iSeeker->Seek(iStreamId, kSeekSecs, false), SeekAlreadyInProgress);
+    PullNext(EMsgHalt);
+    TEST(!iSeeker->iSeekPending);
+    PullNext(EMsgDecodedStream);
+    TEST(iStreamSampleStart == kSeekSecs * kSampleRate);
+
+    // audio from the seek point is replayed, ramping up
+    iRampingUp = true;
+    iLastSubsample = 0;
+    iJiffies = 0;
+    while (!iSeeker->iQueue.IsEmpty()) {
+        PullNext(EMsgAudioPcm);
+    }
+    TEST(iJiffies == upstreamJiffies - (kSeekSecs * Jiffies::kPerSecond));
+    TEST(iTrackOffsetPulled == upstreamJiffies);
+
+    // ...then continues seamlessly with audio from upstream
+    iPendingMsgs.push_back(CreateAudio());
+    PullNext(EMsgAudioPcm);
+    TEST(iTrackOffsetPulled == iTrackOffset);
+}
+
+void SuiteSeeker::TestSeekBackwardBeyondHistory()
+{
+    static const TUint kSeekSecs = 10;
+    StartStreamAt(kSeekSecs * Jiffies::kPerSecond);
+    for (TUint i=0; i<4; i++) {
+        iPendingMsgs.push_back(CreateAudio());
+        PullNext(EMsgAudioPcm);
+    }
+
+    // history doesn't extend back beyond the start of the current stream
+    iNextSeekResponse = kExpectedFlushId;
+    iSeeker->Seek(iStreamId, kSeekSecs - 1, false);
+    iSeekerResponse.Wait();
+    TEST(iSeekSeconds == kSeekSecs - 1);
+    PullNext(EMsgHalt);
+}
+
 
 void TestSeeker()
 {
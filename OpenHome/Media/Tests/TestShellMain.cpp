@@ -11,6 +11,8 @@ using namespace OpenHome::Media;
 using namespace OpenHome::Media::Codec;
 
 SIMPLE_TEST_DECLARATION(TestAudioReservoir);
+ENV_TEST_DECLARATION(TestAnimatorBasic);
+SIMPLE_TEST_DECLARATION(TestClockPuller);
 SIMPLE_TEST_DECLARATION(TestCodecController);
 SIMPLE_TEST_DECLARATION(TestConfigManager);
 SIMPLE_TEST_DECLARATION(TestContainer);
@@ -18,6 +20,9 @@ SIMPLE_TEST_DECLARATION(TestContentProcessor);
 SIMPLE_TEST_DECLARATION(TestDecodedAudioAggregator);
 SIMPLE_TEST_DECLARATION(TestIdProvider);
 SIMPLE_TEST_DECLARATION(TestFiller);
+ENV_TEST_DECLARATION(TestPrerollCache);
+ENV_TEST_DECLARATION(TestHostResolver);
+ENV_TEST_DECLARATION(TestBinaryLogger);
 SIMPLE_TEST_DECLARATION(TestToneGenerator);
 SIMPLE_TEST_DECLARATION(TestMuteManager);
 SIMPLE_TEST_DECLARATION(TestMsg);
@@ -28,6 +33,7 @@ SIMPLE_TEST_DECLARATION(TestProtocolHttp);
 SIMPLE_TEST_DECLARATION(TestRamper);
 SIMPLE_TEST_DECLARATION(TestReporter);
 SIMPLE_TEST_DECLARATION(TestRewinder);
+SIMPLE_TEST_DECLARATION(TestSampleRateConverter);
 SIMPLE_TEST_DECLARATION(TestSampleRateValidator);
 SIMPLE_TEST_DECLARATION(TestSeeker);
 SIMPLE_TEST_DECLARATION(TestSkipper);
@@ -42,6 +48,7 @@ SIMPLE_TEST_DECLARATION(TestStopper);
 SIMPLE_TEST_DECLARATION(TestStore);
 SIMPLE_TEST_DECLARATION(TestSupply);
 SIMPLE_TEST_DECLARATION(TestSupplyAggregator);
+SIMPLE_TEST_DECLARATION(TestFileSource);
 SIMPLE_TEST_DECLARATION(TestTrackDatabase);
 SIMPLE_TEST_DECLARATION(TestTrackInspector);
 SIMPLE_TEST_DECLARATION(TestUriProviderRepeater);
@@ -54,6 +61,7 @@ SIMPLE_TEST_DECLARATION(TestVolumeManager);
 ENV_TEST_DECLARATION(TestFlywheelRamper);
 ENV_TEST_DECLARATION(TestRaop);
 ENV_TEST_DECLARATION(TestUdpServer);
+ENV_TEST_DECLARATION(TestStreamUrlResolver);
 SIMPLE_TEST_DECLARATION(TestPowerManager);
 ENV_TEST_DECLARATION(TestProtocolHls);
 ENV_TEST_DECLARATION(TestSsl);
@@ -61,6 +69,7 @@ ENV_TEST_DECLARATION(TestWebAppFramework);
 CP_DV_TEST_DECLARATION(TestCredentials);
 CP_DV_TEST_DECLARATION(TestUpnpErrors);
 CP_DV_TEST_DECLARATION(TestDvOdp);
+CP_DV_TEST_DECLARATION(TestOdpCoalescing);
 ENV_TEST_DECLARATION(TestSocket);
 
 
@@ -78,6 +87,8 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
 {
     std::vector<ShellTest> shellTests;
     shellTests.push_back(ShellTest("TestAudioReservoir", ShellTestAudioReservoir));
+    shellTests.push_back(ShellTest("TestAnimatorBasic", ShellTestAnimatorBasic));
+    shellTests.push_back(ShellTest("TestClockPuller", ShellTestClockPuller));
     shellTests.push_back(ShellTest("TestCodecController", ShellTestCodecController));
     shellTests.push_back(ShellTest("TestConfigManager", ShellTestConfigManager));
     shellTests.push_back(ShellTest("TestContainer", ShellTestContainer));
@@ -85,6 +96,9 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestDecodedAudioAggregator", ShellTestDecodedAudioAggregator));
     shellTests.push_back(ShellTest("TestIdProvider", ShellTestIdProvider));
     shellTests.push_back(ShellTest("TestFiller", ShellTestFiller));
+    shellTests.push_back(ShellTest("TestPrerollCache", ShellTestPrerollCache));
+    shellTests.push_back(ShellTest("TestHostResolver", ShellTestHostResolver));
+    shellTests.push_back(ShellTest("TestBinaryLogger", ShellTestBinaryLogger));
     shellTests.push_back(ShellTest("TestToneGenerator", ShellTestToneGenerator));
     shellTests.push_back(ShellTest("TestMuteManager", ShellTestMuteManager));
     shellTests.push_back(ShellTest("TestMsg", ShellTestMsg));
@@ -97,6 +111,7 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestProtocolHttp", ShellTestProtocolHttp));
     shellTests.push_back(ShellTest("TestRamper", ShellTestRamper));
     shellTests.push_back(ShellTest("TestReporter", ShellTestReporter));
+    shellTests.push_back(ShellTest("TestSampleRateConverter", ShellTestSampleRateConverter));
     shellTests.push_back(ShellTest("TestSampleRateValidator", ShellTestSampleRateValidator));
     shellTests.push_back(ShellTest("TestSeeker", ShellTestSeeker));
     shellTests.push_back(ShellTest("TestSkipper", ShellTestSkipper));
@@ -111,6 +126,7 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestStore", ShellTestStore));
     shellTests.push_back(ShellTest("TestSupply", ShellTestSupply));
     shellTests.push_back(ShellTest("TestSupplyAggregator", ShellTestSupplyAggregator));
+    shellTests.push_back(ShellTest("TestFileSource", ShellTestFileSource));
     shellTests.push_back(ShellTest("TestTrackDatabase", ShellTestTrackDatabase));
     shellTests.push_back(ShellTest("TestTrackInspector", ShellTestTrackInspector));
     shellTests.push_back(ShellTest("TestUriProviderRepeater", ShellTestUriProviderRepeater));
@@ -121,11 +137,13 @@ void OpenHome::TestFramework::Runner::Main(TInt /*aArgc*/, TChar* /*aArgv*/[], N
     shellTests.push_back(ShellTest("TestUdpServer", ShellTestUdpServer));
     shellTests.push_back(ShellTest("TestUpnpErrors", ShellTestUpnpErrors));
     shellTests.push_back(ShellTest("TestDvOdp", ShellTestDvOdp));
+    shellTests.push_back(ShellTest("TestOdpCoalescing", ShellTestOdpCoalescing));
     shellTests.push_back(ShellTest("TestJson", ShellTestJson));
     //shellTests.push_back(ShellTest("TestSpotifyReporter", ShellTestSpotifyReporter));
     shellTests.push_back(ShellTest("TestCredentials", ShellTestCredentials));
     shellTests.push_back(ShellTest("TestFriendlyNameManager", ShellTestFriendlyNameManager));
     shellTests.push_back(ShellTest("TestVolumeManager", ShellTestVolumeManager));
+    shellTests.push_back(ShellTest("TestStreamUrlResolver", ShellTestStreamUrlResolver));
     shellTests.push_back(ShellTest("TestFlywheelRamper", ShellTestFlywheelRamper));
     shellTests.push_back(ShellTest("TestRaop", ShellTestRaop));
     shellTests.push_back(ShellTest("TestWebAppFramework", ShellTestWebAppFramework));
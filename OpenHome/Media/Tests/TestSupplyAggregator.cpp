@@ -42,6 +42,7 @@ public:
     void Test() override;
 private:
     void OutputNextNonAudioMsg();
+    void OutputDataDirect(const Brx& aData);
 private: // from IPipelineElementDownstream
     void Push(Msg* aMsg) override;
 private: // from IMsgProcessor
@@ -81,7 +82,7 @@ private:
     MsgFactory* iMsgFactory;
     TrackFactory* iTrackFactory;
     AllocatorInfoLogger iInfoAggregator;
-    SupplyAggregator* iSupply;
+    SupplyAggregatorBytes* iSupply;
     DummyStreamHandler iDummyStreamHandler;
     EMsgType iLastMsg;
     EMsgType iGenMsgType;
@@ -199,6 +200,47 @@ void SuiteSupplyAggregator::Test()
         TEST(iMsgPushCount == expectedMsgCount);
     }
     TEST(iMsgPushCount == ++expectedMsgCount);
+
+    // data written directly is buffered into full msgs
+    const Brn testData(kTestData);
+    iExpectFullAudioMsg = true;
+    iExpectAudioStream = true;
+    iTestAudioData = true;
+    do {
+        OutputDataDirect(testData);
+    } while (expectedMsgCount == iMsgPushCount);
+    TEST(++expectedMsgCount == iMsgPushCount);
+
+    // copied data can follow direct writes in a single msg.  A direct write after copied data starts a new msg
+    iExpectFullAudioMsg = false;
+    OutputDataDirect(testData);
+    iSupply->OutputData(testData);
+    TEST(iMsgPushCount == expectedMsgCount);
+    OutputDataDirect(testData);
+    TEST(iMsgPushCount == ++expectedMsgCount);
+    TEST(iAudio.Bytes() == 2 * testData.Bytes());
+    iSupply->Flush();
+    TEST(iMsgPushCount == ++expectedMsgCount);
+    TEST(iAudio.Bytes() == testData.Bytes());
+
+    // requesting more space than the current msg has left outputs it
+    OutputDataDirect(testData);
+    {
+        Bwn buf = iSupply->WritableData(EncodedAudio::kMaxBytes);
+        TEST(iMsgPushCount == ++expectedMsgCount);
+        TEST(buf.MaxBytes() == EncodedAudio::kMaxBytes);
+        iSupply->CommitData(0);
+    }
+
+    // empty writable msgs aren't output
+    iSupply->Flush();
+    TEST(iMsgPushCount == expectedMsgCount);
+
+    // other msgs flush data written directly
+    OutputDataDirect(testData);
+    iSupply->OutputWait();
+    TEST(iMsgPushCount == expectedMsgCount+2);
+    TEST(iLastMsg == EMsgWait);
 }
 
 void SuiteSupplyAggregator::OutputNextNonAudioMsg()
@@ -236,6 +278,13 @@ void SuiteSupplyAggregator::OutputNextNonAudioMsg()
     iGenMsgType = (EMsgType)((TUint)iGenMsgType + 1);
 }
 
+void SuiteSupplyAggregator::OutputDataDirect(const Brx& aData)
+{
+    Bwn buf = iSupply->WritableData(aData.Bytes());
+    buf.Append(aData);
+    iSupply->CommitData(buf.Bytes());
+}
+
 void SuiteSupplyAggregator::Push(Msg* aMsg)
 {
     aMsg->Process(*this)->RemoveRef();
@@ -7,6 +7,12 @@
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Media/Debug.h>
 
+#include <cmath>
+#ifdef __linux__
+# include <errno.h>
+# include <time.h>
+#endif
+
 using namespace OpenHome;
 using namespace OpenHome::Media;
 
@@ -43,17 +49,35 @@ const TUint AnimatorBasic::kSupportedMsgTypes =   eMode
                                                 | ePlayable
                                                 | eQuit;
 
-AnimatorBasic::AnimatorBasic(Environment& aEnv, IPipeline& aPipeline, TBool aPullable)
+AnimatorBasic::JitterStats::JitterStats()
+    : iWakeups(0)
+    , iLateMinUs(0)
+    , iLateMaxUs(0)
+    , iLateMeanUs(0)
+    , iLateStdDevUs(0)
+    , iDropouts(0)
+    , iElapsedUs(0)
+    , iJiffiesPlayed(0)
+{
+}
+
+AnimatorBasic::AnimatorBasic(Environment& aEnv, IPipeline& aPipeline, TBool aPullable, TUint aPeriodMs, EPacing aPacing)
     : PipelineElement(kSupportedMsgTypes)
     , iPipeline(aPipeline)
     , iSem("DRVB", 0)
     , iOsCtx(aEnv.OsCtx())
     , iPullable(aPullable)
+    , iPeriodMs(aPeriodMs)
+    , iPacing(aPacing)
     , iSampleRate(0)
+    , iCarryJiffies(0)
     , iPlayable(nullptr)
     , iPullValue(IPullableClock::kNominalFreq)
     , iQuit(false)
+    , iLockStats("DRVS")
 {
+    ASSERT(iPeriodMs >= kPeriodMsMin && iPeriodMs <= kPeriodMsMax);
+    ResetJitterStats();
     iPipeline.SetAnimator(*this);
     iThread = new ThreadFunctor("PipelineAnimator", MakeFunctor(*this, &AnimatorBasic::DriverThread), kPrioritySystemHighest);
     iThread->Start();
@@ -64,6 +88,39 @@ AnimatorBasic::~AnimatorBasic()
     delete iThread;
 }
 
+void AnimatorBasic::GetJitterStats(JitterStats& aStats)
+{
+    AutoMutex _(iLockStats);
+    aStats.iWakeups = iWakeups;
+    aStats.iLateMinUs = (iWakeups == 0? 0 : iLateMinNs / 1000);
+    aStats.iLateMaxUs = iLateMaxNs / 1000;
+    aStats.iLateMeanUs = (iWakeups == 0? 0 : (iLateSumNs / iWakeups) / 1000);
+    if (iWakeups > 1) {
+        const double mean = (double)iLateSumNs / 1000 / iWakeups;
+        const double variance = (iLateSumSqUs / iWakeups) - (mean * mean);
+        aStats.iLateStdDevUs = (variance <= 0? 0 : (TUint64)sqrt(variance));
+    }
+    else {
+        aStats.iLateStdDevUs = 0;
+    }
+    aStats.iDropouts = iDropouts;
+    aStats.iElapsedUs = (NowNs() - iStatsStartNs) / 1000;
+    aStats.iJiffiesPlayed = iJiffiesPlayed;
+}
+
+void AnimatorBasic::ResetJitterStats()
+{
+    AutoMutex _(iLockStats);
+    iStatsStartNs = NowNs();
+    iWakeups = 0;
+    iLateMinNs = 0;
+    iLateMaxNs = 0;
+    iLateSumNs = 0;
+    iLateSumSqUs = 0;
+    iDropouts = 0;
+    iJiffiesPlayed = 0;
+}
+
 void AnimatorBasic::DriverThread()
 {
     // pull the first (assumed non-audio) msg here so that any delays populating the pipeline don't affect timing calculations below.
@@ -73,49 +130,12 @@ void AnimatorBasic::DriverThread()
         (void)msg->Process(*this);
     }
 
-    TUint64 now = OsTimeInUs(iOsCtx);
-    iLastTimeUs = now;
-    iNextTimerDuration = kTimerFrequencyMs;
-    iPendingJiffies = kTimerFrequencyMs * Jiffies::kPerMs;
     try {
-        for (;;) {
-            while (iPendingJiffies > 0) {
-                if (iPlayable != nullptr) {
-                    ProcessAudio(iPlayable);
-                }
-                else {
-                    Msg* msg = iPipeline.Pull();
-                    msg = msg->Process(*this);
-                    ASSERT(msg == nullptr);
-                }
-            }
-            if (iQuit) {
-                break;
-            }
-            iLastTimeUs = now;
-            if (iNextTimerDuration != 0) {
-                try {
-                    iSem.Wait(iNextTimerDuration);
-                }
-                catch (Timeout&) {}
-            }
-            iNextTimerDuration = kTimerFrequencyMs;
-            now = OsTimeInUs(iOsCtx);
-            const TUint diffMs = ((TUint)(now - iLastTimeUs + 500)) / 1000;
-            if (diffMs > 100) { // assume delay caused by drop-out.  process regular amount of audio
-                iPendingJiffies = kTimerFrequencyMs * Jiffies::kPerMs;
-            }
-            else {
-                iPendingJiffies = diffMs * Jiffies::kPerMs;
-                if (iPullValue != IPullableClock::kNominalFreq) {
-                    TInt64 pending64 = iPullValue * iPendingJiffies;
-                    pending64 /= IPullableClock::kNominalFreq;
-                    //Log::Print("iPendingJiffies=%08x, pull=%08x\n", iPendingJiffies, pending64); // FIXME
-                    //TInt pending = (TInt)iPendingJiffies + (TInt)pending64;
-                    //Log::Print("Pulled clock, now want %u jiffies (%ums, %d%%) extra\n", (TUint)pending, Jiffies::ToMs(pending), (pending-(TInt)iPendingJiffies)/iPendingJiffies); // FIXME
-                    iPendingJiffies = (TUint)pending64;
-                }
-            }
+        if (iPacing == ePacingPrecise) {
+            PacePrecise();
+        }
+        else {
+            PaceCoarse();
         }
     }
     catch (ThreadKill&) {}
@@ -131,6 +151,100 @@ void AnimatorBasic::DriverThread()
     }
 }
 
+void AnimatorBasic::PaceCoarse()
+{
+    TUint64 now = OsTimeInUs(iOsCtx);
+    iLastTimeUs = now;
+    iNextTimerDuration = iPeriodMs;
+    iPendingJiffies = iPeriodMs * Jiffies::kPerMs;
+    for (;;) {
+        ProcessPending();
+        if (iQuit) {
+            break;
+        }
+        iLastTimeUs = now;
+        const TUint timerDuration = iNextTimerDuration;
+        if (timerDuration != 0) {
+            try {
+                iSem.Wait(timerDuration);
+            }
+            catch (Timeout&) {}
+        }
+        iNextTimerDuration = iPeriodMs;
+        now = OsTimeInUs(iOsCtx);
+        const TUint64 elapsedUs = now - iLastTimeUs;
+        const TUint diffMs = ((TUint)(elapsedUs + 500)) / 1000;
+        const TBool dropout = (diffMs > kDropoutMs);
+        if (timerDuration != 0) {
+            const TUint64 expectedUs = timerDuration * 1000;
+            RecordWakeup((elapsedUs > expectedUs? (elapsedUs - expectedUs) * 1000 : 0), dropout);
+        }
+        if (dropout) { // assume delay caused by drop-out.  process regular amount of audio
+            iPendingJiffies = iPeriodMs * Jiffies::kPerMs;
+        }
+        else {
+            iPendingJiffies = diffMs * Jiffies::kPerMs;
+            if (iPullValue != IPullableClock::kNominalFreq) {
+                TInt64 pending64 = iPullValue * iPendingJiffies;
+                pending64 /= IPullableClock::kNominalFreq;
+                //Log::Print("iPendingJiffies=%08x, pull=%08x\n", iPendingJiffies, pending64); // FIXME
+                //TInt pending = (TInt)iPendingJiffies + (TInt)pending64;
+                //Log::Print("Pulled clock, now want %u jiffies (%ums, %d%%) extra\n", (TUint)pending, Jiffies::ToMs(pending), (pending-(TInt)iPendingJiffies)/iPendingJiffies); // FIXME
+                iPendingJiffies = (TUint)pending64;
+            }
+        }
+    }
+}
+
+void AnimatorBasic::PacePrecise()
+{
+    /* Each period is accounted for in exact jiffies (every supported sample rate has an integer
+       number of jiffies per ms).  Anything short of a whole sample is carried to the next period
+       and the fractional part of any pulled period is carried in pullRemainder so that, over time,
+       the audio consumed exactly matches the time elapsed. */
+    const TUint64 periodNs = (TUint64)iPeriodMs * 1000000;
+    const TUint64 dropoutNs = (TUint64)kDropoutMs * 1000000;
+    TUint64 pullRemainder = 0;
+    TUint64 deadline = NowNs();
+    iPendingJiffies = PeriodJiffies(iPeriodMs, iPullValue, pullRemainder);
+    for (;;) {
+        ProcessPending();
+        if (iQuit) {
+            break;
+        }
+        deadline += periodNs;
+        SleepUntilNs(deadline);
+        const TUint64 now = NowNs();
+        const TUint64 lateNs = (now > deadline? now - deadline : 0);
+        const TBool dropout = (lateNs > dropoutNs);
+        RecordWakeup(lateNs, dropout);
+        if (dropout) { // assume delay caused by drop-out.  Restart timing, processing a regular amount of audio
+            deadline = now;
+        }
+        TUint64 pending = iCarryJiffies + PeriodJiffies(iPeriodMs, iPullValue, pullRemainder);
+        while (deadline + periodNs <= now) { // late enough that we've missed further deadlines
+            deadline += periodNs;
+            pending += PeriodJiffies(iPeriodMs, iPullValue, pullRemainder);
+        }
+        iCarryJiffies = 0;
+        iPendingJiffies = (TUint)pending;
+    }
+}
+
+void AnimatorBasic::ProcessPending()
+{
+    while (iPendingJiffies > 0) {
+        if (iPlayable != nullptr) {
+            ProcessAudio(iPlayable);
+        }
+        else {
+            Msg* msg = iPipeline.Pull();
+            msg = msg->Process(*this);
+            ASSERT(msg == nullptr);
+        }
+    }
+}
+
 void AnimatorBasic::ProcessAudio(MsgPlayable* aMsg)
 {
     iPlayable = nullptr;
@@ -140,6 +254,9 @@ void AnimatorBasic::ProcessAudio(MsgPlayable* aMsg)
         jiffies = iPendingJiffies;
         const TUint bytes = Jiffies::ToBytes(jiffies, iJiffiesPerSample, iNumChannels, (iBitDepth/8));
         if (bytes == 0) {
+            if (iPacing == ePacingPrecise) {
+                iCarryJiffies = iPendingJiffies;
+            }
             iPendingJiffies = 0;
             iPlayable = aMsg;
             return;
@@ -147,9 +264,74 @@ void AnimatorBasic::ProcessAudio(MsgPlayable* aMsg)
         iPlayable = aMsg->Split(bytes);
     }
     iPendingJiffies -= jiffies;
+    {
+        AutoMutex _(iLockStats);
+        iJiffiesPlayed += jiffies;
+    }
     aMsg->RemoveRef();
 }
 
+TUint64 AnimatorBasic::NowNs() const
+{
+#ifdef __linux__
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((TUint64)ts.tv_sec * 1000000000) + ts.tv_nsec;
+#else
+    return OsTimeInUs(iOsCtx) * 1000;
+#endif
+}
+
+void AnimatorBasic::SleepUntilNs(TUint64 aDeadlineNs)
+{
+#ifdef __linux__
+    struct timespec ts;
+    ts.tv_sec = (time_t)(aDeadlineNs / 1000000000);
+    ts.tv_nsec = (long)(aDeadlineNs % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    // no absolute timer available; wake no earlier than the deadline.  Lateness doesn't accumulate.
+    const TUint64 now = NowNs();
+    if (aDeadlineNs > now) {
+        try {
+            iSem.Wait((TUint)((aDeadlineNs - now + 999999) / 1000000));
+        }
+        catch (Timeout&) {}
+    }
+#endif
+}
+
+void AnimatorBasic::RecordWakeup(TUint64 aLateNs, TBool aDropout)
+{
+    AutoMutex _(iLockStats);
+    if (aDropout) {
+        iDropouts++;
+        return;
+    }
+    if (iWakeups == 0 || aLateNs < iLateMinNs) {
+        iLateMinNs = aLateNs;
+    }
+    if (aLateNs > iLateMaxNs) {
+        iLateMaxNs = aLateNs;
+    }
+    iWakeups++;
+    iLateSumNs += aLateNs;
+    const double lateUs = aLateNs / 1000.0;
+    iLateSumSqUs += lateUs * lateUs;
+}
+
+TUint AnimatorBasic::PeriodJiffies(TUint aPeriodMs, TUint64 aPull, TUint64& aPullRemainder)
+{ // static
+    const TUint64 jiffies = (TUint64)aPeriodMs * Jiffies::kPerMs;
+    if (aPull == IPullableClock::kNominalFreq) {
+        return (TUint)jiffies;
+    }
+    const TUint64 scaled = (jiffies * aPull) + aPullRemainder;
+    aPullRemainder = scaled % IPullableClock::kNominalFreq;
+    return (TUint)(scaled / IPullableClock::kNominalFreq);
+}
+
 Msg* AnimatorBasic::ProcessMsg(MsgMode* aMsg)
 {
     iPullValue = IPullableClock::kNominalFreq;
@@ -174,6 +356,7 @@ Msg* AnimatorBasic::ProcessMsg(MsgDrain* aMsg)
 Msg* AnimatorBasic::ProcessMsg(MsgHalt* aMsg)
 {
     iPendingJiffies = 0;
+    iCarryJiffies = 0;
     iNextTimerDuration = 0;
     aMsg->ReportHalted();
     aMsg->RemoveRef();
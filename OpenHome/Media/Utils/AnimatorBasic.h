@@ -25,16 +25,61 @@ private:
     const TUint iOpenHomeMax;
 };
 
+/*
+    Animator which consumes audio at the pipeline's nominal rate without outputting it.
+    Used as a virtual DAC by test players and soak rigs.
+
+    ePacingCoarse wakes after relative, whole millisecond, timeouts and rounds each period to
+    whole samples.  ePacingPrecise sleeps until absolute deadlines (clock_nanosleep on Linux),
+    carries any part-sample between periods and so stays sample accurate indefinitely.
+    Lateness of each wakeup is available from GetJitterStats() in either mode.
+*/
+
 class AnimatorBasic : public PipelineElement, public IPullableClock, public IPipelineAnimator
 {
-    static const TUint kTimerFrequencyMs = 5;
+    friend class SuiteAnimatorBasic;
+
     static const TUint kSupportedMsgTypes;
+    static const TUint kDropoutMs = 100;
+public:
+    static const TUint kPeriodMsDefault = 5;
+    static const TUint kPeriodMsMin = 1;
+    static const TUint kPeriodMsMax = 20;
+    enum EPacing
+    {
+        ePacingCoarse
+       ,ePacingPrecise
+    };
+    class JitterStats
+    {
+    public:
+        JitterStats();
+    public:
+        TUint64 iWakeups;
+        TUint64 iLateMinUs;
+        TUint64 iLateMaxUs;
+        TUint64 iLateMeanUs;
+        TUint64 iLateStdDevUs;
+        TUint iDropouts;        // wakeups more than kDropoutMs late; audio over this gap isn't accounted for
+        TUint64 iElapsedUs;     // time the stats cover
+        TUint64 iJiffiesPlayed; // audio consumed over iElapsedUs
+    };
 public:
-    AnimatorBasic(Environment& aEnv, IPipeline& aPipeline, TBool aPullable);
+    AnimatorBasic(Environment& aEnv, IPipeline& aPipeline, TBool aPullable,
+                  TUint aPeriodMs = kPeriodMsDefault, EPacing aPacing = ePacingCoarse);
     ~AnimatorBasic();
+    void GetJitterStats(JitterStats& aStats);
+    void ResetJitterStats();
 private:
     void DriverThread();
+    void PaceCoarse();
+    void PacePrecise();
+    void ProcessPending();
     void ProcessAudio(MsgPlayable* aMsg);
+    TUint64 NowNs() const;
+    void SleepUntilNs(TUint64 aDeadlineNs);
+    void RecordWakeup(TUint64 aLateNs, TBool aDropout);
+    static TUint PeriodJiffies(TUint aPeriodMs, TUint64 aPull, TUint64& aPullRemainder);
 private: // from IMsgProcessor
     Msg* ProcessMsg(MsgMode* aMsg) override;
     Msg* ProcessMsg(MsgDrain* aMsg) override;
@@ -54,16 +99,28 @@ private:
     OsContext* iOsCtx;
     ThreadFunctor *iThread;
     const TBool iPullable;
+    const TUint iPeriodMs;
+    const EPacing iPacing;
     TUint iSampleRate;
     TUint iJiffiesPerSample;
     TUint iNumChannels;
     TUint iBitDepth;
     TUint iPendingJiffies;
+    TUint iCarryJiffies;    // part-sample left over from the previous period (ePacingPrecise only)
     TUint64 iLastTimeUs;
     TUint iNextTimerDuration;
     MsgPlayable* iPlayable;
     TUint64 iPullValue;
     TBool iQuit;
+    Mutex iLockStats;
+    TUint64 iStatsStartNs;
+    TUint64 iWakeups;
+    TUint64 iLateMinNs;
+    TUint64 iLateMaxNs;
+    TUint64 iLateSumNs;
+    double iLateSumSqUs;
+    TUint iDropouts;
+    TUint64 iJiffiesPlayed;
 };
 
 } // namespace Media
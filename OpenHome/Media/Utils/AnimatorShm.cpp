@@ -0,0 +1,400 @@
+#include <OpenHome/Media/Utils/AnimatorShm.h>
+#include <OpenHome/Media/Utils/ShmPcmRing.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Media/Debug.h>
+
+#include <algorithm>
+#include <new>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+const TUint AnimatorShm::kSupportedMsgTypes =   eMode
+                                              | eDrain
+                                              | eHalt
+                                              | eDecodedStream
+                                              | ePlayable
+                                              | eQuit;
+
+AnimatorShm::AnimatorShm(Environment& aEnv, IPipeline& aPipeline, const Brx& aShmName, TUint aBufferMs)
+    : PipelineElement(kSupportedMsgTypes)
+    , iPipeline(aPipeline)
+    , iOsCtx(aEnv.OsCtx())
+    , iShmName(aShmName.Bytes() + 1)
+    , iBufferMs(aBufferMs)
+    , iSem("DRVS", 0)
+    , iSampleRate(0)
+    , iNumChannels(0)
+    , iBitDepth(0)
+    , iBytesPerSampleOut(0)
+    , iFrameBytesIn(0)
+    , iFrameBytesOut(0)
+    , iLimitBytes(0)
+    , iWriteBytes(0)
+    , iLastReadBytes(0)
+    , iLastReadChangeUs(0)
+    , iConsumerStalled(false)
+    , iQuit(false)
+{
+    ASSERT(iBufferMs > 0);
+    iShmName.Replace(aShmName);
+    const TUint maxFrameBytes = kMaxChannels * 4;
+    const TUint maxBytes = ((kMaxSampleRate / 1000) * iBufferMs * maxFrameBytes);
+    iDataBytes = ((maxBytes + kShmPcmRingFrameAlign - 1) / kShmPcmRingFrameAlign) * kShmPcmRingFrameAlign;
+    iMapBytes = kShmPcmRingDataOffset + iDataBytes;
+
+    const TChar* name = reinterpret_cast<const TChar*>(iShmName.PtrZ());
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0660);
+    if (fd < 0) {
+        LOG_ERROR(kPipeline, "AnimatorShm: shm_open(%s) failed (%d)\n", name, errno);
+        THROW(AnimatorShmError);
+    }
+    if (ftruncate(fd, iMapBytes) != 0) {
+        LOG_ERROR(kPipeline, "AnimatorShm: ftruncate(%s, %u) failed (%d)\n", name, iMapBytes, errno);
+        (void)close(fd);
+        (void)shm_unlink(name);
+        THROW(AnimatorShmError);
+    }
+    void* p = mmap(nullptr, iMapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void)close(fd);
+    if (p == MAP_FAILED) {
+        LOG_ERROR(kPipeline, "AnimatorShm: mmap(%s) failed (%d)\n", name, errno);
+        (void)shm_unlink(name);
+        THROW(AnimatorShmError);
+    }
+    (void)memset(p, 0, kShmPcmRingDataOffset);
+    iHeader = new (p) ShmPcmRingHeader();
+    iData = static_cast<TByte*>(p) + kShmPcmRingDataOffset;
+    iHeader->iVersion = kShmPcmRingVersion;
+    iHeader->iDataOffset = kShmPcmRingDataOffset;
+    iHeader->iDataBytes = iDataBytes;
+    iHeader->iFormatSeq.store(0);
+    iHeader->iState.store(eShmPcmRingStarting);
+    iHeader->iPullMultiplier.store(kNominalFreq);
+    iHeader->iWriteBytes.store(0);
+    iHeader->iWriteTimeUs.store(ShmPcmRingNowUs());
+    iHeader->iReadBytes.store(0);
+    iHeader->iReadTimeUs.store(0);
+    iHeader->iConsumerLatencyUs.store(0);
+    std::atomic_thread_fence(std::memory_order_release);
+    iHeader->iMagic = kShmPcmRingMagic; // last, so a consumer never sees a partially initialised header
+
+    iPipeline.SetAnimator(*this);
+    iThread = new ThreadFunctor("PipelineAnimator", MakeFunctor(*this, &AnimatorShm::DriverThread), kPrioritySystemHighest);
+    iThread->Start();
+}
+
+AnimatorShm::~AnimatorShm()
+{
+    delete iThread;
+    iHeader->iState.store(eShmPcmRingClosed);
+    (void)munmap(iHeader, iMapBytes);
+    (void)shm_unlink(reinterpret_cast<const TChar*>(iShmName.PtrZ()));
+}
+
+void AnimatorShm::DriverThread()
+{
+    try {
+        while (!iQuit) {
+            Msg* msg = iPipeline.Pull();
+            ASSERT(msg != nullptr);
+            msg = msg->Process(*this);
+            ASSERT(msg == nullptr);
+        }
+    }
+    catch (ThreadKill&) {}
+}
+
+TUint AnimatorShm::WaitForSpace(TUint aMinFrames)
+{
+    const TUint minBytes = std::min(aMinFrames * iFrameBytesOut, iLimitBytes);
+    for (;;) {
+        const TUint64 readBytes = iHeader->iReadBytes.load(std::memory_order_acquire);
+        const TUint used = (TUint)(iWriteBytes - readBytes);
+        if (used + minBytes <= iLimitBytes) {
+            return (iLimitBytes - used) / iFrameBytesOut;
+        }
+        if (ConsumerStalled(readBytes)) {
+            return 0;
+        }
+        try {
+            iSem.Wait(kPollIntervalMs);
+        }
+        catch (Timeout&) {}
+    }
+}
+
+TBool AnimatorShm::WaitForEmpty()
+{
+    for (;;) {
+        const TUint64 readBytes = iHeader->iReadBytes.load(std::memory_order_acquire);
+        if (readBytes == iWriteBytes) {
+            return true;
+        }
+        if (ConsumerStalled(readBytes)) {
+            return false;
+        }
+        try {
+            iSem.Wait(kPollIntervalMs);
+        }
+        catch (Timeout&) {}
+    }
+}
+
+TBool AnimatorShm::ConsumerStalled(TUint64 aReadBytes)
+{
+    const TUint64 now = OsTimeInUs(iOsCtx);
+    if (aReadBytes != iLastReadBytes || iLastReadChangeUs == 0) {
+        iLastReadBytes = aReadBytes;
+        iLastReadChangeUs = now;
+        if (iConsumerStalled) {
+            LOG(kPipeline, "AnimatorShm: consumer reading again\n");
+            iConsumerStalled = false;
+        }
+        return false;
+    }
+    if (iConsumerStalled) {
+        return true;
+    }
+    if (now - iLastReadChangeUs < kConsumerTimeoutMs * 1000) {
+        return false;
+    }
+    LOG_ERROR(kPipeline, "AnimatorShm: consumer not reading, discarding audio\n");
+    iConsumerStalled = true;
+    return true;
+}
+
+void AnimatorShm::Discard(MsgPlayable* aMsg)
+{
+    // no consumer; throw audio away at its nominal rate
+    const TUint ms = Jiffies::ToMs(aMsg->Jiffies());
+    aMsg->RemoveRef();
+    if (ms > 0) {
+        try {
+            iSem.Wait(ms);
+        }
+        catch (Timeout&) {}
+    }
+}
+
+void AnimatorShm::WriteSamples(const Brx& aData, TUint aBytesPerSample)
+{
+    const TByte* src = aData.Ptr();
+    const TUint samples = aData.Bytes() / aBytesPerSample;
+    TUint pos = (TUint)(iWriteBytes % iDataBytes);
+    if (iBytesPerSampleOut == 2) {
+        for (TUint i=0; i<samples; i++) {
+            TUint16 sample = (TUint16)(src[0] << 8);
+            if (aBytesPerSample > 1) {
+                sample |= src[1];
+            }
+            src += aBytesPerSample;
+            *reinterpret_cast<TInt16*>(iData + pos) = (TInt16)sample;
+            pos += 2;
+            if (pos == iDataBytes) {
+                pos = 0;
+            }
+        }
+    }
+    else {
+        for (TUint i=0; i<samples; i++) {
+            TUint32 sample = 0;
+            for (TUint j=0; j<aBytesPerSample; j++) {
+                sample |= (TUint32)src[j] << (24 - 8*j);
+            }
+            src += aBytesPerSample;
+            *reinterpret_cast<TInt32*>(iData + pos) = (TInt32)sample;
+            pos += 4;
+            if (pos == iDataBytes) {
+                pos = 0;
+            }
+        }
+    }
+    iWriteBytes += samples * iBytesPerSampleOut;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgMode* aMsg)
+{
+    PullClock(kNominalFreq);
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgDrain* aMsg)
+{
+    (void)WaitForEmpty();
+    PullClock(kNominalFreq);
+    aMsg->ReportDrained();
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgHalt* aMsg)
+{
+    iHeader->iState.store(eShmPcmRingHalted);
+    aMsg->ReportHalted();
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgDecodedStream* aMsg)
+{
+    const DecodedStreamInfo& stream = aMsg->StreamInfo();
+    const TUint bytesPerSampleOut = (stream.BitDepth() > 16? 4 : 2);
+    if (stream.SampleRate() != iSampleRate || stream.NumChannels() != iNumChannels ||
+        stream.BitDepth() != iBitDepth) {
+        // format may only change while the ring is empty (or nothing is reading it - a
+        // consumer resyncs to the write cursor when it attaches)
+        (void)WaitForEmpty();
+        iSampleRate = stream.SampleRate();
+        iNumChannels = stream.NumChannels();
+        iBitDepth = stream.BitDepth();
+        iBytesPerSampleOut = bytesPerSampleOut;
+        iFrameBytesIn = iNumChannels * (iBitDepth / 8);
+        iFrameBytesOut = iNumChannels * iBytesPerSampleOut;
+        iLimitBytes = ((iSampleRate * iBufferMs) / 1000) * iFrameBytesOut;
+        iLimitBytes = std::min(iLimitBytes, (iDataBytes / iFrameBytesOut) * iFrameBytesOut);
+        iHeader->iFormatSeq.fetch_add(1, std::memory_order_relaxed); // odd => change in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        iHeader->iSampleRate.store(iSampleRate, std::memory_order_relaxed);
+        iHeader->iNumChannels.store(iNumChannels, std::memory_order_relaxed);
+        iHeader->iBitDepth.store(iBitDepth, std::memory_order_relaxed);
+        iHeader->iBytesPerSample.store(iBytesPerSampleOut, std::memory_order_relaxed);
+        // the previous stream may have ended part way through a frame of the new format; skip
+        // to the next whole frame so that WriteSamples() wraps exactly at the end of the ring
+        iWriteBytes = ((iWriteBytes + iFrameBytesOut - 1) / iFrameBytesOut) * iFrameBytesOut;
+        iHeader->iWriteBytes.store(iWriteBytes, std::memory_order_relaxed);
+        iHeader->iFormatSeq.fetch_add(1, std::memory_order_release);
+        LOG(kPipeline, "AnimatorShm: format %u/%u/%u\n", iSampleRate, iBitDepth, iNumChannels);
+    }
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgPlayable* aMsg)
+{
+    iHeader->iState.store(eShmPcmRingPlaying);
+    MsgPlayable* msg = aMsg;
+    while (msg != nullptr) {
+        const TUint frames = msg->Bytes() / iFrameBytesIn;
+        const TUint minFrames = std::min(frames, std::max(iSampleRate / 1000, 1u)); // avoid writing in tiny fragments
+        const TUint space = WaitForSpace(minFrames);
+        if (space == 0) {
+            Discard(msg);
+            break;
+        }
+        MsgPlayable* remaining = nullptr;
+        if (frames > space) {
+            remaining = msg->Split(space * iFrameBytesIn);
+        }
+        msg->Read(*this);
+        msg->RemoveRef();
+        iHeader->iWriteTimeUs.store(ShmPcmRingNowUs(), std::memory_order_relaxed);
+        iHeader->iWriteBytes.store(iWriteBytes, std::memory_order_release);
+        msg = remaining;
+    }
+    return nullptr;
+}
+
+Msg* AnimatorShm::ProcessMsg(MsgQuit* aMsg)
+{
+    iQuit = true;
+    aMsg->RemoveRef();
+    return nullptr;
+}
+
+void AnimatorShm::BeginBlock()
+{
+}
+
+void AnimatorShm::ProcessFragment8(const Brx& aData, TUint /*aNumChannels*/)
+{
+    WriteSamples(aData, 1);
+}
+
+void AnimatorShm::ProcessFragment16(const Brx& aData, TUint /*aNumChannels*/)
+{
+    WriteSamples(aData, 2);
+}
+
+void AnimatorShm::ProcessFragment24(const Brx& aData, TUint /*aNumChannels*/)
+{
+    WriteSamples(aData, 3);
+}
+
+void AnimatorShm::ProcessFragment32(const Brx& aData, TUint /*aNumChannels*/)
+{
+    WriteSamples(aData, 4);
+}
+
+void AnimatorShm::EndBlock()
+{
+}
+
+void AnimatorShm::Flush()
+{
+}
+
+void AnimatorShm::PullClock(TUint aMultiplier)
+{
+    aMultiplier = std::max(kNominalFreq - kMaxPull, std::min(kNominalFreq + kMaxPull, aMultiplier));
+    if (iHeader->iPullMultiplier.exchange(aMultiplier) != aMultiplier) {
+        LOG(kPipeline, "AnimatorShm::PullClock now at %u\n", aMultiplier);
+    }
+}
+
+TUint AnimatorShm::MaxPull() const
+{
+    return kMaxPull;
+}
+
+TUint AnimatorShm::PipelineAnimatorBufferJiffies()
+{
+    /* May be called from any thread so can't use the driver thread's copy of the format.
+       Read the ring's instead, retrying if it changed while we read it. */
+    TUint sampleRate;
+    TUint frameBytes;
+    TUint64 used;
+    for (;;) {
+        const TUint seq = iHeader->iFormatSeq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            Thread::Sleep(0); // writer is part way through a change
+            continue;
+        }
+        sampleRate = iHeader->iSampleRate.load(std::memory_order_relaxed);
+        frameBytes = iHeader->iNumChannels.load(std::memory_order_relaxed) * iHeader->iBytesPerSample.load(std::memory_order_relaxed);
+        used = iHeader->iWriteBytes.load(std::memory_order_acquire) - iHeader->iReadBytes.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (iHeader->iFormatSeq.load(std::memory_order_relaxed) == seq) {
+            break;
+        }
+    }
+    if (frameBytes == 0) {
+        return 0;
+    }
+    return (TUint)(used / frameBytes) * Jiffies::PerSample(sampleRate);
+}
+
+TUint AnimatorShm::PipelineAnimatorDelayJiffies(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels)
+{
+    if (aSampleRate > kMaxSampleRate || aNumChannels == 0 || aNumChannels > kMaxChannels) {
+        THROW(SampleRateUnsupported);
+    }
+    if (aBitDepth != 8 && aBitDepth != 16 && aBitDepth != 24 && aBitDepth != 32) {
+        THROW(SampleRateUnsupported);
+    }
+    const TUint64 consumerJiffies = ((TUint64)iHeader->iConsumerLatencyUs.load() * Jiffies::kPerMs) / 1000;
+    return (iBufferMs * Jiffies::kPerMs) + (TUint)consumerJiffies;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Exception.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+EXCEPTION(AnimatorShmError);
+
+namespace OpenHome {
+    class Environment;
+namespace Media {
+
+struct ShmPcmRingHeader;
+
+/*
+    Animator which writes audio into a POSIX shared memory ring (see ShmPcmRing.h) for an
+    out of process consumer, such as a DSP or room correction process.
+
+    The consumer is the clock: audio is written as soon as there is space, keeping up to
+    aBufferMs of audio in the ring.  The ring's occupancy is reported as
+    PipelineAnimatorBufferJiffies(); aBufferMs plus the consumer's reported latency is
+    reported as PipelineAnimatorDelayJiffies().  PullClock() requests are published to the
+    consumer via the ring's header.
+
+    If the consumer stops reading for kConsumerTimeoutMs, audio is discarded at its nominal
+    rate so that the pipeline can continue (and be shut down) without one.
+
+    Linux only.
+*/
+
+class AnimatorShm : public PipelineElement
+                  , public IPullableClock
+                  , public IPipelineAnimator
+                  , private IPcmProcessor
+                  , private INonCopyable
+{
+    friend class SuiteAnimatorShm;
+
+    static const TUint kSupportedMsgTypes;
+    static const TUint kPollIntervalMs = 1;
+    static const TUint kConsumerTimeoutMs = 500;
+    static const TUint kMaxPull = kNominalFreq / 100; // 1%
+public:
+    static const TUint kBufferMsDefault = 20;
+    static const TUint kMaxSampleRate = 192000;
+    static const TUint kMaxChannels = 8;
+public:
+    AnimatorShm(Environment& aEnv, IPipeline& aPipeline, const Brx& aShmName, TUint aBufferMs = kBufferMsDefault); // throws AnimatorShmError
+    ~AnimatorShm();
+private:
+    void DriverThread();
+    TUint WaitForSpace(TUint aMinFrames); // returns frames of space, or 0 if the consumer isn't reading
+    TBool WaitForEmpty();                 // returns false if the consumer isn't reading
+    TBool ConsumerStalled(TUint64 aReadBytes);
+    void Discard(MsgPlayable* aMsg);
+    void WriteSamples(const Brx& aData, TUint aBytesPerSample);
+private: // from IMsgProcessor
+    Msg* ProcessMsg(MsgMode* aMsg) override;
+    Msg* ProcessMsg(MsgDrain* aMsg) override;
+    Msg* ProcessMsg(MsgHalt* aMsg) override;
+    Msg* ProcessMsg(MsgDecodedStream* aMsg) override;
+    Msg* ProcessMsg(MsgPlayable* aMsg) override;
+    Msg* ProcessMsg(MsgQuit* aMsg) override;
+private: // from IPcmProcessor
+    void BeginBlock() override;
+    void ProcessFragment8(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment16(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment24(const Brx& aData, TUint aNumChannels) override;
+    void ProcessFragment32(const Brx& aData, TUint aNumChannels) override;
+    void EndBlock() override;
+    void Flush() override;
+public: // from IPullableClock
+    void PullClock(TUint aMultiplier) override;
+    TUint MaxPull() const override;
+public: // from IPipelineAnimator
+    TUint PipelineAnimatorBufferJiffies() override;
+    TUint PipelineAnimatorDelayJiffies(TUint aSampleRate, TUint aBitDepth, TUint aNumChannels) override;
+private:
+    IPipeline& iPipeline;
+    OsContext* iOsCtx;
+    Bwh iShmName;
+    const TUint iBufferMs;
+    Semaphore iSem;
+    ShmPcmRingHeader* iHeader;
+    TByte* iData;
+    TUint iDataBytes;
+    TUint iMapBytes;
+    ThreadFunctor* iThread;
+    TUint iSampleRate;
+    TUint iNumChannels;
+    TUint iBitDepth;
+    TUint iBytesPerSampleOut;
+    TUint iFrameBytesIn;
+    TUint iFrameBytesOut;
+    TUint iLimitBytes;      // max bytes buffered in ring for current format
+    TUint64 iWriteBytes;    // local copy of write cursor, includes data not yet published
+    TUint64 iLastReadBytes;
+    TUint64 iLastReadChangeUs;
+    TBool iConsumerStalled;
+    TBool iQuit;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,449 @@
+#include <OpenHome/Media/Utils/BinaryLogger.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Standard.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+namespace OpenHome {
+namespace Media {
+
+/*
+ * Written only by the thread that owns it.  Each entry's sequence number is made odd
+ * while it is being written so that Read() can discard entries that were overwritten
+ * while being copied.
+ */
+class BinaryLogger::Ring : private INonCopyable
+{
+public:
+    static const TUint kMaxNameBytes = 16;
+public:
+    Ring(TUint aEntries, const Brx& aThreadName);
+    ~Ring();
+public:
+    Bws<kMaxNameBytes> iThreadName;
+    BinaryLogger::Entry* iEntries;
+    const TUint iCapacity;
+    std::atomic<TUint64> iWriteIndex;
+};
+
+} // namespace Media
+} // namespace OpenHome
+
+namespace {
+
+// The ring owned by the calling thread, valid only while iGeneration matches the active logger
+struct ThreadRing
+{
+    void* iRing;
+    TUint iGeneration;
+};
+thread_local ThreadRing tRing = { nullptr, 0 };
+
+} // namespace
+
+
+// BinaryLogger::Entry
+
+BinaryLogger::Entry::Entry()
+    : iSeq(0)
+    , iFormat(nullptr)
+    , iTimeUs(0)
+    , iNumArgs(0)
+    , iStringBytes(0)
+{
+}
+
+
+// BinaryLogger::Ring
+
+BinaryLogger::Ring::Ring(TUint aEntries, const Brx& aThreadName)
+    : iCapacity(aEntries)
+    , iWriteIndex(0)
+{
+    const TUint bytes = (aThreadName.Bytes() < kMaxNameBytes? aThreadName.Bytes() : kMaxNameBytes);
+    iThreadName.Replace(aThreadName.Split(0, bytes));
+    iEntries = new BinaryLogger::Entry[aEntries];
+}
+
+BinaryLogger::Ring::~Ring()
+{
+    delete[] iEntries;
+}
+
+
+// BinaryLogger
+
+std::atomic<BinaryLogger*> BinaryLogger::iActive(nullptr);
+std::atomic<TUint> BinaryLogger::iGeneration(0);
+
+BinaryLogger::BinaryLogger(Environment& aEnv, TUint aEntriesPerThread)
+    : iEnv(aEnv)
+    , iEntriesPerThread(aEntriesPerThread)
+    , iGenerationId(++iGeneration)
+    , iEnabled(false)
+    , iLockRings("BLOG")
+    , iRingCount(0)
+    , iDropped(0)
+{
+    ASSERT(iEntriesPerThread > 0);
+    for (TUint i=0; i<kMaxThreads; i++) {
+        iRings[i] = nullptr;
+    }
+    BinaryLogger* expected = nullptr;
+    const TBool installed = iActive.compare_exchange_strong(expected, this);
+    ASSERT(installed); // only one instance at a time
+}
+
+BinaryLogger::~BinaryLogger()
+{
+    iActive.store(nullptr);
+    for (TUint i=0; i<kMaxThreads; i++) {
+        delete iRings[i];
+    }
+}
+
+void BinaryLogger::SetEnabled(TBool aEnabled)
+{
+    iEnabled.store(aEnabled);
+}
+
+TBool BinaryLogger::Enabled() const
+{
+    return iEnabled.load();
+}
+
+TUint BinaryLogger::Dropped() const
+{
+    return iDropped.load();
+}
+
+void BinaryLogger::Read(IWriter& aWriter)
+{
+    class Record
+    {
+    public:
+        Record(const Entry& aEntry, const Ring& aRing)
+            : iRing(&aRing)
+        {
+            iEntry.iFormat = aEntry.iFormat;
+            iEntry.iTimeUs = aEntry.iTimeUs;
+            iEntry.iNumArgs = (aEntry.iNumArgs < kMaxArgs? aEntry.iNumArgs : kMaxArgs);
+            iEntry.iStringBytes = (aEntry.iStringBytes < kMaxStringBytes? aEntry.iStringBytes : kMaxStringBytes);
+            (void)memcpy(iEntry.iArgs, aEntry.iArgs, sizeof(iEntry.iArgs));
+            (void)memcpy(iEntry.iTypes, aEntry.iTypes, sizeof(iEntry.iTypes));
+            (void)memcpy(iEntry.iStrings, aEntry.iStrings, sizeof(iEntry.iStrings));
+        }
+        Record(const Record& aRecord)
+            : iRing(aRecord.iRing)
+        {
+            *this = aRecord;
+        }
+        Record& operator=(const Record& aRecord)
+        {
+            iRing = aRecord.iRing;
+            iEntry.iFormat = aRecord.iEntry.iFormat;
+            iEntry.iTimeUs = aRecord.iEntry.iTimeUs;
+            iEntry.iNumArgs = aRecord.iEntry.iNumArgs;
+            iEntry.iStringBytes = aRecord.iEntry.iStringBytes;
+            (void)memcpy(iEntry.iArgs, aRecord.iEntry.iArgs, sizeof(iEntry.iArgs));
+            (void)memcpy(iEntry.iTypes, aRecord.iEntry.iTypes, sizeof(iEntry.iTypes));
+            (void)memcpy(iEntry.iStrings, aRecord.iEntry.iStrings, sizeof(iEntry.iStrings));
+            return *this;
+        }
+        TBool operator<(const Record& aRecord) const
+        {
+            return iEntry.iTimeUs < aRecord.iEntry.iTimeUs;
+        }
+    public:
+        const Ring* iRing;
+        Entry iEntry;
+    };
+
+    std::vector<Record> records;
+    const TUint rings = iRingCount.load(std::memory_order_acquire);
+    for (TUint i=0; i<rings; i++) {
+        const Ring& ring = *iRings[i];
+        const TUint64 end = ring.iWriteIndex.load(std::memory_order_acquire);
+        const TUint64 start = (end > ring.iCapacity? end - ring.iCapacity : 0);
+        for (TUint64 j=start; j<end; j++) {
+            const Entry& entry = ring.iEntries[j % ring.iCapacity];
+            const TUint64 seq = entry.iSeq.load(std::memory_order_acquire);
+            if (seq != 2 * j + 2) {
+                continue; // overwritten since we read iWriteIndex
+            }
+            Record record(entry, ring);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (entry.iSeq.load(std::memory_order_relaxed) != seq) {
+                continue; // overwritten while we copied it
+            }
+            records.push_back(record);
+        }
+    }
+    std::stable_sort(records.begin(), records.end());
+
+    Bws<kMaxLineBytes> line;
+    for (auto& record : records) {
+        Format(record.iEntry, record.iRing->iThreadName, line);
+        aWriter.Write(line);
+    }
+    const TUint dropped = iDropped.load();
+    if (dropped > 0) {
+        line.SetBytes(0);
+        line.AppendPrintf("BinaryLogger: %u log calls dropped (too many threads)\n", dropped);
+        aWriter.Write(line);
+    }
+}
+
+BinaryLogger::Entry* BinaryLogger::BeginEntry(const TChar* aFormat)
+{
+    Ring* ring = static_cast<Ring*>(tRing.iRing);
+    if (ring == nullptr || tRing.iGeneration != iGenerationId) {
+        ring = CreateRing();
+        if (ring == nullptr) {
+            iDropped++;
+            return nullptr;
+        }
+        tRing.iRing = ring;
+        tRing.iGeneration = iGenerationId;
+    }
+    const TUint64 index = ring->iWriteIndex.load(std::memory_order_relaxed);
+    Entry& entry = ring->iEntries[index % ring->iCapacity];
+    entry.iSeq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.iFormat = aFormat;
+    entry.iTimeUs = OsTimeInUs(iEnv.OsCtx());
+    entry.iStringBytes = 0;
+    return &entry;
+}
+
+void BinaryLogger::EndEntry(Entry& aEntry, TUint aNumArgs)
+{
+    aEntry.iNumArgs = aNumArgs;
+    Ring* ring = static_cast<Ring*>(tRing.iRing);
+    const TUint64 index = ring->iWriteIndex.load(std::memory_order_relaxed);
+    aEntry.iSeq.store(2 * index + 2, std::memory_order_release);
+    ring->iWriteIndex.store(index + 1, std::memory_order_release);
+}
+
+BinaryLogger::Ring* BinaryLogger::CreateRing()
+{
+    AutoMutex _(iLockRings);
+    const TUint count = iRingCount.load(std::memory_order_relaxed);
+    if (count == kMaxThreads) {
+        return nullptr;
+    }
+    Thread* thread = Thread::Current();
+    const Brn name(thread == nullptr? Brn("????") : Brn(thread->Name()));
+    Ring* ring = new Ring(iEntriesPerThread, name);
+    iRings[count] = ring;
+    iRingCount.store(count + 1, std::memory_order_release);
+    return ring;
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, TInt aValue)
+{ // static
+    Put(aEntry, aIndex, (long long)aValue);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, TUint aValue)
+{ // static
+    Put(aEntry, aIndex, (unsigned long long)aValue);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, long aValue)
+{ // static
+    Put(aEntry, aIndex, (long long)aValue);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, unsigned long aValue)
+{ // static
+    Put(aEntry, aIndex, (unsigned long long)aValue);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, long long aValue)
+{ // static
+    aEntry.iArgs[aIndex] = (TUint64)aValue;
+    aEntry.iTypes[aIndex++] = Entry::eInt;
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, unsigned long long aValue)
+{ // static
+    aEntry.iArgs[aIndex] = (TUint64)aValue;
+    aEntry.iTypes[aIndex++] = Entry::eUint;
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, double aValue)
+{ // static
+    static_assert(sizeof(double) == sizeof(TUint64), "BinaryLogger: unexpected double size");
+    (void)memcpy(&aEntry.iArgs[aIndex], &aValue, sizeof(aValue));
+    aEntry.iTypes[aIndex++] = Entry::eDouble;
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, const TChar* aValue)
+{ // static
+    const TChar* str = (aValue == nullptr? "(null)" : aValue);
+    const TUint remaining = kMaxStringBytes - aEntry.iStringBytes;
+    TUint bytes = 0;
+    while (bytes < remaining && str[bytes] != '\0') {
+        bytes++;
+    }
+    PutString(aEntry, aIndex++, str, bytes);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, const TByte* aValue)
+{ // static
+    TUint bytes = 0;
+    if (aIndex > 0 && (aEntry.iTypes[aIndex-1] == Entry::eInt || aEntry.iTypes[aIndex-1] == Entry::eUint)) {
+        bytes = (TUint)aEntry.iArgs[aIndex-1];
+    }
+    bytes = std::min(bytes, kMaxStringBytes - aEntry.iStringBytes);
+    PutString(aEntry, aIndex++, reinterpret_cast<const TChar*>(aValue), bytes);
+}
+
+void BinaryLogger::Put(Entry& aEntry, TUint& aIndex, const void* aValue)
+{ // static
+    aEntry.iArgs[aIndex] = (TUint64)reinterpret_cast<uintptr_t>(aValue);
+    aEntry.iTypes[aIndex++] = Entry::ePointer;
+}
+
+void BinaryLogger::PutString(Entry& aEntry, TUint aIndex, const TChar* aPtr, TUint aBytes)
+{ // static
+    (void)memcpy(&aEntry.iStrings[aEntry.iStringBytes], aPtr, aBytes);
+    aEntry.iArgs[aIndex] = ((TUint64)aEntry.iStringBytes << 32) | aBytes;
+    aEntry.iTypes[aIndex] = Entry::eString;
+    aEntry.iStringBytes += aBytes;
+}
+
+void BinaryLogger::Format(const Entry& aEntry, const Brx& aThreadName, Bwx& aLine)
+{ // static
+    aLine.SetBytes(0);
+    aLine.AppendPrintf("%llu.%03llu %.*s: ", aEntry.iTimeUs / 1000000, (aEntry.iTimeUs / 1000) % 1000, PBUF(aThreadName));
+
+    TUint arg = 0;
+    const TChar* p = aEntry.iFormat;
+    while (*p != '\0' && aLine.Bytes() < aLine.MaxBytes()) {
+        if (*p != '%') {
+            aLine.Append(*p++);
+            continue;
+        }
+        if (p[1] == '%') {
+            aLine.Append('%');
+            p += 2;
+            continue;
+        }
+
+        // rebuild the conversion spec with a fixed length modifier, resolving any '*'
+        TChar spec[32];
+        TUint specBytes = 0;
+        spec[specBytes++] = *p++;
+        TBool truncated = false;
+        for (; *p != '\0' && strchr("-+ #0123456789.*hlLqjzt", *p) != nullptr; p++) {
+            if (strchr("hlLqjzt", *p) != nullptr) {
+                continue;
+            }
+            if (*p == '*') {
+                const TInt value = (arg < aEntry.iNumArgs? (TInt)aEntry.iArgs[arg++] : 0);
+                specBytes += snprintf(&spec[specBytes], sizeof(spec) - specBytes, "%d", value);
+            }
+            else {
+                spec[specBytes++] = *p;
+            }
+            if (specBytes >= sizeof(spec) - 4) {
+                truncated = true;
+                break;
+            }
+        }
+        const TChar conversion = *p;
+        if (conversion == '\0' || truncated) {
+            break;
+        }
+        p++;
+        if (arg >= aEntry.iNumArgs) {
+            aLine.AppendPrintf("(?)");
+            continue;
+        }
+        const TUint64 value = aEntry.iArgs[arg];
+        const Entry::EType type = aEntry.iTypes[arg++];
+
+        if (conversion == 's') {
+            if (type == Entry::eString) {
+                const TUint offset = (TUint)(value >> 32);
+                const TUint bytes = (TUint)(value & 0xffffffff);
+                aLine.AppendPrintf("%.*s", bytes, &aEntry.iStrings[offset]);
+            }
+            else {
+                aLine.AppendPrintf("(?)");
+            }
+            continue;
+        }
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+            spec[specBytes++] = 'l';
+            spec[specBytes++] = 'l';
+            spec[specBytes++] = conversion;
+            spec[specBytes] = '\0';
+            aLine.AppendPrintf(spec, (long long)value);
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec[specBytes++] = 'l';
+            spec[specBytes++] = 'l';
+            spec[specBytes++] = conversion;
+            spec[specBytes] = '\0';
+            aLine.AppendPrintf(spec, (unsigned long long)value);
+            break;
+        case 'c':
+            spec[specBytes++] = conversion;
+            spec[specBytes] = '\0';
+            aLine.AppendPrintf(spec, (int)value);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        {
+            double d = 0;
+            if (type == Entry::eDouble) {
+                (void)memcpy(&d, &value, sizeof(d));
+            }
+            spec[specBytes++] = conversion;
+            spec[specBytes] = '\0';
+            aLine.AppendPrintf(spec, d);
+        }
+            break;
+        case 'p':
+            spec[specBytes++] = conversion;
+            spec[specBytes] = '\0';
+            aLine.AppendPrintf(spec, reinterpret_cast<void*>((uintptr_t)value));
+            break;
+        default:
+            aLine.AppendPrintf("(?)");
+            break;
+        }
+    }
+    if (aLine.Bytes() > 0 && aLine[aLine.Bytes()-1] != '\n') {
+        if (aLine.Bytes() == aLine.MaxBytes()) {
+            aLine.SetBytes(aLine.Bytes() - 1);
+        }
+        aLine.Append('\n');
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <atomic>
+#include <vector>
+
+/*
+ * As LOG() but recorded by the active BinaryLogger, if there is one and it is enabled.
+ * aFormat must be a string literal.
+ */
+#define LOG_BINARY(aLevel, aFormat, ...)                                                       \
+    do {                                                                                       \
+        if (OpenHome::Debug::TestLevel(OpenHome::Debug::aLevel)) {                             \
+            if (!OpenHome::Media::BinaryLogger::TryRecord(aFormat, ##__VA_ARGS__)) {           \
+                OpenHome::Log::Print(aFormat, ##__VA_ARGS__);                                  \
+            }                                                                                  \
+        }                                                                                      \
+    } while (0)
+
+namespace OpenHome {
+class Environment;
+class IWriter;
+namespace Media {
+
+/*
+ * Low overhead alternative to Log::Print() for code running on audio threads.
+ *
+ * TryRecord() stores a pointer to its format string, a timestamp and the raw values of its
+ * arguments in a ring owned by the calling thread.  No locks are taken and no text is
+ * formatted until Read() is called, typically from the debug service or shell.
+ * Format strings must therefore outlive the logger (i.e. be literals).  String arguments
+ * (%s, or %.*s via PBUF) are copied, truncated to kMaxStringBytes per log call.  Width and
+ * precision are ignored for strings.
+ *
+ * Only one instance may exist at a time.  Threads must stop logging before it is destroyed.
+ */
+class BinaryLogger : private INonCopyable
+{
+public:
+    static const TUint kMaxArgs = 8;
+    static const TUint kMaxStringBytes = 48;
+    static const TUint kMaxThreads = 64;
+    static const TUint kDefaultEntriesPerThread = 256;
+private:
+    static const TUint kMaxLineBytes = 1024;
+    class Entry
+    {
+    public:
+        enum EType : TByte
+        {
+            eInt,
+            eUint,
+            eDouble,
+            eString,
+            ePointer
+        };
+    public:
+        Entry();
+    public:
+        std::atomic<TUint64> iSeq; // odd while being written
+        const TChar* iFormat;
+        TUint64 iTimeUs;
+        TUint64 iArgs[kMaxArgs];
+        EType iTypes[kMaxArgs];
+        TUint iNumArgs;
+        TUint iStringBytes;
+        TChar iStrings[kMaxStringBytes];
+    };
+    class Ring;
+public:
+    BinaryLogger(Environment& aEnv, TUint aEntriesPerThread = kDefaultEntriesPerThread);
+    ~BinaryLogger();
+    void SetEnabled(TBool aEnabled);
+    TBool Enabled() const;
+    TUint Dropped() const; // log calls discarded because kMaxThreads was exceeded
+    /*
+     * Formats all entries still held, oldest first.  Safe to call while other threads log.
+     */
+    void Read(IWriter& aWriter);
+    /*
+     * Returns false (recording nothing) if no logger exists or it is disabled.
+     */
+    template<typename... Args>
+    static TBool TryRecord(const TChar* aFormat, Args... aArgs);
+private:
+    Entry* BeginEntry(const TChar* aFormat);
+    void EndEntry(Entry& aEntry, TUint aNumArgs);
+    Ring* CreateRing();
+    static void PutArgs(Entry& aEntry, TUint& aIndex);
+    template<typename T, typename... Rest>
+    static void PutArgs(Entry& aEntry, TUint& aIndex, T aFirst, Rest... aRest);
+    static void Put(Entry& aEntry, TUint& aIndex, TInt aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, TUint aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, long aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, unsigned long aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, long long aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, unsigned long long aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, double aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, const TChar* aValue);
+    static void Put(Entry& aEntry, TUint& aIndex, const TByte* aValue); // length taken from previous (PBUF) argument
+    static void Put(Entry& aEntry, TUint& aIndex, const void* aValue);
+    static void PutString(Entry& aEntry, TUint aIndex, const TChar* aPtr, TUint aBytes);
+    static void Format(const Entry& aEntry, const Brx& aThreadName, Bwx& aLine);
+private:
+    static std::atomic<BinaryLogger*> iActive;
+    static std::atomic<TUint> iGeneration;
+private:
+    Environment& iEnv;
+    const TUint iEntriesPerThread;
+    const TUint iGenerationId;
+    std::atomic<TBool> iEnabled;
+    Mutex iLockRings;
+    Ring* iRings[kMaxThreads];
+    std::atomic<TUint> iRingCount;
+    std::atomic<TUint> iDropped;
+};
+
+// BinaryLogger
+
+template<typename... Args>
+TBool BinaryLogger::TryRecord(const TChar* aFormat, Args... aArgs)
+{ // static
+    static_assert(sizeof...(aArgs) <= kMaxArgs, "BinaryLogger: too many arguments");
+    BinaryLogger* self = iActive.load(std::memory_order_acquire);
+    if (self == nullptr || !self->iEnabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    Entry* entry = self->BeginEntry(aFormat);
+    if (entry != nullptr) {
+        TUint index = 0;
+        PutArgs(*entry, index, aArgs...);
+        self->EndEntry(*entry, index);
+    }
+    return true;
+}
+
+inline void BinaryLogger::PutArgs(Entry& /*aEntry*/, TUint& /*aIndex*/)
+{ // static
+}
+
+template<typename T, typename... Rest>
+void BinaryLogger::PutArgs(Entry& aEntry, TUint& aIndex, T aFirst, Rest... aRest)
+{ // static
+    Put(aEntry, aIndex, aFirst);
+    PutArgs(aEntry, aIndex, aRest...);
+}
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,145 @@
+#include <OpenHome/Media/Utils/ClockPullerOccupancy.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Media/ClockPuller.h>
+#include <OpenHome/Media/Pipeline/Msg.h>
+#include <OpenHome/Media/Debug.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <algorithm>
+
+using namespace OpenHome;
+using namespace OpenHome::Media;
+
+// ClockPullerOccupancy
+
+const TUint ClockPullerOccupancy::kPeriodJiffies = 250 * Jiffies::kPerMs;
+
+static const TInt64 kPpbPerUnit = 1000000000LL;
+
+ClockPullerOccupancy::ClockPullerOccupancy(IPullableClock& aPullableClock)
+    : iPullableClock(aPullableClock)
+    , iLock("CPOC")
+    , iMaxPullPpb((TInt)std::min((TInt64)kMaxPullPpb, ((TInt64)aPullableClock.MaxPull() * kPpbPerUnit) / IPullableClock::kNominalFreq))
+    , iRunning(false)
+    , iOccupancy(0)
+    , iPullPpb(0)
+{
+    ResetLocked();
+}
+
+TInt ClockPullerOccupancy::PullPpb() const
+{
+    AutoMutex _(iLock);
+    return iPullPpb;
+}
+
+TInt64 ClockPullerOccupancy::OccupancyJiffies() const
+{
+    AutoMutex _(iLock);
+    return iOccupancy;
+}
+
+void ClockPullerOccupancy::Start()
+{
+    AutoMutex _(iLock);
+    ResetLocked();
+    iRunning = true;
+    LOG(kPipeline, "ClockPullerOccupancy::Start occupancy=%lldms\n", iOccupancy / Jiffies::kPerMs);
+}
+
+void ClockPullerOccupancy::Stop()
+{
+    AutoMutex _(iLock);
+    iRunning = false;
+    ResetLocked();
+    PullLocked(0);
+}
+
+void ClockPullerOccupancy::Update(TInt aDelta)
+{
+    AutoMutex _(iLock);
+    if (aDelta >= 0) {
+        iOccupancy += aDelta;
+        return;
+    }
+    // audio has been played; weight the occupancy it was played from by its duration
+    TUint played = (TUint)-aDelta;
+    iOccupancy -= played;
+    if (!iRunning) {
+        return;
+    }
+    while (played > 0) {
+        const TUint jiffies = std::min(played, kPeriodJiffies - iPeriodJiffies);
+        iPeriodWeighted += (iOccupancy + played - jiffies) * jiffies;
+        iPeriodJiffies += jiffies;
+        played -= jiffies;
+        if (iPeriodJiffies == kPeriodJiffies) {
+            PeriodCompleteLocked(iPeriodWeighted / kPeriodJiffies);
+            iPeriodJiffies = 0;
+            iPeriodWeighted = 0;
+        }
+    }
+}
+
+void ClockPullerOccupancy::ResetLocked()
+{
+    iPeriodJiffies = 0;
+    iPeriodWeighted = 0;
+    iTargetSet = false;
+    iTarget = 0;
+    iHistoryCount = 0;
+    iHistoryIndex = 0;
+    iIntegralUsMs = 0;
+}
+
+void ClockPullerOccupancy::PeriodCompleteLocked(TInt64 aMeanOccupancy)
+{
+    if (!iTargetSet) {
+        // occupancy at Start() is somewhere on the sawtooth of msg arrivals; use the first period's mean instead
+        iTarget = aMeanOccupancy;
+        iTargetSet = true;
+        return;
+    }
+    iHistory[iHistoryIndex] = aMeanOccupancy;
+    iHistoryIndex = (iHistoryIndex + 1) % kMedianWindow;
+    if (iHistoryCount < kMedianWindow) {
+        iHistoryCount++;
+        if (iHistoryCount < kMedianWindow) {
+            return;
+        }
+    }
+
+    // +ve error => buffer is growing => local clock is slow => pull faster
+    static const TInt64 kPeriodMs = kPeriodJiffies / Jiffies::kPerMs;
+    const TInt64 errorUs = ((MedianLocked() - iTarget) * 1000) / Jiffies::kPerMs;
+    const TInt64 integralUsMs = iIntegralUsMs + errorUs * kPeriodMs;
+    const TInt64 integralPpb = (integralUsMs * kKiPpbPerUsSecNum) / (kKiPpbPerUsSecDen * 1000);
+    TInt64 ppb = kKpPpbPerUs * errorUs + integralPpb;
+    const TBool saturated = (ppb > iMaxPullPpb || ppb < -iMaxPullPpb);
+    if (!saturated) { // anti-windup
+        iIntegralUsMs = integralUsMs;
+    }
+    ppb = std::max((TInt64)-iMaxPullPpb, std::min((TInt64)iMaxPullPpb, ppb));
+    ppb = std::max((TInt64)iPullPpb - kMaxSlewPpb, std::min((TInt64)iPullPpb + kMaxSlewPpb, ppb));
+    PullLocked((TInt)ppb);
+}
+
+void ClockPullerOccupancy::PullLocked(TInt aPpb)
+{
+    if (aPpb == iPullPpb) {
+        return;
+    }
+    iPullPpb = aPpb;
+    const TInt64 multiplier = (TInt64)IPullableClock::kNominalFreq + ((TInt64)aPpb * IPullableClock::kNominalFreq) / kPpbPerUnit;
+    LOG(kPipeline, "ClockPullerOccupancy: pull %dppb, occupancy %lldus from target\n",
+                   aPpb, ((iOccupancy - iTarget) * 1000) / Jiffies::kPerMs);
+    iPullableClock.PullClock((TUint)multiplier);
+}
+
+TInt64 ClockPullerOccupancy::MedianLocked() const
+{
+    TInt64 sorted[kMedianWindow];
+    std::copy(iHistory, iHistory + kMedianWindow, sorted);
+    std::nth_element(sorted, sorted + kMedianWindow/2, sorted + kMedianWindow);
+    return sorted[kMedianWindow/2];
+}
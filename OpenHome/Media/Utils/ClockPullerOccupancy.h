@@ -0,0 +1,71 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Media/ClockPuller.h>
+
+namespace OpenHome {
+namespace Media {
+
+class IPullableClock;
+
+/*
+    Recovers a remote sender's clock from the occupancy of the pipeline's buffer.
+
+    Occupancy is tracked from IPipelineBufferObserver updates (+ve as audio is buffered,
+    -ve as it is played).  Every kPeriodJiffies of audio played, the time-weighted mean
+    occupancy over that period is fed through a median filter (rejecting outliers such as
+    a burst of late network packets) and a PI controller that pulls the local clock
+    towards the rate that holds occupancy at the level measured just after Start().
+
+    Intended for sources (Songcast, RAOP, ...) whose senders run on an independent clock.
+    All calculations use integer arithmetic; pull values are tracked in parts per billion.
+
+    IPullableClock::PullClock() is called with this class' lock held so must not call back
+    into the pipeline.
+*/
+
+class ClockPullerOccupancy : public IClockPuller, private INonCopyable
+{
+public:
+    static const TUint kPeriodJiffies;
+    static const TUint kMedianWindow = 5;
+    static const TInt kKpPpbPerUs = 30;         // proportional gain: 30ppm per ms of error
+    static const TInt kKiPpbPerUsSecNum = 3;    // integral gain: 0.3ppm per ms of error per second
+    static const TInt kKiPpbPerUsSecDen = 10;
+    static const TInt kMaxSlewPpb = 1000;       // limits change in pull per period to 1ppm
+    static const TInt kMaxPullPpb = 1000000;    // never pull by more than 1000ppm, even if clock supports it
+public:
+    ClockPullerOccupancy(IPullableClock& aPullableClock);
+    TInt PullPpb() const;           // test/debug use only
+    TInt64 OccupancyJiffies() const; // test/debug use only
+public: // from IClockPuller
+    void Start() override;
+    void Stop() override;
+public: // from IPipelineBufferObserver
+    void Update(TInt aDelta) override;
+private:
+    void ResetLocked();
+    void PeriodCompleteLocked(TInt64 aMeanOccupancy);
+    void PullLocked(TInt aPpb);
+    TInt64 MedianLocked() const;
+private:
+    IPullableClock& iPullableClock;
+    mutable Mutex iLock;
+    const TInt iMaxPullPpb;
+    TBool iRunning;
+    TInt64 iOccupancy;
+    TUint iPeriodJiffies;
+    TInt64 iPeriodWeighted; // sum of occupancy * jiffies played this period
+    TBool iTargetSet;
+    TInt64 iTarget;
+    TInt64 iHistory[kMedianWindow];
+    TUint iHistoryCount;
+    TUint iHistoryIndex;
+    TInt64 iIntegralUsMs;
+    TInt iPullPpb;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+    Layout of the POSIX shared memory ring that AnimatorShm writes PCM into.
+
+    Deliberately depends only on the C/C++ runtime so that out of process consumers can
+    include it without linking any part of this tree.
+
+    The shared memory object (shm_open() name, e.g. "/ohPipeline") holds a ShmPcmRingHeader
+    followed, at offset kShmPcmRingDataOffset, by iDataBytes of audio.
+
+    Audio is interleaved, native endian, signed PCM:
+        bit depth 8 or 16  => int16_t per sample (8-bit audio in the top 8 bits)
+        bit depth 24 or 32 => int32_t per sample, left-justified (24-bit audio in the top 24 bits)
+    iBytesPerSample gives the container size.  iDataBytes is a multiple of every possible
+    frame size so a frame never wraps around the end of the ring.
+
+    iWriteBytes/iReadBytes are free running counts of bytes written/consumed.  The ring
+    position of either is its value modulo iDataBytes.  Only the producer writes iWriteBytes;
+    only the consumer writes iReadBytes.  A consumer that (re)attaches should start by setting
+    iReadBytes to iWriteBytes.
+
+    The format fields only change while the ring is empty (iReadBytes == iWriteBytes).
+    iFormatSeq is odd while they are being changed and is incremented again (to an even
+    value) once the change is complete.  On each change, iWriteBytes is rounded up to a
+    multiple of the new frame size; a consumer must likewise round iReadBytes up (skipping
+    the unwritten gap) before reading audio in the new format.  A consumer should re-read the format whenever it
+    sees a new even iFormatSeq; one that needs a consistent snapshot (e.g. from another
+    thread) should re-read if iFormatSeq was odd or changed while it read the fields.
+
+    Timestamps are CLOCK_MONOTONIC, in microseconds.  iReadTimeUs should be updated each time
+    iReadBytes is; iConsumerLatencyUs is any delay the consumer adds after reading audio (its
+    own buffering, DSP, output hardware) and is included in the pipeline's latency.
+
+    iPullMultiplier is the rate the producer would like audio consumed at, as a fix 1.31
+    multiple of the nominal sample rate (1<<31 => nominal).  Consumers that can resample
+    should honour it; it allows the pipeline to lock to a remote sender's clock.
+*/
+
+namespace OpenHome {
+namespace Media {
+
+static const uint32_t kShmPcmRingMagic = 0x5250484f; // "OHPR"
+static const uint32_t kShmPcmRingVersion = 1;
+static const uint32_t kShmPcmRingDataOffset = 4096;
+static const uint32_t kShmPcmRingFrameAlign = 3360; // lcm of all frame sizes (1..8 channels of 2 or 4 bytes)
+
+enum EShmPcmRingState
+{
+    eShmPcmRingStarting = 0
+   ,eShmPcmRingPlaying  = 1
+   ,eShmPcmRingHalted   = 2 // no more audio until further notice; consumer should expect to underrun
+   ,eShmPcmRingClosed   = 3
+};
+
+struct ShmPcmRingHeader
+{
+    // written once by producer at creation
+    uint32_t iMagic;
+    uint32_t iVersion;
+    uint32_t iDataOffset;
+    uint32_t iDataBytes;
+    // written by producer
+    alignas(64) std::atomic<uint32_t> iFormatSeq;
+    std::atomic<uint32_t> iSampleRate;
+    std::atomic<uint32_t> iNumChannels;
+    std::atomic<uint32_t> iBitDepth;       // of the source audio
+    std::atomic<uint32_t> iBytesPerSample; // 2 or 4
+    std::atomic<uint32_t> iState;
+    std::atomic<uint32_t> iPullMultiplier;
+    std::atomic<uint64_t> iWriteBytes;
+    std::atomic<uint64_t> iWriteTimeUs;
+    // written by consumer
+    alignas(64) std::atomic<uint64_t> iReadBytes;
+    std::atomic<uint64_t> iReadTimeUs;
+    std::atomic<uint32_t> iConsumerLatencyUs;
+};
+
+static_assert(sizeof(ShmPcmRingHeader) <= kShmPcmRingDataOffset, "ShmPcmRingHeader overlaps audio");
+#if ATOMIC_LLONG_LOCK_FREE != 2
+# error "ShmPcmRing requires lock-free 64-bit atomics"
+#endif
+
+inline uint64_t ShmPcmRingNowUs()
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+/*
+    Minimal consumer side helper.  Not thread safe; use from a single consumer thread.
+*/
+class ShmPcmRingReader
+{
+public:
+    ShmPcmRingReader() : iHeader(nullptr), iData(nullptr), iMapBytes(0), iFormatSeq(0), iReadFormatSeq(0) {}
+    ~ShmPcmRingReader() { Close(); }
+    bool Open(const char* aName)
+    {
+        Close();
+        const int fd = shm_open(aName, O_RDWR, 0);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < kShmPcmRingDataOffset) {
+            (void)close(fd);
+            return false;
+        }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        (void)close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        iHeader = static_cast<ShmPcmRingHeader*>(p);
+        iMapBytes = (size_t)st.st_size;
+        if (iHeader->iMagic != kShmPcmRingMagic || iHeader->iVersion != kShmPcmRingVersion ||
+            (size_t)iHeader->iDataOffset + iHeader->iDataBytes > iMapBytes) {
+            Close();
+            return false;
+        }
+        iData = static_cast<uint8_t*>(p) + iHeader->iDataOffset;
+        iHeader->iReadBytes.store(iHeader->iWriteBytes.load(std::memory_order_acquire), std::memory_order_release);
+        iHeader->iReadTimeUs.store(ShmPcmRingNowUs(), std::memory_order_relaxed);
+        iFormatSeq = iHeader->iFormatSeq.load(std::memory_order_acquire);
+        iReadFormatSeq = iFormatSeq;
+        return true;
+    }
+    void Close()
+    {
+        if (iHeader != nullptr) {
+            (void)munmap(iHeader, iMapBytes);
+            iHeader = nullptr;
+            iData = nullptr;
+        }
+    }
+    ShmPcmRingHeader& Header() { return *iHeader; }
+    bool FormatChanged()
+    {
+        const uint32_t seq = iHeader->iFormatSeq.load(std::memory_order_acquire);
+        if (seq == iFormatSeq || (seq & 1) != 0) { // odd => change in progress
+            return false;
+        }
+        iFormatSeq = seq;
+        return true;
+    }
+    uint32_t FrameBytes() const { return iHeader->iNumChannels.load(std::memory_order_relaxed) * iHeader->iBytesPerSample.load(std::memory_order_relaxed); }
+    uint64_t AvailableBytes() const
+    {
+        return iHeader->iWriteBytes.load(std::memory_order_acquire) - iHeader->iReadBytes.load(std::memory_order_relaxed);
+    }
+    /*
+     * Copies up to aMaxBytes (rounded down to whole frames) and advances the read cursor.
+     * Returns number of bytes copied.
+     */
+    uint32_t Read(void* aDest, uint32_t aMaxBytes)
+    {
+        const uint32_t seq = iHeader->iFormatSeq.load(std::memory_order_acquire);
+        if ((seq & 1) != 0) {
+            return 0;
+        }
+        const uint32_t frameBytes = FrameBytes();
+        if (frameBytes == 0) {
+            return 0;
+        }
+        if (seq != iReadFormatSeq) {
+            iReadFormatSeq = seq;
+            const uint64_t readBytes = iHeader->iReadBytes.load(std::memory_order_relaxed);
+            const uint64_t aligned = ((readBytes + frameBytes - 1) / frameBytes) * frameBytes;
+            if (aligned <= iHeader->iWriteBytes.load(std::memory_order_acquire)) {
+                iHeader->iReadBytes.store(aligned, std::memory_order_release);
+            }
+        }
+        uint64_t bytes = AvailableBytes();
+        if (iHeader->iFormatSeq.load(std::memory_order_acquire) != seq) {
+            return 0; // format changed while we were reading it; caller will retry
+        }
+        if (bytes > aMaxBytes) {
+            bytes = aMaxBytes;
+        }
+        bytes -= bytes % frameBytes;
+        const uint64_t readBytes = iHeader->iReadBytes.load(std::memory_order_relaxed);
+        const uint32_t pos = (uint32_t)(readBytes % iHeader->iDataBytes);
+        const uint32_t first = (bytes > iHeader->iDataBytes - pos)? iHeader->iDataBytes - pos : (uint32_t)bytes;
+        (void)memcpy(aDest, iData + pos, first);
+        (void)memcpy(static_cast<uint8_t*>(aDest) + first, iData, (size_t)bytes - first);
+        iHeader->iReadTimeUs.store(ShmPcmRingNowUs(), std::memory_order_relaxed);
+        iHeader->iReadBytes.store(readBytes + bytes, std::memory_order_release);
+        return (uint32_t)bytes;
+    }
+private:
+    ShmPcmRingHeader* iHeader;
+    uint8_t* iData;
+    size_t iMapBytes;
+    uint32_t iFormatSeq;
+    uint32_t iReadFormatSeq;
+};
+
+} // namespace Media
+} // namespace OpenHome
@@ -7,7 +7,10 @@
 #include <OpenHome/Private/Printer.h>
 #include <OpenHome/Private/Standard.h>
 #include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
 #include <OpenHome/Private/Timer.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Net/Private/DviService.h>
 #include <OpenHome/Net/Private/Service.h>
 #include <OpenHome/Json.h>
@@ -19,26 +22,234 @@
 
 #include <atomic>
 #include <map>
+#include <vector>
 #include <limits.h>
 
 using namespace OpenHome;
 using namespace OpenHome::Net;
 
+// PropertyWriterFactoryOdp::Property
+
+PropertyWriterFactoryOdp::Property::Property(const Brx& aName)
+    : iName(aName)
+    , iValue(64)
+    , iKind(PropertyKind::Text)
+    , iPending(false)
+{
+}
+
+TBool PropertyWriterFactoryOdp::Property::Set(PropertyKind aKind, const Brx& aValue)
+{
+    const TBool replaced = iPending;
+    if (aValue.Bytes() > iValue.MaxBytes()) {
+        iValue.Grow(aValue.Bytes());
+    }
+    iValue.Replace(aValue);
+    iKind = aKind;
+    iPending = true;
+    return replaced;
+}
+
+void PropertyWriterFactoryOdp::Property::Write(WriterJsonArray& aWriterProperties)
+{
+    iPending = false;
+    auto writerObj = aWriterProperties.CreateObject();
+    AutoWriterJson _(writerObj);
+    {
+        writerObj.WriteString(Odp::kKeyName, iName);
+        auto writerString = writerObj.CreateStringStreamed(Odp::kKeyValue);
+        AutoWriterJson __(writerString);
+        switch (iKind)
+        {
+        case PropertyKind::Text:
+            writerString.Write(iValue);
+            break;
+        case PropertyKind::String:
+            writerString.WriteEscaped(iValue);
+            break;
+        case PropertyKind::Binary:
+            Converter::ToBase64(writerString, iValue);
+            break;
+        }
+    }
+}
+
+TBool PropertyWriterFactoryOdp::Property::Pending() const
+{
+    return iPending;
+}
+
+const Brx& PropertyWriterFactoryOdp::Property::Name() const
+{
+    return iName;
+}
+
+
+// PropertyWriterFactoryOdp::PendingNotify
+
+PropertyWriterFactoryOdp::PendingNotify::PendingNotify(const Brx& aSid, TUint aLastWriteMs)
+    : iLastWriteMs(aLastWriteMs)
+    , iDueMs(0)
+    , iScheduled(false)
+    , iSid(aSid)
+{
+}
+
+PropertyWriterFactoryOdp::PendingNotify::~PendingNotify()
+{
+    for (auto it=iProperties.begin(); it!=iProperties.end(); ++it) {
+        delete *it;
+    }
+}
+
+const Brx& PropertyWriterFactoryOdp::PendingNotify::Sid() const
+{
+    return iSid;
+}
+
+TBool PropertyWriterFactoryOdp::PendingNotify::Set(PropertyKind aKind, const Brx& aName, const Brx& aValue)
+{
+    // services have few enough properties that a linear search beats a map
+    for (auto it=iProperties.begin(); it!=iProperties.end(); ++it) {
+        if ((*it)->Name() == aName) {
+            return (*it)->Set(aKind, aValue);
+        }
+    }
+    auto prop = new Property(aName);
+    iProperties.push_back(prop);
+    return prop->Set(aKind, aValue);
+}
+
+TBool PropertyWriterFactoryOdp::PendingNotify::HasChanges() const
+{
+    for (auto it=iProperties.begin(); it!=iProperties.end(); ++it) {
+        if ((*it)->Pending()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PropertyWriterFactoryOdp::PendingNotify::Write(WriterJsonArray& aWriterProperties)
+{
+    for (auto it=iProperties.begin(); it!=iProperties.end(); ++it) {
+        if ((*it)->Pending()) {
+            (*it)->Write(aWriterProperties);
+        }
+    }
+}
+
+
+// OdpNotifyFlusher
+
+OdpNotifyFlusher::OdpNotifyFlusher(Environment& aEnv)
+    : iEnv(aEnv)
+    , iLock("OdpF")
+    , iLockFlush("OdpG")
+    , iSem("OdpF", 0)
+    , iQuit(false)
+{
+    iThread = new ThreadFunctor("OdpFlush", MakeFunctor(*this, &OdpNotifyFlusher::Run), kPrioritySystemHigh);
+    iThread->Start();
+}
+
+OdpNotifyFlusher::~OdpNotifyFlusher()
+{
+    iLock.Wait();
+    ASSERT(iDue.size() == 0);
+    iQuit = true;
+    iLock.Signal();
+    iSem.Signal();
+    delete iThread;
+}
+
+void OdpNotifyFlusher::Schedule(IOdpNotifyFlushable& aFlushable, TUint aDelayMs)
+{
+    iLock.Wait();
+    iDue[&aFlushable] = NowMs() + aDelayMs;
+    iLock.Signal();
+    iSem.Signal();
+}
+
+void OdpNotifyFlusher::Cancel(IOdpNotifyFlushable& aFlushable)
+{
+    iLock.Wait();
+    iDue.erase(&aFlushable);
+    iLock.Signal();
+    // wait for any in-progress call to complete, then discard anything it rescheduled
+    iLockFlush.Wait();
+    iLockFlush.Signal();
+    iLock.Wait();
+    iDue.erase(&aFlushable);
+    iLock.Signal();
+}
+
+void OdpNotifyFlusher::Run()
+{
+    for (;;) {
+        iLock.Wait();
+        if (iQuit) {
+            iLock.Signal();
+            break;
+        }
+        const TUint now = NowMs();
+        auto next = iDue.end();
+        for (auto it=iDue.begin(); it!=iDue.end(); ++it) {
+            if (next == iDue.end() || (TInt)(it->second - next->second) < 0) {
+                next = it;
+            }
+        }
+        if (next == iDue.end()) {
+            iLock.Signal();
+            iSem.Wait();
+            continue;
+        }
+        const TInt remaining = (TInt)(next->second - now);
+        if (remaining > 0) {
+            iLock.Signal();
+            try {
+                iSem.Wait((TUint)remaining);
+            }
+            catch (Timeout&) {}
+            continue;
+        }
+        IOdpNotifyFlushable* flushable = next->first;
+        iDue.erase(next);
+        iLockFlush.Wait();
+        iLock.Signal();
+        flushable->NotifyFlushDue();
+        iLockFlush.Signal();
+    }
+}
+
+TUint OdpNotifyFlusher::NowMs() const
+{
+    return Os::TimeInMs(iEnv.OsCtx());
+}
+
+
 // PropertyWriterFactoryOdp
 
-PropertyWriterFactoryOdp::PropertyWriterFactoryOdp(IOdpSession& aSession, DvStack& aDvStack)
+PropertyWriterFactoryOdp::PropertyWriterFactoryOdp(IOdpSession& aSession, DvStack& aDvStack, TUint aCoalesceMs, OdpNotifyFlusher* aFlusher)
     : iLock("OdpP")
+    , iEnv(aDvStack.Env())
     , iSession(aSession)
     , iSubscriptionManager(aDvStack.SubscriptionManager())
+    , iCoalesceMs(aCoalesceMs)
     , iEnabled(true)
     , iRefCount(1)
-    , iWriter(nullptr)
     , iDuration(aDvStack.Env().InitParams()->DvMaxUpdateTimeSecs())
+    , iFlusher(aFlusher)
+    , iLockNotify("OdpN")
+    , iPendingCurrent(nullptr)
+    , iPropertiesCoalesced(0)
+    , iNotifiesWritten(0)
 {
     ASSERT(iRefCount.is_lock_free());
     iRenewTimer = new Timer(aDvStack.Env(),
                             MakeFunctor(*this, &PropertyWriterFactoryOdp::Renew),
                             "PropertyWriterFactoryOdp");
+    ASSERT(iFlusher != nullptr || iCoalesceMs == 0);
 }
 
 void PropertyWriterFactoryOdp::Disable()
@@ -56,6 +267,12 @@ void PropertyWriterFactoryOdp::Disable()
             }
         }
     }
+    // let any update that was claimed before we were disabled complete before cancelling its flush
+    iLockNotify.Wait();
+    iLockNotify.Signal();
+    if (iFlusher != nullptr) {
+        iFlusher->Cancel(*this);
+    }
     for (auto it=subscriptions.begin(); it!=subscriptions.end(); ++it) {
         (*it)->Remove();
         (*it)->RemoveRef();
@@ -63,9 +280,24 @@ void PropertyWriterFactoryOdp::Disable()
     RemoveRef();
 }
 
+TUint PropertyWriterFactoryOdp::PropertiesCoalesced() const
+{
+    AutoMutex _(iLockNotify);
+    return iPropertiesCoalesced;
+}
+
+TUint PropertyWriterFactoryOdp::NotifiesWritten() const
+{
+    AutoMutex _(iLockNotify);
+    return iNotifiesWritten;
+}
+
 PropertyWriterFactoryOdp::~PropertyWriterFactoryOdp()
 {
     delete iRenewTimer;
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        delete *it;
+    }
 }
 
 void PropertyWriterFactoryOdp::AddRef()
@@ -109,35 +341,124 @@ void PropertyWriterFactoryOdp::ScheduleRenewTimer()
     iRenewTimer->FireIn(renewMs);
 }
 
-IPropertyWriter* PropertyWriterFactoryOdp::ClaimWriter(const IDviSubscriptionUserData* /*aUserData*/,
-                                                       const Brx& aSid, TUint /*aSequenceNumber*/)
+void PropertyWriterFactoryOdp::SetPending(PropertyKind aKind, const Brx& aName, const Brx& aValue)
 {
+    if (iPendingCurrent->Set(aKind, aName, aValue)) {
+        iPropertiesCoalesced++;
+    }
+}
+
+void PropertyWriterFactoryOdp::WriteNotify(PendingNotify& aPending, TUint aNowMs)
+{ // called with iLockNotify held
+    aPending.iLastWriteMs = aNowMs;
+    if (!aPending.HasChanges()) {
+        return;
+    }
     {
         AutoMutex _(iLock);
         if (!iEnabled) {
-            return nullptr;
+            return;
         }
-        iWriter = &iSession.WriteLock();
     }
     try {
-        iWriterNotify.Set(*iWriter);
-        iWriterNotify.WriteString(Odp::kKeyType, Odp::kTypeNotify);
-        iWriterNotify.WriteString(Odp::kKeySid, aSid);
-        iWriterProperties = iWriterNotify.CreateArray(Odp::kKeyProperties);
+        IWriter& writer = iSession.WriteLock();
+        AutoOdpSession _(iSession);
+        WriterJsonObject writerNotify(writer);
+        writerNotify.WriteString(Odp::kKeyType, Odp::kTypeNotify);
+        writerNotify.WriteString(Odp::kKeySid, aPending.Sid());
+        auto writerProperties = writerNotify.CreateArray(Odp::kKeyProperties);
+        aPending.Write(writerProperties);
+        writerProperties.WriteEnd();
+        writerNotify.WriteEnd();
+        iSession.WriteEnd();
+        iNotifiesWritten++;
     }
     catch (WriterError&) {
-        iSession.WriteUnlock();
-        throw;
+        LOG_ERROR(kOdp, "Odp: failed to write notify for %.*s\n", PBUF(aPending.Sid()));
+    }
+}
+
+void PropertyWriterFactoryOdp::ScheduleFlush(TUint aNowMs)
+{ // called with iLockNotify held
+    TBool scheduled = false;
+    TUint delayMs = 0;
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        if ((*it)->iScheduled) {
+            const TInt remaining = (TInt)((*it)->iDueMs - aNowMs);
+            const TUint ms = (remaining < 0? 0 : (TUint)remaining);
+            if (!scheduled || ms < delayMs) {
+                delayMs = ms;
+            }
+            scheduled = true;
+        }
     }
+    if (scheduled) {
+        iFlusher->Schedule(*this, delayMs);
+    }
+}
+
+void PropertyWriterFactoryOdp::NotifyFlushDue()
+{
+    AutoMutex _(iLockNotify);
+    {
+        AutoMutex __(iLock);
+        if (!iEnabled) {
+            return;
+        }
+    }
+    const TUint now = NowMs();
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        auto pending = *it;
+        if (pending->iScheduled && (TInt)(now - pending->iDueMs) >= 0) {
+            pending->iScheduled = false;
+            WriteNotify(*pending, now);
+        }
+    }
+    ScheduleFlush(now);
+}
+
+TUint PropertyWriterFactoryOdp::NowMs() const
+{
+    return Os::TimeInMs(iEnv.OsCtx());
+}
+
+IPropertyWriter* PropertyWriterFactoryOdp::ClaimWriter(const IDviSubscriptionUserData* /*aUserData*/,
+                                                       const Brx& aSid, TUint /*aSequenceNumber*/)
+{
+    iLockNotify.Wait();
+    AutoMutex _(iLock);
+    if (!iEnabled) {
+        iLockNotify.Signal();
+        return nullptr;
+    }
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        if ((*it)->Sid() == aSid) {
+            iPendingCurrent = *it;
+            return this;
+        }
+    }
+    // new subscription.  First update (covering all properties) is written immediately
+    iPendingCurrent = new PendingNotify(aSid, NowMs() - iCoalesceMs);
+    iPending.push_back(iPendingCurrent);
     return this;
 }
 
 void PropertyWriterFactoryOdp::ReleaseWriter(IPropertyWriter* /*aWriter*/)
 {
-    AutoOdpSession _(iSession);
-    iWriterProperties.WriteEnd();
-    iWriterNotify.WriteEnd();
-    iSession.WriteEnd();
+    PendingNotify& pending = *iPendingCurrent;
+    iPendingCurrent = nullptr;
+    if (!pending.iScheduled) {
+        const TUint now = NowMs();
+        if (now - pending.iLastWriteMs >= iCoalesceMs) {
+            WriteNotify(pending, now);
+        }
+        else {
+            pending.iScheduled = true;
+            pending.iDueMs = pending.iLastWriteMs + iCoalesceMs;
+            ScheduleFlush(now);
+        }
+    }
+    iLockNotify.Signal();
 }
 
 void PropertyWriterFactoryOdp::NotifySubscriptionCreated(const Brx& aSid)
@@ -157,6 +478,15 @@ void PropertyWriterFactoryOdp::NotifySubscriptionCreated(const Brx& aSid)
 
 void PropertyWriterFactoryOdp::NotifySubscriptionDeleted(const Brx& aSid)
 {
+    iLockNotify.Wait();
+    for (auto it=iPending.begin(); it!=iPending.end(); ++it) {
+        if ((*it)->Sid() == aSid) {
+            delete *it; // discards any deferred update, which is of no use to a client that has unsubscribed
+            (void)iPending.erase(it);
+            break;
+        }
+    }
+    iLockNotify.Signal();
     TBool knownSubscription = false;
     TBool cancelTimer = false;
     {
@@ -188,54 +518,31 @@ void PropertyWriterFactoryOdp::LogUserData(IWriter& aWriter, const IDviSubscript
 
 void PropertyWriterFactoryOdp::PropertyWriteString(const Brx& aName, const Brx& aValue)
 {
-    auto writerObj = iWriterProperties.CreateObject();
-    AutoWriterJson _(writerObj);
-    {
-        writerObj.WriteString(Odp::kKeyName, aName);
-        auto writerString = writerObj.CreateStringStreamed(Odp::kKeyValue);
-        AutoWriterJson __(writerString);
-        writerString.WriteEscaped(aValue);
-    }
+    SetPending(PropertyKind::String, aName, aValue);
 }
 
 void PropertyWriterFactoryOdp::PropertyWriteInt(const Brx& aName, TInt aValue)
 {
     Bws<Ascii::kMaxIntStringBytes> valBuf;
     Ascii::AppendDec(valBuf, aValue);
-    auto writerObj = iWriterProperties.CreateObject();
-    AutoWriterJson _(writerObj);
-    writerObj.WriteString(Odp::kKeyName, aName);
-    writerObj.WriteString(Odp::kKeyValue, valBuf);
+    SetPending(PropertyKind::Text, aName, valBuf);
 }
 
 void PropertyWriterFactoryOdp::PropertyWriteUint(const Brx& aName, TUint aValue)
 {
     Bws<Ascii::kMaxUintStringBytes> valBuf;
     Ascii::AppendDec(valBuf, aValue);
-    auto writerObj = iWriterProperties.CreateObject();
-    AutoWriterJson _(writerObj);
-    writerObj.WriteString(Odp::kKeyName, aName);
-    writerObj.WriteString(Odp::kKeyValue, valBuf);
+    SetPending(PropertyKind::Text, aName, valBuf);
 }
 
 void PropertyWriterFactoryOdp::PropertyWriteBool(const Brx& aName, TBool aValue)
 {
-    auto writerObj = iWriterProperties.CreateObject();
-    AutoWriterJson _(writerObj);
-    writerObj.WriteString(Odp::kKeyName, aName);
-    writerObj.WriteString(Odp::kKeyValue, aValue ? WriterJson::kBoolTrue : WriterJson::kBoolFalse);
+    SetPending(PropertyKind::Text, aName, aValue ? WriterJson::kBoolTrue : WriterJson::kBoolFalse);
 }
 
 void PropertyWriterFactoryOdp::PropertyWriteBinary(const Brx& aName, const Brx& aValue)
 {
-    auto writerObj = iWriterProperties.CreateObject();
-    AutoWriterJson _(writerObj);
-    {
-        writerObj.WriteString(Odp::kKeyName, aName);
-        auto writerString = writerObj.CreateStringStreamed(Odp::kKeyValue);
-        AutoWriterJson __(writerString);
-        Converter::ToBase64(writerString, aValue);
-    }
+    SetPending(PropertyKind::Binary, aName, aValue);
 }
 
 void PropertyWriterFactoryOdp::PropertyWriteEnd()
@@ -256,9 +563,11 @@ const Brn DviOdp::kErrMsgSubscriptionNoService("Service not found");
 const TUint DviOdp::kErrCodeSubscriptionNoServiceVersion    = 803;
 const Brn DviOdp::kErrMsgSubscriptionNoServiceVersion("Service version not found");
 
-DviOdp::DviOdp(DvStack& aDvStack, IOdpSession& aSession)
+DviOdp::DviOdp(DvStack& aDvStack, IOdpSession& aSession, TUint aEventCoalesceMs, OdpNotifyFlusher* aFlusher)
     : iDvStack(aDvStack)
     , iSession(aSession)
+    , iEventCoalesceMs(aEventCoalesceMs)
+    , iFlusher(aFlusher)
     , iPropertyWriterFactory(nullptr)
     , iWriter(nullptr)
 {
@@ -266,7 +575,7 @@ DviOdp::DviOdp(DvStack& aDvStack, IOdpSession& aSession)
 
 void DviOdp::Announce()
 {
-    iPropertyWriterFactory = new PropertyWriterFactoryOdp(iSession, iDvStack);
+    iPropertyWriterFactory = new PropertyWriterFactoryOdp(iSession, iDvStack, iEventCoalesceMs, iFlusher);
     auto deviceMap = iDvStack.DeviceMap().CopyMap();
     iWriter = &iSession.WriteLock();
     AutoOdpSession _(iSession);
@@ -319,11 +628,21 @@ void DviOdp::Announce()
 void DviOdp::Disable()
 {
     if (iPropertyWriterFactory != nullptr) {
+        LOG(kOdp, "Odp: session disabled.  %u notifies written, %u property values coalesced\n",
+                  iPropertyWriterFactory->NotifiesWritten(), iPropertyWriterFactory->PropertiesCoalesced());
         iPropertyWriterFactory->Disable();
         iPropertyWriterFactory = nullptr;
     }
 }
 
+TUint DviOdp::PropertiesCoalesced() const
+{
+    if (iPropertyWriterFactory == nullptr) {
+        return 0;
+    }
+    return iPropertyWriterFactory->PropertiesCoalesced();
+}
+
 void DviOdp::Process(const Brx& aJsonRequest)
 {
     iResponseStarted = iResponseEnded = false;
@@ -3,6 +3,7 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
 #include <OpenHome/Net/Private/DviService.h>
 #include <OpenHome/Net/Private/DviSubscription.h>
 #include <OpenHome/Net/Private/Service.h>
@@ -10,10 +11,13 @@
 
 #include <atomic>
 #include <map>
+#include <vector>
 
 namespace OpenHome {
+    class Environment;
     class IWriter;
     class Timer;
+    class ThreadFunctor;
 namespace Net {
     class DvStack;
     class DviDevice;
@@ -30,19 +34,109 @@ public:
     virtual ~IOdpSession() {}
 };
 
+class IOdpNotifyFlushable
+{
+public:
+    virtual void NotifyFlushDue() = 0;
+    virtual ~IOdpNotifyFlushable() {}
+};
+
+/*
+    Writes deferred (coalesced) evented updates for any number of sessions from a single thread.
+    Writing to a session may block so this is kept off ohNet's shared Timer thread.
+*/
+class OdpNotifyFlusher : private INonCopyable
+{
+public:
+    OdpNotifyFlusher(Environment& aEnv);
+    ~OdpNotifyFlusher();
+    void Schedule(IOdpNotifyFlushable& aFlushable, TUint aDelayMs); // replaces any earlier schedule for aFlushable
+    void Cancel(IOdpNotifyFlushable& aFlushable); // on return, aFlushable is not being (and won't be) called
+private:
+    void Run();
+    TUint NowMs() const;
+private:
+    Environment& iEnv;
+    Mutex iLock;
+    Mutex iLockFlush; // held while NotifyFlushDue() is called
+    Semaphore iSem;
+    std::map<IOdpNotifyFlushable*, TUint> iDue; // flushable => due time (ms)
+    TBool iQuit;
+    ThreadFunctor* iThread;
+};
+
+/*
+    Writes evented updates for all of a session's subscriptions.
+
+    Updates are coalesced per subscription.  The first change after a quiet period is written
+    immediately.  Any further changes within aCoalesceMs of that are held back and written as
+    a single notify message once the window expires, carrying only the latest value of each
+    property.  This bounds the rate of messages to a client during bursts of changes (volume
+    knob spins, seek scrubbing, playlist bulk edits) without delaying isolated changes.
+    aCoalesceMs of 0 writes every update immediately.
+    Deferred updates are written by aFlusher if this is non-null, otherwise by a flusher
+    (thread) owned by this factory.
+*/
 class PropertyWriterFactoryOdp : public IPropertyWriterFactory
                                , private IPropertyWriter
+                               , private IOdpNotifyFlushable
                                , private INonCopyable
 {
 public:
-    PropertyWriterFactoryOdp(IOdpSession& aSession, DvStack& aDvStack);
+    PropertyWriterFactoryOdp(IOdpSession& aSession, DvStack& aDvStack, TUint aCoalesceMs, OdpNotifyFlusher* aFlusher); // aFlusher may be nullptr iff aCoalesceMs is 0
     void Disable();
+    TUint PropertiesCoalesced() const; // count of property values replaced before they were written
+    TUint NotifiesWritten() const;
+private:
+    enum class PropertyKind
+    {
+        Text,
+        String,
+        Binary
+    };
+    class Property : private INonCopyable
+    {
+    public:
+        Property(const Brx& aName);
+        TBool Set(PropertyKind aKind, const Brx& aValue); // returns true if an unwritten value was replaced
+        void Write(WriterJsonArray& aWriterProperties);
+        TBool Pending() const;
+        const Brx& Name() const;
+    private:
+        Bwh iName;
+        Bwh iValue;
+        PropertyKind iKind;
+        TBool iPending;
+    };
+    class PendingNotify : private INonCopyable
+    {
+    public:
+        PendingNotify(const Brx& aSid, TUint aLastWriteMs);
+        ~PendingNotify();
+        const Brx& Sid() const;
+        TBool Set(PropertyKind aKind, const Brx& aName, const Brx& aValue);
+        TBool HasChanges() const;
+        void Write(WriterJsonArray& aWriterProperties);
+    public:
+        TUint iLastWriteMs;
+        TUint iDueMs;
+        TBool iScheduled;
+    private:
+        Brh iSid;
+        std::vector<Property*> iProperties;
+    };
 private:
     ~PropertyWriterFactoryOdp();
     void AddRef();
     void RemoveRef();
     void Renew();
     void ScheduleRenewTimer();
+    void SetPending(PropertyKind aKind, const Brx& aName, const Brx& aValue);
+    void WriteNotify(PendingNotify& aPending, TUint aNowMs);
+    void ScheduleFlush(TUint aNowMs);
+    TUint NowMs() const;
+private: // from IOdpNotifyFlushable
+    void NotifyFlushDue() override;
 private: // from IPropertyWriterFactory
     IPropertyWriter* ClaimWriter(const IDviSubscriptionUserData* aUserData,
                                  const Brx& aSid, TUint aSequenceNumber) override;
@@ -60,16 +154,21 @@ private: // from IPropertyWriter
     void PropertyWriteEnd() override;
 private:
     Mutex iLock;
+    Environment& iEnv;
     IOdpSession& iSession;
     DviSubscriptionManager& iSubscriptionManager;
+    const TUint iCoalesceMs;
     TBool iEnabled;
     std::atomic<TUint> iRefCount;
     std::map<Brn, Brn, BufferCmp> iSubscriptions;
-    IWriter* iWriter;
-    WriterJsonObject iWriterNotify;
-    WriterJsonArray iWriterProperties;
     Timer* iRenewTimer;
     TUint iDuration;
+    OdpNotifyFlusher* iFlusher;
+    mutable Mutex iLockNotify; // held from ClaimWriter to ReleaseWriter and while deferred updates are written.  Protects members below
+    std::vector<PendingNotify*> iPending;
+    PendingNotify* iPendingCurrent;
+    TUint iPropertiesCoalesced;
+    TUint iNotifiesWritten;
 };
 
 class DviOdp : private IDviInvocation
@@ -85,11 +184,14 @@ public:
     static const Brn kErrMsgSubscriptionNoService;
     static const TUint kErrCodeSubscriptionNoServiceVersion;
     static const Brn kErrMsgSubscriptionNoServiceVersion;
+    static const TUint kEventCoalesceMsDefault = 50;
 public:
-    DviOdp(DvStack& aDvStack, IOdpSession& aSession);
+    DviOdp(DvStack& aDvStack, IOdpSession& aSession, TUint aEventCoalesceMs,
+           OdpNotifyFlusher* aFlusher); // aFlusher is normally shared by all of a server's sessions; may be nullptr iff aEventCoalesceMs is 0
     void Announce();
     void Disable();
     void Process(const Brx& aJsonRequest);
+    TUint PropertiesCoalesced() const;
 private:
     void LogParseErrorThrow(const TChar* aEx, const Brx& aJson);
     void Action();
@@ -131,6 +233,8 @@ private: // from IDviInvocation
 private:
     DvStack& iDvStack;
     IOdpSession& iSession;
+    const TUint iEventCoalesceMs;
+    OdpNotifyFlusher* iFlusher;
     PropertyWriterFactoryOdp* iPropertyWriterFactory;
     IWriter* iWriter;
     JsonParser iParserReq;
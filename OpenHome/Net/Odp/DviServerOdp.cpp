@@ -19,7 +19,7 @@ using namespace OpenHome::Net;
 
 const Brn DviSessionOdp::kUserAgentDefault("Odp");
 
-DviSessionOdp::DviSessionOdp(DvStack& aDvStack, TIpAddress aAdapter)
+DviSessionOdp::DviSessionOdp(DvStack& aDvStack, TIpAddress aAdapter, TUint aEventCoalesceMs, OdpNotifyFlusher* aFlusher)
     : iAdapter(aAdapter)
     , iWriteLock("Odp1")
     , iShutdownSem("Odp2", 1)
@@ -27,7 +27,7 @@ DviSessionOdp::DviSessionOdp(DvStack& aDvStack, TIpAddress aAdapter)
     iReadBuffer = new Srs<1024>(*this);
     iReaderUntil = new ReaderUntilS<kMaxReadBytes>(*iReadBuffer);
     iWriteBuffer = new Sws<kWriteBufferBytes>(*this);
-    iProtocol = new DviOdp(aDvStack, *this);
+    iProtocol = new DviOdp(aDvStack, *this, aEventCoalesceMs, aFlusher);
 }
 
 DviSessionOdp::~DviSessionOdp()
@@ -104,17 +104,23 @@ const Brx& DviSessionOdp::ClientUserAgentDefault() const
 
 // DviServerOdp
 
-DviServerOdp::DviServerOdp(DvStack& aDvStack, TUint aNumSessions, TUint aPort)
+DviServerOdp::DviServerOdp(DvStack& aDvStack, TUint aNumSessions, TUint aPort, TUint aEventCoalesceMs)
     : DviServer(aDvStack)
     , iNumSessions(aNumSessions)
     , iPort(aPort)
+    , iEventCoalesceMs(aEventCoalesceMs)
+    , iFlusher(nullptr)
 {
+    if (iEventCoalesceMs > 0) {
+        iFlusher = new OdpNotifyFlusher(aDvStack.Env());
+    }
     Initialise();
 }
 
 DviServerOdp::~DviServerOdp()
 {
     Deinitialise();
+    delete iFlusher;
 }
 
 TUint DviServerOdp::Port() const
@@ -132,7 +138,7 @@ SocketTcpServer* DviServerOdp::CreateServer(const NetworkAdapter& aNif)
         Bws<Thread::kMaxNameBytes+1> thName;
         thName.AppendPrintf("OdpSession%d", i);
         thName.PtrZ();
-        auto session = new DviSessionOdp(iDvStack, aNif.Address());
+        auto session = new DviSessionOdp(iDvStack, aNif.Address(), iEventCoalesceMs, iFlusher);
         server->Add(reinterpret_cast<const TChar*>(thName.Ptr()), session);
     }
 
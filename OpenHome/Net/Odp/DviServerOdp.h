@@ -14,7 +14,7 @@ class DviSessionOdp : public SocketTcpSession
 {
     static const Brn kUserAgentDefault;
 public:
-    DviSessionOdp(DvStack& aDvStack, TIpAddress aAdapter);
+    DviSessionOdp(DvStack& aDvStack, TIpAddress aAdapter, TUint aEventCoalesceMs, OdpNotifyFlusher* aFlusher);
     ~DviSessionOdp();
 private: // from SocketTcpSession
     void Run() override;
@@ -39,7 +39,8 @@ private:
 class DviServerOdp : public DviServer
 {
 public:
-    DviServerOdp(DvStack& aDvStack, TUint aNumSessions, TUint aPort = 0);
+    DviServerOdp(DvStack& aDvStack, TUint aNumSessions, TUint aPort = 0,
+                 TUint aEventCoalesceMs = DviOdp::kEventCoalesceMsDefault);
     ~DviServerOdp();
     TUint Port() const;
 private: // from DviServerUpnp
@@ -48,6 +49,8 @@ private: // from DviServerUpnp
 private:
     const TUint iNumSessions;
     TUint iPort;
+    const TUint iEventCoalesceMs;
+    OdpNotifyFlusher* iFlusher; // shared by all sessions
 };
 
 } // namespace Net
@@ -0,0 +1,746 @@
+#include <OpenHome/Net/Odp/DviServerOdpEpoll.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/NetworkAdapterList.h>
+#include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Net/Private/DviStack.h>
+#include <OpenHome/Net/Odp/DviOdp.h>
+#include <OpenHome/Private/Debug.h>
+#include <OpenHome/Debug-ohMediaPlayer.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+using namespace OpenHome;
+using namespace OpenHome::Net;
+
+// DviSessionOdpEpoll
+
+const Brn DviSessionOdpEpoll::kUserAgentDefault("Odp");
+const TUint DviSessionOdpEpoll::kMaxReadBytes;
+
+DviSessionOdpEpoll::DviSessionOdpEpoll(DviServerOdpEpoll& aServer, DvStack& aDvStack, TInt aFd, TIpAddress aAdapter,
+                                       TUint aEventCoalesceMs, OdpNotifyFlusher* aFlusher)
+    : iServer(aServer)
+    , iFd(aFd)
+    , iAdapter(aAdapter)
+    , iWriteLock("OdE1")
+    , iLock("OdE2")
+    , iMsg(kWriteBufferBytesInitial)
+    , iIn(kReadBufferBytesInitial)
+    , iOut(kWriteBufferBytesInitial)
+    , iOutOffset(0)
+    , iEvents(EPOLLIN)
+    , iAnnounced(false)
+    , iProcessing(true) // server schedules Announce() as soon as we're accepted
+    , iClosing(false)
+    , iCloseQueued(false)
+{
+    iProtocol = new DviOdp(aDvStack, *this, aEventCoalesceMs, aFlusher);
+}
+
+DviSessionOdpEpoll::~DviSessionOdpEpoll()
+{
+    iProtocol->Disable();
+    iWriteLock.Wait();
+    /* Nothing to do inside this lock.  Taking it after calling iProtocol->Disable() confirms
+       that no evented update is currently using iMsg. */
+    iWriteLock.Signal();
+    delete iProtocol;
+    (void)::close(iFd);
+}
+
+void DviSessionOdpEpoll::HandleReadable()
+{
+    AutoMutex _(iLock);
+    if (iClosing) {
+        return;
+    }
+    for (;;) {
+        if (iIn.Bytes() == iIn.MaxBytes()) {
+            if (iIn.MaxBytes() >= kMaxReadBytes) {
+                break; // full - UpdateEventsLocked() stops us polling for input until a worker consumes a request
+            }
+            iIn.Grow(std::min(2 * iIn.MaxBytes(), kMaxReadBytes));
+        }
+        TByte* ptr = const_cast<TByte*>(iIn.Ptr()) + iIn.Bytes();
+        const ssize_t bytes = ::recv(iFd, ptr, iIn.MaxBytes() - iIn.Bytes(), MSG_DONTWAIT);
+        if (bytes > 0) {
+            iIn.SetBytes(iIn.Bytes() + (TUint)bytes);
+        }
+        else if (bytes == 0) {
+            RequestCloseLocked(); // client closed its connection
+            return;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        else if (errno != EINTR) {
+            RequestCloseLocked();
+            return;
+        }
+    }
+    if (iIn.Bytes() >= kMaxReadBytes && !HasRequestLocked()) {
+        LOG_ERROR(kOdp, "DviSessionOdpEpoll: request exceeds %u bytes, closing connection\n", kMaxReadBytes);
+        RequestCloseLocked();
+        return;
+    }
+    ScheduleIfReadyLocked();
+    UpdateEventsLocked();
+}
+
+void DviSessionOdpEpoll::HandleWritable()
+{
+    AutoMutex _(iLock);
+    if (iClosing) {
+        return;
+    }
+    TrySendLocked();
+    ScheduleIfReadyLocked(); // may have been held back waiting for the client to read our output
+    UpdateEventsLocked();
+}
+
+void DviSessionOdpEpoll::Process(Bwx& aRequest)
+{
+    try {
+        if (!iAnnounced) {
+            iAnnounced = true;
+            iProtocol->Announce();
+        }
+        while (TryReadRequest(aRequest)) {
+            try {
+                iProtocol->Process(aRequest);
+            }
+            catch (AssertionFailed&) {
+                throw;
+            }
+            catch (Exception& ex) {
+                LOG_ERROR(kOdp, "DviSessionOdpEpoll::Process - %s parsing request:\n%.*s\n", ex.Message(), PBUF(aRequest));
+            }
+        }
+    }
+    catch (AssertionFailed&) {
+        throw;
+    }
+    catch (Exception&) {
+        AutoMutex _(iLock);
+        RequestCloseLocked();
+    }
+
+    AutoMutex _(iLock);
+    iProcessing = false;
+    if (iClosing) {
+        if (!iCloseQueued) {
+            iCloseQueued = true;
+            iServer.PostClose(*this);
+        }
+    }
+    else {
+        // the poller won't have scheduled us for any request that arrived while we were busy
+        ScheduleIfReadyLocked();
+    }
+}
+
+TBool DviSessionOdpEpoll::TryReadRequest(Bwx& aRequest)
+{
+    AutoMutex _(iLock);
+    if (iClosing || QueuedBytesLocked() >= kWriteQueueHighWaterBytes) {
+        return false;
+    }
+    const TByte* start = iIn.Ptr();
+    const TByte* lf = static_cast<const TByte*>(memchr(start, Ascii::kLf, iIn.Bytes()));
+    if (lf == nullptr) {
+        return false;
+    }
+    const TUint bytes = (TUint)(lf - start);
+    aRequest.Replace(Brn(start, bytes));
+    const TUint remaining = iIn.Bytes() - bytes - 1;
+    (void)memmove(const_cast<TByte*>(start), lf + 1, remaining);
+    iIn.SetBytes(remaining);
+    UpdateEventsLocked(); // resumes reading if our buffer had been full
+    return true;
+}
+
+void DviSessionOdpEpoll::RequestCloseLocked()
+{
+    if (!iClosing) {
+        iClosing = true;
+        // Stop polling now rather than in ProcessCloses(), which waits for any worker to finish
+        // with us.  Level-triggered EOF/HUP would otherwise wake the poller continuously until then.
+        iServer.RemoveFd(iFd);
+    }
+    if (!iProcessing && !iCloseQueued) {
+        iCloseQueued = true;
+        iServer.PostClose(*this);
+    }
+}
+
+void DviSessionOdpEpoll::TrySendLocked()
+{
+    while (iOutOffset < iOut.Bytes()) {
+        const ssize_t sent = ::send(iFd, iOut.Ptr() + iOutOffset, iOut.Bytes() - iOutOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent > 0) {
+            iOutOffset += (TUint)sent;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        else if (sent == 0 || errno != EINTR) {
+            RequestCloseLocked();
+            return;
+        }
+    }
+    iOut.SetBytes(0);
+    iOutOffset = 0;
+}
+
+void DviSessionOdpEpoll::UpdateEventsLocked()
+{
+    if (iClosing) {
+        return; // may already have been removed from the poller
+    }
+    TUint events = 0;
+    if (iIn.Bytes() < kMaxReadBytes) {
+        events |= EPOLLIN;
+    }
+    if (iOutOffset < iOut.Bytes()) {
+        events |= EPOLLOUT;
+    }
+    if (events != iEvents) {
+        iEvents = events;
+        iServer.SetEvents(iFd, events);
+    }
+}
+
+TBool DviSessionOdpEpoll::HasRequestLocked() const
+{
+    return memchr(iIn.Ptr(), Ascii::kLf, iIn.Bytes()) != nullptr;
+}
+
+TUint DviSessionOdpEpoll::QueuedBytesLocked() const
+{
+    return iOut.Bytes() - iOutOffset;
+}
+
+void DviSessionOdpEpoll::ScheduleIfReadyLocked()
+{
+    if (!iProcessing && !iClosing && HasRequestLocked() && QueuedBytesLocked() < kWriteQueueHighWaterBytes) {
+        iProcessing = true;
+        iServer.Schedule(*this);
+    }
+}
+
+IWriter& DviSessionOdpEpoll::WriteLock()
+{
+    iWriteLock.Wait();
+    iMsg.SetBytes(0); // discard any message that was abandoned without a call to WriteEnd()
+    return *this;
+}
+
+void DviSessionOdpEpoll::WriteUnlock()
+{
+    iWriteLock.Signal();
+}
+
+void DviSessionOdpEpoll::WriteEnd()
+{
+    Write(Ascii::kLf);
+    AutoMutex _(iLock);
+    if (iClosing) {
+        iMsg.SetBytes(0);
+        return;
+    }
+    const TUint queued = QueuedBytesLocked();
+    if (queued > 0 && queued + iMsg.Bytes() > kMaxWriteQueueBytes) {
+        LOG_ERROR(kOdp, "DviSessionOdpEpoll: client isn't reading (%u bytes queued), closing connection\n", queued);
+        iServer.NotifySlowClient();
+        RequestCloseLocked();
+        iMsg.SetBytes(0);
+        return;
+    }
+    if (iOutOffset > 0 && iOut.Bytes() + iMsg.Bytes() > iOut.MaxBytes()) {
+        (void)memmove(const_cast<TByte*>(iOut.Ptr()), iOut.Ptr() + iOutOffset, queued);
+        iOut.SetBytes(queued);
+        iOutOffset = 0;
+    }
+    const TUint required = iOut.Bytes() + iMsg.Bytes();
+    if (required > iOut.MaxBytes()) {
+        iOut.Grow(std::max(required, 2 * iOut.MaxBytes()));
+    }
+    iOut.Append(iMsg);
+    iMsg.SetBytes(0);
+    TrySendLocked();
+    UpdateEventsLocked();
+}
+
+TIpAddress DviSessionOdpEpoll::Adapter() const
+{
+    return iAdapter;
+}
+
+const Brx& DviSessionOdpEpoll::ClientUserAgentDefault() const
+{
+    return kUserAgentDefault;
+}
+
+void DviSessionOdpEpoll::Write(TByte aValue)
+{
+    const Brn buf(&aValue, 1);
+    Write(buf);
+}
+
+void DviSessionOdpEpoll::Write(const Brx& aBuffer)
+{
+    const TUint required = iMsg.Bytes() + aBuffer.Bytes();
+    if (required > iMsg.MaxBytes()) {
+        iMsg.Grow(std::max(required, 2 * iMsg.MaxBytes()));
+    }
+    iMsg.Append(aBuffer);
+}
+
+void DviSessionOdpEpoll::WriteFlush()
+{
+    // messages are queued for sending from WriteEnd()
+}
+
+
+// DviServerOdpEpoll::Job
+
+DviServerOdpEpoll::Job::Job(DviSessionOdpEpoll* aSession, TBool aDispose)
+    : iSession(aSession)
+    , iDispose(aDispose)
+{
+}
+
+
+// DviServerOdpEpoll
+
+DviServerOdpEpoll::DviServerOdpEpoll(DvStack& aDvStack, TUint aNumWorkers, TUint aMaxSessions, TUint aPort, TUint aEventCoalesceMs)
+    : iDvStack(aDvStack)
+    , iMaxSessions(aMaxSessions)
+    , iEventCoalesceMs(aEventCoalesceMs)
+    , iFlusher(nullptr)
+    , iFdEpoll(-1)
+    , iFdWake(-1)
+    , iPort(aPort)
+    , iLock("OdE3")
+    , iSemJobs("OdE4", 0)
+    , iSessionCount(0)
+    , iSlowClientDisconnects(0)
+    , iAdaptersChanged(false)
+    , iQuit(false)
+{
+    ASSERT(aNumWorkers > 0);
+    NetworkAdapterList& nifList = iDvStack.Env().NetworkAdapterList();
+    try {
+        iFdEpoll = ::epoll_create1(EPOLL_CLOEXEC);
+        iFdWake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (iFdEpoll < 0 || iFdWake < 0) {
+            THROW(NetworkError);
+        }
+        struct epoll_event ev;
+        (void)memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = iFdWake;
+        if (::epoll_ctl(iFdEpoll, EPOLL_CTL_ADD, iFdWake, &ev) != 0) {
+            THROW(NetworkError);
+        }
+        // register for changes before reading the adapter list so that none are missed
+        Functor functor = MakeFunctor(*this, &DviServerOdpEpoll::AdaptersChanged);
+        iSubnetListChangeListenerId = nifList.AddSubnetListChangeListener(functor, "DviServerOdpEpoll-subnet", false);
+        iCurrentAdapterChangeListenerId = nifList.AddCurrentChangeListener(functor, "DviServerOdpEpoll-current", false);
+        try {
+            UpdateListeners(true);
+        }
+        catch (Exception&) {
+            nifList.RemoveCurrentChangeListener(iCurrentAdapterChangeListenerId);
+            nifList.RemoveSubnetListChangeListener(iSubnetListChangeListenerId);
+            throw;
+        }
+    }
+    catch (Exception&) {
+        LOG_ERROR(kOdp, "DviServerOdpEpoll: failed to create server on port %u (%d)\n", aPort, errno);
+        for (auto it=iListeners.begin(); it!=iListeners.end(); ++it) {
+            (void)::close(it->first);
+        }
+        for (TInt fd : { iFdEpoll, iFdWake }) {
+            if (fd >= 0) {
+                (void)::close(fd);
+            }
+        }
+        throw;
+    }
+
+    if (iEventCoalesceMs > 0) {
+        iFlusher = new OdpNotifyFlusher(iDvStack.Env());
+    }
+    for (TUint i=0; i<aNumWorkers; i++) {
+        Bws<Thread::kMaxNameBytes+1> thName;
+        thName.AppendPrintf("OdpWorker%u", i);
+        thName.PtrZ();
+        auto worker = new ThreadFunctor(reinterpret_cast<const TChar*>(thName.Ptr()),
+                                        MakeFunctor(*this, &DviServerOdpEpoll::WorkerRun),
+                                        kPrioritySystemHigh);
+        iWorkers.push_back(worker);
+        worker->Start();
+    }
+    iPoller = new ThreadFunctor("OdpPoller", MakeFunctor(*this, &DviServerOdpEpoll::PollerRun), kPrioritySystemHigh);
+    iPoller->Start();
+}
+
+DviServerOdpEpoll::~DviServerOdpEpoll()
+{
+    NetworkAdapterList& nifList = iDvStack.Env().NetworkAdapterList();
+    nifList.RemoveCurrentChangeListener(iCurrentAdapterChangeListenerId);
+    nifList.RemoveSubnetListChangeListener(iSubnetListChangeListenerId);
+    iLock.Wait();
+    iQuit = true;
+    iLock.Signal();
+    Wake();
+    delete iPoller;
+
+    // Poller has exited so won't schedule any more work.  Stop workers rescheduling sessions.
+    for (auto it=iSessions.begin(); it!=iSessions.end(); ++it) {
+        AutoMutex _(it->second->iLock);
+        it->second->iClosing = true;
+    }
+    iLock.Wait();
+    for (TUint i=0; i<iWorkers.size(); i++) {
+        iJobs.push_back(Job(nullptr, false));
+    }
+    iLock.Signal();
+    for (TUint i=0; i<iWorkers.size(); i++) {
+        iSemJobs.Signal();
+    }
+    for (auto it=iWorkers.begin(); it!=iWorkers.end(); ++it) {
+        delete *it; // workers run all jobs queued ahead of their exit job
+    }
+    for (auto it=iSessions.begin(); it!=iSessions.end(); ++it) {
+        delete it->second;
+    }
+    delete iFlusher;
+
+    for (auto it=iListeners.begin(); it!=iListeners.end(); ++it) {
+        (void)::close(it->first);
+    }
+    (void)::close(iFdWake);
+    (void)::close(iFdEpoll);
+}
+
+TUint DviServerOdpEpoll::Port() const
+{
+    AutoMutex _(iLock);
+    return iPort;
+}
+
+TUint DviServerOdpEpoll::SessionCount() const
+{
+    AutoMutex _(iLock);
+    return iSessionCount;
+}
+
+TUint DviServerOdpEpoll::SlowClientDisconnects() const
+{
+    AutoMutex _(iLock);
+    return iSlowClientDisconnects;
+}
+
+void DviServerOdpEpoll::Schedule(DviSessionOdpEpoll& aSession)
+{
+    iLock.Wait();
+    iJobs.push_back(Job(&aSession, false));
+    iLock.Signal();
+    iSemJobs.Signal();
+}
+
+void DviServerOdpEpoll::PostClose(DviSessionOdpEpoll& aSession)
+{
+    iLock.Wait();
+    iPendingCloses.push_back(&aSession);
+    iLock.Signal();
+    Wake();
+}
+
+void DviServerOdpEpoll::NotifySlowClient()
+{
+    AutoMutex _(iLock);
+    iSlowClientDisconnects++;
+}
+
+void DviServerOdpEpoll::SetEvents(TInt aFd, TUint aEvents)
+{
+    struct epoll_event ev;
+    (void)memset(&ev, 0, sizeof(ev));
+    ev.events = aEvents;
+    ev.data.fd = aFd;
+    (void)::epoll_ctl(iFdEpoll, EPOLL_CTL_MOD, aFd, &ev);
+}
+
+void DviServerOdpEpoll::RemoveFd(TInt aFd)
+{
+    (void)::epoll_ctl(iFdEpoll, EPOLL_CTL_DEL, aFd, nullptr);
+}
+
+void DviServerOdpEpoll::Wake()
+{
+    const uint64_t val = 1;
+    (void)::write(iFdWake, &val, sizeof(val));
+}
+
+void DviServerOdpEpoll::AdaptersChanged()
+{
+    iLock.Wait();
+    iAdaptersChanged = true;
+    iLock.Signal();
+    Wake();
+}
+
+void DviServerOdpEpoll::UpdateListeners(TBool aThrowOnError)
+{
+    std::vector<TIpAddress> adapters;
+    {
+        AutoNetworkAdapterRef ref(iDvStack.Env(), "DviServerOdpEpoll");
+        const NetworkAdapter* current = ref.Adapter();
+        if (current != nullptr) {
+            adapters.push_back(current->Address());
+        }
+        else {
+            std::vector<NetworkAdapter*>* subnetList = iDvStack.Env().NetworkAdapterList().CreateSubnetList();
+            for (TUint i=0; i<subnetList->size(); i++) {
+                adapters.push_back((*subnetList)[i]->Address());
+            }
+            NetworkAdapterList::DestroySubnetList(subnetList);
+        }
+    }
+
+    // stop listening on adapters that have gone away, closing any sessions accepted on them
+    for (auto it=iListeners.begin(); it!=iListeners.end();) {
+        if (std::find(adapters.begin(), adapters.end(), it->second) != adapters.end()) {
+            ++it;
+            continue;
+        }
+        (void)::epoll_ctl(iFdEpoll, EPOLL_CTL_DEL, it->first, nullptr);
+        (void)::close(it->first);
+        for (auto sit=iSessions.begin(); sit!=iSessions.end(); ++sit) {
+            DviSessionOdpEpoll* session = sit->second;
+            if (session->iAdapter == it->second) {
+                AutoMutex _(session->iLock);
+                session->RequestCloseLocked();
+            }
+        }
+        it = iListeners.erase(it);
+    }
+
+    for (auto it=adapters.begin(); it!=adapters.end(); ++it) {
+        TBool listening = false;
+        for (auto lit=iListeners.begin(); lit!=iListeners.end(); ++lit) {
+            if (lit->second == *it) {
+                listening = true;
+                break;
+            }
+        }
+        if (listening) {
+            continue;
+        }
+        try {
+            AddListener(*it);
+        }
+        catch (Exception&) {
+            Endpoint::AddressBuf buf;
+            Endpoint(0, *it).AppendAddress(buf);
+            LOG_ERROR(kOdp, "DviServerOdpEpoll: failed to listen on %.*s (%d)\n", PBUF(buf), errno);
+            if (aThrowOnError) {
+                throw;
+            }
+        }
+    }
+}
+
+void DviServerOdpEpoll::AddListener(TIpAddress aAdapter)
+{
+    const TInt fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        THROW(NetworkError);
+    }
+    try {
+        int reuse = 1;
+        (void)::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        iLock.Wait();
+        const TUint port = iPort; // 0 until the first listener has been allocated an ephemeral port
+        iLock.Signal();
+        struct sockaddr_in addr;
+        (void)memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = aAdapter;
+        if (::bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            if (errno == EADDRINUSE) {
+                THROW(NetworkAddressInUse);
+            }
+            THROW(NetworkError);
+        }
+        if (::listen(fd, SOMAXCONN) != 0) {
+            THROW(NetworkError);
+        }
+        socklen_t len = sizeof(addr);
+        if (::getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+            THROW(NetworkError);
+        }
+        struct epoll_event ev;
+        (void)memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (::epoll_ctl(iFdEpoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            THROW(NetworkError);
+        }
+        iLock.Wait();
+        iPort = ntohs(addr.sin_port);
+        iLock.Signal();
+    }
+    catch (Exception&) {
+        (void)::close(fd);
+        throw;
+    }
+    iListeners.insert(std::pair<TInt, TIpAddress>(fd, aAdapter));
+}
+
+void DviServerOdpEpoll::Accept(TInt aFdListen, TIpAddress aAdapter)
+{
+    for (;;) {
+        const TInt fd = ::accept4(aFdListen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR(kOdp, "DviServerOdpEpoll: accept failed (%d)\n", errno);
+            }
+            return;
+        }
+        if (iSessions.size() >= iMaxSessions) {
+            LOG_ERROR(kOdp, "DviServerOdpEpoll: rejecting connection, already have %u sessions\n", iMaxSessions);
+            (void)::close(fd);
+            continue;
+        }
+        auto session = new DviSessionOdpEpoll(*this, iDvStack, fd, aAdapter, iEventCoalesceMs, iFlusher);
+        struct epoll_event ev;
+        (void)memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (::epoll_ctl(iFdEpoll, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            LOG_ERROR(kOdp, "DviServerOdpEpoll: failed to poll new connection (%d)\n", errno);
+            delete session;
+            continue;
+        }
+        iSessions.insert(std::pair<TInt, DviSessionOdpEpoll*>(fd, session));
+        iLock.Wait();
+        iSessionCount++;
+        iLock.Signal();
+        Schedule(*session); // sends announcement
+    }
+}
+
+void DviServerOdpEpoll::ProcessCloses()
+{
+    std::vector<DviSessionOdpEpoll*> closes;
+    iLock.Wait();
+    closes.swap(iPendingCloses);
+    iLock.Signal();
+    for (auto it=closes.begin(); it!=closes.end(); ++it) {
+        DviSessionOdpEpoll* session = *it;
+        iSessions.erase(session->iFd); // fd already removed from iFdEpoll by RequestCloseLocked()
+        iLock.Wait();
+        iSessionCount--;
+        iJobs.push_back(Job(session, true)); // DviOdp::Disable() may block so don't delete session here
+        iLock.Signal();
+        iSemJobs.Signal();
+    }
+}
+
+void DviServerOdpEpoll::PollerRun()
+{
+    static const TInt kMaxEvents = 64;
+    struct epoll_event events[kMaxEvents];
+    for (;;) {
+        const TInt count = ::epoll_wait(iFdEpoll, events, kMaxEvents, -1);
+        if (count < 0 && errno != EINTR) {
+            LOG_ERROR(kOdp, "DviServerOdpEpoll: epoll_wait failed (%d)\n", errno);
+            break;
+        }
+        for (TInt i=0; i<count; i++) {
+            const TInt fd = events[i].data.fd;
+            const TUint flags = events[i].events;
+            if (fd == iFdWake) {
+                uint64_t val;
+                (void)::read(iFdWake, &val, sizeof(val));
+            }
+            else if (iListeners.find(fd) != iListeners.end()) {
+                Accept(fd, iListeners[fd]);
+            }
+            else {
+                auto it = iSessions.find(fd);
+                if (it == iSessions.end()) {
+                    continue;
+                }
+                DviSessionOdpEpoll* session = it->second;
+                if (flags & (EPOLLERR | EPOLLHUP)) {
+                    AutoMutex _(session->iLock);
+                    session->RequestCloseLocked();
+                    continue;
+                }
+                if (flags & EPOLLOUT) {
+                    session->HandleWritable();
+                }
+                if (flags & EPOLLIN) {
+                    session->HandleReadable();
+                }
+            }
+        }
+        iLock.Wait();
+        const TBool quit = iQuit;
+        const TBool adaptersChanged = iAdaptersChanged;
+        iAdaptersChanged = false;
+        iLock.Signal();
+        if (quit) {
+            break;
+        }
+        if (adaptersChanged) {
+            UpdateListeners(false);
+        }
+        ProcessCloses();
+    }
+}
+
+void DviServerOdpEpoll::WorkerRun()
+{
+    Bwh request(DviSessionOdpEpoll::kMaxReadBytes);
+    for (;;) {
+        iSemJobs.Wait();
+        iLock.Wait();
+        ASSERT(iJobs.size() > 0);
+        const Job job = iJobs.front();
+        iJobs.pop_front();
+        iLock.Signal();
+        if (job.iSession == nullptr) {
+            break;
+        }
+        if (job.iDispose) {
+            delete job.iSession;
+        }
+        else {
+            job.iSession->Process(request);
+        }
+    }
+}
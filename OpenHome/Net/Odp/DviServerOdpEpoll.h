@@ -0,0 +1,153 @@
+#pragma once
+
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Net/Odp/DviOdp.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+/*
+    Linux only.  Alternative to DviServerOdp for devices that need to support many
+    (mostly idle) control points.
+
+    Listens on the same adapter(s) as DviServerOdp - the current adapter if one is selected,
+    otherwise every adapter in the subnet list - and follows changes to these.
+
+    DviServerOdp dedicates a thread and a 12k read buffer to every possible session.
+    DviServerOdpEpoll instead multiplexes all connections onto a single epoll thread, handing
+    complete requests to a small fixed pool of worker threads.  Responses and evented updates
+    are queued per connection and written without blocking.
+
+    Back-pressure:
+    - a connection whose unprocessed requests fill its read buffer isn't read from again until
+      a worker has caught up
+    - requests from a connection with a lot of unsent output aren't processed until the client
+      has read some of it
+    - a client that stops reading altogether is disconnected once its output queue reaches
+      kMaxWriteQueueBytes (it'll resubscribe, receiving full state, when it reconnects)
+*/
+
+namespace OpenHome {
+    class ThreadFunctor;
+namespace Net {
+    class DvStack;
+    class DviServerOdpEpoll;
+
+class DviSessionOdpEpoll : private IOdpSession
+                         , private IWriter
+                         , private INonCopyable
+{
+    friend class DviServerOdpEpoll;
+    static const Brn kUserAgentDefault;
+    static const TUint kReadBufferBytesInitial = 1024;
+    static const TUint kWriteBufferBytesInitial = 1024;
+public:
+    static const TUint kMaxReadBytes = 12 * 1024;
+    static const TUint kWriteQueueHighWaterBytes = 64 * 1024;
+    static const TUint kMaxWriteQueueBytes = 256 * 1024;
+private:
+    DviSessionOdpEpoll(DviServerOdpEpoll& aServer, DvStack& aDvStack, TInt aFd, TIpAddress aAdapter,
+                       TUint aEventCoalesceMs, OdpNotifyFlusher* aFlusher);
+    ~DviSessionOdpEpoll();
+    void HandleReadable();  // epoll thread
+    void HandleWritable();  // epoll thread
+    void Process(Bwx& aRequest);  // worker thread
+    TBool TryReadRequest(Bwx& aRequest);
+    void RequestCloseLocked();
+    void TrySendLocked();
+    void UpdateEventsLocked();
+    TBool HasRequestLocked() const;
+    TUint QueuedBytesLocked() const;
+    void ScheduleIfReadyLocked();
+private: // from IOdpSession
+    IWriter& WriteLock() override;
+    void WriteUnlock() override;
+    void WriteEnd() override;
+    TIpAddress Adapter() const override;
+    const Brx& ClientUserAgentDefault() const override;
+private: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    DviServerOdpEpoll& iServer;
+    const TInt iFd;
+    const TIpAddress iAdapter;
+    Mutex iWriteLock;   // held while a message is composed in iMsg
+    Mutex iLock;        // protects everything below
+    DviOdp* iProtocol;
+    Bwh iMsg;
+    Bwh iIn;
+    Bwh iOut;
+    TUint iOutOffset;
+    TUint iEvents;
+    TBool iAnnounced;
+    TBool iProcessing;
+    TBool iClosing;
+    TBool iCloseQueued;
+};
+
+class DviServerOdpEpoll : private INonCopyable
+{
+    friend class DviSessionOdpEpoll;
+public:
+    DviServerOdpEpoll(DvStack& aDvStack, TUint aNumWorkers, TUint aMaxSessions, TUint aPort = 0,
+                      TUint aEventCoalesceMs = DviOdp::kEventCoalesceMsDefault);
+    ~DviServerOdpEpoll();
+    TUint Port() const;
+    TUint SessionCount() const;
+    TUint SlowClientDisconnects() const;
+private:
+    class Job
+    {
+    public:
+        Job(DviSessionOdpEpoll* aSession, TBool aDispose);
+    public:
+        DviSessionOdpEpoll* iSession; // nullptr => worker should exit
+        TBool iDispose;
+    };
+private:
+    void Schedule(DviSessionOdpEpoll& aSession);
+    void PostClose(DviSessionOdpEpoll& aSession);
+    void NotifySlowClient();
+    void SetEvents(TInt aFd, TUint aEvents);
+    void RemoveFd(TInt aFd);
+    void Wake();
+    void AdaptersChanged();
+    void UpdateListeners(TBool aThrowOnError);
+    void AddListener(TIpAddress aAdapter);
+    void Accept(TInt aFdListen, TIpAddress aAdapter);
+    void ProcessCloses();
+    void PollerRun();
+    void WorkerRun();
+private:
+    DvStack& iDvStack;
+    const TUint iMaxSessions;
+    const TUint iEventCoalesceMs;
+    OdpNotifyFlusher* iFlusher; // shared by all sessions - writes to them don't block
+    std::map<TInt, TIpAddress> iListeners; // listening fd => adapter; only accessed by poller thread (or constructor/destructor)
+    TInt iFdEpoll;
+    TInt iFdWake;
+    TUint iPort;
+    mutable Mutex iLock;
+    Semaphore iSemJobs;
+    std::deque<Job> iJobs;
+    std::vector<DviSessionOdpEpoll*> iPendingCloses;
+    std::map<TInt, DviSessionOdpEpoll*> iSessions; // only accessed by poller thread (or destructor after it has exited)
+    TUint iSessionCount;
+    TUint iSlowClientDisconnects;
+    TBool iAdaptersChanged;
+    TBool iQuit;
+    TUint iSubnetListChangeListenerId;
+    TUint iCurrentAdapterChangeListenerId;
+    ThreadFunctor* iPoller;
+    std::vector<ThreadFunctor*> iWorkers;
+};
+
+} // namespace Net
+} // namespace OpenHome
@@ -158,6 +158,14 @@ void TestOdp::TestActions()
         proxy->SyncEchoString(valStr, result);
         ASSERT(result == valStr);
     }
+    // strings that still contain escape sequences once unescaped must only be unescaped once
+    static const TChar* kEscapedStrings[] = { "C:\\new\\table", "\\u0041\\\"", "\\\\n", "[\"\\t\"]" };
+    for (i=0; i<sizeof(kEscapedStrings)/sizeof(kEscapedStrings[0]); i++) {
+        valStr.Set(kEscapedStrings[i]);
+        Brh result;
+        proxy->SyncEchoString(valStr, result);
+        ASSERT(result == valStr);
+    }
     valStr.Set("Lorem ipsum dolor sit amet, consectetur adipisicing elit, sed do eiusmod tempor incididunt ut "
                "labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco "
                "laboris nisi ut aliquip ex ea commodo consequat. Duis aute irure dolor in reprehenderit in "
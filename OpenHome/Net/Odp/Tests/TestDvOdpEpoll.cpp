@@ -0,0 +1,317 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Net/Private/Tests/TestBasicDv.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/Net/Core/DvDevice.h>
+#include <OpenHome/Net/Private/DviStack.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Network.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Odp/DviProtocolOdp.h>
+#include <OpenHome/Net/Odp/DviServerOdpEpoll.h>
+#include <OpenHome/Net/Odp/Odp.h>
+#include <OpenHome/Debug-ohMediaPlayer.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Net;
+using namespace OpenHome::TestFramework;
+
+/*
+    Stress test for DviServerOdpEpoll.
+    Opens hundreds of raw Odp connections from the local host, checking that every one
+    receives an announcement, responses to its own actions and evented updates caused by
+    actions from other clients.  Then checks that a client which never reads is disconnected
+    rather than being allowed to consume unbounded memory.
+*/
+
+namespace OpenHome {
+namespace Net {
+namespace Test {
+
+class DeviceOdpEpoll : private INonCopyable
+{
+public:
+    static const Brn kOdpName;
+public:
+    DeviceOdpEpoll(DvStack& aDvStack);
+    ~DeviceOdpEpoll();
+private:
+    DvDeviceStandard* iDevice;
+    ProviderTestBasic* iTestBasic;
+};
+
+class OdpClient : private INonCopyable
+{
+    static const TUint kMaxReadBytes = 16 * 1024;
+    static const TUint kMaxWriteBytes = 1024;
+public:
+    OdpClient(Environment& aEnv, const Endpoint& aEndpoint);
+    ~OdpClient();
+    void Send(const Brx& aRequest);
+    Brn ReadType(const Brx& aType); // discards any messages of other types
+    void Action(const TChar* aAction, const Brx& aArgName, const Brx& aArgValue);
+    void Subscribe();
+    TUint Increment(TUint aValue);
+private:
+    SocketTcpClient iSocket;
+    Srs<1024> iReadBuffer;
+    ReaderUntilS<kMaxReadBytes> iReaderUntil;
+    Sws<kMaxWriteBytes> iWriteBuffer;
+};
+
+} // namespace Test
+} // namespace Net
+} // namespace OpenHome
+
+using namespace OpenHome::Net::Test;
+
+static Brn ArgValue(const Brx& aJson, const Brx& aArrayKey, const Brx& aName)
+{
+    JsonParser parser;
+    parser.Parse(aJson);
+    auto args = JsonParserArray::Create(parser.String(aArrayKey));
+    try {
+        for (;;) {
+            JsonParser parserArg;
+            parserArg.Parse(args.NextObject());
+            if (parserArg.String(Odp::kKeyName) == aName) {
+                return parserArg.String(Odp::kKeyValue);
+            }
+        }
+    }
+    catch (JsonArrayEnumerationComplete&) {
+    }
+    return Brx::Empty();
+}
+
+
+// DeviceOdpEpoll
+
+const Brn DeviceOdpEpoll::kOdpName("TestOdpEpollDevice");
+static Bwh gDeviceName("device");
+
+DeviceOdpEpoll::DeviceOdpEpoll(DvStack& aDvStack)
+{
+    TestFramework::RandomiseUdn(aDvStack.Env(), gDeviceName);
+    iDevice = new DvDeviceStandard(aDvStack, gDeviceName);
+    iDevice->SetAttribute("Upnp.Domain", "openhome.org");
+    iDevice->SetAttribute("Upnp.Type", "Test");
+    iDevice->SetAttribute("Upnp.Version", "1");
+    iDevice->SetAttribute("Upnp.FriendlyName", "ohNetTestDevice");
+    iDevice->SetAttribute("Upnp.Manufacturer", "None");
+    iDevice->SetAttribute("Upnp.ModelName", "ohNet test device");
+    iDevice->SetAttribute("Odp.Name", "TestOdpEpollDevice");
+    iTestBasic = new ProviderTestBasic(*iDevice);
+    iDevice->SetEnabled();
+}
+
+DeviceOdpEpoll::~DeviceOdpEpoll()
+{
+    delete iTestBasic;
+    delete iDevice;
+}
+
+
+// OdpClient
+
+OdpClient::OdpClient(Environment& aEnv, const Endpoint& aEndpoint)
+    : iReadBuffer(iSocket)
+    , iReaderUntil(iReadBuffer)
+    , iWriteBuffer(iSocket)
+{
+    iSocket.Open(aEnv);
+    iSocket.Connect(aEndpoint, aEnv.InitParams()->TcpConnectTimeoutMs());
+}
+
+OdpClient::~OdpClient()
+{
+    iSocket.Close();
+}
+
+void OdpClient::Send(const Brx& aRequest)
+{
+    iWriteBuffer.Write(aRequest);
+    iWriteBuffer.Write(Ascii::kLf);
+    iWriteBuffer.WriteFlush();
+}
+
+Brn OdpClient::ReadType(const Brx& aType)
+{
+    for (;;) {
+        Brn line = iReaderUntil.ReadUntil(Ascii::kLf);
+        JsonParser parser;
+        parser.Parse(line);
+        if (parser.String(Odp::kKeyType) == aType) {
+            return line;
+        }
+    }
+}
+
+void OdpClient::Action(const TChar* aAction, const Brx& aArgName, const Brx& aArgValue)
+{
+    Bwh req(aArgValue.Bytes() + 256);
+    WriterBuffer writer(req);
+    WriterJsonObject obj(writer);
+    obj.WriteString(Odp::kKeyType, Odp::kTypeAction);
+    obj.WriteString(Odp::kKeyDevice, DeviceOdpEpoll::kOdpName);
+    auto service = obj.CreateObject(Odp::kKeyService);
+    service.WriteString(Odp::kKeyName, Brn("TestBasic"));
+    service.WriteInt(Odp::kKeyVersion, 1);
+    service.WriteEnd();
+    obj.WriteString(Odp::kKeyAction, Brn(aAction));
+    auto args = obj.CreateArray(Odp::kKeyArguments);
+    auto arg = args.CreateObject();
+    arg.WriteString(Odp::kKeyName, aArgName);
+    arg.WriteString(Odp::kKeyValue, aArgValue);
+    arg.WriteEnd();
+    args.WriteEnd();
+    obj.WriteEnd();
+    Send(req);
+}
+
+void OdpClient::Subscribe()
+{
+    Send(Brn("{\"type\":\"subscribe\",\"device\":\"TestOdpEpollDevice\",\"service\":{\"name\":\"TestBasic\",\"version\":1}}"));
+    (void)ReadType(Odp::kTypeSubscribeResponse);
+    (void)ReadType(Odp::kTypeNotify); // initial update, covering all properties
+}
+
+TUint OdpClient::Increment(TUint aValue)
+{
+    Bws<Ascii::kMaxUintStringBytes> val;
+    Ascii::AppendDec(val, aValue);
+    Action("Increment", Brn("Value"), val);
+    Brn resp = ReadType(Odp::kTypeActionResponse);
+    return Ascii::Uint(ArgValue(resp, Odp::kKeyArguments, Brn("Result")));
+}
+
+
+
+static void WaitForSessionCount(DviServerOdpEpoll& aServer, TUint aCount)
+{ // sessions are closed asynchronously
+    for (TUint i=0; aServer.SessionCount() != aCount && i<100; i++) {
+        Thread::Sleep(50);
+    }
+    ASSERT(aServer.SessionCount() == aCount);
+}
+
+static void TestManyClients(Environment& aEnv, DviServerOdpEpoll& aServer, const Endpoint& aEndpoint, TUint aNumClients)
+{
+    Print("  %u clients...\n", aNumClients);
+    std::vector<OdpClient*> clients;
+    TUint start = Os::TimeInMs(aEnv.OsCtx());
+    for (TUint i=0; i<aNumClients; i++) {
+        clients.push_back(new OdpClient(aEnv, aEndpoint));
+    }
+    for (auto it=clients.begin(); it!=clients.end(); ++it) {
+        (void)(*it)->ReadType(Odp::kTypeAnnouncement);
+    }
+    ASSERT(aServer.SessionCount() == aNumClients);
+    Print("    connected and announced in %ums\n", Os::TimeInMs(aEnv.OsCtx()) - start);
+
+    // pipeline one request per client before reading any responses
+    start = Os::TimeInMs(aEnv.OsCtx());
+    for (TUint i=0; i<aNumClients; i++) {
+        Bws<Ascii::kMaxUintStringBytes> val;
+        Ascii::AppendDec(val, i);
+        clients[i]->Action("Increment", Brn("Value"), val);
+    }
+    for (TUint i=0; i<aNumClients; i++) {
+        Brn resp = clients[i]->ReadType(Odp::kTypeActionResponse);
+        ASSERT(Ascii::Uint(ArgValue(resp, Odp::kKeyArguments, Brn("Result"))) == i + 1);
+    }
+    for (TUint i=0; i<aNumClients; i++) {
+        ASSERT(clients[i]->Increment(i * 2) == i * 2 + 1);
+    }
+    Print("    %u actions in %ums\n", 2 * aNumClients, Os::TimeInMs(aEnv.OsCtx()) - start);
+
+    start = Os::TimeInMs(aEnv.OsCtx());
+    for (auto it=clients.begin(); it!=clients.end(); ++it) {
+        (*it)->Subscribe();
+    }
+    Print("    subscribed in %ums\n", Os::TimeInMs(aEnv.OsCtx()) - start);
+
+    // updates are requested from an unsubscribed client so that it only ever reads responses
+    static const TUint kUpdates = 5;
+    auto driver = new OdpClient(aEnv, aEndpoint);
+    (void)driver->ReadType(Odp::kTypeAnnouncement);
+    start = Os::TimeInMs(aEnv.OsCtx());
+    for (TUint i=0; i<kUpdates; i++) {
+        Bws<Ascii::kMaxUintStringBytes> val;
+        Ascii::AppendDec(val, 1000 + i);
+        driver->Action("SetUint", Brn("ValueUint"), val);
+        (void)driver->ReadType(Odp::kTypeActionResponse);
+        for (auto it=clients.begin(); it!=clients.end(); ++it) {
+            Brn notify = (*it)->ReadType(Odp::kTypeNotify);
+            ASSERT(ArgValue(notify, Odp::kKeyProperties, Brn("VarUint")) == val);
+        }
+    }
+    Print("    %u updates delivered to every client in %ums\n", kUpdates, Os::TimeInMs(aEnv.OsCtx()) - start);
+
+    delete driver;
+    for (auto it=clients.begin(); it!=clients.end(); ++it) {
+        delete *it;
+    }
+    WaitForSessionCount(aServer, 0);
+}
+
+static void TestSlowClient(Environment& aEnv, DviServerOdpEpoll& aServer, const Endpoint& aEndpoint)
+{
+    Print("  Slow client...\n");
+    auto fast = new OdpClient(aEnv, aEndpoint);
+    (void)fast->ReadType(Odp::kTypeAnnouncement);
+    auto slow = new OdpClient(aEnv, aEndpoint);
+    (void)slow->ReadType(Odp::kTypeAnnouncement);
+    slow->Subscribe();
+    // slow now stops reading.  Each update queues a large notify on its connection.
+
+    const TUint disconnectsBefore = aServer.SlowClientDisconnects();
+    Bwh str(8 * 1024);
+    TUint updates = 0;
+    while (aServer.SlowClientDisconnects() == disconnectsBefore) {
+        ASSERT(updates < 10000); // kernel socket buffers should have filled long before this
+        str.SetBytes(0);
+        str.AppendPrintf("%u ", updates++);
+        while (str.Bytes() < str.MaxBytes()) {
+            str.Append((TChar)('a' + (updates % 26)));
+        }
+        fast->Action("SetString", Brn("ValueStr"), str);
+        (void)fast->ReadType(Odp::kTypeActionResponse);
+    }
+    Print("    slow client disconnected after %u updates\n", updates);
+    WaitForSessionCount(aServer, 1);
+
+    // the fast client is unaffected
+    ASSERT(fast->Increment(41) == 42);
+    delete slow;
+    delete fast;
+}
+
+
+
+void TestDvOdpEpoll(DvStack& aDvStack, TUint aNumClients)
+{
+    Print("TestDvOdpEpoll - starting\n");
+
+    Debug::SetLevel(Debug::kOdp);
+    Debug::SetSeverity(Debug::kSeverityError);
+
+    Environment& env = aDvStack.Env();
+    auto server = new DviServerOdpEpoll(aDvStack, 4, aNumClients + 2, 0, 0); // no coalescing - every update is written
+    aDvStack.AddProtocolFactory(new DviProtocolFactoryOdp());
+    auto device = new DeviceOdpEpoll(aDvStack);
+    Endpoint ep(server->Port(), Brn("127.0.0.1"));
+
+    TestManyClients(env, *server, ep, aNumClients);
+    TestSlowClient(env, *server, ep);
+
+    delete device;
+    delete server;
+
+    Print("TestDvOdpEpoll - completed\n");
+}
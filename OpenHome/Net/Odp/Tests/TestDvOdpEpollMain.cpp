@@ -0,0 +1,36 @@
+#include <OpenHome/Types.h>
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Net/Core/OhNet.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::Net;
+
+extern void TestDvOdpEpoll(DvStack& aDvStack, TUint aNumClients);
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionClients("-c", "--clients", 200, "number of concurrent Odp clients");
+    parser.AddOption(&optionClients);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    aInitParams->SetUseLoopbackNetworkAdapter();
+    auto lib = new Library(aInitParams);
+    auto subnetList = lib->CreateSubnetList();
+    auto subnet = (*subnetList)[0]->Subnet();
+    Library::DestroySubnetList(subnetList);
+    CpStack* cpStack = nullptr;
+    DvStack* dvStack = nullptr;
+    lib->StartCombined(subnet, cpStack, dvStack);
+
+    TestDvOdpEpoll(*dvStack, optionClients.Value());
+
+    delete lib;
+}
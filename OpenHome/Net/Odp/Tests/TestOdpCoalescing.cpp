@@ -0,0 +1,484 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/SuiteUnitTest.h>
+#include <OpenHome/Net/Private/Tests/TestBasicDv.h>
+#include <OpenHome/Types.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/Net/Core/DvDevice.h>
+#include <OpenHome/Net/Private/DviStack.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Net/Odp/DviOdp.h>
+#include <OpenHome/Net/Odp/Odp.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace OpenHome {
+namespace Net {
+namespace Test {
+
+typedef std::map<std::string, std::string> PropertyState;
+
+// Stands in for a network session, storing each message written
+class OdpSessionCapture : public IOdpSession
+                        , private IWriter
+{
+public:
+    OdpSessionCapture();
+    ~OdpSessionCapture();
+    TUint Count(const Brx& aType) const;
+    void Apply(PropertyState& aState) const; // applies properties from every notify, in order
+    void GetSid(Bwx& aSid) const; // sid from the first subscribe response
+private: // from IOdpSession
+    IWriter& WriteLock() override;
+    void WriteUnlock() override;
+    void WriteEnd() override;
+    TIpAddress Adapter() const override;
+    const Brx& ClientUserAgentDefault() const override;
+private: // from IWriter
+    void Write(TByte aValue) override;
+    void Write(const Brx& aBuffer) override;
+    void WriteFlush() override;
+private:
+    Mutex iWriteLock;
+    mutable Mutex iLock;
+    Bwh iMsg;
+    std::vector<Brh*> iMessages;
+};
+
+class DeviceOdpCoalescing : private INonCopyable
+{
+public:
+    static const Brn kOdpName;
+public:
+    DeviceOdpCoalescing(DvStack& aDvStack);
+    ~DeviceOdpCoalescing();
+private:
+    DvDeviceStandard* iDevice;
+    ProviderTestBasic* iTestBasic;
+};
+
+} // namespace Test
+
+class SuiteOdpCoalescing : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+    static const TUint kCoalesceMs = 50;
+    static const TUint kTimeoutMs = 5 * 1000;
+public:
+    SuiteOdpCoalescing(DvStack& aDvStack);
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void Create(TUint aCoalesceMs);
+    void Destroy();
+    void Action(const TChar* aAction, const TChar* aArgName, const Brx& aArgValue);
+    void SetUint(TUint aValue);
+    void SetInt(TInt aValue);
+    void WaitForValue(const Brx& aProperty, const Brx& aValue);
+    void CheckFinalState();
+private:
+    void TestInitialUpdate();
+    void TestIsolatedChangeNotDelayed();
+    void TestBurstCoalesced();
+    void TestMultiplePropertiesConsistent();
+    void TestCoalescingDisabled();
+    void TestUnsubscribeDiscardsPending();
+private:
+    DvStack& iDvStack;
+    OdpNotifyFlusher* iFlusher;
+    Test::DeviceOdpCoalescing* iDevice;
+    Test::OdpSessionCapture* iSession;
+    DviOdp* iProtocol;
+    Test::PropertyState iExpected;
+};
+
+} // namespace Net
+} // namespace OpenHome
+
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+using namespace OpenHome::Net;
+using namespace OpenHome::Net::Test;
+
+static std::string Str(const Brx& aBuf)
+{
+    return std::string(reinterpret_cast<const char*>(aBuf.Ptr()), aBuf.Bytes());
+}
+
+
+// OdpSessionCapture
+
+OdpSessionCapture::OdpSessionCapture()
+    : iWriteLock("OSC1")
+    , iLock("OSC2")
+    , iMsg(1024)
+{
+}
+
+OdpSessionCapture::~OdpSessionCapture()
+{
+    for (auto it=iMessages.begin(); it!=iMessages.end(); ++it) {
+        delete *it;
+    }
+}
+
+TUint OdpSessionCapture::Count(const Brx& aType) const
+{
+    AutoMutex _(iLock);
+    TUint count = 0;
+    for (auto it=iMessages.begin(); it!=iMessages.end(); ++it) {
+        JsonParser parser;
+        parser.Parse(**it);
+        if (parser.String(Odp::kKeyType) == aType) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void OdpSessionCapture::Apply(PropertyState& aState) const
+{
+    AutoMutex _(iLock);
+    aState.clear();
+    for (auto it=iMessages.begin(); it!=iMessages.end(); ++it) {
+        JsonParser parser;
+        parser.Parse(**it);
+        if (parser.String(Odp::kKeyType) != Odp::kTypeNotify) {
+            continue;
+        }
+        auto props = JsonParserArray::Create(parser.String(Odp::kKeyProperties));
+        try {
+            for (;;) {
+                JsonParser parserProp;
+                parserProp.Parse(props.NextObject());
+                aState[Str(parserProp.String(Odp::kKeyName))] = Str(parserProp.String(Odp::kKeyValue));
+            }
+        }
+        catch (JsonArrayEnumerationComplete&) {
+        }
+    }
+}
+
+void OdpSessionCapture::GetSid(Bwx& aSid) const
+{
+    AutoMutex _(iLock);
+    for (auto it=iMessages.begin(); it!=iMessages.end(); ++it) {
+        JsonParser parser;
+        parser.Parse(**it);
+        if (parser.String(Odp::kKeyType) == Odp::kTypeSubscribeResponse) {
+            aSid.Replace(parser.String(Odp::kKeySid));
+            return;
+        }
+    }
+    aSid.SetBytes(0);
+}
+
+IWriter& OdpSessionCapture::WriteLock()
+{
+    iWriteLock.Wait();
+    return *this;
+}
+
+void OdpSessionCapture::WriteUnlock()
+{
+    iWriteLock.Signal();
+}
+
+void OdpSessionCapture::WriteEnd()
+{
+    AutoMutex _(iLock);
+    iMessages.push_back(new Brh(iMsg));
+    iMsg.SetBytes(0);
+}
+
+TIpAddress OdpSessionCapture::Adapter() const
+{
+    return 0;
+}
+
+const Brx& OdpSessionCapture::ClientUserAgentDefault() const
+{
+    return Brx::Empty();
+}
+
+void OdpSessionCapture::Write(TByte aValue)
+{
+    const Brn buf(&aValue, 1);
+    Write(buf);
+}
+
+void OdpSessionCapture::Write(const Brx& aBuffer)
+{
+    if (iMsg.Bytes() + aBuffer.Bytes() > iMsg.MaxBytes()) {
+        iMsg.Grow(2 * (iMsg.Bytes() + aBuffer.Bytes()));
+    }
+    iMsg.Append(aBuffer);
+}
+
+void OdpSessionCapture::WriteFlush()
+{
+}
+
+
+// DeviceOdpCoalescing
+
+const Brn DeviceOdpCoalescing::kOdpName("TestOdpCoalescingDevice");
+static Bwh gDeviceName("device");
+
+DeviceOdpCoalescing::DeviceOdpCoalescing(DvStack& aDvStack)
+{
+    TestFramework::RandomiseUdn(aDvStack.Env(), gDeviceName);
+    iDevice = new DvDeviceStandard(aDvStack, gDeviceName);
+    iDevice->SetAttribute("Upnp.Domain", "openhome.org");
+    iDevice->SetAttribute("Upnp.Type", "Test");
+    iDevice->SetAttribute("Upnp.Version", "1");
+    iDevice->SetAttribute("Upnp.FriendlyName", "ohNetTestDevice");
+    iDevice->SetAttribute("Upnp.Manufacturer", "None");
+    iDevice->SetAttribute("Upnp.ModelName", "ohNet test device");
+    iDevice->SetAttribute("Odp.Name", "TestOdpCoalescingDevice");
+    iTestBasic = new ProviderTestBasic(*iDevice);
+    iDevice->SetEnabled();
+}
+
+DeviceOdpCoalescing::~DeviceOdpCoalescing()
+{
+    delete iTestBasic;
+    delete iDevice;
+}
+
+
+// SuiteOdpCoalescing
+
+SuiteOdpCoalescing::SuiteOdpCoalescing(DvStack& aDvStack)
+    : SuiteUnitTest("OdpCoalescing")
+    , iDvStack(aDvStack)
+{
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestInitialUpdate), "TestInitialUpdate");
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestIsolatedChangeNotDelayed), "TestIsolatedChangeNotDelayed");
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestBurstCoalesced), "TestBurstCoalesced");
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestMultiplePropertiesConsistent), "TestMultiplePropertiesConsistent");
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestCoalescingDisabled), "TestCoalescingDisabled");
+    AddTest(MakeFunctor(*this, &SuiteOdpCoalescing::TestUnsubscribeDiscardsPending), "TestUnsubscribeDiscardsPending");
+}
+
+void SuiteOdpCoalescing::Setup()
+{
+    iFlusher = new OdpNotifyFlusher(iDvStack.Env());
+    iDevice = new DeviceOdpCoalescing(iDvStack);
+    Create(kCoalesceMs);
+}
+
+void SuiteOdpCoalescing::TearDown()
+{
+    Destroy();
+    delete iDevice;
+    delete iFlusher;
+}
+
+void SuiteOdpCoalescing::Create(TUint aCoalesceMs)
+{
+    iSession = new OdpSessionCapture();
+    iProtocol = new DviOdp(iDvStack, *iSession, aCoalesceMs, iFlusher);
+    iProtocol->Announce();
+    Bwh req("{\"type\":\"subscribe\",\"device\":\"TestOdpCoalescingDevice\",\"service\":{\"name\":\"TestBasic\",\"version\":1}}");
+    iProtocol->Process(req);
+    for (TUint i=0; iSession->Count(Odp::kTypeNotify) == 0 && i<kTimeoutMs; i+=10) {
+        Thread::Sleep(10);
+    }
+    TEST(iSession->Count(Odp::kTypeNotify) == 1);
+    iSession->Apply(iExpected); // initial state
+}
+
+void SuiteOdpCoalescing::Destroy()
+{
+    iProtocol->Disable();
+    delete iProtocol;
+    delete iSession;
+}
+
+void SuiteOdpCoalescing::Action(const TChar* aAction, const TChar* aArgName, const Brx& aArgValue)
+{
+    Bwh req(aArgValue.Bytes() + 256);
+    WriterBuffer writer(req);
+    WriterJsonObject obj(writer);
+    obj.WriteString(Odp::kKeyType, Odp::kTypeAction);
+    obj.WriteString(Odp::kKeyDevice, DeviceOdpCoalescing::kOdpName);
+    auto service = obj.CreateObject(Odp::kKeyService);
+    service.WriteString(Odp::kKeyName, Brn("TestBasic"));
+    service.WriteInt(Odp::kKeyVersion, 1);
+    service.WriteEnd();
+    obj.WriteString(Odp::kKeyAction, Brn(aAction));
+    auto args = obj.CreateArray(Odp::kKeyArguments);
+    auto arg = args.CreateObject();
+    arg.WriteString(Odp::kKeyName, Brn(aArgName));
+    arg.WriteString(Odp::kKeyValue, aArgValue);
+    arg.WriteEnd();
+    args.WriteEnd();
+    obj.WriteEnd();
+    iProtocol->Process(req);
+}
+
+void SuiteOdpCoalescing::SetUint(TUint aValue)
+{
+    Bws<Ascii::kMaxUintStringBytes> val;
+    Ascii::AppendDec(val, aValue);
+    Action("SetUint", "ValueUint", val);
+    iExpected["VarUint"] = Str(val);
+}
+
+void SuiteOdpCoalescing::SetInt(TInt aValue)
+{
+    Bws<Ascii::kMaxIntStringBytes> val;
+    Ascii::AppendDec(val, aValue);
+    Action("SetInt", "ValueInt", val);
+    iExpected["VarInt"] = Str(val);
+}
+
+void SuiteOdpCoalescing::WaitForValue(const Brx& aProperty, const Brx& aValue)
+{
+    PropertyState state;
+    for (TUint i=0; i<kTimeoutMs; i+=5) {
+        iSession->Apply(state);
+        auto it = state.find(Str(aProperty));
+        if (it != state.end() && it->second == Str(aValue)) {
+            return;
+        }
+        Thread::Sleep(5);
+    }
+    TEST(0);
+}
+
+void SuiteOdpCoalescing::CheckFinalState()
+{
+    // give any deferred update time to be written
+    Thread::Sleep(3 * kCoalesceMs);
+    PropertyState state;
+    iSession->Apply(state);
+    TEST(state.size() == iExpected.size());
+    for (auto it=iExpected.begin(); it!=iExpected.end(); ++it) {
+        auto it2 = state.find(it->first);
+        TEST(it2 != state.end());
+        if (it2 != state.end()) {
+            TEST(it2->second == it->second);
+        }
+    }
+}
+
+void SuiteOdpCoalescing::TestInitialUpdate()
+{
+    // initial update covers all properties, was written immediately and has nothing to coalesce
+    TEST(iExpected.size() == 5);
+    TEST(iProtocol->PropertiesCoalesced() == 0);
+}
+
+void SuiteOdpCoalescing::TestIsolatedChangeNotDelayed()
+{
+    Thread::Sleep(2 * kCoalesceMs);
+    const TUint start = Os::TimeInMs(iDvStack.Env().OsCtx());
+    SetUint(7);
+    WaitForValue(Brn("VarUint"), Brn("7"));
+    const TUint elapsed = Os::TimeInMs(iDvStack.Env().OsCtx()) - start;
+    TEST(elapsed < kCoalesceMs);
+    TEST(iSession->Count(Odp::kTypeNotify) == 2);
+    CheckFinalState();
+}
+
+void SuiteOdpCoalescing::TestBurstCoalesced()
+{
+    static const TUint kChanges = 200;
+    Thread::Sleep(2 * kCoalesceMs);
+    const TUint start = Os::TimeInMs(iDvStack.Env().OsCtx());
+    for (TUint i=1; i<=kChanges; i++) {
+        SetUint(i);
+    }
+    const TUint elapsed = Os::TimeInMs(iDvStack.Env().OsCtx()) - start;
+    WaitForValue(Brn("VarUint"), Brn("200"));
+    CheckFinalState();
+
+    // at most one update per window (plus one for the leading edge)
+    const TUint notifies = iSession->Count(Odp::kTypeNotify) - 1;
+    TEST(notifies <= 2 + elapsed / kCoalesceMs);
+    Print("  %u changes in %ums => %u notifies, %u values coalesced\n",
+          kChanges, elapsed, notifies, iProtocol->PropertiesCoalesced());
+}
+
+void SuiteOdpCoalescing::TestMultiplePropertiesConsistent()
+{
+    static const TUint kChanges = 100;
+    for (TUint i=0; i<kChanges; i++) {
+        SetUint(i * 3);
+        SetInt(-(TInt)i);
+        if (i % 7 == 0) {
+            Bws<32> str;
+            str.AppendPrintf("str %u", i);
+            Action("SetString", "ValueStr", str);
+            iExpected["VarStr"] = Str(str);
+        }
+    }
+    Bws<Ascii::kMaxUintStringBytes> last;
+    Ascii::AppendDec(last, (kChanges - 1) * 3);
+    WaitForValue(Brn("VarUint"), last);
+    CheckFinalState();
+}
+
+void SuiteOdpCoalescing::TestCoalescingDisabled()
+{
+    Destroy();
+    Create(0);
+    for (TUint i=1; i<=20; i++) {
+        SetUint(i);
+    }
+    WaitForValue(Brn("VarUint"), Brn("20"));
+    CheckFinalState();
+    TEST(iProtocol->PropertiesCoalesced() == 0);
+}
+
+void SuiteOdpCoalescing::TestUnsubscribeDiscardsPending()
+{
+    Thread::Sleep(2 * kCoalesceMs);
+    SetUint(1); // written immediately
+    WaitForValue(Brn("VarUint"), Brn("1"));
+    SetUint(2); // held back for the rest of the window
+    Thread::Sleep(kCoalesceMs / 5);
+
+    Bws<128> sid;
+    iSession->GetSid(sid);
+    TEST(sid.Bytes() > 0);
+    Bwh req(sid.Bytes() + 256);
+    WriterBuffer writer(req);
+    WriterJsonObject obj(writer);
+    obj.WriteString(Odp::kKeyType, Odp::kTypeUnsubscribe);
+    obj.WriteString(Odp::kKeyDevice, DeviceOdpCoalescing::kOdpName);
+    auto service = obj.CreateObject(Odp::kKeyService);
+    service.WriteString(Odp::kKeyName, Brn("TestBasic"));
+    service.WriteInt(Odp::kKeyVersion, 1);
+    service.WriteEnd();
+    obj.WriteString(Odp::kKeySid, sid);
+    obj.WriteEnd();
+    iProtocol->Process(req);
+    TEST(iSession->Count(Odp::kTypeUnsubscribeResponse) == 1);
+
+    // no notify is written for the unsubscribed sid once its window expires
+    const TUint notifies = iSession->Count(Odp::kTypeNotify);
+    Thread::Sleep(3 * kCoalesceMs);
+    TEST(iSession->Count(Odp::kTypeNotify) == notifies);
+    PropertyState state;
+    iSession->Apply(state);
+    TEST(state["VarUint"] == "1");
+}
+
+
+
+void TestOdpCoalescing(CpStack& /*aCpStack*/, DvStack& aDvStack)
+{
+    Runner runner("Odp event coalescing tests\n");
+    runner.Add(new SuiteOdpCoalescing(aDvStack));
+    runner.Run();
+}
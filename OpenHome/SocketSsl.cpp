@@ -5,6 +5,9 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Private/Env.h>
 #include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/OsWrapper.h>
 #include <OpenHome/Debug-ohMediaPlayer.h>
 
 #include "openssl/bio.h"
@@ -13,17 +16,57 @@
 #include "openssl/engine.h"
 
 #include <stdlib.h>
+#include <time.h>
 
 namespace OpenHome {
 
+class SslSessionCache : private INonCopyable
+{
+    static const TUint kMaxSessions = 16;
+public:
+    static const TUint kMaxKeyBytes = 264; // max host name plus port
+public:
+    SslSessionCache();
+    ~SslSessionCache();
+    TBool TrySetSession(const Brx& aKey, SSL* aSsl);
+    void Add(const Brx& aKey, SSL_SESSION* aSession); // takes ownership of aSession
+    void Remove(const Brx& aKey);
+    void NotifyHandshake(TBool aResumed, TUint64 aUs);
+    SslHandshakeStats Stats() const;
+private:
+    class Entry
+    {
+    public:
+        Entry();
+        void Clear();
+    public:
+        Bws<kMaxKeyBytes> iKey;
+        SSL_SESSION* iSession;
+        TUint64 iLastUsed;
+    };
+private:
+    Entry* Find(const Brx& aKey);
+    static TBool Expired(SSL_SESSION* aSession);
+private:
+    mutable Mutex iLock;
+    Entry iEntries[kMaxSessions];
+    TUint64 iUseCount;
+    SslHandshakeStats iStats;
+};
+
 class SslContext
 {
 public:
     static SSL_CTX* Get(Environment& aEnv);
     static void RemoveRef(Environment& aEnv);
+    static SslSessionCache& SessionCache(); // only valid while a ref is held
+    static SslHandshakeStats HandshakeStats(Environment& aEnv);
+private:
+    static int NewSessionCallback(SSL* aSsl, SSL_SESSION* aSession);
 private:
     static TUint iRefCount;
     static SSL_CTX* iCtx;
+    static SslSessionCache* iSessionCache;
 };
 
 class SocketSslImpl : public IWriter, public IReaderSource
@@ -33,7 +76,7 @@ public:
     SocketSslImpl(Environment& aEnv, TUint aReadBytes);
     ~SocketSslImpl();
     void SetSecure(TBool aSecure);
-    void Connect(const Endpoint& aEndpoint, TUint aTimeoutMs);
+    void Connect(const Endpoint& aEndpoint, const Brx& aHost, TUint aTimeoutMs);
     void Close();
     void Interrupt(TBool aInterrupt);
     void LogVerbose(TBool aVerbose);
@@ -45,12 +88,17 @@ public: // from IReaderSource
     void Read(Bwx& aBuffer) override;
     void ReadFlush() override;
     void ReadInterrupt() override;
+public:
+    const Brx& SessionKey() const;
 private:
+    void Handshake(const Endpoint& aEndpoint, const Brx& aHost);
     static long BioCallback(BIO *b, int oper, const char *argp, int argi, long argl, long retvalue);
 private:
     Environment& iEnv;
     SocketTcpClient iSocketTcp;
+    SSL_CTX* iCtx;
     SSL* iSsl;
+    Bws<SslSessionCache::kMaxKeyBytes> iSessionKey;
     TUint iMemBufSize;
     TByte* iBioReadBuf;
     TBool iSecure;
@@ -64,10 +112,134 @@ private:
 using namespace OpenHome;
 
 
+// SslHandshakeStats
+
+SslHandshakeStats::SslHandshakeStats()
+    : iFullCount(0)
+    , iResumedCount(0)
+    , iFullUs(0)
+    , iResumedUs(0)
+{
+}
+
+
+// SslSessionCache
+
+SslSessionCache::Entry::Entry()
+    : iSession(nullptr)
+    , iLastUsed(0)
+{
+}
+
+void SslSessionCache::Entry::Clear()
+{
+    if (iSession != nullptr) {
+        SSL_SESSION_free(iSession);
+        iSession = nullptr;
+    }
+    iKey.SetBytes(0);
+    iLastUsed = 0;
+}
+
+SslSessionCache::SslSessionCache()
+    : iLock("SSLC")
+    , iUseCount(0)
+{
+}
+
+SslSessionCache::~SslSessionCache()
+{
+    for (TUint i=0; i<kMaxSessions; i++) {
+        iEntries[i].Clear();
+    }
+}
+
+TBool SslSessionCache::TrySetSession(const Brx& aKey, SSL* aSsl)
+{
+    AutoMutex _(iLock);
+    Entry* entry = Find(aKey);
+    if (entry == nullptr) {
+        return false;
+    }
+    if (Expired(entry->iSession)) {
+        entry->Clear();
+        return false;
+    }
+    entry->iLastUsed = ++iUseCount;
+    return (SSL_set_session(aSsl, entry->iSession) == 1); // aSsl takes its own reference
+}
+
+void SslSessionCache::Add(const Brx& aKey, SSL_SESSION* aSession)
+{
+    if (aSession == nullptr) {
+        return;
+    }
+    AutoMutex _(iLock);
+    Entry* entry = Find(aKey);
+    if (entry == nullptr) {
+        entry = &iEntries[0];
+        for (TUint i=1; i<kMaxSessions && entry->iSession != nullptr; i++) {
+            if (iEntries[i].iSession == nullptr || iEntries[i].iLastUsed < entry->iLastUsed) {
+                entry = &iEntries[i];
+            }
+        }
+    }
+    entry->Clear();
+    entry->iKey.Replace(aKey);
+    entry->iSession = aSession;
+    entry->iLastUsed = ++iUseCount;
+}
+
+void SslSessionCache::Remove(const Brx& aKey)
+{
+    AutoMutex _(iLock);
+    Entry* entry = Find(aKey);
+    if (entry != nullptr) {
+        entry->Clear();
+    }
+}
+
+void SslSessionCache::NotifyHandshake(TBool aResumed, TUint64 aUs)
+{
+    AutoMutex _(iLock);
+    if (aResumed) {
+        iStats.iResumedCount++;
+        iStats.iResumedUs += aUs;
+    }
+    else {
+        iStats.iFullCount++;
+        iStats.iFullUs += aUs;
+    }
+}
+
+SslHandshakeStats SslSessionCache::Stats() const
+{
+    AutoMutex _(iLock);
+    return iStats;
+}
+
+SslSessionCache::Entry* SslSessionCache::Find(const Brx& aKey)
+{
+    for (TUint i=0; i<kMaxSessions; i++) {
+        if (iEntries[i].iSession != nullptr && iEntries[i].iKey == aKey) {
+            return &iEntries[i];
+        }
+    }
+    return nullptr;
+}
+
+TBool SslSessionCache::Expired(SSL_SESSION* aSession)
+{ // static
+    const long expiry = SSL_SESSION_get_time(aSession) + SSL_SESSION_get_timeout(aSession);
+    return ((long)time(nullptr) >= expiry);
+}
+
+
 // SslContext
 
 TUint SslContext::iRefCount = 0;
 SSL_CTX* SslContext::iCtx = nullptr;
+SslSessionCache* SslContext::iSessionCache = nullptr;
 
 SSL_CTX* SslContext::Get(Environment& aEnv)
 { // static
@@ -79,6 +251,9 @@ SSL_CTX* SslContext::Get(Environment& aEnv)
         OpenSSL_add_all_algorithms();
         iCtx = SSL_CTX_new(SSLv23_client_method());
         SSL_CTX_set_verify(iCtx, SSL_VERIFY_NONE, nullptr);
+        SSL_CTX_set_session_cache_mode(iCtx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(iCtx, NewSessionCallback);
+        iSessionCache = new SslSessionCache();
     }
     return iCtx;
 }
@@ -87,6 +262,8 @@ void SslContext::RemoveRef(Environment& aEnv)
 { // static
     AutoMutex a(aEnv.Mutex());
     if (--iRefCount == 0) {
+        delete iSessionCache;
+        iSessionCache = nullptr;
         SSL_CTX_free(iCtx);
         iCtx = nullptr;
         CRYPTO_cleanup_all_ex_data();
@@ -97,6 +274,38 @@ void SslContext::RemoveRef(Environment& aEnv)
     }
 }
 
+SslSessionCache& SslContext::SessionCache()
+{ // static
+    ASSERT(iSessionCache != nullptr);
+    return *iSessionCache;
+}
+
+SslHandshakeStats SslContext::HandshakeStats(Environment& aEnv)
+{ // static
+    AutoMutex a(aEnv.Mutex());
+    if (iSessionCache == nullptr) {
+        return SslHandshakeStats();
+    }
+    return iSessionCache->Stats();
+}
+
+int SslContext::NewSessionCallback(SSL* aSsl, SSL_SESSION* aSession)
+{ // static
+    /* Called during SSL_connect for TLS <= 1.2.  TLS 1.3 servers send tickets after the
+       handshake so these arrive during a later SSL_read. */
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    if (!SSL_SESSION_is_resumable(aSession)) {
+        return 0;
+    }
+#endif
+    auto socket = static_cast<SocketSslImpl*>(SSL_get_app_data(aSsl));
+    if (socket == nullptr || iSessionCache == nullptr) {
+        return 0;
+    }
+    iSessionCache->Add(socket->SessionKey(), aSession);
+    return 1; // we've taken ownership of aSession's reference
+}
+
 
 // SocketSsl
 
@@ -110,6 +319,11 @@ SocketSsl::~SocketSsl()
     delete iImpl;
 }
 
+SslHandshakeStats SocketSsl::HandshakeStats(Environment& aEnv)
+{ // static
+    return SslContext::HandshakeStats(aEnv);
+}
+
 void SocketSsl::SetSecure(TBool aSecure)
 {
     iImpl->SetSecure(aSecure);
@@ -117,7 +331,12 @@ void SocketSsl::SetSecure(TBool aSecure)
 
 void SocketSsl::Connect(const Endpoint& aEndpoint, TUint aTimeoutMs)
 {
-    iImpl->Connect(aEndpoint, aTimeoutMs);
+    iImpl->Connect(aEndpoint, Brx::Empty(), aTimeoutMs);
+}
+
+void SocketSsl::Connect(const Endpoint& aEndpoint, const Brx& aHost, TUint aTimeoutMs)
+{
+    iImpl->Connect(aEndpoint, aHost, aTimeoutMs);
 }
 
 void SocketSsl::Close()
@@ -187,6 +406,7 @@ static void SslInfoCallback(const SSL* ssl, int flag, int ret)
 
 SocketSslImpl::SocketSslImpl(Environment& aEnv, TUint aReadBytes)
     : iEnv(aEnv)
+    , iCtx(SslContext::Get(aEnv))
     , iSsl(nullptr)
     , iSecure(true)
     , iConnected(false)
@@ -212,7 +432,7 @@ void SocketSslImpl::SetSecure(TBool aSecure)
     iSecure = aSecure;
 }
 
-void SocketSslImpl::Connect(const Endpoint& aEndpoint, TUint aTimeoutMs)
+void SocketSslImpl::Connect(const Endpoint& aEndpoint, const Brx& aHost, TUint aTimeoutMs)
 {
     iSocketTcp.Open(iEnv);
     try {
@@ -227,30 +447,63 @@ void SocketSslImpl::Connect(const Endpoint& aEndpoint, TUint aTimeoutMs)
         throw;
     }
     if (iSecure) {
-        ASSERT(iSsl == nullptr);
-        iSsl = SSL_new(SslContext::Get(iEnv));
-        SSL_set_info_callback(iSsl, SslInfoCallback);
-        BIO* rbio = BIO_new_mem_buf(iBioReadBuf, iMemBufSize);
-        BIO_set_callback(rbio, BioCallback);
-        BIO_set_callback_arg(rbio, (char*)this);
-        BIO* wbio = BIO_new(BIO_s_mem());
-        BIO_set_callback(wbio, BioCallback);
-        BIO_set_callback_arg(wbio, (char*)this);
-
-        SSL_set_bio(iSsl, rbio, wbio); // ownership of bios passes to iSsl
-        SSL_set_connect_state(iSsl);
-        SSL_set_mode(iSsl, SSL_MODE_AUTO_RETRY);
-
-        if (1 != SSL_connect(iSsl)) {
-            SSL_free(iSsl);
-            iSsl = nullptr;
-            iSocketTcp.Close();
-            THROW(NetworkError);
-        }
+        Handshake(aEndpoint, aHost);
     }
     iConnected = true;
 }
 
+void SocketSslImpl::Handshake(const Endpoint& aEndpoint, const Brx& aHost)
+{
+    ASSERT(iSsl == nullptr);
+    iSsl = SSL_new(iCtx);
+    SSL_set_info_callback(iSsl, SslInfoCallback);
+    BIO* rbio = BIO_new_mem_buf(iBioReadBuf, iMemBufSize);
+    BIO_set_callback(rbio, BioCallback);
+    BIO_set_callback_arg(rbio, (char*)this);
+    BIO* wbio = BIO_new(BIO_s_mem());
+    BIO_set_callback(wbio, BioCallback);
+    BIO_set_callback_arg(wbio, (char*)this);
+
+    SSL_set_bio(iSsl, rbio, wbio); // ownership of bios passes to iSsl
+    SSL_set_app_data(iSsl, this); // allows NewSessionCallback to find iSessionKey
+    SSL_set_connect_state(iSsl);
+    SSL_set_mode(iSsl, SSL_MODE_AUTO_RETRY);
+
+    iSessionKey.SetBytes(0);
+    if (aHost.Bytes() > 0 && aHost.Bytes() < iSessionKey.MaxBytes() - 6) {
+        iSessionKey.Replace(aHost);
+        (void)SSL_set_tlsext_host_name(iSsl, (char*)iSessionKey.PtrZ());
+        iSessionKey.Append(':');
+        Ascii::AppendDec(iSessionKey, aEndpoint.Port());
+    }
+    else {
+        aEndpoint.AppendEndpoint(iSessionKey);
+    }
+    SslSessionCache& cache = SslContext::SessionCache();
+    const TBool offeredSession = cache.TrySetSession(iSessionKey, iSsl);
+
+    const TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    if (1 != SSL_connect(iSsl)) {
+        if (offeredSession) {
+            cache.Remove(iSessionKey);
+        }
+        SSL_free(iSsl);
+        iSsl = nullptr;
+        iSocketTcp.Close();
+        THROW(NetworkError);
+    }
+    const TUint64 us = OsTimeInUs(iEnv.OsCtx()) - start;
+    const TBool resumed = (SSL_session_reused(iSsl) != 0);
+    cache.NotifyHandshake(resumed, us);
+    LOG(kSsl, "SocketSsl: %s handshake with %.*s in %llu us\n",
+              (resumed? "resumed" : "full"), PBUF(iSessionKey), us);
+}
+
+const Brx& SocketSslImpl::SessionKey() const
+{
+    return iSessionKey;
+}
+
 void SocketSslImpl::Close()
 {
     if (!iConnected) {
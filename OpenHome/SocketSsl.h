@@ -11,13 +11,34 @@ namespace OpenHome {
 class Environment;
 class SocketSslImpl;
 
+class SslHandshakeStats
+{
+public:
+    SslHandshakeStats();
+public:
+    TUint iFullCount;
+    TUint iResumedCount;
+    TUint64 iFullUs;    // total time spent in full handshakes
+    TUint64 iResumedUs; // total time spent in resumed handshakes
+};
+
+/*
+ * Sessions negotiated by Connect() are cached (per host where one is passed, otherwise per
+ * endpoint) and offered on later connections to the same server, allowing an abbreviated
+ * handshake.  The cache holds a limited number of sessions, discarding the least recently
+ * used and any that have expired.
+ * Sessions are cached as the server issues them, so TLS 1.3 tickets (sent after the
+ * handshake completes) are picked up by Read().
+ */
 class SocketSsl : public IWriter, public IReaderSource
 {
 public:
     SocketSsl(Environment& aEnv, TUint aReadBytes);
     ~SocketSsl();
+    static SslHandshakeStats HandshakeStats(Environment& aEnv);
     void SetSecure(TBool aSecure);
     void Connect(const Endpoint& aEndpoint, TUint aTimeoutMs);
+    void Connect(const Endpoint& aEndpoint, const Brx& aHost, TUint aTimeoutMs); // aHost is sent as SNI and shares sessions between all addresses for the host
     void Close();
     void Interrupt(TBool aInterrupt);
     void LogVerbose(TBool aVerbose);
@@ -66,6 +66,29 @@ private:
     JsonParser* iParser;
 };
 
+class SuiteJsonTape : public SuiteUnitTest
+{
+public:
+    SuiteJsonTape();
+public: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    void TestScalarTypes();
+    void TestNestedObjects();
+    void TestArrayMembers();
+    void TestEmptyContainers();
+    void TestStructuralCharsInStrings();
+    void TestLongStrings();
+    void TestUnescapeInPlace();
+    void TestTrailingContentIgnored();
+    void TestCorruptInput();
+    void TestDepthLimit();
+    void TestReuse();
+private:
+    JsonTape* iTape;
+};
+
 class SuiteWriterJson : public SuiteUnitTest
 {
 public:
@@ -429,26 +452,21 @@ void SuiteJsonParser::TestGetOptionalString()
 
 void SuiteJsonParser::TestGetValidNum()
 {
-    // FIXME - fails
-
-    //const TBool unescapeInPlace = false;
-    //const Brn json("{\"key1\": 1}");
+    const Brn json("{\"key1\": 1, \"key2\":-23 }");
 
-    //iParser->Parse(json, unescapeInPlace);
-    //TEST(iParser->Num("key1") == 1);
-    //TEST(iParser->Num(Brn("key1")) == 1);
+    iParser->Parse(json);
+    TEST(iParser->Num("key1") == 1);
+    TEST(iParser->Num(Brn("key1")) == 1);
+    TEST(iParser->Num("key2") == -23);
 }
 
 void SuiteJsonParser::TestGetInvalidNum()
 {
-    // FIXME - fails
-
-    //const TBool unescapeInPlace = false;
-    //const Brn json("{\"key1\":1}");
+    const Brn json("{\"key1\":1}");
 
-    //iParser->Parse(json, unescapeInPlace);
-    //TEST_THROWS(iParser->Num("key2"), JsonKeyNotFound);
-    //TEST_THROWS(iParser->Num(Brn("key2")), JsonKeyNotFound);
+    iParser->Parse(json);
+    TEST_THROWS(iParser->Num("key2"), JsonKeyNotFound);
+    TEST_THROWS(iParser->Num(Brn("key2")), JsonKeyNotFound);
 }
 
 void SuiteJsonParser::TestGetStringAsNum()
@@ -533,6 +551,231 @@ void SuiteJsonParser::TestParseUnicodeEscaped()
 }
 
 
+// SuiteJsonTape
+
+SuiteJsonTape::SuiteJsonTape()
+    : SuiteUnitTest("SuiteJsonTape")
+{
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestScalarTypes), "TestScalarTypes");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestNestedObjects), "TestNestedObjects");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestArrayMembers), "TestArrayMembers");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestEmptyContainers), "TestEmptyContainers");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestStructuralCharsInStrings), "TestStructuralCharsInStrings");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestLongStrings), "TestLongStrings");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestUnescapeInPlace), "TestUnescapeInPlace");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestTrailingContentIgnored), "TestTrailingContentIgnored");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestCorruptInput), "TestCorruptInput");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestDepthLimit), "TestDepthLimit");
+    AddTest(MakeFunctor(*this, &SuiteJsonTape::TestReuse), "TestReuse");
+}
+
+void SuiteJsonTape::Setup()
+{
+    iTape = new JsonTape();
+}
+
+void SuiteJsonTape::TearDown()
+{
+    delete iTape;
+}
+
+void SuiteJsonTape::TestScalarTypes()
+{
+    iTape->Parse(Brn("{\"s\":\"str\", \"i\":-12, \"f\":1.5e3, \"t\":true, \"b\":false, \"n\":null}"));
+    TEST(iTape->Count() == 7);
+    TEST(iTape->Type(0) == JsonTape::ValType::Object);
+    const TUint s = iTape->Find(0, Brn("s"));
+    TEST(iTape->Type(s) == JsonTape::ValType::String);
+    TEST(iTape->Value(s) == Brn("str"));
+    const TUint i = iTape->Find(0, Brn("i"));
+    TEST(iTape->Type(i) == JsonTape::ValType::Number);
+    TEST(iTape->Value(i) == Brn("-12"));
+    const TUint f = iTape->Find(0, Brn("f"));
+    TEST(iTape->Type(f) == JsonTape::ValType::Number);
+    TEST(iTape->Value(f) == Brn("1.5e3"));
+    const TUint t = iTape->Find(0, Brn("t"));
+    TEST(iTape->Type(t) == JsonTape::ValType::Bool);
+    TEST(iTape->Value(t) == Brn("true"));
+    TEST(iTape->Value(iTape->Find(0, Brn("b"))) == Brn("false"));
+    TEST(iTape->Type(iTape->Find(0, Brn("n"))) == JsonTape::ValType::Null);
+    TEST(iTape->Find(0, Brn("x")) == JsonTape::kEnd);
+    TEST(iTape->FirstChild(s) == JsonTape::kEnd);
+}
+
+void SuiteJsonTape::TestNestedObjects()
+{
+    const Brn json("{\"key1\":{\"key2\":{\"key3\": 3, \"key4\":4}, \"key5\":\"val5\"}, \"key6\":6}");
+    iTape->Parse(json);
+    const TUint key1 = iTape->Find(0, Brn("key1"));
+    TEST(iTape->Value(key1) == Brn("{\"key2\":{\"key3\": 3, \"key4\":4}, \"key5\":\"val5\"}"));
+    const TUint key2 = iTape->Find(key1, Brn("key2"));
+    TEST(iTape->Value(key2) == Brn("{\"key3\": 3, \"key4\":4}"));
+    TEST(iTape->Value(iTape->Find(key2, Brn("key4"))) == Brn("4"));
+    TEST(iTape->Value(iTape->Find(key1, Brn("key5"))) == Brn("val5"));
+
+    // keys are only matched against direct children
+    TEST(iTape->Find(0, Brn("key3")) == JsonTape::kEnd);
+    TEST(iTape->Find(key1, Brn("key6")) == JsonTape::kEnd);
+
+    // siblings step over nested content
+    TEST(iTape->FirstChild(0) == key1);
+    const TUint key6 = iTape->NextSibling(key1);
+    TEST(iTape->Key(key6) == Brn("key6"));
+    TEST(iTape->NextSibling(key6) == JsonTape::kEnd);
+}
+
+void SuiteJsonTape::TestArrayMembers()
+{
+    iTape->Parse(Brn("{\"arr\":[ \"a\", 2, {\"k\":[true]}, [], null ]}"));
+    const TUint arr = iTape->Find(0, Brn("arr"));
+    TEST(iTape->Type(arr) == JsonTape::ValType::Array);
+    TEST(iTape->Value(arr) == Brn("[ \"a\", 2, {\"k\":[true]}, [], null ]"));
+    TUint i = iTape->FirstChild(arr);
+    TEST(iTape->Key(i).Bytes() == 0);
+    TEST(iTape->Value(i) == Brn("a"));
+    i = iTape->NextSibling(i);
+    TEST(iTape->Value(i) == Brn("2"));
+    i = iTape->NextSibling(i);
+    TEST(iTape->Type(i) == JsonTape::ValType::Object);
+    TEST(iTape->Value(iTape->FirstChild(iTape->Find(i, Brn("k")))) == Brn("true"));
+    i = iTape->NextSibling(i);
+    TEST(iTape->Type(i) == JsonTape::ValType::Array);
+    TEST(iTape->FirstChild(i) == JsonTape::kEnd);
+    i = iTape->NextSibling(i);
+    TEST(iTape->Type(i) == JsonTape::ValType::Null);
+    TEST(iTape->NextSibling(i) == JsonTape::kEnd);
+
+    // arrays are valid roots for the tape (but not for JsonParser)
+    iTape->Parse(Brn("[1,2]"));
+    TEST(iTape->Type(0) == JsonTape::ValType::Array);
+    TEST(iTape->Count() == 3);
+}
+
+void SuiteJsonTape::TestEmptyContainers()
+{
+    iTape->Parse(Brn("{}"));
+    TEST(iTape->Count() == 1);
+    TEST(iTape->FirstChild(0) == JsonTape::kEnd);
+    TEST(iTape->Value(0) == Brn("{}"));
+
+    iTape->Parse(Brn("{\"a\":{ },\"b\":[\n]}"));
+    const TUint a = iTape->Find(0, Brn("a"));
+    TEST(iTape->Value(a) == Brn("{ }"));
+    TEST(iTape->FirstChild(a) == JsonTape::kEnd);
+    const TUint b = iTape->Find(0, Brn("b"));
+    TEST(iTape->Value(b) == Brn("[\n]"));
+    TEST(iTape->FirstChild(b) == JsonTape::kEnd);
+}
+
+void SuiteJsonTape::TestStructuralCharsInStrings()
+{
+    iTape->Parse(Brn("{\"obj\":{\"s\":\"}{][,:\\\"\"}, \"k\\\"ey\":\"v\"}"));
+    const TUint obj = iTape->Find(0, Brn("obj"));
+    TEST(iTape->Value(iTape->Find(obj, Brn("s"))) == Brn("}{][,:\\\""));
+    TEST(iTape->Value(iTape->Find(0, Brn("k\\\"ey"))) == Brn("v"));
+}
+
+void SuiteJsonTape::TestLongStrings()
+{
+    // quotes and escapes at every offset within (and either side of) a 16 byte block
+    for (TUint len=0; len<40; len++) {
+        Bws<128> json("{\"a\":\"");
+        for (TUint i=0; i<len; i++) {
+            json.Append((TChar)('a' + (i % 26)));
+        }
+        json.Append("\\\\\\\"x\", \"b\":1}");
+        iTape->Parse(json);
+        const Brn val = iTape->Value(iTape->Find(0, Brn("a")));
+        TEST(val.Bytes() == len + 5);
+        TEST(val.Split(len) == Brn("\\\\\\\"x"));
+        TEST(iTape->Value(iTape->Find(0, Brn("b"))) == Brn("1"));
+    }
+}
+
+void SuiteJsonTape::TestUnescapeInPlace()
+{
+    Bwh json("{\"k\\\"ey\":\"line1\\nline2\",\"obj\":{\"q\":\"\\\"\",\"r\":\"\\\\n\"},\"arr\":[\"a\\tb\"]}");
+    iTape->ParseAndUnescape(json);
+    TUint i = iTape->FirstChild(0);
+    TEST(iTape->Key(i) == Brn("k\\\"ey")); // keys aren't unescaped
+    TEST(iTape->Value(i) == Brn("line1\nline2"));
+
+    // nested values are left escaped so that containers can be parsed again
+    i = iTape->Find(0, Brn("obj"));
+    const Brn obj(iTape->Value(i));
+    TEST(obj == Brn("{\"q\":\"\\\"\",\"r\":\"\\\\n\"}"));
+    TEST(iTape->Value(iTape->Find(i, Brn("q"))) == Brn("\\\""));
+    i = iTape->Find(0, Brn("arr"));
+    TEST(iTape->Value(i) == Brn("[\"a\\tb\"]"));
+    TEST(iTape->Value(iTape->FirstChild(i)) == Brn("a\\tb"));
+
+    // ...and are unescaped exactly once when their container is
+    Bwh nested(obj);
+    JsonTape tape;
+    tape.ParseAndUnescape(nested);
+    TEST(tape.Value(tape.Find(0, Brn("q"))) == Brn("\""));
+    TEST(tape.Value(tape.Find(0, Brn("r"))) == Brn("\\n"));
+}
+
+void SuiteJsonTape::TestTrailingContentIgnored()
+{
+    iTape->Parse(Brn("  {\"a\":1}\r\n{garbage"));
+    TEST(iTape->Count() == 2);
+    TEST(iTape->Value(0) == Brn("{\"a\":1}"));
+}
+
+void SuiteJsonTape::TestCorruptInput()
+{
+    TEST_THROWS(iTape->Parse(Brn("")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":\"unterminated}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":\"\\")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":1,}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":[1 2]}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":[1,]}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":{]}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":tru}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":truex}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\":nil}")), JsonCorrupt);
+    TEST_THROWS(iTape->Parse(Brn("{\"a\"}")), JsonCorrupt);
+}
+
+void SuiteJsonTape::TestDepthLimit()
+{
+    Bws<2 * (JsonTape::kMaxDepth + 1)> json;
+    for (TUint i=0; i<JsonTape::kMaxDepth; i++) {
+        json.Append('[');
+    }
+    for (TUint i=0; i<JsonTape::kMaxDepth; i++) {
+        json.Append(']');
+    }
+    iTape->Parse(json);
+    TEST(iTape->Count() == JsonTape::kMaxDepth);
+
+    json.Replace(Brx::Empty());
+    for (TUint i=0; i<=JsonTape::kMaxDepth; i++) {
+        json.Append('[');
+    }
+    for (TUint i=0; i<=JsonTape::kMaxDepth; i++) {
+        json.Append(']');
+    }
+    TEST_THROWS(iTape->Parse(json), JsonUnsupported);
+}
+
+void SuiteJsonTape::TestReuse()
+{
+    iTape->Parse(Brn("{\"a\":1,\"b\":2,\"c\":3}"));
+    TEST(iTape->Count() == 4);
+    iTape->Parse(Brn("{\"d\":4}"));
+    TEST(iTape->Count() == 2);
+    TEST(iTape->Find(0, Brn("a")) == JsonTape::kEnd);
+    TEST(iTape->Value(iTape->Find(0, Brn("d"))) == Brn("4"));
+    TEST_THROWS(iTape->Parse(Brn("{\"e\":")), JsonCorrupt);
+    iTape->Reset();
+    TEST(iTape->Count() == 0);
+}
+
+
 // SuiteWriterJson
 
 SuiteWriterJson::SuiteWriterJson()
@@ -1170,6 +1413,7 @@ void TestJson()
     runner.Add(new SuiteJsonEncode());
     runner.Add(new SuiteJsonDecode());
     runner.Add(new SuiteJsonParser());
+    runner.Add(new SuiteJsonTape());
     runner.Add(new SuiteWriterJson());
     runner.Add(new SuiteWriterJsonObject());
     runner.Add(new SuiteWriterJsonArray());
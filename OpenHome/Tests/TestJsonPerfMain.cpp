@@ -0,0 +1,236 @@
+#include <OpenHome/Private/TestFramework.h>
+#include <OpenHome/Private/OptionParser.h>
+#include <OpenHome/Json.h>
+#include <OpenHome/Buffer.h>
+#include <OpenHome/OsWrapper.h>
+#include <OpenHome/Private/Env.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Printer.h>
+
+#include <vector>
+
+using namespace OpenHome;
+using namespace OpenHome::TestFramework;
+
+/*
+    Times parsing of representative service responses and ODP messages.
+    Each document is read twice: via JsonParser/JsonParserArray, re-parsing each nested
+    value as existing callers do, and via a single JsonTape that is walked in place.
+*/
+
+namespace OpenHome {
+namespace TestJsonPerf {
+
+class Bench : private INonCopyable
+{
+public:
+    Bench(Environment& aEnv, TUint aIterations);
+    void Run();
+private:
+    typedef void (Bench::*Reader)(const Brx& aJson);
+    void Time(const TChar* aName, const Brx& aJson, Reader aFacade, Reader aTape);
+    void FacadeFlat(const Brx& aJson);
+    void TapeFlat(const Brx& aJson);
+    void FacadeTrack(const Brx& aJson);
+    void TapeTrack(const Brx& aJson);
+    void FacadeList(const Brx& aJson);
+    void TapeList(const Brx& aJson);
+    static void CreateTrackList(Bwx& aBuf, TUint aCount);
+private:
+    Environment& iEnv;
+    const TUint iIterations;
+    JsonParser iParser;
+    JsonParser iParserItem;
+    JsonParser iParserTrack;
+    JsonParser iParserNested;
+    JsonTape iTape;
+    TUint iChecksum; // stops the compiler discarding reads
+};
+
+} // namespace TestJsonPerf
+} // namespace OpenHome
+
+using namespace OpenHome::TestJsonPerf;
+
+// Tidal /tracks/{id}/streamurl
+static const Brn kTidalStreamUrl(
+    "{\"url\":\"https://sp-pr-cf.audio.tidal.com/mediatracks/CAEaKwgDEidmYjA3ZDYyYzRjZmNkNDE2MTg0NDc2ODE5ZTMxMGYxYl82MS5tcDQ/0.flac?Expires=1571753623&Signature=kTWvJ2jsQ9LZ1bEKSbpXq~3gYiC7zEJ0y6QhAJnR8hH0xWq2Ug2pmx5EFtTz6uEA9M-x0kc5pZd5mCxU8n2vm8XGnS6CN&Key-Pair-Id=APKAIIBDEVB3AZ2D4AAQ\","
+    "\"trackId\":77640914,\"playTimeLeftInMinutes\":-1,\"soundQuality\":\"LOSSLESS\",\"encryptionKey\":\"\",\"codec\":\"FLAC\"}");
+
+// Qobuz track/getFileUrl
+static const Brn kQobuzFileUrl(
+    "{\"track_id\":47394127,\"duration\":226,\"url\":\"https:\\/\\/streaming-qobuz-std.akamaized.net\\/file?uid=2391734&eid=47394127&fmt=6&profile=raw&app_id=285473059&cid=1382347&etsp=1571757268&hmac=0Y2vPcD7Q1bE5ZTu8o1aD4nZQ2M\","
+    "\"format_id\":6,\"mime_type\":\"audio\\/flac\",\"sampling_rate\":44.1,\"bit_depth\":16,\"restrictions\":[{\"code\":\"FormatRestrictedByFormatAvailability\"}]}");
+
+// Tidal /tracks/{id}
+static const Brn kTidalTrack(
+    "{\"id\":77640914,\"title\":\"Paranoid Android\",\"duration\":387,\"replayGain\":-9.34,\"peak\":0.988312,"
+    "\"allowStreaming\":true,\"streamReady\":true,\"streamStartDate\":\"2017-06-22T00:00:00.000+0000\","
+    "\"premiumStreamingOnly\":false,\"trackNumber\":2,\"volumeNumber\":1,\"version\":null,\"popularity\":61,"
+    "\"copyright\":\"(P) 2017 XL Recordings Ltd\",\"url\":\"http://www.tidal.com/track/77640914\",\"isrc\":\"GBBKS1700108\","
+    "\"editable\":false,\"explicit\":false,\"audioQuality\":\"LOSSLESS\",\"audioModes\":[\"STEREO\"],"
+    "\"artist\":{\"id\":64518,\"name\":\"Radiohead\",\"type\":\"MAIN\"},"
+    "\"artists\":[{\"id\":64518,\"name\":\"Radiohead\",\"type\":\"MAIN\"}],"
+    "\"album\":{\"id\":77640912,\"title\":\"OK Computer OKNOTOK 1997 2017\",\"cover\":\"7b4a5a6c-b8b3-4ec5-bf1d-eeb7d4e9e32f\"},"
+    "\"mixes\":{\"MASTER_TRACK_MIX\":\"0142e8b2ea6ec6b3d6a5f1ae4c6e7d\",\"TRACK_MIX\":\"00156e1c57c2a5be7bd5d0b2d1c3a1\"}}");
+
+// ODP action request (as sent by a control point)
+static const Brn kOdpAction(
+    "{\"type\":\"action\",\"device\":\"4c494e4e-0026-0f21-cc1b-01373197013f\",\"service\":{\"name\":\"Playlist\",\"version\":1},"
+    "\"action\":\"ReadList\",\"arguments\":[{\"name\":\"IdList\",\"value\":\"12 13 14 15 16 17 18 19 20 21 22 23 24 25\"}]}");
+
+
+// Bench
+
+Bench::Bench(Environment& aEnv, TUint aIterations)
+    : iEnv(aEnv)
+    , iIterations(aIterations)
+    , iChecksum(0)
+{
+}
+
+void Bench::Run()
+{
+    Log::Print("JSON parse benchmark (%u iterations per document)\n", iIterations);
+    Log::Print("%-24s %8s %12s %12s\n", "document", "bytes", "facade(ns)", "tape(ns)");
+    Time("tidal streamurl", kTidalStreamUrl, &Bench::FacadeFlat, &Bench::TapeFlat);
+    Time("qobuz getFileUrl", kQobuzFileUrl, &Bench::FacadeFlat, &Bench::TapeFlat);
+    Time("odp action", kOdpAction, &Bench::FacadeFlat, &Bench::TapeFlat);
+    Time("tidal track", kTidalTrack, &Bench::FacadeTrack, &Bench::TapeTrack);
+    Bwh list(256 * 1024);
+    CreateTrackList(list, 10);
+    Time("tidal playlist (10)", list, &Bench::FacadeList, &Bench::TapeList);
+    CreateTrackList(list, 100);
+    Time("tidal playlist (100)", list, &Bench::FacadeList, &Bench::TapeList);
+    Log::Print("(checksum %u)\n", iChecksum);
+}
+
+void Bench::Time(const TChar* aName, const Brx& aJson, Reader aFacade, Reader aTape)
+{
+    // warm up, also sizing the tapes so that timed runs don't allocate
+    (this->*aFacade)(aJson);
+    (this->*aTape)(aJson);
+
+    TUint64 start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iIterations; i++) {
+        (this->*aFacade)(aJson);
+    }
+    const TUint64 facadeUs = OsTimeInUs(iEnv.OsCtx()) - start;
+    start = OsTimeInUs(iEnv.OsCtx());
+    for (TUint i=0; i<iIterations; i++) {
+        (this->*aTape)(aJson);
+    }
+    const TUint64 tapeUs = OsTimeInUs(iEnv.OsCtx()) - start;
+    Log::Print("%-24s %8u %12u %12u\n", aName, aJson.Bytes(),
+               (TUint)((facadeUs * 1000) / iIterations), (TUint)((tapeUs * 1000) / iIterations));
+}
+
+void Bench::FacadeFlat(const Brx& aJson)
+{
+    iParser.Parse(aJson);
+    iChecksum += iParser.String("url").Bytes();
+}
+
+void Bench::TapeFlat(const Brx& aJson)
+{
+    iTape.Parse(aJson);
+    const TUint url = iTape.Find(0, Brn("url"));
+    if (url != JsonTape::kEnd) {
+        iChecksum += iTape.Value(url).Bytes();
+    }
+}
+
+void Bench::FacadeTrack(const Brx& aJson)
+{
+    iParserTrack.Parse(aJson);
+    iChecksum += iParserTrack.String("title").Bytes();
+    iChecksum += iParserTrack.Num("duration");
+    iParserNested.Parse(iParserTrack.String("artist"));
+    iChecksum += iParserNested.String("name").Bytes();
+    iParserNested.Parse(iParserTrack.String("album"));
+    iChecksum += iParserNested.String("title").Bytes();
+    iChecksum += iParserNested.String("cover").Bytes();
+}
+
+void Bench::TapeTrack(const Brx& aJson)
+{
+    iTape.Parse(aJson);
+    iChecksum += iTape.Value(iTape.Find(0, Brn("title"))).Bytes();
+    iChecksum += iTape.Value(iTape.Find(0, Brn("duration"))).Bytes();
+    const TUint artist = iTape.Find(0, Brn("artist"));
+    iChecksum += iTape.Value(iTape.Find(artist, Brn("name"))).Bytes();
+    const TUint album = iTape.Find(0, Brn("album"));
+    iChecksum += iTape.Value(iTape.Find(album, Brn("title"))).Bytes();
+    iChecksum += iTape.Value(iTape.Find(album, Brn("cover"))).Bytes();
+}
+
+void Bench::FacadeList(const Brx& aJson)
+{
+    iParser.Parse(aJson);
+    iChecksum += iParser.Num("totalNumberOfItems");
+    auto items = JsonParserArray::Create(iParser.String("items"));
+    try {
+        for (;;) {
+            iParserItem.Parse(items.NextObject());
+            FacadeTrack(iParserItem.String("item"));
+        }
+    }
+    catch (JsonArrayEnumerationComplete&) {
+    }
+}
+
+void Bench::TapeList(const Brx& aJson)
+{
+    iTape.Parse(aJson);
+    iChecksum += iTape.Value(iTape.Find(0, Brn("totalNumberOfItems"))).Bytes();
+    const TUint items = iTape.Find(0, Brn("items"));
+    for (TUint i=iTape.FirstChild(items); i!=JsonTape::kEnd; i=iTape.NextSibling(i)) {
+        const TUint track = iTape.Find(i, Brn("item"));
+        iChecksum += iTape.Value(iTape.Find(track, Brn("title"))).Bytes();
+        iChecksum += iTape.Value(iTape.Find(track, Brn("duration"))).Bytes();
+        const TUint artist = iTape.Find(track, Brn("artist"));
+        iChecksum += iTape.Value(iTape.Find(artist, Brn("name"))).Bytes();
+        const TUint album = iTape.Find(track, Brn("album"));
+        iChecksum += iTape.Value(iTape.Find(album, Brn("title"))).Bytes();
+        iChecksum += iTape.Value(iTape.Find(album, Brn("cover"))).Bytes();
+    }
+}
+
+void Bench::CreateTrackList(Bwx& aBuf, TUint aCount)
+{ // Tidal /playlists/{uuid}/items
+    aBuf.Replace(Brx::Empty());
+    WriterBuffer writer(aBuf);
+    WriterJsonObject obj(writer);
+    obj.WriteInt("limit", aCount);
+    obj.WriteInt("offset", 0);
+    obj.WriteInt("totalNumberOfItems", aCount);
+    auto items = obj.CreateArray("items");
+    for (TUint i=0; i<aCount; i++) {
+        auto item = items.CreateObject();
+        item.WriteRaw("item", kTidalTrack);
+        item.WriteString("type", "track");
+        item.WriteEnd();
+    }
+    items.WriteEnd();
+    obj.WriteEnd();
+}
+
+
+
+void OpenHome::TestFramework::Runner::Main(TInt aArgc, TChar* aArgv[], Net::InitialisationParams* aInitParams)
+{
+    std::vector<Brn> args = OptionParser::ConvertArgs(aArgc, aArgv);
+    OptionParser parser;
+    OptionUint optionIterations("-i", "--iterations", 10000, "number of times each document is parsed");
+    parser.AddOption(&optionIterations);
+    if (!parser.Parse(args) || parser.HelpDisplayed()) {
+        delete aInitParams;
+        return;
+    }
+
+    Net::Library* lib = new Net::Library(aInitParams);
+    Bench* bench = new Bench(lib->Env(), optionIterations.Value());
+    bench->Run();
+    delete bench;
+    delete lib;
+}
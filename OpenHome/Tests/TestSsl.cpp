@@ -28,6 +28,7 @@ private:
 private:
     static const TUint kWriteBufBytes = 2 * 1024;
     static const TUint kReadBufBytes = 4 * 1024;
+    Environment& iEnv;
     SocketSsl* iSocket;
     Srx* iReadBuffer;
     ReaderUntil* iReaderUntil;
@@ -53,6 +54,7 @@ using namespace OpenHome::TestFramework;
 
 SuiteSsl::SuiteSsl(Environment& aEnv)
     : Suite("HTTPS tests")
+    , iEnv(aEnv)
 {
     iSocket = new SocketSsl(aEnv, kReadBufBytes);
     iReadBuffer = new Srs<1024>(*iSocket);
@@ -76,6 +78,14 @@ void SuiteSsl::Test()
 {
     Head("www.ssllabs.com", "/ssltest/viewMyClient.html");
     Head("github.com", "/openhome/ohNetGenerated");
+
+    // a second connection to the same host should resume the cached session
+    const SslHandshakeStats before = SocketSsl::HandshakeStats(iEnv);
+    Head("github.com", "/openhome/ohNetGenerated");
+    const SslHandshakeStats after = SocketSsl::HandshakeStats(iEnv);
+    TEST(after.iResumedCount == before.iResumedCount + 1);
+    Print("Handshakes: %u full (%llu us), %u resumed (%llu us)\n",
+          after.iFullCount, after.iFullUs, after.iResumedCount, after.iResumedUs);
 }
 
 void SuiteSsl::Head(const TChar* aHost, const TChar* aPath)
@@ -85,7 +95,7 @@ void SuiteSsl::Head(const TChar* aHost, const TChar* aPath)
     static const TUint kTimeoutMs = 5 * 1000;
     static const TUint kPort = 443;
     Endpoint ep(kPort, host);
-    iSocket->Connect(ep, kTimeoutMs);
+    iSocket->Connect(ep, host, kTimeoutMs);
     iWriterRequest->WriteMethod(Http::kMethodHead, path, Http::eHttp11);
     Http::WriteHeaderHostAndPort(*iWriterRequest, host, kPort);
     Http::WriteHeaderConnectionClose(*iWriterRequest);
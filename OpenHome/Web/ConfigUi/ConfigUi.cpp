@@ -1485,6 +1485,7 @@ ConfigAppBase::ConfigAppBase(IInfoAggregator& aInfoAggregator, IConfigManager& a
     iMsgAllocator = new ConfigMessageAllocator(aInfoAggregator, aSendQueueSize, *this);
 
     iResourceManager = new BlockingResourceManager(aResourceHandlerFactory, aResourceHandlersCount, aResourceDir);
+    iResourceCache = new CachingResourceManager(*iResourceManager, aInfoAggregator, kMaxResourceCacheBytes, aResourceHandlersCount);
 
     for (TUint i=0; i<aMaxTabs; i++) {
         iTabs.push_back(new ConfigTab(i, *iMsgAllocator, iConfigManager, aRebootHandler));
@@ -1504,6 +1505,7 @@ ConfigAppBase::~ConfigAppBase()
         delete iTabs[i];
     }
 
+    delete iResourceCache;
     delete iResourceManager;
 
     for (auto val : iUiVals) {
@@ -1551,7 +1553,7 @@ IResourceHandler* ConfigAppBase::CreateResourceHandler(const Brx& aResource)
     }
 
     // Blocks until an IResourceHandler is available.
-    return iResourceManager->CreateResourceHandler(resource);
+    return iResourceCache->CreateResourceHandler(resource);
 }
 
 ILanguageResourceReader& ConfigAppBase::CreateLanguageResourceHandler(const Brx& aResourceUriTail, std::vector<Bws<10>>& aLanguageList)
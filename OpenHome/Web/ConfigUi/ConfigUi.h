@@ -620,6 +620,7 @@ class ConfigAppBase : public IConfigApp, public ILanguageResourceManager
 {
 private:
     static const TUint kMaxResourcePrefixBytes = 25;
+    static const TUint kMaxResourceCacheBytes = 1024 * 1024;
     static const Brn kLangRoot;
     static const Brn kDefaultLanguage;
     typedef std::pair<Brn, Brn> ResourcePair;
@@ -658,6 +659,7 @@ private:
     Bwh iLangResourceDir;
     const Bws<kMaxResourcePrefixBytes> iResourcePrefix;
     BlockingResourceManager* iResourceManager;
+    CachingResourceManager* iResourceCache;
     std::vector<ILanguageResourceReader*> iLanguageResourceHandlers;
     std::vector<ConfigTab*> iTabs;
     std::vector<IConfigUiVal*> iUiVals;
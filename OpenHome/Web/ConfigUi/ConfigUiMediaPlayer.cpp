@@ -41,6 +41,7 @@ ConfigAppMediaPlayer::ConfigAppMediaPlayer(IInfoAggregator& aInfoAggregator,
     AddConfigNumConditional(VolumeConfig::kKeyStartupValue);
 
     AddConfigChoiceConditional(Brn("Device.AutoPlay"));
+    AddConfigChoiceConditional(Brn("Receiver.AdaptiveLatency"));
     AddConfigChoiceConditional(Brn("Sender.Enabled"));
     AddConfigChoiceConditional(Brn("Sender.Mode"));
     AddConfigChoiceConditional(Brn("Source.NetAux.Auto"));
@@ -3,11 +3,33 @@
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Debug.h>
 #include <OpenHome/Private/Printer.h>
+#include <OpenHome/Private/Stream.h>
+
+#include <algorithm>
 
 using namespace OpenHome;
 using namespace OpenHome::Web;
 
 
+// ContentEncoding
+
+const Brn ContentEncoding::kTokenGzip("gzip");
+const Brn ContentEncoding::kTokenBrotli("br");
+
+
+// IResourceHandler
+
+const Brx& IResourceHandler::SelectEncoding(TUint /*aAcceptedEncodings*/)
+{
+    return Brx::Empty();
+}
+
+const Brx& IResourceHandler::ETag()
+{
+    return Brx::Empty();
+}
+
+
 // ResourceHandlerBase
 
 ResourceHandlerBase::ResourceHandlerBase(const Brx& aRootDir, IResourceHandlerDeallocator& aDeallocator)
@@ -59,3 +81,313 @@ void BlockingResourceManager::Deallocate(ResourceHandlerBase* aResourceHandler)
 {
     iFifo.Write(aResourceHandler);
 }
+
+
+// CachingResourceManager::Variant
+
+CachingResourceManager::Variant::Variant()
+{
+}
+
+TBool CachingResourceManager::Variant::Available() const
+{
+    return iData.Bytes() > 0;
+}
+
+
+// CachingResourceManager::Entry
+
+CachingResourceManager::Entry::Entry(const Brx& aResourceTail)
+    : iResourceTail(aResourceTail)
+{
+}
+
+TUint CachingResourceManager::Entry::Bytes() const
+{
+    TUint bytes = 0;
+    for (TUint i=0; i<eVariantCount; i++) {
+        bytes += iVariants[i].iData.Bytes();
+    }
+    return bytes;
+}
+
+
+// CachingResourceManager::Handler
+
+CachingResourceManager::Handler::Handler(CachingResourceManager& aManager)
+    : iManager(aManager)
+    , iEntry(nullptr)
+    , iVariant(nullptr)
+{
+}
+
+void CachingResourceManager::Handler::Set(const Entry& aEntry)
+{
+    ASSERT(iEntry == nullptr);
+    iEntry = &aEntry;
+    iVariant = &aEntry.iVariants[eIdentity];
+}
+
+TUint CachingResourceManager::Handler::Bytes()
+{
+    ASSERT(iVariant != nullptr);
+    return iVariant->iData.Bytes();
+}
+
+void CachingResourceManager::Handler::Write(IWriter& aWriter)
+{
+    ASSERT(iVariant != nullptr);
+    // single write; large enough that any buffering writer passes it straight through
+    aWriter.Write(iVariant->iData);
+}
+
+void CachingResourceManager::Handler::Destroy()
+{
+    iEntry = nullptr;
+    iVariant = nullptr;
+    iManager.Deallocate(this);
+}
+
+const Brx& CachingResourceManager::Handler::SelectEncoding(TUint aAcceptedEncodings)
+{
+    ASSERT(iEntry != nullptr);
+    if ((aAcceptedEncodings & ContentEncoding::kBrotli) && iEntry->iVariants[eBrotli].Available()) {
+        iVariant = &iEntry->iVariants[eBrotli];
+        return ContentEncoding::kTokenBrotli;
+    }
+    if ((aAcceptedEncodings & ContentEncoding::kGzip) && iEntry->iVariants[eGzip].Available()) {
+        iVariant = &iEntry->iVariants[eGzip];
+        return ContentEncoding::kTokenGzip;
+    }
+    iVariant = &iEntry->iVariants[eIdentity];
+    return Brx::Empty();
+}
+
+const Brx& CachingResourceManager::Handler::ETag()
+{
+    ASSERT(iVariant != nullptr);
+    return iVariant->iETag;
+}
+
+
+// CachingResourceManager
+
+const Brn CachingResourceManager::kQueryMemory("memory");
+const Brn CachingResourceManager::kExtGzip(".gz");
+const Brn CachingResourceManager::kExtBrotli(".br");
+
+CachingResourceManager::CachingResourceManager(IResourceManager& aLoader, IInfoAggregator& aInfoAggregator, TUint aMaxBytes, TUint aHandlerCount)
+    : iLoader(aLoader)
+    , iMaxBytes(aMaxBytes)
+    , iLock("CRM1")
+    , iLockLoad("CRM2")
+    , iFree(aHandlerCount)
+    , iBytes(0)
+    , iHits(0)
+    , iMisses(0)
+{
+    ASSERT(aHandlerCount > 0);
+    for (TUint i=0; i<aHandlerCount; i++) {
+        auto handler = new Handler(*this);
+        iHandlers.push_back(handler);
+        iFree.Write(handler);
+    }
+    std::vector<Brn> infoQueries;
+    infoQueries.push_back(kQueryMemory);
+    aInfoAggregator.Register(*this, infoQueries);
+}
+
+CachingResourceManager::~CachingResourceManager()
+{
+    ASSERT(iFree.SlotsFree() == 0); // All resource handlers must have been returned.
+    for (auto handler : iHandlers) {
+        delete handler;
+    }
+    for (auto kvp : iEntries) {
+        delete kvp.second;
+    }
+}
+
+void CachingResourceManager::Preload(const Brx& aResourceTail)
+{
+    CreateResourceHandler(aResourceTail)->Destroy();
+}
+
+TUint CachingResourceManager::CachedBytes() const
+{
+    AutoMutex _(iLock);
+    return iBytes;
+}
+
+TUint CachingResourceManager::Hits() const
+{
+    AutoMutex _(iLock);
+    return iHits;
+}
+
+TUint CachingResourceManager::Misses() const
+{
+    AutoMutex _(iLock);
+    return iMisses;
+}
+
+IResourceHandler* CachingResourceManager::CreateResourceHandler(const Brx& aResourceTail)
+{
+    const Entry* entry = Find(aResourceTail);
+    if (entry != nullptr) {
+        AutoMutex _(iLock);
+        iHits++;
+    }
+    else {
+        AutoMutex _(iLockLoad);
+        entry = Find(aResourceTail); // may have been loaded by another session while we waited
+        {
+            AutoMutex __(iLock);
+            if (entry != nullptr) {
+                iHits++;
+            }
+            else {
+                iMisses++;
+            }
+        }
+        if (entry == nullptr) {
+            IResourceHandler* uncached = nullptr;
+            entry = LoadLocked(aResourceTail, uncached); // throws ResourceInvalid
+            if (entry == nullptr) {
+                return uncached;
+            }
+        }
+    }
+    auto handler = iFree.Read();
+    handler->Set(*entry);
+    return handler;
+}
+
+void CachingResourceManager::QueryInfo(const Brx& aQuery, IWriter& aWriter)
+{
+    AutoMutex _(iLock);
+    if (aQuery == kQueryMemory) {
+        WriterAscii writer(aWriter);
+        writer.Write(Brn("ResourceCache: "));
+        writer.WriteUint((TUint)iEntries.size());
+        writer.Write(Brn(" resources, "));
+        writer.WriteUint(iBytes);
+        writer.Write(Brn(" of "));
+        writer.WriteUint(iMaxBytes);
+        writer.Write(Brn(" bytes, hits:"));
+        writer.WriteUint(iHits);
+        writer.Write(Brn(", misses:"));
+        writer.WriteUint(iMisses);
+        aWriter.Write(Brn("\n"));
+    }
+}
+
+const CachingResourceManager::Entry* CachingResourceManager::Find(const Brx& aResourceTail) const
+{
+    AutoMutex _(iLock);
+    Brn tail(aResourceTail);
+    auto it = iEntries.find(tail);
+    if (it == iEntries.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+const CachingResourceManager::Entry* CachingResourceManager::LoadLocked(const Brx& aResourceTail, IResourceHandler*& aHandler)
+{
+    // iBytes is only modified by this thread while iLockLoad is held so is safe to read here
+    const TUint available = iMaxBytes - iBytes;
+    IResourceHandler* handler = iLoader.CreateResourceHandler(aResourceTail); // throws ResourceInvalid
+    const TUint bytes = handler->Bytes();
+    if (bytes == 0 || bytes > available) {
+        LOG(kHttp, "CachingResourceManager - not caching %.*s (%u bytes)\n", PBUF(aResourceTail), bytes);
+        aHandler = handler;
+        return nullptr;
+    }
+
+    Entry* entry = new Entry(aResourceTail);
+    try {
+        Read(*handler, bytes, entry->iVariants[eIdentity]);
+    }
+    catch (WriterError&) {
+        handler->Destroy();
+        delete entry;
+        THROW(ResourceInvalid);
+    }
+    handler->Destroy();
+
+    // Only keep compressed variants that are smaller than the original
+    TryLoadVariant(aResourceTail, kExtBrotli, entry->iVariants[eBrotli], std::min(bytes - 1, available - entry->Bytes()));
+    TryLoadVariant(aResourceTail, kExtGzip, entry->iVariants[eGzip], std::min(bytes - 1, available - entry->Bytes()));
+
+    // FNV-1a over the original content; compressed variants are distinct representations so get distinct tags
+    TUint64 hash = 14695981039346656037ULL;
+    const Brx& data = entry->iVariants[eIdentity].iData;
+    for (TUint i=0; i<data.Bytes(); i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    SetETag(entry->iVariants[eIdentity], hash, "");
+    SetETag(entry->iVariants[eGzip], hash, "-gz");
+    SetETag(entry->iVariants[eBrotli], hash, "-br");
+
+    AutoMutex _(iLock);
+    iEntries.insert(std::pair<Brn, Entry*>(Brn(entry->iResourceTail), entry));
+    iBytes += entry->Bytes();
+    LOG(kHttp, "CachingResourceManager - cached %.*s (%u bytes, gz:%u, br:%u)\n", PBUF(aResourceTail), bytes,
+        entry->iVariants[eGzip].iData.Bytes(), entry->iVariants[eBrotli].iData.Bytes());
+    return entry;
+}
+
+void CachingResourceManager::TryLoadVariant(const Brx& aResourceTail, const Brx& aExtension, Variant& aVariant, TUint aMaxBytes)
+{
+    Bwh tail(aResourceTail.Bytes() + aExtension.Bytes());
+    tail.Replace(aResourceTail);
+    tail.Append(aExtension);
+    IResourceHandler* handler = nullptr;
+    try {
+        handler = iLoader.CreateResourceHandler(tail);
+    }
+    catch (ResourceInvalid&) {
+        return; // no precompressed variant; not an error
+    }
+    const TUint bytes = handler->Bytes();
+    try {
+        if (bytes > 0 && bytes <= aMaxBytes) {
+            Read(*handler, bytes, aVariant);
+        }
+    }
+    catch (WriterError&) {
+        aVariant.iData.SetBytes(0);
+    }
+    handler->Destroy();
+}
+
+void CachingResourceManager::Read(IResourceHandler& aHandler, TUint aBytes, Variant& aVariant)
+{
+    WriterBwh writer(aBytes);
+    aHandler.Write(writer);
+    const Brx& buf = writer.Buffer();
+    aVariant.iData.Grow(buf.Bytes());
+    aVariant.iData.Replace(buf);
+}
+
+void CachingResourceManager::SetETag(Variant& aVariant, TUint64 aHash, const TChar* aSuffix)
+{
+    static const TChar kHexDigits[] = "0123456789abcdef";
+    aVariant.iETag.SetBytes(0);
+    if (!aVariant.Available()) {
+        return;
+    }
+    aVariant.iETag.Append('\"');
+    for (TInt shift=60; shift>=0; shift-=4) {
+        aVariant.iETag.Append(kHexDigits[(aHash >> shift) & 0xf]);
+    }
+    aVariant.iETag.Append(aSuffix);
+    aVariant.iETag.Append('\"');
+}
+
+void CachingResourceManager::Deallocate(Handler* aHandler)
+{
+    iFree.Write(aHandler);
+}
@@ -3,6 +3,12 @@
 #include <OpenHome/Types.h>
 #include <OpenHome/Buffer.h>
 #include <OpenHome/Private/Fifo.h>
+#include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Thread.h>
+#include <OpenHome/Private/InfoProvider.h>
+
+#include <map>
+#include <vector>
 
 EXCEPTION(ResourceInvalid);
 
@@ -11,12 +17,29 @@ namespace OpenHome {
     class IWriter;
 namespace Web {
 
+class ContentEncoding
+{
+public:
+    // Bit flags, as passed to IResourceHandler::SelectEncoding()
+    static const TUint kIdentity = 0;
+    static const TUint kGzip     = 1<<0;
+    static const TUint kBrotli   = 1<<1;
+    // Content-Encoding tokens
+    static const Brn kTokenGzip;
+    static const Brn kTokenBrotli;
+};
+
 class IResourceHandler
 {
 public:
     virtual TUint Bytes() = 0;                  // 0 => unknown size
     virtual void Write(IWriter& aWriter) = 0;   // THROWS WriterError
     virtual void Destroy() = 0;
+    // Selects the representation that Bytes()/Write() will refer to from the
+    // ContentEncoding flags the client accepts.  Returns the Content-Encoding
+    // token for that representation; Brx::Empty() => identity.
+    virtual const Brx& SelectEncoding(TUint aAcceptedEncodings);
+    virtual const Brx& ETag();                  // strong, quoted entity tag for selected representation; Brx::Empty() => none
     virtual ~IResourceHandler() {}
 };
 
@@ -78,5 +101,97 @@ private:
     Fifo<ResourceHandlerBase*> iFifo;
 };
 
+/**
+ * ResourceManager that keeps a copy of each resource in memory once it has
+ * been requested, so that subsequent requests don't touch the filesystem.
+ *
+ * Variants that were compressed at build time are picked up from alongside the
+ * original resource ("<resource>.br" and "<resource>.gz") and served to clients
+ * that accept them.  Each representation carries a strong ETag derived from the
+ * resource's content.
+ *
+ * Resources that would take the cache beyond aMaxBytes (or whose size their
+ * handler can't report) are served directly from aLoader instead.
+ */
+class CachingResourceManager : public IResourceManager, private IInfoProvider
+{
+    static const Brn kQueryMemory;
+    static const Brn kExtGzip;
+    static const Brn kExtBrotli;
+    static const TUint kMaxETagBytes = 24;
+private:
+    enum EVariant
+    {
+        eIdentity,
+        eGzip,
+        eBrotli,
+        eVariantCount
+    };
+    class Variant
+    {
+    public:
+        Variant();
+        TBool Available() const;
+    public:
+        Bwh iData;
+        Bws<kMaxETagBytes> iETag;
+    };
+    class Entry : private INonCopyable
+    {
+    public:
+        Entry(const Brx& aResourceTail);
+        TUint Bytes() const;
+    public:
+        Brh iResourceTail;
+        Variant iVariants[eVariantCount];
+    };
+    class Handler : public IResourceHandler, private INonCopyable
+    {
+    public:
+        Handler(CachingResourceManager& aManager);
+        void Set(const Entry& aEntry);
+    public: // from IResourceHandler
+        TUint Bytes() override;
+        void Write(IWriter& aWriter) override;
+        void Destroy() override;
+        const Brx& SelectEncoding(TUint aAcceptedEncodings) override;
+        const Brx& ETag() override;
+    private:
+        CachingResourceManager& iManager;
+        const Entry* iEntry;
+        const Variant* iVariant;
+    };
+    typedef std::map<Brn, Entry*, BufferCmp> EntryMap;
+public:
+    CachingResourceManager(IResourceManager& aLoader, IInfoAggregator& aInfoAggregator, TUint aMaxBytes, TUint aHandlerCount);
+    ~CachingResourceManager();
+    void Preload(const Brx& aResourceTail); // THROWS ResourceInvalid
+    TUint CachedBytes() const;
+    TUint Hits() const;
+    TUint Misses() const;
+public: // from IResourceManager
+    IResourceHandler* CreateResourceHandler(const Brx& aResourceTail) override;
+private: // from IInfoProvider
+    void QueryInfo(const Brx& aQuery, IWriter& aWriter) override;
+private:
+    const Entry* Find(const Brx& aResourceTail) const;
+    const Entry* LoadLocked(const Brx& aResourceTail, IResourceHandler*& aHandler);
+    void TryLoadVariant(const Brx& aResourceTail, const Brx& aExtension, Variant& aVariant, TUint aMaxBytes);
+    static void Read(IResourceHandler& aHandler, TUint aBytes, Variant& aVariant);
+    static void SetETag(Variant& aVariant, TUint64 aHash, const TChar* aSuffix);
+    void Deallocate(Handler* aHandler);
+private:
+    IResourceManager& iLoader;
+    const TUint iMaxBytes;
+    mutable Mutex iLock;
+    Mutex iLockLoad;
+    EntryMap iEntries;
+    std::vector<Handler*> iHandlers;
+    Fifo<Handler*> iFree;
+    TUint iBytes;
+    TUint iHits;
+    TUint iMisses;
+};
+
 } // namespace Web
 } // namespace OpenHome
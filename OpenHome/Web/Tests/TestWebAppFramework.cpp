@@ -3,8 +3,16 @@
 #include <OpenHome/Private/TestFramework.h>
 #include <OpenHome/Private/SuiteUnitTest.h>
 #include <OpenHome/Private/Standard.h>
+#include <OpenHome/Private/Stream.h>
+#include <OpenHome/Private/Ascii.h>
+#include <OpenHome/Private/InfoProvider.h>
 
 #include <OpenHome/Web/WebAppFramework.h>
+#include <OpenHome/Web/ResourceHandler.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
 
 namespace OpenHome {
 namespace Web {
@@ -396,6 +404,71 @@ private:
     WebAppFramework* iFramework;
 };
 
+class MockResourceInfoAggregator : public IInfoAggregator
+{
+public:
+    MockResourceInfoAggregator();
+    void Query(IWriter& aWriter);
+public: // from IInfoAggregator
+    void Register(IInfoProvider& aProvider, std::vector<Brn>& aSupportedQueries) override;
+private:
+    IInfoProvider* iProvider;
+};
+
+class MockMemoryResourceManager : public IResourceManager, private INonCopyable
+{
+private:
+    class Handler : public IResourceHandler
+    {
+    public:
+        Handler(MockMemoryResourceManager& aManager, const Brx& aData);
+    public: // from IResourceHandler
+        TUint Bytes() override;
+        void Write(IWriter& aWriter) override;
+        void Destroy() override;
+    private:
+        MockMemoryResourceManager& iManager;
+        Brn iData;
+    };
+public:
+    MockMemoryResourceManager();
+    void Add(const TChar* aResourceTail, const TChar* aData);
+    TUint Loads() const;
+    TUint Outstanding() const;
+public: // from IResourceManager
+    IResourceHandler* CreateResourceHandler(const Brx& aResourceTail) override;
+private:
+    std::map<std::string, std::string> iResources;
+    TUint iLoads;
+    TUint iOutstanding;
+};
+
+class SuiteCachingResourceManager : public TestFramework::SuiteUnitTest, private INonCopyable
+{
+    static const TUint kMaxCacheBytes = 64;
+public:
+    SuiteCachingResourceManager();
+private: // from SuiteUnitTest
+    void Setup() override;
+    void TearDown() override;
+private:
+    Brn Get(IResourceHandler& aHandler);
+    void TestLoadedOnce();
+    void TestContentMatches();
+    void TestInvalidResource();
+    void TestETagStable();
+    void TestETagDiffersByContent();
+    void TestCompressedVariantSelected();
+    void TestCompressedVariantNotAccepted();
+    void TestTooLargeNotCached();
+    void TestInfo();
+private:
+    MockResourceInfoAggregator* iInfoAggregator;
+    MockMemoryResourceManager* iLoader;
+    CachingResourceManager* iCache;
+    Bwh iBuf;
+};
+
 } // namespace Test
 } // namespace Web
 } // namespace OpenHome
@@ -2079,12 +2152,251 @@ void SuiteWebAppFramework::TestPostLongPollRequestBeforeStarted()
 
 
 
+// MockResourceInfoAggregator
+
+MockResourceInfoAggregator::MockResourceInfoAggregator()
+    : iProvider(nullptr)
+{
+}
+
+void MockResourceInfoAggregator::Query(IWriter& aWriter)
+{
+    ASSERT(iProvider != nullptr);
+    iProvider->QueryInfo(Brn("memory"), aWriter);
+}
+
+void MockResourceInfoAggregator::Register(IInfoProvider& aProvider, std::vector<Brn>& /*aSupportedQueries*/)
+{
+    iProvider = &aProvider;
+}
+
+
+// MockMemoryResourceManager::Handler
+
+MockMemoryResourceManager::Handler::Handler(MockMemoryResourceManager& aManager, const Brx& aData)
+    : iManager(aManager)
+    , iData(aData)
+{
+}
+
+TUint MockMemoryResourceManager::Handler::Bytes()
+{
+    return iData.Bytes();
+}
+
+void MockMemoryResourceManager::Handler::Write(IWriter& aWriter)
+{
+    // deliberately written in small pieces, as a file-backed handler would
+    Brn remaining(iData);
+    while (remaining.Bytes() > 0) {
+        const TUint bytes = std::min(remaining.Bytes(), 4u);
+        aWriter.Write(remaining.Split(0, bytes));
+        remaining.Set(remaining.Split(bytes));
+    }
+}
+
+void MockMemoryResourceManager::Handler::Destroy()
+{
+    iManager.iOutstanding--;
+    delete this;
+}
+
+
+// MockMemoryResourceManager
+
+MockMemoryResourceManager::MockMemoryResourceManager()
+    : iLoads(0)
+    , iOutstanding(0)
+{
+}
+
+void MockMemoryResourceManager::Add(const TChar* aResourceTail, const TChar* aData)
+{
+    iResources[aResourceTail] = aData;
+}
+
+TUint MockMemoryResourceManager::Loads() const
+{
+    return iLoads;
+}
+
+TUint MockMemoryResourceManager::Outstanding() const
+{
+    return iOutstanding;
+}
+
+IResourceHandler* MockMemoryResourceManager::CreateResourceHandler(const Brx& aResourceTail)
+{
+    std::string tail((const TChar*)aResourceTail.Ptr(), aResourceTail.Bytes());
+    auto it = iResources.find(tail);
+    if (it == iResources.end()) {
+        THROW(ResourceInvalid);
+    }
+    iLoads++;
+    iOutstanding++;
+    return new Handler(*this, Brn(it->second.c_str()));
+}
+
+
+// SuiteCachingResourceManager
+
+SuiteCachingResourceManager::SuiteCachingResourceManager()
+    : SuiteUnitTest("SuiteCachingResourceManager")
+    , iBuf(1024)
+{
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestLoadedOnce), "TestLoadedOnce");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestContentMatches), "TestContentMatches");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestInvalidResource), "TestInvalidResource");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestETagStable), "TestETagStable");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestETagDiffersByContent), "TestETagDiffersByContent");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestCompressedVariantSelected), "TestCompressedVariantSelected");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestCompressedVariantNotAccepted), "TestCompressedVariantNotAccepted");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestTooLargeNotCached), "TestTooLargeNotCached");
+    AddTest(MakeFunctor(*this, &SuiteCachingResourceManager::TestInfo), "TestInfo");
+}
+
+void SuiteCachingResourceManager::Setup()
+{
+    iInfoAggregator = new MockResourceInfoAggregator();
+    iLoader = new MockMemoryResourceManager();
+    iLoader->Add("index.html", "<html>index</html>");
+    iLoader->Add("other.html", "<html>other</html>");
+    iLoader->Add("app.js", "var a = 1; var b = 2; var c = 3;");
+    iLoader->Add("app.js.gz", "GZIPPED");
+    iLoader->Add("app.js.br", "BR");
+    iLoader->Add("big.js", "0123456789012345678901234567890123456789012345678901234567890123456789");
+    iCache = new CachingResourceManager(*iLoader, *iInfoAggregator, kMaxCacheBytes, 2);
+}
+
+void SuiteCachingResourceManager::TearDown()
+{
+    delete iCache;
+    TEST(iLoader->Outstanding() == 0);
+    delete iLoader;
+    delete iInfoAggregator;
+}
+
+Brn SuiteCachingResourceManager::Get(IResourceHandler& aHandler)
+{
+    iBuf.SetBytes(0);
+    WriterBuffer writer(iBuf);
+    aHandler.Write(writer);
+    TEST(aHandler.Bytes() == iBuf.Bytes());
+    return Brn(iBuf);
+}
+
+void SuiteCachingResourceManager::TestLoadedOnce()
+{
+    for (TUint i=0; i<3; i++) {
+        auto handler = iCache->CreateResourceHandler(Brn("index.html"));
+        handler->Destroy();
+    }
+    TEST(iLoader->Loads() == 1);
+    TEST(iCache->Misses() == 1);
+    TEST(iCache->Hits() == 2);
+}
+
+void SuiteCachingResourceManager::TestContentMatches()
+{
+    for (TUint i=0; i<2; i++) {
+        auto handler = iCache->CreateResourceHandler(Brn("index.html"));
+        TEST(Get(*handler) == Brn("<html>index</html>"));
+        handler->Destroy();
+    }
+}
+
+void SuiteCachingResourceManager::TestInvalidResource()
+{
+    TEST_THROWS(iCache->CreateResourceHandler(Brn("missing.html")), ResourceInvalid);
+    TEST(iCache->CachedBytes() == 0);
+}
+
+void SuiteCachingResourceManager::TestETagStable()
+{
+    auto handler = iCache->CreateResourceHandler(Brn("index.html"));
+    const Bws<32> etag(handler->ETag());
+    handler->Destroy();
+    TEST(etag.Bytes() > 2);
+    TEST(etag[0] == '"');
+    TEST(etag[etag.Bytes()-1] == '"');
+
+    handler = iCache->CreateResourceHandler(Brn("index.html"));
+    TEST(handler->ETag() == etag);
+    handler->Destroy();
+}
+
+void SuiteCachingResourceManager::TestETagDiffersByContent()
+{
+    auto handler1 = iCache->CreateResourceHandler(Brn("index.html"));
+    auto handler2 = iCache->CreateResourceHandler(Brn("other.html"));
+    TEST(handler1->ETag() != handler2->ETag());
+    handler1->Destroy();
+    handler2->Destroy();
+}
+
+void SuiteCachingResourceManager::TestCompressedVariantSelected()
+{
+    auto handler = iCache->CreateResourceHandler(Brn("app.js"));
+    const Bws<32> etagIdentity(handler->ETag());
+
+    TEST(handler->SelectEncoding(ContentEncoding::kGzip) == ContentEncoding::kTokenGzip);
+    TEST(Get(*handler) == Brn("GZIPPED"));
+    const Bws<32> etagGzip(handler->ETag());
+    TEST(etagGzip != etagIdentity);
+
+    TEST(handler->SelectEncoding(ContentEncoding::kGzip | ContentEncoding::kBrotli) == ContentEncoding::kTokenBrotli);
+    TEST(Get(*handler) == Brn("BR"));
+    TEST(handler->ETag() != etagGzip);
+    TEST(handler->ETag() != etagIdentity);
+    handler->Destroy();
+}
+
+void SuiteCachingResourceManager::TestCompressedVariantNotAccepted()
+{
+    auto handler = iCache->CreateResourceHandler(Brn("app.js"));
+    TEST(handler->SelectEncoding(ContentEncoding::kIdentity) == Brx::Empty());
+    TEST(Get(*handler) == Brn("var a = 1; var b = 2; var c = 3;"));
+    handler->Destroy();
+
+    // no variants on disk => identity, whatever the client accepts
+    handler = iCache->CreateResourceHandler(Brn("index.html"));
+    TEST(handler->SelectEncoding(ContentEncoding::kGzip | ContentEncoding::kBrotli) == Brx::Empty());
+    TEST(Get(*handler) == Brn("<html>index</html>"));
+    handler->Destroy();
+}
+
+void SuiteCachingResourceManager::TestTooLargeNotCached()
+{
+    for (TUint i=0; i<2; i++) {
+        auto handler = iCache->CreateResourceHandler(Brn("big.js"));
+        TEST(handler->ETag() == Brx::Empty());
+        TEST(Get(*handler).Bytes() == 70);
+        handler->Destroy();
+    }
+    TEST(iLoader->Loads() == 2);
+    TEST(iCache->CachedBytes() == 0);
+}
+
+void SuiteCachingResourceManager::TestInfo()
+{
+    iCache->Preload(Brn("index.html"));
+    TEST(iCache->CachedBytes() == Brn("<html>index</html>").Bytes());
+    iBuf.SetBytes(0);
+    WriterBuffer writer(iBuf);
+    iInfoAggregator->Query(writer);
+    Print(iBuf);
+    TEST(Ascii::Contains(iBuf, Brn("1 resources")));
+}
+
+
+
 void TestWebAppFramework(Environment& aEnv)
 {
     Runner runner("WebApp Framework tests\n");
     runner.Add(new SuiteFrameworkTabHandler());
     runner.Add(new SuiteFrameworkTab());
     runner.Add(new SuiteTabManager());
+    runner.Add(new SuiteCachingResourceManager());
     runner.Add(new SuiteWebAppFramework(aEnv));
     runner.Run();
 }
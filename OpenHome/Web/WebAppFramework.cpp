@@ -951,8 +951,101 @@ void WebAppFramework::CurrentAdapterChanged()
 }
 
 
+// HeaderAcceptEncoding
+
+TUint HeaderAcceptEncoding::Encodings() const
+{
+    if (!Received()) {
+        return ContentEncoding::kIdentity;
+    }
+    return iEncodings;
+}
+
+TBool HeaderAcceptEncoding::Recognise(const Brx& aHeader)
+{
+    return Ascii::CaseInsensitiveEquals(aHeader, Brn("Accept-Encoding"));
+}
+
+void HeaderAcceptEncoding::Process(const Brx& aValue)
+{
+    iEncodings = ContentEncoding::kIdentity;
+    Parser parser(aValue);
+    while (!parser.Finished()) {
+        Parser entry(parser.Next(','));
+        Brn coding = Ascii::Trim(entry.Next(';'));
+        if (IsZeroQValue(Ascii::Trim(entry.Remaining()))) {
+            continue; // explicitly refused
+        }
+        if (Ascii::CaseInsensitiveEquals(coding, ContentEncoding::kTokenGzip)) {
+            iEncodings |= ContentEncoding::kGzip;
+        }
+        else if (Ascii::CaseInsensitiveEquals(coding, ContentEncoding::kTokenBrotli)) {
+            iEncodings |= ContentEncoding::kBrotli;
+        }
+    }
+    SetReceived();
+}
+
+TBool HeaderAcceptEncoding::IsZeroQValue(const Brx& aParams)
+{
+    if (aParams.Bytes() < 3 || (aParams[0] != 'q' && aParams[0] != 'Q') || aParams[1] != '=') {
+        return false;
+    }
+    for (TUint i=2; i<aParams.Bytes(); i++) {
+        if (aParams[i] != '0' && aParams[i] != '.') {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+// HeaderIfNoneMatch
+
+TBool HeaderIfNoneMatch::Matches(const Brx& aETag) const
+{
+    if (!Received()) {
+        return false;
+    }
+    Parser parser(iValue);
+    while (!parser.Finished()) {
+        Brn tag = Ascii::Trim(parser.Next(','));
+        if (tag == Brn("*")) {
+            return true;
+        }
+        // If-None-Match uses the weak comparison function
+        if (tag.Bytes() > 2 && tag[0] == 'W' && tag[1] == '/') {
+            tag.Set(tag.Ptr() + 2, tag.Bytes() - 2);
+        }
+        if (tag == aETag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TBool HeaderIfNoneMatch::Recognise(const Brx& aHeader)
+{
+    return Ascii::CaseInsensitiveEquals(aHeader, Brn("If-None-Match"));
+}
+
+void HeaderIfNoneMatch::Process(const Brx& aValue)
+{
+    if (aValue.Bytes() > iValue.MaxBytes()) {
+        return; // treat an over-long list as absent; we'll just send the full response
+    }
+    iValue.Replace(aValue);
+    SetReceived();
+}
+
+
 // HttpSession
 
+const Brn HttpSession::kHeaderContentEncoding("Content-Encoding");
+const Brn HttpSession::kHeaderETag("ETag");
+const Brn HttpSession::kHeaderVary("Vary");
+const Brn HttpSession::kHeaderCacheControl("Cache-Control");
+
 HttpSession::HttpSession(Environment& aEnv, IWebAppManager& aAppManager, ITabManager& aTabManager, IResourceManager& aResourceManager)
     : iAppManager(aAppManager)
     , iTabManager(aTabManager)
@@ -979,6 +1072,8 @@ HttpSession::HttpSession(Environment& aEnv, IWebAppManager& aAppManager, ITabMan
     iReaderRequest->AddHeader(iHeaderTransferEncoding);
     iReaderRequest->AddHeader(iHeaderConnection);
     iReaderRequest->AddHeader(iHeaderAcceptLanguage);
+    iReaderRequest->AddHeader(iHeaderAcceptEncoding);
+    iReaderRequest->AddHeader(iHeaderIfNoneMatch);
 }
 
 HttpSession::~HttpSession()
@@ -1107,6 +1202,21 @@ void HttpSession::Get()
     IResourceHandler* resourceHandler = iResourceManager.CreateResourceHandler(uri);    // throws ResourceInvalid
 
     try {
+        const Brx& encoding = resourceHandler->SelectEncoding(iHeaderAcceptEncoding.Encodings());
+        const Brx& etag = resourceHandler->ETag();
+        if (etag.Bytes() > 0 && iHeaderIfNoneMatch.Matches(etag)) {
+            LOG(kHttp, "HttpSession::Get URI: %.*s  not modified\n", PBUF(uri));
+            iResponseStarted = true;
+            iWriterResponse->WriteStatus(HttpStatus::kNotModified, reqVersion);
+            iWriterResponse->WriteHeader(kHeaderETag, etag);
+            iWriterResponse->WriteHeader(kHeaderVary, Brn("Accept-Encoding"));
+            iWriterResponse->WriteHeader(Http::kHeaderConnection, Http::kConnectionClose);
+            iWriterResponse->WriteFlush();
+            resourceHandler->Destroy();
+            iResponseEnded = true;
+            return;
+        }
+
         Brn mimeType = MimeUtils::MimeTypeFromUri(uri);
         LOG(kHttp, "HttpSession::Get URI: %.*s  Content-Type: %.*s\n", PBUF(uri), PBUF(mimeType));
 
@@ -1117,6 +1227,15 @@ void HttpSession::Get()
         writer.Write(mimeType);
         //writer.Write(Brn("; charset=\"utf-8\""));
         writer.WriteFlush();
+        if (encoding.Bytes() > 0) {
+            iWriterResponse->WriteHeader(kHeaderContentEncoding, encoding);
+        }
+        if (etag.Bytes() > 0) {
+            // clients may cache but must revalidate (cheaply, via If-None-Match) as resources change on upgrade
+            iWriterResponse->WriteHeader(kHeaderETag, etag);
+            iWriterResponse->WriteHeader(kHeaderCacheControl, Brn("no-cache"));
+            iWriterResponse->WriteHeader(kHeaderVary, Brn("Accept-Encoding"));
+        }
         iWriterResponse->WriteHeader(Http::kHeaderConnection, Http::kConnectionClose);
         const TUint len = resourceHandler->Bytes();
         ASSERT(len > 0);    // Resource handler reporting incorrect byte count or corrupt resource.
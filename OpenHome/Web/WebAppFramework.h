@@ -445,12 +445,41 @@ private:
     mutable Mutex iMutex;
 };
 
+class HeaderAcceptEncoding : public HttpHeader
+{
+public:
+    TUint Encodings() const;    // ContentEncoding flags
+private: // from HttpHeader
+    TBool Recognise(const Brx& aHeader) override;
+    void Process(const Brx& aValue) override;
+private:
+    static TBool IsZeroQValue(const Brx& aParams);
+private:
+    TUint iEncodings;
+};
+
+class HeaderIfNoneMatch : public HttpHeader
+{
+    static const TUint kMaxBytes = 512;
+public:
+    TBool Matches(const Brx& aETag) const;
+private: // from HttpHeader
+    TBool Recognise(const Brx& aHeader) override;
+    void Process(const Brx& aValue) override;
+private:
+    Bws<kMaxBytes> iValue;
+};
+
 /**
  * HttpSession that handles serving files (via GET), processing POST requests
  * and allows long polling.
  */
 class HttpSession : public SocketTcpSession
 {
+    static const Brn kHeaderContentEncoding;
+    static const Brn kHeaderETag;
+    static const Brn kHeaderVary;
+    static const Brn kHeaderCacheControl;
 private:
     static const TUint kMaxRequestBytes = 4*1024;
     static const TUint kMaxResponseBytes = 4*1024;
@@ -484,6 +513,8 @@ private:
     HttpHeaderTransferEncoding iHeaderTransferEncoding;
     HttpHeaderConnection iHeaderConnection;
     Net::HeaderAcceptLanguage iHeaderAcceptLanguage;
+    HeaderAcceptEncoding iHeaderAcceptEncoding;
+    HeaderIfNoneMatch iHeaderIfNoneMatch;
     const HttpStatus* iErrorStatus;
     TBool iResponseStarted;
     TBool iResponseEnded;